@@ -46,16 +46,18 @@ endif ()
 include(${CPM_DOWNLOAD_LOCATION})
 # -------- get_cpm.cmake --------
 
-# # https://github.com/google/googletest
-# CPMAddPackage(
-#   NAME googletest
-#   GITHUB_REPOSITORY google/googletest
-#   GIT_TAG v1.13.0
-#   VERSION 1.13.0
-#   OPTIONS
-#       "INSTALL_GTEST OFF"
-#       "gtest_force_shared_crt ON"
-# )
+if (ENABLE_UNIT_TEST)
+    # https://github.com/google/googletest
+    CPMAddPackage(
+            NAME googletest
+            GITHUB_REPOSITORY google/googletest
+            GIT_TAG v1.13.0
+            VERSION 1.13.0
+            OPTIONS
+            "INSTALL_GTEST OFF"
+            "gtest_force_shared_crt ON"
+    )
+endif ()
 
 # # https://github.com/abumq/easyloggingpp
 # CPMAddPackage(
@@ -37,6 +37,36 @@ function(add_header_driver _target)
             ${CMAKE_SOURCE_DIR}/src/kernel/driver/include)
 endfunction()
 
+function(add_header_block _target)
+    target_include_directories(${_target} PRIVATE
+            ${CMAKE_SOURCE_DIR}/src/kernel/block/include)
+endfunction()
+
+function(add_header_fs _target)
+    target_include_directories(${_target} PRIVATE
+            ${CMAKE_SOURCE_DIR}/src/kernel/fs/include)
+endfunction()
+
+function(add_header_rcu _target)
+    target_include_directories(${_target} PRIVATE
+            ${CMAKE_SOURCE_DIR}/src/kernel/rcu/include)
+endfunction()
+
+function(add_header_time _target)
+    target_include_directories(${_target} PRIVATE
+            ${CMAKE_SOURCE_DIR}/src/kernel/time/include)
+endfunction()
+
+function(add_header_sched _target)
+    target_include_directories(${_target} PRIVATE
+            ${CMAKE_SOURCE_DIR}/src/kernel/sched/include)
+endfunction()
+
+function(add_header_mm _target)
+    target_include_directories(${_target} PRIVATE
+            ${CMAKE_SOURCE_DIR}/src/kernel/mm/include)
+endfunction()
+
 function(add_header_3rd _target)
     target_include_directories(${_target} PRIVATE
             ${gnu-efi_BINARY_DIR}/inc)
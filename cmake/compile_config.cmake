@@ -19,17 +19,28 @@ list(APPEND DEFAULT_COMPILE_OPTIONS
         -Wextra
         # 将代码编译为无操作系统支持的独立程序
         -ffreestanding
-        # 启用异常处理机制
-        -fexceptions
+        # 如果 ENABLE_EXCEPTIONS 为 ON 则启用异常处理机制
+        $<$<BOOL:${ENABLE_EXCEPTIONS}>:-fexceptions>
+        # 否则关闭异常、rtti 与展开表，减小镜像体积
+        $<$<NOT:$<BOOL:${ENABLE_EXCEPTIONS}>>:-fno-exceptions;-fno-asynchronous-unwind-tables>
+        $<$<AND:$<NOT:$<BOOL:${ENABLE_EXCEPTIONS}>>,$<COMPILE_LANGUAGE:CXX>>:-fno-rtti>
         # 使用 2 字节 wchar_t
         -fshort-wchar
         # 允许 wchar_t
-        -fpermissive
+        $<$<COMPILE_LANGUAGE:CXX>:-fpermissive>
+        # 支持的最大 cpu 数
+        -DMAX_CPU_COUNT=${MAX_CPU_COUNT}
+        # 块设备轮询模式
+        -DENABLE_BLK_POLL=$<BOOL:${ENABLE_BLK_POLL}>
+        # 启动时运行性能测量
+        -DENABLE_BENCH=$<BOOL:${ENABLE_BENCH}>
         # 目标平台编译选项
         # @todo clang 交叉编译参数
         $<$<STREQUAL:${TARGET_ARCH},x86_64>:
         # 禁用 red-zone
         -mno-red-zone
+        # 只使用通用寄存器，中断入口不保存 sse 寄存器
+        -mgeneral-regs-only
         # 使用的 uefi 版本
         -DGNU_EFI_USE_MS_ABI
         -DENABLE_GNU_EFI=$<BOOL:${ENABLE_GNU_EFI}>
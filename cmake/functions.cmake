@@ -29,6 +29,19 @@ function(objdump_D _elf)
             )
 endfunction()
 
+# 生成 elf 文件的 size -A，用于比较不同编译选项下的镜像大小
+# _elf: elf 文件 target
+# 在 ${${_elf}_BINARY_DIR} 目录下生成 ${_elf}.size 文件
+function(size_A _elf)
+    add_custom_target(size_A_${_elf}
+            COMMENT "size -A ${_elf} ..."
+            DEPENDS ${_elf}
+            WORKING_DIRECTORY ${PROJECT_BINARY_DIR}
+            COMMAND ${TOOLCHAIN_PREFIX}size -A ${${_elf}_BINARY_DIR}/${_elf} > ${${_elf}_BINARY_DIR}/${_elf}.size
+            COMMAND ${CMAKE_COMMAND} -E cat ${${_elf}_BINARY_DIR}/${_elf}.size
+            )
+endfunction()
+
 # 将 elf 转换为 efi，会添加一个 ${efi} 命令
 # _elf: 要转换的 elf 文件 target
 # _efi: 输出的 efi 文件 target
@@ -46,16 +59,30 @@ function(elf2efi _elf _efi)
             )
 endfunction()
 
+# 将目录打包为不压缩的 tar 归档作为 initramfs，会添加一个 initramfs 命令
+# 使用 cmake 自带的 tar，路径过长时使用 pax 扩展头
+# _dir: 要打包的目录
+# _output: 输出的归档文件
+function(make_initramfs _dir _output)
+    add_custom_target(initramfs
+            COMMENT "Building initramfs ..."
+            WORKING_DIRECTORY ${_dir}
+            COMMAND ${CMAKE_COMMAND} -E tar cf ${_output} --format=paxr .
+            )
+endfunction()
+
 # 创建 image 目录并将文件复制
 # _boot: boot efi 文件
 # _kernel: kernel elf 文件
 # _startup: startup.nsh 文件
-function(make_uefi_dir _boot _kernel _startup)
-    add_custom_target(image_uefi DEPENDS ${_boot} ${_kernel}
-            COMMENT "Copying bootloader and kernel"
+# _initramfs: initramfs 归档，由 initramfs 命令生成
+function(make_uefi_dir _boot _kernel _startup _initramfs)
+    add_custom_target(image_uefi DEPENDS ${_boot} ${_kernel} initramfs
+            COMMENT "Copying bootloader, kernel and initramfs"
             COMMAND ${CMAKE_COMMAND} -E make_directory ${PROJECT_BINARY_DIR}/image/
             COMMAND ${CMAKE_COMMAND} -E copy ${${BOOT_ELF_OUTPUT_NAME}_BINARY_DIR}/${_boot} ${PROJECT_BINARY_DIR}/image/
             COMMAND ${CMAKE_COMMAND} -E copy ${${_kernel}_BINARY_DIR}/${_kernel} ${PROJECT_BINARY_DIR}/image/
             COMMAND ${CMAKE_COMMAND} -E copy ${_startup} ${PROJECT_BINARY_DIR}/image/
+            COMMAND ${CMAKE_COMMAND} -E copy ${_initramfs} ${PROJECT_BINARY_DIR}/image/
             )
 endfunction()
@@ -35,6 +35,14 @@ option(ENABLE_GENERATOR_MAKE "Use make or ninja" ON)
 option(ENABLE_GNU_EFI "Use gnu efi" ON)
 # 是否开启测试覆盖率，默认为 ON
 option(ENABLE_TEST_COVERAGE "Enable test coverage" ON)
+# 是否开启 c++ 异常与 rtti，默认为 OFF，内核使用 Expected 传递错误
+option(ENABLE_EXCEPTIONS "Enable c++ exceptions and rtti" OFF)
+# 块设备是否使用轮询完成代替中断，默认为 OFF
+option(ENABLE_BLK_POLL "Poll block device completions" OFF)
+# 是否在启动时运行性能测量，默认为 OFF，结果通过调试器读取
+option(ENABLE_BENCH "Run benchmarks at boot" OFF)
+# 是否构建宿主机单元测试，默认为 ON，仅在 linux 宿主机构建 x86_64 时有效
+option(ENABLE_UNIT_TEST "Build host unit tests" ON)
 
 # 是否为 Debug 版本，默认为 Debug
 if (ENABLE_BUILD_RELEASE)
@@ -45,6 +53,9 @@ else ()
     set(CMAKE_VERBOSE_MAKEFILE ON)
 endif ()
 message(STATUS "ENABLE_BUILD_RELEASE is: ${ENABLE_BUILD_RELEASE}")
+message(STATUS "ENABLE_EXCEPTIONS is: ${ENABLE_EXCEPTIONS}")
+message(STATUS "ENABLE_BLK_POLL is: ${ENABLE_BLK_POLL}")
+message(STATUS "ENABLE_BENCH is: ${ENABLE_BENCH}")
 
 # 设置构建使用的工具，默认为 make
 if (ENABLE_GENERATOR_MAKE)
@@ -77,6 +88,19 @@ if (NOT TARGET_ARCH IN_LIST VALID_TARGET_ARCH)
     message(FATAL_ERROR "TARGET_ARCH must be one of ${VALID_TARGET_ARCH}")
 endif ()
 
+# 支持的最大 cpu 数，用于静态分配每个 cpu 的数据
+if (NOT DEFINED MAX_CPU_COUNT)
+    set(MAX_CPU_COUNT 8)
+endif ()
+message(STATUS "MAX_CPU_COUNT is: ${MAX_CPU_COUNT}")
+
+# 单元测试直接使用宿主机编译器，需要宿主机与目标架构一致
+if (NOT (CMAKE_HOST_SYSTEM_NAME STREQUAL "Linux"
+        AND ${TARGET_ARCH} STREQUAL "x86_64"))
+    set(ENABLE_UNIT_TEST OFF CACHE BOOL "Build host unit tests" FORCE)
+endif ()
+message(STATUS "ENABLE_UNIT_TEST is: ${ENABLE_UNIT_TEST}")
+
 message(STATUS "CMAKE_TOOLCHAIN_FILE is: ${CMAKE_TOOLCHAIN_FILE}")
 # 编译器只支持 gnu-gcc 或 clang
 if (NOT ("${CMAKE_CXX_COMPILER_ID}" MATCHES "GNU" OR "${CMAKE_CXX_COMPILER_ID}" MATCHES "Clang"))
@@ -107,6 +131,7 @@ elseif (${TARGET_ARCH} STREQUAL "riscv64")
     list(APPEND RUN_DEPENDS
             opensbi
             ${KERNEL_ELF_OUTPUT_NAME}
+            initramfs
             )
 elseif (${TARGET_ARCH} STREQUAL "aarch64")
     list(APPEND RUN_DEPENDS
@@ -121,6 +146,27 @@ list(APPEND DEBUG_DEPENDS
         gdbinit
         )
 
+# qemu 模拟的 cpu 数
+if (NOT DEFINED QEMU_SMP)
+    set(QEMU_SMP 4)
+endif ()
+
+# 作为 virtio-blk 设备挂载的磁盘镜像，为空时不挂载
+if (NOT DEFINED QEMU_BLK_IMAGE)
+    set(QEMU_BLK_IMAGE "")
+endif ()
+
+# 作为 nvme 设备挂载的磁盘镜像，为空时不挂载
+if (NOT DEFINED QEMU_NVME_IMAGE)
+    set(QEMU_NVME_IMAGE "")
+endif ()
+
+# 打包为 initramfs 的目录，其中的配置与用户程序由加载器随内核一起载入
+if (NOT DEFINED INITRAMFS_DIR)
+    set(INITRAMFS_DIR ${CMAKE_SOURCE_DIR}/tools/initramfs)
+endif ()
+message(STATUS "INITRAMFS_DIR is: ${INITRAMFS_DIR}")
+
 # qemu gdb 调试端口
 if (NOT DEFINED QEMU_GDB_PORT)
     set(QEMU_GDB_PORT tcp::1234)
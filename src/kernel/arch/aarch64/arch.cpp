@@ -15,15 +15,45 @@
  */
 
 #include "arch.h"
+#include "fpu.h"
+#include "interrupt.h"
+#include "percpu.h"
 
-int32_t arch(uint32_t _argc, uint8_t** _argv) {
-    (void)_argc;
-    (void)_argv;
+/// 加载器传入的 initramfs 的范围
+static const uint8_t* initrd_start;
+static const uint8_t* initrd_end;
 
-    // 进入死循环
-    while (1) {
-        ;
+int32_t arch(uint32_t _argc, uint8_t** _argv) {
+    // 加载器以 argv[0] 与 argv[1] 传入 initramfs 的起始与结束地址
+    if ((_argc >= 2) && (_argv != nullptr) && (_argv[1] > _argv[0])) {
+        initrd_start = _argv[0];
+        initrd_end   = _argv[1];
     }
 
+    // 初始化每个 cpu 的数据，使用 mpidr_el1 的 aff0 作为硬件编号
+    uint64_t mpidr;
+    __asm__ volatile("mrs %0, mpidr_el1" : "=r"(mpidr));
+    percpu_init(mpidr & 0xFF);
+
+    // 初始化中断，此时中断仍然是关闭的
+    interrupt_init();
+
+    // 禁止访问浮点/向量寄存器，只在 kernel_fpu_begin/end 之间使用
+    fpu_init();
+
+    return 0;
+}
+
+/// @todo 从 uefi 配置表获取
+const void* arch_fdt(void) {
+    return nullptr;
+}
+
+uintptr_t arch_acpi_rsdp(void) {
     return 0;
 }
+
+const void* arch_initrd(size_t* _size) {
+    *_size = static_cast<size_t>(initrd_end - initrd_start);
+    return initrd_start;
+}
@@ -0,0 +1,60 @@
+
+/**
+ * @file clock.cpp
+ * @brief aarch64 时钟
+ * @author Zone.N (Zone.Niuzh@hotmail.com)
+ * @version 1.0
+ * @date 2026-10-18
+ * @copyright MIT LICENSE
+ * https://github.com/MRNIU/cmake-kernel
+ * @par change log:
+ * <table>
+ * <tr><th>Date<th>Author<th>Description
+ * <tr><td>2026-10-18<td>Zone.N (Zone.Niuzh@hotmail.com)<td>创建文件
+ * </table>
+ */
+
+#include "clock.h"
+#include "cpu.h"
+
+/// cntv_ctl_el0 使能位
+static constexpr const uint64_t CNTV_CTL_ENABLE = 1 << 0;
+/// cntv_ctl_el0 屏蔽位
+static constexpr const uint64_t CNTV_CTL_IMASK  = 1 << 1;
+
+void clock_arch_init(void) {
+    return;
+}
+
+/// @todo 在 gic 中使能 INTERRUPT_TIMER
+void clock_arch_cpu_init(void) {
+    clock_arch_stop_event();
+    return;
+}
+
+uint64_t clock_arch_read(void) {
+    return cpu_cycles();
+}
+
+uint64_t clock_arch_freq(void) {
+    uint64_t freq;
+    __asm__ volatile("mrs %0, cntfrq_el0" : "=r"(freq));
+    return freq;
+}
+
+void clock_arch_set_event(uint64_t _deadline) {
+    __asm__ volatile("msr cntv_cval_el0, %0" : : "r"(_deadline));
+    __asm__ volatile("msr cntv_ctl_el0, %0" : : "r"(CNTV_CTL_ENABLE));
+    __asm__ volatile("isb" ::: "memory");
+    return;
+}
+
+void clock_arch_stop_event(void) {
+    __asm__ volatile("msr cntv_ctl_el0, %0" : : "r"(CNTV_CTL_IMASK));
+    __asm__ volatile("isb" ::: "memory");
+    return;
+}
+
+void clock_arch_ack(void) {
+    return;
+}
@@ -0,0 +1,51 @@
+
+/**
+ * @file fpu.cpp
+ * @brief aarch64 浮点/向量状态
+ * @author Zone.N (Zone.Niuzh@hotmail.com)
+ * @version 1.0
+ * @date 2026-10-18
+ * @copyright MIT LICENSE
+ * https://github.com/MRNIU/cmake-kernel
+ * @par change log:
+ * <table>
+ * <tr><th>Date<th>Author<th>Description
+ * <tr><td>2026-10-18<td>Zone.N (Zone.Niuzh@hotmail.com)<td>创建文件
+ * </table>
+ */
+
+#include "fpu.h"
+
+// 内核编译时允许使用浮点/向量寄存器，固件已打开 CPACR_EL1.FPEN，
+// 编译器按调用约定保存，切换时 context_switch 保存 d8~d15。
+// 不需要禁止访问与额外的保存，kernel_fpu_begin/end 只记录嵌套深度
+
+void fpu_arch_init(void) {
+    return;
+}
+
+void fpu_arch_cpu_init(void) {
+    return;
+}
+
+void fpu_arch_enable(void) {
+    return;
+}
+
+void fpu_arch_disable(void) {
+    return;
+}
+
+void fpu_arch_save(fpu_state_t* _state) {
+    (void)_state;
+    return;
+}
+
+void fpu_arch_restore(const fpu_state_t* _state) {
+    (void)_state;
+    return;
+}
+
+void fpu_arch_restore_init(void) {
+    return;
+}
@@ -0,0 +1,85 @@
+
+/**
+ * @file context.h
+ * @brief aarch64 上下文切换
+ * @author Zone.N (Zone.Niuzh@hotmail.com)
+ * @version 1.0
+ * @date 2026-10-18
+ * @copyright MIT LICENSE
+ * https://github.com/MRNIU/cmake-kernel
+ * @par change log:
+ * <table>
+ * <tr><th>Date<th>Author<th>Description
+ * <tr><td>2026-10-18<td>Zone.N (Zone.Niuzh@hotmail.com)<td>创建文件
+ * </table>
+ */
+
+#ifndef CMAKE_KERNEL_CONTEXT_H
+#define CMAKE_KERNEL_CONTEXT_H
+
+#include "cstddef"
+#include "cstdint"
+
+/**
+ * @brief 切换时保存在栈上的上下文，与 switch.S 的保存顺序一致
+ * 只有被调用者保存的寄存器，编译器可能使用 d8~d15，也需要保存
+ */
+struct context_t {
+    /// 新任务的入口
+    uint64_t x19;
+    /// 新任务的参数
+    uint64_t x20;
+    uint64_t x21_x28[8];
+    uint64_t fp;
+    /// 返回地址
+    uint64_t lr;
+    uint64_t d8_d15[8];
+};
+
+/// 浮点/向量寄存器由编译器管理，没有需要恢复的状态
+static constexpr const bool FPU_LAZY_RESTORE = true;
+
+/**
+ * @brief 任务的浮点/向量状态
+ * 内核编译时允许使用浮点/向量寄存器，编译器按调用约定保存，
+ * context_t 中已有 d8~d15，不需要额外的保存区
+ */
+struct fpu_state_t {
+    /// 最近一次加载或保存所在的 cpu
+    size_t   cpu;
+    /// kernel_fpu_begin 的嵌套深度
+    uint32_t depth;
+};
+
+extern "C" {
+/**
+ * @brief 保存当前上下文，切换到 _next_sp 指向的上下文
+ * @param  _prev_sp                保存当前栈指针的位置
+ * @param  _next_sp                要切换到的栈指针
+ */
+void context_switch(uintptr_t* _prev_sp, uintptr_t _next_sp);
+
+/**
+ * @brief 新任务第一次被切换到时的入口，调用 _entry(_arg)
+ */
+void context_trampoline(void);
+}
+
+/**
+ * @brief 在新栈上构造初始上下文
+ * @param  _stack_top              栈顶，16 字节对齐
+ * @param  _entry                  入口，不能返回
+ * @param  _arg                    入口的参数
+ * @return uintptr_t               传给 context_switch 的栈指针
+ */
+static inline uintptr_t context_init(uint8_t* _stack_top,
+                                     void (*_entry)(void*), void* _arg) {
+    auto* ctx = reinterpret_cast<context_t*>(_stack_top) - 1;
+    __builtin_memset(ctx, 0, sizeof(context_t));
+    ctx->x19 = reinterpret_cast<uint64_t>(_entry);
+    ctx->x20 = reinterpret_cast<uint64_t>(_arg);
+    ctx->lr  = reinterpret_cast<uint64_t>(context_trampoline);
+    return reinterpret_cast<uintptr_t>(ctx);
+}
+
+#endif /* CMAKE_KERNEL_CONTEXT_H */
@@ -0,0 +1,158 @@
+
+/**
+ * @file cpu.h
+ * @brief aarch64 cpu 相关操作
+ * @author Zone.N (Zone.Niuzh@hotmail.com)
+ * @version 1.0
+ * @date 2026-10-18
+ * @copyright MIT LICENSE
+ * https://github.com/MRNIU/cmake-kernel
+ * @par change log:
+ * <table>
+ * <tr><th>Date<th>Author<th>Description
+ * <tr><td>2026-10-18<td>Zone.N (Zone.Niuzh@hotmail.com)<td>创建文件
+ * </table>
+ */
+
+#ifndef CMAKE_KERNEL_CPU_H
+#define CMAKE_KERNEL_CPU_H
+
+#include "cstddef"
+#include "cstdint"
+
+/**
+ * @brief 自旋等待时提示 cpu 降低流水线与总线压力
+ */
+static inline void cpu_relax(void) {
+    __asm__ volatile("yield" ::: "memory");
+    return;
+}
+
+/**
+ * @brief 等待 *_addr 不再等于 _old，允许提前返回，调用者需要重新检查
+ * ldaxr 设置独占监视器，其它核写该地址时会产生事件唤醒 wfe
+ * @param  _addr                   要等待的地址
+ * @param  _old                    旧值
+ */
+static inline void cpu_wait_change(const uint32_t* _addr, uint32_t _old) {
+    uint32_t val;
+    __asm__ volatile("ldaxr %w0, [%1]" : "=&r"(val) : "r"(_addr) : "memory");
+    if (val == _old) {
+        __asm__ volatile("wfe" ::: "memory");
+    }
+    return;
+}
+
+/**
+ * @brief 设置当前 cpu 的 percpu 偏移，保存在 tpidr_el1 中
+ * @param  _offset                 本 cpu 数据区相对模板的偏移
+ */
+static inline void cpu_set_percpu_offset(uintptr_t _offset) {
+    __asm__ volatile("msr tpidr_el1, %0" : : "r"(_offset) : "memory");
+    return;
+}
+
+/**
+ * @brief 获取当前 cpu 的 percpu 偏移
+ * @return uintptr_t               tpidr_el1 的值
+ */
+static inline uintptr_t cpu_percpu_offset(void) {
+    uintptr_t offset;
+    __asm__ volatile("mrs %0, tpidr_el1" : "=r"(offset));
+    return offset;
+}
+
+/**
+ * @brief 开中断
+ */
+static inline void cpu_irq_enable(void) {
+    __asm__ volatile("msr daifclr, #2" ::: "memory");
+    return;
+}
+
+/**
+ * @brief 关中断
+ */
+static inline void cpu_irq_disable(void) {
+    __asm__ volatile("msr daifset, #2" ::: "memory");
+    return;
+}
+
+/// daif 中 irq 屏蔽位
+static constexpr const uint64_t DAIF_I = 1 << 7;
+
+/**
+ * @brief 关中断并返回之前的状态
+ * @return uint64_t                之前的 daif
+ */
+static inline uint64_t cpu_irq_save(void) {
+    uint64_t flags;
+    __asm__ volatile("mrs %0, daif; msr daifset, #2"
+                     : "=r"(flags)
+                     :
+                     : "memory");
+    return flags;
+}
+
+/**
+ * @brief 恢复 cpu_irq_save 保存的中断状态
+ * @param  _flags                  cpu_irq_save 的返回值
+ */
+static inline void cpu_irq_restore(uint64_t _flags) {
+    __asm__ volatile("msr daif, %0" : : "r"(_flags) : "memory");
+    return;
+}
+
+/**
+ * @brief 中断是否打开
+ * @return true                    打开
+ * @return false                   关闭
+ */
+static inline bool cpu_irq_enabled(void) {
+    uint64_t flags;
+    __asm__ volatile("mrs %0, daif" : "=r"(flags));
+    return (flags & DAIF_I) == 0;
+}
+
+/**
+ * @brief 读取虚拟计数器，频率由 cntfrq_el0 给出
+ * @return uint64_t                计数值
+ */
+static inline uint64_t cpu_cycles(void) {
+    uint64_t cycles;
+    __asm__ volatile("isb; mrs %0, cntvct_el0" : "=r"(cycles));
+    return cycles;
+}
+
+/**
+ * @brief 暂停执行直到有中断挂起，中断关闭时也会返回
+ */
+static inline void cpu_halt(void) {
+    __asm__ volatile("wfi" ::: "memory");
+    return;
+}
+
+/**
+ * @brief cpu_idle_wait 能否被写 _addr 唤醒，否则只能由中断唤醒
+ * @return true                    可以
+ * @return false                   不可以
+ */
+static inline bool cpu_idle_can_monitor(void) {
+    return false;
+}
+
+/**
+ * @brief 空闲等待，调用时中断关闭，返回时中断打开
+ * wfi 在中断关闭时也会被挂起的中断唤醒，之后打开中断处理它
+ * @param  _addr                   要监视的地址，不支持，只能由中断唤醒
+ * @param  _old                    旧值
+ */
+static inline void cpu_idle_wait(const uint32_t* _addr, uint32_t _old) {
+    (void)_addr;
+    (void)_old;
+    cpu_halt();
+    cpu_irq_enable();
+    return;
+}
+
+#endif /* CMAKE_KERNEL_CPU_H */
@@ -0,0 +1,104 @@
+
+/**
+ * @file mmu.h
+ * @brief aarch64 地址转换与 tlb
+ * @author Zone.N (Zone.Niuzh@hotmail.com)
+ * @version 1.0
+ * @date 2026-10-18
+ * @copyright MIT LICENSE
+ * https://github.com/MRNIU/cmake-kernel
+ * @par change log:
+ * <table>
+ * <tr><th>Date<th>Author<th>Description
+ * <tr><td>2026-10-18<td>Zone.N (Zone.Niuzh@hotmail.com)<td>创建文件
+ * </table>
+ */
+
+#ifndef CMAKE_KERNEL_MMU_H
+#define CMAKE_KERNEL_MMU_H
+
+#include "cstddef"
+#include "cstdint"
+
+/// ttbr0_el1 中的 asid 字段
+static constexpr const uint32_t TTBR_ASID_SHIFT = 48;
+static constexpr const uint64_t TTBR_ASID_MASK  = 0xFFFFULL << TTBR_ASID_SHIFT;
+/// tcr_el1.A1，为 1 时 asid 取自 ttbr1_el1
+static constexpr const uint64_t TCR_A1          = 1ULL << 22;
+/// tcr_el1.AS，为 1 时 asid 为 16 位
+static constexpr const uint64_t TCR_AS          = 1ULL << 36;
+
+/**
+ * @brief 地址空间标签 (asid) 的位数
+ * @return uint32_t                位数，asid 不取自 ttbr0_el1 时为 0
+ */
+static inline uint32_t mmu_asid_bits(void) {
+    uint64_t tcr;
+    __asm__ volatile("mrs %0, tcr_el1" : "=r"(tcr));
+    if ((tcr & TCR_A1) != 0) {
+        return 0;
+    }
+    return (tcr & TCR_AS) != 0 ? 16 : 8;
+}
+
+/**
+ * @brief 读取当前页表
+ * @return uintptr_t               不含 asid 的 ttbr0_el1
+ */
+static inline uintptr_t mmu_read_root(void) {
+    uint64_t ttbr;
+    __asm__ volatile("mrs %0, ttbr0_el1" : "=r"(ttbr));
+    return ttbr & ~TTBR_ASID_MASK;
+}
+
+/**
+ * @brief 初始化当前 cpu，asid 不需要额外打开
+ * @param  _tagged                 是否启用标签
+ */
+static inline void mmu_cpu_init(bool _tagged) {
+    (void)_tagged;
+    return;
+}
+
+/**
+ * @brief 丢弃当前 cpu 所有标签的 tlb，包括全局页
+ */
+static inline void mmu_flush_all(void) {
+    __asm__ volatile("tlbi vmalle1\n"
+                     "dsb nsh\n"
+                     "isb"
+                     :
+                     :
+                     : "memory");
+    return;
+}
+
+/**
+ * @brief 切换页表
+ * @param  _root                   页表根
+ * @param  _asid                   标签，未启用时为 0
+ * @param  _flush                  是否丢弃该标签的 tlb，未启用标签时必须为 true
+ */
+static inline void mmu_switch(uintptr_t _root, uint32_t _asid, bool _flush) {
+    auto asid = static_cast<uint64_t>(_asid) << TTBR_ASID_SHIFT;
+    __asm__ volatile("msr ttbr0_el1, %0\n"
+                     "isb"
+                     :
+                     : "r"(_root | asid)
+                     : "memory");
+    // 未启用标签时 asid 可能取自 ttbr1_el1，全部丢弃
+    if (_flush && (_asid == 0)) {
+        mmu_flush_all();
+    }
+    else if (_flush) {
+        __asm__ volatile("tlbi aside1, %0\n"
+                         "dsb nsh\n"
+                         "isb"
+                         :
+                         : "r"(asid)
+                         : "memory");
+    }
+    return;
+}
+
+#endif /* CMAKE_KERNEL_MMU_H */
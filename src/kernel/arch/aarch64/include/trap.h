@@ -0,0 +1,65 @@
+
+/**
+ * @file trap.h
+ * @brief aarch64 中断帧
+ * @author Zone.N (Zone.Niuzh@hotmail.com)
+ * @version 1.0
+ * @date 2026-10-18
+ * @copyright MIT LICENSE
+ * https://github.com/MRNIU/cmake-kernel
+ * @par change log:
+ * <table>
+ * <tr><th>Date<th>Author<th>Description
+ * <tr><td>2026-10-18<td>Zone.N (Zone.Niuzh@hotmail.com)<td>创建文件
+ * </table>
+ */
+
+#ifndef CMAKE_KERNEL_TRAP_H
+#define CMAKE_KERNEL_TRAP_H
+
+#include "cstddef"
+#include "cstdint"
+
+/// 中断号数量
+/// @todo 与 gic 中断号对应
+static constexpr const size_t INTERRUPT_MAX   = 256;
+/// 虚拟定时器的 ppi
+static constexpr const size_t INTERRUPT_TIMER = 27;
+/// 处理器间中断，使用 0 号 sgi
+static constexpr const size_t INTERRUPT_IPI   = 0;
+/// 用于测量进出中断开销的中断号
+static constexpr const size_t INTERRUPT_BENCH = 0;
+
+/**
+ * @brief 中断帧，只包含调用者保存的寄存器
+ */
+struct trap_frame_t {
+    uint64_t x[19];
+    uint64_t lr;
+    uint64_t elr;
+    uint64_t spsr;
+};
+
+/**
+ * @brief 被中断的上下文是否允许中断
+ * @param  _frame                  中断帧
+ * @return true                    spsr.I 为 0
+ * @return false                   spsr.I 为 1
+ */
+static inline bool trap_irq_enabled(const trap_frame_t* _frame) {
+    return (_frame->spsr & (1 << 7)) == 0;
+}
+
+/**
+ * @brief 触发 INTERRUPT_BENCH 号中断
+ * @todo 异常向量表
+ */
+static inline void trap_raise_bench(void) {
+    return;
+}
+
+static inline void trap_ack_bench(void) {
+    return;
+}
+
+#endif /* CMAKE_KERNEL_TRAP_H */
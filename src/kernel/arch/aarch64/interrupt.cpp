@@ -0,0 +1,32 @@
+
+/**
+ * @file interrupt.cpp
+ * @brief aarch64 中断初始化
+ * @author Zone.N (Zone.Niuzh@hotmail.com)
+ * @version 1.0
+ * @date 2026-10-18
+ * @copyright MIT LICENSE
+ * https://github.com/MRNIU/cmake-kernel
+ * @par change log:
+ * <table>
+ * <tr><th>Date<th>Author<th>Description
+ * <tr><td>2026-10-18<td>Zone.N (Zone.Niuzh@hotmail.com)<td>创建文件
+ * </table>
+ */
+
+#include "interrupt.h"
+
+/// @todo 设置 vbar_el1 与 gic
+void interrupt_arch_init(void) {
+    return;
+}
+
+void interrupt_arch_cpu_init(void) {
+    return;
+}
+
+void interrupt_arch_default(size_t _no, trap_frame_t* _frame) {
+    (void)_no;
+    (void)_frame;
+    return;
+}
@@ -0,0 +1,33 @@
+
+/**
+ * @file msi.cpp
+ * @brief aarch64 消息信号中断
+ * @author Zone.N (Zone.Niuzh@hotmail.com)
+ * @version 1.0
+ * @date 2026-10-18
+ * @copyright MIT LICENSE
+ * https://github.com/MRNIU/cmake-kernel
+ * @par change log:
+ * <table>
+ * <tr><th>Date<th>Author<th>Description
+ * <tr><td>2026-10-18<td>Zone.N (Zone.Niuzh@hotmail.com)<td>创建文件
+ * </table>
+ */
+
+#include "msi.h"
+
+// 没有支持消息信号中断的中断控制器驱动 (riscv 的 IMSIC、arm 的 ITS)，
+// 分配总是失败，设备驱动使用轮询
+size_t msi_alloc(size_t _cpu, void (*_handler)(void* _arg), void* _arg,
+                 msi_msg_t* _msg) {
+    (void)_cpu;
+    (void)_handler;
+    (void)_arg;
+    (void)_msg;
+    return 0;
+}
+
+void msi_free(size_t _no) {
+    (void)_no;
+    return;
+}
@@ -0,0 +1,32 @@
+
+/**
+ * @file smp.cpp
+ * @brief aarch64 多核启动
+ * @author Zone.N (Zone.Niuzh@hotmail.com)
+ * @version 1.0
+ * @date 2026-10-18
+ * @copyright MIT LICENSE
+ * https://github.com/MRNIU/cmake-kernel
+ * @par change log:
+ * <table>
+ * <tr><th>Date<th>Author<th>Description
+ * <tr><td>2026-10-18<td>Zone.N (Zone.Niuzh@hotmail.com)<td>创建文件
+ * </table>
+ */
+
+#include "smp.h"
+
+/// @todo 使用 psci CPU_ON 启动其它 cpu
+size_t smp_arch_boot(void) {
+    return 0;
+}
+
+/// @todo 通过 gic 发送 sgi
+void smp_arch_send_ipi(size_t _hartid) {
+    (void)_hartid;
+    return;
+}
+
+void smp_arch_ipi_ack(void) {
+    return;
+}
@@ -20,10 +20,5 @@ int32_t arch(uint32_t _argc, uint8_t** _argv) {
     (void)_argc;
     (void)_argv;
 
-    // 进入死循环
-    while (1) {
-        ;
-    }
-
     return 0;
 }
@@ -0,0 +1,132 @@
+
+/**
+ * @file fpu.cpp
+ * @brief 浮点/向量状态管理
+ * @author Zone.N (Zone.Niuzh@hotmail.com)
+ * @version 1.0
+ * @date 2026-10-18
+ * @copyright MIT LICENSE
+ * https://github.com/MRNIU/cmake-kernel
+ * @par change log:
+ * <table>
+ * <tr><th>Date<th>Author<th>Description
+ * <tr><td>2026-10-18<td>Zone.N (Zone.Niuzh@hotmail.com)<td>创建文件
+ * </table>
+ */
+
+#include "fpu.h"
+#include "cpu.h"
+#include "interrupt.h"
+#include "percpu.h"
+
+// 只有 kernel_fpu_begin/kernel_fpu_end 之间可以使用浮点/向量寄存器，
+// 其它时候访问被禁止。寄存器中的状态属于 fpu_owner，
+// 只有在本次运行中启用过寄存器的任务在切换时需要保存，
+// 只做整数运算的任务切换时不访问浮点/向量状态。
+// 段结束后寄存器的内容不再保留；在段中被切换出去的任务再次使用时，
+// 如果寄存器中仍是它的状态 (没有其它任务使用过，也没有迁移) 则不需要恢复
+
+/// 调度器接管之前各 cpu 使用的状态
+static fpu_state_t boot_states[MAX_CPU_COUNT];
+
+/// 寄存器中是谁的状态
+static DEFINE_PER_CPU(fpu_state_t*, fpu_owner);
+/// 当前任务的状态
+static DEFINE_PER_CPU(fpu_state_t*, fpu_current);
+/// 当前任务是否已允许访问寄存器
+static DEFINE_PER_CPU(bool, fpu_enabled);
+
+/**
+ * @brief 允许当前任务访问寄存器，必要时加载它的状态
+ * @param  _state                  当前任务的状态
+ * @param  _restore                true 时从 _state 恢复，否则恢复为初始状态
+ */
+static void fpu_activate(fpu_state_t* _state, bool _restore) {
+    fpu_arch_enable();
+    this_cpu_write(fpu_enabled, true);
+    auto cpu = cpu_id();
+    if ((this_cpu_read(fpu_owner) == _state) && (_state->cpu == cpu)) {
+        return;
+    }
+    if (_restore) {
+        fpu_arch_restore(_state);
+    }
+    else {
+        fpu_arch_restore_init();
+    }
+    this_cpu_write(fpu_owner, _state);
+    _state->cpu = cpu;
+    return;
+}
+
+void fpu_init(void) {
+    fpu_arch_init();
+    fpu_cpu_init();
+    return;
+}
+
+void fpu_cpu_init(void) {
+    auto* state = &boot_states[cpu_id()];
+    fpu_state_init(state);
+    fpu_arch_cpu_init();
+    this_cpu_write<fpu_state_t*>(fpu_owner, nullptr);
+    this_cpu_write(fpu_current, state);
+    this_cpu_write(fpu_enabled, false);
+    return;
+}
+
+void fpu_state_init(fpu_state_t* _state) {
+    // 不与任何 cpu 的 fpu_owner 匹配，复用的状态不会被当作仍在寄存器中
+    _state->cpu   = SIZE_MAX;
+    _state->depth = 0;
+    return;
+}
+
+void fpu_switch(fpu_state_t* _next) {
+    auto* curr = this_cpu_read(fpu_current);
+    if (this_cpu_read(fpu_enabled)) {
+        fpu_arch_save(curr);
+        curr->cpu = cpu_id();
+        fpu_arch_disable();
+        this_cpu_write(fpu_enabled, false);
+    }
+    this_cpu_write(fpu_current, _next);
+    if (!FPU_LAZY_RESTORE && (_next->depth != 0)) {
+        fpu_activate(_next, true);
+    }
+    return;
+}
+
+bool fpu_fault(void) {
+    auto* state = this_cpu_read(fpu_current);
+    if ((state->depth == 0) || this_cpu_read(fpu_enabled)) {
+        return false;
+    }
+    fpu_activate(state, true);
+    return true;
+}
+
+bool kernel_fpu_usable(void) {
+    return !in_interrupt();
+}
+
+void kernel_fpu_begin(void) {
+    auto  flags = cpu_irq_save();
+    auto* state = this_cpu_read(fpu_current);
+    if (state->depth++ == 0) {
+        fpu_activate(state, false);
+    }
+    cpu_irq_restore(flags);
+    return;
+}
+
+void kernel_fpu_end(void) {
+    auto  flags = cpu_irq_save();
+    auto* state = this_cpu_read(fpu_current);
+    if ((--state->depth == 0) && this_cpu_read(fpu_enabled)) {
+        fpu_arch_disable();
+        this_cpu_write(fpu_enabled, false);
+    }
+    cpu_irq_restore(flags);
+    return;
+}
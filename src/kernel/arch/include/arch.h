@@ -17,8 +17,28 @@
 #ifndef CMAKE_ARCH_H
 #define CMAKE_ARCH_H
 
+#include "cstddef"
 #include "cstdint"
 
-int32_t arch(uint32_t _argc, uint8_t** _argv);
+int32_t     arch(uint32_t _argc, uint8_t** _argv);
+
+/**
+ * @brief 固件传递的扁平设备树
+ * @return const void*             设备树，没有时为 nullptr
+ */
+const void* arch_fdt(void);
+
+/**
+ * @brief ACPI 根系统描述指针 (RSDP)
+ * @return uintptr_t               RSDP 的物理地址，没有时为 0
+ */
+uintptr_t   arch_acpi_rsdp(void);
+
+/**
+ * @brief 加载器传入的 initramfs
+ * @param  _size                   输出，长度
+ * @return const void*             起始地址，没有时为 nullptr
+ */
+const void* arch_initrd(size_t* _size);
 
 #endif /* CMAKE_ARCH_H */
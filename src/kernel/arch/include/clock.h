@@ -0,0 +1,62 @@
+
+/**
+ * @file clock.h
+ * @brief 架构相关的时钟
+ * @author Zone.N (Zone.Niuzh@hotmail.com)
+ * @version 1.0
+ * @date 2026-10-18
+ * @copyright MIT LICENSE
+ * https://github.com/MRNIU/cmake-kernel
+ * @par change log:
+ * <table>
+ * <tr><th>Date<th>Author<th>Description
+ * <tr><td>2026-10-18<td>Zone.N (Zone.Niuzh@hotmail.com)<td>创建文件
+ * </table>
+ */
+
+#ifndef CMAKE_KERNEL_CLOCK_H
+#define CMAKE_KERNEL_CLOCK_H
+
+#include "cstddef"
+#include "cstdint"
+
+/**
+ * @brief 校准时钟，由启动 cpu 在中断初始化之后调用
+ */
+void     clock_arch_init(void);
+
+/**
+ * @brief 打开当前 cpu 的时钟中断，此时不会产生中断
+ */
+void     clock_arch_cpu_init(void);
+
+/**
+ * @brief 读取计数器，各 cpu 的计数器同步且频率恒定
+ * @return uint64_t                计数值
+ */
+uint64_t clock_arch_read(void);
+
+/**
+ * @brief 计数器频率
+ * @return uint64_t                Hz
+ */
+uint64_t clock_arch_freq(void);
+
+/**
+ * @brief 在当前 cpu 的计数器达到 _deadline 时产生一次 INTERRUPT_TIMER
+ * 会覆盖之前设置的时间，_deadline 已过去时尽快产生中断
+ * @param  _deadline               计数值
+ */
+void     clock_arch_set_event(uint64_t _deadline);
+
+/**
+ * @brief 取消当前 cpu 的时钟中断
+ */
+void     clock_arch_stop_event(void);
+
+/**
+ * @brief 应答时钟中断
+ */
+void     clock_arch_ack(void);
+
+#endif /* CMAKE_KERNEL_CLOCK_H */
@@ -0,0 +1,112 @@
+
+/**
+ * @file fpu.h
+ * @brief 浮点/向量状态管理
+ * @author Zone.N (Zone.Niuzh@hotmail.com)
+ * @version 1.0
+ * @date 2026-10-18
+ * @copyright MIT LICENSE
+ * https://github.com/MRNIU/cmake-kernel
+ * @par change log:
+ * <table>
+ * <tr><th>Date<th>Author<th>Description
+ * <tr><td>2026-10-18<td>Zone.N (Zone.Niuzh@hotmail.com)<td>创建文件
+ * </table>
+ */
+
+#ifndef CMAKE_KERNEL_FPU_H
+#define CMAKE_KERNEL_FPU_H
+
+#include "cstddef"
+#include "cstdint"
+
+#include "context.h"
+
+/**
+ * @brief 初始化浮点/向量状态管理，由启动 cpu 在中断初始化之后调用
+ */
+void fpu_init(void);
+
+/**
+ * @brief 初始化当前 cpu，之后访问浮点/向量寄存器会被禁止
+ */
+void fpu_cpu_init(void);
+
+/**
+ * @brief 初始化任务的状态，任务还没有使用过浮点/向量寄存器
+ * @param  _state                  任务的状态
+ */
+void fpu_state_init(fpu_state_t* _state);
+
+/**
+ * @brief 切换任务前调用，需要关中断
+ * 当前任务在本次运行中启用过浮点/向量寄存器时保存其状态，
+ * 否则不访问浮点/向量状态
+ * @param  _next                   要切换到的任务的状态
+ */
+void fpu_switch(fpu_state_t* _next);
+
+/**
+ * @brief 访问被禁止的浮点/向量寄存器时由异常处理调用
+ * @return true                    当前任务在 SIMD 段中，已恢复其状态
+ * @return false                   不在 SIMD 段中，是错误的使用
+ */
+bool fpu_fault(void);
+
+/**
+ * @brief 当前上下文是否可以使用 kernel_fpu_begin
+ * @return true                    可以
+ * @return false                   在中断上下文中，不能使用
+ */
+bool kernel_fpu_usable(void);
+
+/**
+ * @brief 开始使用浮点/向量寄存器，可以嵌套
+ * 段中允许被抢占与迁移，状态在切换时保存；
+ * 段开始时寄存器的值不确定，段结束后不保留
+ */
+void kernel_fpu_begin(void);
+
+/**
+ * @brief 结束使用浮点/向量寄存器
+ */
+void kernel_fpu_end(void);
+
+/**
+ * @brief 架构相关的初始化，检测支持的状态与保存方式
+ */
+void fpu_arch_init(void);
+
+/**
+ * @brief 架构相关的当前 cpu 初始化，返回时访问被禁止
+ */
+void fpu_arch_cpu_init(void);
+
+/**
+ * @brief 允许访问浮点/向量寄存器
+ */
+void fpu_arch_enable(void);
+
+/**
+ * @brief 禁止访问浮点/向量寄存器，之后访问会产生异常
+ */
+void fpu_arch_disable(void);
+
+/**
+ * @brief 将寄存器保存到 _state，只保存修改过的部分，需要已允许访问
+ * @param  _state                  任务的状态
+ */
+void fpu_arch_save(fpu_state_t* _state);
+
+/**
+ * @brief 从 _state 恢复寄存器，需要已允许访问
+ * @param  _state                  任务的状态
+ */
+void fpu_arch_restore(const fpu_state_t* _state);
+
+/**
+ * @brief 将寄存器恢复为初始状态，需要已允许访问
+ */
+void fpu_arch_restore_init(void);
+
+#endif /* CMAKE_KERNEL_FPU_H */
@@ -0,0 +1,101 @@
+
+/**
+ * @file interrupt.h
+ * @brief 中断处理
+ * @author Zone.N (Zone.Niuzh@hotmail.com)
+ * @version 1.0
+ * @date 2026-10-18
+ * @copyright MIT LICENSE
+ * https://github.com/MRNIU/cmake-kernel
+ * @par change log:
+ * <table>
+ * <tr><th>Date<th>Author<th>Description
+ * <tr><td>2026-10-18<td>Zone.N (Zone.Niuzh@hotmail.com)<td>创建文件
+ * </table>
+ */
+
+#ifndef CMAKE_KERNEL_INTERRUPT_H
+#define CMAKE_KERNEL_INTERRUPT_H
+
+#include "cstddef"
+#include "cstdint"
+
+#include "trap.h"
+
+/**
+ * @brief 中断处理函数
+ * @param  _no                     中断号
+ * @param  _frame                  中断帧，返回时从这里恢复寄存器
+ */
+typedef void (*interrupt_handler_t)(size_t _no, trap_frame_t* _frame);
+
+/**
+ * @brief 初始化中断，由启动 cpu 调用，完成后本 cpu 可以接收中断
+ * 不会打开中断
+ */
+void     interrupt_init(void);
+
+/**
+ * @brief 初始化当前 cpu 的中断入口，由每个非启动 cpu 调用
+ */
+void     interrupt_cpu_init(void);
+
+/**
+ * @brief 注册中断处理函数，会覆盖已有的处理函数
+ * @param  _no                     中断号
+ * @param  _handler                处理函数，nullptr 时恢复默认处理
+ * @return true                    成功
+ * @return false                   中断号超出范围
+ */
+bool     register_interrupt_handler(size_t              _no,
+                                    interrupt_handler_t _handler);
+
+/**
+ * @brief 是否在中断上下文中
+ * @return true                    是
+ * @return false                   否
+ */
+bool     in_interrupt(void);
+
+#if ENABLE_BENCH == 1
+/**
+ * @brief 当前 cpu 已处理的中断数
+ * @return uint64_t                中断数
+ */
+uint64_t interrupt_count(void);
+
+/**
+ * @brief 测量进出中断的开销
+ * 在当前 cpu 上触发 _iterations 次 INTERRUPT_BENCH 号中断，
+ * 期间临时替换该中断的处理函数，需要在没有其它 cpu 注册该中断时调用
+ * @param  _iterations             次数
+ * @return uint64_t                每次的平均周期数，不支持时返回 0
+ */
+uint64_t interrupt_bench(size_t _iterations);
+#endif
+
+/**
+ * @brief 架构相关的中断初始化，由 interrupt_init 调用
+ */
+void     interrupt_arch_init(void);
+
+/**
+ * @brief 架构相关的当前 cpu 中断初始化
+ */
+void     interrupt_arch_cpu_init(void);
+
+/**
+ * @brief 没有注册处理函数的中断
+ * @param  _no                     中断号
+ * @param  _frame                  中断帧
+ */
+void     interrupt_arch_default(size_t _no, trap_frame_t* _frame);
+
+/**
+ * @brief 中断入口调用的分发函数
+ * @param  _no                     中断号
+ * @param  _frame                  中断帧
+ */
+extern "C" void trap_dispatch(size_t _no, trap_frame_t* _frame);
+
+#endif /* CMAKE_KERNEL_INTERRUPT_H */
@@ -0,0 +1,49 @@
+
+/**
+ * @file msi.h
+ * @brief 消息信号中断
+ * @author Zone.N (Zone.Niuzh@hotmail.com)
+ * @version 1.0
+ * @date 2026-10-18
+ * @copyright MIT LICENSE
+ * https://github.com/MRNIU/cmake-kernel
+ * @par change log:
+ * <table>
+ * <tr><th>Date<th>Author<th>Description
+ * <tr><td>2026-10-18<td>Zone.N (Zone.Niuzh@hotmail.com)<td>创建文件
+ * </table>
+ */
+
+#ifndef CMAKE_KERNEL_MSI_H
+#define CMAKE_KERNEL_MSI_H
+
+#include "cstddef"
+#include "cstdint"
+
+/**
+ * @brief 设备写入 address 的 data 即触发中断
+ */
+struct msi_msg_t {
+    uint64_t address;
+    uint32_t data;
+};
+
+/**
+ * @brief 分配一个发往 _cpu 的消息信号中断
+ * 处理函数在 _cpu 的中断上下文中执行，返回后由本模块应答中断
+ * @param  _cpu                    目标 cpu 编号
+ * @param  _handler                处理函数
+ * @param  _arg                    处理函数的参数
+ * @param  _msg                    设备需要写入的消息
+ * @return size_t                  中断号，没有空闲中断号或架构不支持时为 0
+ */
+size_t msi_alloc(size_t _cpu, void (*_handler)(void* _arg), void* _arg,
+                 msi_msg_t* _msg);
+
+/**
+ * @brief 释放中断号，调用前设备需要已经停止发送该中断
+ * @param  _no                     msi_alloc 返回的中断号
+ */
+void   msi_free(size_t _no);
+
+#endif /* CMAKE_KERNEL_MSI_H */
@@ -0,0 +1,232 @@
+
+/**
+ * @file percpu.h
+ * @brief 每个 cpu 的数据
+ * @author Zone.N (Zone.Niuzh@hotmail.com)
+ * @version 1.0
+ * @date 2026-10-18
+ * @copyright MIT LICENSE
+ * https://github.com/MRNIU/cmake-kernel
+ * @par change log:
+ * <table>
+ * <tr><th>Date<th>Author<th>Description
+ * <tr><td>2026-10-18<td>Zone.N (Zone.Niuzh@hotmail.com)<td>创建文件
+ * </table>
+ */
+
+#ifndef CMAKE_KERNEL_PERCPU_H
+#define CMAKE_KERNEL_PERCPU_H
+
+#include "cstddef"
+#include "cstdint"
+
+#include "cpu.h"
+
+/**
+ * 使用 DEFINE_PER_CPU 定义的变量位于 .percpu 段，该段只是模板，
+ * 启动时为每个 cpu 复制一份。每个 cpu 将自己的副本相对模板的偏移
+ * 保存在 gs 基址 (x86_64)、tp (riscv64) 或 tpidr_el1 (aarch64) 中，
+ * 访问时在模板地址上加偏移即可，x86_64 上只需要一条 gs 前缀的指令。
+ * 在 percpu_init 之前偏移为 0，访问的是模板本身
+ */
+
+/// 每个 cpu 数据区的大小，包括模板与 percpu_alloc 动态分配的部分
+static constexpr const size_t PERCPU_AREA_SIZE = 16 * 1024;
+
+/**
+ * @brief 定义每个 cpu 的变量，对齐要求不能超过缓存行
+ * @param  _type                   类型
+ * @param  _name                   变量名
+ */
+#define DEFINE_PER_CPU(_type, _name)                                           \
+    __attribute__((section(".percpu"))) _type _name
+
+/**
+ * @brief 声明其它文件中定义的每个 cpu 的变量
+ * @param  _type                   类型
+ * @param  _name                   变量名
+ */
+#define DECLARE_PER_CPU(_type, _name) extern _type _name
+
+/// 各 cpu 数据区相对模板的偏移
+extern uintptr_t percpu_offsets[MAX_CPU_COUNT];
+
+/// 当前 cpu 数据区相对模板的偏移
+DECLARE_PER_CPU(uintptr_t, this_cpu_off);
+/// 当前 cpu 的编号，从 0 开始连续分配
+DECLARE_PER_CPU(size_t, cpu_number);
+/// 硬件 cpu 编号，riscv64 上为 hartid，x86_64 上为 apic id
+DECLARE_PER_CPU(size_t, cpu_hartid);
+
+/**
+ * @brief 获取指定 cpu 的副本
+ * @param  _ptr                    模板中的地址
+ * @param  _cpu                    cpu 编号
+ * @return T*                      _cpu 的副本地址
+ */
+template <class T>
+static inline T* per_cpu_ptr(T* _ptr, size_t _cpu) {
+    return reinterpret_cast<T*>(reinterpret_cast<uintptr_t>(_ptr)
+                                + percpu_offsets[_cpu]);
+}
+
+#if defined(__x86_64__)
+
+/**
+ * @brief 读取当前 cpu 的副本，编译为一条 gs 相对的 mov
+ * @param  _var                    模板中的变量
+ * @return T                       当前 cpu 副本的值
+ */
+template <class T>
+static inline T this_cpu_read(const T& _var) {
+    static_assert(sizeof(T) <= sizeof(uint64_t), "use this_cpu_ptr");
+    T val;
+    __asm__ volatile("mov %%gs:%1, %0" : "=r"(val) : "m"(_var));
+    return val;
+}
+
+/**
+ * @brief 写当前 cpu 的副本
+ * @param  _var                    模板中的变量
+ * @param  _val                    值
+ */
+template <class T>
+static inline void this_cpu_write(T& _var, T _val) {
+    static_assert(sizeof(T) <= sizeof(uint64_t), "use this_cpu_ptr");
+    __asm__ volatile("mov %1, %%gs:%0" : "=m"(_var) : "r"(_val));
+    return;
+}
+
+/**
+ * @brief 当前 cpu 的副本加上 _val，单条指令，不会被本 cpu 的中断打断
+ * @param  _var                    模板中的变量
+ * @param  _val                    增量
+ */
+template <class T>
+static inline void this_cpu_add(T& _var, T _val) {
+    static_assert(sizeof(T) <= sizeof(uint64_t), "use this_cpu_ptr");
+    __asm__ volatile("add %1, %%gs:%0" : "+m"(_var) : "r"(_val));
+    return;
+}
+
+/**
+ * @brief 获取当前 cpu 的副本
+ * @param  _ptr                    模板中的地址
+ * @return T*                      当前 cpu 的副本地址
+ */
+template <class T>
+static inline T* this_cpu_ptr(T* _ptr) {
+    return reinterpret_cast<T*>(reinterpret_cast<uintptr_t>(_ptr)
+                                + this_cpu_read(this_cpu_off));
+}
+
+#else
+
+template <class T>
+static inline T* this_cpu_ptr(T* _ptr) {
+    return reinterpret_cast<T*>(reinterpret_cast<uintptr_t>(_ptr)
+                                + cpu_percpu_offset());
+}
+
+template <class T>
+static inline T this_cpu_read(const T& _var) {
+    return *const_cast<volatile T*>(this_cpu_ptr(&_var));
+}
+
+template <class T>
+static inline void this_cpu_write(T& _var, T _val) {
+    *const_cast<volatile T*>(this_cpu_ptr(&_var)) = _val;
+    return;
+}
+
+/**
+ * @brief 当前 cpu 的副本加上 _val
+ * 使用原子加法 (riscv64 上为一条 amoadd)，不会被本 cpu 的中断打断
+ */
+template <class T>
+static inline void this_cpu_add(T& _var, T _val) {
+    __atomic_fetch_add(this_cpu_ptr(&_var), _val, __ATOMIC_RELAXED);
+    return;
+}
+
+#endif
+
+/**
+ * @brief 获取当前 cpu 的编号
+ * @return size_t                  编号
+ */
+static inline size_t cpu_id(void) {
+    return this_cpu_read(cpu_number);
+}
+
+/**
+ * @brief 为每个 cpu 复制 .percpu 模板，并设置启动 cpu 的偏移
+ * 由启动 cpu 在访问任何 percpu 变量前调用
+ * @param  _hartid                 启动 cpu 的硬件编号
+ */
+void percpu_init(size_t _hartid);
+
+/**
+ * @brief 设置当前 cpu 的偏移，由每个 cpu 启动时调用
+ * @param  _cpu                    cpu 编号
+ */
+void percpu_cpu_init(size_t _cpu);
+
+/**
+ * @brief 在每个 cpu 的数据区中分配空间，初始化为 0，不能释放
+ * @param  _size                   大小
+ * @param  _align                  对齐，不能超过缓存行
+ * @return void*                   模板地址空间中的地址，需要通过
+ * per_cpu_ptr/this_cpu_ptr 访问，空间不足时返回 nullptr
+ */
+void* percpu_alloc(size_t _size, size_t _align);
+
+/**
+ * @brief 每个 cpu 的计数器
+ * 修改只写本 cpu 的副本，累计超过 batch 时才合并到全局计数，
+ * 读取全局计数只需一次读，结果误差不超过 cpu 数 * batch
+ */
+class PercpuCounter {
+private:
+    /// 已合并的全局计数
+    int64_t  count;
+    /// 合并阈值
+    int64_t  batch;
+    /// 每个 cpu 尚未合并的计数
+    int64_t* local;
+
+public:
+    PercpuCounter(void);
+    ~PercpuCounter(void) = default;
+
+    PercpuCounter(const PercpuCounter&)            = delete;
+    PercpuCounter& operator=(const PercpuCounter&) = delete;
+
+    /**
+     * @brief 初始化，需要在 percpu_init 之后调用
+     * @param  _batch              合并阈值
+     * @return true                成功
+     * @return false               percpu 空间不足
+     */
+    bool init(int64_t _batch);
+
+    /**
+     * @brief 增加计数，可以在中断处理函数中调用
+     * @param  _val                增量，可以为负
+     */
+    void add(int64_t _val);
+
+    /**
+     * @brief 读取近似值
+     * @return int64_t             已合并的全局计数
+     */
+    int64_t read(void) const;
+
+    /**
+     * @brief 读取精确值，需要遍历所有 cpu
+     * @return int64_t             全局计数加上各 cpu 未合并的计数
+     */
+    int64_t sum(void) const;
+};
+
+#endif /* CMAKE_KERNEL_PERCPU_H */
@@ -0,0 +1,79 @@
+
+/**
+ * @file smp.h
+ * @brief 多核启动
+ * @author Zone.N (Zone.Niuzh@hotmail.com)
+ * @version 1.0
+ * @date 2026-10-18
+ * @copyright MIT LICENSE
+ * https://github.com/MRNIU/cmake-kernel
+ * @par change log:
+ * <table>
+ * <tr><th>Date<th>Author<th>Description
+ * <tr><td>2026-10-18<td>Zone.N (Zone.Niuzh@hotmail.com)<td>创建文件
+ * </table>
+ */
+
+#ifndef CMAKE_KERNEL_SMP_H
+#define CMAKE_KERNEL_SMP_H
+
+#include "cstddef"
+#include "cstdint"
+
+/// 每个 cpu 的启动栈大小
+static constexpr const size_t CPU_STACK_SIZE = 16 * 1024;
+
+/// 非启动 cpu 使用的栈
+extern uint8_t cpu_stacks[MAX_CPU_COUNT][CPU_STACK_SIZE];
+
+/**
+ * @brief 启动其它 cpu，返回时所有 cpu 均已在线
+ * 需要在 percpu_init 之后调用
+ */
+void   smp_init(void);
+
+/**
+ * @brief 架构相关的多核启动，同时唤醒所有 cpu 并等待它们上线
+ * @return size_t                  上线的非启动 cpu 数
+ */
+size_t smp_arch_boot(void);
+
+/**
+ * @brief 非启动 cpu 进入 C 代码后的公共流程，不会返回
+ * @param  _cpu                    cpu 编号
+ * @param  _hartid                 硬件 cpu 编号
+ */
+[[noreturn]] void smp_ap_main(size_t _cpu, size_t _hartid);
+
+/**
+ * @brief 向 _cpu 发送处理器间中断，用于唤醒空闲的 cpu
+ * @param  _cpu                    cpu 编号
+ */
+void   smp_send_ipi(size_t _cpu);
+
+/**
+ * @brief 架构相关的处理器间中断发送
+ * @param  _hartid                 硬件 cpu 编号
+ */
+void   smp_arch_send_ipi(size_t _hartid);
+
+/**
+ * @brief 应答处理器间中断
+ */
+void   smp_arch_ipi_ack(void);
+
+/**
+ * @brief 在线 cpu 数
+ * @return size_t                  包括启动 cpu
+ */
+size_t smp_cpu_count(void);
+
+/**
+ * @brief cpu 是否在线
+ * @param  _cpu                    cpu 编号
+ * @return true                    在线
+ * @return false                   不在线
+ */
+bool   smp_cpu_is_online(size_t _cpu);
+
+#endif /* CMAKE_KERNEL_SMP_H */
@@ -0,0 +1,120 @@
+
+/**
+ * @file interrupt.cpp
+ * @brief 中断处理
+ * @author Zone.N (Zone.Niuzh@hotmail.com)
+ * @version 1.0
+ * @date 2026-10-18
+ * @copyright MIT LICENSE
+ * https://github.com/MRNIU/cmake-kernel
+ * @par change log:
+ * <table>
+ * <tr><th>Date<th>Author<th>Description
+ * <tr><td>2026-10-18<td>Zone.N (Zone.Niuzh@hotmail.com)<td>创建文件
+ * </table>
+ */
+
+#include "interrupt.h"
+#include "cpu.h"
+#include "percpu.h"
+#include "rcu.h"
+#include "sched.h"
+
+/// 中断处理函数，所有 cpu 共享
+static interrupt_handler_t handlers[INTERRUPT_MAX];
+
+/// 当前 cpu 的中断嵌套深度
+static DEFINE_PER_CPU(size_t, irq_nesting);
+#if ENABLE_BENCH == 1
+/// 当前 cpu 已处理的中断数
+static DEFINE_PER_CPU(uint64_t, irq_count);
+#endif
+
+extern "C" void trap_dispatch(size_t _no, trap_frame_t* _frame) {
+    // 从空闲中唤醒时，处理函数中的 rcu 读端需要被宽限期等待
+    auto outermost = this_cpu_read(irq_nesting) == 0;
+    if (outermost) {
+        rcu_irq_enter();
+    }
+    this_cpu_add<size_t>(irq_nesting, 1);
+#if ENABLE_BENCH == 1
+    this_cpu_add<uint64_t>(irq_count, 1);
+#endif
+    auto handler = __atomic_load_n(&handlers[_no], __ATOMIC_ACQUIRE);
+    if (handler != nullptr) {
+        handler(_no, _frame);
+    }
+    else {
+        interrupt_arch_default(_no, _frame);
+    }
+    this_cpu_add<size_t>(irq_nesting, -1);
+    if (outermost) {
+        rcu_irq_exit();
+        // 处理函数唤醒了更重要的任务或时间片用完时，在返回前切换
+        sched_irq_exit(_frame);
+    }
+    return;
+}
+
+void interrupt_init(void) {
+    interrupt_arch_init();
+    interrupt_cpu_init();
+    return;
+}
+
+void interrupt_cpu_init(void) {
+    interrupt_arch_cpu_init();
+    return;
+}
+
+bool register_interrupt_handler(size_t _no, interrupt_handler_t _handler) {
+    if (_no >= INTERRUPT_MAX) {
+        return false;
+    }
+    __atomic_store_n(&handlers[_no], _handler, __ATOMIC_RELEASE);
+    return true;
+}
+
+bool in_interrupt(void) {
+    return this_cpu_read(irq_nesting) != 0;
+}
+
+#if ENABLE_BENCH == 1
+uint64_t interrupt_count(void) {
+    return this_cpu_read(irq_count);
+}
+
+/**
+ * @brief 测量用的空处理函数
+ */
+static void bench_handler(size_t _no, trap_frame_t* _frame) {
+    (void)_no;
+    (void)_frame;
+    trap_ack_bench();
+    return;
+}
+
+uint64_t interrupt_bench(size_t _iterations) {
+    if (_iterations == 0) {
+        return 0;
+    }
+    auto old   = __atomic_load_n(&handlers[INTERRUPT_BENCH], __ATOMIC_ACQUIRE);
+    auto count = interrupt_count();
+    register_interrupt_handler(INTERRUPT_BENCH, bench_handler);
+    auto flags = cpu_irq_save();
+    cpu_irq_enable();
+    auto start = cpu_cycles();
+    for (size_t i = 0; i < _iterations; i++) {
+        trap_raise_bench();
+    }
+    auto end = cpu_cycles();
+    cpu_irq_disable();
+    cpu_irq_restore(flags);
+    register_interrupt_handler(INTERRUPT_BENCH, old);
+    // 中断没有被送达，说明该架构不支持
+    if (interrupt_count() - count < _iterations) {
+        return 0;
+    }
+    return (end - start) / _iterations;
+}
+#endif
@@ -0,0 +1,109 @@
+
+/**
+ * @file percpu.cpp
+ * @brief 每个 cpu 的数据
+ * @author Zone.N (Zone.Niuzh@hotmail.com)
+ * @version 1.0
+ * @date 2026-10-18
+ * @copyright MIT LICENSE
+ * https://github.com/MRNIU/cmake-kernel
+ * @par change log:
+ * <table>
+ * <tr><th>Date<th>Author<th>Description
+ * <tr><td>2026-10-18<td>Zone.N (Zone.Niuzh@hotmail.com)<td>创建文件
+ * </table>
+ */
+
+#include "percpu.h"
+#include "cpu.h"
+#include "libc.h"
+#include "libcxx.h"
+
+/// 由链接脚本提供的 .percpu 模板范围
+extern "C" uint8_t __percpu_start[];
+extern "C" uint8_t __percpu_end[];
+
+/// 每个 cpu 的数据区
+alignas(CACHE_LINE_SIZE) static uint8_t
+  percpu_areas[MAX_CPU_COUNT][PERCPU_AREA_SIZE];
+
+uintptr_t percpu_offsets[MAX_CPU_COUNT];
+
+DEFINE_PER_CPU(uintptr_t, this_cpu_off);
+DEFINE_PER_CPU(size_t, cpu_number);
+DEFINE_PER_CPU(size_t, cpu_hartid);
+
+/// 已使用的大小，动态分配的空间紧跟在模板之后
+static size_t percpu_used = 0;
+
+void percpu_init(size_t _hartid) {
+    auto size = static_cast<size_t>(__percpu_end - __percpu_start);
+    // 模板超过数据区大小，需要增大 PERCPU_AREA_SIZE
+    if (size > PERCPU_AREA_SIZE) {
+        __builtin_trap();
+    }
+    for (size_t i = 0; i < MAX_CPU_COUNT; i++) {
+        memcpy(percpu_areas[i], __percpu_start, size);
+        memset(percpu_areas[i] + size, 0, PERCPU_AREA_SIZE - size);
+        percpu_offsets[i] = reinterpret_cast<uintptr_t>(percpu_areas[i])
+                            - reinterpret_cast<uintptr_t>(__percpu_start);
+        *per_cpu_ptr(&this_cpu_off, i) = percpu_offsets[i];
+        *per_cpu_ptr(&cpu_number, i)   = i;
+    }
+    percpu_used                  = size;
+    *per_cpu_ptr(&cpu_hartid, 0) = _hartid;
+    percpu_cpu_init(0);
+    return;
+}
+
+void percpu_cpu_init(size_t _cpu) {
+    cpu_set_percpu_offset(percpu_offsets[_cpu]);
+    return;
+}
+
+void* percpu_alloc(size_t _size, size_t _align) {
+    // 启动阶段调用，不需要加锁
+    auto offset = (percpu_used + _align - 1) & ~(_align - 1);
+    if ((_align > CACHE_LINE_SIZE) || (offset + _size > PERCPU_AREA_SIZE)) {
+        return nullptr;
+    }
+    percpu_used = offset + _size;
+    return __percpu_start + offset;
+}
+
+PercpuCounter::PercpuCounter(void) : count(0), batch(0), local(nullptr) {
+}
+
+bool PercpuCounter::init(int64_t _batch) {
+    batch = _batch;
+    local = static_cast<int64_t*>(percpu_alloc(sizeof(int64_t),
+                                               alignof(int64_t)));
+    return local != nullptr;
+}
+
+void PercpuCounter::add(int64_t _val) {
+    // 读-改-写期间不能被本 cpu 的中断打断，也不能迁移到其它 cpu
+    auto  flags       = cpu_irq_save();
+    auto* local_count = this_cpu_ptr(local);
+    auto  val         = *local_count + _val;
+    if ((val >= batch) || (val <= -batch)) {
+        __atomic_fetch_add(&count, val, __ATOMIC_RELAXED);
+        val = 0;
+    }
+    // sum 会在其它 cpu 上并发读取
+    __atomic_store_n(local_count, val, __ATOMIC_RELAXED);
+    cpu_irq_restore(flags);
+    return;
+}
+
+int64_t PercpuCounter::read(void) const {
+    return __atomic_load_n(&count, __ATOMIC_RELAXED);
+}
+
+int64_t PercpuCounter::sum(void) const {
+    auto val = __atomic_load_n(&count, __ATOMIC_RELAXED);
+    for (size_t i = 0; i < MAX_CPU_COUNT; i++) {
+        val += __atomic_load_n(per_cpu_ptr(local, i), __ATOMIC_RELAXED);
+    }
+    return val;
+}
@@ -14,21 +14,16 @@
  * </table>
  */
 
+#include "arch.h"
+#include "fpu.h"
+#include "interrupt.h"
+#include "percpu.h"
+#include "sbi.h"
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 
-#include "cstdint"
-
-#include "sbi/sbi_ecall_interface.h"
-
-struct sbiret_t {
-    /// 错误码
-    long error;
-    /// 返回值
-    long value;
-};
-
 sbiret_t
 ecall(unsigned long _arg0, unsigned long _arg1, unsigned long _arg2,
                unsigned long _arg3, unsigned long _arg4, unsigned long _arg5,
@@ -42,10 +37,10 @@ ecall(unsigned long _arg0, unsigned long _arg1, unsigned long _arg2,
     register uintptr_t a5 asm("a5") = (uintptr_t)(_arg5);
     register uintptr_t a6 asm("a6") = (uintptr_t)(_fid);
     register uintptr_t a7 asm("a7") = (uintptr_t)(_eid);
-    asm("ecall"
-        : "+r"(a0), "+r"(a1)
-        : "r"(a2), "r"(a3), "r"(a4), "r"(a5), "r"(a6), "r"(a7)
-        : "memory");
+    asm volatile("ecall"
+                 : "+r"(a0), "+r"(a1)
+                 : "r"(a2), "r"(a3), "r"(a4), "r"(a5), "r"(a6), "r"(a7)
+                 : "memory");
     ret.error = a0;
     ret.value = a1;
     return ret;
@@ -56,7 +51,26 @@ void put_char(const char _c) {
     return;
 }
 
-int arch(int, char **) {
+#ifdef __cplusplus
+}
+#endif
+
+/// opensbi 通过 a1 传入的设备树
+static const void* fdt_blob;
+
+int32_t arch(uint32_t _argc, uint8_t** _argv) {
+    // 初始化每个 cpu 的数据，opensbi 通过 a0 传入 hartid
+    percpu_init(_argc);
+
+    // a1 为设备树的物理地址
+    fdt_blob = _argv;
+
+    // 初始化中断，此时中断仍然是关闭的
+    interrupt_init();
+
+    // 禁止访问浮点/向量寄存器，只在 kernel_fpu_begin/end 之间使用
+    fpu_init();
+
     put_char('H');
     put_char('e');
     put_char('l');
@@ -71,6 +85,16 @@ int arch(int, char **) {
     return 0;
 }
 
-#ifdef __cplusplus
+const void* arch_fdt(void) {
+    return fdt_blob;
+}
+
+uintptr_t arch_acpi_rsdp(void) {
+    return 0;
+}
+
+/// 由设备树 /chosen 描述
+const void* arch_initrd(size_t* _size) {
+    *_size = 0;
+    return nullptr;
 }
-#endif
@@ -0,0 +1,88 @@
+
+/**
+ * @file clock.cpp
+ * @brief riscv64 时钟
+ * @author Zone.N (Zone.Niuzh@hotmail.com)
+ * @version 1.0
+ * @date 2026-10-18
+ * @copyright MIT LICENSE
+ * https://github.com/MRNIU/cmake-kernel
+ * @par change log:
+ * <table>
+ * <tr><th>Date<th>Author<th>Description
+ * <tr><td>2026-10-18<td>Zone.N (Zone.Niuzh@hotmail.com)<td>创建文件
+ * </table>
+ */
+
+#include "clock.h"
+#include "cpu.h"
+#include "interrupt.h"
+#include "sbi.h"
+
+/// time 的频率
+/// @todo 从设备树 /cpus/timebase-frequency 获取，这里使用 qemu virt 的值
+static constexpr const uint64_t TIMEBASE_FREQ = 10000000;
+/// 非法指令异常
+static constexpr const size_t   ILLEGAL_INSN  = INTERRUPT_EXCEPTION_BASE + 2;
+/// sie 中 s 态时钟中断位
+static constexpr const uint64_t SIE_STIE      = 1 << INTERRUPT_S_TIMER;
+
+/// 是否可以直接写 stimecmp (Sstc)，否则通过 sbi 设置
+static bool sstc;
+
+/**
+ * @brief 探测 stimecmp 时的非法指令处理，跳过该指令并标记不支持
+ */
+static void sstc_probe_handler(size_t _no, trap_frame_t* _frame) {
+    (void)_no;
+    sstc          = false;
+    _frame->sepc += 4;
+    return;
+}
+
+void clock_arch_init(void) {
+    // 不支持 Sstc 或 m 态没有打开 menvcfg.STCE 时，访问 stimecmp 是非法指令
+    sstc = true;
+    register_interrupt_handler(ILLEGAL_INSN, sstc_probe_handler);
+    uint64_t val;
+    __asm__ volatile("csrr %0, 0x14D" : "=r"(val) : : "memory");
+    (void)val;
+    register_interrupt_handler(ILLEGAL_INSN, nullptr);
+    return;
+}
+
+void clock_arch_cpu_init(void) {
+    clock_arch_stop_event();
+    __asm__ volatile("csrs sie, %0" : : "r"(SIE_STIE) : "memory");
+    return;
+}
+
+uint64_t clock_arch_read(void) {
+    uint64_t time;
+    __asm__ volatile("rdtime %0" : "=r"(time));
+    return time;
+}
+
+uint64_t clock_arch_freq(void) {
+    return TIMEBASE_FREQ;
+}
+
+void clock_arch_set_event(uint64_t _deadline) {
+    // 写入新的比较值会同时清除挂起的时钟中断
+    if (sstc) {
+        __asm__ volatile("csrw 0x14D, %0" : : "r"(_deadline) : "memory");
+    }
+    else {
+        ecall(_deadline, 0, 0, 0, 0, 0, SBI_EXT_TIME_SET_TIMER, SBI_EXT_TIME);
+    }
+    return;
+}
+
+void clock_arch_stop_event(void) {
+    clock_arch_set_event(UINT64_MAX);
+    return;
+}
+
+void clock_arch_ack(void) {
+    return;
+}
@@ -0,0 +1,202 @@
+
+/**
+ * @file fpu.cpp
+ * @brief riscv64 浮点/向量状态
+ * @author Zone.N (Zone.Niuzh@hotmail.com)
+ * @version 1.0
+ * @date 2026-10-18
+ * @copyright MIT LICENSE
+ * https://github.com/MRNIU/cmake-kernel
+ * @par change log:
+ * <table>
+ * <tr><th>Date<th>Author<th>Description
+ * <tr><td>2026-10-18<td>Zone.N (Zone.Niuzh@hotmail.com)<td>创建文件
+ * </table>
+ */
+
+#include "cpu.h"
+#include "fpu.h"
+
+// 通过 sstatus.FS/VS 禁止访问，关闭时使用浮点/向量指令产生非法指令异常。
+// 寄存器被修改时硬件将 FS/VS 置为 Dirty，保存时只保存 Dirty 的部分；
+// 从保存区恢复后置为 Clean，没有修改时下次切换不需要保存
+
+static constexpr const uint64_t SSTATUS_VS       = 3 << 9;
+static constexpr const uint64_t SSTATUS_VS_CLEAN = 2 << 9;
+static constexpr const uint64_t SSTATUS_FS       = 3 << 13;
+static constexpr const uint64_t SSTATUS_FS_CLEAN = 2 << 13;
+
+/// 向量 csr
+static constexpr const uint32_t CSR_VSTART       = 0x008;
+static constexpr const uint32_t CSR_VCSR         = 0x00F;
+static constexpr const uint32_t CSR_VL           = 0xC20;
+static constexpr const uint32_t CSR_VTYPE        = 0xC21;
+static constexpr const uint32_t CSR_VLENB        = 0xC22;
+
+/// 是否启用向量扩展
+static bool fpu_vector = false;
+
+static inline uint64_t sstatus_read(void) {
+    uint64_t status;
+    __asm__ volatile("csrr %0, sstatus" : "=r"(status));
+    return status;
+}
+
+static inline void sstatus_set(uint64_t _bits) {
+    __asm__ volatile("csrs sstatus, %0" : : "r"(_bits) : "memory");
+    return;
+}
+
+static inline void sstatus_clear(uint64_t _bits) {
+    __asm__ volatile("csrc sstatus, %0" : : "r"(_bits) : "memory");
+    return;
+}
+
+template <uint32_t Csr>
+static inline uint64_t csr_read(void) {
+    uint64_t val;
+    __asm__ volatile("csrr %0, %1" : "=r"(val) : "i"(Csr));
+    return val;
+}
+
+template <uint32_t Csr>
+static inline void csr_write(uint64_t _val) {
+    __asm__ volatile("csrw %0, %1" : : "i"(Csr), "r"(_val) : "memory");
+    return;
+}
+
+/**
+ * @brief 将 FS/VS 置为 Clean，寄存器与保存区一致
+ */
+static void fpu_mark_clean(void) {
+    auto vs = fpu_vector ? SSTATUS_VS : 0;
+    sstatus_clear(SSTATUS_FS | vs);
+    sstatus_set(SSTATUS_FS_CLEAN | (fpu_vector ? SSTATUS_VS_CLEAN : 0));
+    return;
+}
+
+void fpu_arch_init(void) {
+    // 不支持向量扩展时 VS 恒为 0
+    sstatus_set(SSTATUS_VS_CLEAN);
+    if ((sstatus_read() & SSTATUS_VS) != 0) {
+        fpu_vector = csr_read<CSR_VLENB>() * 32 <= FPU_VECTOR_SIZE;
+    }
+    sstatus_clear(SSTATUS_VS);
+    return;
+}
+
+void fpu_arch_cpu_init(void) {
+    sstatus_clear(SSTATUS_FS | SSTATUS_VS);
+    return;
+}
+
+void fpu_arch_enable(void) {
+    fpu_mark_clean();
+    return;
+}
+
+void fpu_arch_disable(void) {
+    sstatus_clear(SSTATUS_FS | SSTATUS_VS);
+    return;
+}
+
+void fpu_arch_save(fpu_state_t* _state) {
+    auto status = sstatus_read();
+    if ((status & SSTATUS_FS) == SSTATUS_FS) {
+        __asm__ volatile(".irp n, 0,1,2,3,4,5,6,7,8,9,10,11,12,13,14,15,"
+                         "16,17,18,19,20,21,22,23,24,25,26,27,28,29,30,31\n"
+                         "fsd f\\n, \\n * 8(%0)\n"
+                         ".endr"
+                         :
+                         : "r"(_state->f)
+                         : "memory");
+        __asm__ volatile("frcsr %0" : "=r"(_state->fcsr));
+    }
+    if (fpu_vector && ((status & SSTATUS_VS) == SSTATUS_VS)) {
+        _state->vstart = csr_read<CSR_VSTART>();
+        _state->vcsr   = csr_read<CSR_VCSR>();
+        _state->vl     = csr_read<CSR_VL>();
+        _state->vtype  = csr_read<CSR_VTYPE>();
+        // 每组 8 个寄存器，每组 8 * vlenb 字节
+        auto*    dst   = _state->v;
+        uint64_t len;
+        __asm__ volatile(".option push\n"
+                         ".option arch, +v\n"
+                         "vsetvli %0, x0, e8, m8, ta, ma\n"
+                         "vse8.v v0, (%1)\n"
+                         "add %1, %1, %0\n"
+                         "vse8.v v8, (%1)\n"
+                         "add %1, %1, %0\n"
+                         "vse8.v v16, (%1)\n"
+                         "add %1, %1, %0\n"
+                         "vse8.v v24, (%1)\n"
+                         ".option pop"
+                         : "=&r"(len), "+r"(dst)
+                         :
+                         : "memory");
+    }
+    return;
+}
+
+void fpu_arch_restore(const fpu_state_t* _state) {
+    __asm__ volatile(".irp n, 0,1,2,3,4,5,6,7,8,9,10,11,12,13,14,15,"
+                     "16,17,18,19,20,21,22,23,24,25,26,27,28,29,30,31\n"
+                     "fld f\\n, \\n * 8(%0)\n"
+                     ".endr"
+                     :
+                     : "r"(_state->f)
+                     : "memory");
+    __asm__ volatile("fscsr %0" : : "r"(_state->fcsr));
+    if (fpu_vector) {
+        auto*    src = _state->v;
+        uint64_t len;
+        __asm__ volatile(".option push\n"
+                         ".option arch, +v\n"
+                         "vsetvli %0, x0, e8, m8, ta, ma\n"
+                         "vle8.v v0, (%1)\n"
+                         "add %1, %1, %0\n"
+                         "vle8.v v8, (%1)\n"
+                         "add %1, %1, %0\n"
+                         "vle8.v v16, (%1)\n"
+                         "add %1, %1, %0\n"
+                         "vle8.v v24, (%1)\n"
+                         "vsetvl x0, %2, %3\n"
+                         ".option pop"
+                         : "=&r"(len), "+r"(src)
+                         : "r"(_state->vl), "r"(_state->vtype)
+                         : "memory");
+        csr_write<CSR_VSTART>(_state->vstart);
+        csr_write<CSR_VCSR>(_state->vcsr);
+    }
+    // 恢复时写寄存器会将状态置为 Dirty
+    fpu_mark_clean();
+    return;
+}
+
+void fpu_arch_restore_init(void) {
+    __asm__ volatile(".irp n, 0,1,2,3,4,5,6,7,8,9,10,11,12,13,14,15,"
+                     "16,17,18,19,20,21,22,23,24,25,26,27,28,29,30,31\n"
+                     "fmv.d.x f\\n, zero\n"
+                     ".endr\n"
+                     "fscsr zero"
+                     :
+                     :
+                     : "memory");
+    if (fpu_vector) {
+        __asm__ volatile(".option push\n"
+                         ".option arch, +v\n"
+                         "vsetvli t0, x0, e8, m8, ta, ma\n"
+                         "vmv.v.i v0, 0\n"
+                         "vmv.v.i v8, 0\n"
+                         "vmv.v.i v16, 0\n"
+                         "vmv.v.i v24, 0\n"
+                         "csrw vstart, zero\n"
+                         "csrw vcsr, zero\n"
+                         ".option pop"
+                         :
+                         :
+                         : "t0", "memory");
+    }
+    // 保持 Dirty，保存区中还不是这个状态
+    return;
+}
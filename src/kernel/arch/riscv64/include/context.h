@@ -0,0 +1,94 @@
+
+/**
+ * @file context.h
+ * @brief riscv64 上下文切换
+ * @author Zone.N (Zone.Niuzh@hotmail.com)
+ * @version 1.0
+ * @date 2026-10-18
+ * @copyright MIT LICENSE
+ * https://github.com/MRNIU/cmake-kernel
+ * @par change log:
+ * <table>
+ * <tr><th>Date<th>Author<th>Description
+ * <tr><td>2026-10-18<td>Zone.N (Zone.Niuzh@hotmail.com)<td>创建文件
+ * </table>
+ */
+
+#ifndef CMAKE_KERNEL_CONTEXT_H
+#define CMAKE_KERNEL_CONTEXT_H
+
+#include "cstddef"
+#include "cstdint"
+
+/**
+ * @brief 切换时保存在栈上的上下文，与 switch.S 的保存顺序一致
+ * 只有被调用者保存的整数寄存器，其余寄存器由编译器在调用前保存，
+ * 被抢占任务的中断帧在它自己的栈上
+ */
+struct context_t {
+    /// 返回地址
+    uint64_t ra;
+    /// 新任务的入口
+    uint64_t s0;
+    /// 新任务的参数
+    uint64_t s1;
+    uint64_t s2_s11[10];
+    /// 保持 16 字节对齐
+    uint64_t pad;
+};
+
+/// 向量寄存器保存区的大小，支持 VLEN 不超过 512 位，更长时不启用向量扩展
+static constexpr const size_t FPU_VECTOR_SIZE  = 32 * 64;
+/// 无法区分浮点/向量指令导致的非法指令异常，需要在切换时立即恢复
+static constexpr const bool   FPU_LAZY_RESTORE = false;
+
+/**
+ * @brief 任务的浮点/向量状态
+ */
+struct fpu_state_t {
+    uint64_t f[32];
+    uint64_t fcsr;
+    uint64_t vstart;
+    uint64_t vl;
+    uint64_t vtype;
+    uint64_t vcsr;
+    /// v0~v31，每个 vlenb 字节
+    alignas(16) uint8_t v[FPU_VECTOR_SIZE];
+    /// 最近一次加载或保存所在的 cpu
+    size_t   cpu;
+    /// kernel_fpu_begin 的嵌套深度
+    uint32_t depth;
+};
+
+extern "C" {
+/**
+ * @brief 保存当前上下文，切换到 _next_sp 指向的上下文
+ * @param  _prev_sp                保存当前栈指针的位置
+ * @param  _next_sp                要切换到的栈指针
+ */
+void context_switch(uintptr_t* _prev_sp, uintptr_t _next_sp);
+
+/**
+ * @brief 新任务第一次被切换到时的入口，调用 _entry(_arg)
+ */
+void context_trampoline(void);
+}
+
+/**
+ * @brief 在新栈上构造初始上下文
+ * @param  _stack_top              栈顶，16 字节对齐
+ * @param  _entry                  入口，不能返回
+ * @param  _arg                    入口的参数
+ * @return uintptr_t               传给 context_switch 的栈指针
+ */
+static inline uintptr_t context_init(uint8_t* _stack_top,
+                                     void (*_entry)(void*), void* _arg) {
+    auto* ctx = reinterpret_cast<context_t*>(_stack_top) - 1;
+    __builtin_memset(ctx, 0, sizeof(context_t));
+    ctx->ra = reinterpret_cast<uint64_t>(context_trampoline);
+    ctx->s0 = reinterpret_cast<uint64_t>(_entry);
+    ctx->s1 = reinterpret_cast<uint64_t>(_arg);
+    return reinterpret_cast<uintptr_t>(ctx);
+}
+
+#endif /* CMAKE_KERNEL_CONTEXT_H */
@@ -0,0 +1,164 @@
+
+/**
+ * @file cpu.h
+ * @brief riscv64 cpu 相关操作
+ * @author Zone.N (Zone.Niuzh@hotmail.com)
+ * @version 1.0
+ * @date 2026-10-18
+ * @copyright MIT LICENSE
+ * https://github.com/MRNIU/cmake-kernel
+ * @par change log:
+ * <table>
+ * <tr><th>Date<th>Author<th>Description
+ * <tr><td>2026-10-18<td>Zone.N (Zone.Niuzh@hotmail.com)<td>创建文件
+ * </table>
+ */
+
+#ifndef CMAKE_KERNEL_CPU_H
+#define CMAKE_KERNEL_CPU_H
+
+#include "cstddef"
+#include "cstdint"
+
+/**
+ * @brief 自旋等待时提示 cpu 降低流水线与总线压力
+ * 使用 Zihintpause 的 pause，它被编码为 fence w,0，
+ * 不支持该扩展的 cpu 会将其当作空操作执行
+ */
+static inline void cpu_relax(void) {
+    __asm__ volatile(".insn i 0x0F, 0, x0, x0, 0x010" ::: "memory");
+    return;
+}
+
+/**
+ * @brief 等待 *_addr 不再等于 _old，允许提前返回，调用者需要重新检查
+ * 支持 Zawrs 时使用 lr.w 建立保留集，再用 wrs.nto 停顿到保留集失效，
+ * 否则退化为 pause
+ * @param  _addr                   要等待的地址
+ * @param  _old                    旧值
+ */
+static inline void cpu_wait_change(const uint32_t* _addr, uint32_t _old) {
+#ifdef __riscv_zawrs
+    uint32_t val;
+    __asm__ volatile("lr.w %0, (%1)" : "=r"(val) : "r"(_addr) : "memory");
+    if (val == _old) {
+        __asm__ volatile("wrs.nto" ::: "memory");
+    }
+#else
+    (void)_addr;
+    (void)_old;
+    cpu_relax();
+#endif
+    return;
+}
+
+/**
+ * @brief 设置当前 cpu 的 percpu 偏移，保存在 tp 中
+ * @param  _offset                 本 cpu 数据区相对模板的偏移
+ */
+static inline void cpu_set_percpu_offset(uintptr_t _offset) {
+    __asm__ volatile("mv tp, %0" : : "r"(_offset) : "memory");
+    return;
+}
+
+/**
+ * @brief 获取当前 cpu 的 percpu 偏移
+ * @return uintptr_t               tp 的值
+ */
+static inline uintptr_t cpu_percpu_offset(void) {
+    uintptr_t offset;
+    __asm__ volatile("mv %0, tp" : "=r"(offset));
+    return offset;
+}
+
+/**
+ * @brief 开中断
+ */
+static inline void cpu_irq_enable(void) {
+    __asm__ volatile("csrsi sstatus, 0x2" ::: "memory");
+    return;
+}
+
+/**
+ * @brief 关中断
+ */
+static inline void cpu_irq_disable(void) {
+    __asm__ volatile("csrci sstatus, 0x2" ::: "memory");
+    return;
+}
+
+/// sstatus 中断允许位
+static constexpr const uint64_t SSTATUS_SIE = 1 << 1;
+
+/**
+ * @brief 关中断并返回之前的状态
+ * @return uint64_t                之前的 sstatus.SIE
+ */
+static inline uint64_t cpu_irq_save(void) {
+    uint64_t flags;
+    __asm__ volatile("csrrci %0, sstatus, 0x2" : "=r"(flags) : : "memory");
+    return flags & SSTATUS_SIE;
+}
+
+/**
+ * @brief 恢复 cpu_irq_save 保存的中断状态
+ * @param  _flags                  cpu_irq_save 的返回值
+ */
+static inline void cpu_irq_restore(uint64_t _flags) {
+    __asm__ volatile("csrs sstatus, %0" : : "r"(_flags) : "memory");
+    return;
+}
+
+/**
+ * @brief 中断是否打开
+ * @return true                    打开
+ * @return false                   关闭
+ */
+static inline bool cpu_irq_enabled(void) {
+    uint64_t status;
+    __asm__ volatile("csrr %0, sstatus" : "=r"(status));
+    return (status & SSTATUS_SIE) != 0;
+}
+
+/**
+ * @brief 读取周期计数器，需要 m 态在 mcounteren 中允许访问
+ * @return uint64_t                周期数
+ */
+static inline uint64_t cpu_cycles(void) {
+    uint64_t cycles;
+    __asm__ volatile("rdcycle %0" : "=r"(cycles));
+    return cycles;
+}
+
+/**
+ * @brief 暂停执行直到有中断挂起，中断关闭时也会返回
+ */
+static inline void cpu_halt(void) {
+    __asm__ volatile("wfi" ::: "memory");
+    return;
+}
+
+/**
+ * @brief cpu_idle_wait 能否被写 _addr 唤醒，否则只能由中断唤醒
+ * @return true                    可以
+ * @return false                   不可以
+ */
+static inline bool cpu_idle_can_monitor(void) {
+    return false;
+}
+
+/**
+ * @brief 空闲等待，调用时中断关闭，返回时中断打开
+ * wfi 在中断关闭时也会被挂起的中断唤醒，之后打开中断处理它
+ * @param  _addr                   要监视的地址，不支持，只能由中断唤醒
+ * @param  _old                    旧值
+ */
+static inline void cpu_idle_wait(const uint32_t* _addr, uint32_t _old) {
+    (void)_addr;
+    (void)_old;
+    cpu_halt();
+    cpu_irq_enable();
+    return;
+}
+
+#endif /* CMAKE_KERNEL_CPU_H */
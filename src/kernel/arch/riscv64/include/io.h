@@ -0,0 +1,123 @@
+
+/**
+ * @file io.h
+ * @brief riscv64 设备寄存器访问
+ * @author Zone.N (Zone.Niuzh@hotmail.com)
+ * @version 1.0
+ * @date 2026-10-18
+ * @copyright MIT LICENSE
+ * https://github.com/MRNIU/cmake-kernel
+ * @par change log:
+ * <table>
+ * <tr><th>Date<th>Author<th>Description
+ * <tr><td>2026-10-18<td>Zone.N (Zone.Niuzh@hotmail.com)<td>创建文件
+ * </table>
+ */
+
+#ifndef CMAKE_KERNEL_IO_H
+#define CMAKE_KERNEL_IO_H
+
+#include "cstddef"
+#include "cstdint"
+
+// 设备寄存器访问。内核恒等映射物理地址，设备寄存器的物理地址可以直接访问。
+// mmio_write* 之前的内存写入对设备可见后才写寄存器，
+// mmio_read* 之后的内存读取不会早于寄存器读取，
+// 因此驱动先填写描述符再写门铃、先读状态再读完成项时不需要额外的屏障
+
+/**
+ * @brief 设备可见的内存之间的读屏障，用于先读完成标记再读完成项
+ */
+static inline void dma_rmb(void) {
+    __asm__ volatile("fence r, r" ::: "memory");
+    return;
+}
+
+/**
+ * @brief 设备可见的内存之间的写屏障，用于先写描述符再发布索引
+ */
+static inline void dma_wmb(void) {
+    __asm__ volatile("fence w, w" ::: "memory");
+    return;
+}
+
+/**
+ * @brief 内存写入与之后的内存读取之间的全屏障，
+ * 用于先发布索引再读设备写入的事件标记
+ */
+static inline void dma_mb(void) {
+    __asm__ volatile("fence rw, rw" ::: "memory");
+    return;
+}
+
+/// 寄存器读完成后才能读内存
+static inline void io_read_barrier(void) {
+    __asm__ volatile("fence i, r" ::: "memory");
+    return;
+}
+
+/// 之前的内存写入完成后才能写寄存器
+static inline void io_write_barrier(void) {
+    __asm__ volatile("fence w, o" ::: "memory");
+    return;
+}
+
+/**
+ * @brief 读设备寄存器
+ * @param  _addr                   寄存器地址
+ * @return uint8_t                 寄存器的值
+ */
+static inline uint8_t mmio_read8(const volatile void* _addr) {
+    auto val = *static_cast<const volatile uint8_t*>(_addr);
+    io_read_barrier();
+    return val;
+}
+
+static inline uint16_t mmio_read16(const volatile void* _addr) {
+    auto val = *static_cast<const volatile uint16_t*>(_addr);
+    io_read_barrier();
+    return val;
+}
+
+static inline uint32_t mmio_read32(const volatile void* _addr) {
+    auto val = *static_cast<const volatile uint32_t*>(_addr);
+    io_read_barrier();
+    return val;
+}
+
+static inline uint64_t mmio_read64(const volatile void* _addr) {
+    auto val = *static_cast<const volatile uint64_t*>(_addr);
+    io_read_barrier();
+    return val;
+}
+
+/**
+ * @brief 写设备寄存器
+ * @param  _addr                   寄存器地址
+ * @param  _val                    要写的值
+ */
+static inline void mmio_write8(volatile void* _addr, uint8_t _val) {
+    io_write_barrier();
+    *static_cast<volatile uint8_t*>(_addr) = _val;
+    return;
+}
+
+static inline void mmio_write16(volatile void* _addr, uint16_t _val) {
+    io_write_barrier();
+    *static_cast<volatile uint16_t*>(_addr) = _val;
+    return;
+}
+
+static inline void mmio_write32(volatile void* _addr, uint32_t _val) {
+    io_write_barrier();
+    *static_cast<volatile uint32_t*>(_addr) = _val;
+    return;
+}
+
+static inline void mmio_write64(volatile void* _addr, uint64_t _val) {
+    io_write_barrier();
+    *static_cast<volatile uint64_t*>(_addr) = _val;
+    return;
+}
+
+#endif /* CMAKE_KERNEL_IO_H */
@@ -0,0 +1,96 @@
+
+/**
+ * @file mmu.h
+ * @brief riscv64 地址转换与 tlb
+ * @author Zone.N (Zone.Niuzh@hotmail.com)
+ * @version 1.0
+ * @date 2026-10-18
+ * @copyright MIT LICENSE
+ * https://github.com/MRNIU/cmake-kernel
+ * @par change log:
+ * <table>
+ * <tr><th>Date<th>Author<th>Description
+ * <tr><td>2026-10-18<td>Zone.N (Zone.Niuzh@hotmail.com)<td>创建文件
+ * </table>
+ */
+
+#ifndef CMAKE_KERNEL_MMU_H
+#define CMAKE_KERNEL_MMU_H
+
+#include "cstddef"
+#include "cstdint"
+
+/// satp 中的 asid 字段
+static constexpr const uint32_t SATP_ASID_SHIFT = 44;
+static constexpr const uint64_t SATP_ASID_MASK  = 0xFFFFULL << SATP_ASID_SHIFT;
+/// satp 中的模式字段，0 为不转换
+static constexpr const uint32_t SATP_MODE_SHIFT = 60;
+
+static inline uint64_t mmu_read_satp(void) {
+    uint64_t satp;
+    __asm__ volatile("csrr %0, satp" : "=r"(satp));
+    return satp;
+}
+
+/**
+ * @brief 地址空间标签 (asid) 的位数
+ * 向 asid 字段写入全 1 后读回，实现的位数之外恒为 0
+ * @return uint32_t                位数，不转换或不支持时为 0
+ */
+static inline uint32_t mmu_asid_bits(void) {
+    auto satp = mmu_read_satp();
+    // Bare 模式下其它字段必须为 0
+    if ((satp >> SATP_MODE_SHIFT) == 0) {
+        return 0;
+    }
+    uint64_t probe;
+    __asm__ volatile("csrw satp, %1\n"
+                     "csrr %0, satp\n"
+                     "csrw satp, %2"
+                     : "=&r"(probe)
+                     : "r"(satp | SATP_ASID_MASK), "r"(satp)
+                     : "memory");
+    return __builtin_popcountll(probe & SATP_ASID_MASK);
+}
+
+/**
+ * @brief 读取当前页表
+ * @return uintptr_t               不含 asid 的 satp，包括模式与根页号
+ */
+static inline uintptr_t mmu_read_root(void) {
+    return mmu_read_satp() & ~SATP_ASID_MASK;
+}
+
+/**
+ * @brief 初始化当前 cpu，asid 不需要额外打开
+ * @param  _tagged                 是否启用标签
+ */
+static inline void mmu_cpu_init(bool _tagged) {
+    (void)_tagged;
+    return;
+}
+
+/**
+ * @brief 切换页表
+ * @param  _root                   mmu_read_root 格式的页表根
+ * @param  _asid                   标签，未启用时为 0
+ * @param  _flush                  是否丢弃该标签的 tlb，未启用标签时必须为 true
+ */
+static inline void mmu_switch(uintptr_t _root, uint32_t _asid, bool _flush) {
+    auto satp = _root | (static_cast<uint64_t>(_asid) << SATP_ASID_SHIFT);
+    __asm__ volatile("csrw satp, %0" : : "r"(satp) : "memory");
+    if (_flush) {
+        __asm__ volatile("sfence.vma x0, %0" : : "r"(_asid) : "memory");
+    }
+    return;
+}
+
+/**
+ * @brief 丢弃当前 cpu 所有标签的 tlb，包括全局页
+ */
+static inline void mmu_flush_all(void) {
+    __asm__ volatile("sfence.vma" : : : "memory");
+    return;
+}
+
+#endif /* CMAKE_KERNEL_MMU_H */
@@ -0,0 +1,53 @@
+
+/**
+ * @file sbi.h
+ * @brief riscv64 sbi 调用
+ * @author Zone.N (Zone.Niuzh@hotmail.com)
+ * @version 1.0
+ * @date 2026-10-18
+ * @copyright MIT LICENSE
+ * https://github.com/MRNIU/cmake-kernel
+ * @par change log:
+ * <table>
+ * <tr><th>Date<th>Author<th>Description
+ * <tr><td>2026-10-18<td>Zone.N (Zone.Niuzh@hotmail.com)<td>创建文件
+ * </table>
+ */
+
+#ifndef CMAKE_KERNEL_SBI_H
+#define CMAKE_KERNEL_SBI_H
+
+#include "cstdint"
+
+#include "sbi/sbi_ecall_interface.h"
+
+/**
+ * @brief sbi 调用的返回值
+ */
+struct sbiret_t {
+    /// 错误码
+    long error;
+    /// 返回值
+    long value;
+};
+
+extern "C" {
+/**
+ * @brief 调用 sbi
+ * @param  _arg0~_arg5             参数
+ * @param  _fid                    功能号
+ * @param  _eid                    扩展号
+ * @return sbiret_t                返回值
+ */
+sbiret_t ecall(unsigned long _arg0, unsigned long _arg1, unsigned long _arg2,
+               unsigned long _arg3, unsigned long _arg4, unsigned long _arg5,
+               int _fid, int _eid);
+
+/**
+ * @brief 输出一个字符
+ * @param  _c                      字符
+ */
+void     put_char(const char _c);
+}
+
+#endif /* CMAKE_KERNEL_SBI_H */
@@ -0,0 +1,95 @@
+
+/**
+ * @file trap.h
+ * @brief riscv64 中断帧
+ * @author Zone.N (Zone.Niuzh@hotmail.com)
+ * @version 1.0
+ * @date 2026-10-18
+ * @copyright MIT LICENSE
+ * https://github.com/MRNIU/cmake-kernel
+ * @par change log:
+ * <table>
+ * <tr><th>Date<th>Author<th>Description
+ * <tr><td>2026-10-18<td>Zone.N (Zone.Niuzh@hotmail.com)<td>创建文件
+ * </table>
+ */
+
+#ifndef CMAKE_KERNEL_TRAP_H
+#define CMAKE_KERNEL_TRAP_H
+
+#include "cstddef"
+#include "cstdint"
+
+/// 中断号 0~63 为 scause 中的中断编号，64 起为异常编号加 64
+static constexpr const size_t INTERRUPT_MAX            = 128;
+static constexpr const size_t INTERRUPT_EXCEPTION_BASE = 64;
+/// s 态软件中断
+static constexpr const size_t INTERRUPT_S_SOFTWARE     = 1;
+/// s 态时钟中断
+static constexpr const size_t INTERRUPT_S_TIMER        = 5;
+/// s 态外部中断
+static constexpr const size_t INTERRUPT_S_EXTERNAL     = 9;
+/// stvec 向量模式下的向量数，超过的中断编号从 0 号入口进入
+static constexpr const size_t INTERRUPT_VECTOR_N       = 16;
+/// 时钟中断
+static constexpr const size_t INTERRUPT_TIMER          = INTERRUPT_S_TIMER;
+/// 处理器间中断，由 sbi 设置 sip.SSIP
+static constexpr const size_t INTERRUPT_IPI            = INTERRUPT_S_SOFTWARE;
+/// 用于测量进出中断开销的中断号
+static constexpr const size_t INTERRUPT_BENCH          = INTERRUPT_S_SOFTWARE;
+
+/// sip/sie 中 s 态软件中断位
+static constexpr const uint64_t SIP_SSIP = 1 << INTERRUPT_S_SOFTWARE;
+
+/**
+ * @brief 中断帧，与 trap.S 的保存顺序一致
+ * 入口只保存调用者保存的寄存器，被调用者保存的寄存器由 C 代码自己维护
+ */
+struct trap_frame_t {
+    uint64_t ra;
+    uint64_t t0;
+    uint64_t t1;
+    uint64_t t2;
+    uint64_t a0;
+    uint64_t a1;
+    uint64_t a2;
+    uint64_t a3;
+    uint64_t a4;
+    uint64_t a5;
+    uint64_t a6;
+    uint64_t a7;
+    uint64_t t3;
+    uint64_t t4;
+    uint64_t t5;
+    uint64_t t6;
+    uint64_t sepc;
+    uint64_t sstatus;
+};
+
+/**
+ * @brief 被中断的上下文是否允许中断
+ * @param  _frame                  中断帧
+ * @return true                    sstatus.SPIE 为 1
+ * @return false                   sstatus.SPIE 为 0
+ */
+static inline bool trap_irq_enabled(const trap_frame_t* _frame) {
+    return (_frame->sstatus & (1 << 5)) != 0;
+}
+
+/**
+ * @brief 触发 INTERRUPT_BENCH 号中断，需要打开 sie.SSIE
+ */
+static inline void trap_raise_bench(void) {
+    __asm__ volatile("csrs sip, %0" : : "r"(SIP_SSIP) : "memory");
+    return;
+}
+
+/**
+ * @brief 结束 INTERRUPT_BENCH 号中断
+ */
+static inline void trap_ack_bench(void) {
+    __asm__ volatile("csrc sip, %0" : : "r"(SIP_SSIP) : "memory");
+    return;
+}
+
+#endif /* CMAKE_KERNEL_TRAP_H */
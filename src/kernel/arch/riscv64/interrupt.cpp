@@ -0,0 +1,52 @@
+
+/**
+ * @file interrupt.cpp
+ * @brief riscv64 中断初始化
+ * @author Zone.N (Zone.Niuzh@hotmail.com)
+ * @version 1.0
+ * @date 2026-10-18
+ * @copyright MIT LICENSE
+ * https://github.com/MRNIU/cmake-kernel
+ * @par change log:
+ * <table>
+ * <tr><th>Date<th>Author<th>Description
+ * <tr><td>2026-10-18<td>Zone.N (Zone.Niuzh@hotmail.com)<td>创建文件
+ * </table>
+ */
+
+#include "cpu.h"
+#include "interrupt.h"
+
+/// 向量表，位于 trap.S
+extern "C" uint8_t trap_vector[];
+
+/// stvec 向量模式
+static constexpr const uint64_t STVEC_MODE_VECTORED = 1;
+
+void interrupt_arch_init(void) {
+    return;
+}
+
+void interrupt_arch_cpu_init(void) {
+    auto stvec = reinterpret_cast<uint64_t>(trap_vector) | STVEC_MODE_VECTORED;
+    __asm__ volatile("csrw stvec, %0" : : "r"(stvec) : "memory");
+    // 软件中断用于处理器间中断，时钟与外部中断由对应驱动打开
+    __asm__ volatile("csrw sie, %0" : : "r"(SIP_SSIP) : "memory");
+    return;
+}
+
+void interrupt_arch_default(size_t _no, trap_frame_t* _frame) {
+    (void)_frame;
+    // 未处理的异常无法恢复，停机
+    /// @todo 输出异常信息
+    if (_no >= INTERRUPT_EXCEPTION_BASE) {
+        cpu_irq_disable();
+        while (1) {
+            cpu_halt();
+        }
+    }
+    // 屏蔽没有处理函数的中断，避免反复进入
+    uint64_t mask = static_cast<uint64_t>(1) << _no;
+    __asm__ volatile("csrc sie, %0" : : "r"(mask) : "memory");
+    return;
+}
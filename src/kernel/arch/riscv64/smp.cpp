@@ -0,0 +1,102 @@
+
+/**
+ * @file smp.cpp
+ * @brief riscv64 多核启动
+ * @author Zone.N (Zone.Niuzh@hotmail.com)
+ * @version 1.0
+ * @date 2026-10-18
+ * @copyright MIT LICENSE
+ * https://github.com/MRNIU/cmake-kernel
+ * @par change log:
+ * <table>
+ * <tr><th>Date<th>Author<th>Description
+ * <tr><td>2026-10-18<td>Zone.N (Zone.Niuzh@hotmail.com)<td>创建文件
+ * </table>
+ */
+
+#include "smp.h"
+#include "clock.h"
+#include "cpu.h"
+#include "percpu.h"
+#include "sbi.h"
+#include "trap.h"
+
+/// 探测的 hartid 上限
+/// @todo 从设备树获取 hart 列表
+static constexpr const size_t   HARTID_LIMIT   = 64;
+/// 不对应任何 hart 的编号，超时未上线的 cpu 的 hartid 设为该值
+static constexpr const size_t   HARTID_INVALID = ~static_cast<size_t>(0);
+/// 等待 hart 上线的最长时间，单位为微秒
+static constexpr const uint64_t HART_WAIT_US   = 100 * 1000;
+
+/// 其它 hart 的入口，位于 boot.S
+extern "C" void _secondary_start(void);
+
+extern "C" [[noreturn]] void riscv_ap_main(size_t _hartid) {
+    // 启动 hart 在 sbi_hart_start 之前已经记录了 hartid 对应的编号
+    for (size_t cpu = 1; cpu < MAX_CPU_COUNT; cpu++) {
+        if (__atomic_load_n(per_cpu_ptr(&cpu_hartid, cpu), __ATOMIC_ACQUIRE)
+            == _hartid) {
+            smp_ap_main(cpu, _hartid);
+        }
+    }
+    // 不是本内核启动的 hart，停在这里
+    cpu_irq_disable();
+    while (1) {
+        cpu_halt();
+    }
+}
+
+size_t smp_arch_boot(void) {
+    auto   boot_hartid = this_cpu_read(cpu_hartid);
+    size_t started     = 0;
+    // 依次发出启动请求，不等待单个 hart 上线，所有 hart 并行初始化
+    for (size_t hartid = 0;
+         (hartid < HARTID_LIMIT) && (started + 1 < MAX_CPU_COUNT); hartid++) {
+        if (hartid == boot_hartid) {
+            continue;
+        }
+        auto status = ecall(hartid, 0, 0, 0, 0, 0, SBI_EXT_HSM_HART_GET_STATUS,
+                            SBI_EXT_HSM);
+        if ((status.error != SBI_SUCCESS)
+            || (status.value != SBI_HSM_STATE_STOPPED)) {
+            continue;
+        }
+        auto cpu = started + 1;
+        __atomic_store_n(per_cpu_ptr(&cpu_hartid, cpu), hartid,
+                         __ATOMIC_RELEASE);
+        auto ret = ecall(hartid, reinterpret_cast<uintptr_t>(_secondary_start),
+                         reinterpret_cast<uintptr_t>(cpu_stacks[cpu])
+                           + CPU_STACK_SIZE,
+                         0, 0, 0, SBI_EXT_HSM_HART_START, SBI_EXT_HSM);
+        // 失败时该编号留给下一个 hart
+        if (ret.error == SBI_SUCCESS) {
+            started++;
+        }
+    }
+    // 等待 hart 上线，超时后以实际上线的数量为准
+    auto deadline
+      = clock_arch_read() + clock_arch_freq() * HART_WAIT_US / 1000000;
+    while ((smp_cpu_count() < started + 1) && (clock_arch_read() < deadline)) {
+        cpu_relax();
+    }
+    // 之后才运行到 riscv_ap_main 的 hart 找不到编号，停在那里
+    for (size_t cpu = 1; cpu <= started; cpu++) {
+        if (!smp_cpu_is_online(cpu)) {
+            __atomic_store_n(per_cpu_ptr(&cpu_hartid, cpu), HARTID_INVALID,
+                             __ATOMIC_RELEASE);
+        }
+    }
+    return smp_cpu_count() - 1;
+}
+
+void smp_arch_send_ipi(size_t _hartid) {
+    // hart_mask 为 1，hart_mask_base 为目标 hartid
+    ecall(1, _hartid, 0, 0, 0, 0, SBI_EXT_IPI_SEND_IPI, SBI_EXT_IPI);
+    return;
+}
+
+void smp_arch_ipi_ack(void) {
+    __asm__ volatile("csrc sip, %0" : : "r"(SIP_SSIP) : "memory");
+    return;
+}
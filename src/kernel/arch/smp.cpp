@@ -0,0 +1,77 @@
+
+/**
+ * @file smp.cpp
+ * @brief 多核启动
+ * @author Zone.N (Zone.Niuzh@hotmail.com)
+ * @version 1.0
+ * @date 2026-10-18
+ * @copyright MIT LICENSE
+ * https://github.com/MRNIU/cmake-kernel
+ * @par change log:
+ * <table>
+ * <tr><th>Date<th>Author<th>Description
+ * <tr><td>2026-10-18<td>Zone.N (Zone.Niuzh@hotmail.com)<td>创建文件
+ * </table>
+ */
+
+#include "smp.h"
+#include "cpu.h"
+#include "fpu.h"
+#include "interrupt.h"
+#include "kernel.h"
+#include "percpu.h"
+
+static_assert(MAX_CPU_COUNT <= 64, "cpu mask is 64 bits");
+
+alignas(16) uint8_t cpu_stacks[MAX_CPU_COUNT][CPU_STACK_SIZE];
+
+/// 在线 cpu 掩码，启动 cpu 为 0 号
+static uint64_t cpu_online_mask  = 1;
+/// 在线 cpu 数
+static size_t   cpu_online_count = 1;
+
+/**
+ * @brief 处理器间中断，只用于唤醒，被唤醒的 cpu 自行检查要做的工作
+ */
+static void ipi_handler(size_t _no, trap_frame_t* _frame) {
+    (void)_no;
+    (void)_frame;
+    smp_arch_ipi_ack();
+    return;
+}
+
+void smp_init(void) {
+    register_interrupt_handler(INTERRUPT_IPI, ipi_handler);
+    smp_arch_boot();
+    return;
+}
+
+void smp_ap_main(size_t _cpu, size_t _hartid) {
+    percpu_cpu_init(_cpu);
+    this_cpu_write(cpu_hartid, _hartid);
+    interrupt_cpu_init();
+    fpu_cpu_init();
+    __atomic_fetch_or(&cpu_online_mask, static_cast<uint64_t>(1) << _cpu,
+                      __ATOMIC_RELEASE);
+    __atomic_fetch_add(&cpu_online_count, 1, __ATOMIC_RELEASE);
+    secondary_main();
+    cpu_irq_disable();
+    while (1) {
+        cpu_halt();
+    }
+}
+
+void smp_send_ipi(size_t _cpu) {
+    smp_arch_send_ipi(*per_cpu_ptr(&cpu_hartid, _cpu));
+    return;
+}
+
+size_t smp_cpu_count(void) {
+    return __atomic_load_n(&cpu_online_count, __ATOMIC_ACQUIRE);
+}
+
+bool smp_cpu_is_online(size_t _cpu) {
+    return (__atomic_load_n(&cpu_online_mask, __ATOMIC_ACQUIRE)
+            & (static_cast<uint64_t>(1) << _cpu))
+           != 0;
+}
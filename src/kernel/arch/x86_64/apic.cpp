@@ -0,0 +1,75 @@
+
+/**
+ * @file apic.cpp
+ * @brief x86_64 local apic
+ * @author Zone.N (Zone.Niuzh@hotmail.com)
+ * @version 1.0
+ * @date 2026-10-18
+ * @copyright MIT LICENSE
+ * https://github.com/MRNIU/cmake-kernel
+ * @par change log:
+ * <table>
+ * <tr><th>Date<th>Author<th>Description
+ * <tr><td>2026-10-18<td>Zone.N (Zone.Niuzh@hotmail.com)<td>创建文件
+ * </table>
+ */
+
+#include "apic.h"
+#include "cpu.h"
+#include "trap.h"
+
+/// x2apic msr 基址
+static constexpr const uint32_t MSR_X2APIC_BASE = 0x800;
+
+/// 是否为 x2apic 模式，由固件决定，所有 cpu 相同
+static bool      x2apic;
+/// xapic 模式下的 mmio 基址，假设已经恒等映射
+static uintptr_t apic_mmio;
+
+void apic_init(void) {
+    auto base = cpu_read_msr(MSR_APIC_BASE);
+    x2apic    = (base & APIC_BASE_X2APIC) != 0;
+    apic_mmio = base & APIC_BASE_MASK;
+    return;
+}
+
+void apic_cpu_init(void) {
+    apic_write(APIC_REG_SVR, APIC_SVR_ENABLE | INTERRUPT_SPURIOUS);
+    return;
+}
+
+uint32_t apic_read(uint32_t _reg) {
+    if (x2apic) {
+        return cpu_read_msr(MSR_X2APIC_BASE + (_reg >> 4));
+    }
+    return *reinterpret_cast<volatile uint32_t*>(apic_mmio + _reg);
+}
+
+void apic_write(uint32_t _reg, uint32_t _val) {
+    if (x2apic) {
+        cpu_write_msr(MSR_X2APIC_BASE + (_reg >> 4), _val);
+        return;
+    }
+    *reinterpret_cast<volatile uint32_t*>(apic_mmio + _reg) = _val;
+    return;
+}
+
+void apic_eoi(void) {
+    apic_write(APIC_REG_EOI, 0);
+    return;
+}
+
+void apic_send_ipi(uint32_t _dest, uint32_t _icr) {
+    // x2apic 的 icr 是一个 64 位 msr，高 32 位为目标
+    if (x2apic) {
+        cpu_write_msr(MSR_X2APIC_BASE + (APIC_REG_ICR_LOW >> 4),
+                      (static_cast<uint64_t>(_dest) << 32) | _icr);
+        return;
+    }
+    apic_write(APIC_REG_ICR_HIGH, _dest << 24);
+    apic_write(APIC_REG_ICR_LOW, _icr);
+    while ((apic_read(APIC_REG_ICR_LOW) & APIC_ICR_PENDING) != 0) {
+        cpu_relax();
+    }
+    return;
+}
@@ -15,15 +15,109 @@
  */
 
 #include "arch.h"
+#include "fpu.h"
+#include "cpu.h"
+#include "interrupt.h"
+#include "libc.h"
+#include "percpu.h"
 
-int32_t arch(uint32_t _argc, uint8_t** _argv) {
-    (void)_argc;
-    (void)_argv;
+bool cpu_mwait_supported = false;
+
+/// RSDP 的签名，位于 16 字节边界
+static constexpr const char      RSDP_SIGNATURE[] = "RSD PTR ";
+/// ACPI 1.0 的 RSDP 长度，校验和覆盖这些字节
+static constexpr const size_t    RSDP_V1_SIZE     = 20;
+/// bios 数据区中保存 ebda 段地址的位置
+static constexpr const uintptr_t BDA_EBDA_SEGMENT = 0x40E;
+/// bios 只读区
+static constexpr const uintptr_t BIOS_ROM_START   = 0xE0000;
+static constexpr const uintptr_t BIOS_ROM_END     = 0x100000;
+
+/// 加载器传入的 initramfs 的范围
+static const uint8_t* initrd_start;
+static const uint8_t* initrd_end;
+
+/// 加载器从 uefi 配置表中取得的 RSDP，没有时为 0
+static uintptr_t loader_rsdp;
 
-    // 进入死循环
-    while (1) {
-        ;
+/// 加载器为 ap 启动代码保留的低端内存，没有保留时为 0，由 smp.cpp 使用
+uintptr_t ap_trampoline_reserved = 0;
+
+int32_t arch(uint32_t _argc, uint8_t** _argv) {
+    // 加载器以 argv[0] 与 argv[1] 传入 initramfs 的起始与结束地址
+    if ((_argc >= 2) && (_argv != nullptr) && (_argv[1] > _argv[0])) {
+        initrd_start = _argv[0];
+        initrd_end   = _argv[1];
+    }
+    // argv[2] 为已保留的 ap 启动代码内存
+    if ((_argc >= 3) && (_argv != nullptr)) {
+        ap_trampoline_reserved = reinterpret_cast<uintptr_t>(_argv[2]);
     }
+    // argv[3] 为 RSDP
+    if ((_argc >= 4) && (_argv != nullptr)) {
+        loader_rsdp = reinterpret_cast<uintptr_t>(_argv[3]);
+    }
+
+    // 检测 monitor/mwait，虚拟机中通常不提供
+    cpu_mwait_supported = (cpu_cpuid(1, 0).ecx & (1 << 3)) != 0;
+
+    // 初始化每个 cpu 的数据
+    percpu_init(cpu_apic_id());
+
+    // 初始化中断，此时中断仍然是关闭的
+    interrupt_init();
+
+    // 禁止访问浮点/向量寄存器，只在 kernel_fpu_begin/end 之间使用
+    fpu_init();
+
+    return 0;
+}
 
+/**
+ * @brief 在 [_start, _end) 中按 16 字节边界查找 RSDP
+ * @return uintptr_t               RSDP 的地址，没有时为 0
+ */
+static uintptr_t rsdp_scan(uintptr_t _start, uintptr_t _end) {
+    for (auto addr = _start; addr + RSDP_V1_SIZE <= _end; addr += 16) {
+        auto* ptr = reinterpret_cast<const uint8_t*>(addr);
+        if (memcmp(ptr, RSDP_SIGNATURE, sizeof(RSDP_SIGNATURE) - 1) != 0) {
+            continue;
+        }
+        uint8_t sum = 0;
+        for (size_t i = 0; i < RSDP_V1_SIZE; i++) {
+            sum += ptr[i];
+        }
+        if (sum == 0) {
+            return addr;
+        }
+    }
     return 0;
 }
+
+const void* arch_fdt(void) {
+    return nullptr;
+}
+
+uintptr_t arch_acpi_rsdp(void) {
+    // uefi 启动时 RSDP 只在 uefi 配置表中，由加载器传入
+    if (loader_rsdp != 0) {
+        return loader_rsdp;
+    }
+    // 传统 bios: ebda 的前 1KB，之后是 bios 只读区。
+    // 指向固定低地址的指针会被编译器视为越界访问，经 asm 隐藏其来源
+    auto* bda = reinterpret_cast<const volatile uint16_t*>(BDA_EBDA_SEGMENT);
+    __asm__("" : "+r"(bda));
+    auto ebda = static_cast<uintptr_t>(*bda) << 4;
+    if (ebda != 0) {
+        auto rsdp = rsdp_scan(ebda, ebda + 1024);
+        if (rsdp != 0) {
+            return rsdp;
+        }
+    }
+    return rsdp_scan(BIOS_ROM_START, BIOS_ROM_END);
+}
+
+const void* arch_initrd(size_t* _size) {
+    *_size = static_cast<size_t>(initrd_end - initrd_start);
+    return initrd_start;
+}
@@ -0,0 +1,212 @@
+
+/**
+ * @file clock.cpp
+ * @brief x86_64 时钟
+ * @author Zone.N (Zone.Niuzh@hotmail.com)
+ * @version 1.0
+ * @date 2026-10-18
+ * @copyright MIT LICENSE
+ * https://github.com/MRNIU/cmake-kernel
+ * @par change log:
+ * <table>
+ * <tr><th>Date<th>Author<th>Description
+ * <tr><td>2026-10-18<td>Zone.N (Zone.Niuzh@hotmail.com)<td>创建文件
+ * </table>
+ */
+
+#include "clock.h"
+#include "acpi.h"
+#include "apic.h"
+#include "arch.h"
+#include "cpu.h"
+#include "io.h"
+#include "libc.h"
+#include "pit.h"
+#include "trap.h"
+
+/// tsc 截止时间寄存器
+static constexpr const uint32_t MSR_TSC_DEADLINE       = 0x6E0;
+/// lvt 定时器模式，0 为单次
+static constexpr const uint32_t LVT_TIMER_TSC_DEADLINE = 2 << 17;
+static constexpr const uint32_t LVT_MASKED             = 1 << 16;
+/// apic 定时器 16 分频
+static constexpr const uint32_t APIC_TIMER_DIV_16      = 0x3;
+/// 校准时长，单位为微秒
+static constexpr const uint64_t CALIBRATE_US           = 10 * 1000;
+/// cpuid 0x80000007 edx[8]，tsc 频率恒定且不随 c 状态停止
+static constexpr const uint32_t CPUID_INVARIANT_TSC    = 1 << 8;
+/// hpet 寄存器
+static constexpr const uint64_t HPET_REG_CAP           = 0x000;
+static constexpr const uint64_t HPET_REG_CONFIG        = 0x010;
+static constexpr const uint64_t HPET_REG_COUNTER       = 0x0F0;
+/// 主计数器为 64 位
+static constexpr const uint64_t HPET_CAP_COUNTER_64    = 1 << 13;
+static constexpr const uint64_t HPET_CONFIG_ENABLE     = 1 << 0;
+/// HPET 表中基址 (通用地址结构的地址字段) 的偏移
+static constexpr const size_t   HPET_TABLE_BASE        = 44;
+/// 飞秒
+static constexpr const uint64_t FSEC_PER_SEC           = 1000000000000000;
+
+/// 计数器频率
+static uint64_t          clock_freq;
+/// 使用 hpet 作为计数器时为其寄存器基址，否则为 nullptr
+static volatile uint8_t* hpet_regs;
+/// 是否支持 tsc 截止时间模式
+static bool              tsc_deadline;
+/// 不使用 tsc 截止时间模式时，apic 定时器频率
+static uint64_t          apic_freq;
+
+/**
+ * @brief 由 cpuid 获取 tsc 频率
+ * @return uint64_t                Hz，不支持时返回 0
+ */
+static uint64_t tsc_freq_cpuid(void) {
+    if (cpu_cpuid(0, 0).eax < 0x15) {
+        return 0;
+    }
+    // tsc 频率 = 晶振频率 * ebx / eax
+    auto leaf = cpu_cpuid(0x15, 0);
+    if ((leaf.eax == 0) || (leaf.ebx == 0) || (leaf.ecx == 0)) {
+        return 0;
+    }
+    return static_cast<uint64_t>(leaf.ecx) * leaf.ebx / leaf.eax;
+}
+
+/**
+ * @brief tsc 是否恒定
+ * 不恒定的 tsc 会随频率变化或在深度睡眠时停止，不能作为计数器
+ * @return true                    恒定
+ * @return false                   不恒定或无法确定
+ */
+static bool tsc_invariant(void) {
+    if (cpu_cpuid(0x80000000, 0).eax < 0x80000007) {
+        return false;
+    }
+    return (cpu_cpuid(0x80000007, 0).edx & CPUID_INVARIANT_TSC) != 0;
+}
+
+/**
+ * @brief 查找并打开 hpet
+ * @return uint64_t                hpet 频率，没有可用的 64 位 hpet 时返回 0
+ */
+static uint64_t hpet_init(void) {
+    if (!acpi_init(arch_acpi_rsdp())) {
+        return 0;
+    }
+    auto* table = acpi_find_table("HPET", 0);
+    if ((table == nullptr) || (table->length < HPET_TABLE_BASE + 8)) {
+        return 0;
+    }
+    uint64_t base = 0;
+    memcpy(&base, reinterpret_cast<const uint8_t*>(table) + HPET_TABLE_BASE,
+           sizeof(base));
+    // hpet 寄存器假设已经恒等映射
+    auto* regs   = reinterpret_cast<volatile uint8_t*>(base);
+    auto  cap    = mmio_read64(regs + HPET_REG_CAP);
+    // 高 32 位为计数周期，单位为飞秒
+    auto  period = cap >> 32;
+    // 32 位计数器很快回绕，不能作为单调计数器
+    if ((base == 0) || (period == 0) || ((cap & HPET_CAP_COUNTER_64) == 0)) {
+        return 0;
+    }
+    mmio_write64(regs + HPET_REG_CONFIG,
+                 mmio_read64(regs + HPET_REG_CONFIG) | HPET_CONFIG_ENABLE);
+    hpet_regs = regs;
+    return FSEC_PER_SEC / period;
+}
+
+void clock_arch_init(void) {
+    if (!tsc_invariant()) {
+        clock_freq = hpet_init();
+    }
+    // 没有可用的 hpet 时只能使用不恒定的 tsc，节能状态下时间可能不准确
+    if (clock_freq == 0) {
+        clock_freq = tsc_freq_cpuid();
+        if (clock_freq == 0) {
+            auto start = cpu_cycles();
+            pit_udelay(CALIBRATE_US);
+            clock_freq = (cpu_cycles() - start) * (1000000 / CALIBRATE_US);
+        }
+    }
+    // 截止时间以 tsc 计数，计数器为 hpet 时不能使用
+    tsc_deadline = (hpet_regs == nullptr)
+                   && ((cpu_cpuid(1, 0).ecx & (1 << 24)) != 0);
+    if (!tsc_deadline) {
+        // 校准 apic 定时器
+        apic_write(APIC_REG_TIMER_DIV, APIC_TIMER_DIV_16);
+        apic_write(APIC_REG_LVT_TIMER, LVT_MASKED | INTERRUPT_TIMER);
+        apic_write(APIC_REG_TIMER_INIT, 0xFFFFFFFF);
+        pit_udelay(CALIBRATE_US);
+        auto ticks = 0xFFFFFFFF - apic_read(APIC_REG_TIMER_CUR);
+        apic_write(APIC_REG_TIMER_INIT, 0);
+        apic_freq = ticks * (1000000 / CALIBRATE_US);
+        if (apic_freq == 0) {
+            apic_freq = 1;
+        }
+    }
+    return;
+}
+
+void clock_arch_cpu_init(void) {
+    if (tsc_deadline) {
+        apic_write(APIC_REG_LVT_TIMER,
+                   LVT_TIMER_TSC_DEADLINE | INTERRUPT_TIMER);
+        // 写 lvt 与写截止时间之间需要串行化
+        __asm__ volatile("mfence" ::: "memory");
+    }
+    else {
+        apic_write(APIC_REG_TIMER_DIV, APIC_TIMER_DIV_16);
+        apic_write(APIC_REG_LVT_TIMER, INTERRUPT_TIMER);
+    }
+    return;
+}
+
+uint64_t clock_arch_read(void) {
+    if (hpet_regs != nullptr) {
+        return mmio_read64(hpet_regs + HPET_REG_COUNTER);
+    }
+    return cpu_cycles();
+}
+
+uint64_t clock_arch_freq(void) {
+    return clock_freq;
+}
+
+void clock_arch_set_event(uint64_t _deadline) {
+    if (tsc_deadline) {
+        // 截止时间已过去时写入后立即产生中断
+        cpu_write_msr(MSR_TSC_DEADLINE, _deadline);
+        return;
+    }
+    auto now   = clock_arch_read();
+    auto delta = _deadline > now ? _deadline - now : 0;
+    // 超出范围时提前产生中断，由时钟中断处理重新设置。
+    // 先限制为 1 秒，避免乘法溢出
+    if (delta > clock_freq) {
+        delta = clock_freq;
+    }
+    auto count = delta * apic_freq / clock_freq;
+    if (count > 0xFFFFFFFF) {
+        count = 0xFFFFFFFF;
+    }
+    else if (count == 0) {
+        count = 1;
+    }
+    apic_write(APIC_REG_TIMER_INIT, count);
+    return;
+}
+
+void clock_arch_stop_event(void) {
+    if (tsc_deadline) {
+        cpu_write_msr(MSR_TSC_DEADLINE, 0);
+    }
+    else {
+        apic_write(APIC_REG_TIMER_INIT, 0);
+    }
+    return;
+}
+
+void clock_arch_ack(void) {
+    apic_eoi();
+    return;
+}
@@ -0,0 +1,205 @@
+
+/**
+ * @file fpu.cpp
+ * @brief x86_64 浮点/向量状态
+ * @author Zone.N (Zone.Niuzh@hotmail.com)
+ * @version 1.0
+ * @date 2026-10-18
+ * @copyright MIT LICENSE
+ * https://github.com/MRNIU/cmake-kernel
+ * @par change log:
+ * <table>
+ * <tr><th>Date<th>Author<th>Description
+ * <tr><td>2026-10-18<td>Zone.N (Zone.Niuzh@hotmail.com)<td>创建文件
+ * </table>
+ */
+
+#include "cpu.h"
+#include "fpu.h"
+#include "interrupt.h"
+
+// 通过 cr0.TS 禁止访问，使用时产生 #NM。
+// 优先使用 xsaves，其次 xsaveopt，二者都只保存修改过且不处于初始状态的部分；
+// 不支持 xsave 时使用 fxsave，只有 x87 与 sse 状态
+
+/// 保存方式
+static constexpr const uint32_t FPU_MODE_FXSAVE   = 0;
+static constexpr const uint32_t FPU_MODE_XSAVE    = 1;
+static constexpr const uint32_t FPU_MODE_XSAVEOPT = 2;
+static constexpr const uint32_t FPU_MODE_XSAVES   = 3;
+
+static constexpr const uint64_t CR0_MP            = 1 << 1;
+static constexpr const uint64_t CR0_EM            = 1 << 2;
+static constexpr const uint64_t CR0_TS            = 1 << 3;
+static constexpr const uint64_t CR0_NE            = 1 << 5;
+static constexpr const uint64_t CR4_OSFXSR        = 1 << 9;
+static constexpr const uint64_t CR4_OSXMMEXCPT    = 1 << 10;
+static constexpr const uint64_t CR4_OSXSAVE       = 1 << 18;
+
+/// xsave 管理的状态: x87、sse、avx
+static constexpr const uint64_t XFEATURE_BASE     = 0x7;
+/// avx-512: opmask、zmm_hi256、hi16_zmm
+static constexpr const uint64_t XFEATURE_AVX512   = 0xE0;
+/// 管理者模式状态，不使用
+static constexpr const uint32_t MSR_IA32_XSS      = 0xDA0;
+
+/// xsave 区中 mxcsr 与 xsave 头的偏移
+static constexpr const size_t   FXSAVE_FCW        = 0;
+static constexpr const size_t   FXSAVE_MXCSR      = 24;
+static constexpr const size_t   XSAVE_XCOMP_BV    = 520;
+/// x87 与 mxcsr 的初始值
+static constexpr const uint16_t FCW_DEFAULT       = 0x037F;
+static constexpr const uint32_t MXCSR_DEFAULT     = 0x1F80;
+
+static uint32_t fpu_mode      = FPU_MODE_FXSAVE;
+/// 写入 xcr0 的状态
+static uint64_t fpu_xfeatures = 0;
+/// 初始状态，xsave 头中的 XSTATE_BV 为 0，恢复时所有部分回到初始值
+alignas(64) static uint8_t fpu_init_area[FPU_AREA_SIZE];
+
+static inline void xsetbv(uint32_t _index, uint64_t _val) {
+    __asm__ volatile("xsetbv"
+                     :
+                     : "c"(_index), "a"(static_cast<uint32_t>(_val)),
+                       "d"(static_cast<uint32_t>(_val >> 32))
+                     : "memory");
+    return;
+}
+
+/**
+ * @brief 当前设置下 xsave 区需要的大小
+ */
+static size_t xsave_size(void) {
+    if (fpu_mode == FPU_MODE_XSAVES) {
+        return cpu_cpuid(0xD, 1).ebx;
+    }
+    return cpu_cpuid(0xD, 0).ebx;
+}
+
+/**
+ * @brief #NM，在 SIMD 段中被切换出去的任务再次使用寄存器
+ */
+static void fpu_trap_handler(size_t _no, trap_frame_t* _frame) {
+    if (!fpu_fault()) {
+        interrupt_arch_default(_no, _frame);
+    }
+    return;
+}
+
+void fpu_arch_init(void) {
+    if ((cpu_cpuid(1, 0).ecx & (1 << 26)) != 0) {
+        auto leaf  = cpu_cpuid(0xD, 0);
+        auto sub   = cpu_cpuid(0xD, 1);
+        auto xcr0  = (static_cast<uint64_t>(leaf.edx) << 32) | leaf.eax;
+        // avx-512 的三个部分需要同时启用
+        auto mask  = XFEATURE_BASE;
+        if ((xcr0 & XFEATURE_AVX512) == XFEATURE_AVX512) {
+            mask |= XFEATURE_AVX512;
+        }
+        fpu_xfeatures = xcr0 & mask;
+        fpu_mode      = (sub.eax & (1 << 3)) != 0 ? FPU_MODE_XSAVES
+                        : (sub.eax & (1 << 0)) != 0 ? FPU_MODE_XSAVEOPT
+                                                    : FPU_MODE_XSAVE;
+        fpu_arch_cpu_init();
+        if (xsave_size() > FPU_AREA_SIZE) {
+            fpu_xfeatures &= ~XFEATURE_AVX512;
+            fpu_arch_cpu_init();
+        }
+    }
+    *reinterpret_cast<uint16_t*>(fpu_init_area + FXSAVE_FCW)   = FCW_DEFAULT;
+    *reinterpret_cast<uint32_t*>(fpu_init_area + FXSAVE_MXCSR) = MXCSR_DEFAULT;
+    // xrstors 只接受压缩格式
+    if (fpu_mode == FPU_MODE_XSAVES) {
+        *reinterpret_cast<uint64_t*>(fpu_init_area + XSAVE_XCOMP_BV)
+            = (static_cast<uint64_t>(1) << 63) | fpu_xfeatures;
+    }
+    register_interrupt_handler(INTERRUPT_FPU_TRAP, fpu_trap_handler);
+    return;
+}
+
+void fpu_arch_cpu_init(void) {
+    auto cr4 = cpu_read_cr4() | CR4_OSFXSR | CR4_OSXMMEXCPT;
+    if (fpu_mode != FPU_MODE_FXSAVE) {
+        cr4 |= CR4_OSXSAVE;
+    }
+    cpu_write_cr4(cr4);
+    if (fpu_mode != FPU_MODE_FXSAVE) {
+        xsetbv(0, fpu_xfeatures);
+    }
+    if (fpu_mode == FPU_MODE_XSAVES) {
+        cpu_write_msr(MSR_IA32_XSS, 0);
+    }
+    cpu_write_cr0((cpu_read_cr0() | CR0_MP | CR0_NE | CR0_TS) & ~CR0_EM);
+    return;
+}
+
+void fpu_arch_enable(void) {
+    __asm__ volatile("clts" : : : "memory");
+    return;
+}
+
+void fpu_arch_disable(void) {
+    cpu_write_cr0(cpu_read_cr0() | CR0_TS);
+    return;
+}
+
+void fpu_arch_save(fpu_state_t* _state) {
+    auto low  = static_cast<uint32_t>(fpu_xfeatures);
+    auto high = static_cast<uint32_t>(fpu_xfeatures >> 32);
+    if (fpu_mode == FPU_MODE_XSAVES) {
+        __asm__ volatile("xsaves64 (%0)"
+                         :
+                         : "r"(_state->area), "a"(low), "d"(high)
+                         : "memory");
+    }
+    else if (fpu_mode == FPU_MODE_XSAVEOPT) {
+        __asm__ volatile("xsaveopt64 (%0)"
+                         :
+                         : "r"(_state->area), "a"(low), "d"(high)
+                         : "memory");
+    }
+    else if (fpu_mode == FPU_MODE_XSAVE) {
+        __asm__ volatile("xsave64 (%0)"
+                         :
+                         : "r"(_state->area), "a"(low), "d"(high)
+                         : "memory");
+    }
+    else {
+        __asm__ volatile("fxsave64 (%0)" : : "r"(_state->area) : "memory");
+    }
+    return;
+}
+
+/**
+ * @brief 从保存区恢复
+ */
+static void fpu_restore_area(const uint8_t* _area) {
+    auto low  = static_cast<uint32_t>(fpu_xfeatures);
+    auto high = static_cast<uint32_t>(fpu_xfeatures >> 32);
+    if (fpu_mode == FPU_MODE_XSAVES) {
+        __asm__ volatile("xrstors64 (%0)"
+                         :
+                         : "r"(_area), "a"(low), "d"(high)
+                         : "memory");
+    }
+    else if (fpu_mode != FPU_MODE_FXSAVE) {
+        __asm__ volatile("xrstor64 (%0)"
+                         :
+                         : "r"(_area), "a"(low), "d"(high)
+                         : "memory");
+    }
+    else {
+        __asm__ volatile("fxrstor64 (%0)" : : "r"(_area) : "memory");
+    }
+    return;
+}
+
+void fpu_arch_restore(const fpu_state_t* _state) {
+    fpu_restore_area(_state->area);
+    return;
+}
+
+void fpu_arch_restore_init(void) {
+    fpu_restore_area(fpu_init_area);
+    return;
+}
@@ -0,0 +1,84 @@
+
+/**
+ * @file apic.h
+ * @brief x86_64 local apic
+ * @author Zone.N (Zone.Niuzh@hotmail.com)
+ * @version 1.0
+ * @date 2026-10-18
+ * @copyright MIT LICENSE
+ * https://github.com/MRNIU/cmake-kernel
+ * @par change log:
+ * <table>
+ * <tr><th>Date<th>Author<th>Description
+ * <tr><td>2026-10-18<td>Zone.N (Zone.Niuzh@hotmail.com)<td>创建文件
+ * </table>
+ */
+
+#ifndef CMAKE_KERNEL_APIC_H
+#define CMAKE_KERNEL_APIC_H
+
+#include "cstddef"
+#include "cstdint"
+
+/// apic 基址寄存器
+static constexpr const uint32_t MSR_APIC_BASE       = 0x1B;
+static constexpr const uint64_t APIC_BASE_X2APIC    = 1 << 10;
+static constexpr const uint64_t APIC_BASE_MASK      = ~0xFFFULL;
+
+/// 寄存器偏移，x2apic 模式下对应的 msr 为 0x800 + (偏移 >> 4)
+static constexpr const uint32_t APIC_REG_ID         = 0x20;
+static constexpr const uint32_t APIC_REG_EOI        = 0xB0;
+static constexpr const uint32_t APIC_REG_SVR        = 0xF0;
+static constexpr const uint32_t APIC_REG_ICR_LOW    = 0x300;
+static constexpr const uint32_t APIC_REG_ICR_HIGH   = 0x310;
+static constexpr const uint32_t APIC_REG_LVT_TIMER  = 0x320;
+static constexpr const uint32_t APIC_REG_TIMER_INIT = 0x380;
+static constexpr const uint32_t APIC_REG_TIMER_CUR  = 0x390;
+static constexpr const uint32_t APIC_REG_TIMER_DIV  = 0x3E0;
+
+/// svr 中的 apic 软件使能位
+static constexpr const uint32_t APIC_SVR_ENABLE     = 1 << 8;
+/// 中断正在发送
+static constexpr const uint32_t APIC_ICR_PENDING    = 1 << 12;
+/// 广播给除自己外的所有 cpu，电平触发并断言的 INIT
+static constexpr const uint32_t APIC_ICR_INIT_ALL   = 0xC4500;
+/// 广播给除自己外的所有 cpu 的 SIPI，低 8 位为启动页号
+static constexpr const uint32_t APIC_ICR_SIPI_ALL   = 0xC4600;
+
+/**
+ * @brief 检测 apic 模式，由启动 cpu 在其它 cpu 启动前调用
+ */
+void     apic_init(void);
+
+/**
+ * @brief 使能当前 cpu 的 apic
+ */
+void     apic_cpu_init(void);
+
+/**
+ * @brief 读 apic 寄存器
+ * @param  _reg                    寄存器偏移
+ * @return uint32_t                寄存器的值
+ */
+uint32_t apic_read(uint32_t _reg);
+
+/**
+ * @brief 写 apic 寄存器
+ * @param  _reg                    寄存器偏移
+ * @param  _val                    要写的值
+ */
+void     apic_write(uint32_t _reg, uint32_t _val);
+
+/**
+ * @brief 中断处理结束
+ */
+void     apic_eoi(void);
+
+/**
+ * @brief 发送处理器间中断
+ * @param  _dest                   目标 apic id，使用广播时忽略
+ * @param  _icr                    中断命令寄存器低 32 位
+ */
+void     apic_send_ipi(uint32_t _dest, uint32_t _icr);
+
+#endif /* CMAKE_KERNEL_APIC_H */
@@ -0,0 +1,93 @@
+
+/**
+ * @file context.h
+ * @brief x86_64 上下文切换
+ * @author Zone.N (Zone.Niuzh@hotmail.com)
+ * @version 1.0
+ * @date 2026-10-18
+ * @copyright MIT LICENSE
+ * https://github.com/MRNIU/cmake-kernel
+ * @par change log:
+ * <table>
+ * <tr><th>Date<th>Author<th>Description
+ * <tr><td>2026-10-18<td>Zone.N (Zone.Niuzh@hotmail.com)<td>创建文件
+ * </table>
+ */
+
+#ifndef CMAKE_KERNEL_CONTEXT_H
+#define CMAKE_KERNEL_CONTEXT_H
+
+#include "cstddef"
+#include "cstdint"
+
+/**
+ * @brief 切换时保存在栈上的上下文，与 switch.S 的压栈顺序一致
+ * 只有被调用者保存的寄存器，其余寄存器由编译器在调用前保存，
+ * 被抢占任务的中断帧在它自己的栈上
+ */
+struct context_t {
+    uint64_t r15;
+    uint64_t r14;
+    /// 新任务的参数
+    uint64_t r13;
+    /// 新任务的入口
+    uint64_t r12;
+    uint64_t rbx;
+    uint64_t rbp;
+    /// 返回地址
+    uint64_t rip;
+};
+
+/// 扩展状态保存区的大小，xsave 需要的空间超过时不启用 avx-512
+static constexpr const size_t FPU_AREA_SIZE    = 4096;
+/// 在 SIMD 段中被切换出去的任务等到第一次使用 (#NM) 时再恢复
+static constexpr const bool   FPU_LAZY_RESTORE = true;
+
+/**
+ * @brief 任务的浮点/向量状态
+ */
+struct fpu_state_t {
+    /// xsave/xsaves/fxsave 保存区
+    alignas(64) uint8_t area[FPU_AREA_SIZE];
+    /// 最近一次加载或保存所在的 cpu
+    size_t   cpu;
+    /// kernel_fpu_begin 的嵌套深度
+    uint32_t depth;
+};
+
+extern "C" {
+/**
+ * @brief 保存当前上下文，切换到 _next_sp 指向的上下文
+ * @param  _prev_sp                保存当前栈指针的位置
+ * @param  _next_sp                要切换到的栈指针
+ */
+void context_switch(uintptr_t* _prev_sp, uintptr_t _next_sp);
+
+/**
+ * @brief 新任务第一次被切换到时的入口，调用 _entry(_arg)
+ */
+void context_trampoline(void);
+}
+
+/**
+ * @brief 在新栈上构造初始上下文
+ * @param  _stack_top              栈顶，16 字节对齐
+ * @param  _entry                  入口，不能返回
+ * @param  _arg                    入口的参数
+ * @return uintptr_t               传给 context_switch 的栈指针
+ */
+static inline uintptr_t context_init(uint8_t* _stack_top,
+                                     void (*_entry)(void*), void* _arg) {
+    // context_trampoline 中 call 之前栈需要 16 字节对齐
+    auto* ctx = reinterpret_cast<context_t*>(_stack_top - 16) - 1;
+    ctx->r15  = 0;
+    ctx->r14  = 0;
+    ctx->r13  = reinterpret_cast<uint64_t>(_arg);
+    ctx->r12  = reinterpret_cast<uint64_t>(_entry);
+    ctx->rbx  = 0;
+    ctx->rbp  = 0;
+    ctx->rip  = reinterpret_cast<uint64_t>(context_trampoline);
+    return reinterpret_cast<uintptr_t>(ctx);
+}
+
+#endif /* CMAKE_KERNEL_CONTEXT_H */
@@ -0,0 +1,276 @@
+
+/**
+ * @file cpu.h
+ * @brief x86_64 cpu 相关操作
+ * @author Zone.N (Zone.Niuzh@hotmail.com)
+ * @version 1.0
+ * @date 2026-10-18
+ * @copyright MIT LICENSE
+ * https://github.com/MRNIU/cmake-kernel
+ * @par change log:
+ * <table>
+ * <tr><th>Date<th>Author<th>Description
+ * <tr><td>2026-10-18<td>Zone.N (Zone.Niuzh@hotmail.com)<td>创建文件
+ * </table>
+ */
+
+#ifndef CMAKE_KERNEL_CPU_H
+#define CMAKE_KERNEL_CPU_H
+
+#include "cstddef"
+#include "cstdint"
+
+/**
+ * @brief 自旋等待时提示 cpu 降低流水线与总线压力
+ */
+static inline void cpu_relax(void) {
+    __builtin_ia32_pause();
+    return;
+}
+
+/**
+ * @brief 等待 *_addr 不再等于 _old，允许提前返回，调用者需要重新检查
+ * @param  _addr                   要等待的地址
+ * @param  _old                    旧值
+ */
+static inline void cpu_wait_change(const uint32_t* _addr, uint32_t _old) {
+    (void)_addr;
+    (void)_old;
+    // monitor/mwait 只能在 ring0 且 cpuid 支持时使用，这里只用 pause
+    cpu_relax();
+    return;
+}
+
+/**
+ * @brief cpuid 的返回值
+ */
+struct cpuid_t {
+    uint32_t eax;
+    uint32_t ebx;
+    uint32_t ecx;
+    uint32_t edx;
+};
+
+/**
+ * @brief 执行 cpuid
+ * @param  _leaf                   功能号
+ * @param  _subleaf                子功能号
+ * @return cpuid_t                 寄存器的值
+ */
+static inline cpuid_t cpu_cpuid(uint32_t _leaf, uint32_t _subleaf) {
+    cpuid_t ret;
+    __asm__ volatile("cpuid"
+                     : "=a"(ret.eax), "=b"(ret.ebx), "=c"(ret.ecx),
+                       "=d"(ret.edx)
+                     : "a"(_leaf), "c"(_subleaf));
+    return ret;
+}
+
+/**
+ * @brief 获取当前 cpu 的初始 apic id
+ * @return uint32_t                apic id
+ */
+static inline uint32_t cpu_apic_id(void) {
+    return cpu_cpuid(1, 0).ebx >> 24;
+}
+
+/// gs 基址寄存器
+static constexpr const uint32_t MSR_GS_BASE = 0xC0000101;
+
+/**
+ * @brief 写 msr
+ * @param  _msr                    msr 编号
+ * @param  _val                    值
+ */
+static inline void cpu_write_msr(uint32_t _msr, uint64_t _val) {
+    __asm__ volatile("wrmsr"
+                     :
+                     : "c"(_msr), "a"(static_cast<uint32_t>(_val)),
+                       "d"(static_cast<uint32_t>(_val >> 32))
+                     : "memory");
+    return;
+}
+
+/**
+ * @brief 读 msr
+ * @param  _msr                    msr 编号
+ * @return uint64_t                值
+ */
+static inline uint64_t cpu_read_msr(uint32_t _msr) {
+    uint32_t low;
+    uint32_t high;
+    __asm__ volatile("rdmsr" : "=a"(low), "=d"(high) : "c"(_msr));
+    return (static_cast<uint64_t>(high) << 32) | low;
+}
+
+/**
+ * @brief 设置当前 cpu 的 percpu 偏移，保存在 gs 基址中
+ * @param  _offset                 本 cpu 数据区相对模板的偏移
+ */
+static inline void cpu_set_percpu_offset(uintptr_t _offset) {
+    cpu_write_msr(MSR_GS_BASE, _offset);
+    return;
+}
+
+/**
+ * @brief 读端口
+ * @param  _port                   端口号
+ * @return uint8_t                 读到的值
+ */
+static inline uint8_t cpu_inb(uint16_t _port) {
+    uint8_t val;
+    __asm__ volatile("inb %1, %0" : "=a"(val) : "Nd"(_port));
+    return val;
+}
+
+/**
+ * @brief 写端口
+ * @param  _port                   端口号
+ * @param  _val                    要写的值
+ */
+static inline void cpu_outb(uint16_t _port, uint8_t _val) {
+    __asm__ volatile("outb %0, %1" : : "a"(_val), "Nd"(_port));
+    return;
+}
+
+/**
+ * @brief 读控制寄存器
+ * @return uint64_t                寄存器的值
+ */
+static inline uint64_t cpu_read_cr0(void) {
+    uint64_t val;
+    __asm__ volatile("mov %%cr0, %0" : "=r"(val));
+    return val;
+}
+
+static inline uint64_t cpu_read_cr3(void) {
+    uint64_t val;
+    __asm__ volatile("mov %%cr3, %0" : "=r"(val));
+    return val;
+}
+
+static inline uint64_t cpu_read_cr4(void) {
+    uint64_t val;
+    __asm__ volatile("mov %%cr4, %0" : "=r"(val));
+    return val;
+}
+
+/**
+ * @brief 写控制寄存器
+ * @param  _val                    要写的值
+ */
+static inline void cpu_write_cr0(uint64_t _val) {
+    __asm__ volatile("mov %0, %%cr0" : : "r"(_val) : "memory");
+    return;
+}
+
+static inline void cpu_write_cr4(uint64_t _val) {
+    __asm__ volatile("mov %0, %%cr4" : : "r"(_val) : "memory");
+    return;
+}
+
+/**
+ * @brief 开中断
+ */
+static inline void cpu_irq_enable(void) {
+    __asm__ volatile("sti" ::: "memory");
+    return;
+}
+
+/**
+ * @brief 关中断
+ */
+static inline void cpu_irq_disable(void) {
+    __asm__ volatile("cli" ::: "memory");
+    return;
+}
+
+/// rflags 中断允许位
+static constexpr const uint64_t RFLAGS_IF = 1 << 9;
+
+/**
+ * @brief 关中断并返回之前的状态
+ * @return uint64_t                之前的 rflags
+ */
+static inline uint64_t cpu_irq_save(void) {
+    uint64_t flags;
+    __asm__ volatile("pushfq; popq %0; cli" : "=r"(flags) : : "memory");
+    return flags;
+}
+
+/**
+ * @brief 恢复 cpu_irq_save 保存的中断状态
+ * @param  _flags                  cpu_irq_save 的返回值
+ */
+static inline void cpu_irq_restore(uint64_t _flags) {
+    if ((_flags & RFLAGS_IF) != 0) {
+        cpu_irq_enable();
+    }
+    return;
+}
+
+/**
+ * @brief 中断是否打开
+ * @return true                    打开
+ * @return false                   关闭
+ */
+static inline bool cpu_irq_enabled(void) {
+    uint64_t flags;
+    __asm__ volatile("pushfq; popq %0" : "=r"(flags));
+    return (flags & RFLAGS_IF) != 0;
+}
+
+/**
+ * @brief 读取时间戳计数器
+ * @return uint64_t                周期数
+ */
+static inline uint64_t cpu_cycles(void) {
+    uint32_t low;
+    uint32_t high;
+    __asm__ volatile("rdtsc" : "=a"(low), "=d"(high));
+    return (static_cast<uint64_t>(high) << 32) | low;
+}
+
+/// 是否支持 monitor/mwait，由 arch() 检测
+extern bool cpu_mwait_supported;
+
+/**
+ * @brief 暂停执行直到下一个中断，中断关闭时除 nmi 外不会返回
+ */
+static inline void cpu_halt(void) {
+    __asm__ volatile("hlt" ::: "memory");
+    return;
+}
+
+/**
+ * @brief cpu_idle_wait 能否被写 _addr 唤醒，否则只能由中断唤醒
+ * @return true                    可以
+ * @return false                   不可以
+ */
+static inline bool cpu_idle_can_monitor(void) {
+    return cpu_mwait_supported;
+}
+
+/**
+ * @brief 空闲等待，调用时中断关闭，返回时中断打开
+ * 支持 mwait 时监视 _addr 所在的缓存行，被写入或产生中断时返回，
+ * 否则使用 hlt 等待中断。sti 的效果延迟一条指令，
+ * 检查与进入等待之间到达的中断会唤醒 hlt/mwait，不会丢失
+ * @param  _addr                   要监视的地址
+ * @param  _old                    旧值，已变化时直接返回
+ */
+static inline void cpu_idle_wait(const uint32_t* _addr, uint32_t _old) {
+    if (cpu_mwait_supported) {
+        __asm__ volatile("monitor" : : "a"(_addr), "c"(0), "d"(0) : "memory");
+        if (__atomic_load_n(_addr, __ATOMIC_RELAXED) != _old) {
+            cpu_irq_enable();
+            return;
+        }
+        __asm__ volatile("sti; mwait" : : "a"(0), "c"(0) : "memory");
+        return;
+    }
+    __asm__ volatile("sti; hlt" ::: "memory");
+    return;
+}
+
+#endif /* CMAKE_KERNEL_CPU_H */
@@ -0,0 +1,84 @@
+
+/**
+ * @file mmu.h
+ * @brief x86_64 地址转换与 tlb
+ * @author Zone.N (Zone.Niuzh@hotmail.com)
+ * @version 1.0
+ * @date 2026-10-18
+ * @copyright MIT LICENSE
+ * https://github.com/MRNIU/cmake-kernel
+ * @par change log:
+ * <table>
+ * <tr><th>Date<th>Author<th>Description
+ * <tr><td>2026-10-18<td>Zone.N (Zone.Niuzh@hotmail.com)<td>创建文件
+ * </table>
+ */
+
+#ifndef CMAKE_KERNEL_MMU_H
+#define CMAKE_KERNEL_MMU_H
+
+#include "cstddef"
+#include "cstdint"
+
+#include "cpu.h"
+
+/// cr3 中页表的物理地址
+static constexpr const uint64_t CR3_ROOT_MASK = 0x000FFFFFFFFFF000ULL;
+/// 写 cr3 时不刷新该 pcid 的 tlb，需要 cr4.PCIDE
+static constexpr const uint64_t CR3_NOFLUSH   = 1ULL << 63;
+static constexpr const uint64_t CR4_PGE       = 1 << 7;
+static constexpr const uint64_t CR4_PCIDE     = 1 << 17;
+
+/**
+ * @brief 地址空间标签 (pcid) 的位数
+ * @return uint32_t                位数，不支持时为 0
+ */
+static inline uint32_t mmu_asid_bits(void) {
+    return (cpu_cpuid(1, 0).ecx & (1 << 17)) != 0 ? 12 : 0;
+}
+
+/**
+ * @brief 读取当前页表
+ * @return uintptr_t               不含标签的页表根
+ */
+static inline uintptr_t mmu_read_root(void) {
+    return cpu_read_cr3() & CR3_ROOT_MASK;
+}
+
+/**
+ * @brief 初始化当前 cpu，_tagged 时启用 pcid
+ * 启用前 cr3 的 pcid 需要为 0
+ * @param  _tagged                 是否启用标签
+ */
+static inline void mmu_cpu_init(bool _tagged) {
+    if (_tagged) {
+        __asm__ volatile("mov %0, %%cr3" : : "r"(mmu_read_root()) : "memory");
+        cpu_write_cr4(cpu_read_cr4() | CR4_PCIDE);
+    }
+    return;
+}
+
+/**
+ * @brief 切换页表
+ * @param  _root                   页表根
+ * @param  _asid                   标签，未启用时为 0
+ * @param  _flush                  是否丢弃该标签的 tlb，未启用标签时必须为 true
+ */
+static inline void mmu_switch(uintptr_t _root, uint32_t _asid, bool _flush) {
+    uint64_t cr3 = _root | _asid | (_flush ? 0 : CR3_NOFLUSH);
+    __asm__ volatile("mov %0, %%cr3" : : "r"(cr3) : "memory");
+    return;
+}
+
+/**
+ * @brief 丢弃当前 cpu 所有标签的 tlb，包括全局页
+ */
+static inline void mmu_flush_all(void) {
+    // 改变 cr4.PGE 会刷新所有 pcid 与全局页
+    auto cr4 = cpu_read_cr4();
+    cpu_write_cr4(cr4 ^ CR4_PGE);
+    cpu_write_cr4(cr4);
+    return;
+}
+
+#endif /* CMAKE_KERNEL_MMU_H */
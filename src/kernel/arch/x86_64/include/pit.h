@@ -0,0 +1,33 @@
+
+/**
+ * @file pit.h
+ * @brief x86_64 8254 可编程间隔定时器
+ * @author Zone.N (Zone.Niuzh@hotmail.com)
+ * @version 1.0
+ * @date 2026-10-18
+ * @copyright MIT LICENSE
+ * https://github.com/MRNIU/cmake-kernel
+ * @par change log:
+ * <table>
+ * <tr><th>Date<th>Author<th>Description
+ * <tr><td>2026-10-18<td>Zone.N (Zone.Niuzh@hotmail.com)<td>创建文件
+ * </table>
+ */
+
+#ifndef CMAKE_KERNEL_PIT_H
+#define CMAKE_KERNEL_PIT_H
+
+#include "cstddef"
+#include "cstdint"
+
+/// pit 频率
+static constexpr const uint64_t PIT_HZ = 1193182;
+
+/**
+ * @brief 使用 pit 通道 2 忙等
+ * 只在时钟初始化之前使用，用于启动其它 cpu 与校准时钟
+ * @param  _us                     微秒
+ */
+void pit_udelay(uint64_t _us);
+
+#endif /* CMAKE_KERNEL_PIT_H */
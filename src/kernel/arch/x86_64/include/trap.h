@@ -0,0 +1,91 @@
+
+/**
+ * @file trap.h
+ * @brief x86_64 中断帧
+ * @author Zone.N (Zone.Niuzh@hotmail.com)
+ * @version 1.0
+ * @date 2026-10-18
+ * @copyright MIT LICENSE
+ * https://github.com/MRNIU/cmake-kernel
+ * @par change log:
+ * <table>
+ * <tr><th>Date<th>Author<th>Description
+ * <tr><td>2026-10-18<td>Zone.N (Zone.Niuzh@hotmail.com)<td>创建文件
+ * </table>
+ */
+
+#ifndef CMAKE_KERNEL_TRAP_H
+#define CMAKE_KERNEL_TRAP_H
+
+#include "cstddef"
+#include "cstdint"
+
+/// 中断号数量，即 idt 表项数
+static constexpr const size_t INTERRUPT_MAX         = 256;
+/// 0~31 为 cpu 异常
+static constexpr const size_t INTERRUPT_EXCEPTION_N = 32;
+/// 设备不可用异常，cr0.TS 置位时使用浮点/向量指令产生
+static constexpr const size_t INTERRUPT_FPU_TRAP    = 7;
+/// 缺页异常
+static constexpr const size_t INTERRUPT_PAGE_FAULT  = 14;
+/// apic 时钟中断
+static constexpr const size_t INTERRUPT_TIMER       = 0x20;
+/// 处理器间中断
+static constexpr const size_t INTERRUPT_IPI         = 0xF0;
+/// 用于测量进出中断开销的中断号
+static constexpr const size_t INTERRUPT_BENCH       = 0xFE;
+/// apic 伪中断
+static constexpr const size_t INTERRUPT_SPURIOUS    = 0xFF;
+
+/**
+ * @brief 中断帧，与 trap.S 的压栈顺序一致
+ * 入口只保存调用者保存的寄存器，被调用者保存的寄存器由 C 代码自己维护
+ */
+struct trap_frame_t {
+    uint64_t r11;
+    uint64_t r10;
+    uint64_t r9;
+    uint64_t r8;
+    uint64_t rdi;
+    uint64_t rsi;
+    uint64_t rdx;
+    uint64_t rcx;
+    uint64_t rax;
+    /// 中断号
+    uint64_t no;
+    /// 错误码，没有错误码的异常与中断为 0
+    uint64_t error_code;
+    /// 以下由 cpu 压栈
+    uint64_t rip;
+    uint64_t cs;
+    uint64_t rflags;
+    uint64_t rsp;
+    uint64_t ss;
+};
+
+/**
+ * @brief 被中断的上下文是否允许中断
+ * @param  _frame                  中断帧
+ * @return true                    rflags.IF 为 1
+ * @return false                   rflags.IF 为 0
+ */
+static inline bool trap_irq_enabled(const trap_frame_t* _frame) {
+    return (_frame->rflags & (1 << 9)) != 0;
+}
+
+/**
+ * @brief 触发 INTERRUPT_BENCH 号中断
+ */
+static inline void trap_raise_bench(void) {
+    __asm__ volatile("int %0" : : "i"(INTERRUPT_BENCH) : "memory");
+    return;
+}
+
+/**
+ * @brief 结束 INTERRUPT_BENCH 号中断，软件中断不需要应答
+ */
+static inline void trap_ack_bench(void) {
+    return;
+}
+
+#endif /* CMAKE_KERNEL_TRAP_H */
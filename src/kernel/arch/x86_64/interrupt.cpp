@@ -0,0 +1,192 @@
+
+/**
+ * @file interrupt.cpp
+ * @brief x86_64 中断初始化
+ * @author Zone.N (Zone.Niuzh@hotmail.com)
+ * @version 1.0
+ * @date 2026-10-18
+ * @copyright MIT LICENSE
+ * https://github.com/MRNIU/cmake-kernel
+ * @par change log:
+ * <table>
+ * <tr><th>Date<th>Author<th>Description
+ * <tr><td>2026-10-18<td>Zone.N (Zone.Niuzh@hotmail.com)<td>创建文件
+ * </table>
+ */
+
+#include "apic.h"
+#include "cpu.h"
+#include "interrupt.h"
+#include "percpu.h"
+
+/// 中断入口，位于 trap.S，每个 16 字节
+extern "C" uint8_t trap_stubs[];
+static constexpr const size_t   TRAP_STUB_SIZE         = 16;
+
+/// 中断门，present，dpl 0，进入时关中断
+static constexpr const uint8_t  IDT_INTERRUPT_GATE     = 0x8E;
+
+/// 内核 gdt 的段选择子，所有 cpu 相同
+static constexpr const uint16_t GDT_KERNEL_CODE        = 0x08;
+static constexpr const uint16_t GDT_KERNEL_DATA        = 0x10;
+static constexpr const uint16_t GDT_TSS                = 0x18;
+/// gdt 的项数: 空、代码段、数据段、tss (占两项)
+static constexpr const size_t   GDT_ENTRIES            = 5;
+/// 64 位代码段，present，dpl 0，可读可执行
+static constexpr const uint64_t GDT_CODE64             = 0x00AF9A000000FFFF;
+/// 数据段，present，dpl 0，可读写
+static constexpr const uint64_t GDT_DATA               = 0x00CF92000000FFFF;
+/// 可用的 64 位 tss，present
+static constexpr const uint64_t GDT_TSS_AVAILABLE      = 0x89;
+
+/// 双重错误异常
+static constexpr const size_t   INTERRUPT_DOUBLE_FAULT = 8;
+/// 双重错误使用的 ist 编号，内核栈溢出时仍有可用的栈
+static constexpr const uint8_t  IST_DOUBLE_FAULT       = 1;
+static constexpr const size_t   IST_STACK_SIZE         = 4096;
+
+/// 8259 中断控制器数据端口
+static constexpr const uint16_t PIC_MASTER_DATA        = 0x21;
+static constexpr const uint16_t PIC_SLAVE_DATA         = 0xA1;
+
+/**
+ * @brief idt 表项
+ */
+struct idt_entry_t {
+    uint16_t offset_low;
+    uint16_t selector;
+    uint8_t  ist;
+    uint8_t  type_attr;
+    uint16_t offset_mid;
+    uint32_t offset_high;
+    uint32_t reserved;
+} __attribute__((packed));
+
+/**
+ * @brief 64 位 tss，只用于提供中断栈
+ */
+struct tss_t {
+    uint32_t reserved0;
+    /// 特权级切换时使用的栈，内核不运行在 ring3，不使用
+    uint64_t rsp[3];
+    uint64_t reserved1;
+    /// 中断栈表，idt 表项的 ist 字段选择其中一个
+    uint64_t ist[7];
+    uint64_t reserved2;
+    uint16_t reserved3;
+    /// io 权限位图的偏移，超过段界限表示没有位图
+    uint16_t iomap_base;
+} __attribute__((packed));
+
+/**
+ * @brief lgdt 与 lidt 的操作数
+ */
+struct table_ptr_t {
+    uint16_t limit;
+    uint64_t base;
+} __attribute__((packed));
+
+/// 所有 cpu 共享一个 idt
+alignas(16) static idt_entry_t idt[INTERRUPT_MAX];
+
+/// tss 描述符的忙位由 ltr 设置，每个 cpu 使用自己的 gdt 与 tss，
+/// 选择子在所有 cpu 上相同
+alignas(16) static uint64_t    gdts[MAX_CPU_COUNT][GDT_ENTRIES];
+alignas(16) static tss_t       tsss[MAX_CPU_COUNT];
+alignas(16) static uint8_t     ist_stacks[MAX_CPU_COUNT][IST_STACK_SIZE];
+
+/**
+ * @brief 加载本 cpu 的 gdt 与 tss
+ * 启动 cpu 此前使用固件的 gdt，其它 cpu 使用 ap_boot.S 中的临时 gdt，
+ * 二者的代码段选择子不同，之后统一使用 GDT_KERNEL_CODE
+ * @param  _cpu                    cpu 编号
+ */
+static void gdt_cpu_init(size_t _cpu) {
+    auto& tss = tsss[_cpu];
+    tss.iomap_base = sizeof(tss_t);
+    tss.ist[IST_DOUBLE_FAULT - 1]
+      = reinterpret_cast<uint64_t>(ist_stacks[_cpu]) + IST_STACK_SIZE;
+
+    auto  base  = reinterpret_cast<uint64_t>(&tss);
+    auto  limit = static_cast<uint64_t>(sizeof(tss_t) - 1);
+    auto* gdt   = gdts[_cpu];
+
+    gdt[0] = 0;
+    gdt[1] = GDT_CODE64;
+    gdt[2] = GDT_DATA;
+    // tss 描述符占 16 字节，高 8 字节为基址的高 32 位
+    gdt[3] = (limit & 0xFFFF) | ((base & 0xFFFFFF) << 16)
+           | (GDT_TSS_AVAILABLE << 40) | (((limit >> 16) & 0xF) << 48)
+           | (((base >> 24) & 0xFF) << 56);
+    gdt[4] = base >> 32;
+
+    table_ptr_t ptr = {
+        .limit = sizeof(gdts[0]) - 1,
+        .base  = reinterpret_cast<uint64_t>(gdt),
+    };
+    // 远返回重新加载 cs，再加载数据段。
+    // 不重新加载 fs 与 gs，否则会覆盖 percpu 使用的 gs 基址
+    __asm__ volatile("lgdt %0\n"
+                     "pushq %1\n"
+                     "leaq 1f(%%rip), %%rax\n"
+                     "pushq %%rax\n"
+                     "lretq\n"
+                     "1:\n"
+                     "movl %2, %%ds\n"
+                     "movl %2, %%es\n"
+                     "movl %2, %%ss\n"
+                     :
+                     : "m"(ptr), "i"(GDT_KERNEL_CODE),
+                       "r"(static_cast<uint32_t>(GDT_KERNEL_DATA))
+                     : "rax", "memory");
+    __asm__ volatile("ltr %0" : : "r"(GDT_TSS) : "memory");
+    return;
+}
+
+void interrupt_arch_init(void) {
+    for (size_t i = 0; i < INTERRUPT_MAX; i++) {
+        auto addr = reinterpret_cast<uintptr_t>(trap_stubs)
+                  + i * TRAP_STUB_SIZE;
+        idt[i].offset_low  = addr & 0xFFFF;
+        idt[i].selector    = GDT_KERNEL_CODE;
+        idt[i].ist         = 0;
+        idt[i].type_attr   = IDT_INTERRUPT_GATE;
+        idt[i].offset_mid  = (addr >> 16) & 0xFFFF;
+        idt[i].offset_high = (addr >> 32) & 0xFFFFFFFF;
+        idt[i].reserved    = 0;
+    }
+    idt[INTERRUPT_DOUBLE_FAULT].ist = IST_DOUBLE_FAULT;
+    // 屏蔽 8259，只使用 apic
+    cpu_outb(PIC_MASTER_DATA, 0xFF);
+    cpu_outb(PIC_SLAVE_DATA, 0xFF);
+    apic_init();
+    return;
+}
+
+void interrupt_arch_cpu_init(void) {
+    gdt_cpu_init(cpu_id());
+    table_ptr_t ptr = {
+        .limit = sizeof(idt) - 1,
+        .base  = reinterpret_cast<uint64_t>(idt),
+    };
+    __asm__ volatile("lidt %0" : : "m"(ptr) : "memory");
+    apic_cpu_init();
+    return;
+}
+
+void interrupt_arch_default(size_t _no, trap_frame_t* _frame) {
+    (void)_frame;
+    // 未处理的异常无法恢复，停机
+    /// @todo 输出异常信息
+    if (_no < INTERRUPT_EXCEPTION_N) {
+        cpu_irq_disable();
+        while (1) {
+            cpu_halt();
+        }
+    }
+    // 伪中断不需要应答
+    if (_no != INTERRUPT_SPURIOUS) {
+        apic_eoi();
+    }
+    return;
+}
@@ -0,0 +1,86 @@
+
+/**
+ * @file msi.cpp
+ * @brief x86_64 消息信号中断
+ * @author Zone.N (Zone.Niuzh@hotmail.com)
+ * @version 1.0
+ * @date 2026-10-18
+ * @copyright MIT LICENSE
+ * https://github.com/MRNIU/cmake-kernel
+ * @par change log:
+ * <table>
+ * <tr><th>Date<th>Author<th>Description
+ * <tr><td>2026-10-18<td>Zone.N (Zone.Niuzh@hotmail.com)<td>创建文件
+ * </table>
+ */
+
+#include "msi.h"
+#include "apic.h"
+#include "interrupt.h"
+#include "percpu.h"
+#include "spinlock.hpp"
+
+/// 设备中断使用的中断号范围，位于时钟中断与处理器间中断之间
+static constexpr const size_t   MSI_VECTOR_FIRST = 0x30;
+static constexpr const size_t   MSI_VECTOR_LAST  = 0xEF;
+
+/// 消息地址，目标 apic id 位于 12~19 位，使用物理目标模式
+static constexpr const uint64_t MSI_ADDRESS_BASE = 0xFEE00000;
+
+/**
+ * @brief 中断号对应的处理函数
+ */
+struct msi_vector_t {
+    void (*handler)(void* _arg);
+    void* arg;
+};
+
+static TicketLock   msi_lock;
+static msi_vector_t msi_vectors[INTERRUPT_MAX];
+
+static void msi_entry(size_t _no, trap_frame_t* _frame) {
+    (void)_frame;
+    auto* vec     = &msi_vectors[_no];
+    auto  handler = __atomic_load_n(&vec->handler, __ATOMIC_ACQUIRE);
+    if (handler != nullptr) {
+        handler(vec->arg);
+    }
+    apic_eoi();
+    return;
+}
+
+size_t msi_alloc(size_t _cpu, void (*_handler)(void* _arg), void* _arg,
+                 msi_msg_t* _msg) {
+    size_t no = 0;
+    {
+        IrqLockGuard<TicketLock> guard(msi_lock);
+        for (size_t i = MSI_VECTOR_FIRST; i <= MSI_VECTOR_LAST; i++) {
+            if (msi_vectors[i].handler == nullptr) {
+                no = i;
+                break;
+            }
+        }
+        if (no == 0) {
+            return 0;
+        }
+        msi_vectors[no].arg = _arg;
+        __atomic_store_n(&msi_vectors[no].handler, _handler, __ATOMIC_RELEASE);
+    }
+    register_interrupt_handler(no, msi_entry);
+    auto apic_id  = *per_cpu_ptr(&cpu_hartid, _cpu);
+    _msg->address = MSI_ADDRESS_BASE | ((apic_id & 0xFF) << 12);
+    // 边沿触发，固定投递模式
+    _msg->data    = no;
+    return no;
+}
+
+void msi_free(size_t _no) {
+    if ((_no < MSI_VECTOR_FIRST) || (_no > MSI_VECTOR_LAST)) {
+        return;
+    }
+    register_interrupt_handler(_no, nullptr);
+    IrqLockGuard<TicketLock> guard(msi_lock);
+    __atomic_store_n(&msi_vectors[_no].handler, nullptr, __ATOMIC_RELEASE);
+    msi_vectors[_no].arg = nullptr;
+    return;
+}
@@ -0,0 +1,43 @@
+
+/**
+ * @file pit.cpp
+ * @brief x86_64 8254 可编程间隔定时器
+ * @author Zone.N (Zone.Niuzh@hotmail.com)
+ * @version 1.0
+ * @date 2026-10-18
+ * @copyright MIT LICENSE
+ * https://github.com/MRNIU/cmake-kernel
+ * @par change log:
+ * <table>
+ * <tr><th>Date<th>Author<th>Description
+ * <tr><td>2026-10-18<td>Zone.N (Zone.Niuzh@hotmail.com)<td>创建文件
+ * </table>
+ */
+
+#include "pit.h"
+#include "cpu.h"
+
+static constexpr const uint16_t PIT_CMD      = 0x43;
+static constexpr const uint16_t PIT_CH2      = 0x42;
+/// 控制通道 2 门控与读取输出的端口
+static constexpr const uint16_t PIT_CH2_GATE = 0x61;
+
+void pit_udelay(uint64_t _us) {
+    auto ticks = _us * PIT_HZ / 1000000;
+    while (ticks > 0) {
+        auto count = ticks > 0xFFFF ? 0xFFFF : ticks;
+        ticks      -= count;
+        // 关闭门控与扬声器，通道 2 模式 0，先低后高
+        auto gate  = cpu_inb(PIT_CH2_GATE) & ~0x03;
+        cpu_outb(PIT_CH2_GATE, gate);
+        cpu_outb(PIT_CMD, 0xB0);
+        cpu_outb(PIT_CH2, count & 0xFF);
+        cpu_outb(PIT_CH2, (count >> 8) & 0xFF);
+        // 打开门控开始计数，输出变高时计数结束
+        cpu_outb(PIT_CH2_GATE, gate | 0x01);
+        while ((cpu_inb(PIT_CH2_GATE) & 0x20) == 0) {
+            cpu_relax();
+        }
+    }
+    return;
+}
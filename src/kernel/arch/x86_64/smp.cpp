@@ -0,0 +1,134 @@
+
+/**
+ * @file smp.cpp
+ * @brief x86_64 多核启动
+ * @author Zone.N (Zone.Niuzh@hotmail.com)
+ * @version 1.0
+ * @date 2026-10-18
+ * @copyright MIT LICENSE
+ * https://github.com/MRNIU/cmake-kernel
+ * @par change log:
+ * <table>
+ * <tr><th>Date<th>Author<th>Description
+ * <tr><td>2026-10-18<td>Zone.N (Zone.Niuzh@hotmail.com)<td>创建文件
+ * </table>
+ */
+
+#include "smp.h"
+#include "apic.h"
+#include "cpu.h"
+#include "mmu.h"
+#include "percpu.h"
+#include "pit.h"
+#include "trap.h"
+
+// 启动代码位于 ap_boot.S，在这里复制到低端内存并填写参数。
+// 物理地址 AP_BASE 开始的两页由加载器保留，第一页为启动代码，
+// 第二页为顶级页表的副本，供 ap 在进入长模式前使用。
+// 假设启动 cpu 的页表与 uefi 一样恒等映射了低端内存、内核与 cpu_stacks
+extern "C" uint8_t  ap_trampoline_start[];
+extern "C" uint8_t  ap_trampoline_end[];
+extern "C" uint64_t ap_cr0;
+extern "C" uint64_t ap_cr3;
+extern "C" uint64_t ap_boot_cr3;
+extern "C" uint64_t ap_cr4;
+extern "C" uint64_t ap_efer;
+extern "C" uint64_t ap_stack_base;
+extern "C" uint64_t ap_stack_size;
+extern "C" uint64_t ap_entry;
+extern "C" uint32_t ap_next_cpu;
+
+/// 加载器保留的低端内存，位于 arch.cpp
+extern uintptr_t ap_trampoline_reserved;
+
+/// 启动代码复制到的物理地址，需要与 ap_boot.S 及加载器一致
+static constexpr const uintptr_t AP_BASE    = 0x8000;
+/// 顶级页表副本的物理地址
+static constexpr const uintptr_t AP_PML4    = AP_BASE + 0x1000;
+/// 页大小
+static constexpr const size_t    AP_PAGE    = 0x1000;
+
+static constexpr const uint32_t  MSR_EFER   = 0xC0000080;
+/// 长模式已激活，由硬件设置，不能写入
+static constexpr const uint64_t  EFER_LMA   = 1 << 10;
+
+/// 等待 ap 上线的最长时间，单位为微秒
+static constexpr const uint64_t  AP_WAIT_US = 100 * 1000;
+
+/**
+ * @brief 预期的逻辑 cpu 数
+ * @return size_t                  包括启动 cpu，不超过 MAX_CPU_COUNT
+ * @todo 从 acpi madt 获取
+ */
+static size_t expected_cpu_count(void) {
+    size_t count = 1;
+    if (cpu_cpuid(0, 0).eax >= 0xB) {
+        // 0xB 号叶子子叶 1 为封装级，ebx 为其中的逻辑 cpu 数
+        count = cpu_cpuid(0xB, 1).ebx & 0xFFFF;
+    }
+    if (count == 0) {
+        count = 1;
+    }
+    return count > MAX_CPU_COUNT ? MAX_CPU_COUNT : count;
+}
+
+extern "C" [[noreturn]] void x86_ap_entry(size_t _cpu) {
+    smp_ap_main(_cpu, cpu_apic_id());
+}
+
+size_t smp_arch_boot(void) {
+    auto expected = expected_cpu_count();
+    if (expected <= 1) {
+        return 0;
+    }
+    // 低端内存没有保留时不能覆盖，只使用启动 cpu
+    if ((ap_trampoline_reserved != AP_BASE)
+        || (static_cast<size_t>(ap_trampoline_end - ap_trampoline_start)
+            > AP_PAGE)) {
+        return 0;
+    }
+    // 填写参数后复制，ap 使用复制后的副本
+    ap_cr0        = cpu_read_cr0();
+    ap_cr3        = cpu_read_cr3();
+    ap_cr4        = cpu_read_cr4();
+    ap_efer       = cpu_read_msr(MSR_EFER) & ~EFER_LMA;
+    ap_stack_base = reinterpret_cast<uint64_t>(cpu_stacks);
+    ap_stack_size = CPU_STACK_SIZE;
+    ap_entry      = reinterpret_cast<uint64_t>(x86_ap_entry);
+    ap_next_cpu   = 1;
+    // 实模式与保护模式下 cr3 只有 32 位，启动 cpu 的页表可能位于 4GB 以上，
+    // 复制顶级页表到低端内存，其表项可以指向任意物理地址
+    ap_boot_cr3   = AP_PML4;
+    __builtin_memcpy(reinterpret_cast<void*>(AP_PML4),
+                     reinterpret_cast<const void*>(mmu_read_root()),
+                     AP_PAGE);
+    __builtin_memcpy(reinterpret_cast<void*>(AP_BASE), ap_trampoline_start,
+                     ap_trampoline_end - ap_trampoline_start);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+    // INIT-SIPI-SIPI，广播唤醒所有 ap，它们并行初始化
+    apic_send_ipi(0, APIC_ICR_INIT_ALL);
+    pit_udelay(10 * 1000);
+    apic_send_ipi(0, APIC_ICR_SIPI_ALL | (AP_BASE >> 12));
+    pit_udelay(200);
+    apic_send_ipi(0, APIC_ICR_SIPI_ALL | (AP_BASE >> 12));
+
+    // 等待 ap 上线，超时后以实际上线的数量为准
+    for (uint64_t waited = 0;
+         (smp_cpu_count() < expected) && (waited < AP_WAIT_US);
+         waited += 100) {
+        pit_udelay(100);
+    }
+    return smp_cpu_count() - 1;
+}
+
+void smp_arch_send_ipi(size_t _hartid) {
+    // 固定投递，物理目标模式，低 8 位为中断号
+    apic_send_ipi(_hartid, INTERRUPT_IPI);
+    return;
+}
+
+void smp_arch_ipi_ack(void) {
+    apic_eoi();
+    return;
+}
@@ -0,0 +1,322 @@
+
+/**
+ * @file bench.cpp
+ * @brief 块设备性能测量
+ * @author Zone.N (Zone.Niuzh@hotmail.com)
+ * @version 1.0
+ * @date 2026-10-18
+ * @copyright MIT LICENSE
+ * https://github.com/MRNIU/cmake-kernel
+ * @par change log:
+ * <table>
+ * <tr><th>Date<th>Author<th>Description
+ * <tr><td>2026-10-18<td>Zone.N (Zone.Niuzh@hotmail.com)<td>创建文件
+ * </table>
+ */
+
+#include "blkdev.h"
+
+#include "ktime.h"
+#include "libc.h"
+#include "mutex.h"
+#include "sched.h"
+#include "smp.h"
+#include "spinlock.hpp"
+#include "wait.h"
+
+/// 延迟直方图: 每个 2 的幂区间再等分为 8 个桶
+static constexpr const size_t HIST_SUB_BITS = 3;
+static constexpr const size_t HIST_SUB      = 1 << HIST_SUB_BITS;
+static constexpr const size_t HIST_BUCKETS  = 64 * HIST_SUB;
+
+/**
+ * @brief 一个测量线程的状态
+ */
+struct bench_thread_t {
+    blk_dev_t*         bdev;
+    const blk_bench_t* bench;
+    size_t             hwq;
+    /// hwq 是否需要轮询
+    bool               polled;
+    /// 需要完成的请求数，创建失败时为 0
+    size_t             ios;
+    uint64_t           rng;
+    /// 顺序访问时下一个请求的位置
+    uint64_t           next_sector;
+    blk_request_t      rqs[BLK_BENCH_DEPTH_MAX];
+    uint64_t           submit_ns[BLK_BENCH_DEPTH_MAX];
+    uint64_t           complete_ns[BLK_BENCH_DEPTH_MAX];
+    /// 已完成、尚未被线程处理的槽，由 end_io 设置
+    uint64_t           done_mask;
+    /// 结果
+    uint64_t           completed;
+    uint64_t           errors;
+    uint64_t           lat_sum;
+    uint64_t           lat_max;
+    uint32_t           hist[HIST_BUCKETS];
+};
+
+/// 同一时间只运行一个测量
+static Mutex          bench_lock;
+static bench_thread_t bench_threads[MAX_CPU_COUNT];
+/// 已结束的线程数
+static size_t         bench_done;
+/// 数据缓冲区，每个槽一个
+alignas(BLK_BENCH_BLOCK_MAX) static uint8_t
+  bench_buffers[MAX_CPU_COUNT][BLK_BENCH_DEPTH_MAX][BLK_BENCH_BLOCK_MAX];
+
+static size_t hist_bucket(uint64_t _ns) {
+    if (_ns < HIST_SUB) {
+        return _ns;
+    }
+    size_t msb = 63 - __builtin_clzll(_ns);
+    return (msb - HIST_SUB_BITS + 1) * HIST_SUB
+           + ((_ns >> (msb - HIST_SUB_BITS)) & (HIST_SUB - 1));
+}
+
+/**
+ * @brief 桶的下界
+ */
+static uint64_t hist_value(size_t _bucket) {
+    if (_bucket < HIST_SUB) {
+        return _bucket;
+    }
+    auto shift = _bucket / HIST_SUB - 1;
+    return (HIST_SUB + _bucket % HIST_SUB) << shift;
+}
+
+static uint64_t xorshift64(uint64_t* _state) {
+    auto x = *_state;
+    x      ^= x << 13;
+    x      ^= x >> 7;
+    x      ^= x << 17;
+    return *_state = x;
+}
+
+static void bench_end_io(blk_request_t* _rq) {
+    auto* thread              = static_cast<bench_thread_t*>(_rq->private_data);
+    auto  slot                = static_cast<size_t>(_rq - thread->rqs);
+    thread->complete_ns[slot] = ktime_get_ns();
+    __atomic_fetch_or(&thread->done_mask, 1ULL << slot, __ATOMIC_RELEASE);
+    if (!thread->polled) {
+        wake_up_all(&thread->done_mask);
+    }
+    return;
+}
+
+/**
+ * @brief 填写槽 _slot 的下一个请求
+ */
+static blk_request_t* bench_prepare(bench_thread_t* _thread, size_t _slot) {
+    auto* bench    = _thread->bench;
+    auto  sectors  = static_cast<uint32_t>(bench->block_size >> SECTOR_SHIFT);
+    auto  blocks   = _thread->bdev->capacity / sectors;
+    auto* rq       = &_thread->rqs[_slot];
+    rq->op         = bench->write ? BLK_OP_WRITE : BLK_OP_READ;
+    rq->nr_sectors = sectors;
+    if (bench->random) {
+        rq->sector = (xorshift64(&_thread->rng) % blocks) * sectors;
+    }
+    else {
+        // 到达设备末尾后回到开头
+        rq->sector           = _thread->next_sector;
+        _thread->next_sector += sectors;
+        if (_thread->next_sector + sectors > blocks * sectors) {
+            _thread->next_sector = 0;
+        }
+    }
+    rq->status       = BLK_STS_OK;
+    rq->end_io       = bench_end_io;
+    rq->private_data = _thread;
+    return rq;
+}
+
+/**
+ * @brief 等待至少一个请求完成，轮询模式下由本线程收取
+ */
+static uint64_t bench_reap(bench_thread_t* _thread) {
+    auto* bdev = _thread->bdev;
+    if (_thread->polled) {
+        while (__atomic_load_n(&_thread->done_mask, __ATOMIC_ACQUIRE) == 0) {
+            bdev->ops->poll(bdev, _thread->hwq);
+        }
+    }
+    else {
+        wait_event(&_thread->done_mask, [_thread] {
+            return __atomic_load_n(&_thread->done_mask, __ATOMIC_ACQUIRE)
+                   != 0;
+        });
+    }
+    return __atomic_exchange_n(&_thread->done_mask, 0, __ATOMIC_ACQUIRE);
+}
+
+static void bench_thread(void* _arg) {
+    auto*          thread = static_cast<bench_thread_t*>(_arg);
+    auto*          bdev   = thread->bdev;
+    auto           all    = (1ULL << thread->bench->iodepth) - 1;
+    // 空闲的槽
+    auto           idle   = all;
+    size_t         issued = 0;
+    blk_request_t* batch[BLK_BENCH_DEPTH_MAX];
+    size_t         slots[BLK_BENCH_DEPTH_MAX];
+    while (thread->completed < thread->ios) {
+        // 填满空闲的槽，一批请求只通知一次设备
+        size_t count = 0;
+        for (auto mask = idle; (mask != 0) && (issued + count < thread->ios);
+             mask      &= mask - 1) {
+            slots[count] = __builtin_ctzll(mask);
+            batch[count] = bench_prepare(thread, slots[count]);
+            count++;
+        }
+        if (count != 0) {
+            auto now = ktime_get_ns();
+            for (size_t i = 0; i < count; i++) {
+                thread->submit_ns[slots[i]] = now;
+            }
+            auto accepted = bdev->ops->queue_rqs(bdev, thread->hwq, batch,
+                                                 count);
+            if (accepted != 0) {
+                bdev->ops->commit(bdev, thread->hwq);
+            }
+            for (size_t i = 0; i < accepted; i++) {
+                idle &= ~(1ULL << slots[i]);
+            }
+            issued += accepted;
+        }
+        if (idle == all) {
+            // 硬件队列被其它 cpu 占满，稍后重试
+            yield();
+            continue;
+        }
+        for (auto done = bench_reap(thread); done != 0; done &= done - 1) {
+            auto slot = __builtin_ctzll(done);
+            auto lat  = thread->complete_ns[slot] - thread->submit_ns[slot];
+            thread->lat_sum += lat;
+            if (lat > thread->lat_max) {
+                thread->lat_max = lat;
+            }
+            thread->hist[hist_bucket(lat)]++;
+            if (thread->rqs[slot].status != BLK_STS_OK) {
+                thread->errors++;
+            }
+            thread->completed++;
+            idle |= 1ULL << slot;
+        }
+    }
+    __atomic_fetch_add(&bench_done, 1, __ATOMIC_RELEASE);
+    wake_up_all(&bench_done);
+    return;
+}
+
+/**
+ * @brief 合并各线程的结果
+ */
+static void bench_collect(blk_bench_t* _bench) {
+    uint64_t lat_sum   = 0;
+    _bench->completed  = 0;
+    _bench->errors     = 0;
+    _bench->lat_max_ns = 0;
+    for (size_t i = 0; i < _bench->threads; i++) {
+        auto* thread      = &bench_threads[i];
+        _bench->completed += thread->completed;
+        _bench->errors    += thread->errors;
+        lat_sum           += thread->lat_sum;
+        if (thread->lat_max > _bench->lat_max_ns) {
+            _bench->lat_max_ns = thread->lat_max;
+        }
+    }
+    if (_bench->completed == 0) {
+        _bench->lat_avg_ns = 0;
+        _bench->iops       = 0;
+        _bench->lat_p50_ns = 0;
+        _bench->lat_p99_ns = 0;
+        return;
+    }
+    _bench->lat_avg_ns = lat_sum / _bench->completed;
+    _bench->iops       = _bench->elapsed_ns == 0
+                           ? 0
+                           : _bench->completed * 1000000000ULL
+                               / _bench->elapsed_ns;
+    // 从直方图中取分位数
+    uint64_t seen      = 0;
+    _bench->lat_p50_ns = 0;
+    _bench->lat_p99_ns = 0;
+    for (size_t b = 0; b < HIST_BUCKETS; b++) {
+        for (size_t i = 0; i < _bench->threads; i++) {
+            seen += bench_threads[i].hist[b];
+        }
+        if ((_bench->lat_p50_ns == 0) && (seen * 2 >= _bench->completed)) {
+            _bench->lat_p50_ns = hist_value(b);
+        }
+        if (seen * 100 >= _bench->completed * 99) {
+            _bench->lat_p99_ns = hist_value(b);
+            break;
+        }
+    }
+    return;
+}
+
+bool blk_bench(blk_dev_t* _bdev, blk_bench_t* _bench) {
+    auto unit    = _bdev->block_size > SECTOR_SIZE ? _bdev->block_size
+                                                   : SECTOR_SIZE;
+    auto sectors = _bench->block_size >> SECTOR_SHIFT;
+    if ((_bench->threads == 0) || (_bench->threads > smp_cpu_count())
+        || (_bench->iodepth == 0) || (_bench->iodepth > BLK_BENCH_DEPTH_MAX)
+        || (_bench->block_size == 0)
+        || (_bench->block_size > BLK_BENCH_BLOCK_MAX)
+        || (_bench->block_size % unit != 0) || (sectors > _bdev->max_sectors)
+        || (_bdev->capacity < sectors) || (_bench->ios == 0)) {
+        return false;
+    }
+    LockGuard<Mutex> guard(bench_lock);
+    bench_done = 0;
+    task_t* tasks[MAX_CPU_COUNT];
+    bool    ok = true;
+    for (size_t i = 0; i < _bench->threads; i++) {
+        auto* thread = &bench_threads[i];
+        memset(thread, 0, sizeof(*thread));
+        thread->bdev   = _bdev;
+        thread->bench  = _bench;
+        thread->hwq    = blk_hw_queue(_bdev, i);
+        thread->polled = blk_hw_queue_polled(_bdev, thread->hwq);
+        thread->ios    = _bench->ios;
+        thread->rng    = 0x9E3779B97F4A7C15ULL * (i + 1);
+        // 顺序访问时各线程从设备的不同位置开始
+        thread->next_sector
+          = (_bdev->capacity / sectors / _bench->threads) * i * sectors;
+        for (size_t slot = 0; slot < _bench->iodepth; slot++) {
+            thread->rqs[slot].buffer = bench_buffers[i][slot];
+            if (_bench->write) {
+                memset(bench_buffers[i][slot], static_cast<int>(i + slot),
+                       _bench->block_size);
+            }
+        }
+        tasks[i] = kthread_create(bench_thread, thread, "blk_bench");
+        if (tasks[i] == nullptr) {
+            ok = false;
+        }
+        else {
+            kthread_bind(tasks[i], i);
+        }
+    }
+    if (!ok) {
+        // 已创建的线程不提交请求，直接结束
+        for (size_t i = 0; i < _bench->threads; i++) {
+            bench_threads[i].ios = 0;
+        }
+    }
+    auto   start   = ktime_get_ns();
+    size_t created = 0;
+    for (size_t i = 0; i < _bench->threads; i++) {
+        if (tasks[i] != nullptr) {
+            task_wakeup(tasks[i]);
+            created++;
+        }
+    }
+    wait_event(&bench_done, [created] {
+        return __atomic_load_n(&bench_done, __ATOMIC_ACQUIRE) == created;
+    });
+    _bench->elapsed_ns = ktime_get_ns() - start;
+    bench_collect(_bench);
+    return ok;
+}
@@ -0,0 +1,610 @@
+
+/**
+ * @file bio.cpp
+ * @brief 块层
+ * @author Zone.N (Zone.Niuzh@hotmail.com)
+ * @version 1.0
+ * @date 2026-10-18
+ * @copyright MIT LICENSE
+ * https://github.com/MRNIU/cmake-kernel
+ * @par change log:
+ * <table>
+ * <tr><th>Date<th>Author<th>Description
+ * <tr><td>2026-10-18<td>Zone.N (Zone.Niuzh@hotmail.com)<td>创建文件
+ * </table>
+ */
+
+#include "bio.h"
+
+#include "ktime.h"
+#include "libc.h"
+#include "percpu.h"
+#include "sched.h"
+#include "smp.h"
+#include "spinlock.hpp"
+#include "wait.h"
+
+/// 一次交给驱动的最大请求数
+static constexpr const size_t BLK_DISPATCH_BATCH = 16;
+
+/**
+ * @brief 块层的请求，驱动只看到其中的 rq
+ */
+struct blk_req_t {
+    /// 必须是第一个成员，驱动完成时由 rq 找回 blk_req_t
+    blk_request_t rq;
+    blk_queue_t*  queue;
+    /// 所属的请求池，即分配时的硬件队列
+    size_t        pool;
+    /// 派发到的硬件队列
+    size_t        hwq;
+    /// 第一个 bio 的提交时间
+    uint64_t      start_ns;
+    /// 按扇区顺序排列的 bio
+    bio_t*        bio;
+    bio_t*        biotail;
+    blk_seg_t     segs[BLK_SEG_MAX];
+};
+
+/**
+ * @brief 每个 cpu 的统计，中断与任务都会修改，使用原子操作
+ */
+struct blk_cpu_stats_t {
+    uint64_t ios[BLK_OP_NR];
+    uint64_t sectors[BLK_OP_NR];
+    uint64_t errors;
+    uint64_t bios;
+    uint64_t merges;
+    uint64_t lat_sum;
+    uint64_t lat_max;
+    uint64_t lat_hist[BLK_LAT_BUCKETS];
+    /// 派发次数与派发前的在途请求数之和
+    uint64_t dispatches;
+    uint64_t depth_sum;
+    uint64_t depth_max;
+};
+
+/**
+ * @brief 每个 cpu 的软件队列
+ */
+struct alignas(CACHE_LINE_SIZE) blk_ctx_t {
+    TicketLock                                         lock;
+    /// 等待派发的请求
+    IntrusiveList<blk_request_t, &blk_request_t::node> rqs;
+    blk_cpu_stats_t                                    stats;
+};
+
+/**
+ * @brief 每个硬件队列的状态与请求池
+ */
+struct alignas(CACHE_LINE_SIZE) blk_hctx_t {
+    /// 空闲的请求
+    uint64_t  free_tags;
+    /// 等待空闲请求的任务数
+    uint32_t  waiters;
+    /// 在驱动中的请求数
+    size_t    in_flight;
+    /// 对应的软件队列中等待派发的请求数
+    size_t    queued;
+    blk_req_t rqs[BLK_QUEUE_RQS];
+};
+
+/**
+ * @brief 块设备的队列
+ */
+struct blk_queue_t {
+    blk_dev_t* bdev;
+    blk_ctx_t  ctxs[MAX_CPU_COUNT];
+    blk_hctx_t hctxs[BLK_HW_QUEUE_MAX];
+};
+
+static blk_queue_t blk_queues[BLK_DEV_MAX];
+
+static blk_req_t* to_req(blk_request_t* _rq) {
+    return reinterpret_cast<blk_req_t*>(_rq);
+}
+
+static void atomic_max(uint64_t* _ptr, uint64_t _val) {
+    auto old = __atomic_load_n(_ptr, __ATOMIC_RELAXED);
+    while ((old < _val)
+           && !__atomic_compare_exchange_n(_ptr, &old, _val, true,
+                                           __ATOMIC_RELAXED,
+                                           __ATOMIC_RELAXED)) {
+        ;
+    }
+    return;
+}
+
+static void stat_add(uint64_t* _ptr, uint64_t _val) {
+    __atomic_fetch_add(_ptr, _val, __ATOMIC_RELAXED);
+    return;
+}
+
+static uint64_t stat_read(const uint64_t* _ptr) {
+    return __atomic_load_n(_ptr, __ATOMIC_RELAXED);
+}
+
+static blk_cpu_stats_t* this_cpu_stats(blk_queue_t* _queue) {
+    return &_queue->ctxs[cpu_id()].stats;
+}
+
+/**
+ * @brief 轮询设备的全部轮询队列
+ */
+static void blk_poll_all(blk_dev_t* _bdev) {
+    for (size_t i = 0; i < _bdev->nr_hw_queues; i++) {
+        if (blk_hw_queue_polled(_bdev, i)) {
+            _bdev->ops->poll(_bdev, i);
+        }
+    }
+    return;
+}
+
+/**
+ * @brief 把软件队列中的请求成批交给驱动，一次派发只通知一次设备
+ * 硬件队列满时剩余的请求留在软件队列中，完成时再派发
+ * @param  _queue                  队列
+ * @param  _hwq                    硬件队列
+ */
+static void blk_run_hw_queue(blk_queue_t* _queue, size_t _hwq) {
+    auto*  bdev     = _queue->bdev;
+    auto*  hctx     = &_queue->hctxs[_hwq];
+    auto*  stats    = this_cpu_stats(_queue);
+    size_t accepted = 0;
+    bool   full     = false;
+    // 使用同一硬件队列的 cpu 为 _hwq、_hwq + nr_hw_queues ...
+    for (auto cpu = _hwq; (cpu < MAX_CPU_COUNT) && !full;
+         cpu      += bdev->nr_hw_queues) {
+        auto* ctx = &_queue->ctxs[cpu];
+        IrqLockGuard<TicketLock> guard(ctx->lock);
+        while (!ctx->rqs.empty()) {
+            blk_request_t* batch[BLK_DISPATCH_BATCH];
+            size_t         count = 0;
+            while ((count < BLK_DISPATCH_BATCH) && !ctx->rqs.empty()) {
+                batch[count++] = ctx->rqs.pop_front();
+            }
+            // 其它 cpu 的 commit 会让设备看到这批请求，
+            // 交给驱动前计入在途，请求可能在 queue_rqs 返回前完成
+            auto depth = __atomic_fetch_add(&hctx->in_flight, count,
+                                            __ATOMIC_RELAXED);
+            __atomic_fetch_sub(&hctx->queued, count, __ATOMIC_RELAXED);
+            stat_add(&stats->dispatches, 1);
+            stat_add(&stats->depth_sum, depth);
+            atomic_max(&stats->depth_max, depth);
+            auto n    = bdev->ops->queue_rqs(bdev, _hwq, batch, count);
+            accepted += n;
+            if (n < count) {
+                // 未被接受的按原顺序放回队首
+                __atomic_fetch_sub(&hctx->in_flight, count - n,
+                                   __ATOMIC_RELAXED);
+                __atomic_fetch_add(&hctx->queued, count - n,
+                                   __ATOMIC_RELAXED);
+                for (auto i = count; i > n; i--) {
+                    ctx->rqs.push_front(*batch[i - 1]);
+                }
+                full = true;
+                break;
+            }
+        }
+    }
+    if (accepted != 0) {
+        bdev->ops->commit(bdev, _hwq);
+    }
+    return;
+}
+
+/**
+ * @brief 驱动完成请求时调用，可能在中断上下文中
+ */
+static void blk_rq_end_io(blk_request_t* _rq) {
+    auto* req   = to_req(_rq);
+    auto* queue = req->queue;
+    auto* stats = this_cpu_stats(queue);
+    auto  lat   = ktime_get_ns() - req->start_ns;
+    stat_add(&stats->ios[_rq->op], 1);
+    stat_add(&stats->sectors[_rq->op], _rq->nr_sectors);
+    if (_rq->status != BLK_STS_OK) {
+        stat_add(&stats->errors, 1);
+    }
+    stat_add(&stats->lat_sum, lat);
+    atomic_max(&stats->lat_max, lat);
+    // 桶 b 为 [2^(b-1), 2^b)
+    size_t bucket = lat == 0 ? 0 : 64 - __builtin_clzll(lat);
+    bucket        = bucket < BLK_LAT_BUCKETS ? bucket : BLK_LAT_BUCKETS - 1;
+    stat_add(&stats->lat_hist[bucket], 1);
+
+    // 先取下 bio 并释放请求，回调中可以看到空闲的请求
+    auto* bio    = req->bio;
+    auto  status = _rq->status;
+    auto* hwctx  = &queue->hctxs[req->hwq];
+    auto* pool   = &queue->hctxs[req->pool];
+    auto  tag    = static_cast<size_t>(req - pool->rqs);
+    __atomic_fetch_sub(&hwctx->in_flight, 1, __ATOMIC_RELAXED);
+    __atomic_fetch_or(&pool->free_tags, 1ULL << tag, __ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&pool->waiters, __ATOMIC_SEQ_CST) != 0) {
+        wake_up_all(&pool->free_tags);
+    }
+    while (bio != nullptr) {
+        auto* next  = bio->next;
+        bio->status = status;
+        bio->end_io(bio);
+        bio         = next;
+    }
+    // 硬件队列有了空位，继续派发等待中的请求
+    if (__atomic_load_n(&hwctx->queued, __ATOMIC_RELAXED) != 0) {
+        blk_run_hw_queue(queue, req->hwq);
+    }
+    return;
+}
+
+/**
+ * @brief 从当前 cpu 对应的请求池分配请求，没有空闲的请求时
+ * 先派发暂存的请求再等待
+ */
+static blk_req_t* blk_rq_alloc(blk_queue_t* _queue, bio_t* _bio) {
+    auto* bdev = _queue->bdev;
+    auto  pool = blk_hw_queue(bdev, cpu_id());
+    auto* hctx = &_queue->hctxs[pool];
+    auto  mask = __atomic_load_n(&hctx->free_tags, __ATOMIC_RELAXED);
+    while (true) {
+        if (mask == 0) {
+            blk_flush_plug();
+            if (bdev->poll_queues != 0) {
+                blk_poll_all(bdev);
+            }
+            else {
+                __atomic_fetch_add(&hctx->waiters, 1, __ATOMIC_SEQ_CST);
+                wait_event(&hctx->free_tags, [hctx] {
+                    return __atomic_load_n(&hctx->free_tags, __ATOMIC_SEQ_CST)
+                           != 0;
+                });
+                __atomic_fetch_sub(&hctx->waiters, 1, __ATOMIC_RELAXED);
+            }
+            mask = __atomic_load_n(&hctx->free_tags, __ATOMIC_RELAXED);
+            continue;
+        }
+        auto tag = __builtin_ctzll(mask);
+        if (__atomic_compare_exchange_n(&hctx->free_tags, &mask,
+                                        mask & ~(1ULL << tag), true,
+                                        __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+            auto* req          = &hctx->rqs[tag];
+            req->rq.op         = _bio->op;
+            req->rq.sector     = _bio->sector;
+            req->rq.nr_sectors = _bio->nr_sectors;
+            req->rq.status     = BLK_STS_OK;
+            req->rq.nr_segs    = 0;
+            if (_bio->nr_sectors != 0) {
+                req->segs[0]    = { _bio->buffer,
+                                    _bio->nr_sectors << SECTOR_SHIFT };
+                req->rq.nr_segs = 1;
+            }
+            req->start_ns = ktime_get_ns();
+            req->bio      = _bio;
+            req->biotail  = _bio;
+            return req;
+        }
+    }
+}
+
+/**
+ * @brief 段 _end 结尾处与段 _start 开头处能否相接
+ * @return true                    内存连续，可以直接延长
+ */
+static bool seg_contiguous(const blk_seg_t* _end, const void* _start) {
+    return static_cast<uint8_t*>(_end->buffer) + _end->len == _start;
+}
+
+static bool seg_boundary_ok(const blk_dev_t* _bdev, uintptr_t _end,
+                            uintptr_t _start) {
+    return ((_end | _start) & _bdev->seg_boundary) == 0;
+}
+
+/**
+ * @brief 尝试把 _bio 合并到 _req 的开头或结尾
+ * @return true                    已合并
+ */
+static bool blk_try_merge(blk_req_t* _req, bio_t* _bio) {
+    auto* rq   = &_req->rq;
+    auto* bdev = _bio->bdev;
+    if ((_req->queue != bdev->queue) || (rq->op != _bio->op)
+        || (rq->op == BLK_OP_FLUSH)
+        || (rq->nr_sectors + _bio->nr_sectors > bdev->max_sectors)) {
+        return false;
+    }
+    auto max_segs = bdev->max_segs == 0 ? 1 : bdev->max_segs;
+    auto bytes    = _bio->nr_sectors << SECTOR_SHIFT;
+    auto start    = reinterpret_cast<uintptr_t>(_bio->buffer);
+    if (rq->sector + rq->nr_sectors == _bio->sector) {
+        auto* last = &_req->segs[rq->nr_segs - 1];
+        if (seg_contiguous(last, _bio->buffer)) {
+            last->len += bytes;
+        }
+        else if ((rq->nr_segs < max_segs)
+                 && seg_boundary_ok(
+                   bdev, reinterpret_cast<uintptr_t>(last->buffer) + last->len,
+                   start)) {
+            _req->segs[rq->nr_segs++] = { _bio->buffer, bytes };
+        }
+        else {
+            return false;
+        }
+        _req->biotail->next = _bio;
+        _req->biotail       = _bio;
+    }
+    else if (_bio->sector + _bio->nr_sectors == rq->sector) {
+        auto*     first = &_req->segs[0];
+        blk_seg_t seg   = { _bio->buffer, bytes };
+        if (seg_contiguous(&seg, first->buffer)) {
+            first->buffer  = _bio->buffer;
+            first->len    += bytes;
+        }
+        else if ((rq->nr_segs < max_segs)
+                 && seg_boundary_ok(
+                   bdev, start + bytes,
+                   reinterpret_cast<uintptr_t>(first->buffer))) {
+            memmove(&_req->segs[1], &_req->segs[0],
+                    rq->nr_segs * sizeof(blk_seg_t));
+            _req->segs[0] = { _bio->buffer, bytes };
+            rq->nr_segs++;
+        }
+        else {
+            return false;
+        }
+        _bio->next  = _req->bio;
+        _req->bio   = _bio;
+        rq->sector  = _bio->sector;
+    }
+    else {
+        return false;
+    }
+    rq->nr_sectors += _bio->nr_sectors;
+    stat_add(&this_cpu_stats(_req->queue)->merges, 1);
+    return true;
+}
+
+/**
+ * @brief 把暂存中属于 _queue 的请求放入当前 cpu 的软件队列并派发
+ */
+static void blk_plug_dispatch(blk_plug_t* _plug, blk_queue_t* _queue) {
+    auto  cpu  = cpu_id();
+    auto* ctx  = &_queue->ctxs[cpu];
+    auto  hwq  = blk_hw_queue(_queue->bdev, cpu);
+    auto* hctx = &_queue->hctxs[hwq];
+    {
+        IrqLockGuard<TicketLock> guard(ctx->lock);
+        blk_request_t*           next;
+        for (auto* rq = _plug->rqs.front(); rq != nullptr; rq = next) {
+            next = _plug->rqs.next(*rq);
+            if (to_req(rq)->queue == _queue) {
+                _plug->rqs.erase(*rq);
+                to_req(rq)->hwq = hwq;
+                ctx->rqs.push_back(*rq);
+                __atomic_fetch_add(&hctx->queued, 1, __ATOMIC_RELAXED);
+            }
+        }
+    }
+    blk_run_hw_queue(_queue, hwq);
+    return;
+}
+
+static void blk_plug_flush(blk_plug_t* _plug) {
+    // 一般只有一个设备，每个设备一次派发
+    while (!_plug->rqs.empty()) {
+        blk_plug_dispatch(_plug, to_req(_plug->rqs.front())->queue);
+    }
+    return;
+}
+
+/**
+ * @brief 读写需要按逻辑块对齐且不超出设备，刷新不带数据
+ */
+static bool blk_bio_valid(const blk_dev_t* _bdev, const bio_t* _bio) {
+    if (_bio->op == BLK_OP_FLUSH) {
+        return _bio->nr_sectors == 0;
+    }
+    if ((_bio->op >= BLK_OP_NR) || (_bio->nr_sectors == 0)
+        || (_bio->nr_sectors > _bdev->max_sectors)
+        || (_bio->sector + _bio->nr_sectors > _bdev->capacity)) {
+        return false;
+    }
+    auto unit = _bdev->block_size > SECTOR_SIZE ? _bdev->block_size
+                                                : SECTOR_SIZE;
+    return (((_bio->sector | _bio->nr_sectors) << SECTOR_SHIFT) % unit) == 0;
+}
+
+blk_queue_t* blk_queue_create(blk_dev_t* _bdev, size_t _index) {
+    auto* queue = &blk_queues[_index];
+    queue->bdev = _bdev;
+    for (size_t i = 0; i < _bdev->nr_hw_queues; i++) {
+        auto* hctx      = &queue->hctxs[i];
+        hctx->free_tags = ~0ULL >> (64 - BLK_QUEUE_RQS);
+        for (auto& req : hctx->rqs) {
+            req.queue     = queue;
+            req.pool      = i;
+            req.rq.segs   = req.segs;
+            req.rq.end_io = blk_rq_end_io;
+        }
+    }
+    return queue;
+}
+
+void submit_bio(bio_t* _bio) {
+    auto* bdev = _bio->bdev;
+    _bio->next   = nullptr;
+    _bio->status = BLK_STS_OK;
+    if (!blk_bio_valid(bdev, _bio)) {
+        _bio->status = BLK_STS_IOERR;
+        _bio->end_io(_bio);
+        return;
+    }
+    auto* queue = bdev->queue;
+    stat_add(&this_cpu_stats(queue)->bios, 1);
+
+    auto* plug = current_task()->plug;
+    if (plug != nullptr) {
+        // 最近暂存的请求最可能相邻
+        for (auto* rq = plug->rqs.back(); rq != nullptr;
+             rq       = plug->rqs.prev(*rq)) {
+            if (blk_try_merge(to_req(rq), _bio)) {
+                return;
+            }
+        }
+        auto* req = blk_rq_alloc(queue, _bio);
+        plug->rqs.push_back(req->rq);
+        if (plug->rqs.size() >= BLK_PLUG_MAX) {
+            blk_plug_flush(plug);
+        }
+        return;
+    }
+
+    // 没有暂存时先尝试合并进软件队列中等待派发的请求
+    auto  cpu = cpu_id();
+    auto* ctx = &queue->ctxs[cpu];
+    {
+        IrqLockGuard<TicketLock> guard(ctx->lock);
+        auto*                    last = ctx->rqs.back();
+        if ((last != nullptr) && blk_try_merge(to_req(last), _bio)) {
+            return;
+        }
+    }
+    auto* req = blk_rq_alloc(queue, _bio);
+    auto  hwq = blk_hw_queue(bdev, cpu);
+    {
+        IrqLockGuard<TicketLock> guard(ctx->lock);
+        req->hwq = hwq;
+        ctx->rqs.push_back(req->rq);
+        __atomic_fetch_add(&queue->hctxs[hwq].queued, 1, __ATOMIC_RELAXED);
+    }
+    blk_run_hw_queue(queue, hwq);
+    return;
+}
+
+/**
+ * @brief submit_bio_wait 的完成回调
+ */
+static void bio_wait_end_io(bio_t* _bio) {
+    __atomic_store_n(static_cast<bool*>(_bio->private_data), true,
+                     __ATOMIC_RELEASE);
+    wake_up_all(_bio->private_data);
+    return;
+}
+
+int32_t submit_bio_wait(bio_t* _bio) {
+    bool done          = false;
+    _bio->end_io       = bio_wait_end_io;
+    _bio->private_data = &done;
+    submit_bio(_bio);
+    // 暂存中的请求不会完成，先派发
+    blk_flush_plug();
+    auto* bdev = _bio->bdev;
+    if (bdev->poll_queues != 0) {
+        // 请求可能在任意一个硬件队列上，轮询全部轮询队列
+        while (!__atomic_load_n(&done, __ATOMIC_ACQUIRE)) {
+            blk_poll_all(bdev);
+        }
+    }
+    else {
+        wait_event(&done, [&done] {
+            return __atomic_load_n(&done, __ATOMIC_ACQUIRE);
+        });
+    }
+    return _bio->status;
+}
+
+void blk_start_plug(blk_plug_t* _plug) {
+    auto* task = current_task();
+    if (task->plug == nullptr) {
+        task->plug = _plug;
+    }
+    return;
+}
+
+void blk_finish_plug(blk_plug_t* _plug) {
+    auto* task = current_task();
+    if (task->plug == _plug) {
+        blk_plug_flush(_plug);
+        task->plug = nullptr;
+    }
+    return;
+}
+
+void blk_flush_plug(void) {
+    auto* plug = current_task()->plug;
+    if (plug != nullptr) {
+        blk_plug_flush(plug);
+    }
+    return;
+}
+
+size_t blk_poll(blk_dev_t* _bdev) {
+    auto hwq = blk_hw_queue(_bdev, cpu_id());
+    if (!blk_hw_queue_polled(_bdev, hwq)) {
+        return 0;
+    }
+    return _bdev->ops->poll(_bdev, hwq);
+}
+
+void blk_get_stats(const blk_dev_t* _bdev, blk_stats_t* _stats) {
+    auto*    queue      = _bdev->queue;
+    uint64_t lat_sum    = 0;
+    uint64_t dispatches = 0;
+    uint64_t depth_sum  = 0;
+    uint64_t hist[BLK_LAT_BUCKETS];
+    memset(_stats, 0, sizeof(*_stats));
+    memset(hist, 0, sizeof(hist));
+    for (auto& ctx : queue->ctxs) {
+        auto* stats = &ctx.stats;
+        for (size_t op = 0; op < BLK_OP_NR; op++) {
+            _stats->ios[op]     += stat_read(&stats->ios[op]);
+            _stats->sectors[op] += stat_read(&stats->sectors[op]);
+        }
+        _stats->errors += stat_read(&stats->errors);
+        _stats->bios   += stat_read(&stats->bios);
+        _stats->merges += stat_read(&stats->merges);
+        lat_sum        += stat_read(&stats->lat_sum);
+        dispatches     += stat_read(&stats->dispatches);
+        depth_sum      += stat_read(&stats->depth_sum);
+        for (size_t b = 0; b < BLK_LAT_BUCKETS; b++) {
+            hist[b] += stat_read(&stats->lat_hist[b]);
+        }
+        auto lat_max   = stat_read(&stats->lat_max);
+        auto depth_max = stat_read(&stats->depth_max);
+        if (lat_max > _stats->lat_max_ns) {
+            _stats->lat_max_ns = lat_max;
+        }
+        if (depth_max > _stats->depth_max) {
+            _stats->depth_max = depth_max;
+        }
+    }
+    for (size_t i = 0; i < _bdev->nr_hw_queues; i++) {
+        _stats->in_flight += __atomic_load_n(&queue->hctxs[i].in_flight,
+                                             __ATOMIC_RELAXED);
+        _stats->queued    += __atomic_load_n(&queue->hctxs[i].queued,
+                                             __ATOMIC_RELAXED);
+    }
+    if (dispatches != 0) {
+        _stats->depth_avg = depth_sum / dispatches;
+    }
+
+    uint64_t completed = 0;
+    for (size_t op = 0; op < BLK_OP_NR; op++) {
+        completed += _stats->ios[op];
+    }
+    if (completed == 0) {
+        return;
+    }
+    _stats->lat_avg_ns = lat_sum / completed;
+    // 从直方图中取分位数，取桶的上界
+    uint64_t seen = 0;
+    for (size_t b = 0; b < BLK_LAT_BUCKETS; b++) {
+        seen += hist[b];
+        if ((_stats->lat_p50_ns == 0) && (seen * 2 >= completed)) {
+            _stats->lat_p50_ns = 1ULL << b;
+        }
+        if (seen * 100 >= completed * 99) {
+            _stats->lat_p99_ns = 1ULL << b;
+            break;
+        }
+    }
+    return;
+}
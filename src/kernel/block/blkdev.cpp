@@ -0,0 +1,59 @@
+
+/**
+ * @file blkdev.cpp
+ * @brief 块设备
+ * @author Zone.N (Zone.Niuzh@hotmail.com)
+ * @version 1.0
+ * @date 2026-10-18
+ * @copyright MIT LICENSE
+ * https://github.com/MRNIU/cmake-kernel
+ * @par change log:
+ * <table>
+ * <tr><th>Date<th>Author<th>Description
+ * <tr><td>2026-10-18<td>Zone.N (Zone.Niuzh@hotmail.com)<td>创建文件
+ * </table>
+ */
+
+#include "blkdev.h"
+
+#include "bio.h"
+#include "libc.h"
+#include "spinlock.hpp"
+
+/// 已注册的块设备，只增加不删除
+static TicketLock blk_lock;
+static blk_dev_t* blk_devs[BLK_DEV_MAX];
+static size_t     blk_count;
+
+bool blk_register(blk_dev_t* _bdev) {
+    if ((_bdev->nr_hw_queues == 0)
+        || (_bdev->nr_hw_queues > BLK_HW_QUEUE_MAX)) {
+        return false;
+    }
+    LockGuard<TicketLock> guard(blk_lock);
+    if (blk_count == BLK_DEV_MAX) {
+        return false;
+    }
+    _bdev->queue        = blk_queue_create(_bdev, blk_count);
+    blk_devs[blk_count] = _bdev;
+    // 发布后其它 cpu 可以无锁读取
+    __atomic_store_n(&blk_count, blk_count + 1, __ATOMIC_RELEASE);
+    return true;
+}
+
+blk_dev_t* blk_get(size_t _index) {
+    if (_index >= __atomic_load_n(&blk_count, __ATOMIC_ACQUIRE)) {
+        return nullptr;
+    }
+    return blk_devs[_index];
+}
+
+blk_dev_t* blk_find(const char* _name) {
+    auto count = __atomic_load_n(&blk_count, __ATOMIC_ACQUIRE);
+    for (size_t i = 0; i < count; i++) {
+        if (strcmp(blk_devs[i]->name, _name) == 0) {
+            return blk_devs[i];
+        }
+    }
+    return nullptr;
+}
@@ -0,0 +1,153 @@
+
+/**
+ * @file bio.h
+ * @brief 块层
+ * @author Zone.N (Zone.Niuzh@hotmail.com)
+ * @version 1.0
+ * @date 2026-10-18
+ * @copyright MIT LICENSE
+ * https://github.com/MRNIU/cmake-kernel
+ * @par change log:
+ * <table>
+ * <tr><th>Date<th>Author<th>Description
+ * <tr><td>2026-10-18<td>Zone.N (Zone.Niuzh@hotmail.com)<td>创建文件
+ * </table>
+ */
+
+#ifndef CMAKE_KERNEL_BIO_H
+#define CMAKE_KERNEL_BIO_H
+
+#include "cstddef"
+#include "cstdint"
+
+#include "blkdev.h"
+#include "intrusive_list.hpp"
+
+// 块层位于文件系统与块设备驱动之间。
+// 上层提交 bio，块层把扇区与内存都相邻的 bio 合并成一个请求:
+// 任务开启暂存 (plug) 时请求先留在任务中，结束暂存或积累到
+// BLK_PLUG_MAX 个时放入当前 cpu 的软件队列，再成批派发到
+// 该 cpu 对应的硬件队列，一批只通知一次设备。
+// 硬件队列满时请求留在软件队列中，之后到达的 bio 仍可以合并进去，
+// 硬件队列有请求完成时继续派发
+
+/// 任务暂存的请求数上限，达到时派发
+static constexpr const size_t BLK_PLUG_MAX    = 16;
+/// 每个硬件队列可分配的请求数
+static constexpr const size_t BLK_QUEUE_RQS   = 32;
+static_assert(BLK_QUEUE_RQS <= 64, "request tags are a 64-bit mask");
+/// 延迟直方图的桶数，桶 i 的上界为 2^i 纳秒
+static constexpr const size_t BLK_LAT_BUCKETS = 64;
+
+struct bio_t;
+
+/**
+ * @brief 一次 io，扇区与内存都连续
+ * 由提交者分配，完成前不能释放
+ */
+struct bio_t {
+    blk_dev_t* bdev;
+    /// BLK_OP_*
+    uint32_t   op;
+    /// 扇区数，不超过 bdev->max_sectors，刷新为 0
+    uint32_t   nr_sectors;
+    uint64_t   sector;
+    /// 物理连续的缓冲区
+    void*      buffer;
+    /// 完成时设置，BLK_STS_*
+    int32_t    status;
+    /// 完成回调，可能在中断上下文中执行，不能睡眠或提交新的 bio
+    void       (*end_io)(bio_t* _bio);
+    void*      private_data;
+    /// 同一请求中的下一个 bio，块层使用
+    bio_t*     next;
+};
+
+/**
+ * @brief 任务的请求暂存，在任务的栈上
+ * 暂存期间任务不能等待暂存中的 bio，submit_bio_wait 会先派发
+ */
+struct blk_plug_t {
+    IntrusiveList<blk_request_t, &blk_request_t::node> rqs;
+};
+
+/**
+ * @brief 块设备的统计，所有 cpu 的总和
+ */
+struct blk_stats_t {
+    /// 按 BLK_OP_* 完成的请求数与扇区数
+    uint64_t ios[BLK_OP_NR];
+    uint64_t sectors[BLK_OP_NR];
+    uint64_t errors;
+    /// 提交的 bio 数，其中合并进已有请求的数量
+    uint64_t bios;
+    uint64_t merges;
+    /// 请求从创建到完成的延迟，分位数为 2 的幂精度
+    uint64_t lat_avg_ns;
+    uint64_t lat_p50_ns;
+    uint64_t lat_p99_ns;
+    uint64_t lat_max_ns;
+    /// 当前在硬件队列中与在软件队列中等待的请求数
+    uint64_t in_flight;
+    uint64_t queued;
+    /// 每次派发前硬件队列中已有的请求数的平均值与最大值
+    uint64_t depth_avg;
+    uint64_t depth_max;
+};
+
+/**
+ * @brief 为块设备创建队列，由 blk_register 调用
+ * @param  _bdev                   块设备
+ * @param  _index                  设备的注册序号，小于 BLK_DEV_MAX
+ * @return blk_queue_t*            队列
+ */
+blk_queue_t* blk_queue_create(blk_dev_t* _bdev, size_t _index);
+
+/**
+ * @brief 提交 bio，可能睡眠等待空闲的请求
+ * 参数无效时立即以 BLK_STS_IOERR 完成
+ * @param  _bio                    bio，bdev、op、sector、nr_sectors、
+ *                                 buffer 与 end_io 已填写
+ */
+void         submit_bio(bio_t* _bio);
+
+/**
+ * @brief 提交 bio 并等待完成，不使用 _bio 的 end_io
+ * @param  _bio                    bio
+ * @return int32_t                 BLK_STS_*
+ */
+int32_t      submit_bio_wait(bio_t* _bio);
+
+/**
+ * @brief 开始暂存当前任务提交的 bio，已在暂存时不生效
+ * @param  _plug                   暂存
+ */
+void         blk_start_plug(blk_plug_t* _plug);
+
+/**
+ * @brief 结束暂存并派发暂存的请求
+ * @param  _plug                   blk_start_plug 的参数
+ */
+void         blk_finish_plug(blk_plug_t* _plug);
+
+/**
+ * @brief 派发当前任务暂存的请求，暂存继续有效
+ */
+void         blk_flush_plug(void);
+
+/**
+ * @brief 轮询当前 cpu 对应的硬件队列
+ * 使用轮询队列的异步提交者需要调用
+ * @param  _bdev                   块设备
+ * @return size_t                  完成的请求数
+ */
+size_t       blk_poll(blk_dev_t* _bdev);
+
+/**
+ * @brief 获取统计
+ * @param  _bdev                   块设备
+ * @param  _stats                  输出
+ */
+void         blk_get_stats(const blk_dev_t* _bdev, blk_stats_t* _stats);
+
+#endif /* CMAKE_KERNEL_BIO_H */
@@ -0,0 +1,256 @@
+
+/**
+ * @file blkdev.h
+ * @brief 块设备
+ * @author Zone.N (Zone.Niuzh@hotmail.com)
+ * @version 1.0
+ * @date 2026-10-18
+ * @copyright MIT LICENSE
+ * https://github.com/MRNIU/cmake-kernel
+ * @par change log:
+ * <table>
+ * <tr><th>Date<th>Author<th>Description
+ * <tr><td>2026-10-18<td>Zone.N (Zone.Niuzh@hotmail.com)<td>创建文件
+ * </table>
+ */
+
+#ifndef CMAKE_KERNEL_BLKDEV_H
+#define CMAKE_KERNEL_BLKDEV_H
+
+#include "cstddef"
+#include "cstdint"
+
+#include "driver.h"
+#include "intrusive_list.hpp"
+
+// 块设备驱动提供多个硬件队列，cpu c 使用队列 c % nr_hw_queues。
+// 提交分两步: queue_rqs 把一批请求放入硬件队列但不通知设备，
+// commit 再通知一次，一批请求只需要一次门铃。
+// 使用中断的队列在对应 cpu 的中断上下文中完成请求，
+// 轮询的队列只在 poll 中完成请求，设备可以只轮询部分队列。
+// 上层一般通过块层 (bio.h) 提交 bio，由块层合并成请求后派发
+
+/// 扇区大小，请求的位置与长度都以扇区为单位
+static constexpr const uint32_t SECTOR_SIZE       = 512;
+static constexpr const uint32_t SECTOR_SHIFT      = 9;
+
+/// 请求类型
+static constexpr const uint32_t BLK_OP_READ       = 0;
+static constexpr const uint32_t BLK_OP_WRITE      = 1;
+static constexpr const uint32_t BLK_OP_FLUSH      = 2;
+/// 请求类型数
+static constexpr const uint32_t BLK_OP_NR         = 3;
+
+/// 请求状态
+static constexpr const int32_t  BLK_STS_OK        = 0;
+static constexpr const int32_t  BLK_STS_IOERR     = -1;
+static constexpr const int32_t  BLK_STS_NOTSUPP   = -2;
+
+/// 为 true 时块设备驱动不申请中断，由提交者轮询完成
+#if ENABLE_BLK_POLL == 1
+static constexpr const bool     BLK_POLL          = true;
+#else
+static constexpr const bool     BLK_POLL          = false;
+#endif
+
+/// 块设备数上限
+static constexpr const size_t   BLK_DEV_MAX       = 8;
+/// 每个块设备的硬件队列数上限
+static constexpr const size_t   BLK_HW_QUEUE_MAX  = MAX_CPU_COUNT;
+static_assert(BLK_HW_QUEUE_MAX <= 64, "poll_queues is a 64-bit mask");
+/// 单个请求的段数上限
+static constexpr const uint32_t BLK_SEG_MAX       = 8;
+
+/**
+ * @brief 请求中物理连续的一段数据
+ */
+struct blk_seg_t {
+    void*    buffer;
+    uint32_t len;
+};
+
+/**
+ * @brief 请求，由提交者分配
+ */
+struct blk_request_t {
+    /// 提交者使用的链表节点
+    ListNode         node;
+    /// BLK_OP_*
+    uint32_t         op;
+    uint32_t         nr_sectors;
+    uint64_t         sector;
+    /// 数据缓冲区，物理连续，segs 不为 nullptr 时不使用
+    void*            buffer;
+    /// 多段请求的各段，长度之和为 nr_sectors 个扇区，见 blk_rq_seg
+    const blk_seg_t* segs;
+    uint32_t         nr_segs;
+    /// 完成时设置，BLK_STS_*
+    int32_t          status;
+    /// 完成回调，可能在中断上下文中执行
+    void             (*end_io)(blk_request_t* _rq);
+    void*            private_data;
+};
+
+struct blk_dev_t;
+struct blk_queue_t;
+
+/**
+ * @brief 块设备驱动的操作
+ */
+struct blk_dev_ops_t {
+    /**
+     * @brief 把请求放入硬件队列，不通知设备
+     * @return size_t              接受的请求数，队列满时少于 _count
+     */
+    size_t (*queue_rqs)(blk_dev_t* _bdev, size_t _hwq, blk_request_t** _rqs,
+                        size_t _count);
+    /// 通知设备处理已放入硬件队列的请求
+    void   (*commit)(blk_dev_t* _bdev, size_t _hwq);
+    /**
+     * @brief 收取已完成的请求并调用其 end_io
+     * @return size_t              完成的请求数
+     */
+    size_t (*poll)(blk_dev_t* _bdev, size_t _hwq);
+};
+
+/**
+ * @brief 块设备
+ */
+struct blk_dev_t {
+    const char*          name;
+    device_t*            dev;
+    /// 容量，以扇区为单位
+    uint64_t             capacity;
+    /// 逻辑块大小，请求需要按此对齐
+    uint32_t             block_size;
+    /// 单个请求的最大扇区数
+    uint32_t             max_sectors;
+    /// 单个请求的最大段数，不超过 BLK_SEG_MAX，0 视为 1
+    uint32_t             max_segs;
+    /// 段与段相接处 (前一段的结尾与后一段的开头) 需要按 seg_boundary + 1 对齐
+    uint64_t             seg_boundary;
+    size_t               nr_hw_queues;
+    /// 每个硬件队列能同时容纳的请求数
+    size_t               queue_depth;
+    /// 第 i 位为 1 时队列 i 不产生中断，需要调用 poll 完成请求
+    uint64_t             poll_queues;
+    const blk_dev_ops_t* ops;
+    void*                driver_data;
+    /// 块层的队列，由 blk_register 创建
+    blk_queue_t*         queue;
+};
+
+#if ENABLE_BENCH == 1
+/**
+ * @brief fio 风格的测量参数与结果
+ */
+struct blk_bench_t {
+    /// 线程数，每个线程绑定到一个 cpu，不超过在线 cpu 数
+    size_t   threads;
+    /// 每个线程同时在途的请求数，不超过 BLK_BENCH_DEPTH_MAX
+    size_t   iodepth;
+    /// 每个请求的字节数，不超过 BLK_BENCH_BLOCK_MAX
+    size_t   block_size;
+    /// 每个线程完成的请求数
+    size_t   ios;
+    bool     write;
+    /// 随机或顺序访问
+    bool     random;
+
+    /// 结果: 完成的请求数、失败数与总耗时
+    uint64_t completed;
+    uint64_t errors;
+    uint64_t elapsed_ns;
+    /// 结果: 每秒请求数
+    uint64_t iops;
+    /// 结果: 单个请求的平均、p50、p99 与最大延迟
+    uint64_t lat_avg_ns;
+    uint64_t lat_p50_ns;
+    uint64_t lat_p99_ns;
+    uint64_t lat_max_ns;
+};
+
+/// 测量时每个线程的最大在途请求数
+static constexpr const size_t BLK_BENCH_DEPTH_MAX = 32;
+/// 测量时每个请求的最大字节数
+static constexpr const size_t BLK_BENCH_BLOCK_MAX = 4096;
+#endif
+
+/**
+ * @brief 注册块设备，在驱动的 probe 中调用
+ * @param  _bdev                   已填写的块设备
+ * @return true                    成功
+ * @return false                   块设备数已达上限
+ */
+bool       blk_register(blk_dev_t* _bdev);
+
+/**
+ * @brief 按注册顺序获取块设备
+ * @param  _index                  下标
+ * @return blk_dev_t*              块设备，没有时为 nullptr
+ */
+blk_dev_t* blk_get(size_t _index);
+
+/**
+ * @brief 按名称查找块设备
+ * @param  _name                   名称
+ * @return blk_dev_t*              块设备，没有时为 nullptr
+ */
+blk_dev_t* blk_find(const char* _name);
+
+/**
+ * @brief cpu 使用的硬件队列
+ * @param  _bdev                   块设备
+ * @param  _cpu                    cpu 编号
+ * @return size_t                  队列下标
+ */
+static inline size_t blk_hw_queue(const blk_dev_t* _bdev, size_t _cpu) {
+    return _cpu % _bdev->nr_hw_queues;
+}
+
+/**
+ * @brief 请求的段数
+ * @param  _rq                     请求
+ * @return uint32_t                段数，没有数据的请求也至少为 1
+ */
+static inline uint32_t blk_rq_nr_segs(const blk_request_t* _rq) {
+    return _rq->segs == nullptr ? 1 : _rq->nr_segs;
+}
+
+/**
+ * @brief 请求的第 _index 段
+ * @param  _rq                     请求
+ * @param  _index                  段下标，小于 blk_rq_nr_segs
+ * @return blk_seg_t               段
+ */
+static inline blk_seg_t blk_rq_seg(const blk_request_t* _rq, uint32_t _index) {
+    if (_rq->segs != nullptr) {
+        return _rq->segs[_index];
+    }
+    return { _rq->buffer, _rq->nr_sectors << SECTOR_SHIFT };
+}
+
+/**
+ * @brief 硬件队列是否需要轮询
+ * @param  _bdev                   块设备
+ * @param  _hwq                    队列下标
+ * @return true                    队列不产生中断
+ */
+static inline bool blk_hw_queue_polled(const blk_dev_t* _bdev, size_t _hwq) {
+    return (_bdev->poll_queues & (1ULL << _hwq)) != 0;
+}
+
+#if ENABLE_BENCH == 1
+/**
+ * @brief 在 _bdev 上运行 fio 风格的测量
+ * 线程直接使用驱动的队列，不经过上层的合并与调度，
+ * 写测量会覆盖设备上的数据
+ * @param  _bdev                   块设备
+ * @param  _bench                  参数，返回时填写结果
+ * @return true                    成功
+ * @return false                   参数无效或无法创建线程
+ */
+bool       blk_bench(blk_dev_t* _bdev, blk_bench_t* _bench);
+#endif
+
+#endif /* CMAKE_KERNEL_BLKDEV_H */
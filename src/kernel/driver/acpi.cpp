@@ -0,0 +1,124 @@
+
+/**
+ * @file acpi.cpp
+ * @brief ACPI 表
+ * @author Zone.N (Zone.Niuzh@hotmail.com)
+ * @version 1.0
+ * @date 2026-10-18
+ * @copyright MIT LICENSE
+ * https://github.com/MRNIU/cmake-kernel
+ * @par change log:
+ * <table>
+ * <tr><th>Date<th>Author<th>Description
+ * <tr><td>2026-10-18<td>Zone.N (Zone.Niuzh@hotmail.com)<td>创建文件
+ * </table>
+ */
+
+#include "acpi.h"
+
+#include "libc.h"
+
+/// RSDP 的签名
+static constexpr const char   RSDP_SIGNATURE[] = "RSD PTR ";
+/// ACPI 1.0 的 RSDP 长度
+static constexpr const size_t RSDP_V1_SIZE     = 20;
+/// MCFG 表头之后的保留字节
+static constexpr const size_t MCFG_RESERVED    = 8;
+
+/**
+ * @brief 根系统描述指针
+ */
+struct acpi_rsdp_t {
+    char     signature[8];
+    uint8_t  checksum;
+    char     oem_id[6];
+    uint8_t  revision;
+    uint32_t rsdt_address;
+    /// 以下字段在 revision >= 2 时有效
+    uint32_t length;
+    uint64_t xsdt_address;
+    uint8_t  extended_checksum;
+    uint8_t  reserved[3];
+} __attribute__((packed));
+
+/// 根表，XSDT 中的项为 64 位，RSDT 中为 32 位
+static const acpi_sdt_header_t* root_table;
+static size_t                   root_entry_size;
+
+static bool checksum_ok(const void* _ptr, size_t _len) {
+    auto*   ptr = static_cast<const uint8_t*>(_ptr);
+    uint8_t sum = 0;
+    for (size_t i = 0; i < _len; i++) {
+        sum += ptr[i];
+    }
+    return sum == 0;
+}
+
+static const acpi_sdt_header_t* table_at(uint64_t _addr) {
+    auto* table = reinterpret_cast<const acpi_sdt_header_t*>(_addr);
+    if ((table == nullptr) || (table->length < sizeof(acpi_sdt_header_t))
+        || !checksum_ok(table, table->length)) {
+        return nullptr;
+    }
+    return table;
+}
+
+bool acpi_init(uintptr_t _rsdp) {
+    auto* rsdp = reinterpret_cast<const acpi_rsdp_t*>(_rsdp);
+    if ((rsdp == nullptr)
+        || (memcmp(rsdp->signature, RSDP_SIGNATURE, sizeof(rsdp->signature))
+            != 0)
+        || !checksum_ok(rsdp, RSDP_V1_SIZE)) {
+        return false;
+    }
+    // 优先使用 XSDT
+    if ((rsdp->revision >= 2) && checksum_ok(rsdp, rsdp->length)
+        && (rsdp->xsdt_address != 0)) {
+        root_table      = table_at(rsdp->xsdt_address);
+        root_entry_size = sizeof(uint64_t);
+    }
+    if (root_table == nullptr) {
+        root_table      = table_at(rsdp->rsdt_address);
+        root_entry_size = sizeof(uint32_t);
+    }
+    return root_table != nullptr;
+}
+
+const acpi_sdt_header_t* acpi_find_table(const char* _signature,
+                                         size_t      _index) {
+    if (root_table == nullptr) {
+        return nullptr;
+    }
+    auto* entries = reinterpret_cast<const uint8_t*>(root_table + 1);
+    auto  count
+      = (root_table->length - sizeof(acpi_sdt_header_t)) / root_entry_size;
+    for (size_t i = 0; i < count; i++) {
+        // 项没有按自然边界对齐
+        uint64_t addr = 0;
+        memcpy(&addr, entries + i * root_entry_size, root_entry_size);
+        auto* table = table_at(addr);
+        if ((table == nullptr)
+            || (memcmp(table->signature, _signature, 4) != 0)) {
+            continue;
+        }
+        if (_index == 0) {
+            return table;
+        }
+        _index--;
+    }
+    return nullptr;
+}
+
+const acpi_mcfg_alloc_t* acpi_mcfg_alloc(size_t _index) {
+    auto* mcfg = acpi_find_table("MCFG", 0);
+    if (mcfg == nullptr) {
+        return nullptr;
+    }
+    auto offset = sizeof(acpi_sdt_header_t) + MCFG_RESERVED
+                  + _index * sizeof(acpi_mcfg_alloc_t);
+    if (offset + sizeof(acpi_mcfg_alloc_t) > mcfg->length) {
+        return nullptr;
+    }
+    return reinterpret_cast<const acpi_mcfg_alloc_t*>(
+      reinterpret_cast<const uint8_t*>(mcfg) + offset);
+}
@@ -1,7 +1,7 @@
 
 /**
  * @file driver.cpp
- * @brief driver cpp
+ * @brief 驱动框架
  * @author Zone.N (Zone.Niuzh@hotmail.com)
  * @version 1.0
  * @date 2023-07-15
@@ -16,14 +16,336 @@
 
 #include "driver.h"
 
-int32_t driver(uint32_t _argc, uint8_t** _argv) {
-    (void)_argc;
-    (void)_argv;
+#include "libc.h"
+#include "sched.h"
+#include "spinlock.hpp"
+#include "wait.h"
 
-    // 进入死循环
-    while (1) {
-        ;
+/// 由链接脚本提供的 .driver_init 段范围
+extern "C" driver_init_t __driver_init_start[];
+extern "C" driver_init_t __driver_init_end[];
+
+/// 驱动框架是否已启动，启动前添加的设备只加入总线
+static bool   driver_started;
+/// 全部级别是否初始化完成
+static bool   driver_init_done;
+/// 已加入工作队列、尚未结束的探测数
+static size_t probe_pending;
+/// 成功绑定的次数，用于判断重试是否有进展
+static size_t probe_bound;
+
+/// 返回 PROBE_DEFER 的设备，有新的绑定后重试
+static TicketLock                                     defer_lock;
+static IntrusiveList<device_t, &device_t::defer_node> defer_list;
+/// 初始化完成后，由新的绑定触发的重试
+static work_t                                         defer_work;
+
+static bool id_is_end(const device_id_t* _id) {
+    return (_id->vendor == 0) && (_id->device == 0) && (_id->class_mask == 0)
+           && (_id->compatible == nullptr);
+}
+
+static bool compatible_match(const device_t* _dev, const char* _compatible) {
+    if (_dev->compatible == nullptr) {
+        return false;
+    }
+    size_t offset = 0;
+    while (offset < _dev->compatible_len) {
+        auto* str = _dev->compatible + offset;
+        if (strcmp(str, _compatible) == 0) {
+            return true;
+        }
+        offset += strlen(str) + 1;
+    }
+    return false;
+}
+
+const device_id_t* device_match_id(const device_t*    _dev,
+                                   const device_id_t* _ids) {
+    for (auto* id = _ids; !id_is_end(id); id++) {
+        if (id->compatible != nullptr) {
+            if (compatible_match(_dev, id->compatible)) {
+                return id;
+            }
+            continue;
+        }
+        if ((id->vendor != DEVICE_ID_ANY) && (id->vendor != _dev->vendor)) {
+            continue;
+        }
+        if ((id->device != DEVICE_ID_ANY) && (id->device != _dev->device)) {
+            continue;
+        }
+        if (((id->class_code ^ _dev->class_code) & id->class_mask) != 0) {
+            continue;
+        }
+        return id;
+    }
+    return nullptr;
+}
+
+static const device_id_t* bus_match(device_t* _dev, driver_t* _drv) {
+    if (_dev->bus->match != nullptr) {
+        return _dev->bus->match(_dev, _drv);
+    }
+    if (_drv->id_table == nullptr) {
+        return nullptr;
+    }
+    return device_match_id(_dev, _drv->id_table);
+}
+
+/**
+ * @brief 未绑定的设备加入工作队列探测，已在探测或已绑定时不做处理
+ * 不会睡眠，可以在持有总线的锁时调用
+ */
+static void probe_queue(device_t* _dev) {
+    uint32_t expected = DEVICE_UNBOUND;
+    if (!__atomic_compare_exchange_n(&_dev->state, &expected, DEVICE_PROBING,
+                                     false, __ATOMIC_ACQ_REL,
+                                     __ATOMIC_RELAXED)) {
+        return;
+    }
+    __atomic_add_fetch(&probe_pending, 1, __ATOMIC_RELAXED);
+    queue_work(&system_unbound_wq, &_dev->probe_work);
+    return;
+}
+
+static void probe_done(void) {
+    if (__atomic_sub_fetch(&probe_pending, 1, __ATOMIC_ACQ_REL) == 0) {
+        wake_up_all(&probe_pending);
+    }
+    return;
+}
+
+static void probe_wait(void) {
+    wait_event(&probe_pending, [] {
+        return __atomic_load_n(&probe_pending, __ATOMIC_ACQUIRE) == 0;
+    });
+    return;
+}
+
+/**
+ * @brief 重新探测全部等待重试的设备
+ * @return true                    有等待重试的设备
+ */
+static bool probe_retry_deferred(void) {
+    IrqLockGuard<TicketLock> guard(defer_lock);
+    if (defer_list.empty()) {
+        return false;
+    }
+    // 重新探测时不会在持有锁期间再次加入，循环一定结束
+    while (auto* dev = defer_list.pop_front()) {
+        probe_queue(dev);
+    }
+    return true;
+}
+
+static void defer_work_func(work_t* _work) {
+    (void)_work;
+    probe_retry_deferred();
+    return;
+}
+
+/**
+ * @brief 从 _drv 之后的驱动开始依次尝试，直到有驱动绑定
+ * @param  _dev                    设备
+ * @param  _last                   上次尝试的最后一个驱动，更新为本次的
+ * @return int32_t                 绑定成功返回 PROBE_OK，
+ *                                 有驱动要求重试返回 PROBE_DEFER
+ */
+static int32_t device_attach(device_t* _dev, driver_t** _last) {
+    auto*     bus    = _dev->bus;
+    int32_t   result = PROBE_ERROR;
+    driver_t* drv    = nullptr;
+    while (true) {
+        {
+            LockGuard<Mutex> guard(bus->lock);
+            drv = *_last == nullptr ? bus->drivers.front()
+                                    : bus->drivers.next(**_last);
+        }
+        if (drv == nullptr) {
+            break;
+        }
+        *_last   = drv;
+        auto* id = bus_match(_dev, drv);
+        if (id == nullptr) {
+            continue;
+        }
+        _dev->driver = drv;
+        _dev->id     = id;
+        auto ret     = drv->probe(_dev, id);
+        if (ret == PROBE_OK) {
+            return PROBE_OK;
+        }
+        _dev->driver      = nullptr;
+        _dev->id          = nullptr;
+        _dev->driver_data = nullptr;
+        if (ret == PROBE_DEFER) {
+            result = PROBE_DEFER;
+        }
+    }
+    return result;
+}
+
+static void probe_work_func(work_t* _work) {
+    auto* dev = reinterpret_cast<device_t*>(
+      reinterpret_cast<uintptr_t>(_work) - offsetof(device_t, probe_work));
+    auto*     bus      = dev->bus;
+    driver_t* last     = nullptr;
+    bool      bound    = false;
+    bool      deferred = false;
+    while (true) {
+        uint64_t generation;
+        {
+            LockGuard<Mutex> guard(bus->lock);
+            generation = bus->generation;
+        }
+        auto ret = device_attach(dev, &last);
+        if (ret == PROBE_OK) {
+            __atomic_store_n(&dev->state, DEVICE_BOUND, __ATOMIC_RELEASE);
+            __atomic_add_fetch(&probe_bound, 1, __ATOMIC_RELAXED);
+            bound = true;
+            break;
+        }
+        deferred = deferred || (ret == PROBE_DEFER);
+        LockGuard<Mutex> guard(bus->lock);
+        // 探测期间注册的驱动看到设备正在探测，由这里继续尝试
+        if (bus->generation == generation) {
+            if (deferred) {
+                IrqLockGuard<TicketLock> defer_guard(defer_lock);
+                defer_list.push_back(*dev);
+            }
+            // 之后 dev 可能被移除，不再访问
+            __atomic_store_n(&dev->state, DEVICE_UNBOUND, __ATOMIC_RELEASE);
+            break;
+        }
+    }
+    wake_up_all(&dev->state);
+    // 初始化完成后，新的绑定可能满足了等待重试的设备的依赖
+    if (bound && __atomic_load_n(&driver_init_done, __ATOMIC_ACQUIRE)) {
+        queue_work(&system_unbound_wq, &defer_work);
+    }
+    probe_done();
+    return;
+}
+
+void device_init(device_t* _dev, const char* _name, bus_t* _bus,
+                 device_t* _parent) {
+    _dev->name           = _name;
+    _dev->bus            = _bus;
+    _dev->parent         = _parent;
+    _dev->vendor         = 0;
+    _dev->device         = 0;
+    _dev->class_code     = 0;
+    _dev->compatible     = nullptr;
+    _dev->compatible_len = 0;
+    _dev->state          = DEVICE_UNBOUND;
+    _dev->driver         = nullptr;
+    _dev->id             = nullptr;
+    _dev->driver_data    = nullptr;
+    work_init(&_dev->probe_work, probe_work_func);
+    return;
+}
+
+void device_add(device_t* _dev) {
+    LockGuard<Mutex> guard(_dev->bus->lock);
+    _dev->bus->devices.push_back(*_dev);
+    if (__atomic_load_n(&driver_started, __ATOMIC_ACQUIRE)) {
+        probe_queue(_dev);
+    }
+    return;
+}
+
+static void defer_remove(device_t* _dev) {
+    IrqLockGuard<TicketLock> guard(defer_lock);
+    if (_dev->defer_node.is_linked()) {
+        defer_list.erase(*_dev);
+    }
+    return;
+}
+
+void device_remove(device_t* _dev) {
+    {
+        LockGuard<Mutex> guard(_dev->bus->lock);
+        _dev->bus->devices.erase(*_dev);
     }
+    // 不在总线与重试链表中后不会再有新的探测，等正在进行的探测结束，
+    // 它可能再次把设备加入重试链表
+    defer_remove(_dev);
+    wait_event(&_dev->state, [_dev] {
+        return __atomic_load_n(&_dev->state, __ATOMIC_ACQUIRE)
+               != DEVICE_PROBING;
+    });
+    defer_remove(_dev);
+    if ((_dev->state == DEVICE_BOUND) && (_dev->driver->remove != nullptr)) {
+        _dev->driver->remove(_dev);
+    }
+    _dev->driver      = nullptr;
+    _dev->id          = nullptr;
+    _dev->driver_data = nullptr;
+    _dev->state       = DEVICE_UNBOUND;
+    return;
+}
+
+void driver_register(driver_t* _drv) {
+    auto*            bus = _drv->bus;
+    LockGuard<Mutex> guard(bus->lock);
+    bus->drivers.push_back(*_drv);
+    bus->generation++;
+    if (!__atomic_load_n(&driver_started, __ATOMIC_ACQUIRE)) {
+        return;
+    }
+    for (auto& dev : bus->devices) {
+        probe_queue(&dev);
+    }
+    return;
+}
+
+/**
+ * @brief 等待本级别的探测全部结束，之后只要有新的绑定就重试等待的设备
+ */
+static void probe_settle(void) {
+    probe_wait();
+    auto last_bound = SIZE_MAX;
+    while (true) {
+        auto bound = __atomic_load_n(&probe_bound, __ATOMIC_RELAXED);
+        if ((bound == last_bound) || !probe_retry_deferred()) {
+            break;
+        }
+        last_bound = bound;
+        probe_wait();
+    }
+    return;
+}
+
+static void driver_init_thread(void* _arg) {
+    (void)_arg;
+    __atomic_store_n(&driver_started, true, __ATOMIC_RELEASE);
+    for (uint32_t level = 0; level < DRIVER_LEVEL_COUNT; level++) {
+        for (auto* init = __driver_init_start; init < __driver_init_end;
+             init++) {
+            if (init->level == level) {
+                driver_register(init->driver);
+            }
+        }
+        probe_settle();
+    }
+    __atomic_store_n(&driver_init_done, true, __ATOMIC_RELEASE);
+    wake_up_all(&driver_init_done);
+    return;
+}
+
+void driver_init(void) {
+    work_init(&defer_work, defer_work_func);
+    if (kthread_run(driver_init_thread, nullptr, "driver_init") == nullptr) {
+        __builtin_trap();
+    }
+    return;
+}
 
-    return 0;
+void driver_wait_init(void) {
+    wait_event(&driver_init_done, [] {
+        return __atomic_load_n(&driver_init_done, __ATOMIC_ACQUIRE);
+    });
+    probe_wait();
+    return;
 }
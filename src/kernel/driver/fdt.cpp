@@ -0,0 +1,262 @@
+
+/**
+ * @file fdt.cpp
+ * @brief 扁平设备树解析
+ * @author Zone.N (Zone.Niuzh@hotmail.com)
+ * @version 1.0
+ * @date 2026-10-18
+ * @copyright MIT LICENSE
+ * https://github.com/MRNIU/cmake-kernel
+ * @par change log:
+ * <table>
+ * <tr><th>Date<th>Author<th>Description
+ * <tr><td>2026-10-18<td>Zone.N (Zone.Niuzh@hotmail.com)<td>创建文件
+ * </table>
+ */
+
+#include "fdt.h"
+
+#include "libc.h"
+
+/// 头部魔数
+static constexpr const uint32_t FDT_MAGIC      = 0xD00DFEED;
+/// 支持的最低版本
+static constexpr const uint32_t FDT_VERSION    = 17;
+/// 结构块中的标记
+static constexpr const uint32_t FDT_BEGIN_NODE = 1;
+static constexpr const uint32_t FDT_END_NODE   = 2;
+static constexpr const uint32_t FDT_PROP       = 3;
+static constexpr const uint32_t FDT_NOP        = 4;
+static constexpr const uint32_t FDT_END        = 9;
+/// 查找父节点时支持的最大深度
+static constexpr const int32_t  FDT_MAX_DEPTH  = 32;
+
+/**
+ * @brief 设备树头部，大端存储
+ */
+struct fdt_header_t {
+    uint32_t magic;
+    uint32_t totalsize;
+    uint32_t off_dt_struct;
+    uint32_t off_dt_strings;
+    uint32_t off_mem_rsvmap;
+    uint32_t version;
+    uint32_t last_comp_version;
+    uint32_t boot_cpuid_phys;
+    uint32_t size_dt_strings;
+    uint32_t size_dt_struct;
+};
+
+/// 结构块与字符串块
+static const uint8_t* fdt_struct;
+static uint32_t       fdt_struct_size;
+static const char*    fdt_strings;
+static uint32_t       fdt_strings_size;
+
+static uint32_t be32(const void* _ptr) {
+    uint32_t val;
+    memcpy(&val, _ptr, sizeof(val));
+    return __builtin_bswap32(val);
+}
+
+static uint32_t align4(uint32_t _off) {
+    return (_off + 3) & ~3U;
+}
+
+/**
+ * @brief 读取 _off 处的标记，并计算下一个标记的偏移
+ * @param  _off                    标记的偏移
+ * @param  _next                   下一个标记的偏移
+ * @return uint32_t                标记，越界时为 FDT_END
+ */
+static uint32_t next_tag(uint32_t _off, uint32_t* _next) {
+    if (_off + 4 > fdt_struct_size) {
+        return FDT_END;
+    }
+    auto tag = be32(fdt_struct + _off);
+    _off     += 4;
+    if (tag == FDT_BEGIN_NODE) {
+        auto* name = reinterpret_cast<const char*>(fdt_struct + _off);
+        _off       += strlen(name) + 1;
+    }
+    else if (tag == FDT_PROP) {
+        if (_off + 8 > fdt_struct_size) {
+            return FDT_END;
+        }
+        _off += 8 + be32(fdt_struct + _off);
+    }
+    *_next = align4(_off);
+    return *_next > fdt_struct_size ? FDT_END : tag;
+}
+
+bool fdt_init(const void* _blob) {
+    if (_blob == nullptr) {
+        return false;
+    }
+    auto* header = static_cast<const fdt_header_t*>(_blob);
+    if ((be32(&header->magic) != FDT_MAGIC)
+        || (be32(&header->last_comp_version) > FDT_VERSION)) {
+        return false;
+    }
+    auto* base       = static_cast<const uint8_t*>(_blob);
+    fdt_struct       = base + be32(&header->off_dt_struct);
+    fdt_struct_size  = be32(&header->size_dt_struct);
+    fdt_strings      = reinterpret_cast<const char*>(
+      base + be32(&header->off_dt_strings));
+    fdt_strings_size = be32(&header->size_dt_strings);
+    return true;
+}
+
+int32_t fdt_next_node(int32_t _node, int32_t* _depth) {
+    if (fdt_struct == nullptr) {
+        return -1;
+    }
+    uint32_t off = 0;
+    if (_node < 0) {
+        *_depth = -1;
+    }
+    else {
+        // 跳过当前节点的开始标记
+        next_tag(_node, &off);
+    }
+    while (true) {
+        uint32_t next;
+        auto     tag = next_tag(off, &next);
+        if (tag == FDT_BEGIN_NODE) {
+            (*_depth)++;
+            return static_cast<int32_t>(off);
+        }
+        if (tag == FDT_END_NODE) {
+            (*_depth)--;
+        }
+        else if ((tag != FDT_PROP) && (tag != FDT_NOP)) {
+            return -1;
+        }
+        off = next;
+    }
+}
+
+/**
+ * @brief 以 '\0' 分隔的字符串列表是否包含 _str
+ */
+static bool stringlist_contains(const char* _list, size_t _len,
+                                const char* _str) {
+    size_t offset = 0;
+    while (offset < _len) {
+        auto* item = _list + offset;
+        if (strcmp(item, _str) == 0) {
+            return true;
+        }
+        offset += strlen(item) + 1;
+    }
+    return false;
+}
+
+int32_t fdt_find_compatible(int32_t _node, const char* _compatible) {
+    int32_t depth = 0;
+    auto    node  = fdt_next_node(_node, &depth);
+    while (node >= 0) {
+        size_t len;
+        auto*  prop = fdt_get_prop(node, "compatible", &len);
+        if ((prop != nullptr)
+            && stringlist_contains(static_cast<const char*>(prop), len,
+                                   _compatible)) {
+            return node;
+        }
+        node = fdt_next_node(node, &depth);
+    }
+    return -1;
+}
+
+int32_t fdt_parent(int32_t _node) {
+    int32_t stack[FDT_MAX_DEPTH];
+    int32_t depth = 0;
+    auto    node  = fdt_next_node(-1, &depth);
+    while ((node >= 0) && (depth < FDT_MAX_DEPTH)) {
+        stack[depth] = node;
+        if (node == _node) {
+            return depth == 0 ? -1 : stack[depth - 1];
+        }
+        node = fdt_next_node(node, &depth);
+    }
+    return -1;
+}
+
+const char* fdt_node_name(int32_t _node) {
+    return reinterpret_cast<const char*>(fdt_struct + _node + 4);
+}
+
+const void* fdt_get_prop(int32_t _node, const char* _name, size_t* _len) {
+    if ((fdt_struct == nullptr) || (_node < 0)) {
+        return nullptr;
+    }
+    uint32_t off;
+    next_tag(_node, &off);
+    while (true) {
+        uint32_t next;
+        auto     tag = next_tag(off, &next);
+        if (tag == FDT_PROP) {
+            auto len     = be32(fdt_struct + off + 4);
+            auto nameoff = be32(fdt_struct + off + 8);
+            if ((nameoff < fdt_strings_size)
+                && (strcmp(fdt_strings + nameoff, _name) == 0)) {
+                if (_len != nullptr) {
+                    *_len = len;
+                }
+                return fdt_struct + off + 12;
+            }
+        }
+        else if (tag != FDT_NOP) {
+            // 属性都在子节点之前
+            return nullptr;
+        }
+        off = next;
+    }
+}
+
+uint32_t fdt_cell(const void* _prop, size_t _index) {
+    return be32(static_cast<const uint8_t*>(_prop) + _index * 4);
+}
+
+uint64_t fdt_cells(const void* _prop, size_t _index, uint32_t _cells) {
+    uint64_t val = 0;
+    for (uint32_t i = 0; i < _cells; i++) {
+        val = (val << 32) | fdt_cell(_prop, _index + i);
+    }
+    return val;
+}
+
+void fdt_cells_of(int32_t _node, uint32_t* _address_cells,
+                  uint32_t* _size_cells) {
+    auto* ac        = fdt_get_prop(_node, "#address-cells", nullptr);
+    auto* sc        = fdt_get_prop(_node, "#size-cells", nullptr);
+    *_address_cells = ac == nullptr ? 2 : fdt_cell(ac, 0);
+    *_size_cells    = sc == nullptr ? 1 : fdt_cell(sc, 0);
+    return;
+}
+
+bool fdt_get_reg(int32_t _node, size_t _index, uint64_t* _base,
+                 uint64_t* _size) {
+    size_t len;
+    auto*  reg = fdt_get_prop(_node, "reg", &len);
+    if (reg == nullptr) {
+        return false;
+    }
+    uint32_t address_cells;
+    uint32_t size_cells;
+    fdt_cells_of(fdt_parent(_node), &address_cells, &size_cells);
+    auto cells = address_cells + size_cells;
+    if ((cells == 0) || ((_index + 1) * cells * 4 > len)) {
+        return false;
+    }
+    *_base = fdt_cells(reg, _index * cells, address_cells);
+    *_size = fdt_cells(reg, _index * cells + address_cells, size_cells);
+    return true;
+}
+
+bool fdt_node_available(int32_t _node) {
+    auto* status = static_cast<const char*>(
+      fdt_get_prop(_node, "status", nullptr));
+    return (status == nullptr) || (strcmp(status, "okay") == 0)
+           || (strcmp(status, "ok") == 0);
+}
@@ -0,0 +1,79 @@
+
+/**
+ * @file acpi.h
+ * @brief ACPI 表
+ * @author Zone.N (Zone.Niuzh@hotmail.com)
+ * @version 1.0
+ * @date 2026-10-18
+ * @copyright MIT LICENSE
+ * https://github.com/MRNIU/cmake-kernel
+ * @par change log:
+ * <table>
+ * <tr><th>Date<th>Author<th>Description
+ * <tr><td>2026-10-18<td>Zone.N (Zone.Niuzh@hotmail.com)<td>创建文件
+ * </table>
+ */
+
+#ifndef CMAKE_KERNEL_ACPI_H
+#define CMAKE_KERNEL_ACPI_H
+
+#include "cstddef"
+#include "cstdint"
+
+// 只读地访问固件提供的 ACPI 表，不解释 AML。
+// 表位于物理内存中，内核恒等映射物理内存，可以直接访问
+
+/**
+ * @brief 系统描述表的公共头部
+ */
+struct acpi_sdt_header_t {
+    char     signature[4];
+    uint32_t length;
+    uint8_t  revision;
+    uint8_t  checksum;
+    char     oem_id[6];
+    char     oem_table_id[8];
+    uint32_t oem_revision;
+    uint32_t creator_id;
+    uint32_t creator_revision;
+} __attribute__((packed));
+
+/**
+ * @brief MCFG 表中的一项，描述一个段的 ECAM 配置空间
+ */
+struct acpi_mcfg_alloc_t {
+    /// ECAM 基地址，对应 bus 0
+    uint64_t base;
+    /// pci 段号
+    uint16_t segment;
+    /// 总线范围
+    uint8_t  bus_start;
+    uint8_t  bus_end;
+    uint32_t reserved;
+} __attribute__((packed));
+
+/**
+ * @brief 从 RSDP 找到根表
+ * @param  _rsdp                   RSDP 的物理地址，为 0 时没有 ACPI
+ * @return true                    成功
+ * @return false                   RSDP 或根表无效
+ */
+bool                     acpi_init(uintptr_t _rsdp);
+
+/**
+ * @brief 查找表
+ * @param  _signature              4 字符签名，如 "MCFG"
+ * @param  _index                  同一签名的第几个表
+ * @return const acpi_sdt_header_t* 校验通过的表，没有时为 nullptr
+ */
+const acpi_sdt_header_t* acpi_find_table(const char* _signature,
+                                         size_t      _index);
+
+/**
+ * @brief MCFG 表的第 _index 项
+ * @param  _index                  下标
+ * @return const acpi_mcfg_alloc_t* 配置空间描述，没有时为 nullptr
+ */
+const acpi_mcfg_alloc_t* acpi_mcfg_alloc(size_t _index);
+
+#endif /* CMAKE_KERNEL_ACPI_H */
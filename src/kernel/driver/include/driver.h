@@ -1,7 +1,7 @@
 
 /**
  * @file driver.h
- * @brief driver 头文件
+ * @brief 驱动框架
  * @author Zone.N (Zone.Niuzh@hotmail.com)
  * @version 1.0
  * @date 2023-07-15
@@ -17,14 +17,202 @@
 #ifndef CMAKE_KERNEL_DRIVER_H
 #define CMAKE_KERNEL_DRIVER_H
 
+#include "cstddef"
 #include "cstdint"
 
+#include "intrusive_list.hpp"
+#include "mutex.h"
+#include "workqueue.h"
+
+// 驱动通过 DRIVER_INIT 放入 .driver_init 段，driver_init 按级别注册。
+// 同一级别的驱动全部注册后，与总线上未绑定的设备匹配，
+// 每个待探测的设备作为一个工作项在非绑定线程池中并行探测，
+// 该级别的全部探测结束后才开始下一级别。
+// 总线的探测函数可以添加设备，新设备与已注册的驱动匹配后同样并行探测
+
+/// 初始化级别: 核心设施，如中断控制器
+static constexpr const uint32_t DRIVER_LEVEL_CORE   = 0;
+/// 初始化级别: 总线，探测时发现并添加设备
+static constexpr const uint32_t DRIVER_LEVEL_BUS    = 1;
+/// 初始化级别: 一般设备
+static constexpr const uint32_t DRIVER_LEVEL_DEVICE = 2;
+/// 初始化级别: 依赖其它设备的驱动
+static constexpr const uint32_t DRIVER_LEVEL_LATE   = 3;
+/// 初始化级别数
+static constexpr const uint32_t DRIVER_LEVEL_COUNT  = 4;
+
+/// 匹配任意厂商号或设备号
+static constexpr const uint32_t DEVICE_ID_ANY       = UINT32_MAX;
+
+/// probe 返回值: 成功
+static constexpr const int32_t  PROBE_OK            = 0;
+/// probe 返回值: 依赖的设备尚未就绪，之后重试
+static constexpr const int32_t  PROBE_DEFER         = 1;
+/// probe 返回值: 失败
+static constexpr const int32_t  PROBE_ERROR         = -1;
+
+/// 设备状态: 未绑定驱动
+static constexpr const uint32_t DEVICE_UNBOUND      = 0;
+/// 设备状态: 正在探测
+static constexpr const uint32_t DEVICE_PROBING      = 1;
+/// 设备状态: 已绑定驱动
+static constexpr const uint32_t DEVICE_BOUND        = 2;
+
+struct bus_t;
+struct driver_t;
+
+/**
+ * @brief 设备标识，驱动以全零项结尾的数组声明支持的设备
+ */
+struct device_id_t {
+    /// 厂商号，DEVICE_ID_ANY 匹配任意值
+    uint32_t    vendor;
+    /// 设备号，DEVICE_ID_ANY 匹配任意值
+    uint32_t    device;
+    /// 类别码，只比较 class_mask 中的位
+    uint32_t    class_code;
+    uint32_t    class_mask;
+    /// 设备树 compatible 或 ACPI _HID，为 nullptr 时不比较
+    const char* compatible;
+    /// 驱动私有数据
+    uintptr_t   data;
+};
+
+/**
+ * @brief 设备
+ * 由总线嵌入到自己的设备结构中，不分配内存
+ */
+struct device_t {
+    /// 总线的设备链表
+    ListNode           bus_node;
+    /// 等待重试的链表
+    ListNode           defer_node;
+    const char*        name;
+    bus_t*             bus;
+    device_t*          parent;
+    /// 厂商号、设备号与类别码，总线没有时为 0
+    uint32_t           vendor;
+    uint32_t           device;
+    uint32_t           class_code;
+    /// 以 '\0' 分隔的 compatible 列表及其总长度
+    const char*        compatible;
+    size_t             compatible_len;
+    /// DEVICE_*
+    uint32_t           state;
+    /// 绑定的驱动与匹配的标识
+    driver_t*          driver;
+    const device_id_t* id;
+    /// 驱动私有数据
+    void*              driver_data;
+    /// 异步探测的工作项
+    work_t             probe_work;
+};
+
+/**
+ * @brief 驱动
+ * 只支持编译进内核的驱动，注册后不会注销。
+ * probe 在工作线程中执行，可以睡眠，不同设备的 probe 可能并发执行，
+ * 返回 PROBE_*；remove 可以为 nullptr
+ */
+struct driver_t {
+    /// 总线的驱动链表
+    ListNode           bus_node;
+    const char*        name;
+    bus_t*             bus;
+    /// 支持的设备，以全零项结尾
+    const device_id_t* id_table;
+    int32_t            (*probe)(device_t* _dev, const device_id_t* _id);
+    void               (*remove)(device_t* _dev);
+};
+
+/**
+ * @brief 总线
+ * match 返回匹配的标识，不匹配时为 nullptr，为 nullptr 时使用
+ * device_match_id 匹配驱动的标识表
+ */
+struct bus_t {
+    const char*        name;
+    const device_id_t* (*match)(device_t* _dev, driver_t* _drv);
+
+    /// 保护设备与驱动链表
+    Mutex                                        lock;
+    IntrusiveList<device_t, &device_t::bus_node> devices;
+    IntrusiveList<driver_t, &driver_t::bus_node> drivers;
+    /// 每次注册驱动时加一，探测期间有新驱动时重新匹配
+    uint64_t                                     generation;
+};
+
+/**
+ * @brief .driver_init 段中的一项
+ */
+struct driver_init_t {
+    driver_t* driver;
+    /// DRIVER_LEVEL_*
+    uint32_t  level;
+};
+
+/**
+ * @brief 在 _level 级别注册驱动 _driver
+ * 按结构大小对齐，段中的各项之间没有填充，可以作为数组遍历
+ * @param  _driver                 driver_t 变量名
+ * @param  _level                  DRIVER_LEVEL_*
+ */
+#define DRIVER_INIT(_driver, _level)                                           \
+    static driver_init_t _driver##_init                                        \
+      __attribute__((used, section(".driver_init"),                            \
+                     aligned(sizeof(driver_init_t))))                          \
+      = { &(_driver), (_level) }
+
+/**
+ * @brief 按设备的厂商号、设备号、类别码与 compatible 匹配标识表
+ * @param  _dev                    设备
+ * @param  _ids                    以全零项结尾的标识表
+ * @return const device_id_t*      第一个匹配的标识，没有时为 nullptr
+ */
+const device_id_t* device_match_id(const device_t*    _dev,
+                                   const device_id_t* _ids);
+
+/**
+ * @brief 初始化设备
+ * @param  _dev                    设备
+ * @param  _name                   名称，不复制
+ * @param  _bus                    所在总线
+ * @param  _parent                 父设备，没有时为 nullptr
+ */
+void               device_init(device_t* _dev, const char* _name, bus_t* _bus,
+                               device_t* _parent);
+
+/**
+ * @brief 添加设备到总线，驱动框架启动后立即开始异步探测
+ * @param  _dev                    已初始化的设备
+ */
+void               device_add(device_t* _dev);
+
+/**
+ * @brief 从总线移除设备，等待正在进行的探测结束，已绑定时调用 remove
+ * 不能在设备自己的 probe 中调用
+ * @param  _dev                    设备
+ */
+void               device_remove(device_t* _dev);
+
+/**
+ * @brief 注册驱动，驱动框架启动后与总线上未绑定的设备匹配
+ * 一般通过 DRIVER_INIT 注册，也可以在运行时直接调用
+ * @param  _drv                    驱动
+ */
+void               driver_register(driver_t* _drv);
+
+/**
+ * @brief 启动驱动框架
+ * 创建初始化线程，在其中按级别注册驱动并探测设备后返回，
+ * 由启动 cpu 在 workqueues_init 之后调用
+ */
+void               driver_init(void);
+
 /**
- * @brief 入口
- * @param  _argc                   参数个数
- * @param  _argv                   参数列表
- * @return int32_t                 正常返回 0
+ * @brief 等待全部级别初始化完成，且没有正在进行的探测
+ * 不能在 probe 中调用
  */
-int32_t driver(uint32_t _argc, uint8_t** _argv);
+void               driver_wait_init(void);
 
 #endif /* CMAKE_KERNEL_DRIVER_H */
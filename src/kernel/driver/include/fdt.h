@@ -0,0 +1,118 @@
+
+/**
+ * @file fdt.h
+ * @brief 扁平设备树解析
+ * @author Zone.N (Zone.Niuzh@hotmail.com)
+ * @version 1.0
+ * @date 2026-10-18
+ * @copyright MIT LICENSE
+ * https://github.com/MRNIU/cmake-kernel
+ * @par change log:
+ * <table>
+ * <tr><th>Date<th>Author<th>Description
+ * <tr><td>2026-10-18<td>Zone.N (Zone.Niuzh@hotmail.com)<td>创建文件
+ * </table>
+ */
+
+#ifndef CMAKE_KERNEL_FDT_H
+#define CMAKE_KERNEL_FDT_H
+
+#include "cstddef"
+#include "cstdint"
+
+// 只读地解析扁平设备树 (dtb)，不复制、不分配内存。
+// 节点以其在结构块中的偏移表示，负数表示不存在
+
+/**
+ * @brief 设置要解析的设备树
+ * @param  _blob                   设备树，头部校验失败时忽略
+ * @return true                    成功
+ * @return false                   不是有效的设备树
+ */
+bool        fdt_init(const void* _blob);
+
+/**
+ * @brief 按深度优先顺序的下一个节点
+ * @param  _node                   当前节点，小于 0 时从根节点开始
+ * @param  _depth                  当前深度，返回下一个节点的深度，根为 0
+ * @return int32_t                 下一个节点，没有时为 -1
+ */
+int32_t     fdt_next_node(int32_t _node, int32_t* _depth);
+
+/**
+ * @brief 查找 compatible 包含 _compatible 的下一个节点
+ * @param  _node                   从该节点之后开始查找，小于 0 时从头开始
+ * @param  _compatible             兼容字符串
+ * @return int32_t                 节点，没有时为 -1
+ */
+int32_t     fdt_find_compatible(int32_t _node, const char* _compatible);
+
+/**
+ * @brief 父节点
+ * @param  _node                   节点
+ * @return int32_t                 父节点，根节点没有父节点，返回 -1
+ */
+int32_t     fdt_parent(int32_t _node);
+
+/**
+ * @brief 节点名，包括 @ 之后的单元地址
+ * @param  _node                   节点
+ * @return const char*             节点名
+ */
+const char* fdt_node_name(int32_t _node);
+
+/**
+ * @brief 获取属性
+ * @param  _node                   节点
+ * @param  _name                   属性名
+ * @param  _len                    属性长度，可以为 nullptr
+ * @return const void*             属性值，大端存储，没有时为 nullptr
+ */
+const void* fdt_get_prop(int32_t _node, const char* _name, size_t* _len);
+
+/**
+ * @brief 读取一个大端的 32 位单元
+ * @param  _prop                   属性值
+ * @param  _index                  单元下标
+ * @return uint32_t                单元的值
+ */
+uint32_t    fdt_cell(const void* _prop, size_t _index);
+
+/**
+ * @brief 读取由 _cells 个单元组成的数
+ * @param  _prop                   属性值
+ * @param  _index                  第一个单元的下标
+ * @param  _cells                  单元数，1 或 2
+ * @return uint64_t                数值
+ */
+uint64_t    fdt_cells(const void* _prop, size_t _index, uint32_t _cells);
+
+/**
+ * @brief 节点的子节点使用的地址与长度单元数
+ * @param  _node                   节点
+ * @param  _address_cells          #address-cells，默认为 2
+ * @param  _size_cells             #size-cells，默认为 1
+ */
+void        fdt_cells_of(int32_t _node, uint32_t* _address_cells,
+                         uint32_t* _size_cells);
+
+/**
+ * @brief 读取 reg 属性的第 _index 个区间
+ * @param  _node                   节点
+ * @param  _index                  区间下标
+ * @param  _base                   起始地址
+ * @param  _size                   长度
+ * @return true                    成功
+ * @return false                   没有 reg 属性或下标越界
+ */
+bool        fdt_get_reg(int32_t _node, size_t _index, uint64_t* _base,
+                        uint64_t* _size);
+
+/**
+ * @brief 节点是否可用，status 属性不存在或为 "okay"/"ok"
+ * @param  _node                   节点
+ * @return true                    可用
+ */
+bool        fdt_node_available(int32_t _node);
+
+#endif /* CMAKE_KERNEL_FDT_H */
@@ -0,0 +1,229 @@
+
+/**
+ * @file pci.h
+ * @brief PCIe 总线
+ * @author Zone.N (Zone.Niuzh@hotmail.com)
+ * @version 1.0
+ * @date 2026-10-18
+ * @copyright MIT LICENSE
+ * https://github.com/MRNIU/cmake-kernel
+ * @par change log:
+ * <table>
+ * <tr><th>Date<th>Author<th>Description
+ * <tr><td>2026-10-18<td>Zone.N (Zone.Niuzh@hotmail.com)<td>创建文件
+ * </table>
+ */
+
+#ifndef CMAKE_KERNEL_PCI_H
+#define CMAKE_KERNEL_PCI_H
+
+#include "cstddef"
+#include "cstdint"
+
+#include "driver.h"
+#include "platform.h"
+
+// 通过 ECAM 访问配置空间。主桥是平台总线上 compatible 为
+// "pci-host-ecam-generic" 的设备，来自设备树或 ACPI MCFG 表，
+// 在 DRIVER_LEVEL_BUS 探测时枚举其下的设备并加入 pci_bus。
+// 固件已分配的 BAR 保持不变，未分配的从主桥窗口中分配，
+// 只进入固件已配置的桥，不重新编号总线。
+// 内核恒等映射物理内存，BAR 的 cpu 地址即可直接访问
+
+/// 配置空间寄存器
+static constexpr const uint32_t PCI_VENDOR_ID          = 0x00;
+static constexpr const uint32_t PCI_DEVICE_ID          = 0x02;
+static constexpr const uint32_t PCI_COMMAND            = 0x04;
+static constexpr const uint32_t PCI_STATUS             = 0x06;
+static constexpr const uint32_t PCI_CLASS_REVISION     = 0x08;
+static constexpr const uint32_t PCI_HEADER_TYPE        = 0x0E;
+static constexpr const uint32_t PCI_BAR0               = 0x10;
+static constexpr const uint32_t PCI_SECONDARY_BUS      = 0x19;
+static constexpr const uint32_t PCI_SUBORDINATE_BUS    = 0x1A;
+static constexpr const uint32_t PCI_CAPABILITY_LIST    = 0x34;
+
+/// PCI_COMMAND 中的位
+static constexpr const uint16_t PCI_COMMAND_IO         = 0x0001;
+static constexpr const uint16_t PCI_COMMAND_MEMORY     = 0x0002;
+static constexpr const uint16_t PCI_COMMAND_MASTER     = 0x0004;
+static constexpr const uint16_t PCI_COMMAND_INTX_OFF   = 0x0400;
+
+/// PCI_STATUS 中的位: 有能力链表
+static constexpr const uint16_t PCI_STATUS_CAP_LIST    = 0x0010;
+
+/// PCI_HEADER_TYPE 中的字段
+static constexpr const uint8_t  PCI_HEADER_TYPE_MASK   = 0x7F;
+static constexpr const uint8_t  PCI_HEADER_TYPE_BRIDGE = 0x01;
+static constexpr const uint8_t  PCI_HEADER_MULTI_FUNC  = 0x80;
+
+/// 能力 id
+static constexpr const uint8_t  PCI_CAP_ID_MSI         = 0x05;
+static constexpr const uint8_t  PCI_CAP_ID_VNDR        = 0x09;
+static constexpr const uint8_t  PCI_CAP_ID_EXP         = 0x10;
+static constexpr const uint8_t  PCI_CAP_ID_MSIX        = 0x11;
+
+/// BAR 数
+static constexpr const size_t   PCI_BAR_COUNT          = 6;
+/// BAR 标志
+static constexpr const uint32_t PCI_BAR_IO             = 0x01;
+static constexpr const uint32_t PCI_BAR_MEM64          = 0x04;
+static constexpr const uint32_t PCI_BAR_PREFETCH       = 0x08;
+
+/// 每个设备的中断数上限，每个 cpu 一个队列，再加一个管理中断
+static constexpr const size_t   PCI_IRQ_MAX            = MAX_CPU_COUNT + 1;
+
+/**
+ * @brief 主桥的一个地址窗口
+ * 设备看到的 pci 地址与 cpu 地址之间有固定偏移
+ */
+struct pci_window_t {
+    uint64_t cpu_base;
+    uint64_t pci_base;
+    uint64_t size;
+    /// 下一个可分配的 pci 地址
+    uint64_t next;
+};
+
+/**
+ * @brief 主桥，一个 ECAM 段
+ */
+struct pci_host_t {
+    platform_device_t* pdev;
+    /// bus 0 对应的配置空间地址
+    uintptr_t          ecam;
+    uint16_t           segment;
+    uint8_t            bus_start;
+    uint8_t            bus_end;
+    /// 32 位与 64 位内存窗口，没有时 size 为 0
+    pci_window_t       mem32;
+    pci_window_t       mem64;
+};
+
+/**
+ * @brief 一个 BAR
+ */
+struct pci_bar_t {
+    /// cpu 地址，未分配或为 io 空间时为 0
+    uint64_t base;
+    uint64_t size;
+    /// PCI_BAR_*
+    uint32_t flags;
+};
+
+/**
+ * @brief pci 功能
+ */
+struct pci_device_t {
+    device_t          dev;
+    pci_host_t*       host;
+    /// 配置空间地址
+    uintptr_t         config;
+    uint8_t           bus;
+    uint8_t           slot;
+    uint8_t           func;
+    pci_bar_t         bars[PCI_BAR_COUNT];
+    /// MSI-X 能力的偏移、表项数与表地址，没有时都为 0
+    uint8_t           msix_cap;
+    uint16_t          msix_count;
+    volatile uint8_t* msix_table;
+    /// 每个 MSI-X 表项分配的中断号，0 表示未分配
+    size_t            irqs[PCI_IRQ_MAX];
+    /// "ssss:bb:dd.f"
+    char              name[16];
+};
+
+/// pci 总线，按厂商号、设备号与类别码匹配
+extern bus_t pci_bus;
+
+/**
+ * @brief 从 dev 取得 pci 设备
+ * @param  _dev                    pci 总线上的设备
+ * @return pci_device_t*           pci 设备
+ */
+pci_device_t*  to_pci_device(device_t* _dev);
+
+/**
+ * @brief 读写配置空间
+ * @param  _pdev                   设备
+ * @param  _offset                 寄存器偏移，按访问宽度对齐
+ */
+uint8_t        pci_read8(const pci_device_t* _pdev, uint32_t _offset);
+uint16_t       pci_read16(const pci_device_t* _pdev, uint32_t _offset);
+uint32_t       pci_read32(const pci_device_t* _pdev, uint32_t _offset);
+void           pci_write8(pci_device_t* _pdev, uint32_t _offset, uint8_t _val);
+void           pci_write16(pci_device_t* _pdev, uint32_t _offset,
+                           uint16_t _val);
+void           pci_write32(pci_device_t* _pdev, uint32_t _offset,
+                           uint32_t _val);
+
+/**
+ * @brief 查找能力
+ * @param  _pdev                   设备
+ * @param  _id                     PCI_CAP_ID_*
+ * @param  _start                  从该能力之后开始查找，为 0 时从头开始
+ * @return uint8_t                 能力的偏移，没有时为 0
+ */
+uint8_t        pci_find_capability(const pci_device_t* _pdev, uint8_t _id,
+                                   uint8_t _start);
+
+/**
+ * @brief 打开内存空间访问与总线主控
+ * @param  _pdev                   设备
+ */
+void           pci_enable(pci_device_t* _pdev);
+
+/**
+ * @brief 获取内存 BAR 的地址
+ * @param  _pdev                   设备
+ * @param  _bar                    BAR 下标
+ * @return volatile void*          可以直接访问的地址，io 或未分配时为 nullptr
+ */
+volatile void* pci_iomap(const pci_device_t* _pdev, size_t _bar);
+
+/**
+ * @brief 启用 MSI-X，全部表项初始时屏蔽，同时关闭 INTx
+ * @param  _pdev                   设备
+ * @param  _count                  希望使用的表项数
+ * @return size_t                  可用的表项数，没有 MSI-X 时为 0
+ */
+size_t         pci_msix_enable(pci_device_t* _pdev, size_t _count);
+
+/**
+ * @brief 为 MSI-X 表项分配发往 _cpu 的中断并取消屏蔽
+ * 队列的中断应发往提交该队列请求的 cpu，见 pci_queue_cpu
+ * @param  _pdev                   设备
+ * @param  _index                  表项下标
+ * @param  _cpu                    目标 cpu
+ * @param  _handler                处理函数，在 _cpu 的中断上下文执行
+ * @param  _arg                    处理函数的参数
+ * @return true                    成功
+ * @return false                   没有中断号或架构不支持，驱动需要轮询
+ */
+bool           pci_irq_request(pci_device_t* _pdev, size_t _index, size_t _cpu,
+                               void (*_handler)(void* _arg), void* _arg);
+
+/**
+ * @brief 屏蔽表项并释放中断号
+ * @param  _pdev                   设备
+ * @param  _index                  表项下标
+ */
+void           pci_irq_free(pci_device_t* _pdev, size_t _index);
+
+/**
+ * @brief cpu 使用的队列
+ * 有 _queues 个队列时，cpu c 使用队列 c % _queues
+ * @param  _cpu                    cpu 编号
+ * @param  _queues                 队列数
+ * @return size_t                  队列下标
+ */
+size_t         pci_cpu_queue(size_t _cpu, size_t _queues);
+
+/**
+ * @brief 队列的中断发往的 cpu，是使用该队列的第一个在线 cpu
+ * @param  _queue                  队列下标
+ * @param  _queues                 队列数
+ * @return size_t                  cpu 编号
+ */
+size_t         pci_queue_cpu(size_t _queue, size_t _queues);
+
+#endif /* CMAKE_KERNEL_PCI_H */
@@ -0,0 +1,62 @@
+
+/**
+ * @file platform.h
+ * @brief 平台总线
+ * @author Zone.N (Zone.Niuzh@hotmail.com)
+ * @version 1.0
+ * @date 2026-10-18
+ * @copyright MIT LICENSE
+ * https://github.com/MRNIU/cmake-kernel
+ * @par change log:
+ * <table>
+ * <tr><th>Date<th>Author<th>Description
+ * <tr><td>2026-10-18<td>Zone.N (Zone.Niuzh@hotmail.com)<td>创建文件
+ * </table>
+ */
+
+#ifndef CMAKE_KERNEL_PLATFORM_H
+#define CMAKE_KERNEL_PLATFORM_H
+
+#include "cstddef"
+#include "cstdint"
+
+#include "driver.h"
+
+// 平台总线上的设备来自固件描述: 设备树中可用且有 compatible 的节点，
+// 以及 ACPI MCFG 表中的每个 ECAM 段，后者的 compatible 为
+// "pci-host-ecam-generic"，与设备树中的通用 pci 主桥一致
+
+/// 平台设备数上限
+static constexpr const size_t PLATFORM_DEVICE_MAX = 64;
+
+/**
+ * @brief 平台设备
+ */
+struct platform_device_t {
+    device_t    dev;
+    /// 设备树节点，不是来自设备树时为 -1
+    int32_t     fdt_node;
+    /// 描述该设备的 ACPI 结构，不是来自 ACPI 时为 nullptr
+    const void* acpi;
+    /// 第一个寄存器区间
+    uint64_t    base;
+    uint64_t    size;
+    char        name[32];
+};
+
+/// 平台总线
+extern bus_t platform_bus;
+
+/**
+ * @brief 从 dev 取得平台设备
+ * @param  _dev                    平台总线上的设备
+ * @return platform_device_t*      平台设备
+ */
+platform_device_t* to_platform_device(device_t* _dev);
+
+/**
+ * @brief 解析固件描述并添加平台设备，在 driver_init 之前调用
+ */
+void               platform_init(void);
+
+#endif /* CMAKE_KERNEL_PLATFORM_H */
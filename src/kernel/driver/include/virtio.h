@@ -0,0 +1,280 @@
+
+/**
+ * @file virtio.h
+ * @brief virtio-pci 传输层与 split 虚拟队列
+ * @author Zone.N (Zone.Niuzh@hotmail.com)
+ * @version 1.0
+ * @date 2026-10-18
+ * @copyright MIT LICENSE
+ * https://github.com/MRNIU/cmake-kernel
+ * @par change log:
+ * <table>
+ * <tr><th>Date<th>Author<th>Description
+ * <tr><td>2026-10-18<td>Zone.N (Zone.Niuzh@hotmail.com)<td>创建文件
+ * </table>
+ */
+
+#ifndef CMAKE_KERNEL_VIRTIO_H
+#define CMAKE_KERNEL_VIRTIO_H
+
+#include "cstddef"
+#include "cstdint"
+
+#include "pci.h"
+
+// virtio 1.x 的 pci 传输层 (modern)，不支持 legacy 接口。
+// 虚拟队列使用 split 格式，packed 格式 (VIRTIO_F_RING_PACKED) 未实现，
+// 不协商该特性。队列内存静态分配，内核恒等映射物理内存，
+// 虚拟地址即设备使用的地址。
+// 虚拟队列本身不加锁，由驱动保证同一队列的操作互斥
+
+/// virtio 设备的厂商号
+static constexpr const uint32_t VIRTIO_PCI_VENDOR          = 0x1AF4;
+
+/// 设备状态
+static constexpr const uint8_t  VIRTIO_STATUS_ACKNOWLEDGE  = 0x01;
+static constexpr const uint8_t  VIRTIO_STATUS_DRIVER       = 0x02;
+static constexpr const uint8_t  VIRTIO_STATUS_DRIVER_OK    = 0x04;
+static constexpr const uint8_t  VIRTIO_STATUS_FEATURES_OK  = 0x08;
+static constexpr const uint8_t  VIRTIO_STATUS_NEEDS_RESET  = 0x40;
+static constexpr const uint8_t  VIRTIO_STATUS_FAILED       = 0x80;
+
+/// 与设备类型无关的特性位
+static constexpr const uint32_t VIRTIO_F_INDIRECT_DESC     = 28;
+static constexpr const uint32_t VIRTIO_F_EVENT_IDX         = 29;
+static constexpr const uint32_t VIRTIO_F_VERSION_1         = 32;
+static constexpr const uint32_t VIRTIO_F_RING_PACKED       = 34;
+
+/// 不使用中断的 MSI-X 向量号
+static constexpr const uint16_t VIRTIO_MSI_NO_VECTOR       = 0xFFFF;
+
+/// 描述符标志
+static constexpr const uint16_t VIRTQ_DESC_F_NEXT          = 0x1;
+static constexpr const uint16_t VIRTQ_DESC_F_WRITE         = 0x2;
+/// 驱动不需要中断，协商 EVENT_IDX 后由 used_event 代替
+static constexpr const uint16_t VIRTQ_AVAIL_F_NO_INTERRUPT = 0x1;
+/// 设备不需要通知，协商 EVENT_IDX 后由 avail_event 代替
+static constexpr const uint16_t VIRTQ_USED_F_NO_NOTIFY     = 0x1;
+
+/// 队列的最大描述符数，设备支持的更少时使用设备的值
+static constexpr const uint16_t VIRTQ_SIZE_MAX             = 128;
+/// 全部设备的虚拟队列数上限
+static constexpr const size_t   VIRTQUEUE_MAX              = 32;
+
+struct virtq_desc_t {
+    uint64_t addr;
+    uint32_t len;
+    uint16_t flags;
+    uint16_t next;
+};
+
+/**
+ * @brief 驱动写、设备读的环，ring[size] 为 used_event
+ */
+struct virtq_avail_t {
+    uint16_t flags;
+    uint16_t idx;
+    uint16_t ring[VIRTQ_SIZE_MAX + 1];
+};
+
+struct virtq_used_elem_t {
+    /// 描述符链的头
+    uint32_t id;
+    /// 设备写入的字节数
+    uint32_t len;
+};
+
+/**
+ * @brief 设备写、驱动读的环，ring[size] 之后为 avail_event
+ */
+struct virtq_used_t {
+    uint16_t          flags;
+    uint16_t          idx;
+    virtq_used_elem_t ring[VIRTQ_SIZE_MAX];
+    uint16_t          avail_event;
+};
+
+// 队列最大时 ring[size] 即 avail_event，需要紧接在环之后
+static_assert(offsetof(virtq_used_t, avail_event)
+                == offsetof(virtq_used_t, ring)
+                     + sizeof(virtq_used_elem_t) * VIRTQ_SIZE_MAX,
+              "avail_event must follow the used ring");
+
+/**
+ * @brief virtio-pci 设备
+ */
+struct virtio_device_t {
+    pci_device_t*     pdev;
+    /// 各能力指向的寄存器
+    volatile uint8_t* common;
+    volatile uint8_t* notify;
+    volatile uint8_t* device;
+    uint32_t          notify_multiplier;
+    /// 协商后的特性
+    uint64_t          features;
+};
+
+/**
+ * @brief 一段连续的缓冲区
+ */
+struct virtio_buf_t {
+    const void* addr;
+    uint32_t    len;
+};
+
+/**
+ * @brief split 虚拟队列
+ */
+struct virtqueue_t {
+    virtio_device_t*   vdev;
+    uint16_t           index;
+    uint16_t           size;
+    virtq_desc_t*      desc;
+    virtq_avail_t*     avail;
+    virtq_used_t*      used;
+    volatile uint16_t* notify;
+    /// 空闲描述符通过 next 串成链表
+    uint16_t           free_head;
+    uint16_t           num_free;
+    /// avail->idx 的副本，以及上次通知设备时的值
+    uint16_t           avail_idx;
+    uint16_t           kicked_idx;
+    /// 已收取到的 used->idx
+    uint16_t           last_used;
+    bool               event_idx;
+    /// 为 true 时不请求中断
+    bool               cb_disabled;
+    /// 每个描述符链的头对应的调用者数据
+    void*              tokens[VIRTQ_SIZE_MAX];
+};
+
+/**
+ * @brief 查找 virtio 能力并映射寄存器
+ * @param  _vdev                   设备
+ * @param  _pdev                   pci 设备，需要已分配 BAR
+ * @return true                    成功
+ * @return false                   缺少必需的能力
+ */
+bool         virtio_pci_init(virtio_device_t* _vdev, pci_device_t* _pdev);
+
+/**
+ * @brief 复位设备，等待复位完成
+ * @param  _vdev                   设备
+ */
+void         virtio_reset(virtio_device_t* _vdev);
+
+/**
+ * @brief 在设备状态中加入 _status
+ * @param  _vdev                   设备
+ * @param  _status                 VIRTIO_STATUS_*
+ */
+void         virtio_add_status(virtio_device_t* _vdev, uint8_t _status);
+
+/**
+ * @brief 协商特性，成功后设置 FEATURES_OK
+ * @param  _vdev                   设备
+ * @param  _wanted                 驱动支持的特性，总是包含 VERSION_1
+ * @return true                    成功，结果保存在 _vdev->features
+ * @return false                   设备不接受
+ */
+bool         virtio_negotiate(virtio_device_t* _vdev, uint64_t _wanted);
+
+/**
+ * @brief 是否协商了特性
+ * @param  _vdev                   设备
+ * @param  _bit                    特性位
+ * @return true                    已协商
+ */
+bool         virtio_has_feature(const virtio_device_t* _vdev, uint32_t _bit);
+
+/**
+ * @brief 设备支持的虚拟队列数
+ * @param  _vdev                   设备
+ * @return uint16_t                队列数
+ */
+uint16_t     virtio_num_queues(const virtio_device_t* _vdev);
+
+/**
+ * @brief 设置配置变化中断的向量
+ * @param  _vdev                   设备
+ * @param  _vector                 MSI-X 表项，或 VIRTIO_MSI_NO_VECTOR
+ */
+void         virtio_set_config_vector(virtio_device_t* _vdev, uint16_t _vector);
+
+/**
+ * @brief 设置 DRIVER_OK，之后设备开始处理队列
+ * @param  _vdev                   设备
+ */
+void         virtio_ready(virtio_device_t* _vdev);
+
+/**
+ * @brief 读取设备相关的配置，多次读取直到配置代数不变
+ * @param  _vdev                   设备
+ * @param  _offset                 偏移
+ */
+uint16_t     virtio_config_read16(virtio_device_t* _vdev, uint32_t _offset);
+uint32_t     virtio_config_read32(virtio_device_t* _vdev, uint32_t _offset);
+uint64_t     virtio_config_read64(virtio_device_t* _vdev, uint32_t _offset);
+
+/**
+ * @brief 创建并启用虚拟队列，在 virtio_ready 之前调用
+ * @param  _vdev                   设备
+ * @param  _index                  队列下标
+ * @param  _vector                 完成中断的 MSI-X 表项，不使用时为
+ *                                 VIRTIO_MSI_NO_VECTOR
+ * @return virtqueue_t*            队列，设备不支持或队列池耗尽时为 nullptr
+ */
+virtqueue_t* virtqueue_create(virtio_device_t* _vdev, uint16_t _index,
+                              uint16_t _vector);
+
+/**
+ * @brief 把一个描述符链放入队列，不通知设备
+ * @param  _vq                     队列
+ * @param  _bufs                   缓冲区，先是设备读的，再是设备写的
+ * @param  _out                    设备读的缓冲区数
+ * @param  _in                     设备写的缓冲区数
+ * @param  _token                  完成时由 virtqueue_get_buf 返回，非空
+ * @return true                    成功
+ * @return false                   描述符不足
+ */
+bool         virtqueue_add(virtqueue_t* _vq, const virtio_buf_t* _bufs,
+                           size_t _out, size_t _in, void* _token);
+
+/**
+ * @brief 上次通知之后放入了描述符链，且设备需要通知
+ * 协商 EVENT_IDX 时按设备的 avail_event 判断，多个描述符链只通知一次
+ * @param  _vq                     队列
+ * @return true                    需要调用 virtqueue_notify
+ */
+bool         virtqueue_kick_prepare(virtqueue_t* _vq);
+
+/**
+ * @brief 通知设备
+ * @param  _vq                     队列
+ */
+void         virtqueue_notify(virtqueue_t* _vq);
+
+/**
+ * @brief 收取一个已完成的描述符链
+ * @param  _vq                     队列
+ * @param  _len                    设备写入的字节数
+ * @return void*                   放入时的 _token，没有时为 nullptr
+ */
+void*        virtqueue_get_buf(virtqueue_t* _vq, uint32_t* _len);
+
+/**
+ * @brief 不请求完成中断
+ * 协商 EVENT_IDX 时不再推进 used_event，设备最多再发送一次中断
+ * @param  _vq                     队列
+ */
+void         virtqueue_disable_cb(virtqueue_t* _vq);
+
+/**
+ * @brief 请求完成中断
+ * @param  _vq                     队列
+ * @return true                    没有未收取的完成
+ * @return false                   已有完成，调用者需要再次收取
+ */
+bool         virtqueue_enable_cb(virtqueue_t* _vq);
+
+#endif /* CMAKE_KERNEL_VIRTIO_H */
@@ -0,0 +1,638 @@
+
+/**
+ * @file nvme.cpp
+ * @brief NVMe 驱动
+ * @author Zone.N (Zone.Niuzh@hotmail.com)
+ * @version 1.0
+ * @date 2026-10-18
+ * @copyright MIT LICENSE
+ * https://github.com/MRNIU/cmake-kernel
+ * @par change log:
+ * <table>
+ * <tr><th>Date<th>Author<th>Description
+ * <tr><td>2026-10-18<td>Zone.N (Zone.Niuzh@hotmail.com)<td>创建文件
+ * </table>
+ */
+
+#include "blkdev.h"
+#include "cpu.h"
+#include "io.h"
+#include "ktime.h"
+#include "libc.h"
+#include "pci.h"
+#include "smp.h"
+#include "spinlock.hpp"
+
+/// 类别码: 大容量存储、非易失性存储器、NVMe
+static constexpr const uint32_t NVME_CLASS           = 0x010802;
+static constexpr const uint32_t NVME_CLASS_MASK      = 0xFFFFFF;
+
+/// 控制器寄存器
+static constexpr const uint32_t NVME_REG_CAP         = 0x00;
+static constexpr const uint32_t NVME_REG_INTMS       = 0x0C;
+static constexpr const uint32_t NVME_REG_CC          = 0x14;
+static constexpr const uint32_t NVME_REG_CSTS        = 0x1C;
+static constexpr const uint32_t NVME_REG_AQA         = 0x24;
+static constexpr const uint32_t NVME_REG_ASQ         = 0x28;
+static constexpr const uint32_t NVME_REG_ACQ         = 0x30;
+/// 第一个门铃
+static constexpr const uint32_t NVME_REG_DBS         = 0x1000;
+
+/// CC: 启用，提交项 64 字节，完成项 16 字节，页大小 4KB
+static constexpr const uint32_t NVME_CC_EN           = 1 << 0;
+static constexpr const uint32_t NVME_CC_IOSQES       = 6 << 16;
+static constexpr const uint32_t NVME_CC_IOCQES       = 4 << 20;
+/// CSTS: 就绪，致命错误
+static constexpr const uint32_t NVME_CSTS_RDY        = 1 << 0;
+static constexpr const uint32_t NVME_CSTS_CFS        = 1 << 1;
+
+/// 管理命令
+static constexpr const uint8_t  NVME_ADMIN_CREATE_SQ = 0x01;
+static constexpr const uint8_t  NVME_ADMIN_CREATE_CQ = 0x05;
+static constexpr const uint8_t  NVME_ADMIN_IDENTIFY  = 0x06;
+static constexpr const uint8_t  NVME_ADMIN_SET_FEAT  = 0x09;
+/// io 命令
+static constexpr const uint8_t  NVME_CMD_FLUSH       = 0x00;
+static constexpr const uint8_t  NVME_CMD_WRITE       = 0x01;
+static constexpr const uint8_t  NVME_CMD_READ        = 0x02;
+
+/// Identify 的 CNS
+static constexpr const uint32_t NVME_ID_CNS_NS       = 0x00;
+static constexpr const uint32_t NVME_ID_CNS_CTRL     = 0x01;
+/// Identify 数据中的字段
+static constexpr const size_t   NVME_ID_CTRL_MDTS    = 77;
+static constexpr const size_t   NVME_ID_NS_NSZE      = 0;
+static constexpr const size_t   NVME_ID_NS_FLBAS     = 26;
+static constexpr const size_t   NVME_ID_NS_LBAF      = 128;
+/// 特性: 队列数
+static constexpr const uint32_t NVME_FEAT_NUM_QUEUES = 0x07;
+/// 创建队列的标志: 物理连续，产生中断
+static constexpr const uint32_t NVME_QUEUE_CONTIG    = 1 << 0;
+static constexpr const uint32_t NVME_CQ_IRQ_ENABLED  = 1 << 1;
+
+/// 状态码 (SCT 与 SC)
+static constexpr const uint16_t NVME_SC_SUCCESS      = 0x000;
+static constexpr const uint16_t NVME_SC_INVALID_OP   = 0x001;
+static constexpr const uint16_t NVME_SC_MASK         = 0x7FF;
+
+/// 使用的命名空间
+static constexpr const uint32_t NVME_NSID            = 1;
+/// 内存页
+static constexpr const size_t   NVME_PAGE_SIZE       = 4096;
+/// 设备数上限
+static constexpr const size_t   NVME_DEV_MAX         = 2;
+/// 管理队列与 io 队列的项数
+static constexpr const size_t   NVME_ADMIN_DEPTH     = 32;
+static constexpr const size_t   NVME_QUEUE_DEPTH     = 64;
+static_assert(NVME_QUEUE_DEPTH <= 65, "command ids are a 64-bit mask");
+/// 每个命令的 PRP 列表项数，决定单个请求的扇区数上限，
+/// 数据不按页对齐时首页之外最多还有这么多页
+static constexpr const size_t   NVME_PRP_ENTRIES     = 32;
+static constexpr const uint32_t NVME_MAX_SECTORS
+  = (NVME_PRP_ENTRIES * NVME_PAGE_SIZE) >> SECTOR_SHIFT;
+
+/**
+ * @brief 提交项
+ */
+struct nvme_sqe_t {
+    uint8_t  opcode;
+    uint8_t  flags;
+    uint16_t cid;
+    uint32_t nsid;
+    uint64_t reserved;
+    uint64_t mptr;
+    uint64_t prp1;
+    uint64_t prp2;
+    uint32_t cdw10;
+    uint32_t cdw11;
+    uint32_t cdw12;
+    uint32_t cdw13;
+    uint32_t cdw14;
+    uint32_t cdw15;
+};
+static_assert(sizeof(nvme_sqe_t) == 64, "IOSQES");
+
+/**
+ * @brief 完成项，status 的最低位是相位
+ */
+struct nvme_cqe_t {
+    uint32_t result;
+    uint32_t reserved;
+    uint16_t sq_head;
+    uint16_t sq_id;
+    uint16_t cid;
+    uint16_t status;
+};
+static_assert(sizeof(nvme_cqe_t) == 16, "IOCQES");
+
+/**
+ * @brief 管理队列与 Identify 的内存
+ */
+struct nvme_admin_mem_t {
+    alignas(NVME_PAGE_SIZE) nvme_sqe_t sq[NVME_ADMIN_DEPTH];
+    alignas(NVME_PAGE_SIZE) nvme_cqe_t cq[NVME_ADMIN_DEPTH];
+    alignas(NVME_PAGE_SIZE) uint8_t identify[NVME_PAGE_SIZE];
+};
+
+/**
+ * @brief io 队列的内存，每个命令号预留一个 PRP 列表，提交时不分配内存
+ */
+struct nvme_queue_mem_t {
+    alignas(NVME_PAGE_SIZE) nvme_sqe_t sq[NVME_QUEUE_DEPTH];
+    alignas(NVME_PAGE_SIZE) nvme_cqe_t cq[NVME_QUEUE_DEPTH];
+    alignas(NVME_PAGE_SIZE) uint64_t prps[NVME_QUEUE_DEPTH][NVME_PRP_ENTRIES];
+};
+
+struct nvme_t;
+
+/**
+ * @brief 一对提交/完成队列
+ * 每个 cpu 一对，各自的锁与门铃不共享缓存行。
+ * 中断与提交可能在不同 cpu 上，使用关中断的锁
+ */
+struct alignas(CACHE_LINE_SIZE) nvme_queue_t {
+    TicketLock        lock;
+    nvme_t*           nvme;
+    nvme_sqe_t*       sq;
+    nvme_cqe_t*       cq;
+    /// 按命令号的 PRP 列表，管理队列为 nullptr
+    uint64_t          (*prps)[NVME_PRP_ENTRIES];
+    volatile uint8_t* sq_db;
+    volatile uint8_t* cq_db;
+    uint16_t          qid;
+    uint16_t          depth;
+    uint16_t          sq_tail;
+    /// 最后写入门铃的 sq_tail
+    uint16_t          sq_db_tail;
+    uint16_t          cq_head;
+    uint16_t          cq_phase;
+    /// 空闲的命令号，在途命令数少于 depth，提交队列不会满
+    uint64_t          free_cids;
+    /// 按命令号保存的请求
+    blk_request_t*    rqs[NVME_QUEUE_DEPTH];
+};
+
+/**
+ * @brief 一个 NVMe 控制器，只使用命名空间 1
+ */
+struct nvme_t {
+    pci_device_t*     pdev;
+    volatile uint8_t* regs;
+    /// 门铃间距，字节
+    uint32_t          db_stride;
+    /// 逻辑块大小的 log2
+    uint32_t          lba_shift;
+    /// CAP.TO，也作为管理命令的超时
+    uint64_t          timeout_ns;
+    nvme_queue_t      admin;
+    nvme_queue_t      queues[BLK_HW_QUEUE_MAX];
+    blk_dev_t         bdev;
+    /// "nvme0n1" 起
+    char              name[16];
+};
+
+static nvme_t           nvmes[NVME_DEV_MAX];
+static nvme_admin_mem_t nvme_admin_mems[NVME_DEV_MAX];
+static nvme_queue_mem_t nvme_queue_mems[NVME_DEV_MAX][BLK_HW_QUEUE_MAX];
+static size_t           nvme_count;
+
+static uint16_t read_once(const uint16_t* _ptr) {
+    return *static_cast<const volatile uint16_t*>(_ptr);
+}
+
+static int32_t nvme_status(uint16_t _status) {
+    auto sc = static_cast<uint16_t>((_status >> 1) & NVME_SC_MASK);
+    if (sc == NVME_SC_SUCCESS) {
+        return BLK_STS_OK;
+    }
+    return sc == NVME_SC_INVALID_OP ? BLK_STS_NOTSUPP : BLK_STS_IOERR;
+}
+
+static void nvme_queue_init(nvme_t* _nvme, nvme_queue_t* _queue, uint16_t _qid,
+                            nvme_sqe_t* _sq, nvme_cqe_t* _cq, size_t _depth) {
+    _queue->nvme       = _nvme;
+    _queue->sq         = _sq;
+    _queue->cq         = _cq;
+    _queue->sq_db      = _nvme->regs + NVME_REG_DBS
+                         + 2 * _qid * _nvme->db_stride;
+    _queue->cq_db      = _queue->sq_db + _nvme->db_stride;
+    _queue->qid        = _qid;
+    _queue->depth      = static_cast<uint16_t>(_depth);
+    _queue->sq_tail    = 0;
+    _queue->sq_db_tail = 0;
+    _queue->cq_head    = 0;
+    // 完成队列清零后，设备写入的第一轮相位为 1
+    _queue->cq_phase   = 1;
+    _queue->free_cids  = ~0ULL >> (65 - _depth);
+    memset(_cq, 0, _depth * sizeof(nvme_cqe_t));
+    return;
+}
+
+/**
+ * @brief 写入一个提交项，不写门铃，调用者持有锁
+ */
+static void nvme_sq_push(nvme_queue_t* _queue, const nvme_sqe_t* _cmd) {
+    _queue->sq[_queue->sq_tail] = *_cmd;
+    _queue->sq_tail             = _queue->sq_tail + 1 == _queue->depth
+                                    ? 0
+                                    : _queue->sq_tail + 1;
+    return;
+}
+
+/**
+ * @brief 写提交队列门铃，调用者持有锁
+ * 门铃的值是尾指针，必须按顺序写入，所以在锁内进行
+ */
+static void nvme_sq_ring(nvme_queue_t* _queue) {
+    if (_queue->sq_tail != _queue->sq_db_tail) {
+        mmio_write32(_queue->sq_db, _queue->sq_tail);
+        _queue->sq_db_tail = _queue->sq_tail;
+    }
+    return;
+}
+
+/**
+ * @brief 取下一个完成项，调用者持有锁
+ * @return nvme_cqe_t*             完成项，没有时为 nullptr
+ */
+static nvme_cqe_t* nvme_cq_pop(nvme_queue_t* _queue) {
+    auto* cqe = &_queue->cq[_queue->cq_head];
+    if ((read_once(&cqe->status) & 1) != _queue->cq_phase) {
+        return nullptr;
+    }
+    // 先读相位再读完成项的其它字段
+    dma_rmb();
+    if (++_queue->cq_head == _queue->depth) {
+        _queue->cq_head  = 0;
+        _queue->cq_phase ^= 1;
+    }
+    return cqe;
+}
+
+/**
+ * @brief 执行管理命令并轮询等待完成，只在 probe 中调用
+ * @param  _nvme                   控制器
+ * @param  _cmd                    命令，cid 由此函数填写
+ * @param  _result                 完成项的 result，可以为 nullptr
+ * @return int32_t                 BLK_STS_*
+ */
+static int32_t nvme_admin(nvme_t* _nvme, nvme_sqe_t* _cmd, uint32_t* _result) {
+    auto* admin = &_nvme->admin;
+    _cmd->cid   = admin->sq_tail;
+    nvme_sq_push(admin, _cmd);
+    nvme_sq_ring(admin);
+    auto        deadline = ktime_get_ns() + _nvme->timeout_ns;
+    nvme_cqe_t* cqe;
+    while ((cqe = nvme_cq_pop(admin)) == nullptr) {
+        if (ktime_get_ns() > deadline) {
+            return BLK_STS_IOERR;
+        }
+        cpu_relax();
+    }
+    mmio_write32(admin->cq_db, admin->cq_head);
+    if (_result != nullptr) {
+        *_result = cqe->result;
+    }
+    return nvme_status(cqe->status);
+}
+
+static int32_t nvme_identify(nvme_t* _nvme, uint32_t _cns, uint32_t _nsid,
+                             void* _buf) {
+    nvme_sqe_t cmd = {};
+    cmd.opcode     = NVME_ADMIN_IDENTIFY;
+    cmd.nsid       = _nsid;
+    cmd.prp1       = reinterpret_cast<uintptr_t>(_buf);
+    cmd.cdw10      = _cns;
+    return nvme_admin(_nvme, &cmd, nullptr);
+}
+
+/**
+ * @brief 等待 CSTS.RDY 变为 _ready
+ * @return true                    成功
+ * @return false                   超时或控制器出错
+ */
+static bool nvme_wait_ready(nvme_t* _nvme, bool _ready) {
+    auto deadline = ktime_get_ns() + _nvme->timeout_ns;
+    for (;;) {
+        auto csts = mmio_read32(_nvme->regs + NVME_REG_CSTS);
+        // 全 1 表示设备已不在总线上
+        if ((csts == UINT32_MAX) || (_ready && ((csts & NVME_CSTS_CFS) != 0))) {
+            return false;
+        }
+        if (((csts & NVME_CSTS_RDY) != 0) == _ready) {
+            return true;
+        }
+        if (ktime_get_ns() > deadline) {
+            return false;
+        }
+        cpu_relax();
+    }
+}
+
+/**
+ * @brief 为请求的数据填写 PRP1/PRP2
+ * 块层保证段与段相接处按页对齐，因此除 PRP1 外的每一项都是整页的开头，
+ * 超过两页时 PRP2 指向命令号预留的 PRP 列表
+ */
+static void nvme_setup_prps(nvme_queue_t* _queue, uint16_t _cid,
+                            nvme_sqe_t* _cmd, const blk_request_t* _rq) {
+    auto*  list  = _queue->prps[_cid];
+    size_t n     = 0;
+    bool   first = true;
+    auto   segs  = blk_rq_nr_segs(_rq);
+    for (uint32_t i = 0; i < segs; i++) {
+        auto     seg  = blk_rq_seg(_rq, i);
+        auto     addr = reinterpret_cast<uintptr_t>(seg.buffer);
+        uint64_t len  = seg.len;
+        while (len > 0) {
+            uint64_t chunk = NVME_PAGE_SIZE - (addr & (NVME_PAGE_SIZE - 1));
+            chunk          = chunk < len ? chunk : len;
+            if (first) {
+                _cmd->prp1 = addr;
+                first      = false;
+            }
+            else {
+                list[n++] = addr;
+            }
+            addr += chunk;
+            len  -= chunk;
+        }
+    }
+    if (n == 1) {
+        _cmd->prp2 = list[0];
+    }
+    else if (n > 1) {
+        _cmd->prp2 = reinterpret_cast<uintptr_t>(list);
+    }
+    return;
+}
+
+static size_t nvme_queue_rqs(blk_dev_t* _bdev, size_t _hwq,
+                             blk_request_t** _rqs, size_t _count) {
+    auto*  nvme     = static_cast<nvme_t*>(_bdev->driver_data);
+    auto*  queue    = &nvme->queues[_hwq];
+    auto   shift    = nvme->lba_shift - SECTOR_SHIFT;
+    size_t accepted = 0;
+
+    IrqLockGuard<TicketLock> guard(queue->lock);
+    for (; (accepted < _count) && (queue->free_cids != 0); accepted++) {
+        auto*      rq  = _rqs[accepted];
+        auto       cid = static_cast<uint16_t>(
+          __builtin_ctzll(queue->free_cids));
+        nvme_sqe_t cmd = {};
+        cmd.cid        = cid;
+        cmd.nsid       = NVME_NSID;
+        if (rq->op == BLK_OP_FLUSH) {
+            cmd.opcode = NVME_CMD_FLUSH;
+        }
+        else {
+            auto slba  = rq->sector >> shift;
+            cmd.opcode = rq->op == BLK_OP_WRITE ? NVME_CMD_WRITE
+                                                : NVME_CMD_READ;
+            cmd.cdw10  = static_cast<uint32_t>(slba);
+            cmd.cdw11  = static_cast<uint32_t>(slba >> 32);
+            // 块数从 0 起
+            cmd.cdw12  = (rq->nr_sectors >> shift) - 1;
+            nvme_setup_prps(queue, cid, &cmd, rq);
+        }
+        nvme_sq_push(queue, &cmd);
+        queue->free_cids &= ~(1ULL << cid);
+        queue->rqs[cid]   = rq;
+    }
+    return accepted;
+}
+
+static void nvme_commit(blk_dev_t* _bdev, size_t _hwq) {
+    auto* nvme  = static_cast<nvme_t*>(_bdev->driver_data);
+    auto* queue = &nvme->queues[_hwq];
+    IrqLockGuard<TicketLock> guard(queue->lock);
+    // 一批请求只写一次门铃
+    nvme_sq_ring(queue);
+    return;
+}
+
+/**
+ * @brief 收取已完成的请求，一次写完成队列门铃，解锁后再调用 end_io
+ * @param  _queue                  队列
+ * @return size_t                  完成数
+ */
+static size_t nvme_complete(nvme_queue_t* _queue) {
+    blk_request_t* done[NVME_QUEUE_DEPTH];
+    size_t         count = 0;
+    {
+        IrqLockGuard<TicketLock> guard(_queue->lock);
+        nvme_cqe_t*              cqe;
+        while ((cqe = nvme_cq_pop(_queue)) != nullptr) {
+            auto cid          = cqe->cid;
+            auto* rq          = _queue->rqs[cid];
+            rq->status        = nvme_status(cqe->status);
+            _queue->rqs[cid]  = nullptr;
+            _queue->free_cids |= 1ULL << cid;
+            done[count++]     = rq;
+        }
+        if (count != 0) {
+            mmio_write32(_queue->cq_db, _queue->cq_head);
+        }
+    }
+    for (size_t i = 0; i < count; i++) {
+        done[i]->end_io(done[i]);
+    }
+    return count;
+}
+
+static size_t nvme_poll(blk_dev_t* _bdev, size_t _hwq) {
+    auto* nvme = static_cast<nvme_t*>(_bdev->driver_data);
+    return nvme_complete(&nvme->queues[_hwq]);
+}
+
+static void nvme_irq(void* _arg) {
+    nvme_complete(static_cast<nvme_queue_t*>(_arg));
+    return;
+}
+
+static const blk_dev_ops_t nvme_ops = {
+    nvme_queue_rqs,
+    nvme_commit,
+    nvme_poll,
+};
+
+/**
+ * @brief 关闭并重新启用控制器，建立管理队列
+ */
+static bool nvme_enable(nvme_t* _nvme, nvme_admin_mem_t* _mem) {
+    auto* regs = _nvme->regs;
+    if ((mmio_read32(regs + NVME_REG_CC) & NVME_CC_EN) != 0) {
+        mmio_write32(regs + NVME_REG_CC, 0);
+    }
+    if (!nvme_wait_ready(_nvme, false)) {
+        return false;
+    }
+    nvme_queue_init(_nvme, &_nvme->admin, 0, _mem->sq, _mem->cq,
+                    NVME_ADMIN_DEPTH);
+    mmio_write32(regs + NVME_REG_AQA,
+                 (NVME_ADMIN_DEPTH - 1) << 16 | (NVME_ADMIN_DEPTH - 1));
+    mmio_write64(regs + NVME_REG_ASQ, reinterpret_cast<uintptr_t>(_mem->sq));
+    mmio_write64(regs + NVME_REG_ACQ, reinterpret_cast<uintptr_t>(_mem->cq));
+    mmio_write32(regs + NVME_REG_CC,
+                 NVME_CC_EN | NVME_CC_IOSQES | NVME_CC_IOCQES);
+    return nvme_wait_ready(_nvme, true);
+}
+
+/**
+ * @brief 创建 io 队列对 _qid，_vector 为 -1 时完成队列不产生中断
+ */
+static bool nvme_create_queue(nvme_t* _nvme, nvme_queue_t* _queue,
+                              int32_t _vector) {
+    auto       size = static_cast<uint32_t>(_queue->depth - 1) << 16;
+    nvme_sqe_t cmd  = {};
+    cmd.opcode      = NVME_ADMIN_CREATE_CQ;
+    cmd.prp1        = reinterpret_cast<uintptr_t>(_queue->cq);
+    cmd.cdw10       = size | _queue->qid;
+    cmd.cdw11       = NVME_QUEUE_CONTIG;
+    if (_vector >= 0) {
+        cmd.cdw11 |= static_cast<uint32_t>(_vector) << 16
+                     | NVME_CQ_IRQ_ENABLED;
+    }
+    if (nvme_admin(_nvme, &cmd, nullptr) != BLK_STS_OK) {
+        return false;
+    }
+    cmd        = {};
+    cmd.opcode = NVME_ADMIN_CREATE_SQ;
+    cmd.prp1   = reinterpret_cast<uintptr_t>(_queue->sq);
+    cmd.cdw10  = size | _queue->qid;
+    // 提交队列 n 使用完成队列 n
+    cmd.cdw11  = static_cast<uint32_t>(_queue->qid) << 16
+                | NVME_QUEUE_CONTIG;
+    return nvme_admin(_nvme, &cmd, nullptr) == BLK_STS_OK;
+}
+
+static int32_t nvme_probe(device_t* _dev, const device_id_t* _id) {
+    (void)_id;
+    auto* pdev = to_pci_device(_dev);
+    auto  idx  = __atomic_fetch_add(&nvme_count, 1, __ATOMIC_RELAXED);
+    if (idx >= NVME_DEV_MAX) {
+        return PROBE_ERROR;
+    }
+    auto* nvme = &nvmes[idx];
+    auto* amem = &nvme_admin_mems[idx];
+    pci_enable(pdev);
+    nvme->pdev = pdev;
+    nvme->regs = static_cast<volatile uint8_t*>(pci_iomap(pdev, 0));
+    if (nvme->regs == nullptr) {
+        return PROBE_ERROR;
+    }
+    auto cap         = mmio_read64(nvme->regs + NVME_REG_CAP);
+    auto mqes        = (cap & 0xFFFF) + 1;
+    nvme->db_stride  = 4U << ((cap >> 32) & 0xF);
+    nvme->timeout_ns = ((cap >> 24) & 0xFF) * 500 * NSEC_PER_MSEC;
+    // 最小页大小 (CAP.MPSMIN) 需要是 4KB
+    if ((((cap >> 48) & 0xF) != 0) || !nvme_enable(nvme, amem)) {
+        return PROBE_ERROR;
+    }
+
+    if (nvme_identify(nvme, NVME_ID_CNS_CTRL, 0, amem->identify)
+        != BLK_STS_OK) {
+        return PROBE_ERROR;
+    }
+    // MDTS 以最小页为单位的 2 的幂，0 表示不限
+    uint32_t max_sectors = NVME_MAX_SECTORS;
+    auto     mdts        = amem->identify[NVME_ID_CTRL_MDTS];
+    if ((mdts != 0) && (mdts < 32)) {
+        auto limit  = (NVME_PAGE_SIZE << mdts) >> SECTOR_SHIFT;
+        max_sectors = limit < max_sectors ? limit : max_sectors;
+    }
+    if (nvme_identify(nvme, NVME_ID_CNS_NS, NVME_NSID, amem->identify)
+        != BLK_STS_OK) {
+        return PROBE_ERROR;
+    }
+    uint64_t nsze;
+    memcpy(&nsze, amem->identify + NVME_ID_NS_NSZE, sizeof(nsze));
+    auto lbaf       = amem->identify[NVME_ID_NS_FLBAS] & 0xF;
+    // 每个格式 4 字节，第 2 字节是逻辑块大小的 log2
+    nvme->lba_shift = amem->identify[NVME_ID_NS_LBAF + 4 * lbaf + 2];
+    if ((nsze == 0) || (nvme->lba_shift < SECTOR_SHIFT)
+        || (nvme->lba_shift > 12)) {
+        return PROBE_ERROR;
+    }
+
+    // 每个 cpu 一对队列，控制器支持的更少时多个 cpu 共用
+    size_t queues = smp_cpu_count();
+    queues        = queues < BLK_HW_QUEUE_MAX ? queues : BLK_HW_QUEUE_MAX;
+    queues        = queues == 0 ? 1 : queues;
+    nvme_sqe_t cmd = {};
+    cmd.opcode     = NVME_ADMIN_SET_FEAT;
+    cmd.cdw10      = NVME_FEAT_NUM_QUEUES;
+    cmd.cdw11      = static_cast<uint32_t>((queues - 1) << 16 | (queues - 1));
+    uint32_t result;
+    if (nvme_admin(nvme, &cmd, &result) != BLK_STS_OK) {
+        return PROBE_ERROR;
+    }
+    // 结果是分配的提交与完成队列数，从 0 起
+    size_t nsq = (result & 0xFFFF) + 1;
+    size_t ncq = (result >> 16) + 1;
+    queues     = nsq < queues ? nsq : queues;
+    queues     = ncq < queues ? ncq : queues;
+
+    // 向量 0 属于管理队列，管理命令轮询完成，保持屏蔽。
+    // 队列 i 使用向量 i + 1，发往使用该队列的 cpu，
+    // 配置为轮询模式或没有可用向量的队列不产生中断
+    size_t vectors = 0;
+    if (!BLK_POLL) {
+        vectors = pci_msix_enable(pdev, queues + 1);
+    }
+    if (vectors == 0) {
+        // 没有 MSI-X 时屏蔽 INTx
+        mmio_write32(nvme->regs + NVME_REG_INTMS, UINT32_MAX);
+    }
+    auto     depth  = mqes < NVME_QUEUE_DEPTH ? mqes : NVME_QUEUE_DEPTH;
+    uint64_t polled = 0;
+    for (size_t i = 0; i < queues; i++) {
+        auto* queue = &nvme->queues[i];
+        auto* qmem  = &nvme_queue_mems[idx][i];
+        nvme_queue_init(nvme, queue, static_cast<uint16_t>(i + 1), qmem->sq,
+                        qmem->cq, depth);
+        queue->prps    = qmem->prps;
+        int32_t vector = -1;
+        if ((i + 1 < vectors)
+            && pci_irq_request(pdev, i + 1, pci_queue_cpu(i, queues),
+                               nvme_irq, queue)) {
+            vector = static_cast<int32_t>(i + 1);
+        }
+        else {
+            polled |= 1ULL << i;
+        }
+        if (!nvme_create_queue(nvme, queue, vector)) {
+            return PROBE_ERROR;
+        }
+    }
+
+    auto* bdev = &nvme->bdev;
+    memcpy(nvme->name, "nvme0n1", sizeof("nvme0n1"));
+    nvme->name[4]      = static_cast<char>('0' + idx);
+    bdev->name         = nvme->name;
+    bdev->dev          = _dev;
+    bdev->capacity     = nsze << (nvme->lba_shift - SECTOR_SHIFT);
+    bdev->block_size   = 1U << nvme->lba_shift;
+    bdev->max_sectors  = max_sectors;
+    // PRP 只能描述按页相接的段
+    bdev->max_segs     = BLK_SEG_MAX;
+    bdev->seg_boundary = NVME_PAGE_SIZE - 1;
+    bdev->nr_hw_queues = queues;
+    bdev->queue_depth  = depth - 1;
+    bdev->poll_queues  = polled;
+    bdev->ops          = &nvme_ops;
+    bdev->driver_data  = nvme;
+    _dev->driver_data  = nvme;
+    return blk_register(bdev) ? PROBE_OK : PROBE_ERROR;
+}
+
+static const device_id_t nvme_ids[] = {
+    { DEVICE_ID_ANY, DEVICE_ID_ANY, NVME_CLASS, NVME_CLASS_MASK, nullptr, 0 },
+    {},
+};
+
+static driver_t nvme_driver = {
+    {}, "nvme", &pci_bus, nvme_ids, nvme_probe, nullptr,
+};
+
+DRIVER_INIT(nvme_driver, DRIVER_LEVEL_DEVICE);
@@ -0,0 +1,486 @@
+
+/**
+ * @file pci.cpp
+ * @brief PCIe 总线
+ * @author Zone.N (Zone.Niuzh@hotmail.com)
+ * @version 1.0
+ * @date 2026-10-18
+ * @copyright MIT LICENSE
+ * https://github.com/MRNIU/cmake-kernel
+ * @par change log:
+ * <table>
+ * <tr><th>Date<th>Author<th>Description
+ * <tr><td>2026-10-18<td>Zone.N (Zone.Niuzh@hotmail.com)<td>创建文件
+ * </table>
+ */
+
+#include "pci.h"
+
+#include "acpi.h"
+#include "fdt.h"
+#include "io.h"
+#include "libc.h"
+#include "msi.h"
+#include "smp.h"
+
+/// 主桥数上限
+static constexpr const size_t   PCI_HOST_MAX       = 4;
+/// pci 功能数上限
+static constexpr const size_t   PCI_DEVICE_MAX     = 64;
+/// 每条总线的插槽数与每个插槽的功能数
+static constexpr const uint8_t  PCI_SLOT_COUNT     = 32;
+static constexpr const uint8_t  PCI_FUNC_COUNT     = 8;
+/// 桥的嵌套深度上限
+static constexpr const size_t   PCI_BRIDGE_DEPTH   = 8;
+/// 桥只有两个 BAR
+static constexpr const size_t   PCI_BRIDGE_BARS    = 2;
+
+/// MSI-X 能力中的寄存器
+static constexpr const uint32_t PCI_MSIX_FLAGS     = 2;
+static constexpr const uint32_t PCI_MSIX_TABLE     = 4;
+static constexpr const uint16_t PCI_MSIX_QSIZE     = 0x07FF;
+static constexpr const uint16_t PCI_MSIX_MASKALL   = 0x4000;
+static constexpr const uint16_t PCI_MSIX_ENABLE    = 0x8000;
+static constexpr const uint32_t PCI_MSIX_BIR       = 0x7;
+/// MSI-X 表项
+static constexpr const size_t   MSIX_ENTRY_SIZE    = 16;
+static constexpr const size_t   MSIX_ADDR_LO       = 0;
+static constexpr const size_t   MSIX_ADDR_HI       = 4;
+static constexpr const size_t   MSIX_DATA          = 8;
+static constexpr const size_t   MSIX_CTRL          = 12;
+static constexpr const uint32_t MSIX_CTRL_MASKED   = 1;
+
+/// 设备树 ranges 中 pci 地址第一个单元的空间类型
+static constexpr const uint32_t RANGES_SPACE_SHIFT = 24;
+static constexpr const uint32_t RANGES_SPACE_MEM32 = 2;
+static constexpr const uint32_t RANGES_SPACE_MEM64 = 3;
+
+bus_t pci_bus = { "pci", nullptr, {}, {}, {}, 0 };
+
+/// 静态分配的主桥与设备，不同主桥可能并行探测
+static pci_host_t   pci_hosts[PCI_HOST_MAX];
+static size_t       pci_host_count;
+static pci_device_t pci_devices[PCI_DEVICE_MAX];
+static size_t       pci_device_count;
+
+pci_device_t* to_pci_device(device_t* _dev) {
+    return reinterpret_cast<pci_device_t*>(
+      reinterpret_cast<uint8_t*>(_dev) - offsetof(pci_device_t, dev));
+}
+
+static volatile uint8_t* config_ptr(const pci_device_t* _pdev,
+                                    uint32_t            _offset) {
+    return reinterpret_cast<volatile uint8_t*>(_pdev->config + _offset);
+}
+
+uint8_t pci_read8(const pci_device_t* _pdev, uint32_t _offset) {
+    return mmio_read8(config_ptr(_pdev, _offset));
+}
+
+uint16_t pci_read16(const pci_device_t* _pdev, uint32_t _offset) {
+    return mmio_read16(config_ptr(_pdev, _offset));
+}
+
+uint32_t pci_read32(const pci_device_t* _pdev, uint32_t _offset) {
+    return mmio_read32(config_ptr(_pdev, _offset));
+}
+
+void pci_write8(pci_device_t* _pdev, uint32_t _offset, uint8_t _val) {
+    mmio_write8(config_ptr(_pdev, _offset), _val);
+    return;
+}
+
+void pci_write16(pci_device_t* _pdev, uint32_t _offset, uint16_t _val) {
+    mmio_write16(config_ptr(_pdev, _offset), _val);
+    return;
+}
+
+void pci_write32(pci_device_t* _pdev, uint32_t _offset, uint32_t _val) {
+    mmio_write32(config_ptr(_pdev, _offset), _val);
+    return;
+}
+
+uint8_t pci_find_capability(const pci_device_t* _pdev, uint8_t _id,
+                            uint8_t _start) {
+    if ((pci_read16(_pdev, PCI_STATUS) & PCI_STATUS_CAP_LIST) == 0) {
+        return 0;
+    }
+    auto pos = _start == 0 ? pci_read8(_pdev, PCI_CAPABILITY_LIST)
+                           : pci_read8(_pdev, _start + 1);
+    // 限制遍历次数，防止链表成环
+    for (size_t i = 0; (i < 48) && (pos >= 0x40); i++) {
+        pos &= ~3;
+        if (pci_read8(_pdev, pos) == _id) {
+            return pos;
+        }
+        pos = pci_read8(_pdev, pos + 1);
+    }
+    return 0;
+}
+
+void pci_enable(pci_device_t* _pdev) {
+    auto cmd = pci_read16(_pdev, PCI_COMMAND);
+    pci_write16(_pdev, PCI_COMMAND,
+                cmd | PCI_COMMAND_MEMORY | PCI_COMMAND_MASTER);
+    return;
+}
+
+volatile void* pci_iomap(const pci_device_t* _pdev, size_t _bar) {
+    if ((_bar >= PCI_BAR_COUNT) || (_pdev->bars[_bar].base == 0)) {
+        return nullptr;
+    }
+    return reinterpret_cast<volatile void*>(_pdev->bars[_bar].base);
+}
+
+static volatile uint8_t* msix_entry(pci_device_t* _pdev, size_t _index) {
+    return _pdev->msix_table + _index * MSIX_ENTRY_SIZE;
+}
+
+size_t pci_msix_enable(pci_device_t* _pdev, size_t _count) {
+    auto cap = pci_find_capability(_pdev, PCI_CAP_ID_MSIX, 0);
+    if (cap == 0) {
+        return 0;
+    }
+    auto flags  = pci_read16(_pdev, cap + PCI_MSIX_FLAGS);
+    auto table  = pci_read32(_pdev, cap + PCI_MSIX_TABLE);
+    auto* bar   = static_cast<volatile uint8_t*>(
+      pci_iomap(_pdev, table & PCI_MSIX_BIR));
+    if (bar == nullptr) {
+        return 0;
+    }
+    _pdev->msix_cap   = cap;
+    _pdev->msix_count = (flags & PCI_MSIX_QSIZE) + 1;
+    _pdev->msix_table = bar + (table & ~PCI_MSIX_BIR);
+    // 先在功能级屏蔽并启用，屏蔽每个表项后再取消功能级屏蔽
+    pci_write16(_pdev, cap + PCI_MSIX_FLAGS,
+                flags | PCI_MSIX_ENABLE | PCI_MSIX_MASKALL);
+    for (size_t i = 0; i < _pdev->msix_count; i++) {
+        mmio_write32(msix_entry(_pdev, i) + MSIX_CTRL, MSIX_CTRL_MASKED);
+    }
+    pci_write16(_pdev, cap + PCI_MSIX_FLAGS,
+                (flags | PCI_MSIX_ENABLE) & ~PCI_MSIX_MASKALL);
+    auto cmd = pci_read16(_pdev, PCI_COMMAND);
+    pci_write16(_pdev, PCI_COMMAND, cmd | PCI_COMMAND_INTX_OFF);
+
+    auto count = _count < _pdev->msix_count ? _count : _pdev->msix_count;
+    return count < PCI_IRQ_MAX ? count : PCI_IRQ_MAX;
+}
+
+bool pci_irq_request(pci_device_t* _pdev, size_t _index, size_t _cpu,
+                     void (*_handler)(void* _arg), void* _arg) {
+    if ((_pdev->msix_table == nullptr) || (_index >= _pdev->msix_count)
+        || (_index >= PCI_IRQ_MAX) || (_pdev->irqs[_index] != 0)) {
+        return false;
+    }
+    msi_msg_t msg;
+    auto      no = msi_alloc(_cpu, _handler, _arg, &msg);
+    if (no == 0) {
+        return false;
+    }
+    _pdev->irqs[_index] = no;
+    auto* entry         = msix_entry(_pdev, _index);
+    mmio_write32(entry + MSIX_ADDR_LO, static_cast<uint32_t>(msg.address));
+    mmio_write32(entry + MSIX_ADDR_HI,
+                 static_cast<uint32_t>(msg.address >> 32));
+    mmio_write32(entry + MSIX_DATA, msg.data);
+    mmio_write32(entry + MSIX_CTRL, 0);
+    return true;
+}
+
+void pci_irq_free(pci_device_t* _pdev, size_t _index) {
+    if ((_index >= PCI_IRQ_MAX) || (_pdev->irqs[_index] == 0)) {
+        return;
+    }
+    auto* entry = msix_entry(_pdev, _index);
+    mmio_write32(entry + MSIX_CTRL, MSIX_CTRL_MASKED);
+    // 读回以确保屏蔽已生效，之后设备不会再发送该中断
+    (void)mmio_read32(entry + MSIX_CTRL);
+    msi_free(_pdev->irqs[_index]);
+    _pdev->irqs[_index] = 0;
+    return;
+}
+
+size_t pci_cpu_queue(size_t _cpu, size_t _queues) {
+    return _cpu % _queues;
+}
+
+size_t pci_queue_cpu(size_t _queue, size_t _queues) {
+    for (auto cpu = _queue % _queues; cpu < MAX_CPU_COUNT; cpu += _queues) {
+        if (smp_cpu_is_online(cpu)) {
+            return cpu;
+        }
+    }
+    // 使用该队列的 cpu 都不在线，发往启动 cpu
+    return 0;
+}
+
+/**
+ * @brief 以 _digits 位小写十六进制写入 _val，不写入 '\0'
+ */
+static char* hex_format(char* _buf, uint64_t _val, size_t _digits) {
+    for (size_t i = 0; i < _digits; i++) {
+        _buf[_digits - 1 - i] = "0123456789abcdef"[_val & 0xF];
+        _val                  >>= 4;
+    }
+    return _buf + _digits;
+}
+
+/**
+ * @brief 从窗口中分配按大小对齐的 pci 地址
+ * @return uint64_t                pci 地址，窗口不足时为 0
+ */
+static uint64_t window_alloc(pci_window_t* _window, uint64_t _size) {
+    if (_window->size == 0) {
+        return 0;
+    }
+    auto addr = (_window->next + _size - 1) & ~(_size - 1);
+    if (addr + _size > _window->pci_base + _window->size) {
+        return 0;
+    }
+    _window->next = addr + _size;
+    return addr;
+}
+
+/**
+ * @brief pci 地址对应的 cpu 地址，不在任何窗口中时两者相同
+ */
+static uint64_t window_to_cpu(const pci_host_t* _host, uint64_t _addr) {
+    const pci_window_t* windows[] = { &_host->mem32, &_host->mem64 };
+    for (auto* window : windows) {
+        if ((_addr >= window->pci_base)
+            && (_addr - window->pci_base < window->size)) {
+            return _addr - window->pci_base + window->cpu_base;
+        }
+    }
+    return _addr;
+}
+
+/**
+ * @brief 测量 BAR 的大小，固件未分配的从主桥窗口中分配
+ * 测量期间关闭设备的地址译码
+ * @param  _pdev                   设备
+ * @param  _count                  BAR 数
+ */
+static void bar_probe(pci_device_t* _pdev, size_t _count) {
+    auto cmd = pci_read16(_pdev, PCI_COMMAND);
+    pci_write16(_pdev, PCI_COMMAND,
+                cmd & ~(PCI_COMMAND_IO | PCI_COMMAND_MEMORY));
+    for (size_t i = 0; i < _count; i++) {
+        auto offset = PCI_BAR0 + i * 4;
+        auto orig   = pci_read32(_pdev, offset);
+        pci_write32(_pdev, offset, UINT32_MAX);
+        auto mask = pci_read32(_pdev, offset);
+        pci_write32(_pdev, offset, orig);
+        if (mask == 0) {
+            continue;
+        }
+        auto* bar = &_pdev->bars[i];
+        if ((orig & PCI_BAR_IO) != 0) {
+            // 不使用 io 空间，只记录大小
+            bar->flags = PCI_BAR_IO;
+            bar->size  = (~(mask & ~3U) + 1) & 0xFFFF;
+            continue;
+        }
+        bar->flags    = orig & (PCI_BAR_MEM64 | PCI_BAR_PREFETCH);
+        uint64_t base = orig & ~0xFU;
+        uint64_t size = mask & ~0xFU;
+        if (((bar->flags & PCI_BAR_MEM64) != 0) && (i + 1 < _count)) {
+            auto orig_hi = pci_read32(_pdev, offset + 4);
+            pci_write32(_pdev, offset + 4, UINT32_MAX);
+            auto mask_hi = pci_read32(_pdev, offset + 4);
+            pci_write32(_pdev, offset + 4, orig_hi);
+            base |= static_cast<uint64_t>(orig_hi) << 32;
+            size |= static_cast<uint64_t>(mask_hi) << 32;
+            // 高 32 位不再作为独立的 BAR
+            i++;
+        }
+        else {
+            size |= 0xFFFFFFFF00000000ULL;
+        }
+        bar->size = ~size + 1;
+        if (base == 0) {
+            // 64 位 BAR 优先使用 64 位窗口
+            auto* host = _pdev->host;
+            if (((bar->flags & PCI_BAR_MEM64) != 0)
+                && (host->mem64.size != 0)) {
+                base = window_alloc(&host->mem64, bar->size);
+            }
+            if (base == 0) {
+                base = window_alloc(&host->mem32, bar->size);
+            }
+            if ((base == 0)
+                || (((bar->flags & PCI_BAR_MEM64) == 0) && (base >> 32 != 0))) {
+                continue;
+            }
+            pci_write32(_pdev, offset, static_cast<uint32_t>(base));
+            if ((bar->flags & PCI_BAR_MEM64) != 0) {
+                pci_write32(_pdev, offset + 4,
+                            static_cast<uint32_t>(base >> 32));
+            }
+        }
+        bar->base = window_to_cpu(_pdev->host, base);
+    }
+    pci_write16(_pdev, PCI_COMMAND, cmd);
+    return;
+}
+
+static pci_device_t* pci_device_alloc(void) {
+    auto idx = __atomic_fetch_add(&pci_device_count, 1, __ATOMIC_RELAXED);
+    if (idx >= PCI_DEVICE_MAX) {
+        return nullptr;
+    }
+    auto* pdev = &pci_devices[idx];
+    memset(pdev, 0, sizeof(*pdev));
+    return pdev;
+}
+
+/**
+ * @brief 枚举一条总线，进入固件已配置的桥
+ * @param  _host                   主桥
+ * @param  _bus                    总线号
+ * @param  _parent                 上游的桥，根总线为主桥
+ * @param  _depth                  桥的嵌套深度
+ */
+static void pci_scan_bus(pci_host_t* _host, uint8_t _bus, device_t* _parent,
+                         size_t _depth) {
+    for (uint8_t slot = 0; slot < PCI_SLOT_COUNT; slot++) {
+        for (uint8_t func = 0; func < PCI_FUNC_COUNT; func++) {
+            auto config = _host->ecam + (static_cast<uintptr_t>(_bus) << 20)
+                          + (static_cast<uintptr_t>(slot) << 15)
+                          + (static_cast<uintptr_t>(func) << 12);
+            auto vendor = mmio_read16(
+              reinterpret_cast<volatile void*>(config + PCI_VENDOR_ID));
+            if (vendor == 0xFFFF) {
+                // 功能 0 不存在时插槽为空
+                if (func == 0) {
+                    break;
+                }
+                continue;
+            }
+            auto* pdev = pci_device_alloc();
+            if (pdev == nullptr) {
+                return;
+            }
+            pdev->host   = _host;
+            pdev->config = config;
+            pdev->bus    = _bus;
+            pdev->slot   = slot;
+            pdev->func   = func;
+            auto header  = pci_read8(pdev, PCI_HEADER_TYPE);
+            auto bridge  = (header & PCI_HEADER_TYPE_MASK)
+                          == PCI_HEADER_TYPE_BRIDGE;
+            // "ssss:bb:dd.f"
+            auto* name = hex_format(pdev->name, _host->segment, 4);
+            *name++    = ':';
+            name       = hex_format(name, _bus, 2);
+            *name++    = ':';
+            name       = hex_format(name, slot, 2);
+            *name++    = '.';
+            name       = hex_format(name, func, 1);
+            *name      = '\0';
+
+            device_init(&pdev->dev, pdev->name, &pci_bus, _parent);
+            pdev->dev.vendor     = vendor;
+            pdev->dev.device     = pci_read16(pdev, PCI_DEVICE_ID);
+            pdev->dev.class_code = pci_read32(pdev, PCI_CLASS_REVISION) >> 8;
+            bar_probe(pdev, bridge ? PCI_BRIDGE_BARS : PCI_BAR_COUNT);
+            device_add(&pdev->dev);
+
+            if (bridge) {
+                auto secondary = pci_read8(pdev, PCI_SECONDARY_BUS);
+                if ((secondary > _bus) && (secondary <= _host->bus_end)
+                    && (_depth < PCI_BRIDGE_DEPTH)) {
+                    pci_scan_bus(_host, secondary, &pdev->dev, _depth + 1);
+                }
+            }
+            if ((func == 0) && ((header & PCI_HEADER_MULTI_FUNC) == 0)) {
+                break;
+            }
+        }
+    }
+    return;
+}
+
+/**
+ * @brief 从设备树节点读取总线范围与地址窗口
+ */
+static void host_from_fdt(pci_host_t* _host, int32_t _node) {
+    auto* bus_range  = fdt_get_prop(_node, "bus-range", nullptr);
+    auto* domain     = fdt_get_prop(_node, "linux,pci-domain", nullptr);
+    auto  buses      = _host->pdev->size >> 20;
+    _host->bus_start = bus_range == nullptr ? 0 : fdt_cell(bus_range, 0);
+    _host->bus_end   = bus_range == nullptr ? _host->bus_start + buses - 1
+                                            : fdt_cell(bus_range, 1);
+    _host->segment   = domain == nullptr ? 0 : fdt_cell(domain, 0);
+    // reg 从 bus_start 开始
+    _host->ecam
+      = _host->pdev->base - (static_cast<uintptr_t>(_host->bus_start) << 20);
+
+    // ranges 的每项: 3 个单元的 pci 地址，父节点的 cpu 地址，长度
+    size_t len;
+    auto*  ranges = fdt_get_prop(_node, "ranges", &len);
+    if (ranges == nullptr) {
+        return;
+    }
+    uint32_t parent_cells;
+    uint32_t unused;
+    uint32_t size_cells;
+    fdt_cells_of(fdt_parent(_node), &parent_cells, &unused);
+    fdt_cells_of(_node, &unused, &size_cells);
+    auto cells = 3 + parent_cells + size_cells;
+    for (size_t i = 0; (i + 1) * cells * 4 <= len; i++) {
+        auto  base   = i * cells;
+        auto  space  = (fdt_cell(ranges, base) >> RANGES_SPACE_SHIFT) & 3;
+        auto* window = space == RANGES_SPACE_MEM64   ? &_host->mem64
+                       : space == RANGES_SPACE_MEM32 ? &_host->mem32
+                                                     : nullptr;
+        if ((window == nullptr) || (window->size != 0)) {
+            continue;
+        }
+        window->pci_base = fdt_cells(ranges, base + 1, 2);
+        window->cpu_base = fdt_cells(ranges, base + 3, parent_cells);
+        window->size
+          = fdt_cells(ranges, base + 3 + parent_cells, size_cells);
+        // pci 地址 0 表示未分配，不从 0 开始分配
+        window->next = window->pci_base == 0 ? 0x1000 : window->pci_base;
+    }
+    return;
+}
+
+static int32_t pci_host_probe(device_t* _dev, const device_id_t* _id) {
+    (void)_id;
+    auto idx = __atomic_fetch_add(&pci_host_count, 1, __ATOMIC_RELAXED);
+    if (idx >= PCI_HOST_MAX) {
+        return PROBE_ERROR;
+    }
+    auto* host = &pci_hosts[idx];
+    host->pdev = to_platform_device(_dev);
+    if (host->pdev->fdt_node >= 0) {
+        host_from_fdt(host, host->pdev->fdt_node);
+    }
+    else if (host->pdev->acpi != nullptr) {
+        auto* alloc     = static_cast<const acpi_mcfg_alloc_t*>(
+          host->pdev->acpi);
+        host->ecam      = alloc->base;
+        host->segment   = alloc->segment;
+        host->bus_start = alloc->bus_start;
+        host->bus_end   = alloc->bus_end;
+    }
+    else {
+        return PROBE_ERROR;
+    }
+    _dev->driver_data = host;
+    pci_scan_bus(host, host->bus_start, _dev, 0);
+    return PROBE_OK;
+}
+
+static const device_id_t pci_host_ids[] = {
+    { 0, 0, 0, 0, "pci-host-ecam-generic", 0 },
+    {},
+};
+
+static driver_t pci_host_driver = {
+    {}, "pci-host-ecam", &platform_bus, pci_host_ids, pci_host_probe, nullptr,
+};
+
+DRIVER_INIT(pci_host_driver, DRIVER_LEVEL_BUS);
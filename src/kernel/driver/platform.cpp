@@ -0,0 +1,123 @@
+
+/**
+ * @file platform.cpp
+ * @brief 平台总线
+ * @author Zone.N (Zone.Niuzh@hotmail.com)
+ * @version 1.0
+ * @date 2026-10-18
+ * @copyright MIT LICENSE
+ * https://github.com/MRNIU/cmake-kernel
+ * @par change log:
+ * <table>
+ * <tr><th>Date<th>Author<th>Description
+ * <tr><td>2026-10-18<td>Zone.N (Zone.Niuzh@hotmail.com)<td>创建文件
+ * </table>
+ */
+
+#include "platform.h"
+
+#include "acpi.h"
+#include "arch.h"
+#include "fdt.h"
+#include "libc.h"
+
+/// 由 MCFG 表生成的设备使用的 compatible，包括结尾的 '\0'
+static constexpr const char ECAM_COMPATIBLE[] = "pci-host-ecam-generic";
+
+bus_t platform_bus = { "platform", nullptr, {}, {}, {}, 0 };
+
+/// 静态分配的平台设备
+static platform_device_t platform_devices[PLATFORM_DEVICE_MAX];
+static size_t            platform_device_count;
+
+platform_device_t* to_platform_device(device_t* _dev) {
+    return reinterpret_cast<platform_device_t*>(
+      reinterpret_cast<uint8_t*>(_dev) - offsetof(platform_device_t, dev));
+}
+
+/**
+ * @brief 以 _digits 位小写十六进制写入 _val，并以 '\0' 结尾
+ */
+static void hex_format(char* _buf, uint64_t _val, size_t _digits) {
+    for (size_t i = 0; i < _digits; i++) {
+        _buf[_digits - 1 - i] = "0123456789abcdef"[_val & 0xF];
+        _val                  >>= 4;
+    }
+    _buf[_digits] = '\0';
+    return;
+}
+
+static platform_device_t* platform_device_alloc(void) {
+    if (platform_device_count == PLATFORM_DEVICE_MAX) {
+        return nullptr;
+    }
+    auto* pdev     = &platform_devices[platform_device_count++];
+    pdev->fdt_node = -1;
+    pdev->acpi     = nullptr;
+    pdev->base     = 0;
+    pdev->size     = 0;
+    return pdev;
+}
+
+static void platform_fdt_scan(void) {
+    if (!fdt_init(arch_fdt())) {
+        return;
+    }
+    int32_t depth = 0;
+    for (auto node = fdt_next_node(-1, &depth); node >= 0;
+         node      = fdt_next_node(node, &depth)) {
+        size_t len;
+        auto*  compatible = fdt_get_prop(node, "compatible", &len);
+        // 根节点的 compatible 描述的是机器
+        if ((depth == 0) || (compatible == nullptr)
+            || !fdt_node_available(node)) {
+            continue;
+        }
+        auto* pdev = platform_device_alloc();
+        if (pdev == nullptr) {
+            return;
+        }
+        // 节点名在设备树中，不需要复制
+        device_init(&pdev->dev, fdt_node_name(node), &platform_bus, nullptr);
+        pdev->dev.compatible     = static_cast<const char*>(compatible);
+        pdev->dev.compatible_len = len;
+        pdev->fdt_node           = node;
+        fdt_get_reg(node, 0, &pdev->base, &pdev->size);
+        device_add(&pdev->dev);
+    }
+    return;
+}
+
+static void platform_acpi_scan(void) {
+    if (!acpi_init(arch_acpi_rsdp())) {
+        return;
+    }
+    for (size_t i = 0;; i++) {
+        auto* alloc = acpi_mcfg_alloc(i);
+        if (alloc == nullptr) {
+            return;
+        }
+        auto* pdev = platform_device_alloc();
+        if (pdev == nullptr) {
+            return;
+        }
+        // "pci" 与 4 位十六进制段号
+        memcpy(pdev->name, "pci", 3);
+        hex_format(pdev->name + 3, alloc->segment, 4);
+        device_init(&pdev->dev, pdev->name, &platform_bus, nullptr);
+        // base 对应 bus 0，每条总线 1MB
+        auto buses               = static_cast<uint64_t>(alloc->bus_end) + 1;
+        pdev->dev.compatible     = ECAM_COMPATIBLE;
+        pdev->dev.compatible_len = sizeof(ECAM_COMPATIBLE);
+        pdev->acpi               = alloc;
+        pdev->base               = alloc->base;
+        pdev->size               = buses << 20;
+        device_add(&pdev->dev);
+    }
+}
+
+void platform_init(void) {
+    platform_fdt_scan();
+    platform_acpi_scan();
+    return;
+}
@@ -0,0 +1,362 @@
+
+/**
+ * @file virtio.cpp
+ * @brief virtio-pci 传输层与 split 虚拟队列
+ * @author Zone.N (Zone.Niuzh@hotmail.com)
+ * @version 1.0
+ * @date 2026-10-18
+ * @copyright MIT LICENSE
+ * https://github.com/MRNIU/cmake-kernel
+ * @par change log:
+ * <table>
+ * <tr><th>Date<th>Author<th>Description
+ * <tr><td>2026-10-18<td>Zone.N (Zone.Niuzh@hotmail.com)<td>创建文件
+ * </table>
+ */
+
+#include "virtio.h"
+
+#include "cpu.h"
+#include "io.h"
+
+/// virtio 能力的类型
+static constexpr const uint8_t  VIRTIO_PCI_CAP_COMMON_CFG = 1;
+static constexpr const uint8_t  VIRTIO_PCI_CAP_NOTIFY_CFG = 2;
+static constexpr const uint8_t  VIRTIO_PCI_CAP_DEVICE_CFG = 4;
+/// virtio 能力中的字段
+static constexpr const uint32_t VIRTIO_CAP_CFG_TYPE       = 3;
+static constexpr const uint32_t VIRTIO_CAP_BAR            = 4;
+static constexpr const uint32_t VIRTIO_CAP_OFFSET         = 8;
+static constexpr const uint32_t VIRTIO_CAP_NOTIFY_MULT    = 16;
+
+/// 通用配置中的寄存器
+static constexpr const uint32_t COMMON_DFSELECT           = 0;
+static constexpr const uint32_t COMMON_DF                 = 4;
+static constexpr const uint32_t COMMON_GFSELECT           = 8;
+static constexpr const uint32_t COMMON_GF                 = 12;
+static constexpr const uint32_t COMMON_MSIX               = 16;
+static constexpr const uint32_t COMMON_NUMQ               = 18;
+static constexpr const uint32_t COMMON_STATUS             = 20;
+static constexpr const uint32_t COMMON_CFGGENERATION      = 21;
+static constexpr const uint32_t COMMON_Q_SELECT           = 22;
+static constexpr const uint32_t COMMON_Q_SIZE             = 24;
+static constexpr const uint32_t COMMON_Q_MSIX             = 26;
+static constexpr const uint32_t COMMON_Q_ENABLE           = 28;
+static constexpr const uint32_t COMMON_Q_NOFF             = 30;
+static constexpr const uint32_t COMMON_Q_DESCLO           = 32;
+static constexpr const uint32_t COMMON_Q_DESCHI           = 36;
+static constexpr const uint32_t COMMON_Q_AVAILLO          = 40;
+static constexpr const uint32_t COMMON_Q_AVAILHI          = 44;
+static constexpr const uint32_t COMMON_Q_USEDLO           = 48;
+static constexpr const uint32_t COMMON_Q_USEDHI           = 52;
+
+/**
+ * @brief 一个虚拟队列的内存，按规范要求对齐
+ */
+struct virtq_mem_t {
+    alignas(4096) virtq_desc_t desc[VIRTQ_SIZE_MAX];
+    alignas(2) virtq_avail_t avail;
+    alignas(4) virtq_used_t used;
+};
+
+/// 静态分配的虚拟队列
+static virtqueue_t virtqueues[VIRTQUEUE_MAX];
+static virtq_mem_t virtq_mems[VIRTQUEUE_MAX];
+static size_t      virtqueue_count;
+
+static uint16_t read_once(const uint16_t* _ptr) {
+    return *static_cast<const volatile uint16_t*>(_ptr);
+}
+
+static void write_once(uint16_t* _ptr, uint16_t _val) {
+    *static_cast<volatile uint16_t*>(_ptr) = _val;
+    return;
+}
+
+/**
+ * @brief 设备是否需要事件，new_idx 越过了 _event
+ */
+static bool need_event(uint16_t _event, uint16_t _new, uint16_t _old) {
+    return static_cast<uint16_t>(_new - _event - 1)
+           < static_cast<uint16_t>(_new - _old);
+}
+
+bool virtio_pci_init(virtio_device_t* _vdev, pci_device_t* _pdev) {
+    _vdev->pdev     = _pdev;
+    _vdev->common   = nullptr;
+    _vdev->notify   = nullptr;
+    _vdev->device   = nullptr;
+    _vdev->features = 0;
+    for (auto pos = pci_find_capability(_pdev, PCI_CAP_ID_VNDR, 0); pos != 0;
+         pos      = pci_find_capability(_pdev, PCI_CAP_ID_VNDR, pos)) {
+        auto  type = pci_read8(_pdev, pos + VIRTIO_CAP_CFG_TYPE);
+        auto* bar  = static_cast<volatile uint8_t*>(
+          pci_iomap(_pdev, pci_read8(_pdev, pos + VIRTIO_CAP_BAR)));
+        if (bar == nullptr) {
+            continue;
+        }
+        auto* addr = bar + pci_read32(_pdev, pos + VIRTIO_CAP_OFFSET);
+        // 同一类型有多个时使用第一个
+        if ((type == VIRTIO_PCI_CAP_COMMON_CFG) && (_vdev->common == nullptr)) {
+            _vdev->common = addr;
+        }
+        else if ((type == VIRTIO_PCI_CAP_NOTIFY_CFG)
+                 && (_vdev->notify == nullptr)) {
+            _vdev->notify = addr;
+            _vdev->notify_multiplier
+              = pci_read32(_pdev, pos + VIRTIO_CAP_NOTIFY_MULT);
+        }
+        else if ((type == VIRTIO_PCI_CAP_DEVICE_CFG)
+                 && (_vdev->device == nullptr)) {
+            _vdev->device = addr;
+        }
+    }
+    return (_vdev->common != nullptr) && (_vdev->notify != nullptr);
+}
+
+void virtio_reset(virtio_device_t* _vdev) {
+    mmio_write8(_vdev->common + COMMON_STATUS, 0);
+    // 读到 0 时复位完成
+    while (mmio_read8(_vdev->common + COMMON_STATUS) != 0) {
+        cpu_relax();
+    }
+    return;
+}
+
+void virtio_add_status(virtio_device_t* _vdev, uint8_t _status) {
+    auto status = mmio_read8(_vdev->common + COMMON_STATUS);
+    mmio_write8(_vdev->common + COMMON_STATUS, status | _status);
+    return;
+}
+
+bool virtio_negotiate(virtio_device_t* _vdev, uint64_t _wanted) {
+    mmio_write32(_vdev->common + COMMON_DFSELECT, 0);
+    uint64_t features = mmio_read32(_vdev->common + COMMON_DF);
+    mmio_write32(_vdev->common + COMMON_DFSELECT, 1);
+    features |= static_cast<uint64_t>(mmio_read32(_vdev->common + COMMON_DF))
+                << 32;
+    features &= _wanted | (1ULL << VIRTIO_F_VERSION_1);
+    if ((features & (1ULL << VIRTIO_F_VERSION_1)) == 0) {
+        return false;
+    }
+    mmio_write32(_vdev->common + COMMON_GFSELECT, 0);
+    mmio_write32(_vdev->common + COMMON_GF, static_cast<uint32_t>(features));
+    mmio_write32(_vdev->common + COMMON_GFSELECT, 1);
+    mmio_write32(_vdev->common + COMMON_GF,
+                 static_cast<uint32_t>(features >> 32));
+    virtio_add_status(_vdev, VIRTIO_STATUS_FEATURES_OK);
+    if ((mmio_read8(_vdev->common + COMMON_STATUS)
+         & VIRTIO_STATUS_FEATURES_OK)
+        == 0) {
+        return false;
+    }
+    _vdev->features = features;
+    return true;
+}
+
+bool virtio_has_feature(const virtio_device_t* _vdev, uint32_t _bit) {
+    return (_vdev->features & (1ULL << _bit)) != 0;
+}
+
+uint16_t virtio_num_queues(const virtio_device_t* _vdev) {
+    return mmio_read16(_vdev->common + COMMON_NUMQ);
+}
+
+void virtio_set_config_vector(virtio_device_t* _vdev, uint16_t _vector) {
+    mmio_write16(_vdev->common + COMMON_MSIX, _vector);
+    return;
+}
+
+void virtio_ready(virtio_device_t* _vdev) {
+    virtio_add_status(_vdev, VIRTIO_STATUS_DRIVER_OK);
+    return;
+}
+
+uint16_t virtio_config_read16(virtio_device_t* _vdev, uint32_t _offset) {
+    return static_cast<uint16_t>(virtio_config_read64(_vdev, _offset));
+}
+
+uint32_t virtio_config_read32(virtio_device_t* _vdev, uint32_t _offset) {
+    uint8_t  gen;
+    uint32_t val;
+    do {
+        gen = mmio_read8(_vdev->common + COMMON_CFGGENERATION);
+        val = mmio_read32(_vdev->device + _offset);
+    } while (gen != mmio_read8(_vdev->common + COMMON_CFGGENERATION));
+    return val;
+}
+
+uint64_t virtio_config_read64(virtio_device_t* _vdev, uint32_t _offset) {
+    uint8_t  gen;
+    uint64_t val;
+    do {
+        gen = mmio_read8(_vdev->common + COMMON_CFGGENERATION);
+        val = mmio_read32(_vdev->device + _offset)
+              | static_cast<uint64_t>(mmio_read32(_vdev->device + _offset + 4))
+                  << 32;
+    } while (gen != mmio_read8(_vdev->common + COMMON_CFGGENERATION));
+    return val;
+}
+
+static void write_addr(virtio_device_t* _vdev, uint32_t _lo, uint32_t _hi,
+                       const void* _addr) {
+    auto addr = reinterpret_cast<uintptr_t>(_addr);
+    mmio_write32(_vdev->common + _lo, static_cast<uint32_t>(addr));
+    mmio_write32(_vdev->common + _hi, static_cast<uint32_t>(addr >> 32));
+    return;
+}
+
+virtqueue_t* virtqueue_create(virtio_device_t* _vdev, uint16_t _index,
+                              uint16_t _vector) {
+    auto* common = _vdev->common;
+    mmio_write16(common + COMMON_Q_SELECT, _index);
+    auto size = mmio_read16(common + COMMON_Q_SIZE);
+    if (size == 0) {
+        return nullptr;
+    }
+    auto idx = __atomic_fetch_add(&virtqueue_count, 1, __ATOMIC_RELAXED);
+    if (idx >= VIRTQUEUE_MAX) {
+        return nullptr;
+    }
+    auto* vq  = &virtqueues[idx];
+    auto* mem = &virtq_mems[idx];
+
+    vq->vdev        = _vdev;
+    vq->index       = _index;
+    vq->size        = size < VIRTQ_SIZE_MAX ? size : VIRTQ_SIZE_MAX;
+    vq->desc        = mem->desc;
+    vq->avail       = &mem->avail;
+    vq->used        = &mem->used;
+    vq->free_head   = 0;
+    vq->num_free    = vq->size;
+    vq->avail_idx   = 0;
+    vq->kicked_idx  = 0;
+    vq->last_used   = 0;
+    vq->event_idx   = virtio_has_feature(_vdev, VIRTIO_F_EVENT_IDX);
+    vq->cb_disabled = _vector == VIRTIO_MSI_NO_VECTOR;
+    for (uint16_t i = 0; i < vq->size; i++) {
+        vq->desc[i].next = i + 1;
+        vq->tokens[i]    = nullptr;
+    }
+    vq->avail->flags = vq->cb_disabled ? VIRTQ_AVAIL_F_NO_INTERRUPT : 0;
+    vq->avail->idx   = 0;
+
+    mmio_write16(common + COMMON_Q_SIZE, vq->size);
+    mmio_write16(common + COMMON_Q_MSIX, _vector);
+    // 设备无法分配向量时读回 NO_VECTOR
+    if (mmio_read16(common + COMMON_Q_MSIX) != _vector) {
+        return nullptr;
+    }
+    write_addr(_vdev, COMMON_Q_DESCLO, COMMON_Q_DESCHI, vq->desc);
+    write_addr(_vdev, COMMON_Q_AVAILLO, COMMON_Q_AVAILHI, vq->avail);
+    write_addr(_vdev, COMMON_Q_USEDLO, COMMON_Q_USEDHI, vq->used);
+    auto notify_off = mmio_read16(common + COMMON_Q_NOFF);
+    vq->notify      = reinterpret_cast<volatile uint16_t*>(
+      _vdev->notify + notify_off * _vdev->notify_multiplier);
+    mmio_write16(common + COMMON_Q_ENABLE, 1);
+    return vq;
+}
+
+bool virtqueue_add(virtqueue_t* _vq, const virtio_buf_t* _bufs, size_t _out,
+                   size_t _in, void* _token) {
+    auto total = _out + _in;
+    if ((total == 0) || (total > _vq->num_free)) {
+        return false;
+    }
+    auto head = _vq->free_head;
+    auto idx  = head;
+    for (size_t i = 0; i < total; i++) {
+        auto* desc  = &_vq->desc[idx];
+        desc->addr  = reinterpret_cast<uintptr_t>(_bufs[i].addr);
+        desc->len   = _bufs[i].len;
+        desc->flags = (i >= _out ? VIRTQ_DESC_F_WRITE : 0)
+                      | (i + 1 < total ? VIRTQ_DESC_F_NEXT : 0);
+        // 最后一个描述符的 next 仍指向空闲链表，设备不会读取
+        idx         = desc->next;
+    }
+    auto slot              = _vq->avail_idx % _vq->size;
+    _vq->free_head         = idx;
+    _vq->num_free          -= total;
+    _vq->tokens[head]      = _token;
+    _vq->avail->ring[slot] = head;
+    _vq->avail_idx++;
+    // 描述符与环中的项先于 idx 对设备可见
+    dma_wmb();
+    write_once(&_vq->avail->idx, _vq->avail_idx);
+    return true;
+}
+
+bool virtqueue_kick_prepare(virtqueue_t* _vq) {
+    // idx 的写入先于读取设备的通知抑制
+    dma_mb();
+    auto old        = _vq->kicked_idx;
+    _vq->kicked_idx = _vq->avail_idx;
+    if (old == _vq->avail_idx) {
+        return false;
+    }
+    if (_vq->event_idx) {
+        // avail_event 紧接在环之后
+        auto* event = reinterpret_cast<uint16_t*>(&_vq->used->ring[_vq->size]);
+        return need_event(read_once(event), _vq->avail_idx, old);
+    }
+    return (read_once(&_vq->used->flags) & VIRTQ_USED_F_NO_NOTIFY) == 0;
+}
+
+void virtqueue_notify(virtqueue_t* _vq) {
+    mmio_write16(_vq->notify, _vq->index);
+    return;
+}
+
+void* virtqueue_get_buf(virtqueue_t* _vq, uint32_t* _len) {
+    if (_vq->last_used == read_once(&_vq->used->idx)) {
+        return nullptr;
+    }
+    // 先读 idx 再读环中的项
+    dma_rmb();
+    auto* elem = &_vq->used->ring[_vq->last_used % _vq->size];
+    auto  head = static_cast<uint16_t>(elem->id);
+    if (_len != nullptr) {
+        *_len = elem->len;
+    }
+    auto* token       = _vq->tokens[head];
+    _vq->tokens[head] = nullptr;
+    // 把描述符链放回空闲链表
+    auto idx = head;
+    _vq->num_free++;
+    while ((_vq->desc[idx].flags & VIRTQ_DESC_F_NEXT) != 0) {
+        idx = _vq->desc[idx].next;
+        _vq->num_free++;
+    }
+    _vq->desc[idx].next = _vq->free_head;
+    _vq->free_head      = head;
+    _vq->last_used++;
+    // 推进 used_event，下一个完成时再产生中断
+    if (_vq->event_idx && !_vq->cb_disabled) {
+        write_once(&_vq->avail->ring[_vq->size], _vq->last_used);
+    }
+    return token;
+}
+
+void virtqueue_disable_cb(virtqueue_t* _vq) {
+    if (_vq->cb_disabled) {
+        return;
+    }
+    _vq->cb_disabled = true;
+    if (!_vq->event_idx) {
+        write_once(&_vq->avail->flags, VIRTQ_AVAIL_F_NO_INTERRUPT);
+    }
+    return;
+}
+
+bool virtqueue_enable_cb(virtqueue_t* _vq) {
+    _vq->cb_disabled = false;
+    if (_vq->event_idx) {
+        write_once(&_vq->avail->ring[_vq->size], _vq->last_used);
+    }
+    else {
+        write_once(&_vq->avail->flags, 0);
+    }
+    // 写入先于读取 used->idx，避免漏掉在此期间完成的项
+    dma_mb();
+    return _vq->last_used == read_once(&_vq->used->idx);
+}
@@ -0,0 +1,346 @@
+
+/**
+ * @file virtio_blk.cpp
+ * @brief virtio 块设备驱动
+ * @author Zone.N (Zone.Niuzh@hotmail.com)
+ * @version 1.0
+ * @date 2026-10-18
+ * @copyright MIT LICENSE
+ * https://github.com/MRNIU/cmake-kernel
+ * @par change log:
+ * <table>
+ * <tr><th>Date<th>Author<th>Description
+ * <tr><td>2026-10-18<td>Zone.N (Zone.Niuzh@hotmail.com)<td>创建文件
+ * </table>
+ */
+
+#include "blkdev.h"
+#include "smp.h"
+#include "spinlock.hpp"
+#include "virtio.h"
+
+/// 设备号，transitional 与 modern
+static constexpr const uint32_t VIRTIO_BLK_ID_TRANSITIONAL = 0x1001;
+static constexpr const uint32_t VIRTIO_BLK_ID_MODERN       = 0x1042;
+
+/// 块设备特性位
+static constexpr const uint32_t VIRTIO_BLK_F_SIZE_MAX      = 1;
+static constexpr const uint32_t VIRTIO_BLK_F_SEG_MAX       = 2;
+static constexpr const uint32_t VIRTIO_BLK_F_BLK_SIZE      = 6;
+static constexpr const uint32_t VIRTIO_BLK_F_FLUSH         = 9;
+static constexpr const uint32_t VIRTIO_BLK_F_MQ            = 12;
+
+/// 设备配置中的字段
+static constexpr const uint32_t VIRTIO_BLK_CFG_CAPACITY    = 0;
+static constexpr const uint32_t VIRTIO_BLK_CFG_SIZE_MAX    = 8;
+static constexpr const uint32_t VIRTIO_BLK_CFG_SEG_MAX     = 12;
+static constexpr const uint32_t VIRTIO_BLK_CFG_BLK_SIZE    = 20;
+static constexpr const uint32_t VIRTIO_BLK_CFG_NUM_QUEUES  = 34;
+
+/// 请求类型
+static constexpr const uint32_t VIRTIO_BLK_T_IN            = 0;
+static constexpr const uint32_t VIRTIO_BLK_T_OUT           = 1;
+static constexpr const uint32_t VIRTIO_BLK_T_FLUSH         = 4;
+/// 请求状态
+static constexpr const uint8_t  VIRTIO_BLK_S_OK            = 0;
+static constexpr const uint8_t  VIRTIO_BLK_S_UNSUPP        = 2;
+
+/// 设备数上限
+static constexpr const size_t   VIRTIO_BLK_DEV_MAX         = 4;
+/// 单段请求使用的描述符: 请求头、数据、状态
+static constexpr const size_t   VIRTIO_BLK_DESCS           = 3;
+/// 每个队列的在途请求数上限，按单段请求计算，
+/// 多段请求用完描述符时 virtqueue_add 失败，请求留给块层重试
+static constexpr const size_t   VIRTIO_BLK_DEPTH
+  = VIRTQ_SIZE_MAX / VIRTIO_BLK_DESCS;
+static_assert(VIRTIO_BLK_DEPTH <= 64, "tags are a 64-bit mask");
+
+/// 数据描述符长度是 32 位，单个请求的扇区数上限
+static constexpr const uint32_t VIRTIO_BLK_MAX_SECTORS     = 0xFFFFF000
+                                                             >> SECTOR_SHIFT;
+
+/**
+ * @brief 请求头，设备只读
+ */
+struct virtio_blk_req_hdr_t {
+    uint32_t type;
+    uint32_t reserved;
+    uint64_t sector;
+};
+
+struct virtio_blk_t;
+
+/**
+ * @brief 一个硬件队列
+ * 中断与提交可能在不同 cpu 上，使用关中断的锁
+ */
+struct virtio_blk_queue_t {
+    TicketLock           lock;
+    virtio_blk_t*        vblk;
+    virtqueue_t*         vq;
+    /// 空闲的请求标签
+    uint64_t             free_tags;
+    /// 按标签保存的请求头、状态与请求
+    virtio_blk_req_hdr_t hdrs[VIRTIO_BLK_DEPTH];
+    uint8_t              status[VIRTIO_BLK_DEPTH];
+    blk_request_t*       rqs[VIRTIO_BLK_DEPTH];
+};
+
+/**
+ * @brief 一个 virtio 块设备
+ */
+struct virtio_blk_t {
+    virtio_device_t    vdev;
+    blk_dev_t          bdev;
+    virtio_blk_queue_t queues[BLK_HW_QUEUE_MAX];
+    /// "vda" 起
+    char               name[8];
+};
+
+static virtio_blk_t virtio_blks[VIRTIO_BLK_DEV_MAX];
+static size_t       virtio_blk_count;
+
+static int32_t blk_status(uint8_t _status) {
+    if (_status == VIRTIO_BLK_S_OK) {
+        return BLK_STS_OK;
+    }
+    return _status == VIRTIO_BLK_S_UNSUPP ? BLK_STS_NOTSUPP : BLK_STS_IOERR;
+}
+
+static size_t virtio_blk_queue_rqs(blk_dev_t* _bdev, size_t _hwq,
+                                   blk_request_t** _rqs, size_t _count) {
+    auto*  vblk     = static_cast<virtio_blk_t*>(_bdev->driver_data);
+    auto*  queue    = &vblk->queues[_hwq];
+    size_t accepted = 0;
+
+    IrqLockGuard<TicketLock> guard(queue->lock);
+    for (; (accepted < _count) && (queue->free_tags != 0); accepted++) {
+        auto* rq  = _rqs[accepted];
+        auto  tag = __builtin_ctzll(queue->free_tags);
+        auto* hdr = &queue->hdrs[tag];
+
+        hdr->type     = rq->op == BLK_OP_WRITE   ? VIRTIO_BLK_T_OUT
+                        : rq->op == BLK_OP_FLUSH ? VIRTIO_BLK_T_FLUSH
+                                                 : VIRTIO_BLK_T_IN;
+        hdr->reserved = 0;
+        hdr->sector   = rq->sector;
+        // 读请求的数据由设备写入，写请求的数据由设备读取
+        virtio_buf_t bufs[BLK_SEG_MAX + 2];
+        size_t       out = 1;
+        size_t       in  = 1;
+        bufs[0]          = { hdr, sizeof(*hdr) };
+        if (rq->op != BLK_OP_FLUSH) {
+            auto segs = blk_rq_nr_segs(rq);
+            for (uint32_t i = 0; i < segs; i++) {
+                auto seg    = blk_rq_seg(rq, i);
+                bufs[1 + i] = { seg.buffer, seg.len };
+            }
+            if (rq->op == BLK_OP_WRITE) {
+                out += segs;
+            }
+            else {
+                in += segs;
+            }
+        }
+        bufs[out + in - 1] = { &queue->status[tag], 1 };
+        if (!virtqueue_add(queue->vq, bufs, out, in,
+                           reinterpret_cast<void*>(tag + 1))) {
+            break;
+        }
+        queue->free_tags &= ~(1ULL << tag);
+        queue->rqs[tag]   = rq;
+    }
+    return accepted;
+}
+
+static void virtio_blk_commit(blk_dev_t* _bdev, size_t _hwq) {
+    auto* vblk  = static_cast<virtio_blk_t*>(_bdev->driver_data);
+    auto* queue = &vblk->queues[_hwq];
+    bool  kick;
+    {
+        IrqLockGuard<TicketLock> guard(queue->lock);
+        kick = virtqueue_kick_prepare(queue->vq);
+    }
+    // 通知是一次 mmio 写，会导致虚拟机退出，不在锁内进行
+    if (kick) {
+        virtqueue_notify(queue->vq);
+    }
+    return;
+}
+
+/**
+ * @brief 收取已完成的请求，解锁后再调用 end_io
+ * @param  _queue                  队列
+ * @param  _irq                    是否在中断中，是则收取后重新请求中断
+ * @return size_t                  完成数
+ */
+static size_t virtio_blk_complete(virtio_blk_queue_t* _queue, bool _irq) {
+    blk_request_t* done[VIRTIO_BLK_DEPTH];
+    size_t         count = 0;
+    {
+        IrqLockGuard<TicketLock> guard(_queue->lock);
+        do {
+            if (_irq) {
+                virtqueue_disable_cb(_queue->vq);
+            }
+            void* token;
+            while ((token = virtqueue_get_buf(_queue->vq, nullptr))
+                   != nullptr) {
+                auto tag          = reinterpret_cast<uintptr_t>(token) - 1;
+                auto* rq          = _queue->rqs[tag];
+                rq->status        = blk_status(_queue->status[tag]);
+                _queue->rqs[tag]  = nullptr;
+                _queue->free_tags |= 1ULL << tag;
+                done[count++]     = rq;
+            }
+        } while (_irq && !virtqueue_enable_cb(_queue->vq));
+    }
+    for (size_t i = 0; i < count; i++) {
+        done[i]->end_io(done[i]);
+    }
+    return count;
+}
+
+static size_t virtio_blk_poll(blk_dev_t* _bdev, size_t _hwq) {
+    auto* vblk = static_cast<virtio_blk_t*>(_bdev->driver_data);
+    return virtio_blk_complete(&vblk->queues[_hwq], false);
+}
+
+static void virtio_blk_irq(void* _arg) {
+    virtio_blk_complete(static_cast<virtio_blk_queue_t*>(_arg), true);
+    return;
+}
+
+static const blk_dev_ops_t virtio_blk_ops = {
+    virtio_blk_queue_rqs,
+    virtio_blk_commit,
+    virtio_blk_poll,
+};
+
+/**
+ * @brief 为每个队列申请发往使用该队列的 cpu 的中断
+ * @return true                    全部成功
+ * @return false                   不支持 MSI-X 或中断不足，已申请的被释放
+ */
+static bool virtio_blk_setup_irqs(virtio_blk_t* _vblk, size_t _queues) {
+    auto* pdev = _vblk->vdev.pdev;
+    if (pci_msix_enable(pdev, _queues) < _queues) {
+        return false;
+    }
+    for (size_t i = 0; i < _queues; i++) {
+        if (!pci_irq_request(pdev, i, pci_queue_cpu(i, _queues),
+                             virtio_blk_irq, &_vblk->queues[i])) {
+            for (size_t j = 0; j < i; j++) {
+                pci_irq_free(pdev, j);
+            }
+            return false;
+        }
+    }
+    return true;
+}
+
+static int32_t virtio_blk_probe(device_t* _dev, const device_id_t* _id) {
+    (void)_id;
+    auto* pdev = to_pci_device(_dev);
+    auto  idx  = __atomic_fetch_add(&virtio_blk_count, 1, __ATOMIC_RELAXED);
+    if (idx >= VIRTIO_BLK_DEV_MAX) {
+        return PROBE_ERROR;
+    }
+    auto* vblk = &virtio_blks[idx];
+    auto* vdev = &vblk->vdev;
+    pci_enable(pdev);
+    if (!virtio_pci_init(vdev, pdev) || (vdev->device == nullptr)) {
+        return PROBE_ERROR;
+    }
+    virtio_reset(vdev);
+    virtio_add_status(vdev, VIRTIO_STATUS_ACKNOWLEDGE | VIRTIO_STATUS_DRIVER);
+    uint64_t wanted = (1ULL << VIRTIO_F_EVENT_IDX)
+                      | (1ULL << VIRTIO_BLK_F_SIZE_MAX)
+                      | (1ULL << VIRTIO_BLK_F_SEG_MAX)
+                      | (1ULL << VIRTIO_BLK_F_BLK_SIZE)
+                      | (1ULL << VIRTIO_BLK_F_FLUSH)
+                      | (1ULL << VIRTIO_BLK_F_MQ);
+    if (!virtio_negotiate(vdev, wanted)) {
+        virtio_add_status(vdev, VIRTIO_STATUS_FAILED);
+        return PROBE_ERROR;
+    }
+
+    // 每个 cpu 一个队列，设备支持的更少时多个 cpu 共用
+    size_t queues = 1;
+    if (virtio_has_feature(vdev, VIRTIO_BLK_F_MQ)) {
+        queues = virtio_config_read16(vdev, VIRTIO_BLK_CFG_NUM_QUEUES);
+    }
+    auto cpus = smp_cpu_count();
+    queues    = queues < cpus ? queues : cpus;
+    queues    = queues < BLK_HW_QUEUE_MAX ? queues : BLK_HW_QUEUE_MAX;
+    queues    = queues == 0 ? 1 : queues;
+
+    // 配置为轮询模式或架构不支持 MSI 时不使用中断
+    bool polled = BLK_POLL || !virtio_blk_setup_irqs(vblk, queues);
+    virtio_set_config_vector(vdev, VIRTIO_MSI_NO_VECTOR);
+    size_t depth = VIRTIO_BLK_DEPTH;
+    for (size_t i = 0; i < queues; i++) {
+        auto*    queue = &vblk->queues[i];
+        uint16_t vector
+          = polled ? VIRTIO_MSI_NO_VECTOR : static_cast<uint16_t>(i);
+        queue->vblk = vblk;
+        queue->vq   = virtqueue_create(vdev, i, vector);
+        if (queue->vq == nullptr) {
+            virtio_add_status(vdev, VIRTIO_STATUS_FAILED);
+            return PROBE_ERROR;
+        }
+        auto qdepth      = queue->vq->size / VIRTIO_BLK_DESCS;
+        depth            = qdepth < depth ? qdepth : depth;
+        queue->free_tags = qdepth == 64 ? ~0ULL : (1ULL << qdepth) - 1;
+    }
+    virtio_ready(vdev);
+
+    auto* bdev     = &vblk->bdev;
+    vblk->name[0]  = 'v';
+    vblk->name[1]  = 'd';
+    vblk->name[2]  = static_cast<char>('a' + idx);
+    vblk->name[3]  = '\0';
+    bdev->name     = vblk->name;
+    bdev->dev      = _dev;
+    bdev->capacity = virtio_config_read64(vdev, VIRTIO_BLK_CFG_CAPACITY);
+    bdev->block_size
+      = virtio_has_feature(vdev, VIRTIO_BLK_F_BLK_SIZE)
+          ? virtio_config_read32(vdev, VIRTIO_BLK_CFG_BLK_SIZE)
+          : SECTOR_SIZE;
+    bdev->max_sectors = VIRTIO_BLK_MAX_SECTORS;
+    if (virtio_has_feature(vdev, VIRTIO_BLK_F_SIZE_MAX)) {
+        auto size_max = virtio_config_read32(vdev, VIRTIO_BLK_CFG_SIZE_MAX)
+                        >> SECTOR_SHIFT;
+        if ((size_max != 0) && (size_max < bdev->max_sectors)) {
+            bdev->max_sectors = size_max;
+        }
+    }
+    bdev->max_segs = BLK_SEG_MAX;
+    if (virtio_has_feature(vdev, VIRTIO_BLK_F_SEG_MAX)) {
+        auto seg_max = virtio_config_read32(vdev, VIRTIO_BLK_CFG_SEG_MAX);
+        if ((seg_max != 0) && (seg_max < bdev->max_segs)) {
+            bdev->max_segs = seg_max;
+        }
+    }
+    // 每段一个描述符，段的位置没有限制
+    bdev->seg_boundary = 0;
+    bdev->nr_hw_queues = queues;
+    bdev->queue_depth  = depth;
+    bdev->poll_queues  = polled ? ~0ULL >> (64 - queues) : 0;
+    bdev->ops          = &virtio_blk_ops;
+    bdev->driver_data  = vblk;
+    _dev->driver_data  = vblk;
+    return blk_register(bdev) ? PROBE_OK : PROBE_ERROR;
+}
+
+static const device_id_t virtio_blk_ids[] = {
+    { VIRTIO_PCI_VENDOR, VIRTIO_BLK_ID_TRANSITIONAL, 0, 0, nullptr, 0 },
+    { VIRTIO_PCI_VENDOR, VIRTIO_BLK_ID_MODERN, 0, 0, nullptr, 0 },
+    {},
+};
+
+static driver_t virtio_blk_driver = {
+    {}, "virtio-blk", &pci_bus, virtio_blk_ids, virtio_blk_probe, nullptr,
+};
+
+DRIVER_INIT(virtio_blk_driver, DRIVER_LEVEL_DEVICE);
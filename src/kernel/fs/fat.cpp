@@ -0,0 +1,1104 @@
+
+/**
+ * @file fat.cpp
+ * @brief FAT 文件系统
+ * @author Zone.N (Zone.Niuzh@hotmail.com)
+ * @version 1.0
+ * @date 2026-10-18
+ * @copyright MIT LICENSE
+ * https://github.com/MRNIU/cmake-kernel
+ * @par change log:
+ * <table>
+ * <tr><th>Date<th>Author<th>Description
+ * <tr><td>2026-10-18<td>Zone.N (Zone.Niuzh@hotmail.com)<td>创建文件
+ * </table>
+ */
+
+#include "fat.h"
+
+#include "driver.h"
+#include "flat_hash_map.hpp"
+#include "intrusive_list.hpp"
+#include "libc.h"
+#include "mutex.h"
+#include "new"
+#include "pagecache.h"
+#include "sched.h"
+#include "spinlock.hpp"
+#include "wait.h"
+
+/// 同时挂载的文件系统数
+static constexpr const size_t   FAT_FS_MAX        = 2;
+/// 文件表的大小，包括引用已释放但仍保留缓存的文件
+static constexpr const size_t   FAT_FILES         = 64;
+/// 每个文件缓存的 extent 数
+static constexpr const size_t   FAT_EXTENTS       = 32;
+/// 解码簇链时，在需要的簇之后沿连续的簇继续解码的最大簇数
+static constexpr const uint32_t FAT_DECODE_AHEAD  = 4096;
+/// 每个文件系统的目录项缓存与完整缓存的目录的槽数
+static constexpr const size_t   FAT_DENTRIES      = 4096;
+static constexpr const size_t   FAT_DIRS          = 128;
+/// 簇链结束
+static constexpr const uint32_t FAT_EOC           = 0xFFFFFFFF;
+/// 第一个数据簇的簇号
+static constexpr const uint32_t FAT_FIRST_CLUSTER = 2;
+/// FAT12 与 FAT16 的簇数上限，按簇数区分 FAT 类型
+static constexpr const uint32_t FAT12_CLUSTERS    = 4085;
+static constexpr const uint32_t FAT16_CLUSTERS    = 65525;
+/// FAT32 的表项只使用低 28 位
+static constexpr const uint32_t FAT32_MASK        = 0x0FFFFFFF;
+/// 不小于该值的表项表示簇链结束
+static constexpr const uint32_t FAT16_EOC         = 0xFFF8;
+static constexpr const uint32_t FAT32_EOC         = 0x0FFFFFF8;
+/// FAT32 只使用一份 FAT，低 4 位为使用的 FAT
+static constexpr const uint16_t FAT32_NO_MIRROR   = 0x80;
+static constexpr const uint16_t FAT32_ACTIVE_MASK = 0x0F;
+/// 目录项大小与目录的最大项数
+static constexpr const size_t   DIRENT_SIZE       = 32;
+static constexpr const size_t   DIR_ENTRIES_MAX   = 65536;
+/// 目录结束与已删除的目录项
+static constexpr const uint8_t  DIRENT_END        = 0x00;
+static constexpr const uint8_t  DIRENT_FREE       = 0xE5;
+/// 首字节为 0xE5 的短文件名存储为 0x05
+static constexpr const uint8_t  DIRENT_KANJI      = 0x05;
+/// 短文件名的基本名与扩展名为小写，位于 NT 保留字节
+static constexpr const uint8_t  NT_LOWER_BASE     = 0x08;
+static constexpr const uint8_t  NT_LOWER_EXT      = 0x10;
+/// 长文件名目录项的属性
+static constexpr const uint8_t  ATTR_LFN          = 0x0F;
+static constexpr const uint8_t  ATTR_LFN_MASK     = 0x3F;
+/// 长文件名的最后一项，以及序号
+static constexpr const uint8_t  LFN_LAST          = 0x40;
+static constexpr const uint8_t  LFN_SEQ_MASK      = 0x1F;
+/// 每个长文件名目录项的字符数与一个文件名的最大项数
+static constexpr const size_t   LFN_CHARS         = 13;
+static constexpr const size_t   LFN_ENTRIES_MAX   = 20;
+/// 引导扇区的签名
+static constexpr const size_t   BOOT_SIG_OFFSET   = 510;
+/// MBR 分区表
+static constexpr const size_t   MBR_PART_OFFSET   = 446;
+static constexpr const size_t   MBR_PART_SIZE     = 16;
+static constexpr const size_t   MBR_PARTS         = 4;
+/// GPT 保护分区的类型
+static constexpr const uint8_t  MBR_TYPE_GPT      = 0xEE;
+/// 检查的 GPT 分区项数
+static constexpr const uint32_t GPT_ENTRIES_MAX   = 128;
+static constexpr const uint32_t GPT_ENTRY_SIZE    = 128;
+
+/**
+ * @brief 引导扇区中的 BPB，FAT32 的扩展部分在 FAT16 上不使用
+ */
+struct fat_bpb_t {
+    uint8_t  jump[3];
+    char     oem[8];
+    uint16_t bytes_per_sec;
+    uint8_t  sec_per_clus;
+    uint16_t rsvd_sec;
+    uint8_t  num_fats;
+    uint16_t root_ent;
+    uint16_t tot_sec16;
+    uint8_t  media;
+    uint16_t fat_sz16;
+    uint16_t sec_per_trk;
+    uint16_t num_heads;
+    uint32_t hidden_sec;
+    uint32_t tot_sec32;
+    uint32_t fat_sz32;
+    uint16_t ext_flags;
+    uint16_t fs_ver;
+    uint32_t root_clus;
+} __attribute__((packed));
+
+/**
+ * @brief 短文件名目录项
+ */
+struct fat_raw_dirent_t {
+    uint8_t  name[11];
+    uint8_t  attr;
+    uint8_t  nt_res;
+    uint8_t  crt_time_tenth;
+    uint16_t crt_time;
+    uint16_t crt_date;
+    uint16_t acc_date;
+    uint16_t cluster_hi;
+    uint16_t wrt_time;
+    uint16_t wrt_date;
+    uint16_t cluster_lo;
+    uint32_t size;
+} __attribute__((packed));
+
+/**
+ * @brief 长文件名目录项，位于对应的短文件名项之前，序号倒序排列
+ */
+struct fat_lfn_dirent_t {
+    uint8_t  ord;
+    uint16_t name1[5];
+    uint8_t  attr;
+    uint8_t  type;
+    /// 对应的短文件名的校验和
+    uint8_t  checksum;
+    uint16_t name2[6];
+    uint16_t cluster_lo;
+    uint16_t name3[2];
+} __attribute__((packed));
+
+static_assert(sizeof(fat_raw_dirent_t) == DIRENT_SIZE);
+static_assert(sizeof(fat_lfn_dirent_t) == DIRENT_SIZE);
+
+/**
+ * @brief 簇链中设备上连续的一段
+ */
+struct fat_extent_t {
+    /// 文件内的簇号
+    uint32_t file_cluster;
+    /// 设备上的簇号
+    uint32_t disk_cluster;
+    uint32_t count;
+};
+
+/**
+ * @brief 目录项缓存中的一项
+ * 按 (目录, 名称) 的 64 位哈希值索引，不保存名称，命中时比较目录与名称长度
+ */
+struct fat_dentry_t {
+    /// 所在目录的首簇
+    uint32_t dir;
+    uint32_t cluster;
+    uint32_t size;
+    uint32_t attr;
+    uint32_t len;
+};
+
+struct fat_fs_t {
+    /// 为 nullptr 时空闲
+    blk_dev_t*                                        bdev;
+    /// 整个设备的缓存，用于读取分区表、FAT 与 FAT16 的根目录
+    pcache_mapping_t                                  meta;
+    /// 16 或 32
+    uint32_t                                          bits;
+    /// 簇大小的位移，以扇区为单位
+    uint32_t                                          cluster_shift;
+    /// 数据簇数
+    uint32_t                                          nr_clusters;
+    /// 各区域在设备上的起始扇区，FAT 为使用中的一份
+    uint64_t                                          fat_start;
+    uint64_t                                          root_start;
+    uint32_t                                          root_sectors;
+    uint64_t                                          data_start;
+    /// FAT32 根目录的首簇，FAT16 的根目录在固定区域，为 0
+    uint32_t                                          root_cluster;
+    /// 根目录，始终持有引用
+    fat_file_t*                                       root;
+    /// 保护目录项缓存
+    TicketLock                                        dcache_lock;
+    FlatHashMap<uint64_t, fat_dentry_t, FAT_DENTRIES> dcache;
+    /// 全部项都在 dcache 中的目录，不在 dcache 中的名称不存在
+    FlatHashMap<uint32_t, bool, FAT_DIRS>             dirs;
+    /// dcache 清空时加一，扫描期间被清空的目录不标记为完整
+    uint64_t                                          dcache_gen;
+};
+
+struct fat_file_t {
+    pcache_mapping_t mapping;
+    /// 为 nullptr 时空闲
+    fat_fs_t*        fs;
+    /// 首簇，FAT16 的根目录为 0
+    uint32_t         cluster;
+    uint32_t         attr;
+    /// 为 0 时在 lru_files 中，缓存保留到文件表需要空位时
+    uint32_t         refcount;
+    /// 保护簇链的解码
+    Mutex            lock;
+    /// 已解码的部分，按文件内的簇号排列
+    fat_extent_t     extents[FAT_EXTENTS];
+    uint32_t         nr_extents;
+    /// 下一个要解码的文件内簇号与对应的设备簇号，簇链结束时后者为 FAT_EOC
+    uint32_t         next_index;
+    uint32_t         next_cluster;
+    ListNode         node;
+};
+
+static int32_t fat_map(pcache_mapping_t* _mapping, uint64_t _sector,
+                       uint64_t* _disk, uint32_t* _count);
+
+static const pcache_mapping_ops_t fat_ops = { fat_map };
+
+/// 保护文件系统与文件表
+static Mutex                                        fat_lock;
+static fat_fs_t                                     fat_fss[FAT_FS_MAX];
+static fat_file_t                                   fat_files[FAT_FILES];
+static IntrusiveList<fat_file_t, &fat_file_t::node> lru_files;
+
+/// 启动卷与是否已经尝试挂载
+static fat_fs_t* boot_fs;
+static bool      boot_done;
+
+static uint32_t load32(const uint8_t* _ptr) {
+    uint32_t val;
+    memcpy(&val, _ptr, sizeof(val));
+    return val;
+}
+
+static uint64_t load64(const uint8_t* _ptr) {
+    uint64_t val;
+    memcpy(&val, _ptr, sizeof(val));
+    return val;
+}
+
+static uint8_t fold(uint8_t _ch) {
+    return (_ch >= 'A') && (_ch <= 'Z') ? _ch + ('a' - 'A') : _ch;
+}
+
+static bool cluster_valid(const fat_fs_t* _fs, uint32_t _cluster) {
+    return (_cluster >= FAT_FIRST_CLUSTER)
+           && (_cluster - FAT_FIRST_CLUSTER < _fs->nr_clusters);
+}
+
+/**
+ * @brief FAT16 的根目录不是簇链，占用数据区之前的固定区域
+ */
+static bool fixed_root(const fat_file_t* _file) {
+    return (_file->fs->bits == 16) && (_file->cluster == 0)
+           && ((_file->attr & FAT_ATTR_DIR) != 0);
+}
+
+/**
+ * @brief 读取 FAT 表项，同一页中的表项复用已取得的页
+ * @param  _page                   持有的 FAT 页，可以为 nullptr，返回时更新，
+ *                                 调用者最后释放
+ * @param  _next                   输出，下一个簇，簇链结束时为 FAT_EOC
+ * @return int32_t                 FAT_OK 或 FAT_ERR_IO
+ */
+static int32_t fat_entry(fat_fs_t* _fs, uint32_t _cluster, page_t** _page,
+                         uint32_t* _next) {
+    auto off   = (_fs->fat_start << SECTOR_SHIFT)
+               + static_cast<uint64_t>(_cluster) * (_fs->bits / 8);
+    auto index = off >> PCACHE_PAGE_SHIFT;
+    if ((*_page == nullptr) || ((*_page)->index != index)) {
+        if (*_page != nullptr) {
+            page_put(*_page);
+        }
+        *_page = pcache_read_page(&_fs->meta, index);
+        if (*_page == nullptr) {
+            return FAT_ERR_IO;
+        }
+    }
+    // 表项按自身大小对齐，不会跨页
+    auto*    data = (*_page)->data + (off & (PCACHE_PAGE_SIZE - 1));
+    uint32_t next;
+    bool     eoc;
+    if (_fs->bits == 32) {
+        memcpy(&next, data, sizeof(uint32_t));
+        next &= FAT32_MASK;
+        eoc   = next >= FAT32_EOC;
+    }
+    else {
+        uint16_t val;
+        memcpy(&val, data, sizeof(val));
+        next = val;
+        eoc  = next >= FAT16_EOC;
+    }
+    if (eoc) {
+        *_next = FAT_EOC;
+        return FAT_OK;
+    }
+    // 空闲或坏簇出现在簇链中，文件系统已损坏
+    if (!cluster_valid(_fs, next)) {
+        return FAT_ERR_IO;
+    }
+    *_next = next;
+    return FAT_OK;
+}
+
+static void chain_reset(fat_file_t* _file) {
+    _file->nr_extents   = 0;
+    _file->next_index   = 0;
+    _file->next_cluster = cluster_valid(_file->fs, _file->cluster)
+                            ? _file->cluster
+                            : FAT_EOC;
+    return;
+}
+
+/**
+ * @brief 查找覆盖文件内簇 _index 的 extent
+ * @return fat_extent_t*           不在已解码的部分中时为 nullptr
+ */
+static fat_extent_t* extent_find(fat_file_t* _file, uint32_t _index) {
+    uint32_t lo = 0;
+    uint32_t hi = _file->nr_extents;
+    while (lo < hi) {
+        auto  mid = lo + (hi - lo) / 2;
+        auto* ext = &_file->extents[mid];
+        if (_index < ext->file_cluster) {
+            hi = mid;
+        }
+        else if (_index - ext->file_cluster >= ext->count) {
+            lo = mid + 1;
+        }
+        else {
+            return ext;
+        }
+    }
+    return nullptr;
+}
+
+/**
+ * @brief 沿簇链解码，直到覆盖文件内的簇 _index，
+ * 之后沿连续的簇最多再解码 FAT_DECODE_AHEAD 个，使映射返回尽量长的一段。
+ * extent 数组满时丢弃前一半，再访问到时从头解码。
+ * 调用者持有 _file->lock
+ * @return int32_t                 FAT_OK 或 FAT_ERR_IO，已解码的部分仍然有效
+ */
+static int32_t chain_decode(fat_file_t* _file, uint32_t _index) {
+    auto*   fs     = _file->fs;
+    page_t* page   = nullptr;
+    int32_t status = FAT_OK;
+    if ((_file->nr_extents != 0) && (_index < _file->extents[0].file_cluster)) {
+        chain_reset(_file);
+    }
+    while (_file->next_cluster != FAT_EOC) {
+        auto* last   = _file->nr_extents == 0
+                         ? nullptr
+                         : &_file->extents[_file->nr_extents - 1];
+        bool  contig = (last != nullptr)
+                      && (last->disk_cluster + last->count
+                          == _file->next_cluster);
+        if ((_file->next_index > _index)
+            && (!contig || (_file->next_index - _index > FAT_DECODE_AHEAD))) {
+            break;
+        }
+        // 有环的簇链会超过簇数
+        if (_file->next_index >= fs->nr_clusters) {
+            status = FAT_ERR_IO;
+            break;
+        }
+        uint32_t next;
+        status = fat_entry(fs, _file->next_cluster, &page, &next);
+        if (status != FAT_OK) {
+            break;
+        }
+        if (contig) {
+            last->count++;
+        }
+        else {
+            if (_file->nr_extents == FAT_EXTENTS) {
+                memmove(_file->extents, _file->extents + FAT_EXTENTS / 2,
+                        sizeof(fat_extent_t) * (FAT_EXTENTS / 2));
+                _file->nr_extents = FAT_EXTENTS / 2;
+            }
+            _file->extents[_file->nr_extents++] = { _file->next_index,
+                                                    _file->next_cluster, 1 };
+        }
+        _file->next_index++;
+        _file->next_cluster = next;
+    }
+    if (page != nullptr) {
+        page_put(page);
+    }
+    return status;
+}
+
+static int32_t fat_map(pcache_mapping_t* _mapping, uint64_t _sector,
+                       uint64_t* _disk, uint32_t* _count) {
+    auto* file = static_cast<fat_file_t*>(_mapping->private_data);
+    auto* fs   = file->fs;
+    if (fixed_root(file)) {
+        if (_sector >= fs->root_sectors) {
+            return BLK_STS_IOERR;
+        }
+        *_disk  = fs->root_start + _sector;
+        *_count = static_cast<uint32_t>(fs->root_sectors - _sector);
+        return BLK_STS_OK;
+    }
+    auto sector_off = _sector & ((1ULL << fs->cluster_shift) - 1);
+    auto index      = _sector >> fs->cluster_shift;
+    if (index >= fs->nr_clusters) {
+        return BLK_STS_IOERR;
+    }
+    LockGuard<Mutex> guard(file->lock);
+    auto*            ext = extent_find(file, static_cast<uint32_t>(index));
+    if (ext == nullptr) {
+        chain_decode(file, static_cast<uint32_t>(index));
+        ext = extent_find(file, static_cast<uint32_t>(index));
+        if (ext == nullptr) {
+            return BLK_STS_IOERR;
+        }
+    }
+    auto off     = index - ext->file_cluster;
+    auto cluster = static_cast<uint64_t>(ext->disk_cluster - FAT_FIRST_CLUSTER
+                                         + off);
+    auto sectors = (static_cast<uint64_t>(ext->count - off)
+                    << fs->cluster_shift)
+                   - sector_off;
+    *_disk       = fs->data_start + (cluster << fs->cluster_shift) + sector_off;
+    *_count      = sectors < UINT32_MAX ? static_cast<uint32_t>(sectors)
+                                        : UINT32_MAX;
+    return BLK_STS_OK;
+}
+
+static uint8_t lfn_checksum(const uint8_t* _name) {
+    uint8_t sum = 0;
+    for (size_t i = 0; i < 11; i++) {
+        sum = static_cast<uint8_t>(((sum & 1) << 7) + (sum >> 1) + _name[i]);
+    }
+    return sum;
+}
+
+/**
+ * @brief 按 NT 保留字节中的大小写标记生成 8.3 短文件名
+ */
+static void short_name(const fat_raw_dirent_t* _dirent, char* _out) {
+    size_t len  = 0;
+    size_t base = 8;
+    size_t ext  = 3;
+    while ((base > 0) && (_dirent->name[base - 1] == ' ')) {
+        base--;
+    }
+    while ((ext > 0) && (_dirent->name[8 + ext - 1] == ' ')) {
+        ext--;
+    }
+    for (size_t i = 0; i < base; i++) {
+        auto ch = _dirent->name[i];
+        if ((i == 0) && (ch == DIRENT_KANJI)) {
+            ch = DIRENT_FREE;
+        }
+        if ((_dirent->nt_res & NT_LOWER_BASE) != 0) {
+            ch = fold(ch);
+        }
+        _out[len++] = static_cast<char>(ch);
+    }
+    if (ext != 0) {
+        _out[len++] = '.';
+    }
+    for (size_t i = 0; i < ext; i++) {
+        auto ch = _dirent->name[8 + i];
+        if ((_dirent->nt_res & NT_LOWER_EXT) != 0) {
+            ch = fold(ch);
+        }
+        _out[len++] = static_cast<char>(ch);
+    }
+    _out[len] = '\0';
+    return;
+}
+
+/**
+ * @brief 把 UCS-2 (UTF-16) 的长文件名转换为 UTF-8
+ * @return size_t                  字节数
+ */
+static size_t lfn_to_utf8(const uint16_t* _lfn, size_t _count, char* _out) {
+    size_t len = 0;
+    for (size_t i = 0; i < _count; i++) {
+        uint32_t ch = _lfn[i];
+        // 0 结束，之后以 0xFFFF 填充
+        if ((ch == 0x0000) || (ch == 0xFFFF)) {
+            break;
+        }
+        if ((ch >= 0xD800) && (ch < 0xDC00) && (i + 1 < _count)
+            && (_lfn[i + 1] >= 0xDC00) && (_lfn[i + 1] < 0xE000)) {
+            ch = 0x10000 + ((ch - 0xD800) << 10) + (_lfn[i + 1] - 0xDC00);
+            i++;
+        }
+        else if ((ch >= 0xD800) && (ch < 0xE000)) {
+            ch = '?';
+        }
+        if (len + 4 > FAT_NAME_MAX) {
+            break;
+        }
+        if (ch < 0x80) {
+            _out[len++] = static_cast<char>(ch);
+        }
+        else if (ch < 0x800) {
+            _out[len++] = static_cast<char>(0xC0 | (ch >> 6));
+            _out[len++] = static_cast<char>(0x80 | (ch & 0x3F));
+        }
+        else if (ch < 0x10000) {
+            _out[len++] = static_cast<char>(0xE0 | (ch >> 12));
+            _out[len++] = static_cast<char>(0x80 | ((ch >> 6) & 0x3F));
+            _out[len++] = static_cast<char>(0x80 | (ch & 0x3F));
+        }
+        else {
+            _out[len++] = static_cast<char>(0xF0 | (ch >> 18));
+            _out[len++] = static_cast<char>(0x80 | ((ch >> 12) & 0x3F));
+            _out[len++] = static_cast<char>(0x80 | ((ch >> 6) & 0x3F));
+            _out[len++] = static_cast<char>(0x80 | (ch & 0x3F));
+        }
+    }
+    _out[len] = '\0';
+    return len;
+}
+
+/**
+ * @brief 读取目录中 *_pos 起的下一个文件，组合其长文件名
+ * @param  _alias                  输出，有长文件名时为短文件名，否则为空串，
+ *                                 可以为 nullptr
+ * @return int32_t                 FAT_OK，已到末尾时为 FAT_ERR_NOENT
+ */
+static int32_t dir_next(fat_file_t* _dir, size_t* _pos, fat_dirent_t* _ent,
+                        char* _alias) {
+    uint16_t lfn[LFN_ENTRIES_MAX * LFN_CHARS];
+    // 期望的下一个长文件名项的序号加一，为 0 时没有未完成的长文件名
+    uint32_t lfn_seq   = 0;
+    uint32_t lfn_count = 0;
+    uint8_t  lfn_sum   = 0;
+    auto     limit     = _dir->mapping.size / DIRENT_SIZE;
+    page_t*  page      = nullptr;
+    int32_t  status    = FAT_ERR_NOENT;
+    while (*_pos < limit) {
+        auto off   = *_pos * DIRENT_SIZE;
+        auto index = off >> PCACHE_PAGE_SHIFT;
+        if ((page == nullptr) || (page->index != index)) {
+            if (page != nullptr) {
+                page_put(page);
+            }
+            page = pcache_read_page(&_dir->mapping, index);
+            if (page == nullptr) {
+                return FAT_ERR_IO;
+            }
+        }
+        auto* raw    = page->data + (off & (PCACHE_PAGE_SIZE - 1));
+        auto* dirent = reinterpret_cast<const fat_raw_dirent_t*>(raw);
+        if (dirent->name[0] == DIRENT_END) {
+            *_pos = limit;
+            break;
+        }
+        (*_pos)++;
+        if (dirent->name[0] == DIRENT_FREE) {
+            lfn_seq = 0;
+            continue;
+        }
+        if ((dirent->attr & ATTR_LFN_MASK) == ATTR_LFN) {
+            auto*    lfn_ent = reinterpret_cast<const fat_lfn_dirent_t*>(raw);
+            uint32_t seq     = lfn_ent->ord & LFN_SEQ_MASK;
+            if ((lfn_ent->ord & LFN_LAST) != 0) {
+                lfn_seq   = (seq != 0) && (seq <= LFN_ENTRIES_MAX) ? seq + 1
+                                                                   : 0;
+                lfn_count = seq * LFN_CHARS;
+                lfn_sum   = lfn_ent->checksum;
+            }
+            if ((lfn_seq == 0) || (seq + 1 != lfn_seq)
+                || (lfn_ent->checksum != lfn_sum)) {
+                lfn_seq = 0;
+                continue;
+            }
+            auto* chars = lfn + (seq - 1) * LFN_CHARS;
+            for (size_t i = 0; i < 5; i++) {
+                chars[i] = lfn_ent->name1[i];
+            }
+            for (size_t i = 0; i < 6; i++) {
+                chars[5 + i] = lfn_ent->name2[i];
+            }
+            for (size_t i = 0; i < 2; i++) {
+                chars[11 + i] = lfn_ent->name3[i];
+            }
+            lfn_seq = seq;
+            continue;
+        }
+        if ((dirent->attr & FAT_ATTR_VOLUME) != 0) {
+            lfn_seq = 0;
+            continue;
+        }
+        char name[13];
+        short_name(dirent, name);
+        // 序号 1 的项已经读到，且校验和与短文件名一致
+        bool has_lfn = (lfn_seq == 1) && (lfn_checksum(dirent->name) == lfn_sum)
+                       && (lfn_to_utf8(lfn, lfn_count, _ent->name) != 0);
+        if (!has_lfn) {
+            memcpy(_ent->name, name, sizeof(name));
+        }
+        if (_alias != nullptr) {
+            if (has_lfn) {
+                memcpy(_alias, name, sizeof(name));
+            }
+            else {
+                _alias[0] = '\0';
+            }
+        }
+        _ent->size    = dirent->size;
+        _ent->attr    = dirent->attr;
+        _ent->cluster = dirent->cluster_lo;
+        if (_dir->fs->bits == 32) {
+            _ent->cluster |= static_cast<uint32_t>(dirent->cluster_hi) << 16;
+        }
+        status = FAT_OK;
+        break;
+    }
+    if (page != nullptr) {
+        page_put(page);
+    }
+    return status;
+}
+
+/**
+ * @brief 目录项缓存的键，ASCII 不区分大小写
+ */
+static uint64_t name_key(uint32_t _dir, const char* _name, size_t _len) {
+    // FNV-1a
+    uint64_t hash = 0xcbf29ce484222325ULL ^ _dir;
+    for (size_t i = 0; i < _len; i++) {
+        hash ^= fold(static_cast<uint8_t>(_name[i]));
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+static bool name_equal(const char* _lhs, size_t _lhs_len, const char* _rhs,
+                       size_t _rhs_len) {
+    if (_lhs_len != _rhs_len) {
+        return false;
+    }
+    for (size_t i = 0; i < _lhs_len; i++) {
+        if (fold(static_cast<uint8_t>(_lhs[i]))
+            != fold(static_cast<uint8_t>(_rhs[i]))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief 加入目录项缓存，满时清空后重新开始
+ */
+static void dcache_insert(fat_fs_t* _fs, const fat_dentry_t& _dentry,
+                          const char* _name) {
+    auto                     key = name_key(_dentry.dir, _name, _dentry.len);
+    IrqLockGuard<TicketLock> guard(_fs->dcache_lock);
+    if (_fs->dcache.insert(key, _dentry) == nullptr) {
+        _fs->dcache.clear();
+        _fs->dirs.clear();
+        _fs->dcache_gen++;
+        _fs->dcache.insert(key, _dentry);
+    }
+    return;
+}
+
+/**
+ * @brief 在目录中查找
+ * 先查目录项缓存，目录完整缓存时未命中即不存在，
+ * 否则扫描整个目录并把全部项加入缓存
+ * @param  _dir                    目录
+ * @param  _name                   名称，不需要以 0 结尾
+ * @param  _len                    名称长度
+ * @param  _dentry                 输出
+ * @return int32_t                 FAT_OK 或 FAT_ERR_*
+ */
+static int32_t dir_lookup(fat_file_t* _dir, const char* _name, size_t _len,
+                          fat_dentry_t* _dentry) {
+    auto*    fs  = _dir->fs;
+    auto     dir = _dir->cluster;
+    uint64_t gen;
+    {
+        IrqLockGuard<TicketLock> guard(fs->dcache_lock);
+        auto* dentry = fs->dcache.find(name_key(dir, _name, _len));
+        if ((dentry != nullptr) && (dentry->dir == dir)
+            && (dentry->len == _len)) {
+            *_dentry = *dentry;
+            return FAT_OK;
+        }
+        if ((dentry == nullptr) && fs->dirs.contains(dir)) {
+            return FAT_ERR_NOENT;
+        }
+        gen = fs->dcache_gen;
+    }
+    fat_dirent_t ent;
+    char         alias[13];
+    size_t       pos   = 0;
+    bool         found = false;
+    int32_t      status;
+    while ((status = dir_next(_dir, &pos, &ent, alias)) == FAT_OK) {
+        auto         len    = strlen(ent.name);
+        fat_dentry_t dentry = { dir, ent.cluster,
+                                static_cast<uint32_t>(ent.size), ent.attr,
+                                static_cast<uint32_t>(len) };
+        dcache_insert(fs, dentry, ent.name);
+        if (!found && name_equal(ent.name, len, _name, _len)) {
+            *_dentry = dentry;
+            found    = true;
+        }
+        if (alias[0] != '\0') {
+            dentry.len = static_cast<uint32_t>(strlen(alias));
+            dcache_insert(fs, dentry, alias);
+            if (!found && name_equal(alias, dentry.len, _name, _len)) {
+                *_dentry = dentry;
+                found    = true;
+            }
+        }
+    }
+    if (status != FAT_ERR_NOENT) {
+        return status;
+    }
+    {
+        IrqLockGuard<TicketLock> guard(fs->dcache_lock);
+        // 表满时不记录，之后未命中时重新扫描
+        if (fs->dcache_gen == gen) {
+            fs->dirs.insert(dir, true);
+        }
+    }
+    return found ? FAT_OK : FAT_ERR_NOENT;
+}
+
+/**
+ * @brief 取得文件，已在文件表中时共享其缓存
+ * 没有空位时回收最久未使用的文件，目录在取得时解码整个簇链得到大小。
+ * 调用者持有 fat_lock
+ * @param  _size                   目录项中的大小，目录不使用
+ * @param  _file                   输出，取得引用的文件
+ * @return int32_t                 FAT_OK 或 FAT_ERR_*
+ */
+static int32_t file_get_locked(fat_fs_t* _fs, uint32_t _cluster,
+                               uint32_t _attr, uint64_t _size,
+                               fat_file_t** _file) {
+    fat_file_t* file = nullptr;
+    for (auto& iter : fat_files) {
+        if (iter.fs == nullptr) {
+            file = file == nullptr ? &iter : file;
+            continue;
+        }
+        if ((iter.fs == _fs) && (iter.cluster == _cluster)
+            && (((iter.attr ^ _attr) & FAT_ATTR_DIR) == 0)) {
+            if (iter.refcount++ == 0) {
+                lru_files.erase(iter);
+            }
+            *_file = &iter;
+            return FAT_OK;
+        }
+    }
+    if (file == nullptr) {
+        file = lru_files.pop_front();
+        if (file == nullptr) {
+            return FAT_ERR_NOMEM;
+        }
+        pcache_mapping_destroy(&file->mapping);
+        file->fs = nullptr;
+    }
+    file->fs       = _fs;
+    file->cluster  = _cluster;
+    file->attr     = _attr;
+    file->refcount = 1;
+    new (&file->lock) Mutex();
+    chain_reset(file);
+    pcache_mapping_init(&file->mapping, _fs->bdev, &fat_ops, _size);
+    file->mapping.private_data = file;
+    if ((_attr & FAT_ATTR_DIR) == 0) {
+        *_file = file;
+        return FAT_OK;
+    }
+    uint64_t size;
+    if (fixed_root(file)) {
+        size = static_cast<uint64_t>(_fs->root_sectors) << SECTOR_SHIFT;
+    }
+    else {
+        // 还没有发布，不需要加锁
+        if (chain_decode(file, UINT32_MAX) != FAT_OK) {
+            pcache_mapping_destroy(&file->mapping);
+            file->fs = nullptr;
+            return FAT_ERR_IO;
+        }
+        size = static_cast<uint64_t>(file->next_index)
+               << (_fs->cluster_shift + SECTOR_SHIFT);
+    }
+    file->mapping.size = size < DIR_ENTRIES_MAX * DIRENT_SIZE
+                           ? size
+                           : DIR_ENTRIES_MAX * DIRENT_SIZE;
+    *_file             = file;
+    return FAT_OK;
+}
+
+/**
+ * @brief 解析 _start 扇区处的引导扇区
+ * @return int32_t                 FAT_OK，不是 FAT16/FAT32 时为 FAT_ERR_INVAL
+ */
+static int32_t bpb_parse(fat_fs_t* _fs, uint64_t _start) {
+    uint8_t sector[SECTOR_SIZE];
+    if (pcache_read(&_fs->meta, _start << SECTOR_SHIFT, sector, SECTOR_SIZE)
+        != SECTOR_SIZE) {
+        return FAT_ERR_IO;
+    }
+    if ((sector[BOOT_SIG_OFFSET] != 0x55)
+        || (sector[BOOT_SIG_OFFSET + 1] != 0xAA)) {
+        return FAT_ERR_INVAL;
+    }
+    fat_bpb_t bpb;
+    memcpy(&bpb, sector, sizeof(bpb));
+    uint32_t bps = bpb.bytes_per_sec;
+    uint32_t spc = bpb.sec_per_clus;
+    if ((bps < SECTOR_SIZE) || (bps > PCACHE_PAGE_SIZE)
+        || ((bps & (bps - 1)) != 0) || (spc == 0) || ((spc & (spc - 1)) != 0)
+        || (bpb.rsvd_sec == 0) || (bpb.num_fats == 0)) {
+        return FAT_ERR_INVAL;
+    }
+    uint64_t fat_size  = bpb.fat_sz16 != 0 ? bpb.fat_sz16 : bpb.fat_sz32;
+    uint64_t total     = bpb.tot_sec16 != 0 ? bpb.tot_sec16 : bpb.tot_sec32;
+    uint64_t root_secs = (bpb.root_ent * DIRENT_SIZE + bps - 1) / bps;
+    uint64_t meta_secs = bpb.rsvd_sec + bpb.num_fats * fat_size + root_secs;
+    if ((fat_size == 0) || (total <= meta_secs)) {
+        return FAT_ERR_INVAL;
+    }
+    auto clusters = (total - meta_secs) / spc;
+    // 不支持 FAT12
+    if ((clusters < FAT12_CLUSTERS) || (clusters > FAT32_EOC - 1)) {
+        return FAT_ERR_INVAL;
+    }
+    uint32_t bits = clusters < FAT16_CLUSTERS ? 16 : 32;
+    if ((bits == 16) == (bpb.root_ent == 0)) {
+        return FAT_ERR_INVAL;
+    }
+    // FAT 需要能容纳全部簇
+    if (fat_size * bps / (bits / 8) < clusters + FAT_FIRST_CLUSTER) {
+        return FAT_ERR_INVAL;
+    }
+    uint32_t active = 0;
+    if ((bits == 32) && ((bpb.ext_flags & FAT32_NO_MIRROR) != 0)) {
+        active = bpb.ext_flags & FAT32_ACTIVE_MASK;
+        if (active >= bpb.num_fats) {
+            return FAT_ERR_INVAL;
+        }
+    }
+    uint64_t scale     = bps / SECTOR_SIZE;
+    _fs->bits          = bits;
+    _fs->cluster_shift = __builtin_ctz(spc * static_cast<uint32_t>(scale));
+    _fs->nr_clusters   = static_cast<uint32_t>(clusters);
+    _fs->fat_start     = _start + (bpb.rsvd_sec + active * fat_size) * scale;
+    _fs->root_start    = _start
+                         + (bpb.rsvd_sec + bpb.num_fats * fat_size) * scale;
+    _fs->root_sectors  = static_cast<uint32_t>(root_secs * scale);
+    _fs->data_start    = _fs->root_start + _fs->root_sectors;
+    _fs->root_cluster  = bits == 32 ? bpb.root_clus : 0;
+    if ((bits == 32) && !cluster_valid(_fs, _fs->root_cluster)) {
+        return FAT_ERR_INVAL;
+    }
+    if (_start + total * scale > _fs->bdev->capacity) {
+        return FAT_ERR_INVAL;
+    }
+    // 块层的请求需要按逻辑块对齐
+    uint64_t block = _fs->bdev->block_size > SECTOR_SIZE
+                       ? _fs->bdev->block_size >> SECTOR_SHIFT
+                       : 1;
+    if ((_fs->data_start % block != 0) || (_fs->root_start % block != 0)
+        || (_fs->root_sectors % block != 0)
+        || ((1ULL << _fs->cluster_shift) % block != 0)) {
+        return FAT_ERR_INVAL;
+    }
+    return FAT_OK;
+}
+
+/**
+ * @brief 在 GPT 的分区中查找 FAT 卷
+ * @param  _lba                    逻辑块大小，扇区
+ */
+static int32_t gpt_find(fat_fs_t* _fs, uint64_t _lba) {
+    uint8_t header[SECTOR_SIZE];
+    if (pcache_read(&_fs->meta, _lba << SECTOR_SHIFT, header, SECTOR_SIZE)
+        != SECTOR_SIZE) {
+        return FAT_ERR_IO;
+    }
+    if (memcmp(header, "EFI PART", 8) != 0) {
+        return FAT_ERR_INVAL;
+    }
+    auto entries    = load64(header + 72);
+    auto count      = load32(header + 80);
+    auto entry_size = load32(header + 84);
+    if ((entry_size < GPT_ENTRY_SIZE)
+        || ((entry_size & (entry_size - 1)) != 0)) {
+        return FAT_ERR_INVAL;
+    }
+    count = count < GPT_ENTRIES_MAX ? count : GPT_ENTRIES_MAX;
+    for (uint32_t i = 0; i < count; i++) {
+        uint8_t entry[GPT_ENTRY_SIZE];
+        auto    off = ((entries * _lba) << SECTOR_SHIFT)
+                 + static_cast<uint64_t>(i) * entry_size;
+        if (pcache_read(&_fs->meta, off, entry, GPT_ENTRY_SIZE)
+            != GPT_ENTRY_SIZE) {
+            return FAT_ERR_IO;
+        }
+        // 类型为全 0 的项未使用
+        if ((load64(entry) == 0) && (load64(entry + 8) == 0)) {
+            continue;
+        }
+        if (bpb_parse(_fs, load64(entry + 32) * _lba) == FAT_OK) {
+            return FAT_OK;
+        }
+    }
+    return FAT_ERR_INVAL;
+}
+
+/**
+ * @brief 依次尝试整个设备、MBR 分区与 GPT 分区
+ */
+static int32_t volume_find(fat_fs_t* _fs) {
+    if (bpb_parse(_fs, 0) == FAT_OK) {
+        return FAT_OK;
+    }
+    uint8_t mbr[SECTOR_SIZE];
+    if (pcache_read(&_fs->meta, 0, mbr, SECTOR_SIZE) != SECTOR_SIZE) {
+        return FAT_ERR_IO;
+    }
+    if ((mbr[BOOT_SIG_OFFSET] != 0x55) || (mbr[BOOT_SIG_OFFSET + 1] != 0xAA)) {
+        return FAT_ERR_INVAL;
+    }
+    uint64_t lba = _fs->bdev->block_size > SECTOR_SIZE
+                     ? _fs->bdev->block_size >> SECTOR_SHIFT
+                     : 1;
+    bool     gpt = false;
+    for (size_t i = 0; i < MBR_PARTS; i++) {
+        auto* part = mbr + MBR_PART_OFFSET + i * MBR_PART_SIZE;
+        auto  type = part[4];
+        if (type == 0) {
+            continue;
+        }
+        if (type == MBR_TYPE_GPT) {
+            gpt = true;
+            continue;
+        }
+        if (bpb_parse(_fs, load32(part + 8) * lba) == FAT_OK) {
+            return FAT_OK;
+        }
+    }
+    return gpt ? gpt_find(_fs, lba) : FAT_ERR_INVAL;
+}
+
+static void mount_thread(void* _arg) {
+    (void)_arg;
+    driver_wait_init();
+    for (size_t i = 0; blk_get(i) != nullptr; i++) {
+        fat_fs_t* fs;
+        if (fat_mount(blk_get(i), &fs) == FAT_OK) {
+            boot_fs = fs;
+            break;
+        }
+    }
+    __atomic_store_n(&boot_done, true, __ATOMIC_RELEASE);
+    wake_up_all(&boot_done);
+    return;
+}
+
+void fat_init(void) {
+    if (kthread_run(mount_thread, nullptr, "fat_mount") == nullptr) {
+        __builtin_trap();
+    }
+    return;
+}
+
+fat_fs_t* fat_boot_volume(void) {
+    wait_event(&boot_done,
+               [] { return __atomic_load_n(&boot_done, __ATOMIC_ACQUIRE); });
+    return boot_fs;
+}
+
+int32_t fat_mount(blk_dev_t* _bdev, fat_fs_t** _fs) {
+    LockGuard<Mutex> guard(fat_lock);
+    fat_fs_t*        fs = nullptr;
+    for (auto& iter : fat_fss) {
+        if (iter.bdev == _bdev) {
+            *_fs = &iter;
+            return FAT_OK;
+        }
+        if ((iter.bdev == nullptr) && (fs == nullptr)) {
+            fs = &iter;
+        }
+    }
+    if (fs == nullptr) {
+        return FAT_ERR_NOMEM;
+    }
+    fs->bdev = _bdev;
+    pcache_mapping_init(&fs->meta, _bdev, nullptr,
+                        _bdev->capacity << SECTOR_SHIFT);
+    auto status = volume_find(fs);
+    if (status == FAT_OK) {
+        status = file_get_locked(fs, fs->root_cluster, FAT_ATTR_DIR, 0,
+                                 &fs->root);
+    }
+    if (status != FAT_OK) {
+        pcache_mapping_destroy(&fs->meta);
+        fs->bdev = nullptr;
+        return status;
+    }
+    *_fs = fs;
+    return FAT_OK;
+}
+
+int32_t fat_open(fat_fs_t* _fs, const char* _path, fat_file_t** _file) {
+    fat_file_t* cur = _fs->root;
+    {
+        LockGuard<Mutex> guard(fat_lock);
+        cur->refcount++;
+    }
+    auto* name = _path;
+    while (true) {
+        while (*name == '/') {
+            name++;
+        }
+        if (*name == '\0') {
+            break;
+        }
+        auto* end = name;
+        while ((*end != '\0') && (*end != '/')) {
+            end++;
+        }
+        size_t len = end - name;
+        // 根目录没有 . 与 .. 项
+        if (((len == 1) && (name[0] == '.'))
+            || ((len == 2) && (name[0] == '.') && (name[1] == '.')
+                && (cur == _fs->root))) {
+            name = end;
+            continue;
+        }
+        if ((cur->attr & FAT_ATTR_DIR) == 0) {
+            fat_close(cur);
+            return FAT_ERR_NOTDIR;
+        }
+        fat_dentry_t dentry;
+        auto         status = dir_lookup(cur, name, len, &dentry);
+        if (status != FAT_OK) {
+            fat_close(cur);
+            return status;
+        }
+        // 指向根目录的 .. 项首簇为 0
+        auto cluster = dentry.cluster;
+        if (((dentry.attr & FAT_ATTR_DIR) != 0) && (cluster == 0)) {
+            cluster = _fs->root_cluster;
+        }
+        fat_file_t* next;
+        {
+            LockGuard<Mutex> guard(fat_lock);
+            status = file_get_locked(_fs, cluster, dentry.attr, dentry.size,
+                                     &next);
+        }
+        fat_close(cur);
+        if (status != FAT_OK) {
+            return status;
+        }
+        cur  = next;
+        name = end;
+    }
+    *_file = cur;
+    return FAT_OK;
+}
+
+void fat_close(fat_file_t* _file) {
+    LockGuard<Mutex> guard(fat_lock);
+    if (--_file->refcount == 0) {
+        lru_files.push_back(*_file);
+    }
+    return;
+}
+
+size_t fat_read(fat_file_t* _file, uint64_t _offset, void* _buf,
+                size_t _len) {
+    if ((_file->attr & FAT_ATTR_DIR) != 0) {
+        return 0;
+    }
+    return pcache_read(&_file->mapping, _offset, _buf, _len);
+}
+
+void fat_stat(const fat_file_t* _file, fat_stat_t* _stat) {
+    _stat->size = _file->mapping.size;
+    _stat->attr = _file->attr;
+    return;
+}
+
+int32_t fat_readdir(fat_file_t* _dir, size_t* _pos, fat_dirent_t* _ent) {
+    if ((_dir->attr & FAT_ATTR_DIR) == 0) {
+        return FAT_ERR_NOTDIR;
+    }
+    return dir_next(_dir, _pos, _ent, nullptr);
+}
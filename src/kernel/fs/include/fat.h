@@ -0,0 +1,144 @@
+
+/**
+ * @file fat.h
+ * @brief FAT 文件系统
+ * @author Zone.N (Zone.Niuzh@hotmail.com)
+ * @version 1.0
+ * @date 2026-10-18
+ * @copyright MIT LICENSE
+ * https://github.com/MRNIU/cmake-kernel
+ * @par change log:
+ * <table>
+ * <tr><th>Date<th>Author<th>Description
+ * <tr><td>2026-10-18<td>Zone.N (Zone.Niuzh@hotmail.com)<td>创建文件
+ * </table>
+ */
+
+#ifndef CMAKE_KERNEL_FAT_H
+#define CMAKE_KERNEL_FAT_H
+
+#include "cstddef"
+#include "cstdint"
+
+#include "blkdev.h"
+
+// 只读的 FAT16/FAT32 文件系统，用于访问启动卷。
+// 文件数据经过页缓存，每个文件的簇链第一次用到时解码为 extent 列表
+// (文件内的簇号到设备上连续簇的映射)，之后的读取只做二分查找，
+// 顺序读取时预读窗口内的页在设备上连续，由块层合并为大的请求。
+// 目录项第一次查找时整个目录读入哈希表，之后按 (目录, 名称) 直接命中，
+// 不存在的名称也不需要再扫描目录
+
+/// 错误码
+static constexpr const int32_t  FAT_OK           = 0;
+/// 设备读取失败或簇链损坏
+static constexpr const int32_t  FAT_ERR_IO       = -1;
+/// 不是 FAT16/FAT32 文件系统
+static constexpr const int32_t  FAT_ERR_INVAL    = -2;
+static constexpr const int32_t  FAT_ERR_NOENT    = -3;
+static constexpr const int32_t  FAT_ERR_NOTDIR   = -4;
+/// 文件系统或打开的文件数已达上限
+static constexpr const int32_t  FAT_ERR_NOMEM    = -5;
+
+/// 目录项属性
+static constexpr const uint32_t FAT_ATTR_RDONLY  = 0x01;
+static constexpr const uint32_t FAT_ATTR_HIDDEN  = 0x02;
+static constexpr const uint32_t FAT_ATTR_SYSTEM  = 0x04;
+static constexpr const uint32_t FAT_ATTR_VOLUME  = 0x08;
+static constexpr const uint32_t FAT_ATTR_DIR     = 0x10;
+static constexpr const uint32_t FAT_ATTR_ARCHIVE = 0x20;
+
+/// 文件名的最大字节数，长文件名最多 255 个 UCS-2 字符，按 UTF-8 编码
+static constexpr const size_t   FAT_NAME_MAX     = 255 * 3;
+
+struct fat_fs_t;
+struct fat_file_t;
+
+/**
+ * @brief 目录项
+ */
+struct fat_dirent_t {
+    /// 长文件名，没有时为 8.3 短文件名
+    char     name[FAT_NAME_MAX + 1];
+    /// 文件大小，字节
+    uint64_t size;
+    /// FAT_ATTR_*
+    uint32_t attr;
+    /// 首簇，空文件为 0
+    uint32_t cluster;
+};
+
+/**
+ * @brief 文件信息
+ */
+struct fat_stat_t {
+    uint64_t size;
+    uint32_t attr;
+};
+
+/**
+ * @brief 启动后台线程，在驱动初始化完成后挂载第一个 FAT 卷作为启动卷
+ */
+void      fat_init(void);
+
+/**
+ * @brief 获取启动卷，等待挂载结束
+ * @return fat_fs_t*              启动卷，没有 FAT 卷时为 nullptr
+ */
+fat_fs_t* fat_boot_volume(void);
+
+/**
+ * @brief 挂载块设备上的 FAT 卷
+ * 依次尝试整个设备、MBR 分区与 GPT 分区，使用第一个有效的卷
+ * @param  _bdev                   块设备
+ * @param  _fs                     输出，文件系统
+ * @return int32_t                 FAT_OK 或 FAT_ERR_*
+ */
+int32_t   fat_mount(blk_dev_t* _bdev, fat_fs_t** _fs);
+
+/**
+ * @brief 按路径打开文件或目录
+ * @param  _fs                     文件系统
+ * @param  _path                   以 '/' 分隔的路径，不区分 ASCII 大小写
+ * @param  _file                   输出，取得引用的文件
+ * @return int32_t                 FAT_OK 或 FAT_ERR_*
+ */
+int32_t   fat_open(fat_fs_t* _fs, const char* _path, fat_file_t** _file);
+
+/**
+ * @brief 释放 fat_open 取得的引用
+ * 文件的缓存保留到文件表需要空位时
+ * @param  _file                   文件
+ */
+void      fat_close(fat_file_t* _file);
+
+/**
+ * @brief 读取文件
+ * 可能睡眠，不能在中断上下文中调用
+ * @param  _file                   文件
+ * @param  _offset                 起始字节
+ * @param  _buf                    输出
+ * @param  _len                    长度，超出文件大小的部分不读
+ * @return size_t                  读取的字节数，出错或 _file 是目录时
+ *                                 少于请求的长度
+ */
+size_t    fat_read(fat_file_t* _file, uint64_t _offset, void* _buf,
+                   size_t _len);
+
+/**
+ * @brief 获取文件信息
+ * @param  _file                   文件
+ * @param  _stat                   输出
+ */
+void      fat_stat(const fat_file_t* _file, fat_stat_t* _stat);
+
+/**
+ * @brief 读取目录中的下一项，跳过卷标
+ * @param  _dir                    目录
+ * @param  _pos                    位置，从 0 开始，返回时指向下一项
+ * @param  _ent                    输出
+ * @return int32_t                 FAT_OK，已到末尾时为 FAT_ERR_NOENT
+ */
+int32_t   fat_readdir(fat_file_t* _dir, size_t* _pos, fat_dirent_t* _ent);
+
+#endif /* CMAKE_KERNEL_FAT_H */
@@ -0,0 +1,140 @@
+
+/**
+ * @file initramfs.h
+ * @brief initramfs
+ * @author Zone.N (Zone.Niuzh@hotmail.com)
+ * @version 1.0
+ * @date 2026-10-18
+ * @copyright MIT LICENSE
+ * https://github.com/MRNIU/cmake-kernel
+ * @par change log:
+ * <table>
+ * <tr><th>Date<th>Author<th>Description
+ * <tr><td>2026-10-18<td>Zone.N (Zone.Niuzh@hotmail.com)<td>创建文件
+ * </table>
+ */
+
+#ifndef CMAKE_KERNEL_INITRAMFS_H
+#define CMAKE_KERNEL_INITRAMFS_H
+
+#include "cstddef"
+#include "cstdint"
+
+// 只读的 initramfs，由加载器整体读入一块连续内存，格式为不压缩的 tar 归档
+// (ustar，支持 pax 与 GNU 长文件名)。
+// 初始化时扫描一遍归档头建立 (目录, 名称) 的哈希索引，不解包：
+// 索引中的名称与文件数据都指向归档所在的内存，读取与映射直接返回其中的地址，
+// 不复制。归档内存在整个内核生命周期内保留，返回的指针一直有效
+
+/// 错误码
+static constexpr const int32_t  INITRAMFS_OK           = 0;
+/// 没有 initramfs 或不是有效的 tar 归档
+static constexpr const int32_t  INITRAMFS_ERR_INVAL    = -1;
+static constexpr const int32_t  INITRAMFS_ERR_NOENT    = -2;
+static constexpr const int32_t  INITRAMFS_ERR_NOTDIR   = -3;
+/// 文件数超过索引的容量
+static constexpr const int32_t  INITRAMFS_ERR_NOMEM    = -4;
+
+/// 文件类型
+static constexpr const uint32_t INITRAMFS_TYPE_FILE    = 0;
+static constexpr const uint32_t INITRAMFS_TYPE_DIR     = 1;
+static constexpr const uint32_t INITRAMFS_TYPE_SYMLINK = 2;
+
+/// 文件名的最大字节数，更长的项在建立索引时跳过
+static constexpr const size_t   INITRAMFS_NAME_MAX     = 255;
+
+struct initramfs_file_t;
+
+/**
+ * @brief 目录项
+ */
+struct initramfs_dirent_t {
+    char     name[INITRAMFS_NAME_MAX + 1];
+    /// 文件大小，符号链接为目标路径的长度
+    uint64_t size;
+    /// 权限位
+    uint32_t mode;
+    /// INITRAMFS_TYPE_*
+    uint32_t type;
+};
+
+/**
+ * @brief 文件信息
+ */
+struct initramfs_stat_t {
+    uint64_t size;
+    uint32_t mode;
+    uint32_t type;
+};
+
+/**
+ * @brief 取得加载器传入的 initramfs 并建立索引
+ * 先使用 arch_initrd，没有时查找设备树 /chosen 中的
+ * linux,initrd-start 与 linux,initrd-end。需要在 platform_init 之后调用
+ * @return int32_t                 INITRAMFS_OK 或 INITRAMFS_ERR_*
+ */
+int32_t     initramfs_init(void);
+
+/**
+ * @brief 以 [_base, _base + _size) 中的 tar 归档建立索引
+ * 只能成功一次，之后归档内存不能释放或修改
+ * @param  _base                   归档的起始地址
+ * @param  _size                   归档的长度
+ * @return int32_t                 INITRAMFS_OK 或 INITRAMFS_ERR_*，
+ *                                 归档损坏或文件数超过容量时
+ *                                 已建立的索引仍然可用
+ */
+int32_t     initramfs_mount(const void* _base, size_t _size);
+
+/**
+ * @brief 按路径打开文件或目录，不跟随符号链接
+ * 文件不需要关闭
+ * @param  _path                   以 '/' 分隔的路径，区分大小写
+ * @param  _file                   输出，文件
+ * @return int32_t                 INITRAMFS_OK 或 INITRAMFS_ERR_*
+ */
+int32_t     initramfs_open(const char* _path, const initramfs_file_t** _file);
+
+/**
+ * @brief 读取文件，不复制
+ * 可以在中断上下文中调用
+ * @param  _file                   文件，符号链接读取的是目标路径
+ * @param  _offset                 起始字节
+ * @param  _len                    长度，超出文件大小的部分不读
+ * @param  _data                   输出，指向 initramfs 中 _offset 处的数据
+ * @return size_t                  可读的字节数，_file 是目录时为 0
+ */
+size_t      initramfs_read(const initramfs_file_t* _file, uint64_t _offset,
+                           size_t _len, const void** _data);
+
+/**
+ * @brief 映射整个文件
+ * 数据在 initramfs 中按 tar 的 512 字节块对齐，归档本身页对齐，
+ * 偏移恰好页对齐的文件可以按页映射到其它地址空间
+ * @param  _file                   文件
+ * @param  _size                   输出，文件大小
+ * @return const void*             文件数据，_file 不是普通文件时为 nullptr
+ */
+const void* initramfs_mmap(const initramfs_file_t* _file, size_t* _size);
+
+/**
+ * @brief 获取文件信息
+ * @param  _file                   文件
+ * @param  _stat                   输出
+ */
+void        initramfs_stat(const initramfs_file_t* _file,
+                           initramfs_stat_t* _stat);
+
+/**
+ * @brief 读取目录中的下一项，按归档中的顺序
+ * @param  _dir                    目录
+ * @param  _pos                    位置，从 0 开始，返回时指向下一项
+ * @param  _ent                    输出
+ * @return int32_t                 INITRAMFS_OK，已到末尾时为
+ *                                 INITRAMFS_ERR_NOENT，
+ *                                 _dir 不是目录时为 INITRAMFS_ERR_NOTDIR
+ */
+int32_t     initramfs_readdir(const initramfs_file_t* _dir, size_t* _pos,
+                              initramfs_dirent_t* _ent);
+
+#endif /* CMAKE_KERNEL_INITRAMFS_H */
@@ -0,0 +1,300 @@
+
+/**
+ * @file pagecache.h
+ * @brief 页缓存
+ * @author Zone.N (Zone.Niuzh@hotmail.com)
+ * @version 1.0
+ * @date 2026-10-18
+ * @copyright MIT LICENSE
+ * https://github.com/MRNIU/cmake-kernel
+ * @par change log:
+ * <table>
+ * <tr><th>Date<th>Author<th>Description
+ * <tr><td>2026-10-18<td>Zone.N (Zone.Niuzh@hotmail.com)<td>创建文件
+ * </table>
+ */
+
+#ifndef CMAKE_KERNEL_PAGECACHE_H
+#define CMAKE_KERNEL_PAGECACHE_H
+
+#include "cstddef"
+#include "cstdint"
+
+#include "blkdev.h"
+#include "intrusive_list.hpp"
+#include "mutex.h"
+
+// 页缓存按 (文件, 页号) 缓存存储设备上的数据。
+// 每个文件的页由一棵基数树索引，读者在 rcu 读端临界区中无锁查找，
+// 修改由全局锁串行化。
+// 回收使用 CLOCK-Pro: 所有页与刚被回收的页的记录 (非驻留页) 在同一个
+// 时钟上，冷页在测试期内再次被访问说明它的重用距离小于热页，提升为热页；
+// 非驻留页在测试期内被再次读入时增大冷页的目标数量，测试期结束时减小，
+// 一次性的顺序扫描因此只会替换冷页。
+// 预读按文件识别顺序访问，窗口随命中逐步增大，随机访问时不预读。
+// 脏页由后台按文件内的顺序成批写回，相邻的页由块层合并成一个请求
+
+/// 页大小
+static constexpr const size_t   PCACHE_PAGE_SHIFT   = 12;
+static constexpr const size_t   PCACHE_PAGE_SIZE    = 1 << PCACHE_PAGE_SHIFT;
+/// 每页的扇区数
+static constexpr const uint32_t PCACHE_PAGE_SECTORS = PCACHE_PAGE_SIZE
+                                                      / SECTOR_SIZE;
+/// 缓存的页数
+static constexpr const size_t   PCACHE_PAGES        = 1024;
+
+/// 页被锁定，正在读入或被独占修改
+static constexpr const uint32_t PG_LOCKED           = 1 << 0;
+/// 数据有效
+static constexpr const uint32_t PG_UPTODATE         = 1 << 1;
+static constexpr const uint32_t PG_DIRTY            = 1 << 2;
+/// 正在写回
+static constexpr const uint32_t PG_WRITEBACK        = 1 << 3;
+/// 最近一次读入失败
+static constexpr const uint32_t PG_ERROR            = 1 << 4;
+/// 上次时钟指针经过后被访问过
+static constexpr const uint32_t PG_REFERENCED       = 1 << 5;
+/// 热页
+static constexpr const uint32_t PG_HOT              = 1 << 6;
+/// 冷页处于测试期
+static constexpr const uint32_t PG_TEST             = 1 << 7;
+/// 非驻留页，只保留记录，没有数据
+static constexpr const uint32_t PG_GHOST            = 1 << 8;
+/// 由预读读入，还没有被访问
+static constexpr const uint32_t PG_READAHEAD        = 1 << 9;
+/// 预读标记，访问到时开始下一个窗口的异步预读
+static constexpr const uint32_t PG_RA_MARK          = 1 << 10;
+
+struct pcache_mapping_t;
+struct pcache_node_t;
+
+/**
+ * @brief 缓存页的描述符
+ * 描述符来自静态的池，回收后仍然可以访问，无锁查找得到的页需要
+ * 在取得引用后重新检查 mapping 与 index
+ */
+struct page_t {
+    pcache_mapping_t* mapping;
+    /// 文件内的页号
+    uint64_t          index;
+    /// PG_*
+    uint32_t          flags;
+    /// 使用者的引用数，PAGE_FROZEN 表示正在回收或没有数据，不能取得引用
+    uint32_t          refcount;
+    /// 数据，非驻留时为 nullptr
+    uint8_t*          data;
+    /// 时钟或空闲链表中的节点
+    ListNode          node;
+    /// 未完成的 bio 数
+    uint32_t          io_pending;
+};
+
+/**
+ * @brief 文件的操作，由文件系统提供
+ */
+struct pcache_mapping_ops_t {
+    /**
+     * @brief 把文件内的扇区映射到设备上的扇区
+     * @param  _mapping            文件
+     * @param  _sector             文件内的扇区
+     * @param  _disk               输出，设备上的扇区
+     * @param  _count              输出，从 _sector 起在设备上连续的扇区数
+     * @return int32_t             BLK_STS_*
+     */
+    int32_t (*map)(pcache_mapping_t* _mapping, uint64_t _sector,
+                   uint64_t* _disk, uint32_t* _count);
+};
+
+/**
+ * @brief 文件的预读状态
+ * 当前窗口为 [start, start + size)，访问到窗口中第
+ * size - async_size 页时异步读入下一个窗口
+ */
+struct pcache_ra_t {
+    uint64_t start;
+    uint32_t size;
+    uint32_t async_size;
+    /// 上一次访问的页号
+    uint64_t prev_index;
+};
+
+/**
+ * @brief 页缓存中的一个文件
+ * 文件系统把它嵌入到自己的文件结构中，ops 为 nullptr 时直接映射块设备，
+ * 作为文件系统元数据的缓存
+ */
+struct pcache_mapping_t {
+    blk_dev_t*                  bdev;
+    const pcache_mapping_ops_t* ops;
+    void*                       private_data;
+    /// 文件大小，字节，之后的部分读为 0 且不写回
+    uint64_t                    size;
+    /// 基数树的根，rcu 保护
+    pcache_node_t*              root;
+    /// 缓存中的驻留页数与脏页数
+    size_t                      nr_pages;
+    size_t                      nr_dirty;
+    pcache_ra_t                 ra;
+    /// 串行化写回
+    Mutex                       wb_lock;
+    /// 写回中的页数与最近一次写回错误
+    uint32_t                    nr_writeback;
+    int32_t                     wb_error;
+    /// 后台写回遍历的链表节点
+    ListNode                    node;
+};
+
+/**
+ * @brief 页缓存的统计
+ */
+struct pcache_stats_t {
+    /// 查找命中与未命中的页数
+    uint64_t hits;
+    uint64_t misses;
+    /// 命中率，千分比
+    uint64_t hit_ratio;
+    /// 预读读入的页数，其中被访问到的与未访问就被回收的
+    uint64_t ra_pages;
+    uint64_t ra_hits;
+    uint64_t ra_wasted;
+    /// 预读页的命中率，千分比
+    uint64_t ra_ratio;
+    /// 同步读入与异步预读的窗口数
+    uint64_t ra_sync;
+    uint64_t ra_async;
+    /// 回收的页数，其中在测试期内被再次读入的
+    uint64_t evictions;
+    uint64_t refaults;
+    /// 冷页提升为热页与热页降为冷页的次数
+    uint64_t promotions;
+    uint64_t demotions;
+    /// 写回的页数，与其中文件内连续的段数
+    uint64_t wb_pages;
+    uint64_t wb_clusters;
+    uint64_t io_errors;
+    /// 当前的热页、冷页与非驻留页数，冷页的目标数量
+    uint64_t nr_hot;
+    uint64_t nr_cold;
+    uint64_t nr_ghost;
+    uint64_t cold_target;
+    uint64_t nr_free;
+    uint64_t nr_dirty;
+};
+
+/**
+ * @brief 初始化页缓存，在工作队列之后调用
+ */
+void     pcache_init(void);
+
+/**
+ * @brief 初始化文件，加入后台写回
+ * @param  _mapping                文件
+ * @param  _bdev                   所在的块设备
+ * @param  _ops                    文件系统的操作，为 nullptr 时直接映射块设备
+ * @param  _size                   文件大小，字节
+ */
+void     pcache_mapping_init(pcache_mapping_t* _mapping, blk_dev_t* _bdev,
+                             const pcache_mapping_ops_t* _ops, uint64_t _size);
+
+/**
+ * @brief 写回并丢弃文件的全部页，之后可以释放 _mapping
+ * 调用者需要保证没有其它使用者
+ * @param  _mapping                文件
+ * @return int32_t                 写回的结果，BLK_STS_*
+ */
+int32_t  pcache_mapping_destroy(pcache_mapping_t* _mapping);
+
+/**
+ * @brief 查找页，不读入
+ * @param  _mapping                文件
+ * @param  _index                  页号
+ * @return page_t*                 取得引用的页，可能还没有数据，
+ *                                 不在缓存中时为 nullptr
+ */
+page_t*  pcache_find(pcache_mapping_t* _mapping, uint64_t _index);
+
+/**
+ * @brief 读取页，不在缓存中时读入，并按访问模式预读
+ * 可能睡眠，不能在中断上下文中调用
+ * @param  _mapping                文件
+ * @param  _index                  页号
+ * @return page_t*                 取得引用且数据有效的页，读入失败时为 nullptr
+ */
+page_t*  pcache_read_page(pcache_mapping_t* _mapping, uint64_t _index);
+
+/**
+ * @brief 取得页用于整页覆盖，不在缓存中时分配但不读入
+ * @param  _mapping                文件
+ * @param  _index                  页号
+ * @return page_t*                 取得引用且已锁定的页，没有内存时为 nullptr
+ */
+page_t*  pcache_grab_page(pcache_mapping_t* _mapping, uint64_t _index);
+
+/**
+ * @brief 释放 pcache_find/pcache_read_page/pcache_grab_page 取得的引用
+ * @param  _page                   页
+ */
+void     page_put(page_t* _page);
+
+/**
+ * @brief 锁定页，可能睡眠
+ * @param  _page                   页，调用者持有引用
+ */
+void     lock_page(page_t* _page);
+
+/**
+ * @brief 解锁页并唤醒等待者
+ * @param  _page                   页
+ */
+void     unlock_page(page_t* _page);
+
+/**
+ * @brief 标记页为脏，调用者持有引用，修改数据时需要锁定页
+ * 脏页过多时唤醒后台写回
+ * @param  _page                   页
+ */
+void     page_mark_dirty(page_t* _page);
+
+/**
+ * @brief 经过缓存读取文件
+ * @param  _mapping                文件
+ * @param  _offset                 起始字节
+ * @param  _buf                    输出
+ * @param  _len                    长度，超出文件大小的部分不读
+ * @return size_t                  读取的字节数，出错时少于请求的长度
+ */
+size_t   pcache_read(pcache_mapping_t* _mapping, uint64_t _offset,
+                     void* _buf, size_t _len);
+
+/**
+ * @brief 经过缓存写入文件，只修改缓存，由写回写到设备
+ * 不改变文件大小，调用者需要先扩展文件
+ * @param  _mapping                文件
+ * @param  _offset                 起始字节
+ * @param  _buf                    数据
+ * @param  _len                    长度，超出文件大小的部分不写
+ * @return size_t                  写入的字节数，出错时少于请求的长度
+ */
+size_t   pcache_write(pcache_mapping_t* _mapping, uint64_t _offset,
+                      const void* _buf, size_t _len);
+
+/**
+ * @brief 写回文件的全部脏页并等待完成
+ * @param  _mapping                文件
+ * @return int32_t                 BLK_STS_*，任意一页失败时为错误
+ */
+int32_t  pcache_writeback(pcache_mapping_t* _mapping);
+
+/**
+ * @brief 写回全部文件
+ * @return int32_t                 BLK_STS_*
+ */
+int32_t  pcache_sync(void);
+
+/**
+ * @brief 获取统计
+ * @param  _stats                  输出
+ */
+void     pcache_get_stats(pcache_stats_t* _stats);
+
+#endif /* CMAKE_KERNEL_PAGECACHE_H */
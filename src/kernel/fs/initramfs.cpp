@@ -0,0 +1,634 @@
+
+/**
+ * @file initramfs.cpp
+ * @brief initramfs
+ * @author Zone.N (Zone.Niuzh@hotmail.com)
+ * @version 1.0
+ * @date 2026-10-18
+ * @copyright MIT LICENSE
+ * https://github.com/MRNIU/cmake-kernel
+ * @par change log:
+ * <table>
+ * <tr><th>Date<th>Author<th>Description
+ * <tr><td>2026-10-18<td>Zone.N (Zone.Niuzh@hotmail.com)<td>创建文件
+ * </table>
+ */
+
+#include "initramfs.h"
+
+#include "arch.h"
+#include "fdt.h"
+#include "flat_hash_map.hpp"
+#include "libc.h"
+
+/// 索引的容量，包括根目录与归档中没有单独记录的上级目录
+static constexpr const size_t   INITRAMFS_FILES  = 2048;
+/// 哈希索引的槽数，装载因子不超过 1/2
+static constexpr const size_t   INITRAMFS_SLOTS  = 4096;
+/// 块大小，头部与数据都按块对齐
+static constexpr const size_t   TAR_BLOCK        = 512;
+/// 类型标志，旧格式的普通文件为 '\0'
+static constexpr const char     TAR_REG          = '0';
+static constexpr const char     TAR_AREG         = '\0';
+static constexpr const char     TAR_LINK         = '1';
+static constexpr const char     TAR_SYMLINK      = '2';
+static constexpr const char     TAR_DIR          = '5';
+static constexpr const char     TAR_CONTIG       = '7';
+/// pax 扩展头，'x' 只作用于下一项，'g' 作用于之后的全部项
+static constexpr const char     TAR_PAX          = 'x';
+static constexpr const char     TAR_PAX_GLOBAL   = 'g';
+/// GNU 长文件名与长链接名，作用于下一项
+static constexpr const char     TAR_GNU_NAME     = 'L';
+static constexpr const char     TAR_GNU_LINK     = 'K';
+/// POSIX ustar 的魔数，GNU 格式为 "ustar  \0"，没有前缀字段
+static constexpr const char     USTAR_MAGIC[]    = "ustar";
+/// 没有单独记录的目录的权限
+static constexpr const uint32_t DIR_MODE_DEFAULT = 0755;
+static constexpr const uint32_t MODE_MASK        = 07777;
+/// 表示没有的下标，0 是根目录，不会是其它项的子项、兄弟或同键项
+static constexpr const uint32_t NONE             = 0;
+/// readdir 已到末尾的位置
+static constexpr const size_t   POS_END          = SIZE_MAX;
+
+/**
+ * @brief tar 头部，数值字段为 ASCII 八进制
+ */
+struct tar_header_t {
+    char name[100];
+    char mode[8];
+    char uid[8];
+    char gid[8];
+    char size[12];
+    char mtime[12];
+    char chksum[8];
+    char typeflag;
+    char linkname[100];
+    char magic[6];
+    char version[2];
+    char uname[32];
+    char gname[32];
+    char devmajor[8];
+    char devminor[8];
+    char prefix[155];
+    char pad[12];
+} __attribute__((packed));
+
+static_assert(sizeof(tar_header_t) == TAR_BLOCK);
+
+/**
+ * @brief 路径，ustar 的路径分为前缀与名称两段，其它情况只用第一段。
+ * 各段不需要以 0 结尾
+ */
+struct path_t {
+    const char* part[2];
+    size_t      len[2];
+};
+
+/**
+ * @brief 长文件名与 pax 扩展头给出的、作用于下一项的属性
+ */
+struct tar_next_t {
+    /// 路径与链接目标，nullptr 表示使用头部中的字段
+    const char* name;
+    size_t      name_len;
+    const char* link;
+    size_t      link_len;
+    bool        has_size;
+    uint64_t    size;
+};
+
+/**
+ * @brief 索引项
+ */
+struct initramfs_file_t {
+    /// 文件数据或符号链接目标，指向归档内存
+    const uint8_t* data;
+    uint64_t       size;
+    /// 名称，指向归档内存，不以 0 结尾
+    const char*    name;
+    uint32_t       len;
+    uint32_t       mode;
+    uint32_t       type;
+    /// 父目录，根目录的父目录是自己
+    uint32_t       parent;
+    /// 第一个与最后一个子项，以及下一个兄弟，按归档中的顺序
+    uint32_t       child;
+    uint32_t       last;
+    uint32_t       sibling;
+    /// 键相同的下一项
+    uint32_t       chain;
+};
+
+/// 索引，第 0 项为根目录
+static initramfs_file_t                                 files[INITRAMFS_FILES];
+static size_t                                           file_count;
+/// (父目录, 名称) 的哈希到键相同的第一项
+static FlatHashMap<uint64_t, uint32_t, INITRAMFS_SLOTS> names;
+/// 正在或已经建立索引，以及索引可以使用
+static bool                                             claimed;
+static bool                                             mounted;
+
+static uint32_t index_of(const initramfs_file_t* _file) {
+    return static_cast<uint32_t>(_file - files);
+}
+
+/**
+ * @brief 字段中 '\0' 之前的长度
+ */
+static size_t field_len(const char* _field, size_t _max) {
+    size_t len = 0;
+    while ((len < _max) && (_field[len] != '\0')) {
+        len++;
+    }
+    return len;
+}
+
+/**
+ * @brief 读取数值字段
+ * 最高位为 1 时是 GNU 的大端二进制数，否则是八进制数，
+ * 以空格或 '\0' 结束
+ */
+static uint64_t tar_number(const char* _field, size_t _len) {
+    auto*    ptr = reinterpret_cast<const uint8_t*>(_field);
+    uint64_t val = 0;
+    if ((ptr[0] & 0x80) != 0) {
+        val = ptr[0] & 0x7F;
+        for (size_t i = 1; i < _len; i++) {
+            val = (val << 8) | ptr[i];
+        }
+        return val;
+    }
+    size_t i = 0;
+    while ((i < _len) && (ptr[i] == ' ')) {
+        i++;
+    }
+    for (; (i < _len) && (ptr[i] >= '0') && (ptr[i] <= '7'); i++) {
+        val = (val << 3) | (ptr[i] - '0');
+    }
+    return val;
+}
+
+/**
+ * @brief 检查魔数与校验和
+ * 校验和是头部全部字节的无符号和，计算时校验和字段按空格处理
+ */
+static bool tar_header_valid(const tar_header_t* _header) {
+    if (memcmp(_header->magic, USTAR_MAGIC, sizeof(USTAR_MAGIC) - 1) != 0) {
+        return false;
+    }
+    auto*    ptr = reinterpret_cast<const uint8_t*>(_header);
+    uint64_t sum = 0;
+    for (size_t i = 0; i < TAR_BLOCK; i++) {
+        sum += ptr[i];
+    }
+    for (auto ch : _header->chksum) {
+        sum = sum - static_cast<uint8_t>(ch) + ' ';
+    }
+    return sum == tar_number(_header->chksum, sizeof(_header->chksum));
+}
+
+static bool block_zero(const uint8_t* _block) {
+    for (size_t i = 0; i < TAR_BLOCK; i++) {
+        if (_block[i] != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief 解析 pax 扩展头，记录格式为 "长度 键=值\n"，长度包括整条记录。
+ * 只使用 path、linkpath 与 size，值指向归档内存
+ */
+static void pax_parse(const char* _data, size_t _size, tar_next_t* _next) {
+    size_t pos = 0;
+    while (pos < _size) {
+        size_t len = 0;
+        auto   i   = pos;
+        while ((i < _size) && (_data[i] >= '0') && (_data[i] <= '9')
+               && (len <= _size)) {
+            len = len * 10 + (_data[i] - '0');
+            i++;
+        }
+        if ((len == 0) || (len > _size - pos) || (i >= pos + len)
+            || (_data[i] != ' ') || (_data[pos + len - 1] != '\n')) {
+            return;
+        }
+        auto* key = _data + i + 1;
+        auto* end = _data + pos + len - 1;
+        auto* val = key;
+        while ((val < end) && (*val != '=')) {
+            val++;
+        }
+        if (val != end) {
+            auto key_len = static_cast<size_t>(val - key);
+            val++;
+            auto val_len = static_cast<size_t>(end - val);
+            if ((key_len == 4) && (memcmp(key, "path", 4) == 0)) {
+                _next->name     = val;
+                _next->name_len = val_len;
+            }
+            else if ((key_len == 8) && (memcmp(key, "linkpath", 8) == 0)) {
+                _next->link     = val;
+                _next->link_len = val_len;
+            }
+            else if ((key_len == 4) && (memcmp(key, "size", 4) == 0)) {
+                _next->has_size = true;
+                _next->size     = 0;
+                for (auto* ptr = val;
+                     (ptr < end) && (*ptr >= '0') && (*ptr <= '9'); ptr++) {
+                    _next->size = _next->size * 10 + (*ptr - '0');
+                }
+            }
+        }
+        pos += len;
+    }
+    return;
+}
+
+/**
+ * @brief 索引的键
+ */
+static uint64_t name_key(uint32_t _dir, const char* _name, size_t _len) {
+    // FNV-1a
+    uint64_t hash = 0xcbf29ce484222325ULL ^ _dir;
+    for (size_t i = 0; i < _len; i++) {
+        hash ^= static_cast<uint8_t>(_name[i]);
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+static initramfs_file_t* child_find(const initramfs_file_t* _dir,
+                                    const char* _name, size_t _len) {
+    auto  dir  = index_of(_dir);
+    auto* head = names.find(name_key(dir, _name, _len));
+    for (auto idx = head == nullptr ? NONE : *head; idx != NONE;
+         idx      = files[idx].chain) {
+        auto* file = &files[idx];
+        if ((file->parent == dir) && (file->len == _len)
+            && (memcmp(file->name, _name, _len) == 0)) {
+            return file;
+        }
+    }
+    return nullptr;
+}
+
+/**
+ * @brief 在目录末尾添加一个目录
+ * @return initramfs_file_t*       新的项，索引已满时为 nullptr
+ */
+static initramfs_file_t* child_add(initramfs_file_t* _dir, const char* _name,
+                                   size_t _len) {
+    if (file_count == INITRAMFS_FILES) {
+        return nullptr;
+    }
+    auto  dir  = index_of(_dir);
+    auto  key  = name_key(dir, _name, _len);
+    auto* head = names.find(key);
+    if ((head == nullptr) && ((head = names.insert(key, NONE)) == nullptr)) {
+        return nullptr;
+    }
+    auto  idx    = static_cast<uint32_t>(file_count++);
+    auto* file   = &files[idx];
+    *file        = {};
+    file->name   = _name;
+    file->len    = static_cast<uint32_t>(_len);
+    file->mode   = DIR_MODE_DEFAULT;
+    file->type   = INITRAMFS_TYPE_DIR;
+    file->parent = dir;
+    file->chain  = *head;
+    *head        = idx;
+    if (_dir->child == NONE) {
+        _dir->child = idx;
+    }
+    else {
+        files[_dir->last].sibling = idx;
+    }
+    _dir->last = idx;
+    return file;
+}
+
+/**
+ * @brief 按路径查找
+ * @param  _path                   路径，忽略空的分量与 "."
+ * @param  _create                 是否创建不存在的项，新的项都是目录，
+ *                                 此时 ".." 无效
+ * @param  _file                   输出，路径指向的项
+ * @return int32_t                 INITRAMFS_OK 或 INITRAMFS_ERR_*
+ */
+static int32_t path_walk(const path_t& _path, bool _create,
+                         initramfs_file_t** _file) {
+    auto* cur = &files[0];
+    for (size_t part = 0; part < 2; part++) {
+        auto* str = _path.part[part];
+        auto  len = _path.len[part];
+        for (size_t i = 0, j; i < len; i = j + 1) {
+            j = i;
+            while ((j < len) && (str[j] != '/')) {
+                j++;
+            }
+            auto* name     = str + i;
+            auto  name_len = j - i;
+            if ((name_len == 0) || ((name_len == 1) && (name[0] == '.'))) {
+                continue;
+            }
+            if (cur->type != INITRAMFS_TYPE_DIR) {
+                return INITRAMFS_ERR_NOTDIR;
+            }
+            if ((name_len == 2) && (name[0] == '.') && (name[1] == '.')) {
+                if (_create) {
+                    return INITRAMFS_ERR_INVAL;
+                }
+                cur = &files[cur->parent];
+                continue;
+            }
+            if (name_len > INITRAMFS_NAME_MAX) {
+                return _create ? INITRAMFS_ERR_INVAL : INITRAMFS_ERR_NOENT;
+            }
+            auto* next = child_find(cur, name, name_len);
+            if (next == nullptr) {
+                if (!_create) {
+                    return INITRAMFS_ERR_NOENT;
+                }
+                next = child_add(cur, name, name_len);
+                if (next == nullptr) {
+                    return INITRAMFS_ERR_NOMEM;
+                }
+            }
+            cur = next;
+        }
+    }
+    *_file = cur;
+    return INITRAMFS_OK;
+}
+
+/**
+ * @brief 把归档中的一项加入索引，不支持的类型与无效的路径跳过
+ * @param  _header                 头部
+ * @param  _data                   数据
+ * @param  _size                   数据长度
+ * @param  _next                   前面的扩展头给出的属性
+ * @return int32_t                 INITRAMFS_OK，索引已满时为
+ *                                 INITRAMFS_ERR_NOMEM
+ */
+static int32_t tar_add(const tar_header_t* _header, const uint8_t* _data,
+                       uint64_t _size, const tar_next_t& _next) {
+    path_t path = {};
+    if (_next.name != nullptr) {
+        path.part[0] = _next.name;
+        path.len[0]  = _next.name_len;
+    }
+    else {
+        // 只有 POSIX ustar 有前缀字段，前缀与名称之间隐含一个 '/'
+        if (_header->magic[sizeof(USTAR_MAGIC) - 1] == '\0') {
+            path.part[0] = _header->prefix;
+            path.len[0]  = field_len(_header->prefix, sizeof(_header->prefix));
+        }
+        path.part[1] = _header->name;
+        path.len[1]  = field_len(_header->name, sizeof(_header->name));
+    }
+    path_t link = {};
+    if (_next.link != nullptr) {
+        link.part[0] = _next.link;
+        link.len[0]  = _next.link_len;
+    }
+    else {
+        link.part[0] = _header->linkname;
+        link.len[0]  = field_len(_header->linkname, sizeof(_header->linkname));
+    }
+
+    auto              flag   = _header->typeflag;
+    initramfs_file_t* target = nullptr;
+    uint32_t          type;
+    if ((flag == TAR_REG) || (flag == TAR_AREG) || (flag == TAR_CONTIG)) {
+        type = INITRAMFS_TYPE_FILE;
+    }
+    else if (flag == TAR_DIR) {
+        type = INITRAMFS_TYPE_DIR;
+    }
+    else if (flag == TAR_SYMLINK) {
+        type = INITRAMFS_TYPE_SYMLINK;
+    }
+    else if (flag == TAR_LINK) {
+        // 硬链接共享目标的数据，目标在归档中位于链接之前
+        if ((path_walk(link, false, &target) != INITRAMFS_OK)
+            || (target->type != INITRAMFS_TYPE_FILE)) {
+            return INITRAMFS_OK;
+        }
+        type = INITRAMFS_TYPE_FILE;
+    }
+    else {
+        // 设备文件与管道
+        return INITRAMFS_OK;
+    }
+
+    initramfs_file_t* file;
+    auto              status = path_walk(path, true, &file);
+    if (status != INITRAMFS_OK) {
+        return status == INITRAMFS_ERR_NOMEM ? status : INITRAMFS_OK;
+    }
+    // 同名的项以后出现的为准，但不替换非空的目录
+    if ((file->type == INITRAMFS_TYPE_DIR) && (type != INITRAMFS_TYPE_DIR)
+        && ((file->child != NONE) || (file == &files[0]))) {
+        return INITRAMFS_OK;
+    }
+    file->type = type;
+    file->mode = static_cast<uint32_t>(
+      tar_number(_header->mode, sizeof(_header->mode)) & MODE_MASK);
+    if (target != nullptr) {
+        file->data = target->data;
+        file->size = target->size;
+    }
+    else if (type == INITRAMFS_TYPE_FILE) {
+        file->data = _data;
+        file->size = _size;
+    }
+    else if (type == INITRAMFS_TYPE_SYMLINK) {
+        file->data = reinterpret_cast<const uint8_t*>(link.part[0]);
+        file->size = link.len[0];
+    }
+    else {
+        file->data = nullptr;
+        file->size = 0;
+    }
+    return INITRAMFS_OK;
+}
+
+/**
+ * @brief 设备树 /chosen 中描述的 initrd
+ * @param  _size                   输出，长度
+ * @return const void*             起始地址，没有时为 nullptr
+ */
+static const void* fdt_initrd(size_t* _size) {
+    int32_t depth = 0;
+    for (auto node = fdt_next_node(-1, &depth); node >= 0;
+         node      = fdt_next_node(node, &depth)) {
+        if ((depth != 1) || (strcmp(fdt_node_name(node), "chosen") != 0)) {
+            continue;
+        }
+        size_t start_len;
+        size_t end_len;
+        auto*  start = fdt_get_prop(node, "linux,initrd-start", &start_len);
+        auto*  end   = fdt_get_prop(node, "linux,initrd-end", &end_len);
+        // 属性为 1 个或 2 个单元
+        if ((start == nullptr) || (end == nullptr)
+            || ((start_len != 4) && (start_len != 8))
+            || ((end_len != 4) && (end_len != 8))) {
+            return nullptr;
+        }
+        auto base  = fdt_cells(start, 0, start_len / sizeof(uint32_t));
+        auto limit = fdt_cells(end, 0, end_len / sizeof(uint32_t));
+        if (limit <= base) {
+            return nullptr;
+        }
+        *_size = limit - base;
+        return reinterpret_cast<const void*>(base);
+    }
+    return nullptr;
+}
+
+int32_t initramfs_init(void) {
+    size_t size = 0;
+    auto*  base = arch_initrd(&size);
+    if (base == nullptr) {
+        base = fdt_initrd(&size);
+    }
+    return initramfs_mount(base, size);
+}
+
+int32_t initramfs_mount(const void* _base, size_t _size) {
+    auto* base = static_cast<const uint8_t*>(_base);
+    // 第一个头部不是 ustar 时认为不是 tar 归档
+    if ((base == nullptr) || (_size < TAR_BLOCK)
+        || !tar_header_valid(reinterpret_cast<const tar_header_t*>(base))) {
+        return INITRAMFS_ERR_INVAL;
+    }
+    if (__atomic_exchange_n(&claimed, true, __ATOMIC_ACQ_REL)) {
+        return INITRAMFS_ERR_INVAL;
+    }
+    files[0]      = {};
+    files[0].name = "";
+    files[0].mode = DIR_MODE_DEFAULT;
+    files[0].type = INITRAMFS_TYPE_DIR;
+    file_count    = 1;
+
+    auto       status = INITRAMFS_OK;
+    tar_next_t next   = {};
+    for (size_t off = 0; off + TAR_BLOCK <= _size;) {
+        // 归档以两个全 0 的块结束
+        if (block_zero(base + off)) {
+            break;
+        }
+        auto* header = reinterpret_cast<const tar_header_t*>(base + off);
+        if (!tar_header_valid(header)) {
+            status = INITRAMFS_ERR_INVAL;
+            break;
+        }
+        auto flag = header->typeflag;
+        // 扩展头的长度不受前面的 pax size 影响
+        auto ext  = (flag == TAR_PAX) || (flag == TAR_PAX_GLOBAL)
+                    || (flag == TAR_GNU_NAME) || (flag == TAR_GNU_LINK);
+        auto size = (next.has_size && !ext)
+                      ? next.size
+                      : tar_number(header->size, sizeof(header->size));
+        auto* data = base + off + TAR_BLOCK;
+        // 数据越界说明归档被截断
+        if (size > _size - off - TAR_BLOCK) {
+            status = INITRAMFS_ERR_INVAL;
+            break;
+        }
+        off += TAR_BLOCK + ((size + TAR_BLOCK - 1) & ~(TAR_BLOCK - 1));
+        auto* str = reinterpret_cast<const char*>(data);
+        if (flag == TAR_PAX) {
+            pax_parse(str, size, &next);
+            continue;
+        }
+        if (flag == TAR_GNU_NAME) {
+            next.name     = str;
+            next.name_len = field_len(str, size);
+            continue;
+        }
+        if (flag == TAR_GNU_LINK) {
+            next.link     = str;
+            next.link_len = field_len(str, size);
+            continue;
+        }
+        // 全局扩展头只包含时间与字符集等不使用的属性
+        if (flag == TAR_PAX_GLOBAL) {
+            continue;
+        }
+        status = tar_add(header, data, size, next);
+        next   = {};
+        if (status != INITRAMFS_OK) {
+            break;
+        }
+    }
+    __atomic_store_n(&mounted, true, __ATOMIC_RELEASE);
+    return status;
+}
+
+int32_t initramfs_open(const char* _path, const initramfs_file_t** _file) {
+    if (!__atomic_load_n(&mounted, __ATOMIC_ACQUIRE)) {
+        return INITRAMFS_ERR_NOENT;
+    }
+    path_t            path = { { _path, nullptr }, { strlen(_path), 0 } };
+    initramfs_file_t* file;
+    auto              status = path_walk(path, false, &file);
+    if (status == INITRAMFS_OK) {
+        *_file = file;
+    }
+    return status;
+}
+
+size_t initramfs_read(const initramfs_file_t* _file, uint64_t _offset,
+                      size_t _len, const void** _data) {
+    if ((_file->type == INITRAMFS_TYPE_DIR) || (_offset >= _file->size)) {
+        *_data = nullptr;
+        return 0;
+    }
+    if (_len > _file->size - _offset) {
+        _len = _file->size - _offset;
+    }
+    *_data = _file->data + _offset;
+    return _len;
+}
+
+const void* initramfs_mmap(const initramfs_file_t* _file, size_t* _size) {
+    if (_file->type != INITRAMFS_TYPE_FILE) {
+        *_size = 0;
+        return nullptr;
+    }
+    *_size = _file->size;
+    return _file->data;
+}
+
+void initramfs_stat(const initramfs_file_t* _file, initramfs_stat_t* _stat) {
+    _stat->size = _file->size;
+    _stat->mode = _file->mode;
+    _stat->type = _file->type;
+    return;
+}
+
+int32_t initramfs_readdir(const initramfs_file_t* _dir, size_t* _pos,
+                          initramfs_dirent_t* _ent) {
+    if (_dir->type != INITRAMFS_TYPE_DIR) {
+        return INITRAMFS_ERR_NOTDIR;
+    }
+    // 位置是下一项在索引中的下标，0 表示从第一个子项开始
+    if (*_pos == POS_END) {
+        return INITRAMFS_ERR_NOENT;
+    }
+    auto idx = *_pos == 0 ? _dir->child : static_cast<uint32_t>(*_pos);
+    if ((idx == NONE) || (idx >= file_count)) {
+        return INITRAMFS_ERR_NOENT;
+    }
+    auto* file = &files[idx];
+    memcpy(_ent->name, file->name, file->len);
+    _ent->name[file->len] = '\0';
+    _ent->size            = file->size;
+    _ent->mode            = file->mode;
+    _ent->type            = file->type;
+    *_pos                 = file->sibling == NONE ? POS_END : file->sibling;
+    return INITRAMFS_OK;
+}
@@ -0,0 +1,1459 @@
+
+/**
+ * @file pagecache.cpp
+ * @brief 页缓存
+ * @author Zone.N (Zone.Niuzh@hotmail.com)
+ * @version 1.0
+ * @date 2026-10-18
+ * @copyright MIT LICENSE
+ * https://github.com/MRNIU/cmake-kernel
+ * @par change log:
+ * <table>
+ * <tr><th>Date<th>Author<th>Description
+ * <tr><td>2026-10-18<td>Zone.N (Zone.Niuzh@hotmail.com)<td>创建文件
+ * </table>
+ */
+
+#include "pagecache.h"
+
+#include "bio.h"
+#include "ktime.h"
+#include "libc.h"
+#include "new"
+#include "percpu.h"
+#include "rcu.h"
+#include "spinlock.hpp"
+#include "wait.h"
+#include "workqueue.h"
+
+/// 基数树每层的位数
+static constexpr const size_t   RADIX_SHIFT  = 6;
+static constexpr const size_t   RADIX_SLOTS  = 1 << RADIX_SHIFT;
+static constexpr const size_t   RADIX_MASK   = RADIX_SLOTS - 1;
+/// 基数树节点数
+static constexpr const size_t   PCACHE_NODES = PCACHE_PAGES;
+/// 描述符数，非驻留页不超过驻留页的总数
+static constexpr const size_t   PCACHE_DESCS = PCACHE_PAGES * 2;
+/// 页 io 使用的 bio 数
+static constexpr const size_t   PCACHE_BIOS  = 256;
+/// 冻结的引用计数
+static constexpr const uint32_t PAGE_FROZEN  = 0x80000000;
+/// 冷页目标数量的下限与初始值
+static constexpr const size_t   COLD_MIN     = PCACHE_PAGES / 64;
+static constexpr const size_t   COLD_INIT    = PCACHE_PAGES / 8;
+/// 预读窗口的初始与最大页数
+static constexpr const uint32_t RA_INIT      = 4;
+static constexpr const uint32_t RA_MAX       = 32;
+/// 写回时一次从基数树中取出的页数
+static constexpr const size_t   WB_BATCH     = 16;
+/// 脏页超过该数量时立即开始写回
+static constexpr const size_t   DIRTY_LIMIT  = PCACHE_PAGES / 4;
+/// 脏页最长的停留时间
+static constexpr const uint64_t WB_INTERVAL  = 5 * NSEC_PER_SEC;
+
+/**
+ * @brief 基数树节点
+ */
+struct pcache_node_t {
+    /// 必须是第一个成员，延迟释放，空闲时作为空闲链表
+    rcu_head_t     rcu;
+    /// 子节点，最低层为页
+    void*          slots[RADIX_SLOTS];
+    /// 子树中有脏页的槽
+    uint64_t       dirty;
+    pcache_node_t* parent;
+    /// 在父节点中的槽号
+    uint32_t       offset;
+    /// 槽号对应页号的位移，最低层为 0
+    uint32_t       shift;
+    /// 非空的槽数
+    uint32_t       count;
+};
+
+/**
+ * @brief 每个 cpu 的统计
+ */
+struct alignas(CACHE_LINE_SIZE) pcache_cpu_stats_t {
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t ra_pages;
+    uint64_t ra_hits;
+    uint64_t ra_wasted;
+    uint64_t ra_sync;
+    uint64_t ra_async;
+    uint64_t evictions;
+    uint64_t refaults;
+    uint64_t promotions;
+    uint64_t demotions;
+    uint64_t wb_pages;
+    uint64_t wb_clusters;
+    uint64_t io_errors;
+};
+
+/// 保护基数树的修改、时钟与空闲的页
+static TicketLock pcache_lock;
+
+/// 页的数据
+alignas(PCACHE_PAGE_SIZE) static uint8_t
+  pcache_frames[PCACHE_PAGES][PCACHE_PAGE_SIZE];
+static uint8_t* free_frames[PCACHE_PAGES];
+static size_t   nr_free_frames;
+
+/// 描述符，空闲的冻结在空闲链表中
+static page_t                               pcache_descs[PCACHE_DESCS];
+static IntrusiveList<page_t, &page_t::node> free_descs;
+static size_t                               nr_dirty;
+
+/// 节点在 rcu 回调中释放，单独加锁
+static TicketLock    node_lock;
+static pcache_node_t pcache_nodes[PCACHE_NODES];
+static rcu_head_t*   free_nodes;
+
+/// bio 在中断中释放，单独加锁
+static TicketLock bio_lock;
+static bio_t      pcache_bios[PCACHE_BIOS];
+static bio_t*     free_bios;
+static uint32_t   bio_waiters;
+
+/// CLOCK-Pro 的时钟，热页、冷页与非驻留页按访问顺序排列
+static IntrusiveList<page_t, &page_t::node> pcache_clock;
+static page_t*                              hand_hot;
+static page_t*                              hand_cold;
+static page_t*                              hand_test;
+static size_t                               nr_hot;
+static size_t                               nr_cold;
+static size_t                               nr_ghost;
+static size_t                               cold_target;
+
+/// 页的引用释放或写回完成时增加，没有可回收的页时在此等待
+static uint32_t reclaim_seq;
+static uint32_t reclaim_waiters;
+
+/// 参与后台写回的文件
+static Mutex                                                    mappings_lock;
+static IntrusiveList<pcache_mapping_t, &pcache_mapping_t::node> mappings;
+/// 定期写回与脏页过多时的写回
+static delayed_work_t                                           wb_dwork;
+static work_t                                                   wb_work;
+
+static pcache_cpu_stats_t pcache_stats[MAX_CPU_COUNT];
+
+static void stat_add(uint64_t* _ptr, uint64_t _val) {
+    __atomic_fetch_add(_ptr, _val, __ATOMIC_RELAXED);
+    return;
+}
+
+static pcache_cpu_stats_t* this_cpu_stats(void) {
+    return &pcache_stats[cpu_id()];
+}
+
+static uint32_t page_flags(const page_t* _page) {
+    return __atomic_load_n(&_page->flags, __ATOMIC_ACQUIRE);
+}
+
+static bool page_test(const page_t* _page, uint32_t _flag) {
+    return (page_flags(_page) & _flag) != 0;
+}
+
+static void page_set(page_t* _page, uint32_t _flag) {
+    __atomic_fetch_or(&_page->flags, _flag, __ATOMIC_RELEASE);
+    return;
+}
+
+static void page_clear(page_t* _page, uint32_t _flag) {
+    __atomic_fetch_and(&_page->flags, ~_flag, __ATOMIC_RELEASE);
+    return;
+}
+
+static bool page_test_and_clear(page_t* _page, uint32_t _flag) {
+    if (!page_test(_page, _flag)) {
+        return false;
+    }
+    return (__atomic_fetch_and(&_page->flags, ~_flag, __ATOMIC_ACQ_REL)
+            & _flag)
+           != 0;
+}
+
+/**
+ * @brief 引用计数不为 0 时加一，冻结的页返回 false
+ */
+static bool page_try_get(page_t* _page) {
+    auto ref = __atomic_load_n(&_page->refcount, __ATOMIC_RELAXED);
+    do {
+        if (ref == PAGE_FROZEN) {
+            return false;
+        }
+    } while (!__atomic_compare_exchange_n(&_page->refcount, &ref, ref + 1,
+                                          true, __ATOMIC_ACQUIRE,
+                                          __ATOMIC_RELAXED));
+    return true;
+}
+
+/**
+ * @brief 页可能变为可回收，唤醒等待内存的任务
+ */
+static void reclaim_wake(void) {
+    __atomic_fetch_add(&reclaim_seq, 1, __ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&reclaim_waiters, __ATOMIC_SEQ_CST) != 0) {
+        wake_up_all(&reclaim_seq);
+    }
+    return;
+}
+
+static uint64_t mapping_pages(const pcache_mapping_t* _mapping) {
+    return (_mapping->size + PCACHE_PAGE_SIZE - 1) >> PCACHE_PAGE_SHIFT;
+}
+
+/**
+ * @brief 分配节点，池中没有节点时返回 nullptr
+ */
+static pcache_node_t* node_alloc(uint32_t _shift) {
+    pcache_node_t* node;
+    {
+        IrqLockGuard<TicketLock> guard(node_lock);
+        if (free_nodes == nullptr) {
+            return nullptr;
+        }
+        node       = reinterpret_cast<pcache_node_t*>(free_nodes);
+        free_nodes = free_nodes->next;
+    }
+    memset(node->slots, 0, sizeof(node->slots));
+    node->dirty  = 0;
+    node->parent = nullptr;
+    node->offset = 0;
+    node->shift  = _shift;
+    node->count  = 0;
+    return node;
+}
+
+static void node_free_rcu(rcu_head_t* _head) {
+    IrqLockGuard<TicketLock> guard(node_lock);
+    _head->next = free_nodes;
+    free_nodes  = _head;
+    return;
+}
+
+/**
+ * @brief 释放节点，无锁的读者可能还在访问，宽限期后才能重用
+ */
+static void node_free(pcache_node_t* _node) {
+    call_rcu(&_node->rcu, node_free_rcu);
+    return;
+}
+
+/**
+ * @brief 查找页号对应的槽的内容，可以在 rcu 读端临界区中无锁调用
+ * @return page_t*                 页，可能是非驻留页
+ */
+static page_t* radix_lookup(pcache_mapping_t* _mapping, uint64_t _index) {
+    auto* node = rcu_dereference(_mapping->root);
+    if ((node == nullptr) || ((_index >> node->shift) >= RADIX_SLOTS)) {
+        return nullptr;
+    }
+    while (true) {
+        auto* slot = rcu_dereference(
+          node->slots[(_index >> node->shift) & RADIX_MASK]);
+        if ((slot == nullptr) || (node->shift == 0)) {
+            return static_cast<page_t*>(slot);
+        }
+        node = static_cast<pcache_node_t*>(slot);
+    }
+}
+
+/**
+ * @brief 最低层中包含 _index 的节点，需要持有 pcache_lock
+ */
+static pcache_node_t* radix_leaf(pcache_mapping_t* _mapping, uint64_t _index) {
+    auto* node = _mapping->root;
+    if ((node == nullptr) || ((_index >> node->shift) >= RADIX_SLOTS)) {
+        return nullptr;
+    }
+    while ((node != nullptr) && (node->shift != 0)) {
+        node = static_cast<pcache_node_t*>(
+          node->slots[(_index >> node->shift) & RADIX_MASK]);
+    }
+    return node;
+}
+
+/**
+ * @brief 从 _node 开始向上释放空节点
+ */
+static void radix_shrink(pcache_mapping_t* _mapping, pcache_node_t* _node) {
+    while ((_node != nullptr) && (_node->count == 0)) {
+        auto* parent = _node->parent;
+        if (parent != nullptr) {
+            rcu_assign_pointer(parent->slots[_node->offset],
+                               static_cast<void*>(nullptr));
+            parent->count--;
+        }
+        else {
+            rcu_assign_pointer(_mapping->root,
+                               static_cast<pcache_node_t*>(nullptr));
+        }
+        node_free(_node);
+        _node = parent;
+    }
+    return;
+}
+
+/**
+ * @brief 插入页，需要持有 pcache_lock，槽必须为空
+ * 新节点初始化后才发布，读者不会看到未初始化的节点
+ * @return true                    成功
+ * @return false                   没有空闲的节点
+ */
+static bool radix_insert(pcache_mapping_t* _mapping, uint64_t _index,
+                         page_t* _page) {
+    if (_mapping->root == nullptr) {
+        auto* root = node_alloc(0);
+        if (root == nullptr) {
+            return false;
+        }
+        rcu_assign_pointer(_mapping->root, root);
+    }
+    // 根覆盖不到 _index 时增加一层
+    while ((_index >> _mapping->root->shift) >= RADIX_SLOTS) {
+        auto* old  = _mapping->root;
+        auto* root = node_alloc(old->shift + RADIX_SHIFT);
+        if (root == nullptr) {
+            return false;
+        }
+        root->slots[0] = old;
+        root->count    = 1;
+        root->dirty    = old->dirty != 0 ? 1 : 0;
+        old->parent    = root;
+        old->offset    = 0;
+        rcu_assign_pointer(_mapping->root, root);
+    }
+    auto* node = _mapping->root;
+    while (node->shift != 0) {
+        auto  offset = (_index >> node->shift) & RADIX_MASK;
+        auto* child  = static_cast<pcache_node_t*>(node->slots[offset]);
+        if (child == nullptr) {
+            child = node_alloc(node->shift - RADIX_SHIFT);
+            if (child == nullptr) {
+                radix_shrink(_mapping, node);
+                return false;
+            }
+            child->parent = node;
+            child->offset = offset;
+            rcu_assign_pointer(node->slots[offset], static_cast<void*>(child));
+            node->count++;
+        }
+        node = child;
+    }
+    rcu_assign_pointer(node->slots[_index & RADIX_MASK],
+                       static_cast<void*>(_page));
+    node->count++;
+    return true;
+}
+
+/**
+ * @brief 设置 _index 的脏标记并向上传递，需要持有 pcache_lock
+ */
+static void radix_tag_set(pcache_mapping_t* _mapping, uint64_t _index) {
+    auto* node   = radix_leaf(_mapping, _index);
+    auto  offset = _index & RADIX_MASK;
+    while ((node != nullptr) && ((node->dirty & (1ULL << offset)) == 0)) {
+        node->dirty |= 1ULL << offset;
+        offset       = node->offset;
+        node         = node->parent;
+    }
+    return;
+}
+
+/**
+ * @brief 清除 _index 的脏标记，子树中没有脏页时向上传递
+ */
+static void radix_tag_clear(pcache_mapping_t* _mapping, uint64_t _index) {
+    auto* node   = radix_leaf(_mapping, _index);
+    auto  offset = _index & RADIX_MASK;
+    while (node != nullptr) {
+        node->dirty &= ~(1ULL << offset);
+        if (node->dirty != 0) {
+            break;
+        }
+        offset = node->offset;
+        node   = node->parent;
+    }
+    return;
+}
+
+/**
+ * @brief 删除页，需要持有 pcache_lock
+ */
+static void radix_delete(pcache_mapping_t* _mapping, uint64_t _index) {
+    radix_tag_clear(_mapping, _index);
+    auto* node = radix_leaf(_mapping, _index);
+    rcu_assign_pointer(node->slots[_index & RADIX_MASK],
+                       static_cast<void*>(nullptr));
+    node->count--;
+    radix_shrink(_mapping, node);
+    return;
+}
+
+/**
+ * @brief _node 的子树中页号不小于 _index 的第一个页
+ * @param  _dirty                  只查找脏页
+ */
+static page_t* radix_next(const pcache_node_t* _node, uint64_t _index,
+                          bool _dirty) {
+    auto     offset = (_index >> _node->shift) & RADIX_MASK;
+    uint64_t mask   = 0;
+    if (_dirty) {
+        mask = _node->dirty;
+    }
+    else {
+        for (size_t i = offset; i < RADIX_SLOTS; i++) {
+            mask |= _node->slots[i] != nullptr ? 1ULL << i : 0;
+        }
+    }
+    mask      &= ~0ULL << offset;
+    auto span  = 1ULL << _node->shift;
+    auto base  = _index & ~(span * RADIX_SLOTS - 1);
+    while (mask != 0) {
+        size_t slot  = __builtin_ctzll(mask);
+        mask        &= mask - 1;
+        if (_node->shift == 0) {
+            return static_cast<page_t*>(_node->slots[slot]);
+        }
+        // 后面的槽从子树的开头开始
+        auto  start = slot == offset ? _index : base + slot * span;
+        auto* page  = radix_next(
+          static_cast<const pcache_node_t*>(_node->slots[slot]), start, _dirty);
+        if (page != nullptr) {
+            return page;
+        }
+    }
+    return nullptr;
+}
+
+static page_t* mapping_next(pcache_mapping_t* _mapping, uint64_t _index,
+                            bool _dirty) {
+    auto* root = _mapping->root;
+    if ((root == nullptr) || ((_index >> root->shift) >= RADIX_SLOTS)) {
+        return nullptr;
+    }
+    return radix_next(root, _index, _dirty);
+}
+
+/**
+ * @brief 时钟上的下一个页，到末尾时回到开头
+ */
+static page_t* clock_next(page_t* _page) {
+    auto* next = pcache_clock.next(*_page);
+    return next != nullptr ? next : pcache_clock.front();
+}
+
+/**
+ * @brief 从时钟上取下页，指向它的指针前进一步
+ */
+static void clock_remove(page_t* _page) {
+    auto* next = pcache_clock.size() == 1 ? nullptr : clock_next(_page);
+    if (hand_hot == _page) {
+        hand_hot = next;
+    }
+    if (hand_cold == _page) {
+        hand_cold = next;
+    }
+    if (hand_test == _page) {
+        hand_test = next;
+    }
+    pcache_clock.erase(*_page);
+    return;
+}
+
+/**
+ * @brief 把页放到时钟的头部，即热页指针之前，三个指针都最晚到达
+ */
+static void clock_add_head(page_t* _page) {
+    if (hand_hot == nullptr) {
+        pcache_clock.push_back(*_page);
+        hand_hot  = _page;
+        hand_cold = _page;
+        hand_test = _page;
+    }
+    else {
+        pcache_clock.insert_before(*hand_hot, *_page);
+    }
+    return;
+}
+
+static void clock_move_head(page_t* _page) {
+    clock_remove(_page);
+    clock_add_head(_page);
+    return;
+}
+
+static void desc_free(page_t* _page) {
+    _page->mapping = nullptr;
+    _page->flags   = 0;
+    free_descs.push_back(*_page);
+    return;
+}
+
+/**
+ * @brief 删除非驻留页的记录
+ */
+static void ghost_remove(page_t* _page) {
+    radix_delete(_page->mapping, _page->index);
+    clock_remove(_page);
+    desc_free(_page);
+    nr_ghost--;
+    return;
+}
+
+/**
+ * @brief 冷页的测试期结束而没有被再次访问，减小冷页的目标数量
+ */
+static void test_expire(page_t* _page) {
+    page_clear(_page, PG_TEST);
+    if (cold_target > COLD_MIN) {
+        cold_target--;
+    }
+    if (page_test(_page, PG_GHOST)) {
+        ghost_remove(_page);
+    }
+    return;
+}
+
+/**
+ * @brief 热页指针: 把一个未被访问的热页降为冷页，
+ * 并结束经过的冷页的测试期
+ * @return true                    降级了一个热页
+ */
+static bool run_hand_hot(void) {
+    for (auto scan = 2 * pcache_clock.size();
+         (scan > 0) && (hand_hot != nullptr); scan--) {
+        auto* page = hand_hot;
+        hand_hot   = clock_next(page);
+        auto flags = page_flags(page);
+        if ((flags & PG_HOT) != 0) {
+            if (page_test_and_clear(page, PG_REFERENCED)) {
+                continue;
+            }
+            page_clear(page, PG_HOT);
+            nr_hot--;
+            nr_cold++;
+            stat_add(&this_cpu_stats()->demotions, 1);
+            return true;
+        }
+        if ((flags & PG_TEST) != 0) {
+            test_expire(page);
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief 测试指针: 结束经过的冷页的测试期，直到删除一个非驻留页
+ */
+static void run_hand_test(void) {
+    for (auto scan = pcache_clock.size(); (scan > 0) && (hand_test != nullptr);
+         scan--) {
+        auto* page  = hand_test;
+        hand_test   = clock_next(page);
+        auto  flags = page_flags(page);
+        if ((flags & (PG_HOT | PG_TEST)) != PG_TEST) {
+            continue;
+        }
+        test_expire(page);
+        if ((flags & PG_GHOST) != 0) {
+            return;
+        }
+    }
+    return;
+}
+
+/**
+ * @brief 回收冷页，测试期内的冷页留下非驻留的记录
+ * @return uint8_t*                页的数据
+ */
+static uint8_t* page_evict(page_t* _page, uint32_t _flags) {
+    auto* mapping = _page->mapping;
+    auto* data    = _page->data;
+    auto* stats   = this_cpu_stats();
+    stat_add(&stats->evictions, 1);
+    if ((_flags & PG_READAHEAD) != 0) {
+        // 预读的页没有用到就被回收，缩小这个文件的预读窗口
+        stat_add(&stats->ra_wasted, 1);
+        if (mapping->ra.size > RA_INIT) {
+            mapping->ra.size /= 2;
+        }
+    }
+    mapping->nr_pages--;
+    nr_cold--;
+    _page->data = nullptr;
+    if ((_flags & PG_TEST) != 0) {
+        // 保留在时钟上的原位置，引用计数保持冻结
+        __atomic_store_n(&_page->flags, PG_GHOST | PG_TEST, __ATOMIC_RELEASE);
+        nr_ghost++;
+        if (nr_ghost > PCACHE_PAGES) {
+            run_hand_test();
+        }
+    }
+    else {
+        radix_delete(mapping, _page->index);
+        clock_remove(_page);
+        desc_free(_page);
+    }
+    return data;
+}
+
+/**
+ * @brief 冷页指针: 找到一个可以回收的冷页并回收
+ * 被访问过的冷页在测试期内提升为热页，否则开始测试期
+ * @param  _dirty                  输出，遇到了不能回收的脏页
+ * @return uint8_t*                回收的页的数据，没有可回收的页时为 nullptr
+ */
+static uint8_t* run_hand_cold(bool* _dirty) {
+    for (auto scan = 2 * pcache_clock.size();
+         (scan > 0) && (hand_cold != nullptr); scan--) {
+        auto* page  = hand_cold;
+        hand_cold   = clock_next(page);
+        auto  flags = page_flags(page);
+        if ((flags & (PG_HOT | PG_GHOST)) != 0) {
+            continue;
+        }
+        if (page_test_and_clear(page, PG_REFERENCED)) {
+            if ((flags & PG_TEST) != 0) {
+                page_clear(page, PG_TEST);
+                page_set(page, PG_HOT);
+                nr_cold--;
+                nr_hot++;
+                stat_add(&this_cpu_stats()->promotions, 1);
+                clock_move_head(page);
+                while ((nr_hot > PCACHE_PAGES - cold_target)
+                       && run_hand_hot()) {
+                    ;
+                }
+            }
+            else {
+                page_set(page, PG_TEST);
+                clock_move_head(page);
+            }
+            continue;
+        }
+        if ((flags & PG_DIRTY) != 0) {
+            *_dirty = true;
+        }
+        if ((flags & (PG_LOCKED | PG_DIRTY | PG_WRITEBACK)) != 0) {
+            continue;
+        }
+        uint32_t ref = 0;
+        if (!__atomic_compare_exchange_n(&page->refcount, &ref, PAGE_FROZEN,
+                                         false, __ATOMIC_ACQUIRE,
+                                         __ATOMIC_RELAXED)) {
+            continue;
+        }
+        // 冻结前释放引用的使用者可能刚修改了标志
+        flags = page_flags(page);
+        if ((flags & (PG_LOCKED | PG_DIRTY | PG_WRITEBACK)) != 0) {
+            __atomic_store_n(&page->refcount, 0, __ATOMIC_RELEASE);
+            continue;
+        }
+        return page_evict(page, flags);
+    }
+    return nullptr;
+}
+
+/**
+ * @brief 创建页或取得已有的页，需要持有 pcache_lock
+ * 新页为测试期内的冷页；非驻留页被再次读入说明冷页太少，
+ * 增大冷页的目标数量并作为热页读入
+ * @param  _created                输出，是否新建，新建的页已锁定
+ * @param  _dirty                  输出，回收时遇到了脏页
+ * @return page_t*                 取得引用的页，没有内存时为 nullptr
+ */
+static page_t* page_add_locked(pcache_mapping_t* _mapping, uint64_t _index,
+                               bool* _created, bool* _dirty) {
+    auto* page = radix_lookup(_mapping, _index);
+    if ((page != nullptr) && !page_test(page, PG_GHOST)) {
+        *_created = false;
+        return page_try_get(page) ? page : nullptr;
+    }
+    uint8_t* data = nullptr;
+    if (nr_free_frames != 0) {
+        data = free_frames[--nr_free_frames];
+    }
+    else {
+        data = run_hand_cold(_dirty);
+    }
+    if (data == nullptr) {
+        return nullptr;
+    }
+    // 回收可能删除了非驻留的记录，重新查找
+    page = radix_lookup(_mapping, _index);
+    if (page != nullptr) {
+        stat_add(&this_cpu_stats()->refaults, 1);
+        if (cold_target < PCACHE_PAGES - COLD_MIN) {
+            cold_target++;
+        }
+        nr_ghost--;
+        nr_hot++;
+        __atomic_store_n(&page->flags, PG_HOT | PG_LOCKED, __ATOMIC_RELAXED);
+        clock_move_head(page);
+    }
+    else {
+        page = free_descs.pop_front();
+        page->mapping = _mapping;
+        page->index   = _index;
+        __atomic_store_n(&page->flags, PG_TEST | PG_LOCKED, __ATOMIC_RELAXED);
+        if (!radix_insert(_mapping, _index, page)) {
+            free_descs.push_front(*page);
+            free_frames[nr_free_frames++] = data;
+            return nullptr;
+        }
+        nr_cold++;
+        clock_add_head(page);
+    }
+    page->data       = data;
+    page->io_pending = 0;
+    _mapping->nr_pages++;
+    *_created        = true;
+    __atomic_store_n(&page->refcount, 1, __ATOMIC_RELEASE);
+    while ((nr_hot > PCACHE_PAGES - cold_target) && run_hand_hot()) {
+        ;
+    }
+    return page;
+}
+
+static void wb_kick(void) {
+    queue_work(&system_unbound_wq, &wb_work);
+    return;
+}
+
+/**
+ * @brief 创建页或取得已有的页
+ * @param  _wait                   没有可回收的页时是否等待
+ */
+static page_t* page_add(pcache_mapping_t* _mapping, uint64_t _index,
+                        bool* _created, bool _wait) {
+    while (true) {
+        auto  seq   = __atomic_load_n(&reclaim_seq, __ATOMIC_SEQ_CST);
+        bool  dirty = false;
+        page_t* page;
+        {
+            IrqLockGuard<TicketLock> guard(pcache_lock);
+            page = page_add_locked(_mapping, _index, _created, &dirty);
+        }
+        if (page != nullptr) {
+            return page;
+        }
+        if (dirty) {
+            wb_kick();
+        }
+        if (!_wait) {
+            return nullptr;
+        }
+        // 所有页都在使用中，等待引用释放或写回完成
+        blk_flush_plug();
+        __atomic_fetch_add(&reclaim_waiters, 1, __ATOMIC_SEQ_CST);
+        wait_event(&reclaim_seq, [seq] {
+            return __atomic_load_n(&reclaim_seq, __ATOMIC_SEQ_CST) != seq;
+        });
+        __atomic_fetch_sub(&reclaim_waiters, 1, __ATOMIC_RELAXED);
+    }
+}
+
+/**
+ * @brief 无锁查找驻留页并取得引用
+ */
+static page_t* page_lookup(pcache_mapping_t* _mapping, uint64_t _index) {
+    page_t* page;
+    rcu_read_lock();
+    while (true) {
+        page = radix_lookup(_mapping, _index);
+        if ((page == nullptr) || !page_try_get(page)) {
+            page = nullptr;
+            break;
+        }
+        // 描述符可能在查找与取得引用之间被回收并重用
+        if ((page->mapping == _mapping) && (page->index == _index)
+            && !page_test(page, PG_GHOST)) {
+            break;
+        }
+        page_put(page);
+    }
+    rcu_read_unlock();
+    if ((page != nullptr) && !page_test(page, PG_REFERENCED)) {
+        page_set(page, PG_REFERENCED);
+    }
+    return page;
+}
+
+static bio_t* bio_alloc(void) {
+    while (true) {
+        {
+            IrqLockGuard<TicketLock> guard(bio_lock);
+            auto*                    bio = free_bios;
+            if (bio != nullptr) {
+                free_bios = bio->next;
+                return bio;
+            }
+        }
+        // 暂存中的 bio 不会完成，先派发
+        blk_flush_plug();
+        __atomic_fetch_add(&bio_waiters, 1, __ATOMIC_SEQ_CST);
+        wait_event(&free_bios, [] {
+            return __atomic_load_n(&free_bios, __ATOMIC_SEQ_CST) != nullptr;
+        });
+        __atomic_fetch_sub(&bio_waiters, 1, __ATOMIC_RELAXED);
+    }
+}
+
+static void bio_free(bio_t* _bio) {
+    {
+        IrqLockGuard<TicketLock> guard(bio_lock);
+        _bio->next = free_bios;
+        __atomic_store_n(&free_bios, _bio, __ATOMIC_SEQ_CST);
+    }
+    if (__atomic_load_n(&bio_waiters, __ATOMIC_SEQ_CST) != 0) {
+        wake_up_all(&free_bios);
+    }
+    return;
+}
+
+/**
+ * @brief 读入完成，解锁页
+ */
+static void page_read_done(page_t* _page) {
+    if (!page_test(_page, PG_ERROR)) {
+        page_set(_page, PG_UPTODATE);
+    }
+    unlock_page(_page);
+    return;
+}
+
+/**
+ * @brief 写回完成，释放写回取得的引用
+ */
+static void page_write_done(page_t* _page) {
+    auto* mapping = _page->mapping;
+    page_clear(_page, PG_WRITEBACK);
+    wake_up_all(_page);
+    if (__atomic_sub_fetch(&mapping->nr_writeback, 1, __ATOMIC_ACQ_REL) == 0) {
+        wake_up_all(&mapping->nr_writeback);
+    }
+    page_put(_page);
+    reclaim_wake();
+    return;
+}
+
+static void page_read_end_io(bio_t* _bio) {
+    auto* page = static_cast<page_t*>(_bio->private_data);
+    if (_bio->status != BLK_STS_OK) {
+        stat_add(&this_cpu_stats()->io_errors, 1);
+        page_set(page, PG_ERROR);
+    }
+    bio_free(_bio);
+    if (__atomic_sub_fetch(&page->io_pending, 1, __ATOMIC_ACQ_REL) == 0) {
+        page_read_done(page);
+    }
+    return;
+}
+
+static void page_write_end_io(bio_t* _bio) {
+    auto* page = static_cast<page_t*>(_bio->private_data);
+    if (_bio->status != BLK_STS_OK) {
+        stat_add(&this_cpu_stats()->io_errors, 1);
+        __atomic_store_n(&page->mapping->wb_error, _bio->status,
+                         __ATOMIC_RELAXED);
+    }
+    bio_free(_bio);
+    if (__atomic_sub_fetch(&page->io_pending, 1, __ATOMIC_ACQ_REL) == 0) {
+        page_write_done(page);
+    }
+    return;
+}
+
+/**
+ * @brief 提交页的 io，页在设备上不连续时拆成多个 bio
+ * 读时文件末尾之后的部分填 0，写时不写
+ * @param  _op                     BLK_OP_READ 或 BLK_OP_WRITE
+ */
+static void page_submit_io(page_t* _page, uint32_t _op) {
+    auto* mapping = _page->mapping;
+    auto* bdev    = mapping->bdev;
+    auto  block   = bdev->block_size > SECTOR_SIZE ? bdev->block_size
+                                                   : SECTOR_SIZE;
+    // 文件末尾按逻辑块向上取整
+    auto  limit   = (mapping->size + block - 1) / block * block >> SECTOR_SHIFT;
+    auto  first   = _page->index * PCACHE_PAGE_SECTORS;
+    auto  end     = first + PCACHE_PAGE_SECTORS < limit
+                      ? first + PCACHE_PAGE_SECTORS
+                      : limit;
+    auto  end_io  = _op == BLK_OP_READ ? page_read_end_io : page_write_end_io;
+    if ((_op == BLK_OP_READ) && (end < first + PCACHE_PAGE_SECTORS)) {
+        auto valid = end > first ? end - first : 0;
+        memset(_page->data + (valid << SECTOR_SHIFT), 0,
+               (PCACHE_PAGE_SECTORS - valid) << SECTOR_SHIFT);
+    }
+    // 提交期间多持有一次，bio 全部完成前不会结束
+    __atomic_store_n(&_page->io_pending, 1, __ATOMIC_RELAXED);
+    for (auto sector = first; sector < end;) {
+        uint64_t disk  = sector;
+        uint32_t count = static_cast<uint32_t>(end - sector);
+        if (mapping->ops != nullptr) {
+            auto status = mapping->ops->map(mapping, sector, &disk, &count);
+            if ((status != BLK_STS_OK) || (count == 0)) {
+                page_set(_page, PG_ERROR);
+                if (_op == BLK_OP_WRITE) {
+                    __atomic_store_n(&mapping->wb_error, BLK_STS_IOERR,
+                                     __ATOMIC_RELAXED);
+                }
+                break;
+            }
+        }
+        uint32_t nr       = end - sector < count ? end - sector : count;
+        nr                = nr < bdev->max_sectors ? nr : bdev->max_sectors;
+        auto*    bio      = bio_alloc();
+        bio->bdev         = bdev;
+        bio->op           = _op;
+        bio->sector       = disk;
+        bio->nr_sectors   = nr;
+        bio->buffer       = _page->data + ((sector - first) << SECTOR_SHIFT);
+        bio->end_io       = end_io;
+        bio->private_data = _page;
+        __atomic_fetch_add(&_page->io_pending, 1, __ATOMIC_RELAXED);
+        submit_bio(bio);
+        sector += nr;
+    }
+    if (__atomic_sub_fetch(&_page->io_pending, 1, __ATOMIC_ACQ_REL) == 0) {
+        if (_op == BLK_OP_READ) {
+            page_read_done(_page);
+        }
+        else {
+            page_write_done(_page);
+        }
+    }
+    return;
+}
+
+/**
+ * @brief 读入预读窗口 [_start, _start + _size) 中不在缓存中的页
+ * 第 _size - _async 页设置预读标记，窗口不超过文件末尾
+ * @param  _demand                 需要返回的页号，没有时为 UINT64_MAX
+ * @return page_t*                 _demand 对应的页，已取得引用
+ */
+static page_t* ra_submit(pcache_mapping_t* _mapping, uint64_t _start,
+                         uint32_t _size, uint32_t _async, uint64_t _demand) {
+    auto    pages  = mapping_pages(_mapping);
+    auto    end    = _start + _size;
+    auto    limit  = _demand != UINT64_MAX && _demand >= pages ? _demand + 1
+                                                               : pages;
+    page_t* result = nullptr;
+    auto*   stats  = this_cpu_stats();
+    end            = end < limit ? end : limit;
+    blk_plug_t plug;
+    blk_start_plug(&plug);
+    for (auto index = _start; index < end; index++) {
+        bool  created;
+        bool  demand = index == _demand;
+        auto* page   = page_add(_mapping, index, &created, demand);
+        if (page == nullptr) {
+            // 没有空闲的页，放弃剩余的预读
+            if (demand) {
+                continue;
+            }
+            break;
+        }
+        if (created) {
+            if (!demand) {
+                page_set(page, PG_READAHEAD);
+                stat_add(&stats->ra_pages, 1);
+            }
+            if ((_async != 0) && (index == _start + _size - _async)) {
+                page_set(page, PG_RA_MARK);
+            }
+            page_submit_io(page, BLK_OP_READ);
+        }
+        if (demand) {
+            result = page;
+        }
+        else {
+            page_put(page);
+        }
+    }
+    blk_finish_plug(&plug);
+    return result;
+}
+
+/**
+ * @brief 同步预读，_index 不在缓存中时调用
+ * 紧接着上一次访问或上一个窗口时认为是顺序访问，窗口加倍，
+ * 否则只读入 _index
+ */
+static page_t* ra_sync(pcache_mapping_t* _mapping, uint64_t _index) {
+    uint64_t start;
+    uint32_t size;
+    uint32_t async;
+    {
+        IrqLockGuard<TicketLock> guard(pcache_lock);
+        auto*                    ra = &_mapping->ra;
+        if ((_index == 0) || (_index == ra->prev_index + 1)
+            || ((ra->size != 0) && (_index == ra->start + ra->size))) {
+            size  = ra->size > 1 ? ra->size * 2 : RA_INIT;
+            size  = size < RA_MAX ? size : RA_MAX;
+            async = size - 1;
+        }
+        else {
+            size  = 1;
+            async = 0;
+        }
+        start          = _index;
+        ra->start      = start;
+        ra->size       = size;
+        ra->async_size = async;
+        ra->prev_index = _index;
+    }
+    stat_add(&this_cpu_stats()->ra_sync, 1);
+    return ra_submit(_mapping, start, size, async, _index);
+}
+
+/**
+ * @brief 异步预读，访问到有预读标记的页时调用，读入下一个窗口
+ */
+static void ra_async(pcache_mapping_t* _mapping, uint64_t _index) {
+    uint64_t start;
+    uint32_t size;
+    {
+        IrqLockGuard<TicketLock> guard(pcache_lock);
+        auto*                    ra = &_mapping->ra;
+        start = ra->start + ra->size;
+        // 标记属于已经被替换的窗口时从当前页之后开始
+        if ((_index < ra->start) || (_index >= start)) {
+            start = _index + 1;
+        }
+        size           = ra->size * 2 < RA_MAX ? ra->size * 2 : RA_MAX;
+        size           = size > RA_INIT ? size : RA_INIT;
+        ra->start      = start;
+        ra->size       = size;
+        ra->async_size = size;
+    }
+    stat_add(&this_cpu_stats()->ra_async, 1);
+    ra_submit(_mapping, start, size, size, UINT64_MAX);
+    return;
+}
+
+/**
+ * @brief 等待页解锁，持有者可能在等待暂存中的 io
+ */
+static void page_wait_locked(page_t* _page) {
+    if (page_test(_page, PG_LOCKED)) {
+        blk_flush_plug();
+        wait_event(_page, [_page] { return !page_test(_page, PG_LOCKED); });
+    }
+    return;
+}
+
+/**
+ * @brief 等待页读入完成，失败时重新读入一次
+ */
+static bool page_wait_uptodate(page_t* _page) {
+    page_wait_locked(_page);
+    if (page_test(_page, PG_UPTODATE)) {
+        return true;
+    }
+    lock_page(_page);
+    if (page_test(_page, PG_UPTODATE)) {
+        unlock_page(_page);
+        return true;
+    }
+    page_clear(_page, PG_ERROR);
+    page_submit_io(_page, BLK_OP_READ);
+    page_wait_locked(_page);
+    return page_test(_page, PG_UPTODATE);
+}
+
+void pcache_init(void) {
+    for (size_t i = 0; i < PCACHE_PAGES; i++) {
+        free_frames[i] = pcache_frames[i];
+    }
+    nr_free_frames = PCACHE_PAGES;
+    for (auto& page : pcache_descs) {
+        page.refcount = PAGE_FROZEN;
+        free_descs.push_back(page);
+    }
+    for (auto& node : pcache_nodes) {
+        node.rcu.next = free_nodes;
+        free_nodes    = &node.rcu;
+    }
+    for (auto& bio : pcache_bios) {
+        bio.next  = free_bios;
+        free_bios = &bio;
+    }
+    cold_target = COLD_INIT;
+    work_init(&wb_work, [](work_t* _work) {
+        (void)_work;
+        pcache_sync();
+        return;
+    });
+    delayed_work_init(&wb_dwork, [](work_t* _work) {
+        (void)_work;
+        pcache_sync();
+        // 还有脏页时继续定期写回
+        if (__atomic_load_n(&nr_dirty, __ATOMIC_RELAXED) != 0) {
+            queue_delayed_work(&system_unbound_wq, &wb_dwork, WB_INTERVAL);
+        }
+        return;
+    });
+    return;
+}
+
+void pcache_mapping_init(pcache_mapping_t* _mapping, blk_dev_t* _bdev,
+                         const pcache_mapping_ops_t* _ops, uint64_t _size) {
+    _mapping->bdev         = _bdev;
+    _mapping->ops          = _ops;
+    _mapping->size         = _size;
+    _mapping->root         = nullptr;
+    _mapping->nr_pages     = 0;
+    _mapping->nr_dirty     = 0;
+    _mapping->ra           = { 0, 0, 0, UINT64_MAX };
+    _mapping->nr_writeback = 0;
+    _mapping->wb_error     = BLK_STS_OK;
+    new (&_mapping->wb_lock) Mutex();
+    LockGuard<Mutex> guard(mappings_lock);
+    mappings.push_back(*_mapping);
+    return;
+}
+
+int32_t pcache_mapping_destroy(pcache_mapping_t* _mapping) {
+    {
+        LockGuard<Mutex> guard(mappings_lock);
+        mappings.erase(*_mapping);
+    }
+    auto     status = pcache_writeback(_mapping);
+    uint64_t index  = 0;
+    while (true) {
+        page_t* page;
+        {
+            IrqLockGuard<TicketLock> guard(pcache_lock);
+            page = mapping_next(_mapping, index, false);
+            if (page == nullptr) {
+                break;
+            }
+            auto flags = page_flags(page);
+            index      = page->index;
+            if ((flags & PG_GHOST) != 0) {
+                ghost_remove(page);
+                continue;
+            }
+            // 预读的 io 还没有完成时等待，完成后再删除
+            if ((flags & PG_LOCKED) == 0) {
+                if ((flags & PG_DIRTY) != 0) {
+                    _mapping->nr_dirty--;
+                    nr_dirty--;
+                }
+                if ((flags & PG_HOT) != 0) {
+                    nr_hot--;
+                }
+                else {
+                    nr_cold--;
+                }
+                free_frames[nr_free_frames++] = page->data;
+                page->data                    = nullptr;
+                page->refcount                = PAGE_FROZEN;
+                _mapping->nr_pages--;
+                radix_delete(_mapping, index);
+                clock_remove(page);
+                desc_free(page);
+                continue;
+            }
+        }
+        page_wait_locked(page);
+    }
+    return status;
+}
+
+page_t* pcache_find(pcache_mapping_t* _mapping, uint64_t _index) {
+    return page_lookup(_mapping, _index);
+}
+
+page_t* pcache_read_page(pcache_mapping_t* _mapping, uint64_t _index) {
+    auto* stats = this_cpu_stats();
+    auto* page  = page_lookup(_mapping, _index);
+    if (page != nullptr) {
+        stat_add(&stats->hits, 1);
+        if (page_test_and_clear(page, PG_READAHEAD)) {
+            // 预读的页第一次被访问相当于读入，不是重用
+            page_clear(page, PG_REFERENCED);
+            stat_add(&stats->ra_hits, 1);
+        }
+        if (page_test_and_clear(page, PG_RA_MARK)) {
+            ra_async(_mapping, _index);
+        }
+        __atomic_store_n(&_mapping->ra.prev_index, _index, __ATOMIC_RELAXED);
+    }
+    else {
+        stat_add(&stats->misses, 1);
+        page = ra_sync(_mapping, _index);
+        if (page == nullptr) {
+            return nullptr;
+        }
+    }
+    if (!page_test(page, PG_UPTODATE) && !page_wait_uptodate(page)) {
+        page_put(page);
+        return nullptr;
+    }
+    return page;
+}
+
+page_t* pcache_grab_page(pcache_mapping_t* _mapping, uint64_t _index) {
+    auto* page = page_lookup(_mapping, _index);
+    if (page != nullptr) {
+        stat_add(&this_cpu_stats()->hits, 1);
+        page_clear(page, PG_READAHEAD);
+        lock_page(page);
+        return page;
+    }
+    stat_add(&this_cpu_stats()->misses, 1);
+    bool created;
+    page = page_add(_mapping, _index, &created, true);
+    if (page == nullptr) {
+        return nullptr;
+    }
+    if (created) {
+        memset(page->data, 0, PCACHE_PAGE_SIZE);
+    }
+    else {
+        lock_page(page);
+    }
+    return page;
+}
+
+void page_put(page_t* _page) {
+    if (__atomic_sub_fetch(&_page->refcount, 1, __ATOMIC_RELEASE) == 0) {
+        reclaim_wake();
+    }
+    return;
+}
+
+void lock_page(page_t* _page) {
+    while ((__atomic_fetch_or(&_page->flags, PG_LOCKED, __ATOMIC_ACQUIRE)
+            & PG_LOCKED)
+           != 0) {
+        // 持有者可能在等待暂存中的 io
+        blk_flush_plug();
+        wait_event(_page, [_page] { return !page_test(_page, PG_LOCKED); });
+    }
+    return;
+}
+
+void unlock_page(page_t* _page) {
+    page_clear(_page, PG_LOCKED);
+    wake_up_all(_page);
+    // 锁定的页不能回收，读入完成的页可能是等待内存的任务要找的
+    reclaim_wake();
+    return;
+}
+
+void page_mark_dirty(page_t* _page) {
+    if (page_test(_page, PG_DIRTY)) {
+        return;
+    }
+    size_t dirty;
+    {
+        IrqLockGuard<TicketLock> guard(pcache_lock);
+        if (page_test(_page, PG_DIRTY)) {
+            return;
+        }
+        page_set(_page, PG_DIRTY);
+        radix_tag_set(_page->mapping, _page->index);
+        _page->mapping->nr_dirty++;
+        dirty = ++nr_dirty;
+    }
+    if (dirty == 1) {
+        queue_delayed_work(&system_unbound_wq, &wb_dwork, WB_INTERVAL);
+    }
+    else if (dirty == DIRTY_LIMIT) {
+        wb_kick();
+    }
+    return;
+}
+
+size_t pcache_read(pcache_mapping_t* _mapping, uint64_t _offset, void* _buf,
+                   size_t _len) {
+    if (_offset >= _mapping->size) {
+        return 0;
+    }
+    _len        = _len < _mapping->size - _offset ? _len
+                                                  : _mapping->size - _offset;
+    size_t done = 0;
+    while (done < _len) {
+        auto   pos  = _offset + done;
+        auto   off  = pos & (PCACHE_PAGE_SIZE - 1);
+        size_t n    = PCACHE_PAGE_SIZE - off;
+        n           = n < _len - done ? n : _len - done;
+        auto*  page = pcache_read_page(_mapping, pos >> PCACHE_PAGE_SHIFT);
+        if (page == nullptr) {
+            break;
+        }
+        memcpy(static_cast<uint8_t*>(_buf) + done, page->data + off, n);
+        page_put(page);
+        done += n;
+    }
+    return done;
+}
+
+size_t pcache_write(pcache_mapping_t* _mapping, uint64_t _offset,
+                    const void* _buf, size_t _len) {
+    if (_offset >= _mapping->size) {
+        return 0;
+    }
+    _len        = _len < _mapping->size - _offset ? _len
+                                                  : _mapping->size - _offset;
+    size_t done = 0;
+    while (done < _len) {
+        auto    pos   = _offset + done;
+        auto    index = pos >> PCACHE_PAGE_SHIFT;
+        auto    off   = pos & (PCACHE_PAGE_SIZE - 1);
+        size_t  n     = PCACHE_PAGE_SIZE - off;
+        n             = n < _len - done ? n : _len - done;
+        page_t* page;
+        // 整页覆盖时不需要读入
+        if (n == PCACHE_PAGE_SIZE) {
+            page = pcache_grab_page(_mapping, index);
+        }
+        else {
+            page = pcache_read_page(_mapping, index);
+            if (page != nullptr) {
+                lock_page(page);
+            }
+        }
+        if (page == nullptr) {
+            break;
+        }
+        // 写回中的页等待完成，设备看到的数据保持稳定
+        if (page_test(page, PG_WRITEBACK)) {
+            blk_flush_plug();
+            wait_event(page, [page] { return !page_test(page, PG_WRITEBACK); });
+        }
+        memcpy(page->data + off, static_cast<const uint8_t*>(_buf) + done, n);
+        page_clear(page, PG_ERROR);
+        page_set(page, PG_UPTODATE);
+        page_mark_dirty(page);
+        unlock_page(page);
+        page_put(page);
+        done += n;
+    }
+    return done;
+}
+
+int32_t pcache_writeback(pcache_mapping_t* _mapping) {
+    LockGuard<Mutex> wb_guard(_mapping->wb_lock);
+    auto*            stats = this_cpu_stats();
+    uint64_t         index = 0;
+    uint64_t         next  = UINT64_MAX;
+    __atomic_store_n(&_mapping->wb_error, BLK_STS_OK, __ATOMIC_RELAXED);
+    // 按页号顺序提交，文件内相邻且设备上连续的页由块层合并
+    blk_plug_t plug;
+    blk_start_plug(&plug);
+    while (true) {
+        page_t* batch[WB_BATCH];
+        size_t  count = 0;
+        {
+            IrqLockGuard<TicketLock> guard(pcache_lock);
+            while (count < WB_BATCH) {
+                auto* page = mapping_next(_mapping, index, true);
+                if (page == nullptr) {
+                    break;
+                }
+                index = page->index + 1;
+                if (page_try_get(page)) {
+                    batch[count++] = page;
+                }
+            }
+        }
+        if (count == 0) {
+            break;
+        }
+        for (size_t i = 0; i < count; i++) {
+            auto* page  = batch[i];
+            bool  dirty = false;
+            lock_page(page);
+            {
+                IrqLockGuard<TicketLock> guard(pcache_lock);
+                if (page_test_and_clear(page, PG_DIRTY)) {
+                    radix_tag_clear(_mapping, page->index);
+                    _mapping->nr_dirty--;
+                    nr_dirty--;
+                    dirty = true;
+                }
+            }
+            if (!dirty) {
+                unlock_page(page);
+                page_put(page);
+                continue;
+            }
+            page_set(page, PG_WRITEBACK);
+            __atomic_fetch_add(&_mapping->nr_writeback, 1, __ATOMIC_RELAXED);
+            unlock_page(page);
+            if (page->index != next) {
+                stat_add(&stats->wb_clusters, 1);
+            }
+            next = page->index + 1;
+            stat_add(&stats->wb_pages, 1);
+            // 引用在写回完成时释放
+            page_submit_io(page, BLK_OP_WRITE);
+        }
+    }
+    blk_finish_plug(&plug);
+    wait_event(&_mapping->nr_writeback, [_mapping] {
+        return __atomic_load_n(&_mapping->nr_writeback, __ATOMIC_ACQUIRE) == 0;
+    });
+    return __atomic_load_n(&_mapping->wb_error, __ATOMIC_RELAXED);
+}
+
+int32_t pcache_sync(void) {
+    int32_t          status = BLK_STS_OK;
+    LockGuard<Mutex> guard(mappings_lock);
+    for (auto& mapping : mappings) {
+        auto ret = pcache_writeback(&mapping);
+        if (ret != BLK_STS_OK) {
+            status = ret;
+        }
+    }
+    return status;
+}
+
+void pcache_get_stats(pcache_stats_t* _stats) {
+    memset(_stats, 0, sizeof(*_stats));
+    for (auto& cpu : pcache_stats) {
+        _stats->hits        += __atomic_load_n(&cpu.hits, __ATOMIC_RELAXED);
+        _stats->misses      += __atomic_load_n(&cpu.misses, __ATOMIC_RELAXED);
+        _stats->ra_pages    += __atomic_load_n(&cpu.ra_pages, __ATOMIC_RELAXED);
+        _stats->ra_hits     += __atomic_load_n(&cpu.ra_hits, __ATOMIC_RELAXED);
+        _stats->ra_wasted   += __atomic_load_n(&cpu.ra_wasted,
+                                               __ATOMIC_RELAXED);
+        _stats->ra_sync     += __atomic_load_n(&cpu.ra_sync, __ATOMIC_RELAXED);
+        _stats->ra_async    += __atomic_load_n(&cpu.ra_async, __ATOMIC_RELAXED);
+        _stats->evictions   += __atomic_load_n(&cpu.evictions,
+                                               __ATOMIC_RELAXED);
+        _stats->refaults    += __atomic_load_n(&cpu.refaults, __ATOMIC_RELAXED);
+        _stats->promotions  += __atomic_load_n(&cpu.promotions,
+                                               __ATOMIC_RELAXED);
+        _stats->demotions   += __atomic_load_n(&cpu.demotions,
+                                               __ATOMIC_RELAXED);
+        _stats->wb_pages    += __atomic_load_n(&cpu.wb_pages, __ATOMIC_RELAXED);
+        _stats->wb_clusters += __atomic_load_n(&cpu.wb_clusters,
+                                               __ATOMIC_RELAXED);
+        _stats->io_errors   += __atomic_load_n(&cpu.io_errors,
+                                               __ATOMIC_RELAXED);
+    }
+    if (_stats->hits + _stats->misses != 0) {
+        _stats->hit_ratio = _stats->hits * 1000
+                            / (_stats->hits + _stats->misses);
+    }
+    if (_stats->ra_pages != 0) {
+        _stats->ra_ratio = _stats->ra_hits * 1000 / _stats->ra_pages;
+    }
+    IrqLockGuard<TicketLock> guard(pcache_lock);
+    _stats->nr_hot      = nr_hot;
+    _stats->nr_cold     = nr_cold;
+    _stats->nr_ghost    = nr_ghost;
+    _stats->cold_target = cold_target;
+    _stats->nr_free     = nr_free_frames;
+    _stats->nr_dirty    = nr_dirty;
+    return;
+}
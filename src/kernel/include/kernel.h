@@ -25,6 +25,11 @@
  * @param  _argv                   参数列表
  * @return int                     正常返回 0
  */
-int main(int _argc, char** _argv);
+int  main(int _argc, char** _argv);
+
+/**
+ * @brief 非启动 cpu 的入口，在 cpu 完成架构相关初始化后调用
+ */
+void secondary_main(void);
 
 #endif /* CMAKE_KERNEL_KERNEL_H */
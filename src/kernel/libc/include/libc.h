@@ -21,6 +21,7 @@
 extern "C" {
 #endif
 
+#include "stddef.h"
 #include "stdint.h"
 
 /**
@@ -31,6 +32,66 @@ extern "C" {
  */
 int32_t libc(uint32_t _argc, uint8_t** _argv);
 
+/**
+ * @brief 拷贝内存，区域不能重叠
+ * @param  _dst                    目标地址
+ * @param  _src                    源地址
+ * @param  _n                      字节数
+ * @return void*                   _dst
+ */
+void*   memcpy(void* _dst, const void* _src, size_t _n);
+
+/**
+ * @brief 拷贝内存，区域可以重叠
+ * @param  _dst                    目标地址
+ * @param  _src                    源地址
+ * @param  _n                      字节数
+ * @return void*                   _dst
+ */
+void*   memmove(void* _dst, const void* _src, size_t _n);
+
+/**
+ * @brief 填充内存
+ * @param  _dst                    目标地址
+ * @param  _val                    填充值，只使用低 8 位
+ * @param  _n                      字节数
+ * @return void*                   _dst
+ */
+void*   memset(void* _dst, int _val, size_t _n);
+
+/**
+ * @brief 比较内存
+ * @param  _lhs                    地址 1
+ * @param  _rhs                    地址 2
+ * @param  _n                      字节数
+ * @return int                     相等返回 0
+ */
+int     memcmp(const void* _lhs, const void* _rhs, size_t _n);
+
+/**
+ * @brief 字符串长度
+ * @param  _str                    字符串
+ * @return size_t                  不包括结尾的 '\0'
+ */
+size_t  strlen(const char* _str);
+
+/**
+ * @brief 比较字符串
+ * @param  _lhs                    字符串 1
+ * @param  _rhs                    字符串 2
+ * @return int                     相等返回 0
+ */
+int     strcmp(const char* _lhs, const char* _rhs);
+
+/**
+ * @brief 比较字符串的前 _n 个字符
+ * @param  _lhs                    字符串 1
+ * @param  _rhs                    字符串 2
+ * @param  _n                      最多比较的字符数
+ * @return int                     相等返回 0
+ */
+int     strncmp(const char* _lhs, const char* _rhs, size_t _n);
+
 #ifdef __cplusplus
 }
 #endif
@@ -24,11 +24,6 @@ int32_t libc(uint32_t _argc, uint8_t** _argv) {
     (void)_argc;
     (void)_argv;
 
-    // 进入死循环
-    while (1) {
-        ;
-    }
-
     return 0;
 }
 
@@ -0,0 +1,121 @@
+
+/**
+ * @file string.c
+ * @brief 内存操作函数
+ * @author Zone.N (Zone.Niuzh@hotmail.com)
+ * @version 1.0
+ * @date 2026-10-18
+ * @copyright MIT LICENSE
+ * https://github.com/MRNIU/cmake-kernel
+ * @par change log:
+ * <table>
+ * <tr><th>Date<th>Author<th>Description
+ * <tr><td>2026-10-18<td>Zone.N (Zone.Niuzh@hotmail.com)<td>创建文件
+ * </table>
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "libc.h"
+
+/// 按字长拷贝时使用的类型，may_alias 避免违反严格别名规则
+typedef uint64_t __attribute__((may_alias)) word_t;
+
+void* memcpy(void* _dst, const void* _src, size_t _n) {
+    uint8_t*       dst = (uint8_t*)_dst;
+    const uint8_t* src = (const uint8_t*)_src;
+    // 两者对齐方式相同时按 8 字节拷贝
+    if ((((uintptr_t)dst ^ (uintptr_t)src) & (sizeof(word_t) - 1)) == 0) {
+        while ((_n > 0) && (((uintptr_t)dst & (sizeof(word_t) - 1)) != 0)) {
+            *dst++ = *src++;
+            _n--;
+        }
+        while (_n >= sizeof(word_t)) {
+            *(word_t*)dst  = *(const word_t*)src;
+            dst           += sizeof(word_t);
+            src           += sizeof(word_t);
+            _n            -= sizeof(word_t);
+        }
+    }
+    while (_n > 0) {
+        *dst++ = *src++;
+        _n--;
+    }
+    return _dst;
+}
+
+void* memmove(void* _dst, const void* _src, size_t _n) {
+    uint8_t*       dst = (uint8_t*)_dst;
+    const uint8_t* src = (const uint8_t*)_src;
+    if ((dst <= src) || (dst >= src + _n)) {
+        return memcpy(_dst, _src, _n);
+    }
+    // 区域重叠且目标在后，从尾部开始拷贝
+    while (_n > 0) {
+        _n--;
+        dst[_n] = src[_n];
+    }
+    return _dst;
+}
+
+void* memset(void* _dst, int _val, size_t _n) {
+    uint8_t* dst  = (uint8_t*)_dst;
+    uint8_t  val  = (uint8_t)_val;
+    word_t   word = 0x0101010101010101ULL * val;
+    while ((_n > 0) && (((uintptr_t)dst & (sizeof(word_t) - 1)) != 0)) {
+        *dst++ = val;
+        _n--;
+    }
+    while (_n >= sizeof(word_t)) {
+        *(word_t*)dst  = word;
+        dst           += sizeof(word_t);
+        _n            -= sizeof(word_t);
+    }
+    while (_n > 0) {
+        *dst++ = val;
+        _n--;
+    }
+    return _dst;
+}
+
+int memcmp(const void* _lhs, const void* _rhs, size_t _n) {
+    const uint8_t* lhs = (const uint8_t*)_lhs;
+    const uint8_t* rhs = (const uint8_t*)_rhs;
+    for (size_t i = 0; i < _n; i++) {
+        if (lhs[i] != rhs[i]) {
+            return lhs[i] - rhs[i];
+        }
+    }
+    return 0;
+}
+
+size_t strlen(const char* _str) {
+    size_t len = 0;
+    while (_str[len] != '\0') {
+        len++;
+    }
+    return len;
+}
+
+int strcmp(const char* _lhs, const char* _rhs) {
+    while ((*_lhs != '\0') && (*_lhs == *_rhs)) {
+        _lhs++;
+        _rhs++;
+    }
+    return (uint8_t)*_lhs - (uint8_t)*_rhs;
+}
+
+int strncmp(const char* _lhs, const char* _rhs, size_t _n) {
+    for (size_t i = 0; i < _n; i++) {
+        if ((_lhs[i] != _rhs[i]) || (_lhs[i] == '\0')) {
+            return (uint8_t)_lhs[i] - (uint8_t)_rhs[i];
+        }
+    }
+    return 0;
+}
+
+#ifdef __cplusplus
+}
+#endif
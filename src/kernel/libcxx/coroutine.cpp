@@ -0,0 +1,143 @@
+
+/**
+ * @file coroutine.cpp
+ * @brief 协程帧内存池
+ * @author Zone.N (Zone.Niuzh@hotmail.com)
+ * @version 1.0
+ * @date 2026-10-18
+ * @copyright MIT LICENSE
+ * https://github.com/MRNIU/cmake-kernel
+ * @par change log:
+ * <table>
+ * <tr><th>Date<th>Author<th>Description
+ * <tr><td>2026-10-18<td>Zone.N (Zone.Niuzh@hotmail.com)<td>创建文件
+ * </table>
+ */
+
+#include "libcxx.h"
+#include "spinlock.hpp"
+#include "task.hpp"
+
+// 协程帧按大小分为几级，每级是一组固定大小的块，用位图记录占用。
+// 分配只在对应的级别中查找第一个空闲位，释放按地址算出下标，
+// 不需要初始化，也不会产生碎片。帧大于最大的级别时分配失败
+
+/// 级数
+static constexpr const size_t CORO_FRAME_CLASSES = 4;
+/// 各级的块大小
+static constexpr const size_t coro_frame_sizes[CORO_FRAME_CLASSES]
+  = { 256, 512, 1024, 2048 };
+/// 各级的块数，需要是 64 的倍数
+static constexpr const size_t coro_frame_counts[CORO_FRAME_CLASSES]
+  = { 128, 64, 64, 64 };
+
+/**
+ * @brief 一级帧
+ * @tparam Size                    块大小
+ * @tparam Count                   块数
+ */
+template <size_t Size, size_t Count>
+struct CoroFrameClass {
+    static_assert(Count % 64 == 0, "Count must be a multiple of 64");
+
+    alignas(CACHE_LINE_SIZE) uint8_t blocks[Count][Size];
+    uint64_t used[Count / 64];
+
+    void* alloc(void) {
+        for (size_t i = 0; i < Count / 64; i++) {
+            if (~used[i] != 0) {
+                auto bit  = static_cast<size_t>(__builtin_ctzll(~used[i]));
+                used[i]  |= static_cast<uint64_t>(1) << bit;
+                return blocks[i * 64 + bit];
+            }
+        }
+        return nullptr;
+    }
+
+    bool free(void* _ptr) {
+        auto offset = static_cast<uint8_t*>(_ptr) - &blocks[0][0];
+        if ((offset < 0) || (static_cast<size_t>(offset) >= sizeof(blocks))) {
+            return false;
+        }
+        auto idx      = static_cast<size_t>(offset) / Size;
+        used[idx / 64] &= ~(static_cast<uint64_t>(1) << (idx % 64));
+        return true;
+    }
+};
+
+static CoroFrameClass<coro_frame_sizes[0], coro_frame_counts[0]> frames_0;
+static CoroFrameClass<coro_frame_sizes[1], coro_frame_counts[1]> frames_1;
+static CoroFrameClass<coro_frame_sizes[2], coro_frame_counts[2]> frames_2;
+static CoroFrameClass<coro_frame_sizes[3], coro_frame_counts[3]> frames_3;
+
+/// 保护各级的位图与统计
+static TicketLock         frame_lock;
+static coro_frame_stats_t frame_stats;
+
+void* coro_frame_alloc(size_t _size) {
+    IrqLockGuard<TicketLock> guard(frame_lock);
+    void*                    ptr = nullptr;
+    // 较小的级别用完时使用更大的块
+    if (_size <= coro_frame_sizes[0]) {
+        ptr = frames_0.alloc();
+    }
+    if ((ptr == nullptr) && (_size <= coro_frame_sizes[1])) {
+        ptr = frames_1.alloc();
+    }
+    if ((ptr == nullptr) && (_size <= coro_frame_sizes[2])) {
+        ptr = frames_2.alloc();
+    }
+    if ((ptr == nullptr) && (_size <= coro_frame_sizes[3])) {
+        ptr = frames_3.alloc();
+    }
+    if (ptr == nullptr) {
+        frame_stats.failed++;
+        return nullptr;
+    }
+    frame_stats.used++;
+    if (frame_stats.used > frame_stats.peak) {
+        frame_stats.peak = frame_stats.used;
+    }
+    return ptr;
+}
+
+void coro_frame_free(void* _ptr, size_t _size) {
+    (void)_size;
+    if (_ptr == nullptr) {
+        return;
+    }
+    IrqLockGuard<TicketLock> guard(frame_lock);
+    // 可能从更大的级别分配，按地址查找
+    if (frames_0.free(_ptr) || frames_1.free(_ptr) || frames_2.free(_ptr)
+        || frames_3.free(_ptr)) {
+        frame_stats.used--;
+    }
+    return;
+}
+
+void coro_frame_get_stats(coro_frame_stats_t* _stats) {
+    IrqLockGuard<TicketLock> guard(frame_lock);
+    *_stats = frame_stats;
+    return;
+}
+
+/**
+ * @brief 与编译器生成的协程帧头部布局相同
+ */
+struct coro_noop_frame_t {
+    /// 恢复函数
+    void (*resume)(void* _frame);
+    /// 销毁函数
+    void (*destroy)(void* _frame);
+};
+
+static void coro_noop_func(void* _frame) {
+    (void)_frame;
+    return;
+}
+
+static coro_noop_frame_t coro_noop_frame = { coro_noop_func, coro_noop_func };
+
+std::coroutine_handle<> coro_noop(void) {
+    return std::coroutine_handle<>::from_address(&coro_noop_frame);
+}
@@ -0,0 +1,281 @@
+
+/**
+ * @file expected.hpp
+ * @brief 无异常的错误传递
+ * @author Zone.N (Zone.Niuzh@hotmail.com)
+ * @version 1.0
+ * @date 2026-10-18
+ * @copyright MIT LICENSE
+ * https://github.com/MRNIU/cmake-kernel
+ * @par change log:
+ * <table>
+ * <tr><th>Date<th>Author<th>Description
+ * <tr><td>2026-10-18<td>Zone.N (Zone.Niuzh@hotmail.com)<td>创建文件
+ * </table>
+ */
+
+#ifndef CMAKE_KERNEL_EXPECTED_HPP
+#define CMAKE_KERNEL_EXPECTED_HPP
+
+#include "new"
+#include "type_traits"
+#include "utility"
+
+/**
+ * @brief 错误值的包装，用于构造失败的 Expected
+ * @tparam E                       错误类型
+ */
+template <class E>
+class Unexpected {
+private:
+    E err;
+
+public:
+    constexpr explicit Unexpected(const E& _err) : err(_err) {
+    }
+
+    constexpr explicit Unexpected(E&& _err) : err(std::move(_err)) {
+    }
+
+    constexpr const E& error(void) const& {
+        return err;
+    }
+
+    constexpr E& error(void) & {
+        return err;
+    }
+
+    constexpr E&& error(void) && {
+        return std::move(err);
+    }
+};
+
+template <class E>
+Unexpected(E) -> Unexpected<E>;
+
+/**
+ * @brief 保存返回值或错误值
+ * 不依赖异常与 rtti，失败路径只是一次分支判断
+ * @tparam T                       返回值类型
+ * @tparam E                       错误类型
+ */
+template <class T, class E>
+class Expected {
+private:
+    union {
+        T val;
+        E err;
+    };
+
+    bool has_val;
+
+public:
+    /**
+     * @brief 使用值构造
+     * @param  _val                返回值
+     */
+    constexpr Expected(const T& _val) : val(_val), has_val(true) {
+    }
+
+    constexpr Expected(T&& _val) : val(std::move(_val)), has_val(true) {
+    }
+
+    /**
+     * @brief 使用错误构造
+     * @param  _unexpected         错误值
+     */
+    template <class G>
+    constexpr Expected(const Unexpected<G>& _unexpected)
+        : err(_unexpected.error()), has_val(false) {
+    }
+
+    template <class G>
+    constexpr Expected(Unexpected<G>&& _unexpected)
+        : err(std::move(_unexpected).error()), has_val(false) {
+    }
+
+    Expected(const Expected& _other) : has_val(_other.has_val) {
+        if (has_val) {
+            new (&val) T(_other.val);
+        }
+        else {
+            new (&err) E(_other.err);
+        }
+    }
+
+    Expected(Expected&& _other) : has_val(_other.has_val) {
+        if (has_val) {
+            new (&val) T(std::move(_other.val));
+        }
+        else {
+            new (&err) E(std::move(_other.err));
+        }
+    }
+
+    Expected& operator=(const Expected& _other) {
+        if (this != &_other) {
+            this->~Expected();
+            new (this) Expected(_other);
+        }
+        return *this;
+    }
+
+    Expected& operator=(Expected&& _other) {
+        if (this != &_other) {
+            this->~Expected();
+            new (this) Expected(std::move(_other));
+        }
+        return *this;
+    }
+
+    ~Expected(void) {
+        if (has_val) {
+            val.~T();
+        }
+        else {
+            err.~E();
+        }
+    }
+
+    /**
+     * @brief 是否保存了返回值
+     * @return true                成功
+     * @return false               失败
+     */
+    constexpr bool has_value(void) const {
+        return has_val;
+    }
+
+    constexpr explicit operator bool(void) const {
+        return has_val;
+    }
+
+    /**
+     * @brief 获取返回值，失败时调用属于逻辑错误
+     * @return T&                  返回值
+     */
+    constexpr T& value(void) & {
+        if (!has_val) {
+            __builtin_trap();
+        }
+        return val;
+    }
+
+    constexpr const T& value(void) const& {
+        if (!has_val) {
+            __builtin_trap();
+        }
+        return val;
+    }
+
+    constexpr T&& value(void) && {
+        if (!has_val) {
+            __builtin_trap();
+        }
+        return std::move(val);
+    }
+
+    /**
+     * @brief 获取错误值，成功时调用属于逻辑错误
+     * @return E&                  错误值
+     */
+    constexpr E& error(void) & {
+        return err;
+    }
+
+    constexpr const E& error(void) const& {
+        return err;
+    }
+
+    /**
+     * @brief 获取返回值，失败时返回默认值
+     * @param  _default            默认值
+     * @return T                   返回值或默认值
+     */
+    template <class U>
+    constexpr T value_or(U&& _default) const& {
+        return has_val ? val : static_cast<T>(std::forward<U>(_default));
+    }
+
+    constexpr T& operator*(void) & {
+        return val;
+    }
+
+    constexpr const T& operator*(void) const& {
+        return val;
+    }
+
+    constexpr T* operator->(void) {
+        return &val;
+    }
+
+    constexpr const T* operator->(void) const {
+        return &val;
+    }
+};
+
+/**
+ * @brief 只关心成功与否的 Expected
+ * @tparam E                       错误类型
+ */
+template <class E>
+class Expected<void, E> {
+private:
+    union {
+        E err;
+    };
+
+    bool has_val;
+
+public:
+    constexpr Expected(void) : has_val(true) {
+    }
+
+    template <class G>
+    constexpr Expected(const Unexpected<G>& _unexpected)
+        : err(_unexpected.error()), has_val(false) {
+    }
+
+    template <class G>
+    constexpr Expected(Unexpected<G>&& _unexpected)
+        : err(std::move(_unexpected).error()), has_val(false) {
+    }
+
+    Expected(const Expected& _other) : has_val(_other.has_val) {
+        if (!has_val) {
+            new (&err) E(_other.err);
+        }
+    }
+
+    Expected& operator=(const Expected& _other) {
+        if (this != &_other) {
+            this->~Expected();
+            new (this) Expected(_other);
+        }
+        return *this;
+    }
+
+    ~Expected(void) {
+        if (!has_val) {
+            err.~E();
+        }
+    }
+
+    constexpr bool has_value(void) const {
+        return has_val;
+    }
+
+    constexpr explicit operator bool(void) const {
+        return has_val;
+    }
+
+    constexpr E& error(void) & {
+        return err;
+    }
+
+    constexpr const E& error(void) const& {
+        return err;
+    }
+};
+
+#endif /* CMAKE_KERNEL_EXPECTED_HPP */
@@ -0,0 +1,299 @@
+
+/**
+ * @file flat_hash_map.hpp
+ * @brief 开放寻址哈希表
+ * @author Zone.N (Zone.Niuzh@hotmail.com)
+ * @version 1.0
+ * @date 2026-10-18
+ * @copyright MIT LICENSE
+ * https://github.com/MRNIU/cmake-kernel
+ * @par change log:
+ * <table>
+ * <tr><th>Date<th>Author<th>Description
+ * <tr><td>2026-10-18<td>Zone.N (Zone.Niuzh@hotmail.com)<td>创建文件
+ * </table>
+ */
+
+#ifndef CMAKE_KERNEL_FLAT_HASH_MAP_HPP
+#define CMAKE_KERNEL_FLAT_HASH_MAP_HPP
+
+#include "cstddef"
+#include "cstdint"
+#include "new"
+#include "utility"
+
+#include "libcxx.h"
+
+/**
+ * @brief 默认哈希函数，对整数与指针做一次乘法混合
+ * @tparam K                       键类型
+ */
+template <class K>
+struct FlatHash {
+    uint64_t operator()(const K& _key) const {
+        auto x = static_cast<uint64_t>(_key);
+        x      ^= x >> 33;
+        x      *= 0xff51afd7ed558ccdULL;
+        x      ^= x >> 33;
+        return x;
+    }
+};
+
+template <class K>
+struct FlatHash<K*> {
+    uint64_t operator()(K* const& _key) const {
+        return FlatHash<uint64_t>()(reinterpret_cast<uintptr_t>(_key));
+    }
+};
+
+/**
+ * @brief 固定容量的开放寻址哈希表
+ * 控制字节与键值对分开存放，查找时先以组为单位比较控制字节，
+ * 一个组是 8 个控制字节，使用 64 位整数运算一次比较整组 (SWAR)，
+ * 不使用浮点/向量寄存器，因此可以在中断上下文中使用。
+ * 不分配内存，容量在编译期确定
+ * @tparam K                       键类型
+ * @tparam V                       值类型
+ * @tparam Capacity                槽数，必须是 8 的倍数且为 2 的幂
+ * @tparam Hash                    哈希函数
+ */
+template <class K, class V, size_t Capacity, class Hash = FlatHash<K>>
+class FlatHashMap {
+    static_assert((Capacity >= 8) && ((Capacity & (Capacity - 1)) == 0),
+                  "Capacity must be a power of 2 and >= 8");
+
+private:
+    /// 组大小
+    static constexpr const size_t   GROUP_SIZE   = 8;
+    /// 组数
+    static constexpr const size_t   GROUP_COUNT  = Capacity / GROUP_SIZE;
+    /// 空槽
+    static constexpr const uint8_t  CTRL_EMPTY   = 0x80;
+    /// 已删除的槽
+    static constexpr const uint8_t  CTRL_DELETED = 0xFE;
+    /// 每个字节的最低位
+    static constexpr const uint64_t LSBS         = 0x0101010101010101ULL;
+    /// 每个字节的最高位
+    static constexpr const uint64_t MSBS         = 0x8080808080808080ULL;
+
+    /**
+     * @brief 键值对
+     */
+    struct Slot {
+        K key;
+        V value;
+    };
+
+    /// 控制字节，高位为 0 时低 7 位保存哈希值的一部分
+    alignas(CACHE_LINE_SIZE) uint8_t ctrl[Capacity];
+    /// 槽，使用时才构造
+    alignas(Slot) uint8_t slots[Capacity * sizeof(Slot)];
+    /// 元素数量
+    size_t count;
+
+    Slot* slot(size_t _idx) {
+        return reinterpret_cast<Slot*>(slots) + _idx;
+    }
+
+    const Slot* slot(size_t _idx) const {
+        return reinterpret_cast<const Slot*>(slots) + _idx;
+    }
+
+    static uint64_t load_group(const uint8_t* _ctrl) {
+        uint64_t group;
+        __builtin_memcpy(&group, _ctrl, sizeof(group));
+        return group;
+    }
+
+    /**
+     * @brief 组中等于 _h2 的控制字节，每个匹配字节的最高位置 1
+     * 可能有假阳性，调用者需要比较键
+     */
+    static uint64_t match(uint64_t _group, uint8_t _h2) {
+        auto x = _group ^ (LSBS * _h2);
+        return (x - LSBS) & ~x & MSBS;
+    }
+
+    /**
+     * @brief 组中的空槽
+     */
+    static uint64_t match_empty(uint64_t _group) {
+        return _group & ~(_group << 6) & MSBS;
+    }
+
+    /**
+     * @brief 组中的空槽或已删除的槽
+     */
+    static uint64_t match_empty_or_deleted(uint64_t _group) {
+        return _group & ~(_group << 7) & MSBS;
+    }
+
+    /**
+     * @brief 匹配掩码中最低的匹配字节的下标
+     */
+    static size_t lowest(uint64_t _mask) {
+        return __builtin_ctzll(_mask) / 8;
+    }
+
+    static uint8_t h2(uint64_t _hash) {
+        return static_cast<uint8_t>(_hash & 0x7F);
+    }
+
+    static size_t h1(uint64_t _hash) {
+        return static_cast<size_t>(_hash >> 7) & (GROUP_COUNT - 1);
+    }
+
+    /**
+     * @brief 查找键所在的槽
+     * @return size_t              槽下标，没有时返回 Capacity
+     */
+    size_t find_index(const K& _key) const {
+        auto hash  = Hash()(_key);
+        auto tag   = h2(hash);
+        auto group = h1(hash);
+        // 三角数探测，GROUP_COUNT 为 2 的幂时可以遍历所有组
+        for (size_t step = 0; step < GROUP_COUNT; step++) {
+            auto* base = ctrl + group * GROUP_SIZE;
+            auto  g    = load_group(base);
+            for (auto m = match(g, tag); m != 0; m &= m - 1) {
+                auto idx = group * GROUP_SIZE + lowest(m);
+                if (slot(idx)->key == _key) {
+                    return idx;
+                }
+            }
+            // 组内有空槽，说明键不可能在后续的组中
+            if (match_empty(g) != 0) {
+                return Capacity;
+            }
+            group = (group + step + 1) & (GROUP_COUNT - 1);
+        }
+        return Capacity;
+    }
+
+public:
+    FlatHashMap(void) : count(0) {
+        __builtin_memset(ctrl, CTRL_EMPTY, sizeof(ctrl));
+    }
+
+    FlatHashMap(const FlatHashMap&)            = delete;
+    FlatHashMap& operator=(const FlatHashMap&) = delete;
+
+    ~FlatHashMap(void) {
+        clear();
+    }
+
+    size_t size(void) const {
+        return count;
+    }
+
+    bool empty(void) const {
+        return count == 0;
+    }
+
+    static constexpr size_t capacity(void) {
+        return Capacity;
+    }
+
+    /**
+     * @brief 查找
+     * @param  _key                键
+     * @return V*                  值的指针，不存在时返回 nullptr
+     */
+    V* find(const K& _key) {
+        auto idx = find_index(_key);
+        return idx == Capacity ? nullptr : &slot(idx)->value;
+    }
+
+    const V* find(const K& _key) const {
+        auto idx = find_index(_key);
+        return idx == Capacity ? nullptr : &slot(idx)->value;
+    }
+
+    bool contains(const K& _key) const {
+        return find_index(_key) != Capacity;
+    }
+
+    /**
+     * @brief 插入，键已存在时不覆盖
+     * @param  _key                键
+     * @param  _value              值
+     * @return V*                  键对应的值，表满时返回 nullptr
+     */
+    template <class... Args>
+    V* emplace(const K& _key, Args&&... _args) {
+        auto idx = find_index(_key);
+        if (idx != Capacity) {
+            return &slot(idx)->value;
+        }
+        // 装载因子不超过 7/8，保证探测序列能遇到空槽
+        if (count >= Capacity - Capacity / 8) {
+            return nullptr;
+        }
+        auto hash  = Hash()(_key);
+        auto group = h1(hash);
+        for (size_t step = 0; step < GROUP_COUNT; step++) {
+            auto* base = ctrl + group * GROUP_SIZE;
+            auto  m    = match_empty_or_deleted(load_group(base));
+            if (m != 0) {
+                idx       = group * GROUP_SIZE + lowest(m);
+                ctrl[idx] = h2(hash);
+                new (slot(idx)) Slot{ _key, V(std::forward<Args>(_args)...) };
+                count++;
+                return &slot(idx)->value;
+            }
+            group = (group + step + 1) & (GROUP_COUNT - 1);
+        }
+        return nullptr;
+    }
+
+    V* insert(const K& _key, const V& _value) {
+        return emplace(_key, _value);
+    }
+
+    /**
+     * @brief 删除
+     * @param  _key                键
+     * @return true                删除成功
+     * @return false               键不存在
+     */
+    bool erase(const K& _key) {
+        auto idx = find_index(_key);
+        if (idx == Capacity) {
+            return false;
+        }
+        slot(idx)->~Slot();
+        // 组内还有空槽时，不会有探测序列越过本组，可以直接标记为空
+        auto* base = ctrl + (idx & ~(GROUP_SIZE - 1));
+        ctrl[idx]  = match_empty(load_group(base)) != 0 ? CTRL_EMPTY
+                                                        : CTRL_DELETED;
+        count--;
+        return true;
+    }
+
+    void clear(void) {
+        for (size_t i = 0; i < Capacity; i++) {
+            if ((ctrl[i] & 0x80) == 0) {
+                slot(i)->~Slot();
+            }
+            ctrl[i] = CTRL_EMPTY;
+        }
+        count = 0;
+        return;
+    }
+
+    /**
+     * @brief 遍历全部元素
+     * @param  _func               _func(const K&, V&)
+     */
+    template <class F>
+    void for_each(F&& _func) {
+        for (size_t i = 0; i < Capacity; i++) {
+            if ((ctrl[i] & 0x80) == 0) {
+                _func(slot(i)->key, slot(i)->value);
+            }
+        }
+        return;
+    }
+};
+
+#endif /* CMAKE_KERNEL_FLAT_HASH_MAP_HPP */
@@ -0,0 +1,244 @@
+
+/**
+ * @file intrusive_list.hpp
+ * @brief 侵入式双向链表
+ * @author Zone.N (Zone.Niuzh@hotmail.com)
+ * @version 1.0
+ * @date 2026-10-18
+ * @copyright MIT LICENSE
+ * https://github.com/MRNIU/cmake-kernel
+ * @par change log:
+ * <table>
+ * <tr><th>Date<th>Author<th>Description
+ * <tr><td>2026-10-18<td>Zone.N (Zone.Niuzh@hotmail.com)<td>创建文件
+ * </table>
+ */
+
+#ifndef CMAKE_KERNEL_INTRUSIVE_LIST_HPP
+#define CMAKE_KERNEL_INTRUSIVE_LIST_HPP
+
+#include "cstddef"
+#include "cstdint"
+
+/**
+ * @brief 链表节点，嵌入到元素中
+ * 节点不分配内存，插入/删除均为 O(1)，可以在中断上下文中使用
+ */
+struct ListNode {
+    ListNode* prev = nullptr;
+    ListNode* next = nullptr;
+
+    /**
+     * @brief 是否已在某个链表中
+     * @return true                在链表中
+     */
+    bool is_linked(void) const {
+        return next != nullptr;
+    }
+};
+
+/**
+ * @brief 侵入式双向循环链表
+ * @tparam T                       元素类型
+ * @tparam Member                  T 中 ListNode 成员的指针
+ */
+template <class T, ListNode T::*Member>
+class IntrusiveList {
+private:
+    /// 哨兵节点，链表为空时指向自身
+    ListNode head;
+    /// 元素数量
+    size_t   count;
+
+    /**
+     * @brief 由节点得到元素
+     * @param  _node               节点
+     * @return T*                  节点所在的元素
+     */
+    static T* to_elem(ListNode* _node) {
+        auto offset = reinterpret_cast<uintptr_t>(
+          &(static_cast<T*>(nullptr)->*Member));
+        return reinterpret_cast<T*>(reinterpret_cast<uintptr_t>(_node)
+                                    - offset);
+    }
+
+    /**
+     * @brief 将 _node 插入到 _prev 与 _next 之间
+     */
+    void insert_between(ListNode* _node, ListNode* _prev, ListNode* _next) {
+        _node->prev = _prev;
+        _node->next = _next;
+        _prev->next = _node;
+        _next->prev = _node;
+        count++;
+        return;
+    }
+
+public:
+    /**
+     * @brief 迭代器
+     */
+    class Iterator {
+    private:
+        ListNode* node;
+
+    public:
+        explicit Iterator(ListNode* _node) : node(_node) {
+        }
+
+        T& operator*(void) const {
+            return *to_elem(node);
+        }
+
+        T* operator->(void) const {
+            return to_elem(node);
+        }
+
+        Iterator& operator++(void) {
+            node = node->next;
+            return *this;
+        }
+
+        Iterator& operator--(void) {
+            node = node->prev;
+            return *this;
+        }
+
+        bool operator==(const Iterator& _other) const {
+            return node == _other.node;
+        }
+
+        bool operator!=(const Iterator& _other) const {
+            return node != _other.node;
+        }
+    };
+
+    IntrusiveList(void) : count(0) {
+        head.prev = &head;
+        head.next = &head;
+    }
+
+    /// 节点中保存了指向 head 的指针，不允许拷贝
+    IntrusiveList(const IntrusiveList&)            = delete;
+    IntrusiveList& operator=(const IntrusiveList&) = delete;
+
+    ~IntrusiveList(void) = default;
+
+    bool empty(void) const {
+        return head.next == &head;
+    }
+
+    size_t size(void) const {
+        return count;
+    }
+
+    T* front(void) {
+        return empty() ? nullptr : to_elem(head.next);
+    }
+
+    T* back(void) {
+        return empty() ? nullptr : to_elem(head.prev);
+    }
+
+    void push_front(T& _elem) {
+        insert_between(&(_elem.*Member), &head, head.next);
+        return;
+    }
+
+    void push_back(T& _elem) {
+        insert_between(&(_elem.*Member), head.prev, &head);
+        return;
+    }
+
+    /**
+     * @brief 将 _elem 插入到 _pos 之前
+     * @param  _pos                位置
+     * @param  _elem               要插入的元素
+     */
+    void insert_before(T& _pos, T& _elem) {
+        auto* pos = &(_pos.*Member);
+        insert_between(&(_elem.*Member), pos->prev, pos);
+        return;
+    }
+
+    /**
+     * @brief 删除元素，元素必须在本链表中
+     * @param  _elem               要删除的元素
+     */
+    void erase(T& _elem) {
+        auto* node       = &(_elem.*Member);
+        node->prev->next = node->next;
+        node->next->prev = node->prev;
+        node->prev       = nullptr;
+        node->next       = nullptr;
+        count--;
+        return;
+    }
+
+    T* pop_front(void) {
+        auto* elem = front();
+        if (elem != nullptr) {
+            erase(*elem);
+        }
+        return elem;
+    }
+
+    T* pop_back(void) {
+        auto* elem = back();
+        if (elem != nullptr) {
+            erase(*elem);
+        }
+        return elem;
+    }
+
+    /**
+     * @brief 获取 _elem 的下一个元素
+     * @param  _elem               当前元素
+     * @return T*                  下一个元素，没有时返回 nullptr
+     */
+    T* next(T& _elem) {
+        auto* node = (_elem.*Member).next;
+        return node == &head ? nullptr : to_elem(node);
+    }
+
+    /**
+     * @brief 获取 _elem 的上一个元素
+     * @param  _elem               当前元素
+     * @return T*                  上一个元素，没有时返回 nullptr
+     */
+    T* prev(T& _elem) {
+        auto* node = (_elem.*Member).prev;
+        return node == &head ? nullptr : to_elem(node);
+    }
+
+    /**
+     * @brief 将 _other 的全部元素移动到本链表尾部，O(1)
+     * @param  _other              另一个链表
+     */
+    void splice_back(IntrusiveList& _other) {
+        if (_other.empty()) {
+            return;
+        }
+        auto* first       = _other.head.next;
+        auto* last        = _other.head.prev;
+        first->prev       = head.prev;
+        head.prev->next   = first;
+        last->next        = &head;
+        head.prev         = last;
+        count            += _other.count;
+        _other.head.prev  = &_other.head;
+        _other.head.next  = &_other.head;
+        _other.count      = 0;
+        return;
+    }
+
+    Iterator begin(void) {
+        return Iterator(head.next);
+    }
+
+    Iterator end(void) {
+        return Iterator(&head);
+    }
+};
+
+#endif /* CMAKE_KERNEL_INTRUSIVE_LIST_HPP */
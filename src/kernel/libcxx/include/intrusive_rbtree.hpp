@@ -0,0 +1,410 @@
+
+/**
+ * @file intrusive_rbtree.hpp
+ * @brief 侵入式红黑树
+ * @author Zone.N (Zone.Niuzh@hotmail.com)
+ * @version 1.0
+ * @date 2026-10-18
+ * @copyright MIT LICENSE
+ * https://github.com/MRNIU/cmake-kernel
+ * @par change log:
+ * <table>
+ * <tr><th>Date<th>Author<th>Description
+ * <tr><td>2026-10-18<td>Zone.N (Zone.Niuzh@hotmail.com)<td>创建文件
+ * </table>
+ */
+
+#ifndef CMAKE_KERNEL_INTRUSIVE_RBTREE_HPP
+#define CMAKE_KERNEL_INTRUSIVE_RBTREE_HPP
+
+#include "cstddef"
+#include "cstdint"
+
+/**
+ * @brief 红黑树节点，嵌入到元素中
+ */
+struct RbNode {
+    RbNode* parent = nullptr;
+    RbNode* left   = nullptr;
+    RbNode* right  = nullptr;
+    bool    red    = false;
+};
+
+/**
+ * @brief 侵入式红黑树，允许重复键
+ * 树本身不分配内存，插入/删除 O(log n)，最小元素缓存后为 O(1)
+ * @tparam T                       元素类型
+ * @tparam Member                  T 中 RbNode 成员的指针
+ * @tparam Compare                 比较函数对象，Compare()(a, b) 表示 a < b
+ */
+template <class T, RbNode T::*Member, class Compare>
+class IntrusiveRbTree {
+private:
+    RbNode* root     = nullptr;
+    /// 最左节点，即最小元素
+    RbNode* leftmost = nullptr;
+    size_t  count    = 0;
+
+    static T* to_elem(RbNode* _node) {
+        if (_node == nullptr) {
+            return nullptr;
+        }
+        auto offset = reinterpret_cast<uintptr_t>(
+          &(static_cast<T*>(nullptr)->*Member));
+        return reinterpret_cast<T*>(reinterpret_cast<uintptr_t>(_node)
+                                    - offset);
+    }
+
+    static RbNode* min_node(RbNode* _node) {
+        while (_node->left != nullptr) {
+            _node = _node->left;
+        }
+        return _node;
+    }
+
+    static RbNode* max_node(RbNode* _node) {
+        while (_node->right != nullptr) {
+            _node = _node->right;
+        }
+        return _node;
+    }
+
+    static bool is_red(const RbNode* _node) {
+        return (_node != nullptr) && _node->red;
+    }
+
+    static RbNode* next_node(RbNode* _node) {
+        if (_node->right != nullptr) {
+            return min_node(_node->right);
+        }
+        auto* parent = _node->parent;
+        while ((parent != nullptr) && (_node == parent->right)) {
+            _node  = parent;
+            parent = parent->parent;
+        }
+        return parent;
+    }
+
+    static RbNode* prev_node(RbNode* _node) {
+        if (_node->left != nullptr) {
+            return max_node(_node->left);
+        }
+        auto* parent = _node->parent;
+        while ((parent != nullptr) && (_node == parent->left)) {
+            _node  = parent;
+            parent = parent->parent;
+        }
+        return parent;
+    }
+
+    void rotate_left(RbNode* _x) {
+        auto* y   = _x->right;
+        _x->right = y->left;
+        if (y->left != nullptr) {
+            y->left->parent = _x;
+        }
+        y->parent = _x->parent;
+        if (_x->parent == nullptr) {
+            root = y;
+        }
+        else if (_x == _x->parent->left) {
+            _x->parent->left = y;
+        }
+        else {
+            _x->parent->right = y;
+        }
+        y->left    = _x;
+        _x->parent = y;
+        return;
+    }
+
+    void rotate_right(RbNode* _x) {
+        auto* y  = _x->left;
+        _x->left = y->right;
+        if (y->right != nullptr) {
+            y->right->parent = _x;
+        }
+        y->parent = _x->parent;
+        if (_x->parent == nullptr) {
+            root = y;
+        }
+        else if (_x == _x->parent->right) {
+            _x->parent->right = y;
+        }
+        else {
+            _x->parent->left = y;
+        }
+        y->right   = _x;
+        _x->parent = y;
+        return;
+    }
+
+    /**
+     * @brief 用 _v 替换 _u 在树中的位置
+     */
+    void transplant(RbNode* _u, RbNode* _v) {
+        if (_u->parent == nullptr) {
+            root = _v;
+        }
+        else if (_u == _u->parent->left) {
+            _u->parent->left = _v;
+        }
+        else {
+            _u->parent->right = _v;
+        }
+        if (_v != nullptr) {
+            _v->parent = _u->parent;
+        }
+        return;
+    }
+
+    void insert_fixup(RbNode* _z) {
+        while (is_red(_z->parent)) {
+            auto* parent = _z->parent;
+            auto* grand  = parent->parent;
+            if (parent == grand->left) {
+                auto* uncle = grand->right;
+                if (is_red(uncle)) {
+                    parent->red = false;
+                    uncle->red  = false;
+                    grand->red  = true;
+                    _z          = grand;
+                    continue;
+                }
+                if (_z == parent->right) {
+                    _z = parent;
+                    rotate_left(_z);
+                    parent = _z->parent;
+                }
+                parent->red = false;
+                grand->red  = true;
+                rotate_right(grand);
+            }
+            else {
+                auto* uncle = grand->left;
+                if (is_red(uncle)) {
+                    parent->red = false;
+                    uncle->red  = false;
+                    grand->red  = true;
+                    _z          = grand;
+                    continue;
+                }
+                if (_z == parent->left) {
+                    _z = parent;
+                    rotate_right(_z);
+                    parent = _z->parent;
+                }
+                parent->red = false;
+                grand->red  = true;
+                rotate_left(grand);
+            }
+        }
+        root->red = false;
+        return;
+    }
+
+    void erase_fixup(RbNode* _x, RbNode* _parent) {
+        while ((_x != root) && !is_red(_x)) {
+            if (_x == _parent->left) {
+                auto* w = _parent->right;
+                if (is_red(w)) {
+                    w->red       = false;
+                    _parent->red = true;
+                    rotate_left(_parent);
+                    w = _parent->right;
+                }
+                if (!is_red(w->left) && !is_red(w->right)) {
+                    w->red  = true;
+                    _x      = _parent;
+                    _parent = _x->parent;
+                    continue;
+                }
+                if (!is_red(w->right)) {
+                    w->left->red = false;
+                    w->red       = true;
+                    rotate_right(w);
+                    w = _parent->right;
+                }
+                w->red        = _parent->red;
+                _parent->red  = false;
+                w->right->red = false;
+                rotate_left(_parent);
+                _x = root;
+            }
+            else {
+                auto* w = _parent->left;
+                if (is_red(w)) {
+                    w->red       = false;
+                    _parent->red = true;
+                    rotate_right(_parent);
+                    w = _parent->left;
+                }
+                if (!is_red(w->left) && !is_red(w->right)) {
+                    w->red  = true;
+                    _x      = _parent;
+                    _parent = _x->parent;
+                    continue;
+                }
+                if (!is_red(w->left)) {
+                    w->right->red = false;
+                    w->red        = true;
+                    rotate_left(w);
+                    w = _parent->left;
+                }
+                w->red       = _parent->red;
+                _parent->red = false;
+                w->left->red = false;
+                rotate_right(_parent);
+                _x = root;
+            }
+        }
+        if (_x != nullptr) {
+            _x->red = false;
+        }
+        return;
+    }
+
+public:
+    IntrusiveRbTree(void)  = default;
+    ~IntrusiveRbTree(void) = default;
+
+    IntrusiveRbTree(const IntrusiveRbTree&)            = delete;
+    IntrusiveRbTree& operator=(const IntrusiveRbTree&) = delete;
+
+    bool empty(void) const {
+        return root == nullptr;
+    }
+
+    size_t size(void) const {
+        return count;
+    }
+
+    /**
+     * @brief 最小元素，O(1)
+     * @return T*                  树为空时返回 nullptr
+     */
+    T* first(void) const {
+        return to_elem(leftmost);
+    }
+
+    T* last(void) const {
+        return root == nullptr ? nullptr : to_elem(max_node(root));
+    }
+
+    T* next(T& _elem) const {
+        return to_elem(next_node(&(_elem.*Member)));
+    }
+
+    T* prev(T& _elem) const {
+        return to_elem(prev_node(&(_elem.*Member)));
+    }
+
+    /**
+     * @brief 插入元素，相等的键插入到已有元素之后
+     * @param  _elem               要插入的元素
+     */
+    void insert(T& _elem) {
+        auto*   node        = &(_elem.*Member);
+        RbNode* parent      = nullptr;
+        auto**  link        = &root;
+        bool    is_leftmost = true;
+        Compare cmp;
+        while (*link != nullptr) {
+            parent = *link;
+            if (cmp(_elem, *to_elem(parent))) {
+                link = &parent->left;
+            }
+            else {
+                link        = &parent->right;
+                is_leftmost = false;
+            }
+        }
+        node->parent = parent;
+        node->left   = nullptr;
+        node->right  = nullptr;
+        node->red    = true;
+        *link        = node;
+        if (is_leftmost) {
+            leftmost = node;
+        }
+        insert_fixup(node);
+        count++;
+        return;
+    }
+
+    /**
+     * @brief 删除元素，元素必须在本树中
+     * @param  _elem               要删除的元素
+     */
+    void erase(T& _elem) {
+        auto* z = &(_elem.*Member);
+        if (z == leftmost) {
+            leftmost = next_node(z);
+        }
+        auto*   y         = z;
+        bool    y_was_red = y->red;
+        RbNode* x         = nullptr;
+        RbNode* x_parent  = nullptr;
+        if (z->left == nullptr) {
+            x        = z->right;
+            x_parent = z->parent;
+            transplant(z, z->right);
+        }
+        else if (z->right == nullptr) {
+            x        = z->left;
+            x_parent = z->parent;
+            transplant(z, z->left);
+        }
+        else {
+            y         = min_node(z->right);
+            y_was_red = y->red;
+            x         = y->right;
+            if (y->parent == z) {
+                x_parent = y;
+            }
+            else {
+                x_parent = y->parent;
+                transplant(y, y->right);
+                y->right         = z->right;
+                y->right->parent = y;
+            }
+            transplant(z, y);
+            y->left         = z->left;
+            y->left->parent = y;
+            y->red          = z->red;
+        }
+        if (!y_was_red) {
+            erase_fixup(x, x_parent);
+        }
+        z->parent = nullptr;
+        z->left   = nullptr;
+        z->right  = nullptr;
+        count--;
+        return;
+    }
+
+    /**
+     * @brief 查找第一个不小于 _key 的元素
+     * @tparam K                   键类型
+     * @tparam KeyCompare          KeyCompare()(elem, key) 表示 elem < key
+     * @param  _key                键
+     * @return T*                  没有时返回 nullptr
+     */
+    template <class K, class KeyCompare>
+    T* lower_bound(const K& _key, KeyCompare _cmp) const {
+        RbNode* node   = root;
+        RbNode* result = nullptr;
+        while (node != nullptr) {
+            if (_cmp(*to_elem(node), _key)) {
+                node = node->right;
+            }
+            else {
+                result = node;
+                node   = node->left;
+            }
+        }
+        return to_elem(result);
+    }
+};
+
+#endif /* CMAKE_KERNEL_INTRUSIVE_RBTREE_HPP */
@@ -17,8 +17,27 @@
 #ifndef CMAKE_KERNEL_LIBCXX_H
 #define CMAKE_KERNEL_LIBCXX_H
 
+#include "cstddef"
 #include "cstdint"
 
+/// 缓存行大小，用于避免伪共享
+static constexpr const size_t CACHE_LINE_SIZE = 64;
+
+/**
+ * @brief (_a * _mul) >> _shift
+ * 乘积使用 128 位，不会溢出。只有乘法与移位，64 位架构上直接展开为指令，
+ * 不依赖 libgcc 的 128 位除法，需要除法时用预先算好的倒数代替
+ * @param  _a                      被乘数
+ * @param  _mul                    乘数
+ * @param  _shift                  右移位数，0~63
+ * @return uint64_t                结果的低 64 位
+ */
+static inline uint64_t mul_u64_u32_shr(uint64_t _a, uint32_t _mul,
+                                       uint32_t _shift) {
+    return static_cast<uint64_t>((static_cast<unsigned __int128>(_a) * _mul)
+                                 >> _shift);
+}
+
 /**
  * @brief 入口
  * @param  _argc                   参数个数
@@ -27,4 +46,59 @@
  */
 int32_t libcxx(uint32_t _argc, uint8_t** _argv);
 
+/**
+ * @brief 构造全局对象
+ * 按链接顺序调用 .preinit_array 与 .init_array 中的函数，
+ * 需要在使用任何全局对象前调用
+ */
+void    cpp_init(void);
+
+/**
+ * @brief 析构全局对象
+ * 逆序调用通过 __cxa_atexit 注册的析构函数与 .fini_array
+ */
+void    cpp_deinit(void);
+
+extern "C" {
+/**
+ * @brief 注册全局/静态局部对象的析构函数
+ * @param  _destructor             析构函数
+ * @param  _object                 要析构的对象
+ * @param  _dso_handle             所属模块
+ * @return int                     成功返回 0
+ */
+int  __cxa_atexit(void (*_destructor)(void*), void* _object,
+                  void* _dso_handle);
+
+/**
+ * @brief 调用 _dso_handle 注册的析构函数
+ * @param  _dso_handle             所属模块，为 nullptr 时调用全部
+ */
+void __cxa_finalize(void* _dso_handle);
+
+/**
+ * @brief 静态局部对象初始化前调用
+ * @param  _guard                  guard 变量
+ * @return int                     需要当前调用者初始化时返回 1
+ */
+int  __cxa_guard_acquire(uint64_t* _guard);
+
+/**
+ * @brief 静态局部对象初始化完成后调用
+ * @param  _guard                  guard 变量
+ */
+void __cxa_guard_release(uint64_t* _guard);
+
+/**
+ * @brief 静态局部对象初始化失败时调用
+ * @param  _guard                  guard 变量
+ */
+void __cxa_guard_abort(uint64_t* _guard);
+
+/**
+ * @brief 调用纯虚函数时的处理
+ */
+void __cxa_pure_virtual(void);
+}
+
 #endif /* CMAKE_KERNEL_LIBCXX_H */
@@ -0,0 +1,98 @@
+
+/**
+ * @file ring_buffer.hpp
+ * @brief 单生产者单消费者环形缓冲区
+ * @author Zone.N (Zone.Niuzh@hotmail.com)
+ * @version 1.0
+ * @date 2026-10-18
+ * @copyright MIT LICENSE
+ * https://github.com/MRNIU/cmake-kernel
+ * @par change log:
+ * <table>
+ * <tr><th>Date<th>Author<th>Description
+ * <tr><td>2026-10-18<td>Zone.N (Zone.Niuzh@hotmail.com)<td>创建文件
+ * </table>
+ */
+
+#ifndef CMAKE_KERNEL_RING_BUFFER_HPP
+#define CMAKE_KERNEL_RING_BUFFER_HPP
+
+#include "cstddef"
+#include "cstdint"
+
+#include "libcxx.h"
+
+/**
+ * @brief 无锁环形缓冲区
+ * 只允许一个生产者和一个消费者，例如中断处理程序生产、线程消费。
+ * 读写下标分别位于独立的缓存行，双方只写自己的下标
+ * @tparam T                       元素类型，需要可平凡复制
+ * @tparam N                       容量，必须为 2 的幂
+ */
+template <class T, size_t N>
+class RingBuffer {
+    static_assert((N & (N - 1)) == 0, "N must be a power of 2");
+
+private:
+    /// 消费者写
+    alignas(CACHE_LINE_SIZE) size_t head;
+    /// 生产者写
+    alignas(CACHE_LINE_SIZE) size_t tail;
+    alignas(CACHE_LINE_SIZE) T buffer[N];
+
+public:
+    RingBuffer(void) : head(0), tail(0) {
+    }
+
+    RingBuffer(const RingBuffer&)            = delete;
+    RingBuffer& operator=(const RingBuffer&) = delete;
+
+    ~RingBuffer(void) = default;
+
+    /**
+     * @brief 生产者写入
+     * @param  _elem               元素
+     * @return true                成功
+     * @return false               已满
+     */
+    bool push(const T& _elem) {
+        auto t = __atomic_load_n(&tail, __ATOMIC_RELAXED);
+        if (t - __atomic_load_n(&head, __ATOMIC_ACQUIRE) == N) {
+            return false;
+        }
+        buffer[t & (N - 1)] = _elem;
+        __atomic_store_n(&tail, t + 1, __ATOMIC_RELEASE);
+        return true;
+    }
+
+    /**
+     * @brief 消费者读取
+     * @param  _elem               读出的元素
+     * @return true                成功
+     * @return false               为空
+     */
+    bool pop(T& _elem) {
+        auto h = __atomic_load_n(&head, __ATOMIC_RELAXED);
+        if (h == __atomic_load_n(&tail, __ATOMIC_ACQUIRE)) {
+            return false;
+        }
+        _elem = buffer[h & (N - 1)];
+        __atomic_store_n(&head, h + 1, __ATOMIC_RELEASE);
+        return true;
+    }
+
+    size_t size(void) const {
+        return __atomic_load_n(&tail, __ATOMIC_ACQUIRE)
+               - __atomic_load_n(&head, __ATOMIC_ACQUIRE);
+    }
+
+    bool empty(void) const {
+        return size() == 0;
+    }
+
+    static constexpr size_t capacity(void) {
+        return N;
+    }
+};
+
+#endif /* CMAKE_KERNEL_RING_BUFFER_HPP */
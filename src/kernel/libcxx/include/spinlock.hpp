@@ -0,0 +1,357 @@
+
+/**
+ * @file spinlock.hpp
+ * @brief 自旋锁
+ * @author Zone.N (Zone.Niuzh@hotmail.com)
+ * @version 1.0
+ * @date 2026-10-18
+ * @copyright MIT LICENSE
+ * https://github.com/MRNIU/cmake-kernel
+ * @par change log:
+ * <table>
+ * <tr><th>Date<th>Author<th>Description
+ * <tr><td>2026-10-18<td>Zone.N (Zone.Niuzh@hotmail.com)<td>创建文件
+ * </table>
+ */
+
+#ifndef CMAKE_KERNEL_SPINLOCK_HPP
+#define CMAKE_KERNEL_SPINLOCK_HPP
+
+#include "cstddef"
+#include "cstdint"
+
+#include "cpu.h"
+#include "libcxx.h"
+
+/**
+ * @brief 排队自旋锁
+ * 按取号顺序获得锁，保证公平。所有等待者在同一个缓存行上自旋，
+ * 适合竞争不激烈、临界区很短的场景
+ */
+class TicketLock {
+private:
+    /// 下一个要发出的号
+    uint32_t next;
+    /// 当前持有锁的号
+    uint32_t owner;
+
+public:
+    constexpr TicketLock(void) : next(0), owner(0) {
+    }
+
+    TicketLock(const TicketLock&)            = delete;
+    TicketLock& operator=(const TicketLock&) = delete;
+
+    void lock(void) {
+        auto ticket = __atomic_fetch_add(&next, 1, __ATOMIC_RELAXED);
+        auto curr   = __atomic_load_n(&owner, __ATOMIC_ACQUIRE);
+        while (curr != ticket) {
+            cpu_wait_change(&owner, curr);
+            curr = __atomic_load_n(&owner, __ATOMIC_ACQUIRE);
+        }
+        return;
+    }
+
+    /**
+     * @brief 尝试获取锁，不等待
+     * @return true                成功
+     * @return false               锁已被占用
+     */
+    bool try_lock(void) {
+        auto curr = __atomic_load_n(&owner, __ATOMIC_RELAXED);
+        // next 等于 owner 说明没有持有者与等待者，owner 此时不会变化
+        return __atomic_compare_exchange_n(&next, &curr, curr + 1, false,
+                                           __ATOMIC_ACQUIRE, __ATOMIC_RELAXED);
+    }
+
+    void unlock(void) {
+        // 只有持有者会修改 owner，不需要原子加
+        __atomic_store_n(&owner, owner + 1, __ATOMIC_RELEASE);
+        return;
+    }
+
+    bool is_locked(void) const {
+        return __atomic_load_n(&next, __ATOMIC_RELAXED)
+               != __atomic_load_n(&owner, __ATOMIC_RELAXED);
+    }
+};
+
+/**
+ * @brief MCS 锁的等待节点
+ * 每个等待者只在自己的节点上自旋，独占一个缓存行，
+ * 释放锁时只写下一个等待者的节点，竞争激烈时不会造成缓存行颠簸
+ */
+struct alignas(CACHE_LINE_SIZE) McsNode {
+    /// 下一个等待者
+    McsNode* next   = nullptr;
+    /// 为 1 时表示仍需等待
+    uint32_t locked = 0;
+};
+
+/**
+ * @brief MCS 队列锁
+ * 锁本身只有一个尾指针，等待节点由调用者提供，通常在栈上
+ */
+class McsLock {
+private:
+    /// 队尾，为空时锁空闲
+    McsNode* tail;
+
+public:
+    constexpr McsLock(void) : tail(nullptr) {
+    }
+
+    McsLock(const McsLock&)            = delete;
+    McsLock& operator=(const McsLock&) = delete;
+
+    /**
+     * @brief 获取锁
+     * @param  _node               等待节点，在 unlock 之前不能释放
+     */
+    void lock(McsNode& _node) {
+        _node.next   = nullptr;
+        _node.locked = 1;
+        auto* prev   = __atomic_exchange_n(&tail, &_node, __ATOMIC_ACQ_REL);
+        if (prev == nullptr) {
+            return;
+        }
+        __atomic_store_n(&prev->next, &_node, __ATOMIC_RELEASE);
+        while (__atomic_load_n(&_node.locked, __ATOMIC_ACQUIRE) != 0) {
+            cpu_wait_change(&_node.locked, 1);
+        }
+        return;
+    }
+
+    bool try_lock(McsNode& _node) {
+        _node.next      = nullptr;
+        _node.locked    = 0;
+        McsNode* expect = nullptr;
+        return __atomic_compare_exchange_n(&tail, &expect, &_node, false,
+                                           __ATOMIC_ACQUIRE, __ATOMIC_RELAXED);
+    }
+
+    /**
+     * @brief 释放锁
+     * @param  _node               lock 时使用的节点
+     */
+    void unlock(McsNode& _node) {
+        auto* next = __atomic_load_n(&_node.next, __ATOMIC_ACQUIRE);
+        if (next == nullptr) {
+            // 没有等待者，将队尾置空
+            auto* expect = &_node;
+            if (__atomic_compare_exchange_n(&tail, &expect, nullptr, false,
+                                            __ATOMIC_RELEASE,
+                                            __ATOMIC_RELAXED)) {
+                return;
+            }
+            // 有新的等待者正在入队，等待它链接到本节点
+            while ((next = __atomic_load_n(&_node.next, __ATOMIC_ACQUIRE))
+                   == nullptr) {
+                cpu_relax();
+            }
+        }
+        __atomic_store_n(&next->locked, 0, __ATOMIC_RELEASE);
+        return;
+    }
+
+    bool is_locked(void) const {
+        return __atomic_load_n(&tail, __ATOMIC_RELAXED) != nullptr;
+    }
+};
+
+/**
+ * @brief 读写自旋锁
+ * 读者之间不互斥，写者优先：有写者等待时新的读者不再进入，避免写者饿死
+ */
+class RwLock {
+private:
+    /// 写者持有锁
+    static constexpr const uint32_t WRITER         = 1;
+    /// 有写者在等待
+    static constexpr const uint32_t WRITER_WAITING = 2;
+    /// 每个读者的计数
+    static constexpr const uint32_t READER         = 4;
+
+    uint32_t state;
+
+public:
+    constexpr RwLock(void) : state(0) {
+    }
+
+    RwLock(const RwLock&)            = delete;
+    RwLock& operator=(const RwLock&) = delete;
+
+    void read_lock(void) {
+        while (true) {
+            auto curr = __atomic_load_n(&state, __ATOMIC_RELAXED);
+            if ((curr & (WRITER | WRITER_WAITING)) == 0) {
+                if (__atomic_compare_exchange_n(&state, &curr, curr + READER,
+                                                true, __ATOMIC_ACQUIRE,
+                                                __ATOMIC_RELAXED)) {
+                    return;
+                }
+                continue;
+            }
+            cpu_wait_change(&state, curr);
+        }
+    }
+
+    void read_unlock(void) {
+        __atomic_fetch_sub(&state, READER, __ATOMIC_RELEASE);
+        return;
+    }
+
+    void write_lock(void) {
+        while (true) {
+            auto curr = __atomic_load_n(&state, __ATOMIC_RELAXED);
+            if ((curr & ~WRITER_WAITING) == 0) {
+                // 获取锁的同时清除等待标记，其余等待的写者会重新设置
+                if (__atomic_compare_exchange_n(&state, &curr, WRITER, true,
+                                                __ATOMIC_ACQUIRE,
+                                                __ATOMIC_RELAXED)) {
+                    return;
+                }
+                continue;
+            }
+            if ((curr & WRITER_WAITING) == 0) {
+                __atomic_fetch_or(&state, WRITER_WAITING, __ATOMIC_RELAXED);
+                continue;
+            }
+            cpu_wait_change(&state, curr);
+        }
+    }
+
+    void write_unlock(void) {
+        __atomic_fetch_and(&state, ~WRITER, __ATOMIC_RELEASE);
+        return;
+    }
+};
+
+/**
+ * @brief 顺序锁
+ * 读者不写任何共享数据，读到不一致的数据时重试，
+ * 适合读多写少且数据可以按值拷贝的场景，如时间戳
+ */
+class SeqLock {
+private:
+    /// 为奇数时表示写者正在修改
+    uint32_t   seq;
+    /// 写者之间互斥
+    TicketLock writer;
+
+public:
+    constexpr SeqLock(void) : seq(0) {
+    }
+
+    SeqLock(const SeqLock&)            = delete;
+    SeqLock& operator=(const SeqLock&) = delete;
+
+    /**
+     * @brief 开始读
+     * @return uint32_t            序号，传给 read_retry
+     */
+    uint32_t read_begin(void) const {
+        auto curr = __atomic_load_n(&seq, __ATOMIC_ACQUIRE);
+        while ((curr & 1) != 0) {
+            cpu_wait_change(&seq, curr);
+            curr = __atomic_load_n(&seq, __ATOMIC_ACQUIRE);
+        }
+        return curr;
+    }
+
+    /**
+     * @brief 结束读
+     * @param  _seq                read_begin 的返回值
+     * @return true                读期间有写者，需要重新读
+     * @return false               读到的数据一致
+     */
+    bool read_retry(uint32_t _seq) const {
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        return __atomic_load_n(&seq, __ATOMIC_RELAXED) != _seq;
+    }
+
+    void write_lock(void) {
+        writer.lock();
+        __atomic_store_n(&seq, seq + 1, __ATOMIC_RELAXED);
+        // 序号必须先于数据可见
+        __atomic_thread_fence(__ATOMIC_RELEASE);
+        return;
+    }
+
+    void write_unlock(void) {
+        __atomic_store_n(&seq, seq + 1, __ATOMIC_RELEASE);
+        writer.unlock();
+        return;
+    }
+};
+
+/**
+ * @brief 作用域锁，构造时加锁，析构时解锁
+ * @tparam Lock                    锁类型，需要 lock() 与 unlock()
+ */
+template <class Lock>
+class LockGuard {
+private:
+    Lock& lock;
+
+public:
+    explicit LockGuard(Lock& _lock) : lock(_lock) {
+        lock.lock();
+    }
+
+    ~LockGuard(void) {
+        lock.unlock();
+    }
+
+    LockGuard(const LockGuard&)            = delete;
+    LockGuard& operator=(const LockGuard&) = delete;
+};
+
+/**
+ * @brief MCS 锁的作用域锁，等待节点位于栈上
+ */
+template <>
+class LockGuard<McsLock> {
+private:
+    McsLock& lock;
+    McsNode  node;
+
+public:
+    explicit LockGuard(McsLock& _lock) : lock(_lock) {
+        lock.lock(node);
+    }
+
+    ~LockGuard(void) {
+        lock.unlock(node);
+    }
+
+    LockGuard(const LockGuard&)            = delete;
+    LockGuard& operator=(const LockGuard&) = delete;
+};
+
+/**
+ * @brief 关中断的作用域锁，构造时关中断并加锁，析构时解锁并恢复中断状态
+ * 锁会在中断处理函数中获取时使用，避免持有者被本 cpu 的中断打断后死锁
+ * @tparam Lock                    锁类型，需要 lock() 与 unlock()
+ */
+template <class Lock>
+class IrqLockGuard {
+private:
+    Lock&    lock;
+    uint64_t flags;
+
+public:
+    explicit IrqLockGuard(Lock& _lock) : lock(_lock), flags(cpu_irq_save()) {
+        lock.lock();
+    }
+
+    ~IrqLockGuard(void) {
+        lock.unlock();
+        cpu_irq_restore(flags);
+    }
+
+    IrqLockGuard(const IrqLockGuard&)            = delete;
+    IrqLockGuard& operator=(const IrqLockGuard&) = delete;
+};
+
+#endif /* CMAKE_KERNEL_SPINLOCK_HPP */
@@ -0,0 +1,148 @@
+
+/**
+ * @file static_vector.hpp
+ * @brief 固定容量数组
+ * @author Zone.N (Zone.Niuzh@hotmail.com)
+ * @version 1.0
+ * @date 2026-10-18
+ * @copyright MIT LICENSE
+ * https://github.com/MRNIU/cmake-kernel
+ * @par change log:
+ * <table>
+ * <tr><th>Date<th>Author<th>Description
+ * <tr><td>2026-10-18<td>Zone.N (Zone.Niuzh@hotmail.com)<td>创建文件
+ * </table>
+ */
+
+#ifndef CMAKE_KERNEL_STATIC_VECTOR_HPP
+#define CMAKE_KERNEL_STATIC_VECTOR_HPP
+
+#include "cstddef"
+#include "cstdint"
+#include "new"
+#include "utility"
+
+/**
+ * @brief 容量在编译期确定的数组，元素连续存放，不分配内存
+ * @tparam T                       元素类型
+ * @tparam N                       容量
+ */
+template <class T, size_t N>
+class StaticVector {
+private:
+    alignas(T) uint8_t storage[N * sizeof(T)];
+    size_t count;
+
+public:
+    StaticVector(void) : count(0) {
+    }
+
+    StaticVector(const StaticVector&)            = delete;
+    StaticVector& operator=(const StaticVector&) = delete;
+
+    ~StaticVector(void) {
+        clear();
+    }
+
+    T* data(void) {
+        return reinterpret_cast<T*>(storage);
+    }
+
+    const T* data(void) const {
+        return reinterpret_cast<const T*>(storage);
+    }
+
+    size_t size(void) const {
+        return count;
+    }
+
+    static constexpr size_t capacity(void) {
+        return N;
+    }
+
+    bool empty(void) const {
+        return count == 0;
+    }
+
+    bool full(void) const {
+        return count == N;
+    }
+
+    T& operator[](size_t _idx) {
+        return data()[_idx];
+    }
+
+    const T& operator[](size_t _idx) const {
+        return data()[_idx];
+    }
+
+    T& back(void) {
+        return data()[count - 1];
+    }
+
+    /**
+     * @brief 在尾部构造元素
+     * @return T*                  新元素，已满时返回 nullptr
+     */
+    template <class... Args>
+    T* emplace_back(Args&&... _args) {
+        if (full()) {
+            return nullptr;
+        }
+        auto* elem = new (data() + count) T(std::forward<Args>(_args)...);
+        count++;
+        return elem;
+    }
+
+    /**
+     * @brief 在尾部添加元素
+     * @return true                成功
+     * @return false               已满
+     */
+    bool push_back(const T& _elem) {
+        return emplace_back(_elem) != nullptr;
+    }
+
+    void pop_back(void) {
+        count--;
+        data()[count].~T();
+        return;
+    }
+
+    /**
+     * @brief 删除 _idx 处的元素，用最后一个元素填补，O(1)，不保持顺序
+     * @param  _idx                下标
+     */
+    void swap_erase(size_t _idx) {
+        if (_idx != count - 1) {
+            data()[_idx] = std::move(back());
+        }
+        pop_back();
+        return;
+    }
+
+    void clear(void) {
+        while (count > 0) {
+            pop_back();
+        }
+        return;
+    }
+
+    T* begin(void) {
+        return data();
+    }
+
+    T* end(void) {
+        return data() + count;
+    }
+
+    const T* begin(void) const {
+        return data();
+    }
+
+    const T* end(void) const {
+        return data() + count;
+    }
+};
+
+#endif /* CMAKE_KERNEL_STATIC_VECTOR_HPP */
@@ -0,0 +1,299 @@
+
+/**
+ * @file task.hpp
+ * @brief 协程任务
+ * @author Zone.N (Zone.Niuzh@hotmail.com)
+ * @version 1.0
+ * @date 2026-10-18
+ * @copyright MIT LICENSE
+ * https://github.com/MRNIU/cmake-kernel
+ * @par change log:
+ * <table>
+ * <tr><th>Date<th>Author<th>Description
+ * <tr><td>2026-10-18<td>Zone.N (Zone.Niuzh@hotmail.com)<td>创建文件
+ * </table>
+ */
+
+#ifndef CMAKE_KERNEL_TASK_HPP
+#define CMAKE_KERNEL_TASK_HPP
+
+#include "coroutine"
+#include "cstddef"
+#include "cstdint"
+#include "new"
+#include "type_traits"
+#include "utility"
+
+#include "intrusive_list.hpp"
+
+/**
+ * @brief 从协程帧内存池分配，不使用通用堆
+ * 按大小分级的固定块，可以在中断上下文中调用
+ * @param  _size                   帧大小
+ * @return void*                   帧，没有合适的空闲块时返回 nullptr
+ */
+void* coro_frame_alloc(size_t _size);
+
+/**
+ * @brief 释放协程帧
+ * @param  _ptr                    coro_frame_alloc 返回的帧
+ * @param  _size                   分配时的大小
+ */
+void  coro_frame_free(void* _ptr, size_t _size);
+
+/**
+ * @brief 协程帧内存池的统计
+ */
+struct coro_frame_stats_t {
+    /// 正在使用的帧数
+    size_t used;
+    /// 曾经同时使用的最大帧数
+    size_t peak;
+    /// 分配失败次数
+    size_t failed;
+};
+
+/**
+ * @brief 读取协程帧内存池的统计
+ * @param  _stats                  统计
+ */
+void  coro_frame_get_stats(coro_frame_stats_t* _stats);
+
+/**
+ * @brief 什么都不做的协程，恢复与销毁时直接返回
+ * 用于对称转移时没有要恢复的协程的情况。不使用 std::noop_coroutine()，
+ * 它的帧是 GNU unique 符号，内核以 -shared 链接时无法重定位
+ * @return std::coroutine_handle<> 协程句柄
+ */
+std::coroutine_handle<> coro_noop(void);
+
+/**
+ * @brief 所有 Task 的 promise 的公共部分
+ * 执行器通过它恢复协程，与具体的返回值类型无关
+ */
+class TaskPromiseBase {
+public:
+    /// 执行上下文，由执行器设置，co_await 子任务时传给子任务
+    void*                   context = nullptr;
+    /// 完成后恢复的协程，没有时为空
+    std::coroutine_handle<> continuation;
+    /// 本协程
+    std::coroutine_handle<> self;
+    /// 没有所有者，完成后自己销毁
+    bool                    detached = false;
+    /// 执行器就绪队列中的节点
+    ListNode                ready_node;
+
+    /**
+     * @brief 完成时恢复等待者 (对称转移，不增加栈深度)，
+     * 没有等待者且已分离时销毁自己
+     */
+    struct FinalAwaiter {
+        bool await_ready(void) noexcept {
+            return false;
+        }
+
+        template <class P>
+        std::coroutine_handle<>
+        await_suspend(std::coroutine_handle<P> _handle) noexcept {
+            auto& promise = _handle.promise();
+            if (promise.continuation) {
+                return promise.continuation;
+            }
+            if (promise.detached) {
+                _handle.destroy();
+            }
+            return coro_noop();
+        }
+
+        void await_resume(void) noexcept {
+        }
+    };
+
+    static void* operator new(size_t _size) noexcept {
+        return coro_frame_alloc(_size);
+    }
+
+    static void operator delete(void* _ptr, size_t _size) noexcept {
+        coro_frame_free(_ptr, _size);
+        return;
+    }
+
+    /// 创建后不立即执行，由 co_await 或执行器启动
+    std::suspend_always initial_suspend(void) noexcept {
+        return {};
+    }
+
+    FinalAwaiter final_suspend(void) noexcept {
+        return {};
+    }
+
+    void unhandled_exception(void) noexcept {
+        __builtin_trap();
+    }
+};
+
+/**
+ * @brief 保存返回值的 promise
+ * @tparam T                       返回值类型
+ */
+template <class T>
+class TaskPromise : public TaskPromiseBase {
+private:
+    alignas(T) uint8_t storage[sizeof(T)];
+    bool has_value = false;
+
+public:
+    ~TaskPromise(void) {
+        if (has_value) {
+            result().~T();
+        }
+    }
+
+    template <class U>
+    void return_value(U&& _value) {
+        new (storage) T(std::forward<U>(_value));
+        has_value = true;
+        return;
+    }
+
+    T& result(void) {
+        return *reinterpret_cast<T*>(storage);
+    }
+};
+
+template <>
+class TaskPromise<void> : public TaskPromiseBase {
+public:
+    void return_void(void) {
+        return;
+    }
+
+    void result(void) {
+        return;
+    }
+};
+
+/**
+ * @brief 惰性执行的协程任务
+ * 创建后挂起，被 co_await 时才开始执行，完成后直接恢复等待者。
+ * 帧从 coro_frame_alloc 分配，失败时得到 valid() 为 false 的任务，
+ * 交给执行器时被拒绝，co_await 时停机，
+ * 内存池需要按并发请求数与调用深度配置
+ * @tparam T                       返回值类型
+ */
+template <class T = void>
+class Task {
+public:
+    class promise_type : public TaskPromise<T> {
+    public:
+        Task get_return_object(void) noexcept {
+            auto handle = std::coroutine_handle<promise_type>::from_promise(
+              *this);
+            this->self = handle;
+            return Task(handle);
+        }
+
+        static Task get_return_object_on_allocation_failure(void) noexcept {
+            return Task(nullptr);
+        }
+    };
+
+    using Handle = std::coroutine_handle<promise_type>;
+
+private:
+    Handle handle;
+
+    explicit Task(Handle _handle) : handle(_handle) {
+    }
+
+    explicit Task(std::nullptr_t) : handle(nullptr) {
+    }
+
+public:
+    /**
+     * @brief co_await 子任务: 启动子任务，完成后恢复当前协程
+     */
+    class Awaiter {
+    private:
+        Handle handle;
+
+    public:
+        explicit Awaiter(Handle _handle) : handle(_handle) {
+        }
+
+        bool await_ready(void) noexcept {
+            // 帧分配失败的任务没有结果可以返回
+            if (!handle) {
+                __builtin_trap();
+            }
+            return handle.done();
+        }
+
+        template <class P>
+        std::coroutine_handle<>
+        await_suspend(std::coroutine_handle<P> _parent) noexcept {
+            static_assert(std::is_base_of_v<TaskPromiseBase, P>,
+                          "Task can only be awaited from a Task");
+            handle.promise().continuation = _parent;
+            handle.promise().context      = _parent.promise().context;
+            return handle;
+        }
+
+        decltype(auto) await_resume(void) {
+            if constexpr (std::is_void_v<T>) {
+                return;
+            }
+            else {
+                return std::move(handle.promise().result());
+            }
+        }
+    };
+
+    Task(Task&& _other) noexcept : handle(_other.handle) {
+        _other.handle = nullptr;
+    }
+
+    Task& operator=(Task&& _other) noexcept {
+        if (this != &_other) {
+            if (handle) {
+                handle.destroy();
+            }
+            handle        = _other.handle;
+            _other.handle = nullptr;
+        }
+        return *this;
+    }
+
+    Task(const Task&)            = delete;
+    Task& operator=(const Task&) = delete;
+
+    ~Task(void) {
+        if (handle) {
+            handle.destroy();
+        }
+    }
+
+    /**
+     * @brief 帧是否分配成功
+     */
+    bool valid(void) const {
+        return static_cast<bool>(handle);
+    }
+
+    Awaiter operator co_await(void) && noexcept {
+        return Awaiter(handle);
+    }
+
+    /**
+     * @brief 放弃所有权，由调用者负责恢复与销毁，用于执行器
+     * @return Handle              协程句柄
+     */
+    Handle release(void) {
+        auto ret = handle;
+        handle   = nullptr;
+        return ret;
+    }
+};
+
+#endif /* CMAKE_KERNEL_TASK_HPP */
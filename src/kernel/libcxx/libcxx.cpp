@@ -15,15 +15,162 @@
  */
 
 #include "libcxx.h"
+#include "cpu.h"
 
-int32_t libcxx(uint32_t _argc, uint8_t** _argv) {
-    (void)_argc;
-    (void)_argv;
+/// 函数指针类型
+typedef void (*function_t)(void);
+
+/// 由链接脚本提供的全局构造/析构函数表
+extern "C" function_t __preinit_array_start[];
+extern "C" function_t __preinit_array_end[];
+extern "C" function_t __init_array_start[];
+extern "C" function_t __init_array_end[];
+extern "C" function_t __fini_array_start[];
+extern "C" function_t __fini_array_end[];
+
+void cpp_init(void) {
+    // 按链接顺序调用，不需要分配内存
+    for (function_t* func = __preinit_array_start; func < __preinit_array_end;
+         func++) {
+        (*func)();
+    }
+    for (function_t* func = __init_array_start; func < __init_array_end;
+         func++) {
+        (*func)();
+    }
+    return;
+}
+
+/**
+ * @brief atexit 注册项
+ */
+struct atexit_entry_t {
+    /// 析构函数
+    void (*destructor)(void*);
+    /// 要析构的对象
+    void* object;
+    /// 所属模块
+    void* dso_handle;
+    /// 是否已填写完成
+    bool  valid;
+};
+
+/// atexit 表的最大项数，内核中全局对象数量有限，使用静态表避免堆分配
+static constexpr const uint32_t ATEXIT_MAX_ENTRIES = 128;
+/// atexit 表
+static atexit_entry_t           atexit_entries[ATEXIT_MAX_ENTRIES];
+/// 已使用的表项数
+static uint32_t                 atexit_count = 0;
+
+void cpp_deinit(void) {
+    __cxa_finalize(nullptr);
+    // 逆序调用 .fini_array
+    for (function_t* func = __fini_array_end; func > __fini_array_start;) {
+        func--;
+        (*func)();
+    }
+    return;
+}
+
+extern "C" {
+
+/// 当前模块句柄，编译器为每个需要析构的全局对象引用它
+void* __dso_handle = nullptr;
+
+int __cxa_atexit(void (*_destructor)(void*), void* _object,
+                 void* _dso_handle) {
+    // 静态局部对象可能在任意核上首次构造，使用原子操作分配表项
+    auto idx = __atomic_fetch_add(&atexit_count, 1, __ATOMIC_RELAXED);
+    if (idx >= ATEXIT_MAX_ENTRIES) {
+        return -1;
+    }
+    atexit_entries[idx].destructor = _destructor;
+    atexit_entries[idx].object     = _object;
+    atexit_entries[idx].dso_handle = _dso_handle;
+    __atomic_store_n(&atexit_entries[idx].valid, true, __ATOMIC_RELEASE);
+    return 0;
+}
 
-    // 进入死循环
+void __cxa_finalize(void* _dso_handle) {
+    auto count = __atomic_load_n(&atexit_count, __ATOMIC_ACQUIRE);
+    if (count > ATEXIT_MAX_ENTRIES) {
+        count = ATEXIT_MAX_ENTRIES;
+    }
+    // 与注册顺序相反
+    while (count-- > 0) {
+        auto& entry = atexit_entries[count];
+        if (__atomic_load_n(&entry.valid, __ATOMIC_ACQUIRE) == false) {
+            continue;
+        }
+        if ((_dso_handle != nullptr) && (entry.dso_handle != _dso_handle)) {
+            continue;
+        }
+        entry.valid = false;
+        entry.destructor(entry.object);
+    }
+    return;
+}
+
+/**
+ * @brief guard 的布局
+ * Itanium C++ ABI 规定 guard 为 64 位，编译器只检查第 0 字节，
+ * 在其非 0 时直接跳过初始化，因此快速路径只有一次 acquire 读
+ */
+enum {
+    /// 初始化已完成
+    GUARD_DONE = 0,
+    /// 正在初始化
+    GUARD_BUSY = 1,
+};
+
+int __cxa_guard_acquire(uint64_t* _guard) {
+    auto* guard = reinterpret_cast<uint8_t*>(_guard);
+    while (true) {
+        if (__atomic_load_n(&guard[GUARD_DONE], __ATOMIC_ACQUIRE) != 0) {
+            return 0;
+        }
+        uint8_t expected = 0;
+        if (__atomic_compare_exchange_n(&guard[GUARD_BUSY], &expected, 1, false,
+                                        __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+            // 抢到初始化权后再检查一次，其它核可能刚刚完成初始化
+            if (__atomic_load_n(&guard[GUARD_DONE], __ATOMIC_ACQUIRE) != 0) {
+                __atomic_store_n(&guard[GUARD_BUSY], 0, __ATOMIC_RELEASE);
+                return 0;
+            }
+            return 1;
+        }
+        // 只读等待，不反复写 guard 所在的缓存行
+        while (__atomic_load_n(&guard[GUARD_BUSY], __ATOMIC_RELAXED) != 0) {
+            cpu_relax();
+        }
+    }
+}
+
+void __cxa_guard_release(uint64_t* _guard) {
+    auto* guard = reinterpret_cast<uint8_t*>(_guard);
+    __atomic_store_n(&guard[GUARD_DONE], 1, __ATOMIC_RELEASE);
+    __atomic_store_n(&guard[GUARD_BUSY], 0, __ATOMIC_RELEASE);
+    return;
+}
+
+void __cxa_guard_abort(uint64_t* _guard) {
+    auto* guard = reinterpret_cast<uint8_t*>(_guard);
+    __atomic_store_n(&guard[GUARD_BUSY], 0, __ATOMIC_RELEASE);
+    return;
+}
+
+void __cxa_pure_virtual(void) {
+    // 调用了纯虚函数，无法恢复
+    cpu_irq_disable();
     while (1) {
-        ;
+        cpu_halt();
     }
+}
+}
+
+int32_t libcxx(uint32_t _argc, uint8_t** _argv) {
+    (void)_argc;
+    (void)_argv;
 
     return 0;
 }
@@ -15,14 +15,166 @@
  */
 
 #include "kernel.h"
+#include "arch.h"
+#include "blkdev.h"
+#include "cpu.h"
+#include "driver.h"
+#include "fat.h"
+#include "initramfs.h"
+#include "interrupt.h"
+#include "ktime.h"
+#include "libcxx.h"
+#include "mm.h"
+#include "mutex.h"
+#include "pagecache.h"
+#include "platform.h"
+#include "rcu.h"
+#include "sched.h"
+#include "smp.h"
+#include "workqueue.h"
 
-int main(int _argc, char** _argv) {
-    (void)_argc;
-    (void)_argv;
+#if ENABLE_BENCH == 1
+/// 测量进出中断开销的次数
+static constexpr const size_t BENCH_INTERRUPT_ITERATIONS = 100000;
+/// 测量上下文切换时每个线程的唤醒次数
+static constexpr const size_t BENCH_SWITCH_ITERATIONS    = 10000;
+/// 测量调度吞吐的线程数与每个线程让出 cpu 的次数
+static constexpr const size_t BENCH_SCHED_THREADS        = 16;
+static constexpr const size_t BENCH_SCHED_ITERATIONS     = 10000;
+/// 测量互斥锁移交时每个线程的加锁次数
+static constexpr const size_t BENCH_HANDOFF_ITERATIONS   = 10000;
+/// 测量互斥锁吞吐的线程数与每个线程的加锁次数
+static constexpr const size_t BENCH_MUTEX_THREADS        = 16;
+static constexpr const size_t BENCH_MUTEX_ITERATIONS     = 10000;
+/// 块设备测量每个线程完成的请求数
+static constexpr const size_t BENCH_BLK_IOS              = 10000;
+
+/**
+ * @brief 启动时性能测量的结果
+ * 内核没有输出，测量完成后在调试器中查看: p bench_results
+ */
+struct bench_results_t {
+    /// 进出一次中断的平均周期数，架构不支持时为 0
+    uint64_t    interrupt_cycles;
+    /// 一次上下文切换的平均纳秒数
+    uint64_t    switch_ns;
+    /// BENCH_SCHED_THREADS 个线程全部完成的纳秒数
+    uint64_t    sched_throughput_ns;
+    /// 互斥锁一次移交的平均纳秒数
+    uint64_t    mutex_handoff_ns;
+    /// BENCH_MUTEX_THREADS 个线程全部完成的纳秒数
+    uint64_t    mutex_throughput_ns;
+    /// 第一个块设备上 4K 随机读的结果，没有块设备时为 0
+    blk_bench_t blk_randread;
+    /// 为 true 时全部测量已完成
+    bool        done;
+};
 
-    // 进入死循环
-    while (1) {
-        ;
+bench_results_t bench_results;
+
+/**
+ * @brief 依次运行需要线程的测量，完成后设置 bench_results.done
+ */
+static void bench_thread(void* _arg) {
+    (void)_arg;
+    bench_results.switch_ns = sched_bench_switch(BENCH_SWITCH_ITERATIONS);
+    bench_results.sched_throughput_ns =
+        sched_bench_throughput(BENCH_SCHED_THREADS, BENCH_SCHED_ITERATIONS);
+    bench_results.mutex_handoff_ns =
+        mutex_bench_handoff(BENCH_HANDOFF_ITERATIONS);
+    bench_results.mutex_throughput_ns =
+        mutex_bench_throughput(BENCH_MUTEX_THREADS, BENCH_MUTEX_ITERATIONS);
+    // 等待驱动探测完成，只读，不破坏设备上的数据
+    driver_wait_init();
+    auto* bdev = blk_get(0);
+    if (bdev != nullptr) {
+        auto& bench      = bench_results.blk_randread;
+        bench.threads    = smp_cpu_count();
+        bench.iodepth    = BLK_BENCH_DEPTH_MAX;
+        bench.block_size = BLK_BENCH_BLOCK_MAX;
+        bench.ios        = BENCH_BLK_IOS;
+        bench.write      = false;
+        bench.random     = true;
+        blk_bench(bdev, &bench);
     }
+    __atomic_store_n(&bench_results.done, true, __ATOMIC_RELEASE);
+    return;
+}
+#endif
+
+int main(int _argc, char** _argv) {
+    // 构造全局对象
+    cpp_init();
+
+    // 架构相关初始化
+    arch(_argc, reinterpret_cast<uint8_t**>(_argv));
+
+    // 初始化地址空间管理
+    mm_init();
+
+    // 初始化 rcu
+    rcu_init();
+
+    // 初始化时钟与定时器
+    time_init();
+
+    // 初始化调度器，当前执行流成为空闲任务
+    sched_init();
+
+    // 初始化工作队列，启动本 cpu 的工作线程
+    workqueues_init();
+
+    // 初始化页缓存与后台写回
+    pcache_init();
+
+#if ENABLE_BENCH == 1
+    // 在其它 cpu 启动前测量，INTERRUPT_BENCH 可能与处理器间中断共用
+    bench_results.interrupt_cycles =
+        interrupt_bench(BENCH_INTERRUPT_ITERATIONS);
+#endif
+
+    // 启动其它 cpu
+    smp_init();
+
+    // 根据设备树与 ACPI 表添加平台设备
+    platform_init();
+
+    // 为加载器传入的 initramfs 建立索引，之后的初始化可以从中读取文件
+    initramfs_init();
+
+    // 在初始化线程中按级别注册驱动，同一级别的设备并行探测
+    driver_init();
+
+    // 驱动初始化完成后在后台挂载启动卷
+    fat_init();
+
+#if ENABLE_BENCH == 1
+    // 其余测量在所有 cpu 启动后于后台线程中运行
+    kthread_run(bench_thread, nullptr, "bench");
+#endif
+
+    // 没有其它工作，进入空闲循环
+    cpu_idle_loop();
     return 0;
 }
+
+void secondary_main(void) {
+    // 初始化本 cpu 的地址空间标签
+    mm_cpu_init();
+
+    // 参与 rcu 宽限期
+    rcu_cpu_online();
+
+    // 初始化本 cpu 的定时器
+    time_cpu_init();
+
+    // 初始化本 cpu 的运行队列
+    sched_cpu_init();
+
+    // 启动本 cpu 的工作线程
+    workqueues_cpu_init();
+
+    // 没有其它工作，进入空闲循环
+    cpu_idle_loop();
+    return;
+}
@@ -0,0 +1,238 @@
+
+/**
+ * @file asid.cpp
+ * @brief 地址空间标签分配
+ * @author Zone.N (Zone.Niuzh@hotmail.com)
+ * @version 1.0
+ * @date 2026-10-18
+ * @copyright MIT LICENSE
+ * https://github.com/MRNIU/cmake-kernel
+ * @par change log:
+ * <table>
+ * <tr><th>Date<th>Author<th>Description
+ * <tr><td>2026-10-18<td>Zone.N (Zone.Niuzh@hotmail.com)<td>创建文件
+ * </table>
+ */
+
+#include "cpu.h"
+#include "libcxx.h"
+#include "mm.h"
+#include "mmu.h"
+#include "percpu.h"
+#include "spinlock.hpp"
+
+// 按代分配标签: 每一代中每个标签最多分配给一个地址空间，
+// context_id 的代数与当前代相同时标签仍然有效，切换时不需要加锁。
+// 标签用完时进入新的一代，清空分配表，
+// 各 cpu 正在使用的标签保留给原来的地址空间，
+// 其余地址空间在下一次切换时重新分配；各 cpu 在下一次分配时丢弃全部 tlb，
+// 旧代的 tlb 不会被新分配到同一标签的地址空间看到。
+// 标签 0 留给内核地址空间
+
+/// 最多支持 16 位标签
+static constexpr const size_t ASID_MAX_BITS = 16;
+static constexpr const size_t ASID_WORDS    = (1 << ASID_MAX_BITS) / 64;
+
+address_space_t kernel_address_space;
+
+/// 标签位数，0 表示不支持标签，每次切换都丢弃 tlb
+static uint32_t asid_bits;
+/// 当前代，低 asid_bits 位为 0
+static uint64_t asid_generation;
+/// 当前代已分配的标签
+static uint64_t asid_map[ASID_WORDS];
+/// 下一次从这里开始查找空闲标签
+static size_t   asid_next;
+/// 保护分配表与代数的更新
+static TicketLock asid_lock;
+
+/**
+ * @brief 每个 cpu 的标签状态
+ */
+struct alignas(CACHE_LINE_SIZE) asid_cpu_t {
+    /// 正在使用的 context_id，进入新的一代时被清 0
+    uint64_t active;
+    /// 进入新的一代时正在使用的 context_id，由 asid_lock 保护
+    uint64_t reserved;
+    /// 需要丢弃全部 tlb
+    bool     flush_pending;
+};
+
+static asid_cpu_t asid_cpus[MAX_CPU_COUNT];
+
+/// 当前 cpu 的地址空间
+static DEFINE_PER_CPU(address_space_t*, current_as);
+
+static uint64_t asid_mask(void) {
+    return (static_cast<uint64_t>(1) << asid_bits) - 1;
+}
+
+static size_t asid_count(void) {
+    return static_cast<size_t>(1) << asid_bits;
+}
+
+static bool asid_test_and_set(uint64_t _asid) {
+    auto& word = asid_map[_asid / 64];
+    auto  bit  = static_cast<uint64_t>(1) << (_asid % 64);
+    auto  old  = (word & bit) != 0;
+    word |= bit;
+    return old;
+}
+
+/**
+ * @brief 从 _start 开始查找空闲标签
+ * @return size_t                  标签，没有时返回 asid_count()
+ */
+static size_t asid_find_free(size_t _start) {
+    auto count = asid_count();
+    for (size_t i = _start; i < count;) {
+        auto word = ~asid_map[i / 64] >> (i % 64);
+        if (word != 0) {
+            auto asid = i + __builtin_ctzll(word);
+            return asid < count ? asid : count;
+        }
+        i = (i / 64 + 1) * 64;
+    }
+    return count;
+}
+
+/**
+ * @brief 进入新的一代，需要持有 asid_lock
+ */
+static void asid_rollover(void) {
+    __builtin_memset(asid_map, 0, sizeof(asid_map));
+    asid_test_and_set(0);
+    for (size_t cpu = 0; cpu < MAX_CPU_COUNT; cpu++) {
+        auto* state = &asid_cpus[cpu];
+        auto  id    = __atomic_exchange_n(&state->active, 0, __ATOMIC_RELAXED);
+        // 上一次进入新的一代后没有切换过，仍在使用保留的标签
+        if (id == 0) {
+            id = state->reserved;
+        }
+        asid_test_and_set(id & asid_mask());
+        state->reserved      = id;
+        state->flush_pending = true;
+    }
+    return;
+}
+
+/**
+ * @brief 将保留的 _old_id 更新为当前代的 _new_id，需要持有 asid_lock
+ * 比较完整的 context_id，更早的代中使用过同一标签的地址空间不会命中
+ * @return true                    _old_id 被某个 cpu 保留，可以继续使用
+ */
+static bool asid_update_reserved(uint64_t _old_id, uint64_t _new_id) {
+    auto hit = false;
+    for (size_t cpu = 0; cpu < MAX_CPU_COUNT; cpu++) {
+        if (asid_cpus[cpu].reserved == _old_id) {
+            asid_cpus[cpu].reserved = _new_id;
+            hit                     = true;
+        }
+    }
+    return hit;
+}
+
+/**
+ * @brief 为 _as 分配当前代的标签，需要持有 asid_lock
+ */
+static uint64_t asid_new_context(const address_space_t* _as) {
+    auto old        = _as->context_id;
+    auto asid       = old & asid_mask();
+    auto generation = __atomic_load_n(&asid_generation, __ATOMIC_RELAXED);
+    if (asid != 0) {
+        auto id = generation | asid;
+        // 进入新的一代时仍在使用，或者原来的标签在这一代还没有被占用
+        if (asid_update_reserved(old, id) || !asid_test_and_set(asid)) {
+            return id;
+        }
+    }
+    asid = asid_find_free(asid_next);
+    if (asid == asid_count()) {
+        generation = __atomic_add_fetch(&asid_generation, asid_count(),
+                                        __ATOMIC_RELAXED);
+        asid_rollover();
+        asid = asid_find_free(1);
+    }
+    asid_test_and_set(asid);
+    asid_next = asid;
+    return generation | asid;
+}
+
+void mm_init(void) {
+    asid_bits = mmu_asid_bits();
+    if (asid_bits > ASID_MAX_BITS) {
+        asid_bits = ASID_MAX_BITS;
+    }
+    asid_generation = asid_count();
+    asid_next       = 1;
+    asid_test_and_set(0);
+    address_space_init(&kernel_address_space, mmu_read_root());
+    kernel_address_space.context_id = 0;
+    mm_cpu_init();
+    return;
+}
+
+void mm_cpu_init(void) {
+    mmu_cpu_init(asid_bits != 0);
+    this_cpu_write(current_as, &kernel_address_space);
+    return;
+}
+
+void address_space_init(address_space_t* _as, uintptr_t _root) {
+    _as->root       = _root;
+    _as->context_id = 0;
+    return;
+}
+
+void address_space_switch(address_space_t* _as) {
+    if (this_cpu_read(current_as) == _as) {
+        return;
+    }
+    this_cpu_write(current_as, _as);
+    if (asid_bits == 0) {
+        mmu_switch(_as->root, 0, true);
+        return;
+    }
+    // 内核地址空间的标签不会被回收
+    if (_as == &kernel_address_space) {
+        mmu_switch(_as->root, 0, false);
+        return;
+    }
+
+    auto* state  = &asid_cpus[cpu_id()];
+    auto  id     = __atomic_load_n(&_as->context_id, __ATOMIC_RELAXED);
+    auto  active = __atomic_load_n(&state->active, __ATOMIC_RELAXED);
+    // 快速路径: 标签属于当前代，且没有与进入新的一代并发
+    // (active 为 0 说明其它 cpu 正在进入新的一代)
+    if ((active != 0)
+        && (((id ^ __atomic_load_n(&asid_generation, __ATOMIC_RELAXED))
+             >> asid_bits)
+            == 0)
+        && __atomic_compare_exchange_n(&state->active, &active, id, false,
+                                       __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+        mmu_switch(_as->root, id & asid_mask(), false);
+        return;
+    }
+
+    bool flush;
+    {
+        LockGuard<TicketLock> guard(asid_lock);
+        id = _as->context_id;
+        if (((id ^ asid_generation) >> asid_bits) != 0) {
+            id = asid_new_context(_as);
+            __atomic_store_n(&_as->context_id, id, __ATOMIC_RELAXED);
+        }
+        flush                = state->flush_pending;
+        state->flush_pending = false;
+        __atomic_store_n(&state->active, id, __ATOMIC_RELAXED);
+    }
+    if (flush) {
+        mmu_flush_all();
+    }
+    mmu_switch(_as->root, id & asid_mask(), false);
+    return;
+}
+
+address_space_t* address_space_current(void) {
+    return this_cpu_read(current_as);
+}
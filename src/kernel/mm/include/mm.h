@@ -0,0 +1,69 @@
+
+/**
+ * @file mm.h
+ * @brief 地址空间
+ * @author Zone.N (Zone.Niuzh@hotmail.com)
+ * @version 1.0
+ * @date 2026-10-18
+ * @copyright MIT LICENSE
+ * https://github.com/MRNIU/cmake-kernel
+ * @par change log:
+ * <table>
+ * <tr><th>Date<th>Author<th>Description
+ * <tr><td>2026-10-18<td>Zone.N (Zone.Niuzh@hotmail.com)<td>创建文件
+ * </table>
+ */
+
+#ifndef CMAKE_KERNEL_MM_H
+#define CMAKE_KERNEL_MM_H
+
+#include "cstddef"
+#include "cstdint"
+
+/**
+ * @brief 地址空间
+ * 切换时带上标签 (x86_64 的 pcid，riscv64 satp 与 aarch64 ttbr0_el1 的
+ * asid)，不同地址空间的 tlb 可以共存，切换时不需要丢弃
+ */
+struct address_space_t {
+    /// 页表根，不含标签
+    uintptr_t root;
+    /// 高位为分配标签时的代数，低位为标签，0 表示还没有分配
+    uint64_t  context_id;
+};
+
+/// 内核地址空间，使用启动时的页表，标签固定为 0
+extern address_space_t kernel_address_space;
+
+/**
+ * @brief 初始化地址空间管理，由启动 cpu 在 arch 之后调用
+ */
+void             mm_init(void);
+
+/**
+ * @brief 初始化当前 cpu，由每个非启动 cpu 调用
+ */
+void             mm_cpu_init(void);
+
+/**
+ * @brief 初始化地址空间
+ * @param  _as                     地址空间
+ * @param  _root                   页表根，与当前架构的格式一致
+ */
+void             address_space_init(address_space_t* _as, uintptr_t _root);
+
+/**
+ * @brief 切换到 _as，需要关中断
+ * 标签仍属于当前代时直接切换，保留 tlb；
+ * 标签用完时进入新的一代，各 cpu 在下一次分配时丢弃全部 tlb
+ * @param  _as                     地址空间
+ */
+void             address_space_switch(address_space_t* _as);
+
+/**
+ * @brief 当前 cpu 正在使用的地址空间
+ * @return address_space_t*        地址空间
+ */
+address_space_t* address_space_current(void);
+
+#endif /* CMAKE_KERNEL_MM_H */
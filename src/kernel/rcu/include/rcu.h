@@ -0,0 +1,126 @@
+
+/**
+ * @file rcu.h
+ * @brief 读-复制-更新
+ * @author Zone.N (Zone.Niuzh@hotmail.com)
+ * @version 1.0
+ * @date 2026-10-18
+ * @copyright MIT LICENSE
+ * https://github.com/MRNIU/cmake-kernel
+ * @par change log:
+ * <table>
+ * <tr><th>Date<th>Author<th>Description
+ * <tr><td>2026-10-18<td>Zone.N (Zone.Niuzh@hotmail.com)<td>创建文件
+ * </table>
+ */
+
+#ifndef CMAKE_KERNEL_RCU_H
+#define CMAKE_KERNEL_RCU_H
+
+#include "cstddef"
+#include "cstdint"
+
+#include "preempt.h"
+
+/**
+ * @brief 延迟回调
+ * 嵌入到要延迟释放的对象中，由 call_rcu 在宽限期结束后调用
+ */
+struct rcu_head_t {
+    /// 下一个回调
+    rcu_head_t* next;
+    /// 回调函数
+    void (*func)(rcu_head_t* _head);
+};
+
+/**
+ * @brief 进入读端临界区
+ * 读端关闭抢占，只写本 cpu 的计数，上下文切换因此是静止状态
+ */
+static inline void rcu_read_lock(void) {
+    preempt_disable();
+    return;
+}
+
+/**
+ * @brief 退出读端临界区
+ */
+static inline void rcu_read_unlock(void) {
+    preempt_enable();
+    return;
+}
+
+/**
+ * @brief 读取受 rcu 保护的指针
+ * @param  _ptr                    指针的地址
+ * @return T*                      指针的值
+ */
+template <class T>
+inline T* rcu_dereference(T* const& _ptr) {
+    return __atomic_load_n(&_ptr, __ATOMIC_CONSUME);
+}
+
+/**
+ * @brief 发布受 rcu 保护的指针，对象的初始化在发布前可见
+ * @param  _ptr                    指针
+ * @param  _val                    新值
+ */
+template <class T>
+inline void rcu_assign_pointer(T*& _ptr, T* _val) {
+    __atomic_store_n(&_ptr, _val, __ATOMIC_RELEASE);
+    return;
+}
+
+/**
+ * @brief 初始化 rcu，由启动 cpu 调用
+ */
+void rcu_init(void);
+
+/**
+ * @brief 将当前 cpu 加入 rcu，此后的宽限期需要等待它
+ */
+void rcu_cpu_online(void);
+
+/**
+ * @brief 报告当前 cpu 经过了静止状态
+ * 由调度器在上下文切换、时钟中断返回用户态等不在读端临界区的位置调用，
+ * 同时推进宽限期并批量执行已到期的回调
+ */
+void rcu_quiescent_state(void);
+
+/**
+ * @brief 当前 cpu 进入空闲，空闲期间视为一直处于静止状态
+ */
+void rcu_idle_enter(void);
+
+/**
+ * @brief 当前 cpu 退出空闲
+ */
+void rcu_idle_exit(void);
+
+/**
+ * @brief 进入中断处理，空闲的 cpu 在中断处理期间暂时退出空闲，
+ * 使中断处理函数可以使用读端临界区
+ */
+void rcu_irq_enter(void);
+
+/**
+ * @brief 退出中断处理，恢复进入中断前的空闲状态
+ */
+void rcu_irq_exit(void);
+
+/**
+ * @brief 注册回调，在当前所有读端临界区结束后调用
+ * 回调按 cpu 批量处理，多个回调共享同一个宽限期
+ * @param  _head                   回调
+ * @param  _func                   回调函数
+ */
+void call_rcu(rcu_head_t* _head, void (*_func)(rcu_head_t* _head));
+
+/**
+ * @brief 等待一个完整的宽限期
+ * 不能在读端临界区中调用
+ */
+void synchronize_rcu(void);
+
+#endif /* CMAKE_KERNEL_RCU_H */
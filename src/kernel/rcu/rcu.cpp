@@ -0,0 +1,293 @@
+
+/**
+ * @file rcu.cpp
+ * @brief 读-复制-更新
+ * @author Zone.N (Zone.Niuzh@hotmail.com)
+ * @version 1.0
+ * @date 2026-10-18
+ * @copyright MIT LICENSE
+ * https://github.com/MRNIU/cmake-kernel
+ * @par change log:
+ * <table>
+ * <tr><th>Date<th>Author<th>Description
+ * <tr><td>2026-10-18<td>Zone.N (Zone.Niuzh@hotmail.com)<td>创建文件
+ * </table>
+ */
+
+#include "rcu.h"
+#include "cpu.h"
+#include "libcxx.h"
+#include "percpu.h"
+#include "spinlock.hpp"
+
+static_assert(MAX_CPU_COUNT <= 64, "rcu uses a 64-bit cpu mask");
+
+/**
+ * @brief 每个 cpu 的 rcu 数据
+ * 只有所属 cpu 会修改，静止状态的快速路径不访问共享缓存行。
+ * 回调队列可能在中断中被 call_rcu 修改，访问时需要关中断
+ */
+struct alignas(CACHE_LINE_SIZE) rcu_data_t {
+    /// 本 cpu 已报告过静止状态的宽限期
+    uint64_t     gp_seq;
+    /// 是否在线
+    bool         online;
+    /// 是否空闲
+    bool         idle;
+    /// 是否在空闲时进入了中断
+    bool         irq_from_idle;
+    /// 尚未分配宽限期的回调
+    rcu_head_t*  next_head;
+    rcu_head_t** next_tail;
+    /// 等待 wait_seq 对应宽限期结束的回调
+    rcu_head_t*  wait_head;
+    rcu_head_t** wait_tail;
+    uint64_t     wait_seq;
+};
+
+/**
+ * @brief 全局宽限期状态
+ * gp_seq 为奇数时表示宽限期正在进行，每个宽限期使其增加 2
+ */
+struct alignas(CACHE_LINE_SIZE) rcu_state_t {
+    /// 当前宽限期序号
+    uint64_t   gp_seq;
+    /// 需要完成到的宽限期序号
+    uint64_t   gp_seq_needed;
+    /// 本宽限期中尚未报告静止状态的 cpu
+    uint64_t   qs_mask;
+    /// 保护以上字段，每个 cpu 每个宽限期最多获取一次。
+    /// 中断返回时的调度也会获取，需要关中断
+    TicketLock lock;
+};
+
+static rcu_state_t rcu_state;
+static DEFINE_PER_CPU(rcu_data_t, rcu_data);
+
+/**
+ * @brief 从现在开始的一个完整宽限期结束时 gp_seq 的值
+ * 如果宽限期正在进行，它开始时可能已有读者，需要等待下一个
+ */
+static uint64_t rcu_seq_snap(void) {
+    auto seq = __atomic_load_n(&rcu_state.gp_seq, __ATOMIC_ACQUIRE);
+    return (seq + 3) & ~static_cast<uint64_t>(1);
+}
+
+static bool rcu_seq_done(uint64_t _snap) {
+    auto seq = __atomic_load_n(&rcu_state.gp_seq, __ATOMIC_ACQUIRE);
+    return static_cast<int64_t>(seq - _snap) >= 0;
+}
+
+static void rcu_end_gp(void);
+
+/**
+ * @brief 开始新的宽限期，需要持有 rcu_state.lock
+ */
+static void rcu_start_gp(void) {
+    auto seq = rcu_state.gp_seq + 1;
+    // 先发布新的序号再检查空闲标记，与 rcu_idle_enter 的顺序相反，
+    // 保证空闲的 cpu 要么被跳过，要么看到新的宽限期并自行报告
+    __atomic_store_n(&rcu_state.gp_seq, seq, __ATOMIC_SEQ_CST);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    uint64_t mask = 0;
+    for (size_t i = 0; i < MAX_CPU_COUNT; i++) {
+        auto* rdp = per_cpu_ptr(&rcu_data, i);
+        if (rdp->online && !__atomic_load_n(&rdp->idle, __ATOMIC_SEQ_CST)) {
+            mask |= static_cast<uint64_t>(1) << i;
+        }
+    }
+    rcu_state.qs_mask = mask;
+    if (mask == 0) {
+        rcu_end_gp();
+    }
+    return;
+}
+
+/**
+ * @brief 结束当前宽限期，需要持有 rcu_state.lock
+ */
+static void rcu_end_gp(void) {
+    auto seq = rcu_state.gp_seq + 1;
+    __atomic_store_n(&rcu_state.gp_seq, seq, __ATOMIC_RELEASE);
+    if (static_cast<int64_t>(rcu_state.gp_seq_needed - seq) > 0) {
+        rcu_start_gp();
+    }
+    return;
+}
+
+/**
+ * @brief 请求宽限期完成到 _snap
+ * @param  _snap                   rcu_seq_snap 的返回值
+ */
+static void rcu_request_gp(uint64_t _snap) {
+    IrqLockGuard<TicketLock> guard(rcu_state.lock);
+    if (static_cast<int64_t>(_snap - rcu_state.gp_seq_needed) > 0) {
+        rcu_state.gp_seq_needed = _snap;
+    }
+    if ((rcu_state.gp_seq & 1) == 0
+        && static_cast<int64_t>(rcu_state.gp_seq_needed - rcu_state.gp_seq)
+             > 0) {
+        rcu_start_gp();
+    }
+    return;
+}
+
+/**
+ * @brief 报告 _cpu 经过了静止状态
+ * @param  _cpu                    cpu 编号
+ */
+static void rcu_report_qs(size_t _cpu) {
+    // 之前的读端访问必须在报告前完成
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    IrqLockGuard<TicketLock> guard(rcu_state.lock);
+    auto& rdp = *per_cpu_ptr(&rcu_data, _cpu);
+    auto  seq = rcu_state.gp_seq;
+    if ((seq & 1) == 0 || rdp.gp_seq == seq) {
+        return;
+    }
+    rdp.gp_seq = seq;
+    auto bit   = static_cast<uint64_t>(1) << _cpu;
+    // 宽限期开始时处于空闲的 cpu 不在 qs_mask 中
+    if ((rcu_state.qs_mask & bit) != 0) {
+        rcu_state.qs_mask &= ~bit;
+        if (rcu_state.qs_mask == 0) {
+            rcu_end_gp();
+        }
+    }
+    return;
+}
+
+/**
+ * @brief 执行到期的回调，为新回调分配宽限期
+ * @param  _rdp                    当前 cpu 的数据
+ */
+static void rcu_advance_cbs(rcu_data_t& _rdp) {
+    if ((_rdp.wait_head != nullptr) && rcu_seq_done(_rdp.wait_seq)) {
+        auto* head     = _rdp.wait_head;
+        _rdp.wait_head = nullptr;
+        _rdp.wait_tail = &_rdp.wait_head;
+        while (head != nullptr) {
+            auto* next = head->next;
+            head->func(head);
+            head = next;
+        }
+    }
+    if (_rdp.next_head == nullptr) {
+        return;
+    }
+    auto snap = rcu_seq_snap();
+    // 与正在等待的回调需要同一个宽限期时合并为一批
+    if ((_rdp.wait_head == nullptr) || (_rdp.wait_seq == snap)) {
+        *_rdp.wait_tail = _rdp.next_head;
+        _rdp.wait_tail  = _rdp.next_tail;
+        _rdp.wait_seq   = snap;
+        _rdp.next_head  = nullptr;
+        _rdp.next_tail  = &_rdp.next_head;
+        rcu_request_gp(snap);
+    }
+    return;
+}
+
+void rcu_init(void) {
+    for (size_t i = 0; i < MAX_CPU_COUNT; i++) {
+        auto& rdp         = *per_cpu_ptr(&rcu_data, i);
+        rdp.gp_seq        = 0;
+        rdp.online        = false;
+        rdp.idle          = false;
+        rdp.irq_from_idle = false;
+        rdp.next_head     = nullptr;
+        rdp.next_tail     = &rdp.next_head;
+        rdp.wait_head     = nullptr;
+        rdp.wait_tail     = &rdp.wait_head;
+        rdp.wait_seq      = 0;
+    }
+    rcu_state.gp_seq        = 0;
+    rcu_state.gp_seq_needed = 0;
+    rcu_state.qs_mask       = 0;
+    rcu_cpu_online();
+    return;
+}
+
+void rcu_cpu_online(void) {
+    IrqLockGuard<TicketLock> guard(rcu_state.lock);
+    auto&                    rdp = *this_cpu_ptr(&rcu_data);
+    // 正在进行的宽限期开始时本 cpu 还没有读者，不需要等待
+    rdp.gp_seq = rcu_state.gp_seq;
+    rdp.online = true;
+    return;
+}
+
+void rcu_quiescent_state(void) {
+    // 关中断后再取本 cpu 的数据，否则报告时可能已被迁移到其它 cpu
+    auto  flags = cpu_irq_save();
+    auto  cpu   = cpu_id();
+    auto& rdp   = *this_cpu_ptr(&rcu_data);
+    auto  seq   = __atomic_load_n(&rcu_state.gp_seq, __ATOMIC_ACQUIRE);
+    if (((seq & 1) != 0) && (rdp.gp_seq != seq)) {
+        rcu_report_qs(cpu);
+    }
+    if ((rdp.wait_head != nullptr) || (rdp.next_head != nullptr)) {
+        rcu_advance_cbs(rdp);
+    }
+    cpu_irq_restore(flags);
+    return;
+}
+
+void rcu_idle_enter(void) {
+    auto* rdp = this_cpu_ptr(&rcu_data);
+    __atomic_store_n(&rdp->idle, true, __ATOMIC_SEQ_CST);
+    // 可能已被计入正在进行的宽限期，此时需要自行报告
+    auto seq = __atomic_load_n(&rcu_state.gp_seq, __ATOMIC_SEQ_CST);
+    if (((seq & 1) != 0) && (rdp->gp_seq != seq)) {
+        rcu_report_qs(cpu_id());
+    }
+    return;
+}
+
+void rcu_idle_exit(void) {
+    auto* rdp = this_cpu_ptr(&rcu_data);
+    __atomic_store_n(&rdp->idle, false, __ATOMIC_SEQ_CST);
+    // 之后的读端访问不能早于清除空闲标记
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    return;
+}
+
+void rcu_irq_enter(void) {
+    auto* rdp = this_cpu_ptr(&rcu_data);
+    if (rdp->idle) {
+        rdp->irq_from_idle = true;
+        rcu_idle_exit();
+    }
+    return;
+}
+
+void rcu_irq_exit(void) {
+    auto* rdp = this_cpu_ptr(&rcu_data);
+    if (rdp->irq_from_idle) {
+        rdp->irq_from_idle = false;
+        rcu_idle_enter();
+    }
+    return;
+}
+
+void call_rcu(rcu_head_t* _head, void (*_func)(rcu_head_t* _head)) {
+    auto  flags    = cpu_irq_save();
+    auto& rdp      = *this_cpu_ptr(&rcu_data);
+    _head->next    = nullptr;
+    _head->func    = _func;
+    *rdp.next_tail = _head;
+    rdp.next_tail  = &_head->next;
+    cpu_irq_restore(flags);
+    return;
+}
+
+void synchronize_rcu(void) {
+    auto snap = rcu_seq_snap();
+    rcu_request_gp(snap);
+    while (!rcu_seq_done(snap)) {
+        // 调用者不在读端临界区中，本 cpu 处于静止状态
+        rcu_quiescent_state();
+        cpu_relax();
+    }
+    return;
+}
@@ -0,0 +1,284 @@
+
+/**
+ * @file bench.cpp
+ * @brief 调度器性能测量
+ * @author Zone.N (Zone.Niuzh@hotmail.com)
+ * @version 1.0
+ * @date 2026-10-18
+ * @copyright MIT LICENSE
+ * https://github.com/MRNIU/cmake-kernel
+ * @par change log:
+ * <table>
+ * <tr><th>Date<th>Author<th>Description
+ * <tr><td>2026-10-18<td>Zone.N (Zone.Niuzh@hotmail.com)<td>创建文件
+ * </table>
+ */
+
+#include "cpu.h"
+#include "ktime.h"
+#include "mutex.h"
+#include "percpu.h"
+#include "sched.h"
+#include "smp.h"
+
+/**
+ * @brief 两个线程交替运行的共享状态
+ */
+struct pingpong_t {
+    /// 两个线程
+    task_t* tasks[2];
+    /// 轮到运行的线程
+    size_t  turn;
+    /// 每个线程的轮数
+    size_t  iterations;
+    /// 已完成的线程数
+    size_t  done;
+};
+
+/**
+ * @brief 多线程吞吐测量的共享状态
+ */
+struct throughput_t {
+    /// 每个线程让出 cpu 的次数
+    size_t iterations;
+    /// 已完成的线程数
+    size_t done;
+};
+
+/**
+ * @brief 互斥锁移交测量的共享状态
+ */
+struct handoff_t {
+    Mutex    mutex;
+    task_t*  tasks[2];
+    size_t   iterations;
+    /// 正在等待加锁的线程
+    bool     waiting[2];
+    /// 最近一次解锁的线程与时间
+    size_t   last_owner;
+    uint64_t last_unlock;
+    /// 线程间移交的总纳秒数与次数
+    uint64_t total;
+    size_t   handoffs;
+    size_t   done;
+};
+
+/**
+ * @brief 互斥锁竞争测量的共享状态
+ */
+struct contention_t {
+    Mutex    mutex;
+    size_t   iterations;
+    /// 受锁保护的计数，用于检查互斥
+    uint64_t counter;
+    size_t   done;
+};
+
+/**
+ * @brief 等待 _done 达到 _count，期间让出 cpu
+ */
+static void bench_wait(const size_t* _done, size_t _count) {
+    while (__atomic_load_n(_done, __ATOMIC_ACQUIRE) < _count) {
+        yield();
+        cpu_relax();
+    }
+    return;
+}
+
+static void pingpong_thread(void* _arg) {
+    auto*  bench = static_cast<pingpong_t*>(_arg);
+    size_t self  = bench->tasks[0] == current_task() ? 0 : 1;
+    for (size_t i = 0; i < bench->iterations; i++) {
+        while (true) {
+            set_current_state(TASK_BLOCKED);
+            if (__atomic_load_n(&bench->turn, __ATOMIC_ACQUIRE) == self) {
+                break;
+            }
+            schedule();
+        }
+        set_current_state(TASK_RUNNING);
+        __atomic_store_n(&bench->turn, 1 - self, __ATOMIC_RELEASE);
+        task_wakeup(bench->tasks[1 - self]);
+    }
+    __atomic_fetch_add(&bench->done, 1, __ATOMIC_RELEASE);
+    return;
+}
+
+uint64_t sched_bench_switch(size_t _iterations) {
+    if (_iterations == 0) {
+        return 0;
+    }
+    pingpong_t bench;
+    bench.turn       = 0;
+    bench.iterations = _iterations;
+    bench.done       = 0;
+    bench.tasks[0]   = kthread_create(pingpong_thread, &bench, "ping");
+    bench.tasks[1]   = kthread_create(pingpong_thread, &bench, "pong");
+    if ((bench.tasks[0] == nullptr) || (bench.tasks[1] == nullptr)) {
+        // 未启动的线程直接唤醒，turn 不会轮到它之外的线程
+        bench.iterations = 0;
+        for (auto* task : bench.tasks) {
+            if (task != nullptr) {
+                task_wakeup(task);
+            }
+        }
+        bench_wait(&bench.done,
+                   (bench.tasks[0] != nullptr) + (bench.tasks[1] != nullptr));
+        return 0;
+    }
+    // 绑定到同一个 cpu，每次唤醒都是一次完整的切换
+    auto cpu = cpu_id();
+    kthread_bind(bench.tasks[0], cpu);
+    kthread_bind(bench.tasks[1], cpu);
+    auto start = ktime_get_ns();
+    task_wakeup(bench.tasks[0]);
+    task_wakeup(bench.tasks[1]);
+    bench_wait(&bench.done, 2);
+    auto end = ktime_get_ns();
+    return (end - start) / (2 * _iterations);
+}
+
+static void throughput_thread(void* _arg) {
+    auto*             bench = static_cast<throughput_t*>(_arg);
+    volatile uint64_t sum   = 0;
+    for (size_t i = 0; i < bench->iterations; i++) {
+        // 少量计算，模拟两次让出之间的工作
+        for (size_t j = 0; j < 64; j++) {
+            sum = sum + j;
+        }
+        yield();
+    }
+    __atomic_fetch_add(&bench->done, 1, __ATOMIC_RELEASE);
+    return;
+}
+
+uint64_t sched_bench_throughput(size_t _threads, size_t _iterations) {
+    if ((_threads == 0) || (_threads > TASK_MAX)) {
+        return 0;
+    }
+    throughput_t bench;
+    bench.iterations = _iterations;
+    bench.done       = 0;
+    size_t created   = 0;
+    auto   start     = ktime_get_ns();
+    for (size_t i = 0; i < _threads; i++) {
+        if (kthread_run(throughput_thread, &bench, "throughput") == nullptr) {
+            break;
+        }
+        created++;
+    }
+    bench_wait(&bench.done, created);
+    auto end = ktime_get_ns();
+    return created == _threads ? end - start : 0;
+}
+
+/// 移交测量中持有者等待另一个线程开始加锁的最长时间
+static constexpr const uint64_t HANDOFF_WAIT_NS = 100000;
+
+static void handoff_thread(void* _arg) {
+    auto*  bench = static_cast<handoff_t*>(_arg);
+    size_t self  = bench->tasks[0] == current_task() ? 0 : 1;
+    for (size_t i = 0; i < bench->iterations; i++) {
+        __atomic_store_n(&bench->waiting[self], true, __ATOMIC_RELAXED);
+        bench->mutex.lock();
+        auto now = ktime_get_ns();
+        __atomic_store_n(&bench->waiting[self], false, __ATOMIC_RELAXED);
+        if ((bench->last_owner != self) && (bench->last_unlock != 0)) {
+            bench->total += now - bench->last_unlock;
+            bench->handoffs++;
+        }
+        // 等另一个线程开始加锁 (自旋或睡眠)，使解锁成为一次移交
+        while (!__atomic_load_n(&bench->waiting[1 - self], __ATOMIC_RELAXED)
+               && (ktime_get_ns() - now < HANDOFF_WAIT_NS)) {
+            cpu_relax();
+        }
+        bench->last_owner  = self;
+        bench->last_unlock = ktime_get_ns();
+        bench->mutex.unlock();
+    }
+    __atomic_store_n(&bench->waiting[self], true, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&bench->done, 1, __ATOMIC_RELEASE);
+    return;
+}
+
+uint64_t mutex_bench_handoff(size_t _iterations) {
+    if (_iterations == 0) {
+        return 0;
+    }
+    handoff_t bench;
+    bench.iterations  = _iterations;
+    bench.waiting[0]  = false;
+    bench.waiting[1]  = false;
+    bench.last_owner  = 2;
+    bench.last_unlock = 0;
+    bench.total       = 0;
+    bench.handoffs    = 0;
+    bench.done        = 0;
+    bench.tasks[0]    = kthread_create(handoff_thread, &bench, "handoff");
+    bench.tasks[1]    = kthread_create(handoff_thread, &bench, "handoff");
+    if ((bench.tasks[0] == nullptr) || (bench.tasks[1] == nullptr)) {
+        // 未启动的线程直接以 0 次迭代启动，使已创建的任务退出
+        bench.iterations = 0;
+        for (auto* task : bench.tasks) {
+            if (task != nullptr) {
+                task_wakeup(task);
+            }
+        }
+        bench_wait(&bench.done,
+                   (bench.tasks[0] != nullptr) + (bench.tasks[1] != nullptr));
+        return 0;
+    }
+    // 有多个 cpu 时分开运行，持有者运行时另一个线程可以自旋
+    if (smp_cpu_count() > 1) {
+        kthread_bind(bench.tasks[0], 0);
+        kthread_bind(bench.tasks[1], 1);
+    }
+    task_wakeup(bench.tasks[0]);
+    task_wakeup(bench.tasks[1]);
+    bench_wait(&bench.done, 2);
+    return bench.handoffs == 0 ? 0 : bench.total / bench.handoffs;
+}
+
+static void contention_thread(void* _arg) {
+    auto*             bench = static_cast<contention_t*>(_arg);
+    volatile uint64_t sum   = 0;
+    for (size_t i = 0; i < bench->iterations; i++) {
+        bench->mutex.lock();
+        bench->counter++;
+        for (size_t j = 0; j < 16; j++) {
+            sum = sum + j;
+        }
+        bench->mutex.unlock();
+        // 锁外的工作
+        for (size_t j = 0; j < 64; j++) {
+            sum = sum + j;
+        }
+    }
+    __atomic_fetch_add(&bench->done, 1, __ATOMIC_RELEASE);
+    return;
+}
+
+uint64_t mutex_bench_throughput(size_t _threads, size_t _iterations) {
+    if ((_threads == 0) || (_threads > TASK_MAX)) {
+        return 0;
+    }
+    contention_t bench;
+    bench.iterations = _iterations;
+    bench.counter    = 0;
+    bench.done       = 0;
+    size_t created   = 0;
+    auto   start     = ktime_get_ns();
+    for (size_t i = 0; i < _threads; i++) {
+        if (kthread_run(contention_thread, &bench, "contention") == nullptr) {
+            break;
+        }
+        created++;
+    }
+    bench_wait(&bench.done, created);
+    auto end = ktime_get_ns();
+    // 计数不等说明互斥失效
+    if ((created != _threads) || (bench.counter != _threads * _iterations)) {
+        return 0;
+    }
+    return end - start;
+}
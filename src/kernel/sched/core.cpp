@@ -0,0 +1,644 @@
+
+/**
+ * @file core.cpp
+ * @brief 调度器核心
+ * @author Zone.N (Zone.Niuzh@hotmail.com)
+ * @version 1.0
+ * @date 2026-10-18
+ * @copyright MIT LICENSE
+ * https://github.com/MRNIU/cmake-kernel
+ * @par change log:
+ * <table>
+ * <tr><th>Date<th>Author<th>Description
+ * <tr><td>2026-10-18<td>Zone.N (Zone.Niuzh@hotmail.com)<td>创建文件
+ * </table>
+ */
+
+#include "context.h"
+#include "cpu.h"
+#include "fpu.h"
+#include "interrupt.h"
+#include "ktime.h"
+#include "libcxx.h"
+#include "mm.h"
+#include "percpu.h"
+#include "rcu.h"
+#include "runqueue.h"
+#include "sched.h"
+#include "smp.h"
+#include "spinlock.hpp"
+#include "timer.h"
+
+// 每个 cpu 一个运行队列，各自加锁，切换时只访问本 cpu 的队列。
+// 切换前获取的锁由切换后的任务在 finish_switch 中释放，
+// 因此持有某个运行队列的锁时，不在运行的任务一定已经完整保存了上下文。
+// 任务只在唤醒时选择 cpu，优先回到上次运行的 cpu 以利用缓存；
+// cpu 空闲时从最忙的 cpu 偷取任务，不做周期性的负载均衡。
+// 截止时间调度的任务在准入时绑定到一个 cpu (分区 EDF)，不参与迁移
+
+static_assert(MAX_CPU_COUNT <= 64, "cpus_allowed is a 64-bit mask");
+
+rq_t runqueues[MAX_CPU_COUNT];
+
+DEFINE_PER_CPU(uint32_t, preempt_count);
+/// 当前任务
+static DEFINE_PER_CPU(task_t*, cpu_curr);
+
+/// 按优先级排列的调度类
+static const sched_class_t* const sched_classes[] = {
+    &dl_sched_class,
+    &fair_sched_class,
+};
+
+static_assert(sizeof(sched_classes) / sizeof(sched_classes[0])
+                == SCHED_CLASS_NR,
+              "sched_classes must match SCHED_CLASS_NR");
+
+/// 空闲任务，使用各 cpu 的启动栈
+static task_t idle_tasks[MAX_CPU_COUNT];
+
+/// 任务池
+static task_t tasks[TASK_MAX];
+/// 任务栈
+alignas(16) static uint8_t task_stacks[TASK_MAX][TASK_STACK_SIZE];
+/// 空闲的任务
+static IntrusiveList<task_t, &task_t::node> free_tasks;
+/// 保护 free_tasks
+static TicketLock free_lock;
+
+void update_rq_clock(rq_t* _rq) {
+    auto now = ktime_get_ns();
+    if (static_cast<int64_t>(now - _rq->clock) > 0) {
+        _rq->clock = now;
+    }
+    return;
+}
+
+bool cpu_active(size_t _cpu) {
+    return smp_cpu_is_online(_cpu)
+           && (__atomic_load_n(&cpu_rq(_cpu)->idle, __ATOMIC_ACQUIRE)
+               != nullptr);
+}
+
+static bool rq_is_idle(const rq_t* _rq) {
+    return __atomic_load_n(&_rq->nr_running, __ATOMIC_RELAXED) == 0;
+}
+
+static bool cache_hot(const task_t* _task) {
+    return (_task->last_ran != 0)
+           && (ktime_get_ns() - _task->last_ran < SCHED_MIGRATION_COST_NS);
+}
+
+rq_t* task_rq_lock(task_t* _task) {
+    while (true) {
+        auto  cpu = __atomic_load_n(&_task->cpu, __ATOMIC_ACQUIRE);
+        auto* rq  = cpu_rq(cpu);
+        rq->lock.lock();
+        if (__atomic_load_n(&_task->cpu, __ATOMIC_RELAXED) == cpu) {
+            return rq;
+        }
+        rq->lock.unlock();
+    }
+}
+
+/**
+ * @brief 按 cpu 编号顺序锁定两个运行队列，避免死锁
+ */
+static void double_rq_lock(rq_t* _a, rq_t* _b) {
+    if (_a->cpu < _b->cpu) {
+        _a->lock.lock();
+        _b->lock.lock();
+    }
+    else {
+        _b->lock.lock();
+        _a->lock.lock();
+    }
+    return;
+}
+
+static void activate_task(rq_t* _rq, task_t* _task, uint32_t _flags) {
+    if ((_flags & (ENQUEUE_WAKEUP | ENQUEUE_NEW)) != 0) {
+        _task->wake_ts = _rq->clock;
+    }
+    _task->on_rq = true;
+    __atomic_store_n(&_rq->nr_running, _rq->nr_running + 1, __ATOMIC_RELAXED);
+    _task->sched_class->enqueue(_rq, _task, _flags);
+    return;
+}
+
+static void deactivate_task(rq_t* _rq, task_t* _task, uint32_t _flags) {
+    _task->on_rq = false;
+    __atomic_store_n(&_rq->nr_running, _rq->nr_running - 1, __ATOMIC_RELAXED);
+    _task->sched_class->dequeue(_rq, _task, _flags);
+    return;
+}
+
+void check_preempt_curr(rq_t* _rq, task_t* _task) {
+    auto* curr = _rq->curr;
+    if (curr == _rq->idle) {
+        resched_curr(_rq);
+    }
+    else if (_task->sched_class == curr->sched_class) {
+        if (_task->sched_class->check_preempt(_rq, _task)) {
+            resched_curr(_rq);
+        }
+    }
+    else if (_task->sched_class->rank < curr->sched_class->rank) {
+        resched_curr(_rq);
+    }
+    return;
+}
+
+/**
+ * @brief 选择唤醒 _task 的 cpu
+ * 依次考虑上次运行的 cpu、当前 cpu 与其它空闲的 cpu，
+ * 都不空闲时缓存热的任务留在原 cpu，否则选任务最少的 cpu
+ */
+static size_t select_cpu(task_t* _task) {
+    auto allowed = [_task](size_t _cpu) {
+        return ((_task->cpus_allowed >> _cpu) & 1) != 0 && cpu_active(_cpu);
+    };
+    auto prev = _task->cpu;
+    if (allowed(prev) && rq_is_idle(cpu_rq(prev))) {
+        return prev;
+    }
+    auto self = cpu_id();
+    if (allowed(self) && rq_is_idle(cpu_rq(self))) {
+        return self;
+    }
+    size_t best    = MAX_CPU_COUNT;
+    size_t best_nr = SIZE_MAX;
+    for (size_t cpu = 0; cpu < MAX_CPU_COUNT; cpu++) {
+        if (!allowed(cpu)) {
+            continue;
+        }
+        auto nr = __atomic_load_n(&cpu_rq(cpu)->nr_running, __ATOMIC_RELAXED);
+        if (nr == 0) {
+            return cpu;
+        }
+        if (nr < best_nr) {
+            best    = cpu;
+            best_nr = nr;
+        }
+    }
+    if (allowed(prev)
+        && (cache_hot(_task)
+            || (__atomic_load_n(&cpu_rq(prev)->nr_running, __ATOMIC_RELAXED)
+                <= best_nr))) {
+        return prev;
+    }
+    // 没有允许的 cpu 在线时留在原处
+    return best == MAX_CPU_COUNT ? prev : best;
+}
+
+/**
+ * @brief 选出下一个任务，所有调度类都没有任务时运行空闲任务
+ */
+static task_t* pick_next_task(rq_t* _rq) {
+    for (auto* sched_class : sched_classes) {
+        auto* task = sched_class->pick_next(_rq);
+        if (task != nullptr) {
+            return task;
+        }
+    }
+    return _rq->idle;
+}
+
+/**
+ * @brief 按当前任务的调度类设置周期时钟，已设置的更早时不修改
+ */
+static void arm_tick(rq_t* _rq) {
+    auto* curr    = _rq->curr;
+    auto  expires = _rq->clock + curr->sched_class->next_tick(_rq, curr);
+    if (!timer_pending(&_rq->tick)
+        || (static_cast<int64_t>(expires - _rq->tick.expires) < 0)) {
+        timer_add(&_rq->tick, expires);
+    }
+    return;
+}
+
+/**
+ * @brief 唤醒延迟计入直方图
+ */
+static void account_latency(rq_t* _rq, task_t* _task) {
+    auto   delay  = _rq->clock - _task->wake_ts;
+    auto   us     = delay / 1000;
+    size_t bucket = us == 0 ? 0 : 64 - __builtin_clzll(us);
+    if (bucket >= SCHED_LATENCY_BUCKETS) {
+        bucket = SCHED_LATENCY_BUCKETS - 1;
+    }
+    auto rank = _task->sched_class->rank;
+    _rq->latency[rank][bucket]++;
+    if (delay > _rq->latency_max[rank]) {
+        _rq->latency_max[rank] = delay;
+    }
+    _task->wake_ts = 0;
+    return;
+}
+
+/**
+ * @brief 周期时钟，只在有任务运行时启动
+ */
+static void sched_tick(ktimer_t* _timer) {
+    (void)_timer;
+    auto*                 rq = this_rq();
+    LockGuard<TicketLock> guard(rq->lock);
+    update_rq_clock(rq);
+    auto* curr = rq->curr;
+    if (curr == rq->idle) {
+        return;
+    }
+    curr->sched_class->tick(rq, curr);
+    arm_tick(rq);
+    return;
+}
+
+/**
+ * @brief 切换完成后由新任务调用，释放切换前获取的锁
+ */
+static void finish_switch(void) {
+    auto* rq   = this_rq();
+    auto* prev = rq->prev;
+    auto  dead = prev->state == TASK_DEAD;
+    prev->last_ran = rq->clock;
+    __atomic_store_n(&prev->on_cpu, false, __ATOMIC_RELEASE);
+    rq->lock.unlock();
+    if (dead) {
+        if (prev->sched_class->task_dead != nullptr) {
+            prev->sched_class->task_dead(prev);
+        }
+        LockGuard<TicketLock> guard(free_lock);
+        free_tasks.push_back(*prev);
+    }
+    return;
+}
+
+/**
+ * @brief 新任务的入口
+ */
+static void task_start(void* _task) {
+    auto* task = static_cast<task_t*>(_task);
+    finish_switch();
+    cpu_irq_enable();
+    task->func(task->arg);
+    kthread_exit();
+}
+
+void schedule(void) {
+    auto flags = cpu_irq_save();
+    // 不在读端临界区中，上下文切换是静止状态。
+    // 关中断后报告，报告的是即将切换出去的 cpu
+    rcu_quiescent_state();
+
+    auto* rq = this_rq();
+    rq->lock.lock();
+    __atomic_fetch_and(this_cpu_ptr(&sched_flags), ~SCHED_NEED_RESCHED,
+                       __ATOMIC_RELAXED);
+    update_rq_clock(rq);
+
+    auto* prev = rq->curr;
+    if (prev != rq->idle) {
+        prev->sched_class->update_curr(rq);
+        if (prev->state != TASK_RUNNING) {
+            deactivate_task(rq, prev, DEQUEUE_SLEEP);
+        }
+        prev->sched_class->put_prev(rq, prev);
+    }
+
+    auto* next = pick_next_task(rq);
+    if (next == prev) {
+        rq->lock.unlock();
+        cpu_irq_restore(flags);
+        return;
+    }
+
+    next->on_cpu     = true;
+    next->exec_start = rq->clock;
+    rq->curr         = next;
+    rq->prev         = prev;
+    rq->nr_switches++;
+    prev->nr_switches++;
+    this_cpu_write(cpu_curr, next);
+    if (next != rq->idle) {
+        if (next->wake_ts != 0) {
+            account_latency(rq, next);
+        }
+        arm_tick(rq);
+    }
+    // 内核线程不访问用户地址，沿用当前的地址空间，避免切换页表
+    if (next->mm != nullptr) {
+        address_space_switch(next->mm);
+    }
+    // 只在 prev 启用过浮点/向量寄存器时保存
+    fpu_switch(&next->fpu);
+    context_switch(&prev->sp, next->sp);
+    // 再次被选中后从这里继续，可能已在其它 cpu 上
+    finish_switch();
+    cpu_irq_restore(flags);
+    return;
+}
+
+void preempt_schedule(void) {
+    if (!cpu_irq_enabled() || in_interrupt()) {
+        return;
+    }
+    schedule();
+    return;
+}
+
+void sched_irq_exit(const trap_frame_t* _frame) {
+    if (!need_resched() || (this_cpu_read(preempt_count) != 0)
+        || !trap_irq_enabled(_frame)) {
+        return;
+    }
+    // 空闲任务自己检查标记，在这里切换会使它在 rcu 空闲状态下被切走
+    if (this_cpu_read(cpu_curr) == this_rq()->idle) {
+        return;
+    }
+    schedule();
+    return;
+}
+
+void yield(void) {
+    auto  flags = cpu_irq_save();
+    auto* rq    = this_rq();
+    rq->lock.lock();
+    if (rq->curr != rq->idle) {
+        update_rq_clock(rq);
+        rq->curr->sched_class->yield(rq);
+    }
+    rq->lock.unlock();
+    cpu_irq_restore(flags);
+    schedule();
+    return;
+}
+
+task_t* current_task(void) {
+    auto  flags = cpu_irq_save();
+    auto* task  = this_cpu_read(cpu_curr);
+    cpu_irq_restore(flags);
+    return task;
+}
+
+void set_current_state(uint32_t _state) {
+    __atomic_store_n(&current_task()->state, _state, __ATOMIC_RELAXED);
+    // 与唤醒者的条件写入构成先写后读
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    return;
+}
+
+bool task_wakeup(task_t* _task) {
+    auto  flags = cpu_irq_save();
+    auto* rq    = task_rq_lock(_task);
+    auto  state = _task->state;
+    if ((state != TASK_BLOCKED) && (state != TASK_NEW)) {
+        rq->lock.unlock();
+        cpu_irq_restore(flags);
+        return false;
+    }
+    // 还没有切换出去，只需要改回可运行
+    if (_task->on_rq) {
+        _task->state = TASK_RUNNING;
+        rq->lock.unlock();
+        cpu_irq_restore(flags);
+        return true;
+    }
+    uint32_t enqueue_flags = state == TASK_NEW ? ENQUEUE_NEW : ENQUEUE_WAKEUP;
+    auto     cpu           = select_cpu(_task);
+    if (cpu != rq->cpu) {
+        // 等待的任务不在任何队列中，WAKING 状态阻止其它唤醒者
+        _task->state = TASK_WAKING;
+        _task->sched_class->migrate(rq, _task);
+        __atomic_store_n(&_task->cpu, cpu, __ATOMIC_RELEASE);
+        rq->lock.unlock();
+        rq = cpu_rq(cpu);
+        rq->lock.lock();
+        enqueue_flags |= ENQUEUE_MIGRATED;
+    }
+    update_rq_clock(rq);
+    _task->state = TASK_RUNNING;
+    activate_task(rq, _task, enqueue_flags);
+    check_preempt_curr(rq, _task);
+    rq->lock.unlock();
+    cpu_irq_restore(flags);
+    return true;
+}
+
+void task_set_nice(task_t* _task, int32_t _nice) {
+    if (_nice < NICE_MIN) {
+        _nice = NICE_MIN;
+    }
+    if (_nice > NICE_MAX) {
+        _nice = NICE_MAX;
+    }
+    auto  flags  = cpu_irq_save();
+    auto* rq     = task_rq_lock(_task);
+    auto  queued = _task->on_rq;
+    update_rq_clock(rq);
+    if (queued) {
+        _task->sched_class->dequeue(rq, _task, 0);
+    }
+    _task->nice   = _nice;
+    _task->weight = fair_nice_to_weight(_nice);
+    if (queued) {
+        _task->sched_class->enqueue(rq, _task, 0);
+    }
+    rq->lock.unlock();
+    cpu_irq_restore(flags);
+    return;
+}
+
+void sched_get_stats(sched_stats_t* _stats) {
+    *_stats = sched_stats_t{};
+    for (size_t cpu = 0; cpu < MAX_CPU_COUNT; cpu++) {
+        auto*                    rq = cpu_rq(cpu);
+        IrqLockGuard<TicketLock> guard(rq->lock);
+        for (size_t rank = 0; rank < SCHED_CLASS_NR; rank++) {
+            for (size_t i = 0; i < SCHED_LATENCY_BUCKETS; i++) {
+                _stats->latency[rank][i] += rq->latency[rank][i];
+            }
+            if (rq->latency_max[rank] > _stats->latency_max[rank]) {
+                _stats->latency_max[rank] = rq->latency_max[rank];
+            }
+        }
+        _stats->dl_misses   += rq->dl_misses;
+        _stats->dl_overruns += rq->dl_overruns;
+    }
+    return;
+}
+
+bool sched_idle_steal(void) {
+    auto   self    = cpu_id();
+    size_t busiest = MAX_CPU_COUNT;
+    // 至少有一个任务在等待运行
+    size_t max_nr  = 1;
+    for (size_t cpu = 0; cpu < MAX_CPU_COUNT; cpu++) {
+        if ((cpu == self) || !cpu_active(cpu)) {
+            continue;
+        }
+        auto nr = __atomic_load_n(&cpu_rq(cpu)->nr_running, __ATOMIC_RELAXED);
+        if (nr > max_nr) {
+            busiest = cpu;
+            max_nr  = nr;
+        }
+    }
+    if (busiest == MAX_CPU_COUNT) {
+        return false;
+    }
+
+    auto  flags = cpu_irq_save();
+    auto* dst   = cpu_rq(self);
+    auto* src   = cpu_rq(busiest);
+    double_rq_lock(dst, src);
+    update_rq_clock(src);
+    update_rq_clock(dst);
+    task_t* task = nullptr;
+    if (src->nr_running > 1) {
+        for (auto* sched_class : sched_classes) {
+            task = sched_class->steal(src, self);
+            if (task != nullptr) {
+                break;
+            }
+        }
+    }
+    if (task != nullptr) {
+        deactivate_task(src, task, 0);
+        task->sched_class->migrate(src, task);
+        __atomic_store_n(&task->cpu, self, __ATOMIC_RELEASE);
+        activate_task(dst, task, ENQUEUE_MIGRATED);
+        check_preempt_curr(dst, task);
+    }
+    src->lock.unlock();
+    dst->lock.unlock();
+    cpu_irq_restore(flags);
+    return task != nullptr;
+}
+
+task_t* kthread_create(void (*_func)(void* _arg), void* _arg,
+                       const char* _name) {
+    task_t* task = nullptr;
+    {
+        IrqLockGuard<TicketLock> guard(free_lock);
+        task = free_tasks.pop_front();
+    }
+    if (task == nullptr) {
+        return nullptr;
+    }
+    task->state         = TASK_NEW;
+    task->on_rq         = false;
+    task->on_cpu        = false;
+    task->cpu           = cpu_id();
+    task->cpus_allowed  = ~static_cast<uint64_t>(0);
+    task->sched_class   = &fair_sched_class;
+    task->vruntime      = 0;
+    task->nice          = 0;
+    task->weight        = NICE_0_WEIGHT;
+    task->exec_start    = 0;
+    task->sum_exec      = 0;
+    task->prev_sum_exec = 0;
+    task->last_ran      = 0;
+    task->nr_switches   = 0;
+    task->wake_ts       = 0;
+    task->dl_runtime    = 0;
+    task->dl_deadline   = 0;
+    task->dl_period     = 0;
+    task->dl_bw         = 0;
+    task->dl_budget     = 0;
+    task->dl_release    = 0;
+    task->dl_queued     = false;
+    task->dl_throttled  = false;
+    task->dl_misses     = 0;
+    task->dl_overruns   = 0;
+    task->func          = _func;
+    task->arg           = _arg;
+    task->name          = _name;
+    task->mm            = nullptr;
+    task->plug          = nullptr;
+    task->sp = context_init(task->stack + TASK_STACK_SIZE, task_start, task);
+    fpu_state_init(&task->fpu);
+    return task;
+}
+
+task_t* kthread_run(void (*_func)(void* _arg), void* _arg, const char* _name) {
+    auto* task = kthread_create(_func, _arg, _name);
+    if (task != nullptr) {
+        task_wakeup(task);
+    }
+    return task;
+}
+
+void kthread_bind(task_t* _task, size_t _cpu) {
+    if ((_task->state != TASK_NEW) || (_cpu >= MAX_CPU_COUNT)) {
+        return;
+    }
+    _task->cpus_allowed = static_cast<uint64_t>(1) << _cpu;
+    _task->cpu          = _cpu;
+    return;
+}
+
+void kthread_set_mm(task_t* _task, address_space_t* _as) {
+    if (_task->state != TASK_NEW) {
+        return;
+    }
+    _task->mm = _as;
+    return;
+}
+
+void kthread_exit(void) {
+    set_current_state(TASK_DEAD);
+    schedule();
+    // 不会再被选中
+    while (true) {
+        cpu_halt();
+    }
+}
+
+void sched_init(void) {
+    for (size_t i = 0; i < TASK_MAX; i++) {
+        tasks[i].stack = task_stacks[i];
+        free_tasks.push_back(tasks[i]);
+    }
+    for (size_t cpu = 0; cpu < MAX_CPU_COUNT; cpu++) {
+        auto* rq             = cpu_rq(cpu);
+        rq->cpu              = cpu;
+        rq->nr_running       = 0;
+        rq->curr             = nullptr;
+        rq->idle             = nullptr;
+        rq->prev             = nullptr;
+        rq->clock            = ktime_get_ns();
+        rq->nr_switches      = 0;
+        rq->cfs.min_vruntime = 0;
+        rq->cfs.load         = 0;
+        rq->cfs.nr_running   = 0;
+        rq->dl.total_bw      = 0;
+        rq->dl.nr_running    = 0;
+        rq->dl_misses        = 0;
+        rq->dl_overruns      = 0;
+    }
+    sched_cpu_init();
+    return;
+}
+
+void sched_cpu_init(void) {
+    auto  cpu          = cpu_id();
+    auto* rq           = cpu_rq(cpu);
+    auto* idle         = &idle_tasks[cpu];
+    idle->state        = TASK_RUNNING;
+    idle->on_rq        = false;
+    idle->on_cpu       = true;
+    idle->cpu          = cpu;
+    idle->cpus_allowed = static_cast<uint64_t>(1) << cpu;
+    idle->sched_class  = nullptr;
+    idle->weight       = NICE_0_WEIGHT;
+    idle->name         = "idle";
+    idle->mm           = nullptr;
+    // 空闲任务就是启动时的执行流
+    fpu_state_init(&idle->fpu);
+    fpu_switch(&idle->fpu);
+    timer_init(&rq->tick, sched_tick);
+    rq->curr = idle;
+    this_cpu_write(cpu_curr, idle);
+    this_cpu_write<uint32_t>(preempt_count, 0);
+    __atomic_store_n(&rq->idle, idle, __ATOMIC_RELEASE);
+    return;
+}
@@ -0,0 +1,349 @@
+
+/**
+ * @file deadline.cpp
+ * @brief 截止时间调度类
+ * @author Zone.N (Zone.Niuzh@hotmail.com)
+ * @version 1.0
+ * @date 2026-10-18
+ * @copyright MIT LICENSE
+ * https://github.com/MRNIU/cmake-kernel
+ * @par change log:
+ * <table>
+ * <tr><th>Date<th>Author<th>Description
+ * <tr><td>2026-10-18<td>Zone.N (Zone.Niuzh@hotmail.com)<td>创建文件
+ * </table>
+ */
+
+#include "cpu.h"
+#include "runqueue.h"
+#include "sched.h"
+#include "spinlock.hpp"
+#include "timer.h"
+
+// 每个任务是一个常量带宽服务器 (CBS): 每个周期最多运行 dl_runtime，
+// 总是运行绝对截止时间最早的任务。预算用完时限流到下一个周期开始，
+// 超时的任务只推迟自己，不影响其它任务的截止时间。
+// 准入时每个 cpu 的带宽之和不超过 DL_BW_LIMIT_PERCENT，任务绑定到该 cpu，
+// 单个 cpu 上带宽不超过 100% 时 EDF 可以满足所有截止时间。
+// 作业在截止时间之后才进入等待记为一次错过
+
+/// 保护各 cpu 的 dl.total_bw
+static TicketLock dl_bw_lock;
+
+static task_t* dl_timer_task(ktimer_t* _timer) {
+    return reinterpret_cast<task_t*>(reinterpret_cast<uintptr_t>(_timer)
+                                     - offsetof(task_t, dl_timer));
+}
+
+/**
+ * @brief 开始一个新作业，截止时间从 _start 起算
+ */
+static void dl_new_job(task_t* _task, uint64_t _start) {
+    _task->dl_abs_deadline = _start + _task->dl_deadline;
+    _task->dl_budget       = static_cast<int64_t>(_task->dl_runtime);
+    return;
+}
+
+/**
+ * @brief 剩余预算在截止时间前用完是否会超过任务的带宽
+ * budget / (deadline - now) > dl_bw
+ */
+static bool dl_overflow(const task_t* _task, uint64_t _now) {
+    auto allowed = mul_u64_u32_shr(_task->dl_abs_deadline - _now,
+                                   static_cast<uint32_t>(_task->dl_bw),
+                                   DL_BW_SHIFT);
+    return static_cast<uint64_t>(_task->dl_budget) > allowed;
+}
+
+/**
+ * @brief 被唤醒时按 CBS 规则决定沿用当前作业还是开始新作业
+ */
+static void dl_wakeup(task_t* _task, uint64_t _now) {
+    if (_task->dl_release != 0) {
+        // sched_dl_wait_period 等待的周期开始了
+        dl_new_job(_task, _task->dl_release);
+        _task->dl_release = 0;
+    }
+    else if ((static_cast<int64_t>(_task->dl_abs_deadline - _now) <= 0)
+             || (_task->dl_budget <= 0) || dl_overflow(_task, _now)) {
+        dl_new_job(_task, _now);
+    }
+    return;
+}
+
+/**
+ * @brief 补充预算，截止时间顺延相应的周期数
+ */
+static void dl_replenish(rq_t* _rq, task_t* _task) {
+    while (_task->dl_budget <= 0) {
+        _task->dl_abs_deadline += _task->dl_period;
+        _task->dl_budget       += static_cast<int64_t>(_task->dl_runtime);
+    }
+    // 落后太多时重新开始，避免以过去的截止时间抢占其它任务
+    if (static_cast<int64_t>(_task->dl_abs_deadline - _rq->clock) <= 0) {
+        dl_new_job(_task, _rq->clock);
+    }
+    return;
+}
+
+/**
+ * @brief 预算用完，限流到下一个周期开始，需要在任务所在的 cpu 上调用
+ */
+static void dl_throttle(rq_t* _rq, task_t* _task) {
+    _task->dl_throttled = true;
+    timer_add(&_task->dl_timer,
+              _task->dl_abs_deadline - _task->dl_deadline + _task->dl_period);
+    resched_curr(_rq);
+    return;
+}
+
+static void dl_insert(rq_t* _rq, task_t* _task) {
+    _rq->dl.tree.insert(*_task);
+    _task->dl_queued = true;
+    return;
+}
+
+static void dl_erase(rq_t* _rq, task_t* _task) {
+    _rq->dl.tree.erase(*_task);
+    _task->dl_queued = false;
+    return;
+}
+
+/**
+ * @brief 补充预算或开始新周期
+ */
+static void dl_timer_fn(ktimer_t* _timer) {
+    auto* task = dl_timer_task(_timer);
+    auto* rq   = task_rq_lock(task);
+    auto  wake = false;
+    update_rq_clock(rq);
+    if (task->dl_throttled) {
+        task->dl_throttled = false;
+        dl_replenish(rq, task);
+        if (task->on_rq && (task != rq->curr)) {
+            dl_insert(rq, task);
+            check_preempt_curr(rq, task);
+        }
+    }
+    if (task->dl_release != 0) {
+        if ((task->state == TASK_BLOCKED) && !task->on_rq) {
+            wake = true;
+        }
+        else {
+            // 还没有切换出去或已被提前唤醒，直接开始新作业
+            dl_new_job(task, task->dl_release);
+            task->dl_release = 0;
+            task->state      = TASK_RUNNING;
+        }
+    }
+    rq->lock.unlock();
+    if (wake) {
+        task_wakeup(task);
+    }
+    return;
+}
+
+static void update_curr(rq_t* _rq) {
+    auto* curr  = _rq->curr;
+    auto  delta = static_cast<int64_t>(_rq->clock - curr->exec_start);
+    if (delta <= 0) {
+        return;
+    }
+    curr->exec_start  = _rq->clock;
+    curr->sum_exec   += delta;
+    curr->dl_budget  -= delta;
+    if ((curr->dl_budget <= 0) && !curr->dl_throttled) {
+        curr->dl_overruns++;
+        _rq->dl_overruns++;
+        dl_throttle(_rq, curr);
+    }
+    return;
+}
+
+static void enqueue(rq_t* _rq, task_t* _task, uint32_t _flags) {
+    _rq->dl.nr_running++;
+    // 被限流的任务由定时器放回
+    if (_task->dl_throttled) {
+        return;
+    }
+    if ((_flags & (ENQUEUE_WAKEUP | ENQUEUE_NEW)) != 0) {
+        dl_wakeup(_task, _rq->clock);
+    }
+    if (_task != _rq->curr) {
+        dl_insert(_rq, _task);
+    }
+    return;
+}
+
+static void dequeue(rq_t* _rq, task_t* _task, uint32_t _flags) {
+    _rq->dl.nr_running--;
+    if (_task->dl_queued) {
+        dl_erase(_rq, _task);
+    }
+    if (((_flags & DEQUEUE_SLEEP) != 0)
+        && (static_cast<int64_t>(_rq->clock - _task->dl_abs_deadline) > 0)) {
+        _task->dl_misses++;
+        _rq->dl_misses++;
+    }
+    return;
+}
+
+static task_t* pick_next(rq_t* _rq) {
+    auto* task = _rq->dl.tree.first();
+    if (task != nullptr) {
+        dl_erase(_rq, task);
+    }
+    return task;
+}
+
+static void put_prev(rq_t* _rq, task_t* _task) {
+    if (_task->on_rq && !_task->dl_throttled) {
+        dl_insert(_rq, _task);
+    }
+    return;
+}
+
+static void tick(rq_t* _rq, task_t* _curr) {
+    update_curr(_rq);
+    auto* first = _rq->dl.tree.first();
+    if ((first != nullptr) && DeadlineLess()(*first, *_curr)) {
+        resched_curr(_rq);
+    }
+    return;
+}
+
+static bool check_preempt(rq_t* _rq, task_t* _task) {
+    update_curr(_rq);
+    return _rq->curr->dl_throttled || DeadlineLess()(*_task, *_rq->curr);
+}
+
+static void yield(rq_t* _rq) {
+    auto* curr = _rq->curr;
+    update_curr(_rq);
+    // 放弃本周期剩余的预算
+    if (!curr->dl_throttled) {
+        curr->dl_budget = 0;
+        dl_throttle(_rq, curr);
+    }
+    return;
+}
+
+static task_t* steal(rq_t* _rq, size_t _dst_cpu) {
+    (void)_rq;
+    (void)_dst_cpu;
+    // 任务绑定在准入的 cpu 上
+    return nullptr;
+}
+
+static void migrate(rq_t* _rq, task_t* _task) {
+    (void)_rq;
+    (void)_task;
+    return;
+}
+
+static uint64_t next_tick(rq_t* _rq, task_t* _curr) {
+    (void)_rq;
+    // 在预算用完时检查，而不是等到下一个周期时钟
+    if ((_curr->dl_budget > 0)
+        && (static_cast<uint64_t>(_curr->dl_budget) < SCHED_TICK_NS)) {
+        return static_cast<uint64_t>(_curr->dl_budget);
+    }
+    return SCHED_TICK_NS;
+}
+
+static void task_dead(task_t* _task) {
+    timer_del(&_task->dl_timer);
+    IrqLockGuard<TicketLock> guard(dl_bw_lock);
+    cpu_rq(_task->cpu)->dl.total_bw -= _task->dl_bw;
+    return;
+}
+
+const sched_class_t dl_sched_class = {
+    .rank          = SCHED_CLASS_DEADLINE,
+    .enqueue       = enqueue,
+    .dequeue       = dequeue,
+    .pick_next     = pick_next,
+    .put_prev      = put_prev,
+    .update_curr   = update_curr,
+    .tick          = tick,
+    .check_preempt = check_preempt,
+    .yield         = yield,
+    .steal         = steal,
+    .migrate       = migrate,
+    .next_tick     = next_tick,
+    .task_dead     = task_dead,
+};
+
+bool sched_set_deadline(task_t* _task, uint64_t _runtime, uint64_t _deadline,
+                        uint64_t _period) {
+    if ((_task->state != TASK_NEW) || (_task->sched_class == &dl_sched_class)
+        || (_runtime < DL_MIN_RUNTIME_NS) || (_runtime > DL_MAX_RUNTIME_NS)
+        || (_runtime > _deadline) || (_deadline > _period)) {
+        return false;
+    }
+    auto bw    = (_runtime << DL_BW_SHIFT) / _period;
+    auto limit = (DL_BW_LIMIT_PERCENT << DL_BW_SHIFT) / 100;
+    // 带宽太小，定点数表示为 0
+    if (bw == 0) {
+        return false;
+    }
+
+    IrqLockGuard<TicketLock> guard(dl_bw_lock);
+    // 选剩余带宽最多的 cpu，使各 cpu 的负载尽量均匀
+    size_t   best    = MAX_CPU_COUNT;
+    uint64_t best_bw = 0;
+    for (size_t cpu = 0; cpu < MAX_CPU_COUNT; cpu++) {
+        if (((_task->cpus_allowed >> cpu) & 1) == 0 || !cpu_active(cpu)) {
+            continue;
+        }
+        auto total = cpu_rq(cpu)->dl.total_bw;
+        if (total + bw > limit) {
+            continue;
+        }
+        if ((best == MAX_CPU_COUNT) || (total < best_bw)) {
+            best    = cpu;
+            best_bw = total;
+        }
+    }
+    if (best == MAX_CPU_COUNT) {
+        return false;
+    }
+    cpu_rq(best)->dl.total_bw += bw;
+
+    _task->dl_runtime   = _runtime;
+    _task->dl_deadline  = _deadline;
+    _task->dl_period    = _period;
+    _task->dl_bw        = bw;
+    _task->dl_budget    = 0;
+    _task->dl_release   = 0;
+    _task->dl_throttled = false;
+    _task->dl_queued    = false;
+    timer_init(&_task->dl_timer, dl_timer_fn);
+    _task->cpus_allowed = static_cast<uint64_t>(1) << best;
+    _task->cpu          = best;
+    _task->sched_class  = &dl_sched_class;
+    return true;
+}
+
+void sched_dl_wait_period(void) {
+    auto* task = current_task();
+    if (task->sched_class != &dl_sched_class) {
+        yield();
+        return;
+    }
+    {
+        auto*                    rq = this_rq();
+        IrqLockGuard<TicketLock> guard(rq->lock);
+        update_rq_clock(rq);
+        update_curr(rq);
+        // 下一个周期从当前作业所在周期的结束开始，保持周期对齐
+        auto release = task->dl_abs_deadline - task->dl_deadline
+                       + task->dl_period;
+        task->dl_throttled = false;
+        task->dl_release   = release;
+        task->state        = TASK_BLOCKED;
+        timer_add(&task->dl_timer, release);
+    }
+    schedule();
+    return;
+}
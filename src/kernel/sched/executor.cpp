@@ -0,0 +1,120 @@
+
+/**
+ * @file executor.cpp
+ * @brief 协程执行器
+ * @author Zone.N (Zone.Niuzh@hotmail.com)
+ * @version 1.0
+ * @date 2026-10-18
+ * @copyright MIT LICENSE
+ * https://github.com/MRNIU/cmake-kernel
+ * @par change log:
+ * <table>
+ * <tr><th>Date<th>Author<th>Description
+ * <tr><td>2026-10-18<td>Zone.N (Zone.Niuzh@hotmail.com)<td>创建文件
+ * </table>
+ */
+
+#include "cpu.h"
+#include "executor.h"
+#include "sched.h"
+#include "spinlock.hpp"
+#include "wait.h"
+#include "workqueue.h"
+
+Executor system_executor(&system_unbound_wq);
+
+Executor::Executor(workqueue_t* _wq) : wq(_wq) {
+    work_init(&work.work, run);
+    work.executor = this;
+}
+
+void Executor::run(work_t* _work) {
+    auto* self = reinterpret_cast<executor_work_t*>(_work)->executor;
+    for (size_t i = 0; i < EXECUTOR_BATCH; i++) {
+        TaskPromiseBase* promise = nullptr;
+        {
+            IrqLockGuard<TicketLock> guard(self->lock);
+            promise = self->ready.pop_front();
+        }
+        if (promise == nullptr) {
+            return;
+        }
+        promise->self.resume();
+    }
+    // 还有就绪的协程，重新排队，让其它工作项有机会运行
+    IrqLockGuard<TicketLock> guard(self->lock);
+    if (!self->ready.empty()) {
+        queue_work(self->wq, &self->work.work);
+    }
+    return;
+}
+
+void Executor::post(TaskPromiseBase* _promise) {
+    {
+        IrqLockGuard<TicketLock> guard(lock);
+        ready.push_back(*_promise);
+    }
+    queue_work(wq, &work.work);
+    return;
+}
+
+bool Executor::spawn(Task<void>&& _task) {
+    if (!_task.valid()) {
+        return false;
+    }
+    auto  handle     = _task.release();
+    auto& promise    = handle.promise();
+    promise.context  = this;
+    promise.detached = true;
+    post(&promise);
+    return true;
+}
+
+static Task<void> block_on_task(Task<void> _task, block_on_state_t* _state) {
+    co_await std::move(_task);
+    block_on_signal(_state);
+}
+
+bool Executor::block_on(Task<void>&& _task) {
+    if (!_task.valid()) {
+        return false;
+    }
+    block_on_state_t state;
+    state.done = false;
+    if (!spawn(block_on_task(std::move(_task), &state))) {
+        return false;
+    }
+    block_on_wait(&state);
+    return true;
+}
+
+void Executor::resume(TaskPromiseBase* _promise) {
+    auto* executor = static_cast<Executor*>(_promise->context);
+    if (executor == nullptr) {
+        _promise->self.resume();
+        return;
+    }
+    executor->post(_promise);
+    return;
+}
+
+void Sleep::fire(ktimer_t* _timer) {
+    auto* sleep = reinterpret_cast<Sleep*>(reinterpret_cast<uintptr_t>(_timer)
+                                           - offsetof(Sleep, timer));
+    Executor::resume(sleep->waiter);
+    return;
+}
+
+void block_on_wait(block_on_state_t* _state) {
+    wait_event(_state, [_state] {
+        return __atomic_load_n(&_state->done, __ATOMIC_ACQUIRE);
+    });
+    return;
+}
+
+void block_on_signal(block_on_state_t* _state) {
+    __atomic_store_n(&_state->done, true, __ATOMIC_RELEASE);
+    // 等待者可能已经返回，_state 只作为键
+    wake_up_all(_state);
+    return;
+}
@@ -0,0 +1,273 @@
+
+/**
+ * @file fair.cpp
+ * @brief 公平调度类
+ * @author Zone.N (Zone.Niuzh@hotmail.com)
+ * @version 1.0
+ * @date 2026-10-18
+ * @copyright MIT LICENSE
+ * https://github.com/MRNIU/cmake-kernel
+ * @par change log:
+ * <table>
+ * <tr><th>Date<th>Author<th>Description
+ * <tr><td>2026-10-18<td>Zone.N (Zone.Niuzh@hotmail.com)<td>创建文件
+ * </table>
+ */
+
+#include "runqueue.h"
+#include "sched.h"
+
+// 每个任务按权重累计 vruntime，总是运行 vruntime 最小的任务。
+// 正在运行的任务不在树中，停止运行时按新的 vruntime 放回。
+// 唤醒的任务最多补偿半个调度周期，长时间等待的任务不会独占 cpu；
+// 迁移时 vruntime 换算为相对目标队列 min_vruntime 的值
+
+/// nice -20~19 对应的权重，相邻两级相差约 1.25 倍
+static constexpr const uint32_t NICE_TO_WEIGHT[40] = {
+    88761, 71755, 56483, 46273, 36291, 29154, 23254, 18705, 14949, 11916,
+    9548,  7620,  6100,  4904,  3906,  3121,  2501,  1991,  1586,  1277,
+    1024,  820,   655,   526,   423,   335,   272,   215,   172,   137,
+    110,   87,    70,    56,    45,    36,    29,    23,    18,    15,
+};
+
+/// 权重的倒数 2^32 / NICE_TO_WEIGHT，用乘法与移位代替除以权重
+static constexpr const uint32_t NICE_TO_WMULT[40]  = {
+    48388,     59856,     76039,     92817,     118348,
+    147320,    184698,    229616,    287308,    360437,
+    449829,    563644,    704092,    875808,    1099582,
+    1376151,   1717299,   2157191,   2708049,   3363325,
+    4194304,   5237764,   6557201,   8165337,   10153586,
+    12820797,  15790320,  19976592,  24970740,  31350126,
+    39045157,  49367440,  61356675,  76695844,  95443717,
+    119304647, 148102320, 186737708, 238609294, 286331153,
+};
+
+/// NICE_TO_WMULT 的小数位数
+static constexpr const uint32_t WMULT_SHIFT        = 32;
+/// NICE_0_WEIGHT 的位数，乘以 NICE_0_WEIGHT 并入右移
+static constexpr const uint32_t NICE_0_SHIFT       = 10;
+static_assert(NICE_0_WEIGHT == (1 << NICE_0_SHIFT));
+
+uint32_t fair_nice_to_weight(int32_t _nice) {
+    return NICE_TO_WEIGHT[_nice - NICE_MIN];
+}
+
+/**
+ * @brief 实际运行时间折算为 vruntime
+ */
+static uint64_t calc_delta_fair(uint64_t _delta, const task_t* _task) {
+    if (_task->weight == NICE_0_WEIGHT) {
+        return _delta;
+    }
+    // _delta * NICE_0_WEIGHT / weight
+    return mul_u64_u32_shr(_delta, NICE_TO_WMULT[_task->nice - NICE_MIN],
+                           WMULT_SHIFT - NICE_0_SHIFT);
+}
+
+/**
+ * @brief _task 在一个调度周期中应运行的时间
+ */
+static uint64_t sched_slice(const cfs_rq_t& _cfs, const task_t* _task) {
+    auto period = SCHED_LATENCY_NS;
+    if (_cfs.nr_running * SCHED_MIN_GRANULARITY_NS > period) {
+        period = _cfs.nr_running * SCHED_MIN_GRANULARITY_NS;
+    }
+    if (_cfs.load == 0) {
+        return period;
+    }
+    return period * _task->weight / _cfs.load;
+}
+
+static bool is_fair_curr(const rq_t* _rq) {
+    return (_rq->curr->sched_class == &fair_sched_class) && _rq->curr->on_rq;
+}
+
+/**
+ * @brief min_vruntime 只增不减，取当前任务与最左任务中较小的 vruntime
+ */
+static void update_min_vruntime(rq_t* _rq) {
+    auto& cfs   = _rq->cfs;
+    auto* first = cfs.tree.first();
+    if (!is_fair_curr(_rq) && (first == nullptr)) {
+        return;
+    }
+    uint64_t vruntime = 0;
+    if (is_fair_curr(_rq)) {
+        vruntime = _rq->curr->vruntime;
+        if ((first != nullptr)
+            && static_cast<int64_t>(first->vruntime - vruntime) < 0) {
+            vruntime = first->vruntime;
+        }
+    }
+    else {
+        vruntime = first->vruntime;
+    }
+    if (static_cast<int64_t>(vruntime - cfs.min_vruntime) > 0) {
+        cfs.min_vruntime = vruntime;
+    }
+    return;
+}
+
+static void update_curr(rq_t* _rq) {
+    auto* curr = _rq->curr;
+    if (curr->sched_class != &fair_sched_class) {
+        return;
+    }
+    auto delta = static_cast<int64_t>(_rq->clock - curr->exec_start);
+    if (delta <= 0) {
+        return;
+    }
+    curr->exec_start  = _rq->clock;
+    curr->sum_exec   += delta;
+    curr->vruntime   += calc_delta_fair(delta, curr);
+    update_min_vruntime(_rq);
+    return;
+}
+
+/**
+ * @brief 确定加入队列时的 vruntime
+ */
+static void place_task(cfs_rq_t& _cfs, task_t* _task, uint32_t _flags) {
+    if ((_flags & ENQUEUE_MIGRATED) != 0) {
+        _task->vruntime += _cfs.min_vruntime;
+    }
+    if ((_flags & ENQUEUE_NEW) != 0) {
+        // 新任务排在当前所有任务之后，不能靠反复创建线程抢占 cpu
+        _task->vruntime = _cfs.min_vruntime + sched_slice(_cfs, _task);
+    }
+    else if ((_flags & ENQUEUE_WAKEUP) != 0) {
+        auto vruntime = _cfs.min_vruntime - SCHED_LATENCY_NS / 2;
+        if (static_cast<int64_t>(_task->vruntime - vruntime) < 0) {
+            _task->vruntime = vruntime;
+        }
+    }
+    return;
+}
+
+static void enqueue(rq_t* _rq, task_t* _task, uint32_t _flags) {
+    auto& cfs = _rq->cfs;
+    update_curr(_rq);
+    cfs.nr_running++;
+    cfs.load += _task->weight;
+    place_task(cfs, _task, _flags);
+    if (_task != _rq->curr) {
+        cfs.tree.insert(*_task);
+    }
+    update_min_vruntime(_rq);
+    return;
+}
+
+static void dequeue(rq_t* _rq, task_t* _task, uint32_t _flags) {
+    (void)_flags;
+    auto& cfs = _rq->cfs;
+    update_curr(_rq);
+    if (_task != _rq->curr) {
+        cfs.tree.erase(*_task);
+    }
+    cfs.nr_running--;
+    cfs.load -= _task->weight;
+    update_min_vruntime(_rq);
+    return;
+}
+
+static task_t* pick_next(rq_t* _rq) {
+    auto* task = _rq->cfs.tree.first();
+    if (task == nullptr) {
+        return nullptr;
+    }
+    _rq->cfs.tree.erase(*task);
+    task->prev_sum_exec = task->sum_exec;
+    return task;
+}
+
+static void put_prev(rq_t* _rq, task_t* _task) {
+    if (_task->on_rq) {
+        _rq->cfs.tree.insert(*_task);
+    }
+    return;
+}
+
+static void tick(rq_t* _rq, task_t* _curr) {
+    update_curr(_rq);
+    auto* first = _rq->cfs.tree.first();
+    if (first == nullptr) {
+        return;
+    }
+    // 用完了本周期的时间片，或落后最左任务超过一个时间片
+    auto ran   = _curr->sum_exec - _curr->prev_sum_exec;
+    auto slice = sched_slice(_rq->cfs, _curr);
+    if ((ran >= slice)
+        || ((ran >= SCHED_MIN_GRANULARITY_NS)
+            && static_cast<int64_t>(_curr->vruntime - first->vruntime)
+                 > static_cast<int64_t>(slice))) {
+        resched_curr(_rq);
+    }
+    return;
+}
+
+static bool check_preempt(rq_t* _rq, task_t* _task) {
+    update_curr(_rq);
+    // 粒度按被唤醒任务的权重折算，权重越大越容易抢占
+    auto gran = calc_delta_fair(SCHED_WAKEUP_GRANULARITY_NS, _task);
+    return static_cast<int64_t>(_rq->curr->vruntime - _task->vruntime)
+           > static_cast<int64_t>(gran);
+}
+
+static void yield(rq_t* _rq) {
+    auto* curr = _rq->curr;
+    update_curr(_rq);
+    // 排到最右边，同类的其它任务都运行过后才会再次被选中
+    auto* last = _rq->cfs.tree.last();
+    if ((last != nullptr)
+        && static_cast<int64_t>(last->vruntime - curr->vruntime) >= 0) {
+        curr->vruntime = last->vruntime + 1;
+    }
+    return;
+}
+
+static task_t* steal(rq_t* _rq, size_t _dst_cpu) {
+    auto    mask     = static_cast<uint64_t>(1) << _dst_cpu;
+    task_t* fallback = nullptr;
+    // 从最右边开始，这些任务在本 cpu 上最晚才会运行，迁移的损失最小
+    auto*   task     = _rq->cfs.tree.last();
+    while (task != nullptr) {
+        if ((task->cpus_allowed & mask) != 0) {
+            if (_rq->clock - task->last_ran >= SCHED_MIGRATION_COST_NS) {
+                return task;
+            }
+            if (fallback == nullptr) {
+                fallback = task;
+            }
+        }
+        task = _rq->cfs.tree.prev(*task);
+    }
+    // 都是缓存热的任务时仍然迁移，目标 cpu 空闲的代价更大
+    return fallback;
+}
+
+static void migrate(rq_t* _rq, task_t* _task) {
+    _task->vruntime -= _rq->cfs.min_vruntime;
+    return;
+}
+
+static uint64_t next_tick(rq_t* _rq, task_t* _curr) {
+    (void)_rq;
+    (void)_curr;
+    return SCHED_TICK_NS;
+}
+
+const sched_class_t fair_sched_class = {
+    .rank          = SCHED_CLASS_FAIR,
+    .enqueue       = enqueue,
+    .dequeue       = dequeue,
+    .pick_next     = pick_next,
+    .put_prev      = put_prev,
+    .update_curr   = update_curr,
+    .tick          = tick,
+    .check_preempt = check_preempt,
+    .yield         = yield,
+    .steal         = steal,
+    .migrate       = migrate,
+    .next_tick     = next_tick,
+    .task_dead     = nullptr,
+};
@@ -0,0 +1,138 @@
+
+/**
+ * @file idle.cpp
+ * @brief 空闲循环
+ * @author Zone.N (Zone.Niuzh@hotmail.com)
+ * @version 1.0
+ * @date 2026-10-18
+ * @copyright MIT LICENSE
+ * https://github.com/MRNIU/cmake-kernel
+ * @par change log:
+ * <table>
+ * <tr><th>Date<th>Author<th>Description
+ * <tr><td>2026-10-18<td>Zone.N (Zone.Niuzh@hotmail.com)<td>创建文件
+ * </table>
+ */
+
+#include "sched.h"
+#include "cpu.h"
+#include "ktime.h"
+#include "percpu.h"
+#include "rcu.h"
+#include "runqueue.h"
+#include "smp.h"
+
+// 空闲时先轮询一段时间再进入低功耗等待 (haltpoll)。
+// 任务很快到达时，轮询省去了 hlt/wfi 的退出延迟与处理器间中断；
+// 长时间空闲时仍然进入低功耗状态。轮询窗口根据每次空闲的时长调整:
+// 在窗口外、上限内被唤醒说明窗口偏小，加倍；超过上限说明很少
+// 有短暂的空闲，减半
+
+/// 轮询窗口上限
+static constexpr const uint64_t POLL_NS_MAX   = 200 * 1000;
+/// 窗口增长时的最小值
+static constexpr const uint64_t POLL_NS_START = 50 * 1000;
+/// 增长倍数
+static constexpr const uint64_t POLL_GROW     = 2;
+/// 缩小倍数
+static constexpr const uint64_t POLL_SHRINK   = 2;
+
+DEFINE_PER_CPU(uint32_t, sched_flags);
+/// 当前的轮询窗口
+DEFINE_PER_CPU(uint64_t, poll_ns);
+
+void resched_cpu(size_t _cpu) {
+    auto* flags = per_cpu_ptr(&sched_flags, _cpu);
+    auto  old
+      = __atomic_fetch_or(flags, SCHED_NEED_RESCHED, __ATOMIC_SEQ_CST);
+    // 已经有人请求过，或目标正在轮询，写标记即可
+    if ((old & (SCHED_NEED_RESCHED | SCHED_POLLING)) != 0) {
+        return;
+    }
+    if (_cpu != cpu_id()) {
+        smp_send_ipi(_cpu);
+    }
+    return;
+}
+
+/**
+ * @brief 根据本次空闲的时长调整轮询窗口
+ * @param  _poll                   轮询窗口
+ * @param  _block_ns               本次空闲的时长
+ */
+static void poll_adjust(uint64_t* _poll, uint64_t _block_ns) {
+    if (_block_ns > POLL_NS_MAX) {
+        *_poll /= POLL_SHRINK;
+    }
+    else if (_block_ns > *_poll) {
+        auto next = *_poll * POLL_GROW;
+        if (next < POLL_NS_START) {
+            next = POLL_NS_START;
+        }
+        if (next > POLL_NS_MAX) {
+            next = POLL_NS_MAX;
+        }
+        *_poll = next;
+    }
+    return;
+}
+
+/**
+ * @brief 空闲一次，直到需要重新调度或产生中断
+ * @param  _flags                  本 cpu 的调度标记
+ * @param  _poll                   本 cpu 的轮询窗口
+ */
+static void do_idle(uint32_t* _flags, uint64_t* _poll) {
+    auto start = ktime_get_ns();
+
+    // 轮询期间写标记即可唤醒，不需要处理器间中断
+    __atomic_fetch_or(_flags, SCHED_POLLING, __ATOMIC_SEQ_CST);
+    while (ktime_get_ns() - start < *_poll) {
+        if ((__atomic_load_n(_flags, __ATOMIC_ACQUIRE) & SCHED_NEED_RESCHED)
+            != 0) {
+            __atomic_fetch_and(_flags, ~SCHED_POLLING, __ATOMIC_RELAXED);
+            return;
+        }
+        cpu_relax();
+    }
+
+    cpu_irq_disable();
+    // 不能被写标记唤醒时，清除 SCHED_POLLING 后再检查标记，
+    // 与 resched_cpu 的 fetch_or 构成先写后读，
+    // 保证要么这里看到请求，要么请求方发送处理器间中断
+    if (!cpu_idle_can_monitor()) {
+        __atomic_fetch_and(_flags, ~SCHED_POLLING, __ATOMIC_SEQ_CST);
+    }
+    auto old = __atomic_load_n(_flags, __ATOMIC_SEQ_CST);
+    if ((old & SCHED_NEED_RESCHED) != 0) {
+        __atomic_fetch_and(_flags, ~SCHED_POLLING, __ATOMIC_RELAXED);
+        cpu_irq_enable();
+        return;
+    }
+    rcu_idle_enter();
+    // 返回时中断已打开，唤醒本 cpu 的中断在这之后处理
+    cpu_idle_wait(_flags, old);
+    rcu_idle_exit();
+    __atomic_fetch_and(_flags, ~SCHED_POLLING, __ATOMIC_RELAXED);
+
+    poll_adjust(_poll, ktime_get_ns() - start);
+    return;
+}
+
+void cpu_idle_loop(void) {
+    auto* flags = this_cpu_ptr(&sched_flags);
+    auto* poll  = this_cpu_ptr(&poll_ns);
+    *poll       = POLL_NS_START;
+    cpu_irq_enable();
+    while (true) {
+        // 空闲循环不持有 rcu 读锁
+        rcu_quiescent_state();
+        // 先从忙的 cpu 偷取任务，偷到时已设置重新调度标记
+        if (!need_resched() && !sched_idle_steal()) {
+            do_idle(flags, poll);
+        }
+        if (need_resched()) {
+            schedule();
+        }
+    }
+}
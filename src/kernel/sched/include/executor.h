@@ -0,0 +1,288 @@
+
+/**
+ * @file executor.h
+ * @brief 协程执行器
+ * @author Zone.N (Zone.Niuzh@hotmail.com)
+ * @version 1.0
+ * @date 2026-10-18
+ * @copyright MIT LICENSE
+ * https://github.com/MRNIU/cmake-kernel
+ * @par change log:
+ * <table>
+ * <tr><th>Date<th>Author<th>Description
+ * <tr><td>2026-10-18<td>Zone.N (Zone.Niuzh@hotmail.com)<td>创建文件
+ * </table>
+ */
+
+#ifndef CMAKE_KERNEL_EXECUTOR_H
+#define CMAKE_KERNEL_EXECUTOR_H
+
+#include "cstddef"
+#include "cstdint"
+
+#include "intrusive_list.hpp"
+#include "ktime.h"
+#include "sched.h"
+#include "spinlock.hpp"
+#include "task.hpp"
+#include "timer.h"
+#include "workqueue.h"
+
+// 协程在执行器中运行: 执行器是工作队列上的一个工作项，
+// 依次恢复就绪队列中的协程，同一个执行器中的协程不会并发执行。
+// 协程等待设备完成或定时器时不占用线程，完成后由中断处理程序
+// 放回就绪队列，每个未完成的请求只需要一个协程帧
+
+/// 每次运行最多恢复的协程数，之后让出工作线程
+static constexpr const size_t EXECUTOR_BATCH = 64;
+
+class Executor;
+
+/**
+ * @brief 执行器的工作项，通过 work 找到执行器
+ */
+struct executor_work_t {
+    work_t    work;
+    Executor* executor;
+};
+
+/**
+ * @brief 协程执行器
+ */
+class Executor {
+private:
+    TicketLock                                                   lock;
+    /// 就绪的协程
+    IntrusiveList<TaskPromiseBase, &TaskPromiseBase::ready_node> ready;
+    /// 运行所在的工作队列
+    workqueue_t*                                                 wq;
+    executor_work_t                                              work;
+
+    static void run(work_t* _work);
+
+public:
+    /**
+     * @brief 构造
+     * @param  _wq                 运行所在的工作队列
+     */
+    explicit Executor(workqueue_t* _wq);
+
+    Executor(const Executor&)            = delete;
+    Executor& operator=(const Executor&) = delete;
+
+    ~Executor(void) = default;
+
+    /**
+     * @brief 将挂起的协程放入就绪队列，可以在中断上下文中调用
+     * @param  _promise            协程的 promise
+     */
+    void post(TaskPromiseBase* _promise);
+
+    /**
+     * @brief 启动任务，不等待结果，完成后自动销毁
+     * @param  _task               任务
+     * @return true                已启动
+     * @return false               任务无效
+     */
+    bool spawn(Task<void>&& _task);
+
+    /**
+     * @brief 在执行器中运行任务，当前线程等待它完成
+     * 不能在执行器的协程或中断上下文中调用
+     * @param  _task               任务
+     * @param  _result             返回值
+     * @return true                已完成
+     * @return false               任务无效或帧分配失败
+     */
+    template <class T>
+    bool block_on(Task<T>&& _task, T* _result);
+
+    bool block_on(Task<void>&& _task);
+
+    /**
+     * @brief 恢复挂起的协程: 有执行器时放入其就绪队列，否则直接恢复
+     * @param  _promise            协程的 promise
+     */
+    static void resume(TaskPromiseBase* _promise);
+};
+
+/// 系统执行器，在 system_unbound_wq 上运行
+extern Executor system_executor;
+
+/**
+ * @brief 让出执行器，排到就绪队列末尾
+ */
+class Yield {
+public:
+    bool await_ready(void) noexcept {
+        return false;
+    }
+
+    /// 不在执行器中运行时不挂起
+    template <class P>
+    bool await_suspend(std::coroutine_handle<P> _handle) noexcept {
+        auto& promise = _handle.promise();
+        if (promise.context == nullptr) {
+            return false;
+        }
+        static_cast<Executor*>(promise.context)->post(&promise);
+        return true;
+    }
+
+    void await_resume(void) noexcept {
+    }
+};
+
+/**
+ * @brief 等待 _delay 纳秒，期间不占用线程
+ */
+class Sleep {
+private:
+    ktimer_t         timer;
+    uint64_t         delay;
+    TaskPromiseBase* waiter;
+
+    static void fire(ktimer_t* _timer);
+
+public:
+    explicit Sleep(uint64_t _delay) : delay(_delay), waiter(nullptr) {
+    }
+
+    bool await_ready(void) noexcept {
+        return delay == 0;
+    }
+
+    template <class P>
+    void await_suspend(std::coroutine_handle<P> _handle) noexcept {
+        waiter = &_handle.promise();
+        timer_init(&timer, fire);
+        timer_add(&timer, ktime_get_ns() + delay);
+        return;
+    }
+
+    void await_resume(void) noexcept {
+    }
+};
+
+/**
+ * @brief 一次性的设备完成事件
+ * 驱动在提交请求时嵌入到请求中，中断处理程序调用 complete，
+ * 协程 co_await 得到完成状态。只允许一个协程等待
+ */
+class Completion {
+private:
+    /// 已完成
+    static constexpr const uintptr_t DONE = 1;
+
+    /// 0 表示未完成且没有等待者，DONE 表示已完成，其它为等待者的 promise
+    uintptr_t state;
+    /// 完成状态
+    int32_t   status;
+
+public:
+    class Awaiter {
+    private:
+        Completion* completion;
+
+    public:
+        explicit Awaiter(Completion* _completion) : completion(_completion) {
+        }
+
+        bool await_ready(void) noexcept {
+            return completion->done();
+        }
+
+        template <class P>
+        bool await_suspend(std::coroutine_handle<P> _handle) noexcept {
+            static_assert(std::is_base_of_v<TaskPromiseBase, P>,
+                          "Completion can only be awaited from a Task");
+            uintptr_t expected = 0;
+            auto      waiter   = reinterpret_cast<uintptr_t>(
+              static_cast<TaskPromiseBase*>(&_handle.promise()));
+            // 失败说明已经完成，不挂起
+            return __atomic_compare_exchange_n(&completion->state, &expected,
+                                               waiter, false, __ATOMIC_ACQ_REL,
+                                               __ATOMIC_ACQUIRE);
+        }
+
+        int32_t await_resume(void) noexcept {
+            return completion->status;
+        }
+    };
+
+    Completion(void) : state(0), status(0) {
+    }
+
+    Completion(const Completion&)            = delete;
+    Completion& operator=(const Completion&) = delete;
+
+    /**
+     * @brief 重新使用前清除完成状态，不能有等待者
+     */
+    void reset(void) {
+        status = 0;
+        __atomic_store_n(&state, 0, __ATOMIC_RELEASE);
+        return;
+    }
+
+    bool done(void) const {
+        return __atomic_load_n(&state, __ATOMIC_ACQUIRE) == DONE;
+    }
+
+    /**
+     * @brief 完成，可以在中断上下文中调用
+     * @param  _status             完成状态
+     */
+    void complete(int32_t _status) {
+        status   = _status;
+        auto old = __atomic_exchange_n(&state, DONE, __ATOMIC_ACQ_REL);
+        if ((old != 0) && (old != DONE)) {
+            Executor::resume(reinterpret_cast<TaskPromiseBase*>(old));
+        }
+        return;
+    }
+
+    Awaiter operator co_await(void) noexcept {
+        return Awaiter(this);
+    }
+};
+
+/**
+ * @brief block_on 的完成标记，等待者在它的地址上睡眠
+ */
+struct block_on_state_t {
+    bool done;
+};
+
+/**
+ * @brief 等待 _state 完成
+ */
+void block_on_wait(block_on_state_t* _state);
+
+/**
+ * @brief 标记 _state 完成并唤醒等待者
+ */
+void block_on_signal(block_on_state_t* _state);
+
+template <class T>
+static Task<void> block_on_task(Task<T> _task, T* _result,
+                                block_on_state_t* _state) {
+    *_result = co_await std::move(_task);
+    block_on_signal(_state);
+}
+
+template <class T>
+bool Executor::block_on(Task<T>&& _task, T* _result) {
+    if (!_task.valid()) {
+        return false;
+    }
+    block_on_state_t state;
+    state.done = false;
+    if (!spawn(block_on_task(std::move(_task), _result, &state))) {
+        return false;
+    }
+    block_on_wait(&state);
+    return true;
+}
+
+#endif /* CMAKE_KERNEL_EXECUTOR_H */
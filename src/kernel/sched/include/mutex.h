@@ -0,0 +1,103 @@
+
+/**
+ * @file mutex.h
+ * @brief 自适应互斥锁
+ * @author Zone.N (Zone.Niuzh@hotmail.com)
+ * @version 1.0
+ * @date 2026-10-18
+ * @copyright MIT LICENSE
+ * https://github.com/MRNIU/cmake-kernel
+ * @par change log:
+ * <table>
+ * <tr><th>Date<th>Author<th>Description
+ * <tr><td>2026-10-18<td>Zone.N (Zone.Niuzh@hotmail.com)<td>创建文件
+ * </table>
+ */
+
+#ifndef CMAKE_KERNEL_MUTEX_H
+#define CMAKE_KERNEL_MUTEX_H
+
+#include "cstddef"
+#include "cstdint"
+
+#include "sched.h"
+
+/**
+ * @brief 自适应互斥锁，可以在持有期间睡眠
+ * 没有竞争时加锁与解锁都只是一次原子操作。
+ * 有竞争时，持有者正在其它 cpu 上运行就先自旋等待它释放，
+ * 持有者睡眠、自旋超时或本 cpu 需要重新调度时才在等待队列中睡眠。
+ * 不能在中断上下文中使用，可以与 LockGuard 一起使用
+ */
+class Mutex {
+private:
+    /// 有等待者，解锁时需要唤醒
+    static constexpr const uintptr_t WAITERS = 1;
+
+    /// 持有者的 task_t 指针，最低位为 WAITERS，0 表示未加锁
+    uintptr_t owner;
+
+    static bool spin(const uintptr_t* _owner);
+    void        lock_slow(void);
+    void        unlock_slow(void);
+
+public:
+    Mutex(void) : owner(0) {
+    }
+
+    Mutex(const Mutex&)            = delete;
+    Mutex& operator=(const Mutex&) = delete;
+
+    ~Mutex(void) = default;
+
+    void lock(void) {
+        uintptr_t expected = 0;
+        if (!__atomic_compare_exchange_n(
+              &owner, &expected, reinterpret_cast<uintptr_t>(current_task()),
+              false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+            lock_slow();
+        }
+        return;
+    }
+
+    bool try_lock(void) {
+        uintptr_t expected = 0;
+        return __atomic_compare_exchange_n(
+          &owner, &expected, reinterpret_cast<uintptr_t>(current_task()),
+          false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED);
+    }
+
+    void unlock(void) {
+        auto expected = reinterpret_cast<uintptr_t>(current_task());
+        if (!__atomic_compare_exchange_n(&owner, &expected, 0, false,
+                                         __ATOMIC_RELEASE, __ATOMIC_RELAXED)) {
+            unlock_slow();
+        }
+        return;
+    }
+
+    bool is_locked(void) const {
+        return __atomic_load_n(&owner, __ATOMIC_RELAXED) != 0;
+    }
+};
+
+#if ENABLE_BENCH == 1
+/**
+ * @brief 测量互斥锁在线程间移交的延迟
+ * 两个线程反复加锁，统计一个线程解锁到另一个线程获得锁的时间
+ * @param  _iterations             每个线程的加锁次数
+ * @return uint64_t                每次移交的平均纳秒数，无法创建线程时为 0
+ */
+uint64_t mutex_bench_handoff(size_t _iterations);
+
+/**
+ * @brief 测量互斥锁在竞争下的吞吐
+ * 所有线程反复加锁、执行少量工作并解锁
+ * @param  _threads                线程数，不超过 TASK_MAX
+ * @param  _iterations             每个线程的加锁次数
+ * @return uint64_t                全部线程完成的纳秒数，无法创建线程时为 0
+ */
+uint64_t mutex_bench_throughput(size_t _threads, size_t _iterations);
+#endif
+
+#endif /* CMAKE_KERNEL_MUTEX_H */
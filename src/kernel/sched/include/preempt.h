@@ -0,0 +1,90 @@
+
+/**
+ * @file preempt.h
+ * @brief 抢占控制
+ * @author Zone.N (Zone.Niuzh@hotmail.com)
+ * @version 1.0
+ * @date 2026-10-18
+ * @copyright MIT LICENSE
+ * https://github.com/MRNIU/cmake-kernel
+ * @par change log:
+ * <table>
+ * <tr><th>Date<th>Author<th>Description
+ * <tr><td>2026-10-18<td>Zone.N (Zone.Niuzh@hotmail.com)<td>创建文件
+ * </table>
+ */
+
+#ifndef CMAKE_KERNEL_PREEMPT_H
+#define CMAKE_KERNEL_PREEMPT_H
+
+#include "cstddef"
+#include "cstdint"
+
+#include "percpu.h"
+
+/// 每个 cpu 的调度标记: 需要重新调度
+static constexpr const uint32_t SCHED_NEED_RESCHED = 1 << 0;
+/// 每个 cpu 的调度标记: cpu 正在轮询标记或 mwait 监视标记，写入即可唤醒
+static constexpr const uint32_t SCHED_POLLING      = 1 << 1;
+
+/// 调度标记，SCHED_*
+DECLARE_PER_CPU(uint32_t, sched_flags);
+/// 抢占禁止计数，不为 0 时中断返回不会切换任务。
+/// 任务在计数不为 0 时不能睡眠，因此计数属于 cpu 而不是任务
+DECLARE_PER_CPU(uint32_t, preempt_count);
+
+/**
+ * @brief 当前 cpu 是否需要重新调度
+ * @return true                    需要
+ * @return false                   不需要
+ */
+static inline bool need_resched(void) {
+    return (this_cpu_read(sched_flags) & SCHED_NEED_RESCHED) != 0;
+}
+
+/**
+ * @brief 抢占计数回到 0 且需要重新调度时调用
+ * 中断关闭或在中断处理中时直接返回
+ */
+void preempt_schedule(void);
+
+/**
+ * @brief 禁止抢占，可以嵌套
+ */
+static inline void preempt_disable(void) {
+    this_cpu_add<uint32_t>(preempt_count, 1);
+    __atomic_signal_fence(__ATOMIC_SEQ_CST);
+    return;
+}
+
+/**
+ * @brief 允许抢占，期间有重新调度的请求时立即切换
+ */
+static inline void preempt_enable(void) {
+    __atomic_signal_fence(__ATOMIC_SEQ_CST);
+    this_cpu_add<uint32_t>(preempt_count, -1);
+    if ((this_cpu_read(preempt_count) == 0) && need_resched()) {
+        preempt_schedule();
+    }
+    return;
+}
+
+/**
+ * @brief 允许抢占，不检查重新调度的请求
+ */
+static inline void preempt_enable_no_resched(void) {
+    __atomic_signal_fence(__ATOMIC_SEQ_CST);
+    this_cpu_add<uint32_t>(preempt_count, -1);
+    return;
+}
+
+/**
+ * @brief 当前是否可以切换任务
+ * @return true                    抢占计数为 0 且中断打开
+ * @return false                   不能切换
+ */
+static inline bool preemptible(void) {
+    return (this_cpu_read(preempt_count) == 0) && cpu_irq_enabled();
+}
+
+#endif /* CMAKE_KERNEL_PREEMPT_H */
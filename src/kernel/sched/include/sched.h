@@ -0,0 +1,318 @@
+
+/**
+ * @file sched.h
+ * @brief 调度
+ * @author Zone.N (Zone.Niuzh@hotmail.com)
+ * @version 1.0
+ * @date 2026-10-18
+ * @copyright MIT LICENSE
+ * https://github.com/MRNIU/cmake-kernel
+ * @par change log:
+ * <table>
+ * <tr><th>Date<th>Author<th>Description
+ * <tr><td>2026-10-18<td>Zone.N (Zone.Niuzh@hotmail.com)<td>创建文件
+ * </table>
+ */
+
+#ifndef CMAKE_KERNEL_SCHED_H
+#define CMAKE_KERNEL_SCHED_H
+
+#include "cstddef"
+#include "cstdint"
+
+#include "fpu.h"
+#include "intrusive_list.hpp"
+#include "intrusive_rbtree.hpp"
+#include "mm.h"
+#include "preempt.h"
+#include "timer.h"
+#include "trap.h"
+
+/// 任务状态: 可运行或正在运行
+static constexpr const uint32_t TASK_RUNNING          = 0;
+/// 任务状态: 等待唤醒
+static constexpr const uint32_t TASK_BLOCKED          = 1;
+/// 任务状态: 正在被唤醒并迁移到其它 cpu
+static constexpr const uint32_t TASK_WAKING           = 2;
+/// 任务状态: 已创建，尚未第一次唤醒
+static constexpr const uint32_t TASK_NEW              = 3;
+/// 任务状态: 已退出，切换出去后回收
+static constexpr const uint32_t TASK_DEAD             = 4;
+
+/// 最多同时存在的内核线程数，不包括空闲任务
+static constexpr const size_t   TASK_MAX              = 64;
+/// 内核线程的栈大小
+static constexpr const size_t   TASK_STACK_SIZE       = 16 * 1024;
+
+/// nice 值范围，越小权重越大
+static constexpr const int32_t  NICE_MIN              = -20;
+static constexpr const int32_t  NICE_MAX              = 19;
+
+/// 调度类编号，也是优先级，越小越优先
+static constexpr const size_t   SCHED_CLASS_DEADLINE  = 0;
+static constexpr const size_t   SCHED_CLASS_FAIR      = 1;
+static constexpr const size_t   SCHED_CLASS_NR        = 2;
+/// 唤醒延迟直方图的桶数，第 0 个桶为不到 1 微秒，
+/// 第 i 个桶为 [2^(i-1), 2^i) 微秒，最后一个桶包括更大的延迟
+static constexpr const size_t   SCHED_LATENCY_BUCKETS = 24;
+
+struct sched_class_t;
+struct blk_plug_t;
+
+/**
+ * @brief 任务，即内核线程
+ * 任务结构与栈均从静态池中分配，退出后回收
+ */
+struct task_t {
+    /// 切换出去时保存的栈指针
+    uintptr_t            sp;
+    /// TASK_*
+    uint32_t             state;
+    /// 是否计入运行队列，正在运行的任务也为 true
+    bool                 on_rq;
+    /// 是否在 cpu 上运行，切换完成后才清除
+    bool                 on_cpu;
+    /// 所在运行队列的 cpu，只在持有该运行队列的锁时修改
+    size_t               cpu;
+    /// 允许运行的 cpu 位图
+    uint64_t             cpus_allowed;
+    /// 调度类，空闲任务为 nullptr
+    const sched_class_t* sched_class;
+
+    /// 公平调度: 运行队列中的节点，正在运行时不在树中
+    RbNode               run_node;
+    /// 公平调度: 按权重折算的运行时间
+    uint64_t             vruntime;
+    /// 公平调度: 由 nice 得到的权重
+    uint32_t             weight;
+    int32_t              nice;
+
+    /// 本次开始运行或上次记账的时间
+    uint64_t             exec_start;
+    /// 累计运行时间
+    uint64_t             sum_exec;
+    /// 被选中时的 sum_exec，用于计算本次已运行的时间
+    uint64_t             prev_sum_exec;
+    /// 上次停止运行的时间，用于判断缓存是否还是热的
+    uint64_t             last_ran;
+    /// 切换出去的次数
+    uint64_t             nr_switches;
+    /// 被唤醒的时间，切换到它时统计延迟，0 表示不是被唤醒的
+    uint64_t             wake_ts;
+
+    /// 截止时间调度: 每个周期的运行时间、相对截止时间与周期，纳秒
+    uint64_t             dl_runtime;
+    uint64_t             dl_deadline;
+    uint64_t             dl_period;
+    /// 截止时间调度: 占用的带宽，dl_runtime / dl_period 的定点数
+    uint64_t             dl_bw;
+    /// 截止时间调度: 当前作业剩余的运行时间
+    int64_t              dl_budget;
+    /// 截止时间调度: 当前作业的绝对截止时间
+    uint64_t             dl_abs_deadline;
+    /// 截止时间调度: 等待的下一个周期的开始时间，0 表示没有等待
+    uint64_t             dl_release;
+    /// 截止时间调度: 运行队列中的节点
+    RbNode               dl_node;
+    /// 截止时间调度: 是否在运行队列的树中
+    bool                 dl_queued;
+    /// 截止时间调度: 预算已用完，等待下一个周期补充
+    bool                 dl_throttled;
+    /// 截止时间调度: 补充预算与周期开始的定时器
+    ktimer_t             dl_timer;
+    /// 截止时间调度: 错过截止时间的作业数
+    uint64_t             dl_misses;
+    /// 截止时间调度: 预算用完的次数
+    uint64_t             dl_overruns;
+
+    /// 入口与参数
+    void                 (*func)(void* _arg);
+    void*                arg;
+    const char*          name;
+    /// 栈底
+    uint8_t*             stack;
+    /// 空闲池中的节点
+    ListNode             node;
+    /// 浮点/向量状态，只在 kernel_fpu_begin/end 之间被切换出去时使用
+    fpu_state_t          fpu;
+    /// 地址空间，nullptr 表示内核线程，沿用上一个任务的地址空间
+    address_space_t*     mm;
+    /// 块层的请求暂存，nullptr 表示没有暂存
+    blk_plug_t*          plug;
+};
+
+/**
+ * @brief 调度统计，所有 cpu 的总和
+ */
+struct sched_stats_t {
+    /// 各调度类从唤醒到开始运行的延迟直方图
+    uint64_t latency[SCHED_CLASS_NR][SCHED_LATENCY_BUCKETS];
+    /// 各调度类的最大唤醒延迟，纳秒
+    uint64_t latency_max[SCHED_CLASS_NR];
+    /// 截止时间调度: 错过截止时间的作业数
+    uint64_t dl_misses;
+    /// 截止时间调度: 预算用完的次数
+    uint64_t dl_overruns;
+};
+
+/**
+ * @brief 初始化调度器，并将当前执行流作为启动 cpu 的空闲任务
+ * 需要在 time_init 之后，smp_init 之前调用
+ */
+void    sched_init(void);
+
+/**
+ * @brief 将当前执行流作为本 cpu 的空闲任务，由非启动 cpu 调用
+ */
+void    sched_cpu_init(void);
+
+/**
+ * @brief 当前任务
+ * @return task_t*                 当前任务，没有内核线程运行时为空闲任务
+ */
+task_t* current_task(void);
+
+/**
+ * @brief 切换到下一个任务
+ * 当前任务的状态不是 TASK_RUNNING 时将其移出运行队列，
+ * 不能在中断处理中、关抢占或持有自旋锁时调用
+ */
+void    schedule(void);
+
+/**
+ * @brief 让出 cpu，当前任务排到同类的其它任务之后
+ */
+void    yield(void);
+
+/**
+ * @brief 设置当前任务的状态，之后的条件检查不会被重排到它前面
+ * 等待的写法为
+ * set_current_state(TASK_BLOCKED); if (!cond) schedule();
+ * set_current_state(TASK_RUNNING);
+ * @param  _state                  TASK_*
+ */
+void    set_current_state(uint32_t _state);
+
+/**
+ * @brief 唤醒任务，也用于第一次启动新任务
+ * 根据缓存亲和性与各 cpu 的负载选择目标 cpu
+ * @param  _task                   任务
+ * @return true                    任务从等待变为可运行
+ * @return false                   任务已经可运行或已退出
+ */
+bool    task_wakeup(task_t* _task);
+
+/**
+ * @brief 设置任务的 nice 值
+ * @param  _task                   任务
+ * @param  _nice                   NICE_MIN~NICE_MAX，超出时截断
+ */
+void    task_set_nice(task_t* _task, int32_t _nice);
+
+/**
+ * @brief 创建内核线程，创建后处于 TASK_NEW 状态，需要 task_wakeup 启动
+ * @param  _func                   入口，返回时线程退出
+ * @param  _arg                    入口的参数
+ * @param  _name                   名称，不复制
+ * @return task_t*                 任务，任务池耗尽时返回 nullptr
+ */
+task_t* kthread_create(void (*_func)(void* _arg), void* _arg,
+                       const char* _name);
+
+/**
+ * @brief 创建并启动内核线程
+ * @param  _func                   入口，返回时线程退出
+ * @param  _arg                    入口的参数
+ * @param  _name                   名称，不复制
+ * @return task_t*                 任务，任务池耗尽时返回 nullptr
+ */
+task_t* kthread_run(void (*_func)(void* _arg), void* _arg, const char* _name);
+
+/**
+ * @brief 将尚未启动的线程绑定到 _cpu
+ * @param  _task                   TASK_NEW 状态的任务
+ * @param  _cpu                    cpu 编号
+ */
+void    kthread_bind(task_t* _task, size_t _cpu);
+
+/**
+ * @brief 设置尚未启动的线程的地址空间
+ * 切换到该线程时同时切换页表，标签仍然有效时不丢弃 tlb
+ * @param  _task                   TASK_NEW 状态的任务
+ * @param  _as                     地址空间，nullptr 表示内核线程
+ */
+void    kthread_set_mm(task_t* _task, address_space_t* _as);
+
+/**
+ * @brief 退出当前线程
+ */
+[[noreturn]] void kthread_exit(void);
+
+/**
+ * @brief 将尚未启动的线程设为截止时间调度 (EDF)
+ * 每个周期最多运行 _runtime，当前周期的作业需要在周期开始后 _deadline
+ * 内完成。带宽 _runtime / _period 需要通过准入检查:
+ * 选出允许的 cpu 中剩余带宽最多的一个，加上后不超过上限时将线程
+ * 绑定到该 cpu，否则拒绝。预算用完时线程被限流到下一个周期
+ * @param  _task                   TASK_NEW 状态的任务
+ * @param  _runtime                每个周期的运行时间，纳秒
+ * @param  _deadline               相对截止时间，纳秒
+ * @param  _period                 周期，纳秒
+ * @return true                    准入成功
+ * @return false                   参数不合法或带宽不足
+ */
+bool    sched_set_deadline(task_t* _task, uint64_t _runtime,
+                           uint64_t _deadline, uint64_t _period);
+
+/**
+ * @brief 结束当前周期的作业，等待下一个周期开始
+ * 非截止时间调度的任务等同于 yield
+ */
+void    sched_dl_wait_period(void);
+
+/**
+ * @brief 获取调度统计
+ * @param  _stats                  输出
+ */
+void    sched_get_stats(sched_stats_t* _stats);
+
+/**
+ * @brief 中断返回前调用，需要时抢占被中断的任务
+ * @param  _frame                  中断帧
+ */
+void    sched_irq_exit(const trap_frame_t* _frame);
+
+/**
+ * @brief 请求 _cpu 重新调度，_cpu 空闲时将其唤醒
+ * 目标 cpu 正在轮询时只写标记，否则发送处理器间中断
+ * @param  _cpu                    cpu 编号
+ */
+void    resched_cpu(size_t _cpu);
+
+/**
+ * @brief 空闲循环，没有可运行的任务时执行
+ * 先尝试从其它 cpu 偷取任务，再在自适应的时间窗口内轮询调度标记，
+ * 超时后进入低功耗等待
+ */
+[[noreturn]] void cpu_idle_loop(void);
+
+#if ENABLE_BENCH == 1
+/**
+ * @brief 测量上下文切换的延迟
+ * 两个绑定到当前 cpu 的线程交替唤醒对方并等待
+ * @param  _iterations             每个线程的唤醒次数
+ * @return uint64_t                每次切换的平均纳秒数，无法创建线程时为 0
+ */
+uint64_t sched_bench_switch(size_t _iterations);
+
+/**
+ * @brief 测量多线程时的调度吞吐
+ * 所有线程反复执行少量工作并让出 cpu，由调度器在各 cpu 间分布
+ * @param  _threads                线程数，不超过 TASK_MAX
+ * @param  _iterations             每个线程让出 cpu 的次数
+ * @return uint64_t                全部线程完成的纳秒数，无法创建线程时为 0
+ */
+uint64_t sched_bench_throughput(size_t _threads, size_t _iterations);
+#endif
+
+#endif /* CMAKE_KERNEL_SCHED_H */
@@ -0,0 +1,131 @@
+
+/**
+ * @file wait.h
+ * @brief 按地址散列的等待队列
+ * @author Zone.N (Zone.Niuzh@hotmail.com)
+ * @version 1.0
+ * @date 2026-10-18
+ * @copyright MIT LICENSE
+ * https://github.com/MRNIU/cmake-kernel
+ * @par change log:
+ * <table>
+ * <tr><th>Date<th>Author<th>Description
+ * <tr><td>2026-10-18<td>Zone.N (Zone.Niuzh@hotmail.com)<td>创建文件
+ * </table>
+ */
+
+#ifndef CMAKE_KERNEL_WAIT_H
+#define CMAKE_KERNEL_WAIT_H
+
+#include "cstddef"
+#include "cstdint"
+
+#include "intrusive_list.hpp"
+#include "sched.h"
+
+// 等待者按等待的地址散列到固定数量的桶中，每个桶有自己的锁，
+// 不同地址上的睡眠与唤醒一般不会争用同一个锁。
+// 等待的地址只作为键，不会被访问，对象释放后唤醒也是安全的
+
+/**
+ * @brief 等待项，在等待者的栈上
+ */
+struct wait_entry_t {
+    /// 桶中的节点，被唤醒时由唤醒者移出
+    ListNode    node;
+    /// 等待的地址
+    const void* key;
+    task_t*     task;
+};
+
+/**
+ * @brief 加入 _key 的等待队列并将当前任务设为 TASK_BLOCKED
+ * 之后检查条件，不满足时调用 schedule()，最后调用 wait_finish
+ * @param  _entry                  等待项，已在队列中时不重复加入
+ * @param  _key                    等待的地址
+ */
+void   wait_prepare(wait_entry_t* _entry, const void* _key);
+
+/**
+ * @brief 结束等待，恢复 TASK_RUNNING，仍在队列中时移出
+ * @param  _entry                  等待项
+ */
+void   wait_finish(wait_entry_t* _entry);
+
+/**
+ * @brief 在桶的锁保护下检查 _should_sleep，为 true 时睡眠直到被唤醒
+ * 唤醒者先修改条件再唤醒时不会丢失唤醒 (futex 语义)
+ * @param  _key                    等待的地址
+ * @param  _should_sleep           是否需要睡眠
+ * @param  _arg                    _should_sleep 的参数
+ * @return true                    睡眠过，被唤醒后需要重新检查条件
+ * @return false                   条件不成立，没有睡眠
+ */
+bool   wait_on(const void* _key, bool (*_should_sleep)(const void* _arg),
+               const void* _arg);
+
+/**
+ * @brief 唤醒 _key 上最多 _nr 个等待者，按等待的先后顺序
+ * 在桶的锁中只摘下等待者，释放锁后再批量唤醒
+ * @param  _key                    等待的地址
+ * @param  _nr                     最多唤醒的数量
+ * @return size_t                  唤醒的数量
+ */
+size_t wake_up(const void* _key, size_t _nr);
+
+/**
+ * @brief 唤醒 _key 上的全部等待者
+ * @param  _key                    等待的地址
+ * @return size_t                  唤醒的数量
+ */
+size_t wake_up_all(const void* _key);
+
+/**
+ * @brief *_addr 等于 _expected 时睡眠，直到 _addr 上的唤醒
+ * @param  _addr                   等待的地址
+ * @param  _expected               期望的值
+ * @return true                    睡眠过
+ * @return false                   值已改变，没有睡眠
+ */
+template <class T>
+bool wait_on_value(const T* _addr, T _expected) {
+    struct value_t {
+        const T* addr;
+        T        expected;
+    };
+    value_t value = { _addr, _expected };
+    return wait_on(
+      _addr,
+      [](const void* _arg) {
+          auto* val = static_cast<const value_t*>(_arg);
+          return __atomic_load_n(val->addr, __ATOMIC_RELAXED) == val->expected;
+      },
+      &value);
+}
+
+/**
+ * @brief 睡眠直到 _cond() 为 true，每次 _key 上的唤醒后重新检查
+ * 不能在中断上下文中调用
+ * @param  _key                    等待的地址
+ * @param  _cond                   条件
+ * @return true                    睡眠过
+ * @return false                   条件一开始就成立
+ */
+template <class Cond>
+bool wait_event(const void* _key, Cond _cond) {
+    if (_cond()) {
+        return false;
+    }
+    wait_entry_t entry;
+    while (true) {
+        wait_prepare(&entry, _key);
+        if (_cond()) {
+            break;
+        }
+        schedule();
+    }
+    wait_finish(&entry);
+    return true;
+}
+
+#endif /* CMAKE_KERNEL_WAIT_H */
@@ -0,0 +1,263 @@
+
+/**
+ * @file workqueue.h
+ * @brief 工作队列
+ * @author Zone.N (Zone.Niuzh@hotmail.com)
+ * @version 1.0
+ * @date 2026-10-18
+ * @copyright MIT LICENSE
+ * https://github.com/MRNIU/cmake-kernel
+ * @par change log:
+ * <table>
+ * <tr><th>Date<th>Author<th>Description
+ * <tr><td>2026-10-18<td>Zone.N (Zone.Niuzh@hotmail.com)<td>创建文件
+ * </table>
+ */
+
+#ifndef CMAKE_KERNEL_WORKQUEUE_H
+#define CMAKE_KERNEL_WORKQUEUE_H
+
+#include "cstddef"
+#include "cstdint"
+
+#include "intrusive_list.hpp"
+#include "timer.h"
+
+/// 工作项状态: 已加入工作队列或延迟定时器，尚未开始执行
+static constexpr const uint32_t WORK_PENDING     = 1 << 0;
+/// 工作项状态: 正在同步取消，期间不能再加入
+static constexpr const uint32_t WORK_CANCELING   = 1 << 1;
+
+/// 工作队列标志: 不绑定 cpu，由自动伸缩的共享线程池执行
+static constexpr const uint32_t WQ_UNBOUND       = 1 << 0;
+
+/// 不指定 cpu，使用当前 cpu
+static constexpr const size_t   WORK_CPU_UNBOUND = SIZE_MAX;
+
+struct worker_pool_t;
+struct workqueue_t;
+
+/**
+ * @brief 工作项
+ * 嵌入到使用者的对象中，不分配内存。
+ * 回调在工作线程中执行，可以睡眠；回调开始前工作项已不再挂起，
+ * 可以在回调中重新加入，也可以释放工作项所在的对象。
+ * 同一个工作项在同一个线程池中不会并发执行
+ */
+struct work_t {
+    /// 所在池的工作列表
+    ListNode       node;
+    /// 回调函数
+    void           (*func)(work_t* _work);
+    /// WORK_*
+    uint32_t       flags;
+    /// 最近一次加入的池
+    worker_pool_t* pool;
+    /// 最近一次加入的工作队列
+    workqueue_t*   wq;
+};
+
+/**
+ * @brief 延迟工作项，定时器到期后加入工作队列
+ */
+struct delayed_work_t {
+    work_t       work;
+    ktimer_t     timer;
+    /// 到期后加入的工作队列与 cpu
+    workqueue_t* wq;
+    size_t       cpu;
+};
+
+/**
+ * @brief 工作队列
+ * 不拥有线程，工作项由绑定到各 cpu 的线程池或共享的非绑定池执行，
+ * 工作队列只记录属性与尚未完成的工作项数
+ */
+struct workqueue_t {
+    const char* name;
+    /// WQ_*
+    uint32_t    flags;
+    /// 已加入线程池、尚未执行完的工作项数
+    size_t      nr_active;
+};
+
+/// 系统工作队列，工作项在加入时的 cpu 上执行
+extern workqueue_t system_wq;
+/// 系统非绑定工作队列，适合耗时较长或需要并行的工作
+extern workqueue_t system_unbound_wq;
+
+/**
+ * @brief 初始化线程池与系统工作队列，由启动 cpu 在 sched_init 之后调用
+ */
+void workqueues_init(void);
+
+/**
+ * @brief 启动当前 cpu 的绑定线程池，由每个非启动 cpu 在 sched_cpu_init
+ * 之后调用
+ */
+void workqueues_cpu_init(void);
+
+/**
+ * @brief 初始化工作队列
+ * @param  _wq                     工作队列
+ * @param  _name                   名称，不复制
+ * @param  _flags                  WQ_*
+ */
+void workqueue_init(workqueue_t* _wq, const char* _name, uint32_t _flags);
+
+/**
+ * @brief 初始化工作项
+ * @param  _work                   工作项
+ * @param  _func                   回调函数
+ */
+void work_init(work_t* _work, void (*_func)(work_t* _work));
+
+/**
+ * @brief 初始化延迟工作项
+ * @param  _dwork                  延迟工作项
+ * @param  _func                   回调函数，参数为 &_dwork->work
+ */
+void delayed_work_init(delayed_work_t* _dwork, void (*_func)(work_t* _work));
+
+/**
+ * @brief 由工作项得到所在的延迟工作项
+ * @param  _work                   delayed_work_t::work
+ * @return delayed_work_t*         延迟工作项
+ */
+static inline delayed_work_t* to_delayed_work(work_t* _work) {
+    return reinterpret_cast<delayed_work_t*>(
+      reinterpret_cast<uintptr_t>(_work) - offsetof(delayed_work_t, work));
+}
+
+/**
+ * @brief 工作项是否挂起
+ * @param  _work                   工作项
+ * @return true                    已加入，尚未开始执行
+ */
+static inline bool work_pending(const work_t* _work) {
+    return (__atomic_load_n(&_work->flags, __ATOMIC_ACQUIRE) & WORK_PENDING)
+           != 0;
+}
+
+/**
+ * @brief 将工作项加入 _cpu 的线程池，可以在中断上下文中调用
+ * 非绑定工作队列忽略 _cpu；_cpu 还没有工作线程时使用非绑定池
+ * @param  _cpu                    cpu 编号，WORK_CPU_UNBOUND 表示当前 cpu
+ * @param  _wq                     工作队列
+ * @param  _work                   工作项
+ * @return true                    已加入
+ * @return false                   已经挂起或正在同步取消
+ */
+bool queue_work_on(size_t _cpu, workqueue_t* _wq, work_t* _work);
+
+/**
+ * @brief 将工作项加入当前 cpu 的线程池
+ * @param  _wq                     工作队列
+ * @param  _work                   工作项
+ * @return true                    已加入
+ * @return false                   已经挂起或正在同步取消
+ */
+bool queue_work(workqueue_t* _wq, work_t* _work);
+
+/**
+ * @brief 将工作项加入 system_wq
+ * @param  _work                   工作项
+ * @return true                    已加入
+ * @return false                   已经挂起或正在同步取消
+ */
+bool schedule_work(work_t* _work);
+
+/**
+ * @brief _delay 纳秒后将工作项加入 _cpu 的线程池
+ * @param  _cpu                    cpu 编号，WORK_CPU_UNBOUND 表示到期时的 cpu
+ * @param  _wq                     工作队列
+ * @param  _dwork                  延迟工作项
+ * @param  _delay                  延迟，纳秒，为 0 时立即加入
+ * @return true                    已加入
+ * @return false                   已经挂起或正在同步取消
+ */
+bool queue_delayed_work_on(size_t _cpu, workqueue_t* _wq,
+                           delayed_work_t* _dwork, uint64_t _delay);
+
+/**
+ * @brief _delay 纳秒后将工作项加入工作队列
+ * @param  _wq                     工作队列
+ * @param  _dwork                  延迟工作项
+ * @param  _delay                  延迟，纳秒，为 0 时立即加入
+ * @return true                    已加入
+ * @return false                   已经挂起或正在同步取消
+ */
+bool queue_delayed_work(workqueue_t* _wq, delayed_work_t* _dwork,
+                        uint64_t _delay);
+
+/**
+ * @brief 等待工作项执行完，不能在中断上下文中调用
+ * 回调不断重新加入自己时可能一直等待
+ * @param  _work                   工作项
+ * @return true                    工作项挂起或正在执行，已等待
+ * @return false                   工作项空闲
+ */
+bool flush_work(work_t* _work);
+
+/**
+ * @brief 立即加入延迟工作项并等待它执行完，不能在中断上下文中调用
+ * @param  _dwork                  延迟工作项
+ * @return true                    工作项挂起或正在执行，已等待
+ * @return false                   工作项空闲
+ */
+bool flush_delayed_work(delayed_work_t* _dwork);
+
+/**
+ * @brief 等待工作队列中已加入线程池的工作项全部执行完，
+ * 不包括定时器尚未到期的延迟工作项。不能在中断上下文中调用
+ * @param  _wq                     工作队列
+ */
+void flush_workqueue(workqueue_t* _wq);
+
+/**
+ * @brief 取消尚未开始执行的工作项，不等待正在执行的回调
+ * @param  _work                   工作项
+ * @return true                    工作项挂起，已取消
+ * @return false                   工作项没有在工作列表中
+ */
+bool cancel_work(work_t* _work);
+
+/**
+ * @brief 取消工作项并等待正在执行的回调结束，不能在中断上下文中调用
+ * 期间工作项不能被重新加入，返回后可以释放
+ * @param  _work                   工作项
+ * @return true                    工作项挂起，已取消
+ * @return false                   工作项没有挂起
+ */
+bool cancel_work_sync(work_t* _work);
+
+/**
+ * @brief 取消尚未开始执行的延迟工作项，不等待正在执行的回调
+ * @param  _dwork                  延迟工作项
+ * @return true                    工作项挂起，已取消
+ * @return false                   工作项没有挂起，或正在由定时器加入
+ */
+bool cancel_delayed_work(delayed_work_t* _dwork);
+
+/**
+ * @brief 取消延迟工作项并等待正在执行的回调结束，不能在中断上下文中调用
+ * @param  _dwork                  延迟工作项
+ * @return true                    工作项挂起，已取消
+ * @return false                   工作项没有挂起
+ */
+bool cancel_delayed_work_sync(delayed_work_t* _dwork);
+
+/**
+ * @brief 将 [0, _count) 按 _grain 分块，由调用者与非绑定池的工作线程并行执行
+ * 各线程从共享的游标领取下一块，调用者完成后取消还没有开始的工作项，
+ * 适合页清零、校验和等可以任意切分的工作。不能在中断上下文中调用
+ * @param  _count                  元素数
+ * @param  _grain                  每块的元素数，为 0 时视为 1
+ * @param  _func                   处理 [_begin, _end) 的函数，可以并发调用
+ * @param  _arg                    _func 的参数
+ */
+void parallel_for(size_t _count, size_t _grain,
+                  void (*_func)(size_t _begin, size_t _end, void* _arg),
+                  void* _arg);
+
+#endif /* CMAKE_KERNEL_WORKQUEUE_H */
@@ -0,0 +1,93 @@
+
+/**
+ * @file mutex.cpp
+ * @brief 自适应互斥锁
+ * @author Zone.N (Zone.Niuzh@hotmail.com)
+ * @version 1.0
+ * @date 2026-10-18
+ * @copyright MIT LICENSE
+ * https://github.com/MRNIU/cmake-kernel
+ * @par change log:
+ * <table>
+ * <tr><th>Date<th>Author<th>Description
+ * <tr><td>2026-10-18<td>Zone.N (Zone.Niuzh@hotmail.com)<td>创建文件
+ * </table>
+ */
+
+#include "cpu.h"
+#include "ktime.h"
+#include "mutex.h"
+#include "preempt.h"
+#include "sched.h"
+#include "wait.h"
+
+/// 持有者在运行时最多自旋的时间，超过后睡眠
+static constexpr const uint64_t MUTEX_SPIN_MAX_NS = 20000;
+
+/**
+ * @brief 持有者正在运行时自旋，直到锁被释放或不再值得自旋
+ * @return true                    锁已被释放，可以重试
+ */
+bool Mutex::spin(const uintptr_t* _owner) {
+    auto start = ktime_get_ns();
+    auto ret   = false;
+    // 自旋期间不被抢占，避免持有 cpu 的自旋者挡住持有者
+    preempt_disable();
+    while (true) {
+        auto word = __atomic_load_n(_owner, __ATOMIC_RELAXED);
+        if (word == 0) {
+            ret = true;
+            break;
+        }
+        // 已有等待者在睡眠，排在它们后面
+        if ((word & WAITERS) != 0) {
+            break;
+        }
+        // 任务结构来自静态池，持有者退出后访问仍然安全
+        auto* task = reinterpret_cast<task_t*>(word);
+        if (!__atomic_load_n(&task->on_cpu, __ATOMIC_RELAXED) || need_resched()
+            || (ktime_get_ns() - start >= MUTEX_SPIN_MAX_NS)) {
+            break;
+        }
+        cpu_relax();
+    }
+    preempt_enable();
+    return ret;
+}
+
+void Mutex::lock_slow(void) {
+    auto self = reinterpret_cast<uintptr_t>(current_task());
+    // 睡眠过之后可能还有其它等待者，获得锁时保留 WAITERS，
+    // 解锁时多一次可能为空的唤醒，但不会丢失唤醒
+    uintptr_t acquire = self;
+    while (true) {
+        uintptr_t expected = 0;
+        if (__atomic_compare_exchange_n(&owner, &expected, acquire, false,
+                                        __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+            return;
+        }
+        if (spin(&owner)) {
+            continue;
+        }
+        auto word = __atomic_load_n(&owner, __ATOMIC_RELAXED);
+        if (word == 0) {
+            continue;
+        }
+        if ((word & WAITERS) == 0) {
+            if (!__atomic_compare_exchange_n(&owner, &word, word | WAITERS,
+                                             false, __ATOMIC_RELAXED,
+                                             __ATOMIC_RELAXED)) {
+                continue;
+            }
+            word |= WAITERS;
+        }
+        wait_on_value(&owner, word);
+        acquire = self | WAITERS;
+    }
+}
+
+void Mutex::unlock_slow(void) {
+    __atomic_store_n(&owner, 0, __ATOMIC_RELEASE);
+    wake_up(&owner, 1);
+    return;
+}
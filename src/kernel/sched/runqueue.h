@@ -0,0 +1,239 @@
+
+/**
+ * @file runqueue.h
+ * @brief 运行队列与调度类
+ * @author Zone.N (Zone.Niuzh@hotmail.com)
+ * @version 1.0
+ * @date 2026-10-18
+ * @copyright MIT LICENSE
+ * https://github.com/MRNIU/cmake-kernel
+ * @par change log:
+ * <table>
+ * <tr><th>Date<th>Author<th>Description
+ * <tr><td>2026-10-18<td>Zone.N (Zone.Niuzh@hotmail.com)<td>创建文件
+ * </table>
+ */
+
+#ifndef CMAKE_KERNEL_RUNQUEUE_H
+#define CMAKE_KERNEL_RUNQUEUE_H
+
+#include "cstddef"
+#include "cstdint"
+
+#include "intrusive_rbtree.hpp"
+#include "libcxx.h"
+#include "percpu.h"
+#include "sched.h"
+#include "spinlock.hpp"
+#include "timer.h"
+
+/// 调度周期，可运行的任务在一个周期内都至少运行一次
+static constexpr const uint64_t SCHED_LATENCY_NS            = 6000000;
+/// 每个任务一次至少运行的时间
+static constexpr const uint64_t SCHED_MIN_GRANULARITY_NS    = 750000;
+/// 被唤醒的任务领先超过该值时才抢占当前任务，减少切换
+static constexpr const uint64_t SCHED_WAKEUP_GRANULARITY_NS = 1000000;
+/// 停止运行不到该时间的任务认为缓存还是热的，尽量不迁移
+static constexpr const uint64_t SCHED_MIGRATION_COST_NS     = 500000;
+/// 有任务运行时的时钟周期，cpu 空闲时停止
+static constexpr const uint64_t SCHED_TICK_NS               = 1000000;
+/// nice 为 0 时的权重
+static constexpr const uint32_t NICE_0_WEIGHT               = 1024;
+
+/// enqueue 标记: 从等待中唤醒
+static constexpr const uint32_t ENQUEUE_WAKEUP              = 1 << 0;
+/// enqueue 标记: 新任务第一次入队
+static constexpr const uint32_t ENQUEUE_NEW                 = 1 << 1;
+/// enqueue 标记: 从其它 cpu 迁移而来，已经过 migrate 处理
+static constexpr const uint32_t ENQUEUE_MIGRATED            = 1 << 2;
+/// dequeue 标记: 任务进入等待
+static constexpr const uint32_t DEQUEUE_SLEEP               = 1 << 0;
+
+/// 截止时间调度的带宽定点数的小数位数
+static constexpr const uint32_t DL_BW_SHIFT                 = 20;
+/// 每个 cpu 上截止时间调度的带宽上限，百分比，余下的留给公平调度
+static constexpr const uint64_t DL_BW_LIMIT_PERCENT         = 95;
+/// 截止时间调度每个周期的最小运行时间，更小时记账误差过大
+static constexpr const uint64_t DL_MIN_RUNTIME_NS           = 100000;
+/// 截止时间调度每个周期的最大运行时间，左移 DL_BW_SHIFT 后不超过 64 位
+static constexpr const uint64_t DL_MAX_RUNTIME_NS           =
+    UINT64_MAX >> DL_BW_SHIFT;
+
+struct rq_t;
+
+/**
+ * @brief 调度类
+ * 所有函数都在持有运行队列的锁、关中断时调用。
+ * 正在运行的任务 (rq->curr) 不在调度类的队列中，
+ * 由 pick_next 取出，由 put_prev 放回
+ */
+struct sched_class_t {
+    /// 优先级，越小越优先，高优先级的类有可运行的任务时低优先级的类不运行
+    size_t rank;
+    /// 加入队列，ENQUEUE_*
+    void    (*enqueue)(rq_t* _rq, task_t* _task, uint32_t _flags);
+    /// 移出队列，DEQUEUE_*，_task 可能是 rq->curr
+    void    (*dequeue)(rq_t* _rq, task_t* _task, uint32_t _flags);
+    /// 取出下一个要运行的任务，没有时返回 nullptr
+    task_t* (*pick_next)(rq_t* _rq);
+    /// 当前任务停止运行，仍可运行时放回队列
+    void    (*put_prev)(rq_t* _rq, task_t* _task);
+    /// 将当前任务的运行时间记账
+    void    (*update_curr)(rq_t* _rq);
+    /// 时钟，需要抢占时调用 resched_curr
+    void    (*tick)(rq_t* _rq, task_t* _curr);
+    /// 同类的 _task 被唤醒时是否应抢占当前任务
+    bool    (*check_preempt)(rq_t* _rq, task_t* _task);
+    /// 当前任务让出 cpu
+    void    (*yield)(rq_t* _rq);
+    /// 选出一个可以迁移到 _dst_cpu 的任务，不取出，没有时返回 nullptr
+    task_t* (*steal)(rq_t* _rq, size_t _dst_cpu);
+    /// _task 离开 _rq，之后以 ENQUEUE_MIGRATED 加入其它队列
+    void    (*migrate)(rq_t* _rq, task_t* _task);
+    /// 当前任务距下一次需要检查抢占的时间，用于设置周期时钟
+    uint64_t (*next_tick)(rq_t* _rq, task_t* _curr);
+    /// _task 已退出并切换出去，释放调度类的资源，可以为 nullptr
+    void    (*task_dead)(task_t* _task);
+};
+
+/**
+ * @brief 按 vruntime 排序，需要处理回绕
+ */
+struct VruntimeLess {
+    bool operator()(const task_t& _a, const task_t& _b) const {
+        return static_cast<int64_t>(_a.vruntime - _b.vruntime) < 0;
+    }
+};
+
+/**
+ * @brief 按绝对截止时间排序，需要处理回绕
+ */
+struct DeadlineLess {
+    bool operator()(const task_t& _a, const task_t& _b) const {
+        return static_cast<int64_t>(_a.dl_abs_deadline - _b.dl_abs_deadline)
+               < 0;
+    }
+};
+
+/**
+ * @brief 截止时间调度的队列
+ */
+struct dl_rq_t {
+    /// 等待运行且未被限流的任务，按绝对截止时间排序
+    IntrusiveRbTree<task_t, &task_t::dl_node, DeadlineLess> tree;
+    /// 绑定到本 cpu 的任务的带宽之和，由 dl_bw_lock 保护
+    uint64_t total_bw;
+    /// 任务数，包括正在运行与被限流的任务
+    size_t   nr_running;
+};
+
+/**
+ * @brief 公平调度的队列
+ */
+struct cfs_rq_t {
+    /// 等待运行的任务，按 vruntime 排序
+    IntrusiveRbTree<task_t, &task_t::run_node, VruntimeLess> tree;
+    /// 单调递增的最小 vruntime，新加入的任务以它为基准
+    uint64_t min_vruntime;
+    /// 权重之和，包括正在运行的任务
+    uint64_t load;
+    /// 任务数，包括正在运行的任务
+    size_t   nr_running;
+};
+
+/**
+ * @brief 每个 cpu 的运行队列
+ */
+struct alignas(CACHE_LINE_SIZE) rq_t {
+    /// 保护本结构以及队列中任务的调度字段，需要关中断
+    TicketLock lock;
+    /// 所属 cpu
+    size_t     cpu;
+    /// 可运行的任务数，包括正在运行的，不包括空闲任务。
+    /// 其它 cpu 不加锁读取，用于选择目标 cpu
+    size_t     nr_running;
+    /// 正在运行的任务
+    task_t*    curr;
+    /// 空闲任务
+    task_t*    idle;
+    /// 切换前的任务，由切换后的任务在 finish_switch 中处理
+    task_t*    prev;
+    /// 最近一次更新的时间
+    uint64_t   clock;
+    /// 切换次数
+    uint64_t   nr_switches;
+    /// 截止时间调度队列
+    dl_rq_t    dl;
+    /// 公平调度队列
+    cfs_rq_t   cfs;
+    /// 有任务运行时的周期时钟
+    ktimer_t   tick;
+    /// 各调度类从唤醒到开始运行的延迟直方图，见 SCHED_LATENCY_BUCKETS
+    uint64_t   latency[SCHED_CLASS_NR][SCHED_LATENCY_BUCKETS];
+    /// 各调度类的最大唤醒延迟
+    uint64_t   latency_max[SCHED_CLASS_NR];
+    /// 截止时间调度: 错过截止时间的作业数
+    uint64_t   dl_misses;
+    /// 截止时间调度: 预算用完的次数
+    uint64_t   dl_overruns;
+};
+
+/// 各 cpu 的运行队列
+extern rq_t runqueues[MAX_CPU_COUNT];
+
+/// 截止时间调度类
+extern const sched_class_t dl_sched_class;
+/// 公平调度类
+extern const sched_class_t fair_sched_class;
+
+static inline rq_t* cpu_rq(size_t _cpu) {
+    return &runqueues[_cpu];
+}
+
+static inline rq_t* this_rq(void) {
+    return &runqueues[cpu_id()];
+}
+
+/**
+ * @brief 请求运行队列所在的 cpu 重新调度
+ */
+static inline void resched_curr(rq_t* _rq) {
+    resched_cpu(_rq->cpu);
+    return;
+}
+
+/**
+ * @brief nice 值对应的权重
+ * @param  _nice                   NICE_MIN~NICE_MAX
+ * @return uint32_t                权重，nice 为 0 时为 NICE_0_WEIGHT
+ */
+uint32_t fair_nice_to_weight(int32_t _nice);
+
+/**
+ * @brief 更新运行队列的时间，需要持有锁
+ */
+void update_rq_clock(rq_t* _rq);
+
+/**
+ * @brief cpu 是否已初始化运行队列，可以接收任务
+ */
+bool cpu_active(size_t _cpu);
+
+/**
+ * @brief 锁定任务所在的运行队列，返回时任务不会被迁移，需要关中断
+ */
+rq_t* task_rq_lock(task_t* _task);
+
+/**
+ * @brief 刚加入队列或解除限流的 _task 是否应抢占当前任务，需要持有锁
+ */
+void check_preempt_curr(rq_t* _rq, task_t* _task);
+
+/**
+ * @brief 尝试从最忙的 cpu 偷取一个任务到当前 cpu，由空闲任务调用
+ * @return true                    偷到了任务，当前 cpu 需要重新调度
+ * @return false                   没有可偷的任务
+ */
+bool sched_idle_steal(void);
+
+#endif /* CMAKE_KERNEL_RUNQUEUE_H */
@@ -0,0 +1,147 @@
+
+/**
+ * @file wait.cpp
+ * @brief 按地址散列的等待队列
+ * @author Zone.N (Zone.Niuzh@hotmail.com)
+ * @version 1.0
+ * @date 2026-10-18
+ * @copyright MIT LICENSE
+ * https://github.com/MRNIU/cmake-kernel
+ * @par change log:
+ * <table>
+ * <tr><th>Date<th>Author<th>Description
+ * <tr><td>2026-10-18<td>Zone.N (Zone.Niuzh@hotmail.com)<td>创建文件
+ * </table>
+ */
+
+#include "cpu.h"
+#include "libcxx.h"
+#include "sched.h"
+#include "spinlock.hpp"
+#include "wait.h"
+
+/// 桶数，2 的幂
+static constexpr const size_t WAIT_TABLE_SIZE = 256;
+/// 每次持有桶的锁最多摘下的等待者数
+static constexpr const size_t WAKE_BATCH      = 16;
+
+/**
+ * @brief 桶
+ */
+struct alignas(CACHE_LINE_SIZE) wait_bucket_t {
+    TicketLock                                       lock;
+    IntrusiveList<wait_entry_t, &wait_entry_t::node> waiters;
+    /// 等待者数，唤醒者据此跳过空桶，不需要加锁
+    size_t                                           nr_waiters;
+};
+
+static wait_bucket_t wait_table[WAIT_TABLE_SIZE];
+
+static wait_bucket_t* wait_bucket(const void* _key) {
+    auto hash = (reinterpret_cast<uintptr_t>(_key) >> 3)
+                * 0x9E3779B97F4A7C15ULL;
+    return &wait_table[hash >> (64 - __builtin_ctzll(WAIT_TABLE_SIZE))];
+}
+
+/**
+ * @brief 加入桶，需要持有桶的锁
+ */
+static void wait_enqueue(wait_bucket_t* _bucket, wait_entry_t* _entry,
+                         const void* _key) {
+    _entry->key  = _key;
+    _entry->task = current_task();
+    _bucket->waiters.push_back(*_entry);
+    // 与唤醒者的修改条件构成先写后读
+    __atomic_add_fetch(&_bucket->nr_waiters, 1, __ATOMIC_SEQ_CST);
+    return;
+}
+
+static void wait_dequeue(wait_bucket_t* _bucket, wait_entry_t* _entry) {
+    _bucket->waiters.erase(*_entry);
+    __atomic_sub_fetch(&_bucket->nr_waiters, 1, __ATOMIC_RELAXED);
+    return;
+}
+
+void wait_prepare(wait_entry_t* _entry, const void* _key) {
+    auto* bucket = wait_bucket(_key);
+    {
+        IrqLockGuard<TicketLock> guard(bucket->lock);
+        if (!_entry->node.is_linked()) {
+            wait_enqueue(bucket, _entry, _key);
+        }
+    }
+    set_current_state(TASK_BLOCKED);
+    return;
+}
+
+void wait_finish(wait_entry_t* _entry) {
+    set_current_state(TASK_RUNNING);
+    // 被唤醒时已经移出，唤醒者在锁中完成移出，这里不需要加锁即可判断
+    if (!__atomic_load_n(&_entry->node.next, __ATOMIC_ACQUIRE)) {
+        return;
+    }
+    auto*                    bucket = wait_bucket(_entry->key);
+    IrqLockGuard<TicketLock> guard(bucket->lock);
+    if (_entry->node.is_linked()) {
+        wait_dequeue(bucket, _entry);
+    }
+    return;
+}
+
+bool wait_on(const void* _key, bool (*_should_sleep)(const void* _arg),
+             const void* _arg) {
+    auto*        bucket = wait_bucket(_key);
+    wait_entry_t entry;
+    {
+        IrqLockGuard<TicketLock> guard(bucket->lock);
+        wait_enqueue(bucket, &entry, _key);
+        if (!_should_sleep(_arg)) {
+            wait_dequeue(bucket, &entry);
+            return false;
+        }
+        set_current_state(TASK_BLOCKED);
+    }
+    schedule();
+    wait_finish(&entry);
+    return true;
+}
+
+size_t wake_up(const void* _key, size_t _nr) {
+    auto* bucket = wait_bucket(_key);
+    // 与等待者的加入等待队列构成先写后读
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&bucket->nr_waiters, __ATOMIC_RELAXED) == 0) {
+        return 0;
+    }
+    size_t total = 0;
+    while (total < _nr) {
+        task_t* batch[WAKE_BATCH];
+        size_t  count = 0;
+        {
+            IrqLockGuard<TicketLock> guard(bucket->lock);
+            auto* entry = bucket->waiters.front();
+            while ((entry != nullptr) && (count < WAKE_BATCH)
+                   && (total + count < _nr)) {
+                auto* next = bucket->waiters.next(*entry);
+                if (entry->key == _key) {
+                    batch[count++] = entry->task;
+                    // 移出后等待者可能立即返回，不再访问 entry
+                    wait_dequeue(bucket, entry);
+                }
+                entry = next;
+            }
+        }
+        for (size_t i = 0; i < count; i++) {
+            task_wakeup(batch[i]);
+        }
+        total += count;
+        if (count < WAKE_BATCH) {
+            break;
+        }
+    }
+    return total;
+}
+
+size_t wake_up_all(const void* _key) {
+    return wake_up(_key, SIZE_MAX);
+}
@@ -0,0 +1,639 @@
+
+/**
+ * @file workqueue.cpp
+ * @brief 工作队列与工作线程池
+ * @author Zone.N (Zone.Niuzh@hotmail.com)
+ * @version 1.0
+ * @date 2026-10-18
+ * @copyright MIT LICENSE
+ * https://github.com/MRNIU/cmake-kernel
+ * @par change log:
+ * <table>
+ * <tr><th>Date<th>Author<th>Description
+ * <tr><td>2026-10-18<td>Zone.N (Zone.Niuzh@hotmail.com)<td>创建文件
+ * </table>
+ */
+
+#include "cpu.h"
+#include "ktime.h"
+#include "libcxx.h"
+#include "sched.h"
+#include "smp.h"
+#include "spinlock.hpp"
+#include "timer.h"
+#include "wait.h"
+#include "workqueue.h"
+
+// 每个 cpu 有一个绑定线程池，另有一个所有 cpu 共享的非绑定线程池，
+// 工作队列只决定工作项进入哪个池。
+// 池中没有空闲线程时按需创建新线程: 非绑定池直到线程数达到 cpu 数的两倍，
+// 绑定池的线程在同一个 cpu 上竞争，只在正在执行的工作项都运行了
+// WQ_STALL_NS 以上 (通常是在睡眠) 时才增加。
+// 空闲超过 WQ_IDLE_TIMEOUT_NS 的线程退出，每个池至少保留一个
+
+/// 每个绑定池的最大线程数
+static constexpr const size_t   WQ_BOUND_MAX_WORKERS   = 2;
+/// 非绑定池的最大线程数
+static constexpr const size_t   WQ_UNBOUND_MAX_WORKERS = 16;
+/// 工作线程总数
+static constexpr const size_t   WORKER_MAX
+  = MAX_CPU_COUNT * WQ_BOUND_MAX_WORKERS + WQ_UNBOUND_MAX_WORKERS;
+/// 空闲线程的退出时间
+static constexpr const uint64_t WQ_IDLE_TIMEOUT_NS     = 300000000;
+/// 绑定池的工作项运行超过该时间视为阻塞，允许增加线程
+static constexpr const uint64_t WQ_STALL_NS            = 10000000;
+
+/**
+ * @brief 工作线程
+ */
+struct worker_t {
+    /// 空闲列表中的节点
+    ListNode       node;
+    task_t*        task;
+    worker_pool_t* pool;
+    /// 正在执行的工作项
+    work_t*        current;
+    /// 开始执行 current 的时间
+    uint64_t       start;
+    /// 开始空闲的时间，忙碌时为 0
+    uint64_t       idle_since;
+    /// 空闲超时后唤醒线程
+    ktimer_t       timer;
+    /// 是否已分配
+    bool           used;
+};
+
+/**
+ * @brief 线程池
+ */
+struct alignas(CACHE_LINE_SIZE) worker_pool_t {
+    TicketLock                                lock;
+    /// 等待执行的工作项
+    IntrusiveList<work_t, &work_t::node>      worklist;
+    /// 空闲线程，最近空闲的在前
+    IntrusiveList<worker_t, &worker_t::node>  idle;
+    /// 绑定的 cpu，非绑定池为 WORK_CPU_UNBOUND
+    size_t                                    cpu;
+    /// 线程数，包括正在创建的
+    size_t                                    nr_workers;
+    /// 是否有线程正在创建，避免同时创建多个
+    bool                                      spawning;
+    /// 是否可以使用
+    bool                                      online;
+};
+
+/**
+ * @brief parallel_for 的共享状态
+ */
+struct parallel_job_t {
+    void   (*func)(size_t _begin, size_t _end, void* _arg);
+    void*  arg;
+    size_t count;
+    size_t grain;
+    /// 下一块的起点
+    size_t next;
+};
+
+/**
+ * @brief parallel_for 交给工作线程的工作项
+ */
+struct parallel_helper_t {
+    work_t          work;
+    parallel_job_t* job;
+};
+
+workqueue_t system_wq;
+workqueue_t system_unbound_wq;
+
+static worker_pool_t cpu_pools[MAX_CPU_COUNT];
+static worker_pool_t unbound_pool;
+
+static worker_t   workers[WORKER_MAX];
+/// 保护 workers 的分配
+static TicketLock workers_lock;
+
+static worker_t* timer_worker(ktimer_t* _timer) {
+    return reinterpret_cast<worker_t*>(reinterpret_cast<uintptr_t>(_timer)
+                                       - offsetof(worker_t, timer));
+}
+
+static delayed_work_t* timer_dwork(ktimer_t* _timer) {
+    return reinterpret_cast<delayed_work_t*>(
+      reinterpret_cast<uintptr_t>(_timer) - offsetof(delayed_work_t, timer));
+}
+
+/**
+ * @brief 工作项完成或被取消后唤醒等待它与它所在工作队列的任务
+ * 只使用地址作为键，工作项可能已经释放
+ */
+static void wake_flushers(const work_t* _work, const workqueue_t* _wq) {
+    wake_up_all(_work);
+    wake_up_all(_wq);
+    return;
+}
+
+/**
+ * @brief 是否有线程正在执行 _work
+ */
+static bool work_running(const work_t* _work) {
+    for (auto& worker : workers) {
+        if (__atomic_load_n(&worker.current, __ATOMIC_ACQUIRE) == _work) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief 工作项是否挂起或正在执行
+ */
+static bool work_busy(const work_t* _work) {
+    // 线程先设置 current 再清除 WORK_PENDING，两者不会同时看不到
+    return work_pending(_work) || work_running(_work);
+}
+
+/**
+ * @brief 设置 WORK_PENDING
+ * @return true                    由调用者加入
+ */
+static bool work_claim(work_t* _work) {
+    auto old = __atomic_load_n(&_work->flags, __ATOMIC_RELAXED);
+    do {
+        if ((old & (WORK_PENDING | WORK_CANCELING)) != 0) {
+            return false;
+        }
+    } while (!__atomic_compare_exchange_n(&_work->flags, &old,
+                                          old | WORK_PENDING, true,
+                                          __ATOMIC_ACQUIRE, __ATOMIC_RELAXED));
+    return true;
+}
+
+static size_t pool_max_workers(const worker_pool_t* _pool) {
+    if (_pool->cpu != WORK_CPU_UNBOUND) {
+        return WQ_BOUND_MAX_WORKERS;
+    }
+    auto max = 2 * smp_cpu_count();
+    return max < WQ_UNBOUND_MAX_WORKERS ? max : WQ_UNBOUND_MAX_WORKERS;
+}
+
+/**
+ * @brief 池中的线程是否都在执行运行了很久的工作项，需要持有池的锁
+ */
+static bool pool_stalled(const worker_pool_t* _pool) {
+    auto now = ktime_get_ns();
+    for (auto& worker : workers) {
+        if ((worker.pool == _pool) && (worker.current != nullptr)
+            && (now - worker.start < WQ_STALL_NS)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief 是否需要为没有空闲线程的池创建线程，需要持有池的锁
+ * 需要时先计入 nr_workers
+ */
+static bool pool_need_spawn(worker_pool_t* _pool) {
+    if (!_pool->online || _pool->spawning || !_pool->idle.empty()
+        || (_pool->nr_workers >= pool_max_workers(_pool))) {
+        return false;
+    }
+    if ((_pool->cpu != WORK_CPU_UNBOUND) && (_pool->nr_workers != 0)
+        && !pool_stalled(_pool)) {
+        return false;
+    }
+    _pool->spawning = true;
+    _pool->nr_workers++;
+    return true;
+}
+
+static worker_t* worker_alloc(void) {
+    IrqLockGuard<TicketLock> guard(workers_lock);
+    for (auto& worker : workers) {
+        if (!worker.used) {
+            worker.used = true;
+            return &worker;
+        }
+    }
+    return nullptr;
+}
+
+static void worker_free(worker_t* _worker) {
+    IrqLockGuard<TicketLock> guard(workers_lock);
+    _worker->pool = nullptr;
+    _worker->used = false;
+    return;
+}
+
+static void worker_timer(ktimer_t* _timer) {
+    task_wakeup(timer_worker(_timer)->task);
+    return;
+}
+
+/**
+ * @brief 取出第一个没有被本池其它线程执行的工作项，需要持有池的锁
+ */
+static work_t* pool_pick(worker_pool_t* _pool) {
+    for (auto& work : _pool->worklist) {
+        auto running = false;
+        for (auto& worker : workers) {
+            if ((worker.pool == _pool) && (worker.current == &work)) {
+                running = true;
+                break;
+            }
+        }
+        if (!running) {
+            _pool->worklist.erase(work);
+            return &work;
+        }
+    }
+    return nullptr;
+}
+
+static void worker_thread(void* _arg);
+
+/**
+ * @brief 为 _pool 创建线程，调用前已计入 nr_workers
+ */
+static void pool_spawn(worker_pool_t* _pool) {
+    auto*   worker = worker_alloc();
+    task_t* task = nullptr;
+    if (worker != nullptr) {
+        worker->pool       = _pool;
+        worker->current    = nullptr;
+        worker->idle_since = 0;
+        timer_init(&worker->timer, worker_timer);
+        task = kthread_create(
+          worker_thread, worker,
+          _pool->cpu == WORK_CPU_UNBOUND ? "kworker/u" : "kworker");
+        worker->task = task;
+    }
+    if (task == nullptr) {
+        if (worker != nullptr) {
+            worker_free(worker);
+        }
+        IrqLockGuard<TicketLock> guard(_pool->lock);
+        _pool->nr_workers--;
+        _pool->spawning = false;
+        return;
+    }
+    if (_pool->cpu != WORK_CPU_UNBOUND) {
+        kthread_bind(task, _pool->cpu);
+    }
+    task_wakeup(task);
+    return;
+}
+
+static void worker_thread(void* _arg) {
+    auto* worker = static_cast<worker_t*>(_arg);
+    auto* pool   = worker->pool;
+    auto  flags  = cpu_irq_save();
+    pool->lock.lock();
+    pool->spawning = false;
+    while (true) {
+        // 被空闲定时器唤醒时仍在空闲列表中
+        if (worker->node.is_linked()) {
+            pool->idle.erase(*worker);
+        }
+        auto* work = pool_pick(pool);
+        if (work != nullptr) {
+            auto* wq           = work->wq;
+            auto  func         = work->func;
+            worker->idle_since = 0;
+            worker->start      = ktime_get_ns();
+            __atomic_store_n(&worker->current, work, __ATOMIC_RELEASE);
+            __atomic_fetch_and(&work->flags, ~WORK_PENDING, __ATOMIC_RELEASE);
+            // 还有工作项等待且没有空闲线程时，在开始执行前增加线程
+            auto spawn = !pool->worklist.empty() && pool_need_spawn(pool);
+            pool->lock.unlock();
+            cpu_irq_restore(flags);
+            if (spawn) {
+                pool_spawn(pool);
+            }
+
+            // 回调可能释放工作项，之后不再访问 work
+            func(work);
+
+            flags = cpu_irq_save();
+            pool->lock.lock();
+            __atomic_store_n(&worker->current, nullptr, __ATOMIC_RELEASE);
+            __atomic_sub_fetch(&wq->nr_active, 1, __ATOMIC_RELEASE);
+            pool->lock.unlock();
+            cpu_irq_restore(flags);
+            wake_flushers(work, wq);
+
+            flags = cpu_irq_save();
+            pool->lock.lock();
+            continue;
+        }
+
+        auto now = ktime_get_ns();
+        if ((worker->idle_since != 0)
+            && (now - worker->idle_since >= WQ_IDLE_TIMEOUT_NS)
+            && (pool->nr_workers > 1)) {
+            pool->nr_workers--;
+            pool->lock.unlock();
+            cpu_irq_restore(flags);
+            worker_free(worker);
+            return;
+        }
+        if (worker->idle_since == 0) {
+            worker->idle_since = now;
+        }
+        pool->idle.push_front(*worker);
+        timer_add(&worker->timer, worker->idle_since + WQ_IDLE_TIMEOUT_NS);
+        set_current_state(TASK_BLOCKED);
+        pool->lock.unlock();
+        cpu_irq_restore(flags);
+
+        schedule();
+
+        set_current_state(TASK_RUNNING);
+        timer_del(&worker->timer);
+        flags = cpu_irq_save();
+        pool->lock.lock();
+    }
+}
+
+/**
+ * @brief 将已设置 WORK_PENDING 的工作项加入线程池
+ */
+static void work_insert(size_t _cpu, workqueue_t* _wq, work_t* _work) {
+    auto* pool = &unbound_pool;
+    if ((_wq->flags & WQ_UNBOUND) == 0) {
+        auto cpu = _cpu == WORK_CPU_UNBOUND ? cpu_id() : _cpu;
+        if ((cpu < MAX_CPU_COUNT) && cpu_pools[cpu].online) {
+            pool = &cpu_pools[cpu];
+        }
+    }
+
+    worker_t* idle  = nullptr;
+    auto      spawn = false;
+    {
+        IrqLockGuard<TicketLock> guard(pool->lock);
+        _work->pool = pool;
+        _work->wq   = _wq;
+        __atomic_add_fetch(&_wq->nr_active, 1, __ATOMIC_RELAXED);
+        pool->worklist.push_back(*_work);
+        idle = pool->idle.pop_front();
+        if (idle != nullptr) {
+            task_wakeup(idle->task);
+        }
+        else {
+            spawn = pool_need_spawn(pool);
+        }
+    }
+    if (spawn) {
+        pool_spawn(pool);
+    }
+    return;
+}
+
+/**
+ * @brief 将挂起的工作项从工作列表中取出
+ * @return true                    已取出，WORK_PENDING 已清除
+ */
+static bool work_grab(work_t* _work) {
+    while (true) {
+        auto* pool = __atomic_load_n(&_work->pool, __ATOMIC_ACQUIRE);
+        if (pool == nullptr) {
+            return false;
+        }
+        workqueue_t* wq = nullptr;
+        {
+            IrqLockGuard<TicketLock> guard(pool->lock);
+            // 已被加入其它池
+            if (_work->pool != pool) {
+                continue;
+            }
+            if (!_work->node.is_linked()) {
+                return false;
+            }
+            pool->worklist.erase(*_work);
+            __atomic_fetch_and(&_work->flags, ~WORK_PENDING,
+                               __ATOMIC_RELEASE);
+            wq = _work->wq;
+            __atomic_sub_fetch(&wq->nr_active, 1, __ATOMIC_RELEASE);
+        }
+        wake_flushers(_work, wq);
+        return true;
+    }
+}
+
+/**
+ * @brief 同步取消，_timer 不为 nullptr 时先取消延迟定时器
+ */
+static bool work_cancel_sync(work_t* _work, ktimer_t* _timer) {
+    __atomic_fetch_or(&_work->flags, WORK_CANCELING, __ATOMIC_ACQUIRE);
+    auto ret = false;
+    if ((_timer != nullptr) && timer_del(_timer)) {
+        __atomic_fetch_and(&_work->flags, ~WORK_PENDING, __ATOMIC_RELEASE);
+        ret = true;
+    }
+    // 挂起但不在工作列表中时正由定时器加入，或刚被线程取出
+    while (!ret && work_pending(_work)) {
+        if (work_grab(_work)) {
+            ret = true;
+            break;
+        }
+        yield();
+    }
+    wait_event(_work, [_work] { return !work_running(_work); });
+    __atomic_fetch_and(&_work->flags, ~WORK_CANCELING, __ATOMIC_RELEASE);
+    return ret;
+}
+
+static void delayed_work_timer(ktimer_t* _timer) {
+    auto* dwork = timer_dwork(_timer);
+    work_insert(dwork->cpu, dwork->wq, &dwork->work);
+    return;
+}
+
+static void pool_init(worker_pool_t* _pool, size_t _cpu) {
+    _pool->cpu        = _cpu;
+    _pool->nr_workers = 0;
+    _pool->spawning   = false;
+    _pool->online     = true;
+    return;
+}
+
+void workqueues_init(void) {
+    pool_init(&unbound_pool, WORK_CPU_UNBOUND);
+    workqueue_init(&system_wq, "events", 0);
+    workqueue_init(&system_unbound_wq, "events_unbound", WQ_UNBOUND);
+    workqueues_cpu_init();
+    return;
+}
+
+void workqueues_cpu_init(void) {
+    auto* pool = &cpu_pools[cpu_id()];
+    {
+        IrqLockGuard<TicketLock> guard(pool->lock);
+        pool_init(pool, cpu_id());
+        pool->spawning   = true;
+        pool->nr_workers = 1;
+    }
+    pool_spawn(pool);
+    return;
+}
+
+void workqueue_init(workqueue_t* _wq, const char* _name, uint32_t _flags) {
+    _wq->name      = _name;
+    _wq->flags     = _flags;
+    _wq->nr_active = 0;
+    return;
+}
+
+void work_init(work_t* _work, void (*_func)(work_t* _work)) {
+    _work->func  = _func;
+    _work->flags = 0;
+    _work->pool  = nullptr;
+    _work->wq    = nullptr;
+    return;
+}
+
+void delayed_work_init(delayed_work_t* _dwork, void (*_func)(work_t* _work)) {
+    work_init(&_dwork->work, _func);
+    timer_init(&_dwork->timer, delayed_work_timer);
+    _dwork->wq  = nullptr;
+    _dwork->cpu = WORK_CPU_UNBOUND;
+    return;
+}
+
+bool queue_work_on(size_t _cpu, workqueue_t* _wq, work_t* _work) {
+    if (!work_claim(_work)) {
+        return false;
+    }
+    work_insert(_cpu, _wq, _work);
+    return true;
+}
+
+bool queue_work(workqueue_t* _wq, work_t* _work) {
+    return queue_work_on(WORK_CPU_UNBOUND, _wq, _work);
+}
+
+bool schedule_work(work_t* _work) {
+    return queue_work_on(WORK_CPU_UNBOUND, &system_wq, _work);
+}
+
+bool queue_delayed_work_on(size_t _cpu, workqueue_t* _wq,
+                           delayed_work_t* _dwork, uint64_t _delay) {
+    if (!work_claim(&_dwork->work)) {
+        return false;
+    }
+    if (_delay == 0) {
+        work_insert(_cpu, _wq, &_dwork->work);
+        return true;
+    }
+    _dwork->wq  = _wq;
+    _dwork->cpu = _cpu;
+    timer_add(&_dwork->timer, ktime_get_ns() + _delay);
+    return true;
+}
+
+bool queue_delayed_work(workqueue_t* _wq, delayed_work_t* _dwork,
+                        uint64_t _delay) {
+    return queue_delayed_work_on(WORK_CPU_UNBOUND, _wq, _dwork, _delay);
+}
+
+bool flush_work(work_t* _work) {
+    return wait_event(_work, [_work] { return !work_busy(_work); });
+}
+
+bool flush_delayed_work(delayed_work_t* _dwork) {
+    if (timer_del(&_dwork->timer)) {
+        work_insert(_dwork->cpu, _dwork->wq, &_dwork->work);
+    }
+    return flush_work(&_dwork->work);
+}
+
+void flush_workqueue(workqueue_t* _wq) {
+    wait_event(_wq, [_wq] {
+        return __atomic_load_n(&_wq->nr_active, __ATOMIC_ACQUIRE) == 0;
+    });
+    return;
+}
+
+bool cancel_work(work_t* _work) {
+    return work_grab(_work);
+}
+
+bool cancel_work_sync(work_t* _work) {
+    return work_cancel_sync(_work, nullptr);
+}
+
+bool cancel_delayed_work(delayed_work_t* _dwork) {
+    if (timer_del(&_dwork->timer)) {
+        __atomic_fetch_and(&_dwork->work.flags, ~WORK_PENDING,
+                           __ATOMIC_RELEASE);
+        return true;
+    }
+    return work_grab(&_dwork->work);
+}
+
+bool cancel_delayed_work_sync(delayed_work_t* _dwork) {
+    return work_cancel_sync(&_dwork->work, &_dwork->timer);
+}
+
+/**
+ * @brief 领取并处理分块，直到全部领完
+ */
+static void parallel_run(parallel_job_t* _job) {
+    while (true) {
+        auto begin = __atomic_fetch_add(&_job->next, _job->grain,
+                                        __ATOMIC_RELAXED);
+        if (begin >= _job->count) {
+            return;
+        }
+        auto end = _job->count - begin < _job->grain ? _job->count
+                                                     : begin + _job->grain;
+        _job->func(begin, end, _job->arg);
+    }
+}
+
+static void parallel_work(work_t* _work) {
+    auto* helper = reinterpret_cast<parallel_helper_t*>(
+      reinterpret_cast<uintptr_t>(_work) - offsetof(parallel_helper_t, work));
+    parallel_run(helper->job);
+    return;
+}
+
+void parallel_for(size_t _count, size_t _grain,
+                  void (*_func)(size_t _begin, size_t _end, void* _arg),
+                  void* _arg) {
+    if (_count == 0) {
+        return;
+    }
+    parallel_job_t job;
+    job.func  = _func;
+    job.arg   = _arg;
+    job.count = _count;
+    job.grain = _grain == 0 ? 1 : _grain;
+    job.next  = 0;
+
+    // 调用者自己也领取分块，最多再使用 cpu 数减一个工作线程
+    auto chunks  = (_count - 1) / job.grain + 1;
+    auto helpers = smp_cpu_count();
+    if (helpers > chunks) {
+        helpers = chunks;
+    }
+    if (helpers > MAX_CPU_COUNT) {
+        helpers = MAX_CPU_COUNT;
+    }
+    helpers--;
+    parallel_helper_t helper[MAX_CPU_COUNT];
+    for (size_t i = 0; i < helpers; i++) {
+        work_init(&helper[i].work, parallel_work);
+        helper[i].job = &job;
+        queue_work(&system_unbound_wq, &helper[i].work);
+    }
+    parallel_run(&job);
+    // 还没有开始的工作项已经没有分块可领
+    for (size_t i = 0; i < helpers; i++) {
+        if (!cancel_work(&helper[i].work)) {
+            flush_work(&helper[i].work);
+        }
+    }
+    return;
+}
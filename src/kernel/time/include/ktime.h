@@ -0,0 +1,103 @@
+
+/**
+ * @file ktime.h
+ * @brief 时间
+ * @author Zone.N (Zone.Niuzh@hotmail.com)
+ * @version 1.0
+ * @date 2026-10-18
+ * @copyright MIT LICENSE
+ * https://github.com/MRNIU/cmake-kernel
+ * @par change log:
+ * <table>
+ * <tr><th>Date<th>Author<th>Description
+ * <tr><td>2026-10-18<td>Zone.N (Zone.Niuzh@hotmail.com)<td>创建文件
+ * </table>
+ */
+
+#ifndef CMAKE_KERNEL_KTIME_H
+#define CMAKE_KERNEL_KTIME_H
+
+#include "cstddef"
+#include "cstdint"
+
+#include "clock.h"
+
+static constexpr const uint64_t NSEC_PER_USEC = 1000;
+static constexpr const uint64_t NSEC_PER_MSEC = 1000 * NSEC_PER_USEC;
+static constexpr const uint64_t NSEC_PER_SEC  = 1000 * NSEC_PER_MSEC;
+
+/**
+ * @brief 时钟源
+ * 计数与纳秒之间使用定点数转换: ns = (cycles * mult) >> shift，
+ * 乘积使用 128 位，不会溢出，mult 取 32 位以内的最大精度
+ */
+struct clocksource_t {
+    /// 计数器频率
+    uint64_t freq;
+    /// 启动时的计数，ktime 从这里开始
+    uint64_t base;
+    /// 计数转换为纳秒
+    uint32_t mult;
+    uint32_t shift;
+    /// 纳秒转换为计数
+    uint32_t inv_mult;
+    uint32_t inv_shift;
+};
+
+extern clocksource_t clocksource;
+
+/**
+ * @brief 初始化时间子系统，由启动 cpu 在中断初始化之后调用
+ */
+void time_init(void);
+
+/**
+ * @brief 初始化当前 cpu 的定时器，由每个非启动 cpu 调用
+ */
+void time_cpu_init(void);
+
+/**
+ * @brief 计数转换为纳秒
+ * @param  _cycles                 计数
+ * @return uint64_t                纳秒
+ */
+static inline uint64_t clocksource_cyc2ns(uint64_t _cycles) {
+    return (static_cast<unsigned __int128>(_cycles) * clocksource.mult)
+           >> clocksource.shift;
+}
+
+/**
+ * @brief 纳秒转换为计数
+ * @param  _ns                     纳秒
+ * @return uint64_t                计数
+ */
+static inline uint64_t clocksource_ns2cyc(uint64_t _ns) {
+    return (static_cast<unsigned __int128>(_ns) * clocksource.inv_mult)
+           >> clocksource.inv_shift;
+}
+
+/**
+ * @brief 启动以来的时间
+ * @return uint64_t                纳秒
+ */
+static inline uint64_t ktime_get_ns(void) {
+    return clocksource_cyc2ns(clock_arch_read() - clocksource.base);
+}
+
+/**
+ * @brief 忙等
+ * @param  _ns                     纳秒
+ */
+void ndelay(uint64_t _ns);
+
+static inline void udelay(uint64_t _us) {
+    ndelay(_us * NSEC_PER_USEC);
+    return;
+}
+
+static inline void mdelay(uint64_t _ms) {
+    ndelay(_ms * NSEC_PER_MSEC);
+    return;
+}
+
+#endif /* CMAKE_KERNEL_KTIME_H */
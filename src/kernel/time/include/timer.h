@@ -0,0 +1,93 @@
+
+/**
+ * @file timer.h
+ * @brief 定时器
+ * @author Zone.N (Zone.Niuzh@hotmail.com)
+ * @version 1.0
+ * @date 2026-10-18
+ * @copyright MIT LICENSE
+ * https://github.com/MRNIU/cmake-kernel
+ * @par change log:
+ * <table>
+ * <tr><th>Date<th>Author<th>Description
+ * <tr><td>2026-10-18<td>Zone.N (Zone.Niuzh@hotmail.com)<td>创建文件
+ * </table>
+ */
+
+#ifndef CMAKE_KERNEL_TIMER_H
+#define CMAKE_KERNEL_TIMER_H
+
+#include "cstddef"
+#include "cstdint"
+
+#include "intrusive_list.hpp"
+
+struct timer_base_t;
+
+/**
+ * @brief 定时器
+ * 嵌入到使用者的对象中，不分配内存。
+ * 回调在时钟中断中执行，执行前定时器已不再挂起，可以在回调中重新添加
+ */
+struct ktimer_t {
+    /// 所在的槽
+    ListNode      node;
+    /// 到期时间，纳秒
+    uint64_t      expires;
+    /// 回调函数
+    void          (*func)(ktimer_t* _timer);
+    /// 挂起时所在的 cpu，未挂起时为 nullptr
+    timer_base_t* base;
+    /// 所在的层与槽
+    uint8_t       level;
+    uint8_t       slot;
+};
+
+/**
+ * @brief 注册时钟中断处理，由 time_init 调用
+ */
+void     timers_init(void);
+
+/**
+ * @brief 初始化当前 cpu 的定时器，由 time_cpu_init 调用
+ */
+void     timer_cpu_init(void);
+
+/**
+ * @brief 初始化定时器
+ * @param  _timer                  定时器
+ * @param  _func                   回调函数
+ */
+void     timer_init(ktimer_t* _timer, void (*_func)(ktimer_t* _timer));
+
+/**
+ * @brief 在当前 cpu 上添加定时器，已挂起时重新设置到期时间
+ * @param  _timer                  定时器
+ * @param  _expires                到期时间，ktime_get_ns() 的纳秒数
+ */
+void     timer_add(ktimer_t* _timer, uint64_t _expires);
+
+/**
+ * @brief 取消定时器，可以在任意 cpu 上调用
+ * 不等待正在执行的回调
+ * @param  _timer                  定时器
+ * @return true                    定时器挂起，已取消
+ * @return false                   定时器未挂起
+ */
+bool     timer_del(ktimer_t* _timer);
+
+/**
+ * @brief 定时器是否挂起
+ * @param  _timer                  定时器
+ * @return true                    挂起
+ * @return false                   未挂起
+ */
+bool     timer_pending(const ktimer_t* _timer);
+
+/**
+ * @brief 当前 cpu 下一次需要处理定时器的时间，用于空闲时估计休眠时长
+ * @return uint64_t                纳秒，没有定时器时为 UINT64_MAX
+ */
+uint64_t timer_next_event(void);
+
+#endif /* CMAKE_KERNEL_TIMER_H */
@@ -0,0 +1,79 @@
+
+/**
+ * @file ktime.cpp
+ * @brief 时间
+ * @author Zone.N (Zone.Niuzh@hotmail.com)
+ * @version 1.0
+ * @date 2026-10-18
+ * @copyright MIT LICENSE
+ * https://github.com/MRNIU/cmake-kernel
+ * @par change log:
+ * <table>
+ * <tr><th>Date<th>Author<th>Description
+ * <tr><td>2026-10-18<td>Zone.N (Zone.Niuzh@hotmail.com)<td>创建文件
+ * </table>
+ */
+
+#include "ktime.h"
+#include "cpu.h"
+#include "timer.h"
+
+clocksource_t clocksource;
+
+/**
+ * @brief 计算 _from 频率转换到 _to 频率的定点数参数
+ * 结果满足 _to = (_from * mult) >> shift，mult 不超过 32 位，
+ * 在此前提下选择最大的 shift 以获得最高精度
+ * @param  _mult                   乘数
+ * @param  _shift                  移位
+ * @param  _from                   源频率
+ * @param  _to                     目标频率
+ */
+static void calc_mult_shift(uint32_t& _mult, uint32_t& _shift, uint64_t _from,
+                            uint64_t _to) {
+    uint64_t tmp = 0;
+    uint32_t sft = 32;
+    for (; sft > 0; sft--) {
+        // _to << sft 溢出时减小 sft
+        if ((_to >> (64 - sft)) != 0) {
+            continue;
+        }
+        tmp = ((_to << sft) + _from / 2) / _from;
+        if ((tmp >> 32) == 0) {
+            break;
+        }
+    }
+    if (sft == 0) {
+        tmp = (_to + _from / 2) / _from;
+    }
+    _mult  = static_cast<uint32_t>(tmp);
+    _shift = sft;
+    return;
+}
+
+void time_init(void) {
+    clock_arch_init();
+    clocksource.freq = clock_arch_freq();
+    calc_mult_shift(clocksource.mult, clocksource.shift, clocksource.freq,
+                    NSEC_PER_SEC);
+    calc_mult_shift(clocksource.inv_mult, clocksource.inv_shift, NSEC_PER_SEC,
+                    clocksource.freq);
+    clocksource.base = clock_arch_read();
+    timers_init();
+    time_cpu_init();
+    return;
+}
+
+void time_cpu_init(void) {
+    timer_cpu_init();
+    clock_arch_cpu_init();
+    return;
+}
+
+void ndelay(uint64_t _ns) {
+    auto end = ktime_get_ns() + _ns;
+    while (ktime_get_ns() < end) {
+        cpu_relax();
+    }
+    return;
+}
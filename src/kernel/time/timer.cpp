@@ -0,0 +1,379 @@
+
+/**
+ * @file timer.cpp
+ * @brief 分层时间轮定时器
+ * @author Zone.N (Zone.Niuzh@hotmail.com)
+ * @version 1.0
+ * @date 2026-10-18
+ * @copyright MIT LICENSE
+ * https://github.com/MRNIU/cmake-kernel
+ * @par change log:
+ * <table>
+ * <tr><th>Date<th>Author<th>Description
+ * <tr><td>2026-10-18<td>Zone.N (Zone.Niuzh@hotmail.com)<td>创建文件
+ * </table>
+ */
+
+#include "timer.h"
+#include "cpu.h"
+#include "interrupt.h"
+#include "ktime.h"
+#include "libcxx.h"
+#include "percpu.h"
+#include "spinlock.hpp"
+
+// 每个 cpu 一个分层时间轮，添加/取消均为 O(1)，不同 cpu 之间没有共享的锁。
+// 第 l 层每个槽的跨度为 64^l 个时间单位，到期时间与 clk 在第 l 层及以上
+// 完全相同的定时器放在第 l 层以下。clk 到达第 l 层某个槽的起点时，
+// 将该槽中的定时器重新放入更低的层，第 0 层的槽到达时执行回调。
+// 不使用周期时钟中断: 每次只在下一个非空槽到达时产生中断，
+// 中断中直接跳过中间的空槽，没有定时器的 cpu 不会被唤醒
+
+/// 时间单位为 2^14 纳秒，约 16 微秒
+static constexpr const uint64_t TIMER_UNIT_SHIFT = 14;
+/// 每层 64 个槽
+static constexpr const uint64_t LVL_BITS         = 6;
+static constexpr const uint64_t LVL_SIZE         = 1 << LVL_BITS;
+static constexpr const uint64_t LVL_MASK         = LVL_SIZE - 1;
+/// 8 层，覆盖 2^62 纳秒，更远的定时器放在最高层，到达时重新放入
+static constexpr const size_t   LVL_DEPTH        = 8;
+/// 表示定时器已从槽中取出，等待执行
+static constexpr const uint8_t  LVL_EXPIRING     = LVL_DEPTH;
+
+/**
+ * @brief 每个 cpu 的时间轮
+ */
+struct alignas(CACHE_LINE_SIZE) timer_base_t {
+    /// 保护本结构与其中的定时器，时钟中断中也会获取，需要关中断
+    TicketLock lock;
+    /// 是否正在时钟中断中处理，此时添加定时器不需要设置时钟
+    bool       running;
+    /// 下一个要处理的时间单位
+    uint64_t   clk;
+    /// 已设置的时钟中断时间，单位同 clk，UINT64_MAX 表示未设置
+    uint64_t   next_event;
+    /// 每层非空槽的位图
+    uint64_t   pending[LVL_DEPTH];
+    /// 每个槽为一个循环链表的哨兵节点
+    ListNode   slots[LVL_DEPTH][LVL_SIZE];
+};
+
+/// 时间轮较大，不放在 percpu 数据区中
+static timer_base_t timer_bases[MAX_CPU_COUNT];
+
+static void list_init(ListNode* _head) {
+    _head->prev = _head;
+    _head->next = _head;
+    return;
+}
+
+static bool list_empty(const ListNode* _head) {
+    return _head->next == _head;
+}
+
+static void list_add_tail(ListNode* _head, ListNode* _node) {
+    _node->prev       = _head->prev;
+    _node->next       = _head;
+    _head->prev->next = _node;
+    _head->prev       = _node;
+    return;
+}
+
+static void list_del(ListNode* _node) {
+    _node->prev->next = _node->next;
+    _node->next->prev = _node->prev;
+    _node->prev       = nullptr;
+    _node->next       = nullptr;
+    return;
+}
+
+/**
+ * @brief 将 _from 中的节点全部移到空链表 _to
+ */
+static void list_move_all(ListNode* _from, ListNode* _to) {
+    if (list_empty(_from)) {
+        list_init(_to);
+        return;
+    }
+    _to->next       = _from->next;
+    _to->prev       = _from->prev;
+    _to->next->prev = _to;
+    _to->prev->next = _to;
+    list_init(_from);
+    return;
+}
+
+static ktimer_t* to_timer(ListNode* _node) {
+    return reinterpret_cast<ktimer_t*>(reinterpret_cast<uintptr_t>(_node)
+                                       - offsetof(ktimer_t, node));
+}
+
+/**
+ * @brief 纳秒转换为时间单位，向上取整，保证定时器不会提前执行
+ */
+static uint64_t ns_to_unit(uint64_t _ns) {
+    return (_ns >> TIMER_UNIT_SHIFT)
+           + ((_ns & ((1ULL << TIMER_UNIT_SHIFT) - 1)) != 0 ? 1 : 0);
+}
+
+/**
+ * @brief 将定时器放入时间轮，需要持有锁
+ */
+static void enqueue(timer_base_t& _base, ktimer_t* _timer) {
+    auto     expires = ns_to_unit(_timer->expires);
+    size_t   level   = 0;
+    uint64_t slot    = _base.clk & LVL_MASK;
+    if (expires > _base.clk) {
+        // 最高的不同位所在的层
+        auto diff = expires ^ _base.clk;
+        level     = (63 - __builtin_clzll(diff)) / LVL_BITS;
+        if (level < LVL_DEPTH) {
+            slot = (expires >> (level * LVL_BITS)) & LVL_MASK;
+        }
+        else {
+            // 超出范围，放在最高层最后到达的槽
+            level = LVL_DEPTH - 1;
+            slot  = ((_base.clk >> (level * LVL_BITS)) - 1) & LVL_MASK;
+        }
+    }
+    _timer->level = level;
+    _timer->slot  = slot;
+    __atomic_store_n(&_timer->base, &_base, __ATOMIC_RELEASE);
+    list_add_tail(&_base.slots[level][slot], &_timer->node);
+    _base.pending[level] |= 1ULL << slot;
+    return;
+}
+
+/**
+ * @brief 将定时器移出时间轮，需要持有锁
+ */
+static void dequeue(timer_base_t& _base, ktimer_t* _timer) {
+    list_del(&_timer->node);
+    if (_timer->level != LVL_EXPIRING) {
+        auto* head = &_base.slots[_timer->level][_timer->slot];
+        if (list_empty(head)) {
+            _base.pending[_timer->level] &= ~(1ULL << _timer->slot);
+        }
+    }
+    __atomic_store_n(&_timer->base, nullptr, __ATOMIC_RELEASE);
+    return;
+}
+
+/**
+ * @brief 第 _level 层 _slot 号槽下一次到达的时间
+ */
+static uint64_t slot_time(const timer_base_t& _base, size_t _level,
+                          uint64_t _slot) {
+    auto shift = _level * LVL_BITS;
+    auto span  = 1ULL << (shift + LVL_BITS);
+    auto time  = (_base.clk & ~(span - 1)) | (_slot << shift);
+    return time < _base.clk ? time + span : time;
+}
+
+/**
+ * @brief 下一个需要处理的时间，需要持有锁
+ * @return uint64_t                时间单位，没有定时器时为 UINT64_MAX
+ */
+static uint64_t next_pending(const timer_base_t& _base) {
+    uint64_t next = UINT64_MAX;
+    for (size_t level = 0; level < LVL_DEPTH; level++) {
+        auto map = _base.pending[level];
+        if (map == 0) {
+            continue;
+        }
+        // 当前槽及之后第一个非空槽，以及绕回后的第一个非空槽
+        auto cur   = (_base.clk >> (level * LVL_BITS)) & LVL_MASK;
+        auto ahead = map & (~0ULL << cur);
+        if (ahead != 0) {
+            auto time = slot_time(_base, level, __builtin_ctzll(ahead));
+            next      = time < next ? time : next;
+        }
+        auto time = slot_time(_base, level, __builtin_ctzll(map));
+        next      = time < next ? time : next;
+    }
+    return next;
+}
+
+/**
+ * @brief 将 clk 到达的高层槽中的定时器放入低层，需要持有锁
+ */
+static void cascade(timer_base_t& _base) {
+    // 从高到低，高层放下来的定时器可能落在同样到达的低层槽中
+    for (size_t level = LVL_DEPTH - 1; level > 0; level--) {
+        auto shift = level * LVL_BITS;
+        if ((_base.clk & ((1ULL << shift) - 1)) != 0) {
+            continue;
+        }
+        auto slot = (_base.clk >> shift) & LVL_MASK;
+        if ((_base.pending[level] & (1ULL << slot)) == 0) {
+            continue;
+        }
+        ListNode list;
+        list_move_all(&_base.slots[level][slot], &list);
+        _base.pending[level] &= ~(1ULL << slot);
+        while (!list_empty(&list)) {
+            auto* timer = to_timer(list.next);
+            list_del(&timer->node);
+            enqueue(_base, timer);
+        }
+    }
+    return;
+}
+
+/**
+ * @brief 按下一个需要处理的时间设置时钟中断，需要持有锁
+ * @param  _base                   时间轮
+ * @param  _force                  已设置的中断已经产生，必须重新设置
+ */
+static void program(timer_base_t& _base, bool _force) {
+    auto next = next_pending(_base);
+    if (!_force && (next == _base.next_event)) {
+        return;
+    }
+    _base.next_event = next;
+    if (next == UINT64_MAX) {
+        clock_arch_stop_event();
+    }
+    else {
+        // 定点数转换有误差，保证中断产生时 ktime_get_ns() 已经到达
+        auto ns     = next << TIMER_UNIT_SHIFT;
+        auto cycles = clocksource_ns2cyc(ns);
+        while (clocksource_cyc2ns(cycles) < ns) {
+            cycles += clocksource_ns2cyc(ns - clocksource_cyc2ns(cycles)) + 1;
+        }
+        clock_arch_set_event(cycles + clocksource.base);
+    }
+    return;
+}
+
+/**
+ * @brief 时钟中断，执行到期的定时器
+ */
+static void timer_interrupt(size_t _no, trap_frame_t* _frame) {
+    (void)_no;
+    (void)_frame;
+    clock_arch_ack();
+    auto& base = timer_bases[cpu_id()];
+    auto  now  = ktime_get_ns() >> TIMER_UNIT_SHIFT;
+
+    LockGuard<TicketLock> guard(base.lock);
+    base.running = true;
+    while (true) {
+        auto next = next_pending(base);
+        if (next > now) {
+            break;
+        }
+        // 中间的槽都是空的，直接跳过
+        base.clk = next;
+        cascade(base);
+        auto slot = base.clk & LVL_MASK;
+        ListNode expired;
+        list_init(&expired);
+        if ((base.pending[0] & (1ULL << slot)) != 0) {
+            list_move_all(&base.slots[0][slot], &expired);
+            base.pending[0] &= ~(1ULL << slot);
+        }
+        // 回调中添加的已到期定时器放入下一个槽
+        base.clk = next + 1;
+        for (auto* node = expired.next; node != &expired; node = node->next) {
+            to_timer(node)->level = LVL_EXPIRING;
+        }
+        while (!list_empty(&expired)) {
+            auto* timer = to_timer(expired.next);
+            dequeue(base, timer);
+            auto  func  = timer->func;
+            // 执行回调时释放锁，允许其它 cpu 取消定时器
+            base.lock.unlock();
+            func(timer);
+            base.lock.lock();
+        }
+    }
+    // 之前的时间单位都已处理
+    base.clk     = now + 1;
+    base.running = false;
+    // 本次中断已消耗，需要重新设置
+    program(base, true);
+    return;
+}
+
+void timers_init(void) {
+    register_interrupt_handler(INTERRUPT_TIMER, timer_interrupt);
+    return;
+}
+
+void timer_cpu_init(void) {
+    auto& base = timer_bases[cpu_id()];
+    base.running    = false;
+    base.clk        = ktime_get_ns() >> TIMER_UNIT_SHIFT;
+    base.next_event = UINT64_MAX;
+    for (size_t level = 0; level < LVL_DEPTH; level++) {
+        base.pending[level] = 0;
+        for (size_t slot = 0; slot < LVL_SIZE; slot++) {
+            list_init(&base.slots[level][slot]);
+        }
+    }
+    return;
+}
+
+void timer_init(ktimer_t* _timer, void (*_func)(ktimer_t* _timer)) {
+    _timer->node.prev = nullptr;
+    _timer->node.next = nullptr;
+    _timer->expires   = 0;
+    _timer->func      = _func;
+    _timer->base      = nullptr;
+    _timer->level     = 0;
+    _timer->slot      = 0;
+    return;
+}
+
+void timer_add(ktimer_t* _timer, uint64_t _expires) {
+    timer_del(_timer);
+    // 先关中断再取 base，否则取得后可能被迁移到其它 cpu
+    auto  flags = cpu_irq_save();
+    auto& base  = timer_bases[cpu_id()];
+
+    base.lock.lock();
+    // 空闲时 clk 可能落后很多，先前移，避免定时器放入过高的层
+    auto now = ktime_get_ns() >> TIMER_UNIT_SHIFT;
+    if ((now > base.clk) && (next_pending(base) > now)) {
+        base.clk = now;
+    }
+    _timer->expires = _expires;
+    enqueue(base, _timer);
+    if (!base.running) {
+        program(base, false);
+    }
+    base.lock.unlock();
+    cpu_irq_restore(flags);
+    return;
+}
+
+bool timer_del(ktimer_t* _timer) {
+    while (true) {
+        auto* base = __atomic_load_n(&_timer->base, __ATOMIC_ACQUIRE);
+        if (base == nullptr) {
+            return false;
+        }
+        IrqLockGuard<TicketLock> guard(base->lock);
+        // 加锁前可能已被执行或移到其它 cpu
+        if (_timer->base == base) {
+            dequeue(*base, _timer);
+            return true;
+        }
+    }
+}
+
+bool timer_pending(const ktimer_t* _timer) {
+    return __atomic_load_n(&_timer->base, __ATOMIC_RELAXED) != nullptr;
+}
+
+uint64_t timer_next_event(void) {
+    auto  flags = cpu_irq_save();
+    auto& base  = timer_bases[cpu_id()];
+
+    base.lock.lock();
+    auto next = next_pending(base);
+    base.lock.unlock();
+    cpu_irq_restore(flags);
+    return next == UINT64_MAX ? UINT64_MAX : next << TIMER_UNIT_SHIFT;
+}
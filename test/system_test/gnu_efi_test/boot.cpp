@@ -15,55 +15,118 @@
  */
 
 #include <cstring>
-#include <exception>
-#include <stdexcept>
 
 #include "load_elf.h"
 
 #define KERNEL_EXECUTABLE_PATH (wchar_t*)L"gnu-efi-test_kernel.elf"
+#define INITRD_PATH            (wchar_t*)L"initramfs.tar"
+
+#if defined(__x86_64__)
+// ap 启动代码与临时页表使用的低端内存，需要与内核 smp.cpp 一致
+#define AP_TRAMPOLINE_BASE     0x8000
+#define AP_TRAMPOLINE_PAGES    2
+#endif
 
 extern "C" EFI_STATUS EFIAPI efi_main(EFI_HANDLE        _image_handle,
                                       EFI_SYSTEM_TABLE* _system_table) {
     EFI_STATUS status      = 0;
     uint64_t   kernel_addr = 0;
-    try {
-        // 输出 efi 信息
-        EFI_LOADED_IMAGE* loaded_image = nullptr;
-        status = LibLocateProtocol(&LoadedImageProtocol, (void**)&loaded_image);
-        if (EFI_ERROR(status)) {
-            debug(L"handleprotocol: %d\n", status);
-        }
 
-        debug(L"Revision:        0x%X\n", loaded_image->Revision);
-        debug(L"ParentHandle:    0x%X\n", loaded_image->ParentHandle);
-        debug(L"SystemTable:     0x%X\n", loaded_image->SystemTable);
-        debug(L"DeviceHandle:    0x%X\n", loaded_image->DeviceHandle);
-        debug(L"FilePath:        0x%X\n", loaded_image->FilePath);
-        debug(L"Reserved:        0x%X\n", loaded_image->Reserved);
-        debug(L"LoadOptionsSize: 0x%X\n", loaded_image->LoadOptionsSize);
-        debug(L"LoadOptions:     0x%X\n", loaded_image->LoadOptions);
-        debug(L"ImageBase:       0x%X\n", loaded_image->ImageBase);
-        debug(L"ImageSize:       0x%X\n", loaded_image->ImageSize);
-        debug(L"ImageCodeType:   0x%X\n", loaded_image->ImageCodeType);
-        debug(L"ImageDataType:   0x%X\n", loaded_image->ImageDataType);
-        debug(L"Unload:          0x%X\n", loaded_image->Unload);
+    // 输出 efi 信息
+    EFI_LOADED_IMAGE* loaded_image = nullptr;
+    status = LibLocateProtocol(&LoadedImageProtocol, (void**)&loaded_image);
+    if (EFI_ERROR(status)) {
+        debug(L"handleprotocol: %d\n", status);
+        return status;
+    }
+
+    debug(L"Revision:        0x%X\n", loaded_image->Revision);
+    debug(L"ParentHandle:    0x%X\n", loaded_image->ParentHandle);
+    debug(L"SystemTable:     0x%X\n", loaded_image->SystemTable);
+    debug(L"DeviceHandle:    0x%X\n", loaded_image->DeviceHandle);
+    debug(L"FilePath:        0x%X\n", loaded_image->FilePath);
+    debug(L"Reserved:        0x%X\n", loaded_image->Reserved);
+    debug(L"LoadOptionsSize: 0x%X\n", loaded_image->LoadOptionsSize);
+    debug(L"LoadOptions:     0x%X\n", loaded_image->LoadOptions);
+    debug(L"ImageBase:       0x%X\n", loaded_image->ImageBase);
+    debug(L"ImageSize:       0x%X\n", loaded_image->ImageSize);
+    debug(L"ImageCodeType:   0x%X\n", loaded_image->ImageCodeType);
+    debug(L"ImageDataType:   0x%X\n", loaded_image->ImageDataType);
+    debug(L"Unload:          0x%X\n", loaded_image->Unload);
 
-        // 初始化 Graphics
-        auto graphics = Graphics();
+    // 初始化 Graphics
+    auto graphics     = Graphics();
+    auto graphics_ret = graphics.init();
+    if (graphics_ret) {
         // 打印图形信息
-        graphics.print_info();
+        graphics_ret = graphics.print_info();
+    }
+    if (graphics_ret) {
         // 设置为 1920*1080
-        graphics.set_mode(PixelBlueGreenRedReserved8BitPerColor, 1920, 1080);
-        // 初始化 Memory
-        auto memory = Memory();
-        memory.print_info();
-        // 加载内核
-        auto elf    = Elf(KERNEL_EXECUTABLE_PATH);
-        kernel_addr = elf.load_kernel_image();
-    } catch (const std::exception& e) {
-        debug(L"Fatal Error: %s\n", e.what());
-        return EFI_LOAD_ERROR;
+        graphics_ret = graphics.set_mode(PixelBlueGreenRedReserved8BitPerColor,
+                                         1920, 1080);
+    }
+    if (!graphics_ret) {
+        debug(L"Fatal Error: Graphics %d\n", graphics_ret.error());
+        return graphics_ret.error();
     }
+    // 初始化 Memory
+    auto memory     = Memory();
+    auto memory_ret = memory.init();
+    if (memory_ret) {
+        memory_ret = memory.print_info();
+    }
+    if (!memory_ret) {
+        debug(L"Fatal Error: Memory %d\n", memory_ret.error());
+        return memory_ret.error();
+    }
+    // 加载内核
+    auto elf     = Elf();
+    auto elf_ret = elf.init(KERNEL_EXECUTABLE_PATH);
+    if (!elf_ret) {
+        debug(L"Fatal Error: Elf %d\n", elf_ret.error());
+        return elf_ret.error();
+    }
+    auto load_kernel_image_ret = elf.load_kernel_image();
+    if (!load_kernel_image_ret) {
+        debug(L"Fatal Error: load_kernel_image %d\n",
+              load_kernel_image_ret.error());
+        return load_kernel_image_ret.error();
+    }
+    kernel_addr = *load_kernel_image_ret;
+
+    // 加载 initramfs，没有时不传入
+    auto initrd     = Initrd();
+    auto initrd_ret = initrd.load(INITRD_PATH);
+    if (!initrd_ret && (initrd_ret.error() != EFI_NOT_FOUND)) {
+        debug(L"Fatal Error: Initrd %d\n", initrd_ret.error());
+        return initrd_ret.error();
+    }
+
+    // 保留 ap 启动代码使用的低端内存，失败时内核只使用启动 cpu
+    EFI_PHYSICAL_ADDRESS ap_trampoline = 0;
+#if defined(__x86_64__)
+    ap_trampoline = AP_TRAMPOLINE_BASE;
+    status        = uefi_call_wrapper(gBS->AllocatePages, 4, AllocateAddress,
+                                      EfiLoaderData, AP_TRAMPOLINE_PAGES,
+                                      &ap_trampoline);
+    if (EFI_ERROR(status)) {
+        debug(L"AllocatePages ap trampoline failed %d\n", status);
+        ap_trampoline = 0;
+    }
+#endif
+
+    // ACPI 表的入口，优先使用 ACPI 2.0，没有时内核自行在低端内存查找
+    void* rsdp = nullptr;
+    status     = LibGetSystemConfigurationTable(&Acpi20TableGuid, &rsdp);
+    if (EFI_ERROR(status)) {
+        status = LibGetSystemConfigurationTable(&AcpiTableGuid, &rsdp);
+    }
+    if (EFI_ERROR(status)) {
+        debug(L"ACPI RSDP not found %d\n", status);
+        rsdp = nullptr;
+    }
+
     // 退出 boot service
     uint64_t               desc_count   = 0;
     EFI_MEMORY_DESCRIPTOR* memory_map   = nullptr;
@@ -73,7 +136,7 @@ extern "C" EFI_STATUS EFIAPI efi_main(EFI_HANDLE        _image_handle,
     memory_map = LibMemoryMap(&desc_count, &map_key, &desc_size, &desc_version);
     if (memory_map == nullptr) {
         debug(L"GetMemoryMap failed2: memory_map == nullptr\n");
-        throw std::runtime_error("memory_map == nullptr");
+        return EFI_OUT_OF_RESOURCES;
     }
     // debug(L"Close failed122 %d\n", 1);
     status
@@ -83,8 +146,14 @@ extern "C" EFI_STATUS EFIAPI efi_main(EFI_HANDLE        _image_handle,
     }
 
     // debug(L"Set Kernel Entry Point to: [0x%llX]\n ", kernel_addr);
-    auto kernel_entry = (void (*)(void))kernel_addr;
-    kernel_entry();
+    // argv[0] 与 argv[1] 为 initramfs 的起始与结束地址，没有时二者相等
+    // argv[2] 为已保留的 ap 启动代码内存，没有时为 nullptr
+    // argv[3] 为 RSDP，没有时为 nullptr
+    uint8_t* kernel_argv[4] = { (uint8_t*)initrd.start(),
+                                (uint8_t*)initrd.end(),
+                                (uint8_t*)ap_trampoline, (uint8_t*)rsdp };
+    auto     kernel_entry   = (void (*)(uint32_t, uint8_t**))kernel_addr;
+    kernel_entry(4, kernel_argv);
 
     return EFI_SUCCESS;
 }
@@ -14,28 +14,27 @@
  * </table>
  */
 
-#include <stdexcept>
-
 #include "load_elf.h"
 
-Graphics::Graphics(void) {
+Expected<void, EFI_STATUS> Graphics::init(void) {
     EFI_STATUS status
       = LibLocateProtocol(&GraphicsOutputProtocol, (void**)&gop);
     if (EFI_ERROR(status)) {
         debug(L"Could not locate GOP: %d\n", status);
-        throw std::runtime_error("EFI_ERROR(status)");
+        return Unexpected(status);
     }
     if (gop == nullptr) {
         debug(L"LibLocateProtocol(GraphicsOutputProtocol, &gop) returned %d "
               L"but gop is nullptr\n",
               status);
-        throw std::runtime_error("gop == nullptr");
+        return Unexpected(EFI_NOT_FOUND);
     }
-    return;
+    return {};
 }
 
-void Graphics::set_mode(EFI_GRAPHICS_PIXEL_FORMAT _format, uint32_t _w,
-                        uint32_t _h) const {
+Expected<void, EFI_STATUS>
+Graphics::set_mode(EFI_GRAPHICS_PIXEL_FORMAT _format, uint32_t _w,
+                   uint32_t _h) const {
     EFI_STATUS status;
 
     for (uint32_t i = 0; i < gop->Mode->MaxMode; i++) {
@@ -45,7 +44,7 @@ void Graphics::set_mode(EFI_GRAPHICS_PIXEL_FORMAT _format, uint32_t _w,
                                    &mode_info);
         if (EFI_ERROR(status)) {
             debug(L"QueryMode failed: %d\n", status);
-            throw std::runtime_error("EFI_ERROR(status)");
+            return Unexpected(status);
         }
 
         if ((mode_info->PixelFormat == _format)
@@ -54,13 +53,13 @@ void Graphics::set_mode(EFI_GRAPHICS_PIXEL_FORMAT _format, uint32_t _w,
             status = uefi_call_wrapper(gop->SetMode, 2, gop, i);
             if (EFI_ERROR(status)) {
                 debug(L"SetMode failed: %d\n", status);
-                throw std::runtime_error("EFI_ERROR(status)");
+                return Unexpected(status);
             }
         }
         status = uefi_call_wrapper(gBS->FreePool, 1, mode_info);
         if (EFI_ERROR(status)) {
             debug(L"FreePool failed: %d\n", status);
-            throw std::runtime_error("EFI_ERROR(status)");
+            return Unexpected(status);
         }
     }
 
@@ -72,10 +71,10 @@ void Graphics::set_mode(EFI_GRAPHICS_PIXEL_FORMAT _format, uint32_t _w,
       gop->Mode->Info->VerticalResolution, gop->Mode->Info->PixelsPerScanLine,
       gop->Mode->FrameBufferBase, gop->Mode->FrameBufferSize);
 
-    return;
+    return {};
 }
 
-void Graphics::print_info(void) const {
+Expected<void, EFI_STATUS> Graphics::print_info(void) const {
     debug(
       L"Current Mode: %d, Version: 0x%x, Format: %d, Horizontal: %d, Vertical: "
       L"%d, ScanLine: %d, FrameBufferBase: 0x%X, FrameBufferSize: 0x%X\n",
@@ -91,7 +90,7 @@ void Graphics::print_info(void) const {
                                         &mode_info_size, &mode_info);
         if (EFI_ERROR(status)) {
             debug(L"QueryMode failed: %d\n", status);
-            throw std::runtime_error("EFI_ERROR(status)");
+            return Unexpected(status);
         }
         debug(
           L"Mode: %d, Version: 0x%x, Format: %d, Horizontal: %d, Vertical: %d, "
@@ -102,8 +101,8 @@ void Graphics::print_info(void) const {
         status = uefi_call_wrapper(gBS->FreePool, 1, mode_info);
         if (EFI_ERROR(status)) {
             debug(L"FreePool failed: %d\n", status);
-            throw std::runtime_error("EFI_ERROR(status)");
+            return Unexpected(status);
         }
     }
-    return;
+    return {};
 }
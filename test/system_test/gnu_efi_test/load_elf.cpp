@@ -16,7 +16,6 @@
 
 #include <cstring>
 #include <cwchar>
-#include <memory>
 
 #include "load_elf.h"
 
@@ -35,10 +34,14 @@ static size_t char2wchar(wchar_t* _d, const char* _s) {
     return i;
 }
 
-size_t Elf::get_file_size(void) const {
+Expected<size_t, EFI_STATUS> Elf::get_file_size(void) const {
     // 获取 elf 文件大小
     auto elf_file_info = LibFileInfo(elf);
-    auto file_size     = elf_file_info->FileSize;
+    if (elf_file_info == nullptr) {
+        debug(L"LibFileInfo failed\n");
+        return Unexpected(EFI_LOAD_ERROR);
+    }
+    auto file_size = elf_file_info->FileSize;
     return file_size;
 }
 
@@ -642,7 +645,7 @@ void Elf::print_shdr(void) const {
     return;
 }
 
-void Elf::load_sections(const Elf64_Phdr& _phdr) const {
+Expected<void, EFI_STATUS> Elf::load_sections(const Elf64_Phdr& _phdr) const {
     EFI_STATUS status;
     void*      data               = nullptr;
     // 计算使用的内存页数
@@ -652,7 +655,7 @@ void Elf::load_sections(const Elf64_Phdr& _phdr) const {
     status = uefi_call_wrapper(elf->SetPosition, 2, elf, _phdr.p_offset);
     if (EFI_ERROR(status)) {
         debug(L"SetPosition failed %d\n", status);
-        throw std::runtime_error("memory_map == nullptr");
+        return Unexpected(status);
     }
     uint64_t aaa = 0;
     // status = uefi_call_wrapper(gBS->AllocatePages, 4, AllocateAddress,
@@ -664,7 +667,7 @@ void Elf::load_sections(const Elf64_Phdr& _phdr) const {
     debug(L"_phdr.p_paddr: [%d] [%d] 0x%X\n", status, section_page_count, aaa);
     if (EFI_ERROR(status)) {
         debug(L"AllocatePages AllocateAddress failed %d\n", status);
-        throw std::runtime_error("EFI_ERROR(status)");
+        return Unexpected(status);
     }
 
     if (_phdr.p_filesz > 0) {
@@ -674,14 +677,14 @@ void Elf::load_sections(const Elf64_Phdr& _phdr) const {
                                    buffer_read_size, (void**)&data);
         if (EFI_ERROR(status)) {
             debug(L"AllocatePool failed %d\n", status);
-            throw std::runtime_error("EFI_ERROR(status)");
+            return Unexpected(status);
         }
         // 读数据
         status = uefi_call_wrapper(elf->Read, 3, elf, &buffer_read_size,
                                    (void*)data);
         if (EFI_ERROR(status)) {
             debug(L"Read failed %d\n", status);
-            throw std::runtime_error("EFI_ERROR(status)");
+            return Unexpected(status);
         }
 
         // 将读出来的数据复制到其对应的物理地址
@@ -692,7 +695,7 @@ void Elf::load_sections(const Elf64_Phdr& _phdr) const {
         status = uefi_call_wrapper(gBS->FreePool, 1, data);
         if (EFI_ERROR(status)) {
             debug(L"FreePool failed %d\n", status);
-            throw std::runtime_error("EFI_ERROR(status)");
+            return Unexpected(status);
         }
     }
 
@@ -707,36 +710,40 @@ void Elf::load_sections(const Elf64_Phdr& _phdr) const {
                           zero_fill_count, 0);
     }
 
-    return;
+    return {};
 }
 
-void Elf::load_program_sections(void) const {
+Expected<void, EFI_STATUS> Elf::load_program_sections(void) const {
     uint64_t loaded = 0;
     for (uint64_t i = 0; i < ehdr.e_phnum; i++) {
         if (phdr[i].p_type != PT_LOAD) {
             continue;
         }
-        load_sections(phdr[i]);
+        auto load_sections_ret = load_sections(phdr[i]);
+        if (!load_sections_ret) {
+            return load_sections_ret;
+        }
         loaded++;
     }
 
     if (loaded == 0) {
         debug(
           L"Fatal Error: No loadable program segments found in Kernel image\n");
-        throw std::runtime_error("loaded == 0");
+        return Unexpected(EFI_LOAD_ERROR);
     }
 
-    return;
+    return {};
 }
 
-Elf::Elf(const wchar_t* const _kernel_image_filename) {
+Expected<void, EFI_STATUS>
+Elf::init(const wchar_t* const _kernel_image_filename) {
     EFI_STATUS status;
     // 打开文件系统协议
     status
       = LibLocateProtocol(&FileSystemProtocol, (void**)&file_system_protocol);
     if (EFI_ERROR(status)) {
         debug(L"LibLocateProtocol failed %d\n", status);
-        throw std::runtime_error("EFI_ERROR(status)");
+        return Unexpected(status);
     }
 
     // 打开根文件系统
@@ -744,7 +751,7 @@ Elf::Elf(const wchar_t* const _kernel_image_filename) {
                                file_system_protocol, &root_file_system);
     if (EFI_ERROR(status)) {
         debug(L"OpenVolume failed %d\n", status);
-        throw std::runtime_error("EFI_ERROR(status)");
+        return Unexpected(status);
     }
 
     // 打开 elf 文件
@@ -753,16 +760,16 @@ Elf::Elf(const wchar_t* const _kernel_image_filename) {
                                EFI_FILE_MODE_READ, EFI_FILE_READ_ONLY);
     if (EFI_ERROR(status)) {
         debug(L"Open failed %d\n", status);
-        throw std::runtime_error("EFI_ERROR(status)");
+        return Unexpected(status);
     }
 
     // 获取 elf 文件大小
-    try {
-        elf_file_size = get_file_size();
-    } catch (std::runtime_error& _e) {
-        debug(L"get_file_size failed %s\n", _e.what());
-        throw std::runtime_error(_e.what());
+    auto get_file_size_ret = get_file_size();
+    if (!get_file_size_ret) {
+        debug(L"get_file_size failed %d\n", get_file_size_ret.error());
+        return Unexpected(get_file_size_ret.error());
     }
+    elf_file_size = *get_file_size_ret;
     debug(L"Kernel file size: %llu\n", elf_file_size);
 
     // 分配 elf 文件缓存
@@ -770,7 +777,7 @@ Elf::Elf(const wchar_t* const _kernel_image_filename) {
                                elf_file_size, (void**)&elf_file_buffer);
     if (EFI_ERROR(status)) {
         debug(L"AllocatePool failed %d\n", status);
-        throw std::runtime_error("EFI_ERROR(status)");
+        return Unexpected(status);
     }
 
     // 将内核文件读入内存
@@ -778,14 +785,14 @@ Elf::Elf(const wchar_t* const _kernel_image_filename) {
                                elf_file_buffer);
     if (EFI_ERROR(status)) {
         debug(L"Read failed %d\n", status);
-        throw std::runtime_error("EFI_ERROR(status)");
+        return Unexpected(status);
     }
 
     // 检查 elf 头数据
     auto check_elf_identity_ret = check_elf_identity();
     if (check_elf_identity_ret == false) {
         debug(L"NOT valid ELF file\n");
-        throw std::runtime_error("check_elf_identity_ret == false");
+        return Unexpected(EFI_LOAD_ERROR);
     }
 
     // 读取 ehdr
@@ -798,30 +805,121 @@ Elf::Elf(const wchar_t* const _kernel_image_filename) {
     get_shdr();
     print_shdr();
 
-    return;
+    return {};
 }
 
 Elf::~Elf(void) {
-    try {
-        EFI_STATUS status;
-        // 关闭 elf 文件
-        status = uefi_call_wrapper(elf->Close, 1, elf);
-        if (EFI_ERROR(status)) {
-            debug(L"Close failed %d\n", status);
-            throw std::runtime_error("EFI_ERROR(status)");
-        }
-    } catch (std::runtime_error& _e) {
-        debug(L"~Elf failed %s\n", _e.what());
+    if (elf == nullptr) {
+        return;
+    }
+    // 关闭 elf 文件
+    auto status = uefi_call_wrapper(elf->Close, 1, elf);
+    if (EFI_ERROR(status)) {
+        debug(L"~Elf Close failed %d\n", status);
     }
     return;
 }
 
-uint64_t Elf::load_kernel_image(void) const {
-    try {
-        load_program_sections();
-    } catch (std::runtime_error& _e) {
-        debug(L"load_kernel_image %s\n", _e.what());
+Expected<uint64_t, EFI_STATUS> Elf::load_kernel_image(void) const {
+    auto load_program_sections_ret = load_program_sections();
+    if (!load_program_sections_ret) {
+        debug(L"load_kernel_image failed %d\n",
+              load_program_sections_ret.error());
+        return Unexpected(load_program_sections_ret.error());
     }
 
     return 0x06409000 + 0x1040;
 }
+
+Initrd::~Initrd(void) {
+    // 正常情况下 load 返回前已经关闭
+    close();
+    return;
+}
+
+void Initrd::close(void) {
+    if (initrd == nullptr) {
+        return;
+    }
+    auto status = uefi_call_wrapper(initrd->Close, 1, initrd);
+    if (EFI_ERROR(status)) {
+        debug(L"Initrd Close failed %d\n", status);
+    }
+    initrd = nullptr;
+    return;
+}
+
+Expected<void, EFI_STATUS> Initrd::load(const wchar_t* const _filename) {
+    EFI_STATUS status;
+    // 打开文件系统协议
+    status
+      = LibLocateProtocol(&FileSystemProtocol, (void**)&file_system_protocol);
+    if (EFI_ERROR(status)) {
+        debug(L"LibLocateProtocol failed %d\n", status);
+        return Unexpected(status);
+    }
+
+    // 打开根文件系统
+    status = uefi_call_wrapper(file_system_protocol->OpenVolume, 2,
+                               file_system_protocol, &root_file_system);
+    if (EFI_ERROR(status)) {
+        debug(L"OpenVolume failed %d\n", status);
+        return Unexpected(status);
+    }
+
+    // 打开 initramfs 文件，不存在时由调用者决定是否继续
+    status = uefi_call_wrapper(root_file_system->Open, 5, root_file_system,
+                               &initrd, (wchar_t*)_filename,
+                               EFI_FILE_MODE_READ, EFI_FILE_READ_ONLY);
+    if (EFI_ERROR(status)) {
+        initrd = nullptr;
+        return Unexpected(status);
+    }
+
+    // 获取文件大小
+    auto initrd_file_info = LibFileInfo(initrd);
+    if (initrd_file_info == nullptr) {
+        debug(L"LibFileInfo failed\n");
+        close();
+        return Unexpected(EFI_LOAD_ERROR);
+    }
+    size = initrd_file_info->FileSize;
+    FreePool(initrd_file_info);
+    if (size == 0) {
+        close();
+        return {};
+    }
+
+    // 分配连续的页，直接读入，不经过中间缓冲
+    status = uefi_call_wrapper(gBS->AllocatePages, 4, AllocateAnyPages,
+                               EfiLoaderData, EFI_SIZE_TO_PAGES(size), &base);
+    if (EFI_ERROR(status)) {
+        debug(L"AllocatePages failed %d\n", status);
+        size = 0;
+        close();
+        return Unexpected(status);
+    }
+    auto read_size = size;
+    status         = uefi_call_wrapper(initrd->Read, 3, initrd, &read_size,
+                                       (void*)base);
+    // 之后不再访问文件，在退出 boot service 之前关闭
+    close();
+    if (EFI_ERROR(status) || (read_size != size)) {
+        debug(L"Read failed %d\n", status);
+        uefi_call_wrapper(gBS->FreePages, 2, base, EFI_SIZE_TO_PAGES(size));
+        base = 0;
+        size = 0;
+        return Unexpected(EFI_ERROR(status) ? status : EFI_LOAD_ERROR);
+    }
+    debug(L"Initrd: 0x%llX, %llu bytes\n", base, size);
+
+    return {};
+}
+
+uint64_t Initrd::start(void) const {
+    return base;
+}
+
+uint64_t Initrd::end(void) const {
+    return base + size;
+}
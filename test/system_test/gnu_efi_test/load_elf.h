@@ -5,6 +5,8 @@
 #include <elf.h>
 #include <utility>
 
+#include "expected.hpp"
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -51,33 +53,42 @@ bool           check_for_fatal_error(IN EFI_STATUS const _status,
 class Graphics {
 private:
     /// 图形输出协议
-    EFI_GRAPHICS_OUTPUT_PROTOCOL* gop;
+    EFI_GRAPHICS_OUTPUT_PROTOCOL* gop = nullptr;
 
 public:
     /**
      * 构造函数
      */
-    Graphics(void);
+    Graphics(void) = default;
 
     /**
      * 析构函数
      */
     ~Graphics(void) = default;
 
+    /**
+     * 初始化，获取图形输出协议
+     * @return 失败时返回 efi 错误码
+     */
+    Expected<void, EFI_STATUS> init(void);
+
     /**
      * 设置图形模式
      * @param _format 图形像素格式，默认为 PixelBlueGreenRedReserved8BitPerColor
      * @param _w 宽度，默认为 1920
      * @param _h 高度，默认为 1080
+     * @return 失败时返回 efi 错误码
      */
-    void set_mode(EFI_GRAPHICS_PIXEL_FORMAT _format
-                  = PixelBlueGreenRedReserved8BitPerColor,
-                  uint32_t _w = 1920, uint32_t _h = 1080) const;
+    Expected<void, EFI_STATUS>
+    set_mode(EFI_GRAPHICS_PIXEL_FORMAT _format
+             = PixelBlueGreenRedReserved8BitPerColor,
+             uint32_t _w = 1920, uint32_t _h = 1080) const;
 
     /**
      * 输出图形信息
+     * @return 失败时返回 efi 错误码
      */
-    void print_info(void) const;
+    Expected<void, EFI_STATUS> print_info(void) const;
 };
 
 class Memory {
@@ -91,24 +102,32 @@ private:
 
     /**
      * 更新内存映射信息
+     * @return 失败时返回 efi 错误码
      */
-    void                   flush_desc(void);
+    Expected<void, EFI_STATUS> flush_desc(void);
 
 public:
     /**
      * 构造函数
      */
-    Memory(void);
+    Memory(void) = default;
 
     /**
      * 析构函数
      */
     ~Memory(void) = default;
 
+    /**
+     * 初始化，读取内存映射信息
+     * @return 失败时返回 efi 错误码
+     */
+    Expected<void, EFI_STATUS> init(void);
+
     /**
      * 输出内存映射信息
+     * @return 失败时返回 efi 错误码
      */
-    void print_info(void);
+    Expected<void, EFI_STATUS> print_info(void);
 };
 
 /**
@@ -131,9 +150,9 @@ private:
 
     /**
      * 获取文件大小
-     * @return 文件大小
+     * @return 文件大小，失败时返回 efi 错误码
      */
-    size_t                           get_file_size(void) const;
+    Expected<size_t, EFI_STATUS>     get_file_size(void) const;
 
     /**
      * 检查 elf 标识
@@ -174,23 +193,77 @@ private:
     /**
      * 将 elf 段加载到内存
      * @param _phdr 要加载的程序段 phdr
+     * @return 失败时返回 efi 错误码
      */
-    void load_sections(const Elf64_Phdr& _phdr) const;
+    Expected<void, EFI_STATUS> load_sections(const Elf64_Phdr& _phdr) const;
 
     /**
      * 加载程序段
+     * @return 失败时返回 efi 错误码
      */
-    void load_program_sections(void) const;
+    Expected<void, EFI_STATUS> load_program_sections(void) const;
 
 public:
-    Elf(const wchar_t* const _kernel_image_filename);
+    Elf(void) = default;
     ~Elf(void);
 
+    /**
+     * 打开并解析 elf 文件
+     * @param _kernel_image_filename 文件名
+     * @return 失败时返回 efi 错误码
+     */
+    Expected<void, EFI_STATUS> init(const wchar_t* const _kernel_image_filename);
+
     /**
      * 加载 elf 内核
-     * @return 内核入口点
+     * @return 内核入口点，失败时返回 efi 错误码
+     */
+    Expected<uint64_t, EFI_STATUS> load_kernel_image(void) const;
+};
+
+/**
+ * initramfs 相关
+ * 不压缩的 tar 归档整体读入一块连续的页，内核直接在这块内存上访问文件，
+ * 不解包也不复制
+ */
+class Initrd {
+private:
+    EFI_SIMPLE_FILE_SYSTEM_PROTOCOL* file_system_protocol = nullptr;
+    EFI_FILE*                        root_file_system     = nullptr;
+    EFI_FILE*                        initrd               = nullptr;
+    /// 起始物理地址，页对齐
+    EFI_PHYSICAL_ADDRESS             base                 = 0;
+    size_t                           size                 = 0;
+
+    /**
+     * 关闭文件，读入的页保留给内核
+     * 文件协议属于 boot service，需要在退出 boot service 之前关闭
+     */
+    void                             close(void);
+
+public:
+    Initrd(void) = default;
+    ~Initrd(void);
+
+    /**
+     * 打开 initramfs 文件并读入新分配的连续页
+     * 页的类型为 EfiLoaderData，退出 boot service 后由内核继续使用
+     * @param _filename 文件名
+     * @return 失败时返回 efi 错误码，文件不存在时为 EFI_NOT_FOUND
+     */
+    Expected<void, EFI_STATUS> load(const wchar_t* const _filename);
+
+    /**
+     * 起始地址，没有加载时为 0
+     * @return 起始物理地址
+     */
+    uint64_t                   start(void) const;
+
+    /**
+     * 结束地址，没有加载时为 0
+     * @return 最后一个字节之后的物理地址
      */
-    uint64_t load_kernel_image(void) const;
+    uint64_t                   end(void) const;
 };
 
 #endif /* CMAKE_KERNEL_LOAD_ELF_H */
@@ -14,26 +14,26 @@
  * </table>
  */
 
-#include <stdexcept>
-
 #include "load_elf.h"
 
-void Memory::flush_desc(void) {
+Expected<void, EFI_STATUS> Memory::flush_desc(void) {
     memory_map = LibMemoryMap(&desc_count, &map_key, &desc_size, &desc_version);
     if (memory_map == nullptr) {
         debug(L"GetMemoryMap failed2: memory_map == nullptr\n");
-        throw std::runtime_error("memory_map == nullptr");
+        return Unexpected(EFI_OUT_OF_RESOURCES);
     }
-    return;
+    return {};
 }
 
-Memory::Memory(void) {
-    flush_desc();
-    return;
+Expected<void, EFI_STATUS> Memory::init(void) {
+    return flush_desc();
 }
 
-void Memory::print_info(void) {
-    flush_desc();
+Expected<void, EFI_STATUS> Memory::print_info(void) {
+    auto flush_desc_ret = flush_desc();
+    if (!flush_desc_ret) {
+        return flush_desc_ret;
+    }
     debug(L"Type\t\t\t\tPages\tPhysicalStart\tVirtualStart\tAttribute\n");
     for (uint64_t i = 0; i < desc_count; i++) {
         EFI_MEMORY_DESCRIPTOR* MMap
@@ -110,5 +110,5 @@ void Memory::print_info(void) {
               MMap->VirtualStart, MMap->Attribute);
     }
     debug(L"map_key: 0x%X\n", map_key);
-    return;
+    return {};
 }
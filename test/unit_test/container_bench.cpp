@@ -0,0 +1,148 @@
+
+/**
+ * @file container_bench.cpp
+ * @brief libcxx 容器微基准测试
+ * @author Zone.N (Zone.Niuzh@hotmail.com)
+ * @version 1.0
+ * @date 2026-10-18
+ * @copyright MIT LICENSE
+ * https://github.com/MRNIU/cmake-kernel
+ * @par change log:
+ * <table>
+ * <tr><th>Date<th>Author<th>Description
+ * <tr><td>2026-10-18<td>Zone.N (Zone.Niuzh@hotmail.com)<td>创建文件
+ * </table>
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <list>
+#include <random>
+#include <set>
+#include <unordered_map>
+#include <vector>
+
+#include "flat_hash_map.hpp"
+#include "intrusive_list.hpp"
+#include "intrusive_rbtree.hpp"
+
+/// 每项测试的元素数
+static constexpr const size_t COUNT  = 4096;
+/// 每项测试的重复次数
+static constexpr const size_t ROUNDS = 256;
+
+/// 防止编译器优化掉结果
+static volatile uint64_t sink;
+
+/**
+ * @brief 运行 _func ROUNDS 次，输出每次操作的平均耗时
+ * @param  _name                    测试名
+ * @param  _ops                     _func 每次执行的操作数
+ * @param  _func                    测试函数
+ */
+template <class _F>
+static void bench(const char* _name, size_t _ops, _F&& _func) {
+    auto begin = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < ROUNDS; i++) {
+        _func();
+    }
+    auto end = std::chrono::steady_clock::now();
+    auto ns  = std::chrono::duration<double, std::nano>(end - begin).count();
+    printf("%-32s %8.2f ns/op\n", _name, ns / (double)(_ops * ROUNDS));
+    return;
+}
+
+struct ListElem {
+    uint64_t val;
+    ListNode node;
+};
+
+struct TreeElem {
+    uint64_t key;
+    RbNode   node;
+};
+
+struct TreeLess {
+    bool operator()(const TreeElem& _lhs, const TreeElem& _rhs) const {
+        return _lhs.key < _rhs.key;
+    }
+};
+
+int main(void) {
+    std::mt19937_64       rng(0);
+    std::vector<uint64_t> keys(COUNT);
+    for (auto& key : keys) {
+        key = rng();
+    }
+
+    // 链表：全部入队后全部出队
+    static ListElem                          list_elems[COUNT];
+    IntrusiveList<ListElem, &ListElem::node> list;
+    bench("IntrusiveList push/pop", COUNT, [&] {
+        for (auto& elem : list_elems) {
+            list.push_back(elem);
+        }
+        while (auto* elem = list.pop_front()) {
+            sink = elem->val;
+        }
+    });
+    std::list<uint64_t> std_list;
+    bench("std::list push/pop", COUNT, [&] {
+        for (auto key : keys) {
+            std_list.push_back(key);
+        }
+        while (!std_list.empty()) {
+            sink = std_list.front();
+            std_list.pop_front();
+        }
+    });
+
+    // 红黑树：随机插入后全部删除
+    static TreeElem tree_elems[COUNT];
+    for (size_t i = 0; i < COUNT; i++) {
+        tree_elems[i].key = keys[i];
+    }
+    IntrusiveRbTree<TreeElem, &TreeElem::node, TreeLess> tree;
+    bench("IntrusiveRbTree insert/erase", COUNT, [&] {
+        for (auto& elem : tree_elems) {
+            tree.insert(elem);
+        }
+        while (auto* elem = tree.first()) {
+            tree.erase(*elem);
+        }
+    });
+    std::multiset<uint64_t> std_set;
+    bench("std::multiset insert/erase", COUNT, [&] {
+        for (auto key : keys) {
+            std_set.insert(key);
+        }
+        while (!std_set.empty()) {
+            std_set.erase(std_set.begin());
+        }
+    });
+
+    // 哈希表：装载因子约 1/2 时查找，一半命中
+    static FlatHashMap<uint64_t, uint64_t, COUNT * 2> map;
+    std::unordered_map<uint64_t, uint64_t>            std_map;
+    for (auto key : keys) {
+        map.insert(key, key);
+        std_map.emplace(key, key);
+    }
+    bench("FlatHashMap find", COUNT * 2, [&] {
+        uint64_t sum = 0;
+        for (auto key : keys) {
+            sum += *map.find(key);
+            sum += map.contains(key + 1);
+        }
+        sink = sum;
+    });
+    bench("std::unordered_map find", COUNT * 2, [&] {
+        uint64_t sum = 0;
+        for (auto key : keys) {
+            sum += std_map.find(key)->second;
+            sum += std_map.count(key + 1);
+        }
+        sink = sum;
+    });
+    return 0;
+}
@@ -0,0 +1,302 @@
+
+/**
+ * @file container_test.cpp
+ * @brief libcxx 容器测试
+ * @author Zone.N (Zone.Niuzh@hotmail.com)
+ * @version 1.0
+ * @date 2026-10-18
+ * @copyright MIT LICENSE
+ * https://github.com/MRNIU/cmake-kernel
+ * @par change log:
+ * <table>
+ * <tr><th>Date<th>Author<th>Description
+ * <tr><td>2026-10-18<td>Zone.N (Zone.Niuzh@hotmail.com)<td>创建文件
+ * </table>
+ */
+
+#include <algorithm>
+#include <gtest/gtest.h>
+#include <random>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "flat_hash_map.hpp"
+#include "intrusive_list.hpp"
+#include "intrusive_rbtree.hpp"
+#include "ring_buffer.hpp"
+#include "static_vector.hpp"
+
+struct ListElem {
+    int      val;
+    ListNode node;
+};
+
+using List = IntrusiveList<ListElem, &ListElem::node>;
+
+TEST(IntrusiveListTest, PushPopOrder) {
+    ListElem elems[4] = { { 0, {} }, { 1, {} }, { 2, {} }, { 3, {} } };
+    List     list;
+    EXPECT_TRUE(list.empty());
+    list.push_back(elems[1]);
+    list.push_back(elems[2]);
+    list.push_front(elems[0]);
+    list.insert_before(elems[2], elems[3]);
+    EXPECT_EQ(list.size(), 4U);
+
+    std::vector<int> order;
+    for (auto& elem : list) {
+        order.push_back(elem.val);
+    }
+    EXPECT_EQ(order, (std::vector<int>{ 0, 1, 3, 2 }));
+    EXPECT_EQ(list.next(elems[2]), nullptr);
+    EXPECT_EQ(list.prev(elems[0]), nullptr);
+
+    list.erase(elems[3]);
+    EXPECT_FALSE(elems[3].node.is_linked());
+    EXPECT_EQ(list.pop_front(), &elems[0]);
+    EXPECT_EQ(list.pop_back(), &elems[2]);
+    EXPECT_EQ(list.pop_back(), &elems[1]);
+    EXPECT_EQ(list.pop_back(), nullptr);
+    EXPECT_TRUE(list.empty());
+}
+
+TEST(IntrusiveListTest, SpliceBack) {
+    ListElem elems[6];
+    List     lhs;
+    List     rhs;
+    for (int i = 0; i < 6; i++) {
+        elems[i].val = i;
+        (i < 3 ? lhs : rhs).push_back(elems[i]);
+    }
+    lhs.splice_back(rhs);
+    EXPECT_TRUE(rhs.empty());
+    EXPECT_EQ(lhs.size(), 6U);
+    int expect = 0;
+    for (auto& elem : lhs) {
+        EXPECT_EQ(elem.val, expect++);
+    }
+    // 空链表拼接后仍然可用
+    rhs.push_back(*lhs.pop_front());
+    EXPECT_EQ(rhs.front(), &elems[0]);
+}
+
+struct TreeElem {
+    int    key;
+    RbNode node;
+};
+
+struct TreeLess {
+    bool operator()(const TreeElem& _lhs, const TreeElem& _rhs) const {
+        return _lhs.key < _rhs.key;
+    }
+};
+
+using Tree = IntrusiveRbTree<TreeElem, &TreeElem::node, TreeLess>;
+
+/**
+ * @brief 检查红黑树性质，返回黑高
+ */
+static int rb_check(const RbNode* _node) {
+    if (_node == nullptr) {
+        return 1;
+    }
+    if (_node->red) {
+        EXPECT_FALSE((_node->left != nullptr) && _node->left->red);
+        EXPECT_FALSE((_node->right != nullptr) && _node->right->red);
+    }
+    if (_node->left != nullptr) {
+        EXPECT_EQ(_node->left->parent, _node);
+    }
+    if (_node->right != nullptr) {
+        EXPECT_EQ(_node->right->parent, _node);
+    }
+    auto left  = rb_check(_node->left);
+    auto right = rb_check(_node->right);
+    EXPECT_EQ(left, right);
+    return left + (_node->red ? 0 : 1);
+}
+
+static void tree_check(Tree& _tree, std::vector<int> _keys) {
+    std::sort(_keys.begin(), _keys.end());
+    ASSERT_EQ(_tree.size(), _keys.size());
+    size_t i    = 0;
+    auto*  elem = _tree.first();
+    while (elem != nullptr) {
+        ASSERT_LT(i, _keys.size());
+        EXPECT_EQ(elem->key, _keys[i++]);
+        elem = _tree.next(*elem);
+    }
+    EXPECT_EQ(i, _keys.size());
+    if (_tree.empty()) {
+        return;
+    }
+    // 从任意节点沿父指针找到根
+    const RbNode* root = &_tree.first()->node;
+    while (root->parent != nullptr) {
+        root = root->parent;
+    }
+    EXPECT_FALSE(root->red);
+    rb_check(root);
+    return;
+}
+
+TEST(IntrusiveRbTreeTest, RandomInsertErase) {
+    constexpr size_t      count = 2000;
+    std::vector<TreeElem> elems(count);
+    std::vector<int>      keys;
+    std::mt19937          rng(1);
+    Tree                  tree;
+    for (auto& elem : elems) {
+        // 键有重复
+        elem.key = static_cast<int>(rng() % (count / 2));
+        tree.insert(elem);
+        keys.push_back(elem.key);
+    }
+    tree_check(tree, keys);
+    EXPECT_EQ(tree.first()->key, *std::min_element(keys.begin(), keys.end()));
+    EXPECT_EQ(tree.last()->key, *std::max_element(keys.begin(), keys.end()));
+
+    std::vector<size_t> order(count);
+    for (size_t i = 0; i < count; i++) {
+        order[i] = i;
+    }
+    std::shuffle(order.begin(), order.end(), rng);
+    for (size_t i = 0; i < count; i++) {
+        auto& elem = elems[order[i]];
+        tree.erase(elem);
+        keys.erase(std::find(keys.begin(), keys.end(), elem.key));
+        if (i % 97 == 0) {
+            tree_check(tree, keys);
+        }
+    }
+    EXPECT_TRUE(tree.empty());
+    EXPECT_EQ(tree.first(), nullptr);
+}
+
+TEST(IntrusiveRbTreeTest, LowerBound) {
+    TreeElem elems[5] = { { 10, {} }, { 20, {} }, { 30, {} }, { 40, {} },
+                          { 50, {} } };
+    Tree     tree;
+    for (auto& elem : elems) {
+        tree.insert(elem);
+    }
+    auto less = [](const TreeElem& _elem, int _key) {
+        return _elem.key < _key;
+    };
+    EXPECT_EQ(tree.lower_bound(5, less), &elems[0]);
+    EXPECT_EQ(tree.lower_bound(30, less), &elems[2]);
+    EXPECT_EQ(tree.lower_bound(31, less), &elems[3]);
+    EXPECT_EQ(tree.lower_bound(51, less), nullptr);
+}
+
+TEST(FlatHashMapTest, MatchesUnorderedMap) {
+    static FlatHashMap<uint64_t, uint64_t, 1024> map;
+    std::unordered_map<uint64_t, uint64_t>       ref;
+    std::mt19937_64                              rng(2);
+    for (size_t i = 0; i < 100000; i++) {
+        auto key = rng() % 1500;
+        if ((rng() % 3) == 0) {
+            EXPECT_EQ(map.erase(key), ref.erase(key) == 1);
+        }
+        else if (ref.size() < 896) {
+            auto* val = map.insert(key, i);
+            ASSERT_NE(val, nullptr);
+            // 已存在时不覆盖
+            EXPECT_EQ(*val, ref.emplace(key, i).first->second);
+        }
+        ASSERT_EQ(map.size(), ref.size());
+    }
+    for (uint64_t key = 0; key < 1500; key++) {
+        auto* val = map.find(key);
+        auto  it  = ref.find(key);
+        ASSERT_EQ(val != nullptr, it != ref.end());
+        if (val != nullptr) {
+            EXPECT_EQ(*val, it->second);
+        }
+    }
+}
+
+TEST(FlatHashMapTest, FullAndTombstones) {
+    static FlatHashMap<uint32_t, uint32_t, 64> map;
+    // 装载因子上限为 7/8
+    for (uint32_t i = 0; i < 56; i++) {
+        ASSERT_NE(map.insert(i, i), nullptr);
+    }
+    EXPECT_EQ(map.insert(1000, 0), nullptr);
+    EXPECT_NE(map.insert(3, 0), nullptr);
+    // 反复删除与插入不会因为已删除的槽而找不到空槽
+    for (uint32_t round = 0; round < 1000; round++) {
+        ASSERT_TRUE(map.erase(round % 56 + round / 56 * 56));
+        ASSERT_NE(map.insert(round + 56, round), nullptr);
+        ASSERT_EQ(map.size(), 56U);
+    }
+    size_t count = 0;
+    map.for_each([&](const uint32_t&, uint32_t&) { count++; });
+    EXPECT_EQ(count, 56U);
+    map.clear();
+    EXPECT_TRUE(map.empty());
+    EXPECT_EQ(map.find(1055), nullptr);
+}
+
+TEST(StaticVectorTest, CapacityAndSwapErase) {
+    StaticVector<std::vector<int>, 4> vec;
+    for (int i = 0; i < 4; i++) {
+        EXPECT_NE(vec.emplace_back(1, i), nullptr);
+    }
+    EXPECT_TRUE(vec.full());
+    EXPECT_EQ(vec.emplace_back(1, 4), nullptr);
+    vec.swap_erase(1);
+    EXPECT_EQ(vec.size(), 3U);
+    EXPECT_EQ(vec[1][0], 3);
+    vec.swap_erase(2);
+    EXPECT_EQ(vec.back()[0], 3);
+    vec.clear();
+    EXPECT_TRUE(vec.empty());
+}
+
+TEST(RingBufferTest, FullEmptyWrap) {
+    static RingBuffer<uint32_t, 8> ring;
+    uint32_t                       val;
+    EXPECT_FALSE(ring.pop(val));
+    for (uint32_t round = 0; round < 5; round++) {
+        for (uint32_t i = 0; i < 8; i++) {
+            EXPECT_TRUE(ring.push(round * 8 + i));
+        }
+        EXPECT_FALSE(ring.push(0));
+        EXPECT_EQ(ring.size(), 8U);
+        for (uint32_t i = 0; i < 8; i++) {
+            ASSERT_TRUE(ring.pop(val));
+            EXPECT_EQ(val, round * 8 + i);
+        }
+        EXPECT_TRUE(ring.empty());
+    }
+}
+
+TEST(RingBufferTest, SingleProducerSingleConsumer) {
+    static RingBuffer<uint64_t, 64> ring;
+    constexpr uint64_t              count = 1000000;
+    std::thread                     producer([] {
+        for (uint64_t i = 0; i < count;) {
+            if (ring.push(i)) {
+                i++;
+            }
+            else {
+                std::this_thread::yield();
+            }
+        }
+    });
+    uint64_t expect = 0;
+    while (expect < count) {
+        uint64_t val;
+        if (ring.pop(val)) {
+            ASSERT_EQ(val, expect);
+            expect++;
+        }
+        else {
+            std::this_thread::yield();
+        }
+    }
+    producer.join();
+    EXPECT_TRUE(ring.empty());
+}
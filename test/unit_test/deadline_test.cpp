@@ -0,0 +1,417 @@
+
+/**
+ * @file deadline_test.cpp
+ * @brief 截止时间调度测试
+ * @author Zone.N (Zone.Niuzh@hotmail.com)
+ * @version 1.0
+ * @date 2026-10-18
+ * @copyright MIT LICENSE
+ * https://github.com/MRNIU/cmake-kernel
+ * @par change log:
+ * <table>
+ * <tr><th>Date<th>Author<th>Description
+ * <tr><td>2026-10-18<td>Zone.N (Zone.Niuzh@hotmail.com)<td>创建文件
+ * </table>
+ */
+
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include "runqueue.h"
+#include "sched.h"
+#include "timer.h"
+
+/**
+ * 直接调用截止时间调度类，运行队列、定时器与切换由测试模拟。
+ * 检查准入的带宽计算与 cpu 选择，并在单个 cpu 上按固定步长模拟
+ * 周期任务: 准入的任务集合不错过截止时间，超出预算的任务被限流，
+ * 不影响其它任务
+ */
+
+/// 模拟的步长
+static constexpr const uint64_t STEP        = 10000;
+/// 模拟时长
+static constexpr const uint64_t HORIZON     = 2000000000;
+/// 周期的单位与范围
+static constexpr const uint64_t PERIOD_UNIT = 100000;
+static constexpr const uint64_t PERIOD_MIN  = 10;
+static constexpr const uint64_t PERIOD_MAX  = 200;
+/// 任务数上限
+static constexpr const size_t   TASKS       = 32;
+/// 随机任务集合数
+static constexpr const size_t   TASK_SETS   = 8;
+/// 毫秒
+static constexpr const uint64_t MS          = 1000000;
+
+rq_t runqueues[MAX_CPU_COUNT];
+
+/// 模拟的时间
+static uint64_t               fake_now;
+/// 可以接收任务的 cpu
+static uint64_t               fake_active;
+/// 需要重新调度
+static bool                   fake_resched;
+/// 挂起的定时器
+static std::vector<ktimer_t*> fake_timers;
+
+bool cpu_active(size_t _cpu) {
+    return ((fake_active >> _cpu) & 1) != 0;
+}
+
+void timer_init(ktimer_t* _timer, void (*_func)(ktimer_t* _timer)) {
+    *_timer      = {};
+    _timer->func = _func;
+    return;
+}
+
+void timer_add(ktimer_t* _timer, uint64_t _expires) {
+    if (std::find(fake_timers.begin(), fake_timers.end(), _timer)
+        == fake_timers.end()) {
+        fake_timers.push_back(_timer);
+    }
+    _timer->expires = _expires;
+    return;
+}
+
+bool timer_del(ktimer_t* _timer) {
+    auto it = std::find(fake_timers.begin(), fake_timers.end(), _timer);
+    if (it == fake_timers.end()) {
+        return false;
+    }
+    fake_timers.erase(it);
+    return true;
+}
+
+void resched_cpu(size_t _cpu) {
+    (void)_cpu;
+    fake_resched = true;
+    return;
+}
+
+void update_rq_clock(rq_t* _rq) {
+    _rq->clock = fake_now;
+    return;
+}
+
+rq_t* task_rq_lock(task_t* _task) {
+    auto* rq = cpu_rq(_task->cpu);
+    rq->lock.lock();
+    return rq;
+}
+
+void check_preempt_curr(rq_t* _rq, task_t* _task) {
+    if ((_rq->curr == nullptr)
+        || _task->sched_class->check_preempt(_rq, _task)) {
+        fake_resched = true;
+    }
+    return;
+}
+
+task_t* current_task(void) {
+    return cpu_rq(0)->curr;
+}
+
+bool task_wakeup(task_t* _task) {
+    auto* rq      = cpu_rq(_task->cpu);
+    _task->state  = TASK_RUNNING;
+    _task->on_rq  = true;
+    update_rq_clock(rq);
+    _task->sched_class->enqueue(rq, _task, ENQUEUE_WAKEUP);
+    check_preempt_curr(rq, _task);
+    return true;
+}
+
+void schedule(void) {
+    // 切换由模拟循环完成，这里只处理进入等待的当前任务
+    auto* rq   = cpu_rq(0);
+    auto* curr = rq->curr;
+    if ((curr != nullptr) && (curr->state != TASK_RUNNING)) {
+        curr->sched_class->dequeue(rq, curr, DEQUEUE_SLEEP);
+        curr->on_rq = false;
+    }
+    fake_resched = true;
+    return;
+}
+
+void yield(void) {
+    return;
+}
+
+/**
+ * @brief 新任务，允许在全部 cpu 上运行
+ */
+static void task_reset(task_t* _task) {
+    *_task              = {};
+    _task->state        = TASK_NEW;
+    _task->cpus_allowed = ~0ULL;
+    return;
+}
+
+static void sched_reset(uint64_t _active) {
+    for (size_t cpu = 0; cpu < MAX_CPU_COUNT; cpu++) {
+        auto* rq          = cpu_rq(cpu);
+        rq->cpu           = cpu;
+        rq->curr          = nullptr;
+        rq->clock         = 0;
+        rq->dl.total_bw   = 0;
+        rq->dl.nr_running = 0;
+        rq->dl_misses     = 0;
+        rq->dl_overruns   = 0;
+    }
+    fake_now     = 0;
+    fake_active  = _active;
+    fake_resched = false;
+    fake_timers.clear();
+    return;
+}
+
+static uint64_t bw_of(uint64_t _runtime, uint64_t _period) {
+    return (_runtime << DL_BW_SHIFT) / _period;
+}
+
+static const uint64_t BW_LIMIT = (DL_BW_LIMIT_PERCENT << DL_BW_SHIFT) / 100;
+
+TEST(DeadlineTest, AdmissionParameters) {
+    sched_reset(1);
+    task_t task;
+    task_reset(&task);
+    // 运行时间过短、超过截止时间，截止时间超过周期
+    EXPECT_FALSE(sched_set_deadline(&task, DL_MIN_RUNTIME_NS - 1, MS, MS));
+    EXPECT_FALSE(sched_set_deadline(&task, 2 * MS, MS, 2 * MS));
+    EXPECT_FALSE(sched_set_deadline(&task, MS, 3 * MS, 2 * MS));
+    // 左移后溢出
+    EXPECT_FALSE(sched_set_deadline(&task, DL_MAX_RUNTIME_NS + 1,
+                                    DL_MAX_RUNTIME_NS + 1,
+                                    DL_MAX_RUNTIME_NS + 1));
+    // 带宽的定点数为 0
+    EXPECT_FALSE(sched_set_deadline(&task, DL_MIN_RUNTIME_NS,
+                                    DL_MIN_RUNTIME_NS,
+                                    DL_MIN_RUNTIME_NS << (DL_BW_SHIFT + 1)));
+    // 不是新任务
+    task.state = TASK_RUNNING;
+    EXPECT_FALSE(sched_set_deadline(&task, MS, MS, 2 * MS));
+    EXPECT_EQ(cpu_rq(0)->dl.total_bw, 0);
+
+    task_reset(&task);
+    ASSERT_TRUE(sched_set_deadline(&task, MS, 2 * MS, 4 * MS));
+    EXPECT_EQ(task.sched_class, &dl_sched_class);
+    EXPECT_EQ(task.dl_bw, bw_of(MS, 4 * MS));
+    EXPECT_EQ(task.cpus_allowed, 1);
+    EXPECT_EQ(cpu_rq(0)->dl.total_bw, task.dl_bw);
+    // 已经是截止时间调度
+    task.state = TASK_NEW;
+    EXPECT_FALSE(sched_set_deadline(&task, MS, 2 * MS, 4 * MS));
+    dl_sched_class.task_dead(&task);
+    EXPECT_EQ(cpu_rq(0)->dl.total_bw, 0);
+}
+
+TEST(DeadlineTest, AdmissionLimit) {
+    sched_reset(1);
+    // 恰好等于上限时可以准入，之后任何任务都不能准入
+    task_t full;
+    task_reset(&full);
+    ASSERT_EQ(bw_of(95 * MS, 100 * MS), BW_LIMIT);
+    ASSERT_TRUE(sched_set_deadline(&full, 95 * MS, 100 * MS, 100 * MS));
+    task_t task;
+    task_reset(&task);
+    EXPECT_FALSE(sched_set_deadline(&task, DL_MIN_RUNTIME_NS, 100 * MS,
+                                    100 * MS));
+    // 退出后释放带宽
+    dl_sched_class.task_dead(&full);
+    EXPECT_TRUE(sched_set_deadline(&task, DL_MIN_RUNTIME_NS, 100 * MS,
+                                   100 * MS));
+}
+
+TEST(DeadlineTest, AdmissionRandom) {
+    // cpu 0、2、3 可用
+    sched_reset(0b1101);
+    std::mt19937_64     rng(20261018);
+    std::vector<task_t> tasks(4096);
+    uint64_t            model[MAX_CPU_COUNT] = {};
+    size_t              accepted             = 0;
+    for (auto& task : tasks) {
+        task_reset(&task);
+        if (rng() % 4 == 0) {
+            task.cpus_allowed = rng() % (1ULL << MAX_CPU_COUNT);
+        }
+        auto period  = (PERIOD_MIN + rng() % PERIOD_MAX) * PERIOD_UNIT;
+        auto runtime = DL_MIN_RUNTIME_NS + rng() % (period / 4);
+        auto bw      = bw_of(runtime, period);
+        // 期望选中剩余带宽最多的、放得下的 cpu，相同时取编号小的
+        size_t best = MAX_CPU_COUNT;
+        for (size_t cpu = 0; cpu < MAX_CPU_COUNT; cpu++) {
+            if ((((task.cpus_allowed & fake_active) >> cpu) & 1) == 0
+                || (model[cpu] + bw > BW_LIMIT)) {
+                continue;
+            }
+            if ((best == MAX_CPU_COUNT) || (model[cpu] < model[best])) {
+                best = cpu;
+            }
+        }
+        auto ok = sched_set_deadline(&task, runtime, period, period);
+        ASSERT_EQ(ok, best != MAX_CPU_COUNT);
+        if (ok) {
+            ASSERT_EQ(task.cpu, best);
+            ASSERT_EQ(task.cpus_allowed, 1ULL << best);
+            model[best] += bw;
+            accepted++;
+        }
+        // 随机退出一些任务
+        if (ok && (rng() % 3 == 0)) {
+            dl_sched_class.task_dead(&task);
+            model[best] -= bw;
+        }
+    }
+    for (size_t cpu = 0; cpu < MAX_CPU_COUNT; cpu++) {
+        EXPECT_EQ(cpu_rq(cpu)->dl.total_bw, model[cpu]);
+        EXPECT_LE(model[cpu], BW_LIMIT);
+    }
+    EXPECT_GT(accepted, 0);
+    EXPECT_LT(accepted, tasks.size());
+}
+
+/**
+ * @brief 模拟的周期任务
+ */
+struct sim_task_t {
+    task_t   task;
+    /// 每个作业的工作量
+    uint64_t work;
+    /// 当前作业剩余的工作量
+    uint64_t left;
+    /// 完成的作业数与完成时已过截止时间的作业数
+    uint64_t jobs;
+    uint64_t late;
+};
+
+/**
+ * @brief 在 cpu 0 上按固定步长运行到 HORIZON
+ */
+static void simulate(std::vector<sim_task_t>& _tasks) {
+    auto* rq = cpu_rq(0);
+    for (auto& sim : _tasks) {
+        sim.left = sim.work;
+        task_wakeup(&sim.task);
+    }
+    fake_resched = true;
+    while (fake_now < HORIZON) {
+        // 到期的定时器
+        for (size_t i = 0; i < fake_timers.size();) {
+            auto* timer = fake_timers[i];
+            if (timer->expires > fake_now) {
+                i++;
+                continue;
+            }
+            fake_timers.erase(fake_timers.begin() + i);
+            timer->func(timer);
+            i = 0;
+        }
+        // 切换
+        if (fake_resched) {
+            fake_resched = false;
+            auto* curr   = rq->curr;
+            if (curr != nullptr) {
+                dl_sched_class.update_curr(rq);
+                dl_sched_class.put_prev(rq, curr);
+            }
+            rq->curr = dl_sched_class.pick_next(rq);
+            if (rq->curr != nullptr) {
+                rq->curr->exec_start = rq->clock;
+            }
+        }
+        fake_now += STEP;
+        update_rq_clock(rq);
+        auto* curr = rq->curr;
+        if (curr == nullptr) {
+            continue;
+        }
+        auto* sim = reinterpret_cast<sim_task_t*>(curr);
+        sim->left -= STEP;
+        dl_sched_class.tick(rq, curr);
+        if (sim->left == 0) {
+            // 作业完成，等待下一个周期
+            sim->jobs++;
+            if (fake_now > curr->dl_abs_deadline) {
+                sim->late++;
+            }
+            sim->left = sim->work;
+            sched_dl_wait_period();
+            rq->curr = nullptr;
+        }
+    }
+    // 任务随测试释放，不能留在队列中
+    for (auto& sim : _tasks) {
+        if (sim.task.dl_queued) {
+            rq->dl.tree.erase(sim.task);
+        }
+    }
+    return;
+}
+
+TEST(DeadlineTest, EdfMeetsDeadlines) {
+    std::mt19937_64 rng(20261018);
+    for (size_t set = 0; set < TASK_SETS; set++) {
+        sched_reset(1);
+        std::vector<sim_task_t> tasks(TASKS);
+        size_t                  count = 0;
+        // 随机任务，放不下时跳过，直到带宽接近上限
+        for (size_t tries = 0; (tries < 1000) && (count < TASKS); tries++) {
+            auto& sim     = tasks[count];
+            auto  period  = (PERIOD_MIN + rng() % PERIOD_MAX) * PERIOD_UNIT;
+            auto  runtime = (1 + rng() % (period / STEP / 3)) * STEP;
+            runtime       = std::max(runtime, DL_MIN_RUNTIME_NS);
+            task_reset(&sim.task);
+            if (!sched_set_deadline(&sim.task, runtime, period, period)) {
+                continue;
+            }
+            // 比预算少一步，预算恰好用完时也算超出
+            sim.work = runtime - STEP;
+            sim.jobs = 0;
+            sim.late = 0;
+            count++;
+        }
+        tasks.resize(count);
+        ASSERT_GT(count, 1);
+        EXPECT_GT(cpu_rq(0)->dl.total_bw, BW_LIMIT * 9 / 10);
+        simulate(tasks);
+        for (auto& sim : tasks) {
+            EXPECT_GE(sim.jobs, HORIZON / sim.task.dl_period - 1);
+            EXPECT_EQ(sim.late, 0);
+            EXPECT_EQ(sim.task.dl_misses, 0);
+            EXPECT_EQ(sim.task.dl_overruns, 0);
+        }
+        EXPECT_EQ(cpu_rq(0)->dl_misses, 0);
+    }
+}
+
+TEST(DeadlineTest, OverrunIsolation) {
+    sched_reset(1);
+    std::vector<sim_task_t> tasks(3);
+    uint64_t                params[][2] = {
+        { 2 * MS, 10 * MS },
+        { 3 * MS, 7 * MS },
+        // 实际工作量是预算的 3 倍
+        { 1 * MS, 5 * MS },
+    };
+    for (size_t i = 0; i < tasks.size(); i++) {
+        task_reset(&tasks[i].task);
+        ASSERT_TRUE(sched_set_deadline(&tasks[i].task, params[i][0],
+                                       params[i][1], params[i][1]));
+        tasks[i].work = params[i][0] - STEP;
+        tasks[i].jobs = 0;
+        tasks[i].late = 0;
+    }
+    tasks[2].work = 3 * params[2][0];
+    simulate(tasks);
+    // 超出预算的任务被限流，每个作业跨越多个周期
+    EXPECT_GT(tasks[2].task.dl_overruns, 0);
+    EXPECT_LE(tasks[2].jobs, HORIZON / params[2][1] / 3 + 1);
+    EXPECT_GT(tasks[2].jobs, 0);
+    for (size_t i = 0; i < 2; i++) {
+        EXPECT_EQ(tasks[i].late, 0);
+        EXPECT_EQ(tasks[i].task.dl_overruns, 0);
+        EXPECT_GE(tasks[i].jobs, HORIZON / params[i][1] - 1);
+    }
+}
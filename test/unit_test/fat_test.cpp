@@ -0,0 +1,1075 @@
+
+/**
+ * @file fat_test.cpp
+ * @brief FAT 文件系统测试
+ * @author Zone.N (Zone.Niuzh@hotmail.com)
+ * @version 1.0
+ * @date 2026-10-18
+ * @copyright MIT LICENSE
+ * https://github.com/MRNIU/cmake-kernel
+ * @par change log:
+ * <table>
+ * <tr><th>Date<th>Author<th>Description
+ * <tr><td>2026-10-18<td>Zone.N (Zone.Niuzh@hotmail.com)<td>创建文件
+ * </table>
+ */
+
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "bio.h"
+#include "driver.h"
+#include "fat.h"
+#include "mutex.h"
+#include "pagecache.h"
+#include "rcu.h"
+#include "sched.h"
+#include "wait.h"
+#include "workqueue.h"
+
+/**
+ * 在内存中构造 MBR 分区上的 FAT16 卷与 GPT 分区上的 FAT32 卷，
+ * 包括连续与碎片化的文件、长文件名、子目录与损坏的簇链。
+ * 块设备是普通内存，bio 在提交时同步完成，并记录数据区的读请求:
+ * 簇链映射为 extent 后，一页中设备上连续的扇区只产生一个 bio，
+ * 请求与按簇链计算的结果逐个比较。
+ * 等待、工作队列与 rcu 回调的处理与 pagecache_test 相同
+ */
+
+/// 与 fat.cpp 相同
+static constexpr const size_t   FAT_FILES    = 64;
+/// 目录项大小与属性
+static constexpr const size_t   DIRENT       = 32;
+static constexpr const uint8_t  ATTR_LFN     = 0x0F;
+/// 长文件名项中的字符数
+static constexpr const size_t   LFN_CHARS    = 13;
+/// 单个 bio 的最大扇区数
+static constexpr const uint32_t MAX_SECTORS  = 256;
+/// 分区的起始扇区
+static constexpr const uint64_t PART_START   = 2048;
+/// 模拟的设备: 空白、簇数不足的 FAT12 大小的卷、FAT16 与 FAT32
+static constexpr const size_t   DISK_BLANK   = 0;
+static constexpr const size_t   DISK_SMALL   = 1;
+static constexpr const size_t   DISK_FAT16   = 2;
+static constexpr const size_t   DISK_FAT32   = 3;
+static constexpr const size_t   DISKS        = 4;
+/// 子目录中的文件数，超过文件表的大小
+static constexpr const size_t   DIR_FILES    = 300;
+/// 文件大小
+static constexpr const size_t   CONTIG_SIZE  = 1024 * 1024 + 123;
+static constexpr const size_t   FRAG_SIZE    = 600 * 1024 + 77;
+/// 损坏的文件在簇链断开之前的簇数与目录项中的簇数
+static constexpr const size_t   BROKEN_GOOD  = 16;
+static constexpr const size_t   BROKEN_TOTAL = 32;
+/// BMP 之外的字符使用代理对
+static const std::string        UNICODE_NAME = "日本語-\xF0\x9F\x98\x80.txt";
+
+/// 读请求，(起始扇区, 扇区数)
+using fake_reads_t = std::vector<std::pair<uint64_t, uint32_t>>;
+
+/**
+ * @brief 模拟的块设备
+ */
+struct fake_disk_t {
+    blk_dev_t            bdev;
+    std::vector<uint8_t> data;
+    /// 数据区的起始扇区，之后的读请求记录在 reads 中
+    uint64_t             data_start;
+    fake_reads_t         reads;
+};
+
+/**
+ * @brief 目录中的一项
+ */
+struct fake_dirent_t {
+    std::string name;
+    /// 有长文件名时的短文件名，否则为空
+    std::string alias;
+    uint32_t    cluster;
+    uint32_t    size;
+    uint8_t     attr;
+};
+
+/**
+ * @brief 构造中的卷与期望的内容
+ */
+struct fake_volume_t {
+    fake_disk_t*                                      disk;
+    uint32_t                                          bits;
+    uint64_t                                          start;
+    uint32_t                                          spc;
+    uint32_t                                          nr_clusters;
+    uint32_t                                          rsvd;
+    uint32_t                                          root_ent;
+    uint32_t                                          fat_size;
+    uint64_t                                          total;
+    /// FAT32 只写入 FAT 1，FAT 0 全为 0
+    uint32_t                                          active;
+    uint32_t                                          root_cluster;
+    /// 下一个分配的簇
+    uint32_t                                          next_free;
+    std::mt19937                                      rng;
+    /// 路径到内容与簇链
+    std::map<std::string, std::vector<uint8_t>>       files;
+    std::map<std::string, std::vector<uint32_t>>      chains;
+    /// 路径到目录中的各项，按存储的顺序
+    std::map<std::string, std::vector<fake_dirent_t>> dirs;
+};
+
+static fake_disk_t              fake_disks[DISKS];
+static fake_volume_t            fake_volumes[2];
+/// 等待宽限期的 rcu 回调
+static std::vector<rcu_head_t*> fake_rcu_heads;
+static task_t                   fake_task;
+
+DEFINE_PER_CPU(uint32_t, sched_flags);
+DEFINE_PER_CPU(uint32_t, preempt_count);
+
+void preempt_schedule(void) {
+    return;
+}
+
+task_t* current_task(void) {
+    return &fake_task;
+}
+
+void Mutex::lock_slow(void) {
+    ADD_FAILURE() << "mutex contended";
+    abort();
+}
+
+void Mutex::unlock_slow(void) {
+    ADD_FAILURE() << "mutex not owned";
+    abort();
+}
+
+void wait_prepare(wait_entry_t* _entry, const void* _key) {
+    _entry->key = _key;
+    return;
+}
+
+void wait_finish(wait_entry_t* _entry) {
+    (void)_entry;
+    return;
+}
+
+size_t wake_up_all(const void* _key) {
+    (void)_key;
+    return 0;
+}
+
+void schedule(void) {
+    // 单线程时没有其它任务能改变等待的条件
+    ADD_FAILURE() << "schedule() would sleep forever";
+    abort();
+}
+
+void call_rcu(rcu_head_t* _head, void (*_func)(rcu_head_t* _head)) {
+    _head->func = _func;
+    fake_rcu_heads.push_back(_head);
+    return;
+}
+
+workqueue_t system_unbound_wq;
+
+void work_init(work_t* _work, void (*_func)(work_t* _work)) {
+    *_work      = {};
+    _work->func = _func;
+    return;
+}
+
+void delayed_work_init(delayed_work_t* _dwork, void (*_func)(work_t* _work)) {
+    work_init(&_dwork->work, _func);
+    return;
+}
+
+bool queue_work(workqueue_t* _wq, work_t* _work) {
+    (void)_wq;
+    (void)_work;
+    return true;
+}
+
+bool queue_delayed_work(workqueue_t* _wq, delayed_work_t* _dwork,
+                        uint64_t _delay) {
+    (void)_wq;
+    (void)_dwork;
+    (void)_delay;
+    return true;
+}
+
+void blk_start_plug(blk_plug_t* _plug) {
+    (void)_plug;
+    return;
+}
+
+void blk_finish_plug(blk_plug_t* _plug) {
+    (void)_plug;
+    return;
+}
+
+void blk_flush_plug(void) {
+    return;
+}
+
+void submit_bio(bio_t* _bio) {
+    auto* disk   = static_cast<fake_disk_t*>(_bio->bdev->driver_data);
+    auto  offset = _bio->sector << SECTOR_SHIFT;
+    auto  len    = static_cast<size_t>(_bio->nr_sectors) << SECTOR_SHIFT;
+    EXPECT_EQ(_bio->op, BLK_OP_READ);
+    EXPECT_GT(_bio->nr_sectors, 0);
+    EXPECT_LE(_bio->nr_sectors, MAX_SECTORS);
+    _bio->status = BLK_STS_OK;
+    if (_bio->sector + _bio->nr_sectors > _bio->bdev->capacity) {
+        _bio->status = BLK_STS_IOERR;
+    }
+    else {
+        memcpy(_bio->buffer, disk->data.data() + offset, len);
+        if (_bio->sector >= disk->data_start) {
+            disk->reads.emplace_back(_bio->sector, _bio->nr_sectors);
+        }
+    }
+    _bio->end_io(_bio);
+    return;
+}
+
+blk_dev_t* blk_get(size_t _index) {
+    return _index < DISKS ? &fake_disks[_index].bdev : nullptr;
+}
+
+void driver_wait_init(void) {
+    return;
+}
+
+task_t* kthread_run(void (*_func)(void* _arg), void* _arg, const char* _name) {
+    (void)_name;
+    // 挂载线程在调用者中直接运行
+    _func(_arg);
+    return &fake_task;
+}
+
+static void put16(uint8_t* _ptr, uint16_t _val) {
+    memcpy(_ptr, &_val, sizeof(_val));
+    return;
+}
+
+static void put32(uint8_t* _ptr, uint32_t _val) {
+    memcpy(_ptr, &_val, sizeof(_val));
+    return;
+}
+
+static void put64(uint8_t* _ptr, uint64_t _val) {
+    memcpy(_ptr, &_val, sizeof(_val));
+    return;
+}
+
+static uint8_t* sector_ptr(fake_disk_t* _disk, uint64_t _sector) {
+    return _disk->data.data() + (_sector << SECTOR_SHIFT);
+}
+
+/**
+ * @brief 初始化设备，内容全为 0
+ * @param  _sectors                容量，扇区
+ */
+static void disk_init(fake_disk_t* _disk, const char* _name,
+                      uint64_t _sectors) {
+    _disk->data.assign(_sectors << SECTOR_SHIFT, 0);
+    _disk->bdev.name        = _name;
+    _disk->bdev.capacity    = _sectors;
+    _disk->bdev.block_size  = SECTOR_SIZE;
+    _disk->bdev.max_sectors = MAX_SECTORS;
+    _disk->bdev.driver_data = _disk;
+    return;
+}
+
+static uint32_t cluster_bytes(const fake_volume_t& _vol) {
+    return _vol.spc << SECTOR_SHIFT;
+}
+
+static uint64_t data_start(const fake_volume_t& _vol) {
+    return _vol.start + _vol.rsvd + 2ULL * _vol.fat_size
+           + _vol.root_ent * DIRENT / SECTOR_SIZE;
+}
+
+static uint64_t cluster_sector(const fake_volume_t& _vol, uint32_t _cluster) {
+    return data_start(_vol) + static_cast<uint64_t>(_cluster - 2) * _vol.spc;
+}
+
+/**
+ * @brief 计算卷的布局并初始化设备
+ * FAT16 的簇为 4 个扇区，FAT32 的簇为 1 个扇区，使一页跨多个簇
+ */
+static void volume_init(fake_volume_t& _vol, fake_disk_t* _disk,
+                        const char* _name, uint32_t _bits, uint64_t _start,
+                        uint32_t _spc, uint32_t _clusters) {
+    _vol.disk         = _disk;
+    _vol.bits         = _bits;
+    _vol.start        = _start;
+    _vol.spc          = _spc;
+    _vol.nr_clusters  = _clusters;
+    _vol.rsvd         = _bits == 32 ? 32 : 4;
+    _vol.root_ent     = _bits == 32 ? 0 : 512;
+    _vol.fat_size     = ((_clusters + 2) * (_bits / 8) + SECTOR_SIZE - 1)
+                        / SECTOR_SIZE;
+    _vol.total        = _vol.rsvd + 2ULL * _vol.fat_size
+                        + _vol.root_ent * DIRENT / SECTOR_SIZE
+                        + static_cast<uint64_t>(_clusters) * _spc;
+    _vol.active       = _bits == 32 ? 1 : 0;
+    _vol.root_cluster = 0;
+    // FAT32 的簇号跨过 16 位
+    _vol.next_free    = _bits == 32 ? 65530 : 2;
+    _vol.rng.seed(_bits);
+    disk_init(_disk, _name, _start + _vol.total);
+    _disk->data_start = data_start(_vol);
+    return;
+}
+
+/**
+ * @brief 写入 FAT 表项，FAT16 写入两份，FAT32 只写入使用中的一份
+ */
+static void fat_set(fake_volume_t& _vol, uint32_t _cluster, uint32_t _val) {
+    for (uint32_t i = 0; i < 2; i++) {
+        if ((_vol.bits == 32) && (i != _vol.active)) {
+            continue;
+        }
+        auto* fat = sector_ptr(_vol.disk,
+                               _vol.start + _vol.rsvd + i * _vol.fat_size);
+        if (_vol.bits == 32) {
+            put32(fat + _cluster * 4, _val);
+        }
+        else {
+            put16(fat + _cluster * 2, static_cast<uint16_t>(_val));
+        }
+    }
+    return;
+}
+
+static void chain_write(fake_volume_t& _vol,
+                        const std::vector<uint32_t>& _clusters) {
+    auto eoc = _vol.bits == 32 ? 0x0FFFFFFF : 0xFFFF;
+    for (size_t i = 0; i < _clusters.size(); i++) {
+        fat_set(_vol, _clusters[i],
+                i + 1 < _clusters.size() ? _clusters[i + 1] : eoc);
+    }
+    return;
+}
+
+/**
+ * @brief 分配簇并写入簇链
+ * @param  _frag                   为 true 时分为 1~3 个簇的段，
+ *                                 段之间留出空闲的簇，并打乱段的顺序
+ */
+static std::vector<uint32_t> alloc(fake_volume_t& _vol, size_t _count,
+                                   bool _frag) {
+    std::vector<std::vector<uint32_t>> runs;
+    size_t                             left = _count;
+    while (left > 0) {
+        size_t len = _frag ? std::min<size_t>(left, 1 + _vol.rng() % 3)
+                           : left;
+        runs.emplace_back();
+        for (size_t i = 0; i < len; i++) {
+            runs.back().push_back(_vol.next_free++);
+        }
+        left -= len;
+        if (_frag) {
+            _vol.next_free += 1 + _vol.rng() % 2;
+        }
+    }
+    if (_frag) {
+        std::shuffle(runs.begin(), runs.end(), _vol.rng);
+    }
+    std::vector<uint32_t> clusters;
+    for (auto& run : runs) {
+        clusters.insert(clusters.end(), run.begin(), run.end());
+    }
+    EXPECT_LE(_vol.next_free, _vol.nr_clusters + 2);
+    chain_write(_vol, clusters);
+    return clusters;
+}
+
+/**
+ * @brief 按簇链写入数据
+ */
+static void data_write(fake_volume_t& _vol,
+                       const std::vector<uint32_t>& _clusters,
+                       const std::vector<uint8_t>& _data) {
+    auto bytes = cluster_bytes(_vol);
+    for (size_t i = 0; i * bytes < _data.size(); i++) {
+        memcpy(sector_ptr(_vol.disk, cluster_sector(_vol, _clusters[i])),
+               _data.data() + i * bytes,
+               std::min<size_t>(bytes, _data.size() - i * bytes));
+    }
+    return;
+}
+
+/**
+ * @brief 添加文件，内容由路径生成
+ * @param  _path                   完整路径
+ * @param  _name                   目录项中的名称
+ * @param  _alias                  有长文件名时的短文件名
+ * @return fake_dirent_t           加入所在目录的项
+ */
+static fake_dirent_t file_add(fake_volume_t& _vol, const std::string& _path,
+                              const std::string& _name,
+                              const std::string& _alias, size_t _size,
+                              bool _frag) {
+    std::vector<uint8_t> data(_size);
+    uint64_t             seed = std::hash<std::string>()(_path) + _vol.bits;
+    for (auto& byte : data) {
+        seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+        byte = static_cast<uint8_t>(seed >> 56);
+    }
+    auto bytes    = cluster_bytes(_vol);
+    auto clusters = alloc(_vol, (_size + bytes - 1) / bytes, _frag);
+    data_write(_vol, clusters, data);
+    _vol.files[_path]  = data;
+    _vol.chains[_path] = clusters;
+    return { _name, _alias, clusters.empty() ? 0 : clusters[0],
+             static_cast<uint32_t>(_size), FAT_ATTR_ARCHIVE };
+}
+
+static uint8_t lfn_checksum(const uint8_t* _name) {
+    uint8_t sum = 0;
+    for (size_t i = 0; i < 11; i++) {
+        sum = static_cast<uint8_t>(((sum & 1) << 7) + (sum >> 1) + _name[i]);
+    }
+    return sum;
+}
+
+/**
+ * @brief UTF-8 转换为 UTF-16，BMP 之外的字符使用代理对
+ */
+static std::vector<uint16_t> utf16(const std::string& _name) {
+    std::vector<uint16_t> out;
+    for (size_t i = 0; i < _name.size();) {
+        auto     ch  = static_cast<uint8_t>(_name[i]);
+        size_t   len = ch < 0x80 ? 1 : ch < 0xE0 ? 2 : ch < 0xF0 ? 3 : 4;
+        uint32_t cp  = len == 1 ? ch : ch & (0x7F >> len);
+        for (size_t j = 1; j < len; j++) {
+            cp = (cp << 6) | (_name[i + j] & 0x3F);
+        }
+        if (cp >= 0x10000) {
+            cp -= 0x10000;
+            out.push_back(static_cast<uint16_t>(0xD800 + (cp >> 10)));
+            out.push_back(static_cast<uint16_t>(0xDC00 + (cp & 0x3FF)));
+        }
+        else {
+            out.push_back(static_cast<uint16_t>(cp));
+        }
+        i += len;
+    }
+    return out;
+}
+
+/**
+ * @brief 8.3 格式的名称字段，"." 与 ".." 按原样填充
+ * @param  _nt_res                 输出，基本名与扩展名全为小写时的标记
+ */
+static void short_field(const std::string& _name, uint8_t* _field,
+                        uint8_t* _nt_res) {
+    memset(_field, ' ', 11);
+    *_nt_res = 0;
+    if (_name[0] == '.') {
+        memcpy(_field, _name.data(), _name.size());
+        return;
+    }
+    auto dot  = _name.find('.');
+    auto base = _name.substr(0, dot);
+    auto ext  = dot == std::string::npos ? "" : _name.substr(dot + 1);
+    for (size_t i = 0; i < base.size(); i++) {
+        _field[i] = static_cast<uint8_t>(toupper(base[i]));
+    }
+    for (size_t i = 0; i < ext.size(); i++) {
+        _field[8 + i] = static_cast<uint8_t>(toupper(ext[i]));
+    }
+    auto lower = [](char _ch) { return (_ch >= 'a') && (_ch <= 'z'); };
+    if (std::any_of(base.begin(), base.end(), lower)) {
+        *_nt_res |= 0x08;
+    }
+    if (std::any_of(ext.begin(), ext.end(), lower)) {
+        *_nt_res |= 0x10;
+    }
+    return;
+}
+
+/**
+ * @brief 序列化目录项，有短文件名时前面加上倒序的长文件名项
+ */
+static std::vector<uint8_t> dir_bytes(
+    const std::vector<fake_dirent_t>& _entries) {
+    std::vector<uint8_t> out;
+    for (auto& ent : _entries) {
+        uint8_t raw[DIRENT] = {};
+        uint8_t nt_res;
+        short_field(ent.alias.empty() ? ent.name : ent.alias, raw, &nt_res);
+        if (!ent.alias.empty()) {
+            auto chars = utf16(ent.name);
+            auto count = (chars.size() + LFN_CHARS - 1) / LFN_CHARS;
+            if (chars.size() % LFN_CHARS != 0) {
+                chars.push_back(0x0000);
+            }
+            chars.resize(count * LFN_CHARS, 0xFFFF);
+            for (size_t seq = count; seq > 0; seq--) {
+                uint8_t lfn[DIRENT] = {};
+                auto*   name        = &chars[(seq - 1) * LFN_CHARS];
+                memcpy(lfn + 1, name, 10);
+                memcpy(lfn + 14, name + 5, 12);
+                memcpy(lfn + 28, name + 11, 4);
+                lfn[0]  = static_cast<uint8_t>(seq | (seq == count ? 0x40 : 0));
+                lfn[11] = ATTR_LFN;
+                lfn[13] = lfn_checksum(raw);
+                out.insert(out.end(), lfn, lfn + DIRENT);
+            }
+            nt_res = 0;
+        }
+        raw[11] = ent.attr;
+        raw[12] = nt_res;
+        put16(raw + 20, static_cast<uint16_t>(ent.cluster >> 16));
+        put16(raw + 26, static_cast<uint16_t>(ent.cluster));
+        put32(raw + 28, ent.size);
+        out.insert(out.end(), raw, raw + DIRENT);
+    }
+    return out;
+}
+
+/**
+ * @brief 目录开头的 "." 与 ".." 项，"." 的首簇在分配后填写
+ * @param  _parent                 上级目录的首簇，根目录为 0
+ */
+static std::vector<fake_dirent_t> dir_new(uint32_t _parent) {
+    return { { ".", "", 0, 0, FAT_ATTR_DIR },
+             { "..", "", _parent, 0, FAT_ATTR_DIR } };
+}
+
+/**
+ * @brief 分配目录的簇，多留一个簇，其中的项全为 0
+ */
+static std::vector<uint32_t> dir_alloc(
+    fake_volume_t& _vol, const std::vector<fake_dirent_t>& _entries) {
+    return alloc(_vol, dir_bytes(_entries).size() / cluster_bytes(_vol) + 1,
+                 true);
+}
+
+/**
+ * @brief 查找序列化后的短文件名项
+ * @param  _field                  11 字节的名称字段
+ */
+static uint8_t* dirent_find(std::vector<uint8_t>& _bytes, const char* _field) {
+    for (size_t off = 0; off < _bytes.size(); off += DIRENT) {
+        if (memcmp(_bytes.data() + off, _field, 11) == 0) {
+            return _bytes.data() + off;
+        }
+    }
+    ADD_FAILURE() << _field << " not found";
+    return nullptr;
+}
+
+/**
+ * @brief 写入引导扇区
+ */
+static void boot_write(fake_volume_t& _vol) {
+    auto* bs = sector_ptr(_vol.disk, _vol.start);
+    bs[0]    = 0xEB;
+    bs[1]    = 0x58;
+    bs[2]    = 0x90;
+    memcpy(bs + 3, "MSWIN4.1", 8);
+    put16(bs + 11, SECTOR_SIZE);
+    bs[13] = static_cast<uint8_t>(_vol.spc);
+    put16(bs + 14, static_cast<uint16_t>(_vol.rsvd));
+    bs[16] = 2;
+    put16(bs + 17, static_cast<uint16_t>(_vol.root_ent));
+    bs[21] = 0xF8;
+    if (_vol.bits == 16) {
+        put16(bs + 19, static_cast<uint16_t>(_vol.total));
+        put16(bs + 22, static_cast<uint16_t>(_vol.fat_size));
+    }
+    else {
+        put32(bs + 32, static_cast<uint32_t>(_vol.total));
+        put32(bs + 36, _vol.fat_size);
+        // 不镜像，使用 FAT 1
+        put16(bs + 40, static_cast<uint16_t>(0x80 | _vol.active));
+        put32(bs + 44, _vol.root_cluster);
+    }
+    bs[510] = 0x55;
+    bs[511] = 0xAA;
+    fat_set(_vol, 0, _vol.bits == 32 ? 0x0FFFFFF8 : 0xFFF8);
+    fat_set(_vol, 1, _vol.bits == 32 ? 0x0FFFFFFF : 0xFFFF);
+    return;
+}
+
+
+/**
+ * @brief 写入 MBR 的分区项
+ */
+static void mbr_part(fake_disk_t* _disk, size_t _index, uint8_t _type,
+                     uint32_t _start) {
+    auto* mbr  = sector_ptr(_disk, 0);
+    auto* part = mbr + 446 + _index * 16;
+    part[4]    = _type;
+    put32(part + 8, _start);
+    put32(part + 12, static_cast<uint32_t>(_disk->bdev.capacity - _start));
+    mbr[510] = 0x55;
+    mbr[511] = 0xAA;
+    return;
+}
+
+/**
+ * @brief 写入 GPT 的头部与分区项，分区项从 LBA 2 开始
+ */
+static void gpt_part(fake_disk_t* _disk, size_t _index, uint64_t _start) {
+    auto* header = sector_ptr(_disk, 1);
+    memcpy(header, "EFI PART", 8);
+    put64(header + 72, 2);
+    put32(header + 80, 128);
+    put32(header + 84, 128);
+    auto* entry = sector_ptr(_disk, 2) + _index * 128;
+    // EFI 系统分区
+    put64(entry, 0x11D2F81FC12A7328ULL);
+    put64(entry + 8, 0x3BC93EC9A0004BBAULL);
+    put64(entry + 32, _start);
+    put64(entry + 40, _disk->bdev.capacity - 1);
+    return;
+}
+
+/**
+ * @brief 写入卷的内容
+ */
+static void volume_fill(fake_volume_t& _vol) {
+    auto                       bytes = cluster_bytes(_vol);
+    std::vector<fake_dirent_t> root;
+    root.push_back({ "TESTVOL", "", 0, 0, FAT_ATTR_VOLUME });
+    root.push_back(file_add(_vol, "README.TXT", "README.TXT", "", 1000, false));
+    // 全为小写的 8.3 名称使用 NT 保留字节中的标记
+    root.push_back(
+        file_add(_vol, "contig.bin", "contig.bin", "", CONTIG_SIZE, false));
+    root.push_back(file_add(_vol, "Fragmented File.bin", "Fragmented File.bin",
+                            "FRAGME~1.BIN", FRAG_SIZE, true));
+    root.push_back(file_add(_vol, "random-order.bin", "random-order.bin",
+                            "RANDOM~1.BIN", FRAG_SIZE, true));
+    root.push_back(file_add(_vol, "EMPTY.TXT", "EMPTY.TXT", "", 0, false));
+    // BMP 之外的字符使用代理对
+    root.push_back(file_add(_vol, UNICODE_NAME, UNICODE_NAME, "___-__~1.TXT",
+                            5000, false));
+    // 簇链在 BROKEN_GOOD 个簇之后指向空闲的簇
+    auto broken = file_add(_vol, "broken.bin", "broken.bin", "",
+                           BROKEN_GOOD * bytes, false);
+    broken.size = BROKEN_TOTAL * bytes;
+    fat_set(_vol, _vol.chains["broken.bin"].back(), _vol.next_free++);
+    root.push_back(broken);
+    // 有环的簇链
+    auto loop = alloc(_vol, 2, false);
+    fat_set(_vol, loop[1], loop[0]);
+    root.push_back({ "LOOP", "", loop[0], 0, FAT_ATTR_DIR });
+
+    auto sub = dir_new(0);
+    for (size_t i = 0; i < DIR_FILES; i++) {
+        char name[16];
+        char alias[16];
+        snprintf(name, sizeof(name), "file-%03zu.dat", i);
+        snprintf(alias, sizeof(alias), "FILE~%zu.DAT", i + 1);
+        sub.push_back(file_add(_vol, std::string("Sub Dir/") + name, name,
+                               alias, 100 + i, false));
+    }
+    // 已删除的项，以及校验和与之后的短文件名不符的长文件名
+    sub.push_back({ "file-deleted.dat", "FILE~0.DAT", 0, 0, 0 });
+    sub.push_back(file_add(_vol, "Sub Dir/ORPHAN.TXT", "orphan name",
+                           "ORPHAN~1.TXT", 10, false));
+    sub.push_back({ "Nested", "NESTED", 0, 0, FAT_ATTR_DIR });
+    // 子目录的 .. 需要上级目录的首簇
+    auto sub_clusters = dir_alloc(_vol, sub);
+    auto nested       = dir_new(sub_clusters[0]);
+    nested.push_back(
+        file_add(_vol, "Sub Dir/Nested/deep.txt", "deep.txt", "", 300, false));
+    auto nested_clusters = dir_alloc(_vol, nested);
+    nested[0].cluster    = nested_clusters[0];
+    data_write(_vol, nested_clusters, dir_bytes(nested));
+    _vol.dirs["Sub Dir/Nested"] = nested;
+    sub[0].cluster              = sub_clusters[0];
+    sub.back().cluster          = nested_clusters[0];
+    auto sub_bytes              = dir_bytes(sub);
+    // 序列化之后修改短文件名与首字节
+    memcpy(dirent_find(sub_bytes, "ORPHAN~1TXT"), "ORPHAN  TXT", 11);
+    dirent_find(sub_bytes, "FILE~0  DAT")[0] = 0xE5;
+    data_write(_vol, sub_clusters, sub_bytes);
+    sub.erase(sub.end() - 3);
+    sub[sub.size() - 2].name  = "ORPHAN.TXT";
+    sub[sub.size() - 2].alias = "";
+    _vol.dirs["Sub Dir"]      = sub;
+    root.push_back({ "Sub Dir", "SUBDIR~1", sub_clusters[0], 0,
+                     FAT_ATTR_DIR });
+
+    if (_vol.bits == 32) {
+        // 根目录最后分配，不在第一个簇
+        auto clusters     = dir_alloc(_vol, root);
+        _vol.root_cluster = clusters[0];
+        data_write(_vol, clusters, dir_bytes(root));
+    }
+    else {
+        auto root_bytes = dir_bytes(root);
+        auto root_start = _vol.start + _vol.rsvd + 2ULL * _vol.fat_size;
+        memcpy(sector_ptr(_vol.disk, root_start), root_bytes.data(),
+               root_bytes.size());
+    }
+    _vol.dirs[""] = root;
+    boot_write(_vol);
+    return;
+}
+
+/**
+ * @brief 按簇链计算读取整个文件产生的请求，每页中设备上连续的扇区为一个
+ * @return fake_reads_t            排序后的请求
+ */
+static fake_reads_t expected_reads(const fake_volume_t& _vol,
+                                   const std::string& _path) {
+    fake_reads_t reads;
+    auto&        chain   = _vol.chains.at(_path);
+    auto         sectors = (_vol.files.at(_path).size() + SECTOR_SIZE - 1)
+                           >> SECTOR_SHIFT;
+    for (size_t i = 0; i < sectors; i++) {
+        auto disk = cluster_sector(_vol, chain[i / _vol.spc]) + i % _vol.spc;
+        if ((i % PCACHE_PAGE_SECTORS != 0)
+            && (reads.back().first + reads.back().second == disk)) {
+            reads.back().second++;
+        }
+        else {
+            reads.emplace_back(disk, 1);
+        }
+    }
+    std::sort(reads.begin(), reads.end());
+    return reads;
+}
+
+/**
+ * @brief 打开文件并获取大小
+ * @return int32_t                 fat_open 的返回值
+ */
+static int32_t open_size(fat_fs_t* _fs, const char* _path, uint64_t* _size) {
+    fat_file_t* file;
+    auto        status = fat_open(_fs, _path, &file);
+    if (status == FAT_OK) {
+        fat_stat_t stat;
+        fat_stat(file, &stat);
+        *_size = stat.size;
+        fat_close(file);
+    }
+    return status;
+}
+
+/**
+ * @brief 宽限期结束，执行等待的回调
+ */
+static void fake_rcu_flush(void) {
+    auto heads = std::move(fake_rcu_heads);
+    fake_rcu_heads.clear();
+    for (auto* head : heads) {
+        head->func(head);
+    }
+    return;
+}
+
+class FatTest : public ::testing::Test {
+protected:
+    /// 挂载空白设备与 FAT12 大小的卷的结果
+    static int32_t blank_status;
+    static int32_t small_status;
+    /// FAT16 与 FAT32 卷
+    fat_fs_t*      fss[2];
+
+    static void SetUpTestSuite(void) {
+        disk_init(&fake_disks[DISK_BLANK], "blank", PART_START);
+        // 整个设备是一个卷，簇数只够 FAT12
+        fake_volume_t small;
+        volume_init(small, &fake_disks[DISK_SMALL], "small", 16, 0, 1, 4000);
+        boot_write(small);
+        volume_init(fake_volumes[0], &fake_disks[DISK_FAT16], "fat16", 16,
+                    PART_START, 4, 8192);
+        volume_fill(fake_volumes[0]);
+        // 第一个分区不是 FAT
+        mbr_part(&fake_disks[DISK_FAT16], 0, 0x83, 64);
+        mbr_part(&fake_disks[DISK_FAT16], 1, 0x06, PART_START);
+        volume_init(fake_volumes[1], &fake_disks[DISK_FAT32], "fat32", 32,
+                    PART_START, 1, 100000);
+        volume_fill(fake_volumes[1]);
+        mbr_part(&fake_disks[DISK_FAT32], 0, 0xEE, 1);
+        // 第一项未使用，第二项不是 FAT
+        gpt_part(&fake_disks[DISK_FAT32], 1, 64);
+        gpt_part(&fake_disks[DISK_FAT32], 2, PART_START);
+        pcache_init();
+        fat_fs_t* fs;
+        blank_status = fat_mount(&fake_disks[DISK_BLANK].bdev, &fs);
+        small_status = fat_mount(&fake_disks[DISK_SMALL].bdev, &fs);
+        // 挂载失败时释放挂载点，启动卷是第一个有效的卷
+        fat_init();
+        return;
+    }
+
+    void SetUp(void) override {
+        // 已挂载时返回同一个文件系统
+        for (size_t i = 0; i < 2; i++) {
+            ASSERT_EQ(fat_mount(&fake_disks[DISK_FAT16 + i].bdev, &fss[i]),
+                      FAT_OK);
+        }
+        return;
+    }
+
+    void TearDown(void) override {
+        fake_rcu_flush();
+        return;
+    }
+};
+
+int32_t FatTest::blank_status;
+int32_t FatTest::small_status;
+
+TEST_F(FatTest, Mount) {
+    EXPECT_EQ(blank_status, FAT_ERR_INVAL);
+    EXPECT_EQ(small_status, FAT_ERR_INVAL);
+    EXPECT_EQ(fat_boot_volume(), fss[0]);
+    EXPECT_NE(fss[0], fss[1]);
+    // 两个卷用完了挂载点
+    fat_fs_t* fs;
+    EXPECT_EQ(fat_mount(&fake_disks[DISK_BLANK].bdev, &fs), FAT_ERR_NOMEM);
+}
+
+TEST_F(FatTest, ExtentRequests) {
+    for (size_t i = 0; i < 2; i++) {
+        auto& vol = fake_volumes[i];
+        SCOPED_TRACE(vol.bits);
+        for (auto* path : { "contig.bin", "Fragmented File.bin" }) {
+            SCOPED_TRACE(path);
+            auto&       data = vol.files[path];
+            fat_file_t* file;
+            ASSERT_EQ(fat_open(fss[i], path, &file), FAT_OK);
+            vol.disk->reads.clear();
+            std::vector<uint8_t> buf(data.size());
+            EXPECT_EQ(fat_read(file, 0, buf.data(), buf.size()), buf.size());
+            EXPECT_TRUE(buf == data);
+            // 每页只读一次，设备上连续的扇区在一个请求中
+            std::sort(vol.disk->reads.begin(), vol.disk->reads.end());
+            EXPECT_EQ(vol.disk->reads, expected_reads(vol, path));
+            fat_close(file);
+        }
+    }
+}
+
+TEST_F(FatTest, RandomOrder) {
+    std::mt19937 rng(20261018);
+    for (size_t i = 0; i < 2; i++) {
+        auto& vol = fake_volumes[i];
+        SCOPED_TRACE(vol.bits);
+        auto&       data = vol.files["random-order.bin"];
+        fat_file_t* file;
+        ASSERT_EQ(fat_open(fss[i], "random-order.bin", &file), FAT_OK);
+        vol.disk->reads.clear();
+        // extent 的数组放不下整个簇链，向前访问时从头解码
+        std::vector<size_t> pages((data.size() + PCACHE_PAGE_SIZE - 1)
+                                  / PCACHE_PAGE_SIZE);
+        for (size_t j = 0; j < pages.size(); j++) {
+            pages[j] = j;
+        }
+        std::shuffle(pages.begin(), pages.end(), rng);
+        for (auto page : pages) {
+            uint8_t buf[PCACHE_PAGE_SIZE];
+            auto    off = page * PCACHE_PAGE_SIZE;
+            auto    len = std::min(PCACHE_PAGE_SIZE, data.size() - off);
+            ASSERT_EQ(fat_read(file, off, buf, len), len);
+            EXPECT_EQ(memcmp(buf, data.data() + off, len), 0);
+        }
+        std::sort(vol.disk->reads.begin(), vol.disk->reads.end());
+        EXPECT_EQ(vol.disk->reads, expected_reads(vol, "random-order.bin"));
+        fat_close(file);
+    }
+}
+
+TEST_F(FatTest, ReadFiles) {
+    for (size_t i = 0; i < 2; i++) {
+        auto& vol = fake_volumes[i];
+        SCOPED_TRACE(vol.bits);
+        for (auto& [path, data] : vol.files) {
+            if (path == "broken.bin") {
+                continue;
+            }
+            SCOPED_TRACE(path);
+            fat_file_t* file;
+            ASSERT_EQ(fat_open(fss[i], path.c_str(), &file), FAT_OK);
+            fat_stat_t stat;
+            fat_stat(file, &stat);
+            EXPECT_EQ(stat.size, data.size());
+            EXPECT_EQ(stat.attr, FAT_ATTR_ARCHIVE);
+            // 不按页或扇区对齐的读取
+            std::vector<uint8_t> buf(data.size() + 1);
+            for (size_t off = 0; off < data.size(); off += 3001) {
+                auto len = std::min<size_t>(3001, data.size() - off);
+                ASSERT_EQ(fat_read(file, off, buf.data() + off, 3001), len);
+            }
+            EXPECT_EQ(memcmp(buf.data(), data.data(), data.size()), 0);
+            EXPECT_EQ(fat_read(file, data.size(), buf.data(), 1), 0);
+            fat_close(file);
+        }
+    }
+}
+
+TEST_F(FatTest, Lookup) {
+    for (size_t i = 0; i < 2; i++) {
+        SCOPED_TRACE(fake_volumes[i].bits);
+        auto*    fs   = fss[i];
+        uint64_t size = 0;
+        // 不区分 ASCII 大小写，短文件名与长文件名都能找到
+        EXPECT_EQ(open_size(fs, "readme.txt", &size), FAT_OK);
+        EXPECT_EQ(size, 1000);
+        EXPECT_EQ(open_size(fs, "//README.TXT/", &size), FAT_OK);
+        EXPECT_EQ(size, 1000);
+        EXPECT_EQ(open_size(fs, "FRAGME~1.BIN", &size), FAT_OK);
+        EXPECT_EQ(size, FRAG_SIZE);
+        EXPECT_EQ(open_size(fs, "fragmented FILE.bin", &size), FAT_OK);
+        EXPECT_EQ(size, FRAG_SIZE);
+        EXPECT_EQ(open_size(fs, UNICODE_NAME.c_str(), &size), FAT_OK);
+        EXPECT_EQ(size, 5000);
+        EXPECT_EQ(open_size(fs, "___-__~1.txt", &size), FAT_OK);
+        EXPECT_EQ(size, 5000);
+        EXPECT_EQ(open_size(fs, "EMPTY.TXT", &size), FAT_OK);
+        EXPECT_EQ(size, 0);
+        // . 与 ..，根目录的 .. 是根目录本身
+        EXPECT_EQ(open_size(fs, "Sub Dir/Nested/./deep.txt", &size), FAT_OK);
+        EXPECT_EQ(size, 300);
+        EXPECT_EQ(open_size(fs, "subdir~1/nested/../FILE-007.DAT", &size),
+                  FAT_OK);
+        EXPECT_EQ(size, 107);
+        EXPECT_EQ(open_size(fs, "/../Sub Dir/../README.TXT", &size), FAT_OK);
+        EXPECT_EQ(size, 1000);
+        // 校验和不符的长文件名不使用
+        EXPECT_EQ(open_size(fs, "Sub Dir/ORPHAN.TXT", &size), FAT_OK);
+        EXPECT_EQ(size, 10);
+        EXPECT_EQ(open_size(fs, "Sub Dir/orphan name", &size), FAT_ERR_NOENT);
+        EXPECT_EQ(open_size(fs, "Sub Dir/file-deleted.dat", &size),
+                  FAT_ERR_NOENT);
+        EXPECT_EQ(open_size(fs, "Sub Dir/file-300.dat", &size),
+                  FAT_ERR_NOENT);
+        EXPECT_EQ(open_size(fs, "README.TXT/x", &size), FAT_ERR_NOTDIR);
+        // 有环的簇链
+        EXPECT_EQ(open_size(fs, "LOOP", &size), FAT_ERR_IO);
+        EXPECT_EQ(open_size(fs, "LOOP/x", &size), FAT_ERR_IO);
+        fat_file_t* root;
+        ASSERT_EQ(fat_open(fs, "/", &root), FAT_OK);
+        fat_stat_t stat;
+        fat_stat(root, &stat);
+        EXPECT_EQ(stat.attr, FAT_ATTR_DIR);
+        fat_close(root);
+    }
+}
+
+TEST_F(FatTest, Readdir) {
+    for (size_t i = 0; i < 2; i++) {
+        auto& vol = fake_volumes[i];
+        SCOPED_TRACE(vol.bits);
+        for (auto& [path, ents] : vol.dirs) {
+            SCOPED_TRACE(path);
+            fat_file_t* dir;
+            ASSERT_EQ(fat_open(fss[i], path.c_str(), &dir), FAT_OK);
+            size_t       pos = 0;
+            fat_dirent_t ent;
+            for (auto& expect : ents) {
+                // 跳过卷标
+                if (expect.attr == FAT_ATTR_VOLUME) {
+                    continue;
+                }
+                ASSERT_EQ(fat_readdir(dir, &pos, &ent), FAT_OK);
+                EXPECT_EQ(ent.name, expect.name);
+                EXPECT_EQ(ent.size, expect.size);
+                EXPECT_EQ(ent.attr, expect.attr);
+                EXPECT_EQ(ent.cluster, expect.cluster);
+            }
+            EXPECT_EQ(fat_readdir(dir, &pos, &ent), FAT_ERR_NOENT);
+            fat_close(dir);
+        }
+        fat_file_t* file;
+        ASSERT_EQ(fat_open(fss[i], "README.TXT", &file), FAT_OK);
+        size_t       pos = 0;
+        fat_dirent_t ent;
+        EXPECT_EQ(fat_readdir(file, &pos, &ent), FAT_ERR_NOTDIR);
+        fat_close(file);
+    }
+}
+
+TEST_F(FatTest, ManyFiles) {
+    for (size_t i = 0; i < 2; i++) {
+        auto& vol = fake_volumes[i];
+        SCOPED_TRACE(vol.bits);
+        // 超过文件表的大小，关闭的文件被回收
+        for (size_t j = 0; j < DIR_FILES; j++) {
+            char path[32];
+            snprintf(path, sizeof(path), "Sub Dir/file-%03zu.dat", j);
+            auto&       data = vol.files[path];
+            fat_file_t* file;
+            ASSERT_EQ(fat_open(fss[i], path, &file), FAT_OK);
+            std::vector<uint8_t> buf(data.size());
+            EXPECT_EQ(fat_read(file, 0, buf.data(), buf.size()), buf.size());
+            EXPECT_TRUE(buf == data);
+            fat_close(file);
+        }
+        // 两个根目录与查找时的目录占用文件表
+        std::vector<fat_file_t*> held;
+        int32_t                  status = FAT_OK;
+        for (size_t j = 0; (j < DIR_FILES) && (status == FAT_OK); j++) {
+            char path[32];
+            snprintf(path, sizeof(path), "Sub Dir/file-%03zu.dat", j);
+            fat_file_t* file;
+            status = fat_open(fss[i], path, &file);
+            if (status == FAT_OK) {
+                held.push_back(file);
+            }
+        }
+        EXPECT_EQ(status, FAT_ERR_NOMEM);
+        EXPECT_EQ(held.size(), FAT_FILES - 3);
+        for (auto* file : held) {
+            fat_close(file);
+        }
+    }
+}
+
+TEST_F(FatTest, HashedLookup) {
+    for (size_t i = 0; i < 2; i++) {
+        SCOPED_TRACE(fake_volumes[i].bits);
+        uint64_t size;
+        ASSERT_EQ(open_size(fss[i], "Sub Dir/file-000.dat", &size), FAT_OK);
+        pcache_stats_t before;
+        pcache_get_stats(&before);
+        // 目录已经完整缓存，查找与不存在的名称都不读目录
+        for (size_t j = 0; j < DIR_FILES; j++) {
+            char path[32];
+            snprintf(path, sizeof(path), "Sub Dir/FILE~%zu.DAT", j + 1);
+            EXPECT_EQ(open_size(fss[i], path, &size), FAT_OK);
+            EXPECT_EQ(size, 100 + j);
+            snprintf(path, sizeof(path), "Sub Dir/missing-%zu", j);
+            EXPECT_EQ(open_size(fss[i], path, &size), FAT_ERR_NOENT);
+        }
+        pcache_stats_t after;
+        pcache_get_stats(&after);
+        EXPECT_EQ(after.hits + after.misses, before.hits + before.misses);
+    }
+}
+
+TEST_F(FatTest, BrokenChain) {
+    for (size_t i = 0; i < 2; i++) {
+        auto& vol = fake_volumes[i];
+        SCOPED_TRACE(vol.bits);
+        auto&       data = vol.files["broken.bin"];
+        fat_file_t* file;
+        ASSERT_EQ(fat_open(fss[i], "broken.bin", &file), FAT_OK);
+        fat_stat_t stat;
+        fat_stat(file, &stat);
+        EXPECT_EQ(stat.size, BROKEN_TOTAL * cluster_bytes(vol));
+        // 读到簇链断开的页为止
+        std::vector<uint8_t> buf(stat.size);
+        auto                 len = fat_read(file, 0, buf.data(), buf.size());
+        EXPECT_EQ(len, data.size() / PCACHE_PAGE_SIZE * PCACHE_PAGE_SIZE);
+        EXPECT_EQ(memcmp(buf.data(), data.data(), len), 0);
+        EXPECT_EQ(fat_read(file, data.size(), buf.data(), 1), 0);
+        fat_close(file);
+    }
+}
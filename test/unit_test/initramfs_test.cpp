@@ -0,0 +1,456 @@
+
+/**
+ * @file initramfs_test.cpp
+ * @brief initramfs 测试
+ * @author Zone.N (Zone.Niuzh@hotmail.com)
+ * @version 1.0
+ * @date 2026-10-18
+ * @copyright MIT LICENSE
+ * https://github.com/MRNIU/cmake-kernel
+ * @par change log:
+ * <table>
+ * <tr><th>Date<th>Author<th>Description
+ * <tr><td>2026-10-18<td>Zone.N (Zone.Niuzh@hotmail.com)<td>创建文件
+ * </table>
+ */
+
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "arch.h"
+#include "fdt.h"
+#include "initramfs.h"
+
+/**
+ * 在内存中构造 tar 归档并建立索引，检查 ustar 前缀、pax 扩展头、
+ * GNU 长文件名、链接、没有单独记录的上级目录，以及损坏的归档。
+ * 索引只能建立一次，损坏的归档在子进程中检查
+ */
+
+/// 块大小
+static constexpr const size_t   BLOCK       = 512;
+/// 头部中各字段的偏移
+static constexpr const size_t   OFF_NAME    = 0;
+static constexpr const size_t   OFF_MODE    = 100;
+static constexpr const size_t   OFF_SIZE    = 124;
+static constexpr const size_t   OFF_CHKSUM  = 148;
+static constexpr const size_t   OFF_FLAG    = 156;
+static constexpr const size_t   OFF_LINK    = 157;
+static constexpr const size_t   OFF_MAGIC   = 257;
+static constexpr const size_t   OFF_PREFIX  = 345;
+/// 超过索引容量的文件数
+static constexpr const size_t   FILES_LARGE = 4096;
+static constexpr const uint32_t MODE_FILE   = 0644;
+static constexpr const uint32_t MODE_DIR    = 0755;
+
+const void* arch_initrd(size_t* _size) {
+    *_size = 0;
+    return nullptr;
+}
+
+int32_t fdt_next_node(int32_t _node, int32_t* _depth) {
+    (void)_node;
+    (void)_depth;
+    return -1;
+}
+
+const char* fdt_node_name(int32_t _node) {
+    (void)_node;
+    return "";
+}
+
+const void* fdt_get_prop(int32_t _node, const char* _name, size_t* _len) {
+    (void)_node;
+    (void)_name;
+    *_len = 0;
+    return nullptr;
+}
+
+uint64_t fdt_cells(const void* _prop, size_t _index, uint32_t _cells) {
+    (void)_prop;
+    (void)_index;
+    (void)_cells;
+    return 0;
+}
+
+/**
+ * @brief 添加一个头部
+ * @param  _tar                    归档
+ * @param  _name                   名称字段，最多 100 字节
+ * @param  _flag                   类型标志
+ * @param  _size                   大小字段
+ * @param  _link                   链接名字段
+ * @param  _prefix                 前缀字段，只有 POSIX ustar 使用
+ * @param  _gnu                    使用 GNU 格式的魔数
+ * @param  _mode                   权限位
+ */
+static void tar_header(std::vector<uint8_t>& _tar, const std::string& _name,
+                       char _flag, size_t _size, const std::string& _link = "",
+                       const std::string& _prefix = "", bool _gnu = false,
+                       uint32_t _mode = MODE_FILE) {
+    auto  off = _tar.size();
+    _tar.resize(off + BLOCK);
+    auto* ptr = reinterpret_cast<char*>(_tar.data() + off);
+    memcpy(ptr + OFF_NAME, _name.data(), std::min<size_t>(_name.size(), 100));
+    snprintf(ptr + OFF_MODE, 8, "%07o", _mode);
+    snprintf(ptr + OFF_SIZE, 12, "%011llo",
+             static_cast<unsigned long long>(_size));
+    ptr[OFF_FLAG] = _flag;
+    memcpy(ptr + OFF_LINK, _link.data(), std::min<size_t>(_link.size(), 100));
+    memcpy(ptr + OFF_MAGIC, _gnu ? "ustar  " : "ustar\0" "00", 8);
+    memcpy(ptr + OFF_PREFIX, _prefix.data(), _prefix.size());
+    // 校验和字段按空格计算
+    memset(ptr + OFF_CHKSUM, ' ', 8);
+    uint32_t sum = 0;
+    for (size_t i = 0; i < BLOCK; i++) {
+        sum += static_cast<uint8_t>(ptr[i]);
+    }
+    snprintf(ptr + OFF_CHKSUM, 8, "%06o", sum);
+    return;
+}
+
+/**
+ * @brief 添加数据，补齐到块大小
+ */
+static void tar_data(std::vector<uint8_t>& _tar, const std::string& _data) {
+    _tar.insert(_tar.end(), _data.begin(), _data.end());
+    _tar.resize((_tar.size() + BLOCK - 1) / BLOCK * BLOCK);
+    return;
+}
+
+/**
+ * @brief 添加一项普通文件
+ */
+static void tar_file(std::vector<uint8_t>& _tar, const std::string& _name,
+                     const std::string& _data) {
+    tar_header(_tar, _name, '0', _data.size());
+    tar_data(_tar, _data);
+    return;
+}
+
+/**
+ * @brief 添加结尾的两个全 0 块
+ */
+static void tar_end(std::vector<uint8_t>& _tar) {
+    _tar.resize(_tar.size() + 2 * BLOCK);
+    return;
+}
+
+/**
+ * @brief pax 记录，长度包括长度字段本身
+ */
+static std::string pax_record(const std::string& _key,
+                              const std::string& _val) {
+    auto body = " " + _key + "=" + _val + "\n";
+    auto len  = body.size() + 1;
+    while (std::to_string(len).size() + body.size() != len) {
+        len = std::to_string(len).size() + body.size();
+    }
+    return std::to_string(len) + body;
+}
+
+/**
+ * @brief 读取整个文件
+ */
+static std::string read_all(const initramfs_file_t* _file) {
+    const void* data;
+    auto        len = initramfs_read(_file, 0, SIZE_MAX, &data);
+    return std::string(static_cast<const char*>(data), len);
+}
+
+/**
+ * @brief 目录中各项的名称，按 readdir 返回的顺序
+ */
+static std::vector<std::string> list_dir(const char* _path) {
+    const initramfs_file_t*  dir;
+    std::vector<std::string> names;
+    EXPECT_EQ(initramfs_open(_path, &dir), INITRAMFS_OK);
+    size_t             pos = 0;
+    initramfs_dirent_t ent;
+    while (initramfs_readdir(dir, &pos, &ent) == INITRAMFS_OK) {
+        names.push_back(ent.name);
+    }
+    return names;
+}
+
+/// 长路径，超过头部的名称字段
+static const std::string PAX_PATH = "opt/" + std::string(150, 'p') + "/pax";
+static const std::string GNU_PATH = "gnu/" + std::string(120, 'g');
+
+class InitramfsTest : public ::testing::Test {
+protected:
+    /// 归档，索引指向其中的数据，测试期间一直有效
+    static std::vector<uint8_t> tar;
+    static int32_t              status;
+
+    static void SetUpTestSuite(void) {
+        tar_header(tar, "etc/", '5', 0, "", "", false, MODE_DIR);
+        tar_file(tar, "etc/hostname", "kernel\n");
+        // 没有上级目录的项
+        tar_file(tar, "usr/lib/libc.so", "ELF");
+        // 全局扩展头不影响之后的项
+        auto global = pax_record("comment", "ignored");
+        tar_header(tar, "pax_global_header", 'g', global.size());
+        tar_data(tar, global);
+        // pax 的 path 与 size 替换头部中的字段
+        auto pax = pax_record("path", PAX_PATH) + pax_record("size", "5");
+        tar_header(tar, "PaxHeaders/pax", 'x', pax.size());
+        tar_data(tar, pax);
+        tar_header(tar, "short", '0', 0);
+        tar_data(tar, "12345");
+        // GNU 长文件名
+        tar_header(tar, "././@LongLink", 'L', GNU_PATH.size() + 1, "", "",
+                   true);
+        tar_data(tar, GNU_PATH + '\0');
+        tar_header(tar, GNU_PATH.substr(0, 100), '0', 3, "", "", true);
+        tar_data(tar, "gnu");
+        // ustar 前缀，与名称之间隐含 '/'
+        tar_header(tar, "file.txt", '0', 6, "", "deep/prefix");
+        tar_data(tar, "prefix");
+        tar_header(tar, "etc/link", '2', 0, "hostname", "", false, 0777);
+        tar_header(tar, "etc/hard", '1', 0, "etc/hostname");
+        // 设备文件跳过
+        tar_header(tar, "dev/console", '3', 0);
+        // 同名的项以后出现的为准，非空的目录不替换
+        tar_file(tar, "etc/motd", "old");
+        tar_file(tar, "etc/motd", "new");
+        tar_file(tar, "etc", "not a dir");
+        tar_file(tar, "./etc//./issue", "issue");
+        tar_end(tar);
+        status = initramfs_mount(tar.data(), tar.size());
+        return;
+    }
+};
+
+std::vector<uint8_t> InitramfsTest::tar;
+int32_t              InitramfsTest::status;
+
+TEST_F(InitramfsTest, Mount) {
+    EXPECT_EQ(status, INITRAMFS_OK);
+    // 只能成功一次
+    EXPECT_EQ(initramfs_mount(tar.data(), tar.size()), INITRAMFS_ERR_INVAL);
+    EXPECT_EQ(initramfs_init(), INITRAMFS_ERR_INVAL);
+}
+
+TEST_F(InitramfsTest, ReadFile) {
+    const initramfs_file_t* file;
+    ASSERT_EQ(initramfs_open("/etc/hostname", &file), INITRAMFS_OK);
+    EXPECT_EQ(read_all(file), "kernel\n");
+
+    const void* data;
+    EXPECT_EQ(initramfs_read(file, 2, 3, &data), 3);
+    EXPECT_EQ(memcmp(data, "rne", 3), 0);
+    EXPECT_EQ(initramfs_read(file, 5, 100, &data), 2);
+    EXPECT_EQ(initramfs_read(file, 7, 1, &data), 0);
+    EXPECT_EQ(data, nullptr);
+
+    // 数据直接指向归档
+    size_t size;
+    auto*  map = static_cast<const uint8_t*>(initramfs_mmap(file, &size));
+    EXPECT_EQ(size, 7);
+    EXPECT_GE(map, tar.data());
+    EXPECT_LT(map, tar.data() + tar.size());
+    EXPECT_EQ((map - tar.data()) % BLOCK, 0);
+
+    initramfs_stat_t stat;
+    initramfs_stat(file, &stat);
+    EXPECT_EQ(stat.size, 7);
+    EXPECT_EQ(stat.mode, MODE_FILE);
+    EXPECT_EQ(stat.type, INITRAMFS_TYPE_FILE);
+}
+
+TEST_F(InitramfsTest, ImplicitDirectory) {
+    const initramfs_file_t* dir;
+    ASSERT_EQ(initramfs_open("usr/lib", &dir), INITRAMFS_OK);
+    initramfs_stat_t stat;
+    initramfs_stat(dir, &stat);
+    EXPECT_EQ(stat.type, INITRAMFS_TYPE_DIR);
+    EXPECT_EQ(stat.mode, MODE_DIR);
+
+    const void* data;
+    EXPECT_EQ(initramfs_read(dir, 0, 1, &data), 0);
+    size_t size;
+    EXPECT_EQ(initramfs_mmap(dir, &size), nullptr);
+
+    const initramfs_file_t* file;
+    ASSERT_EQ(initramfs_open("usr/lib/libc.so", &file), INITRAMFS_OK);
+    EXPECT_EQ(read_all(file), "ELF");
+}
+
+TEST_F(InitramfsTest, Pax) {
+    const initramfs_file_t* file;
+    ASSERT_EQ(initramfs_open(PAX_PATH.c_str(), &file), INITRAMFS_OK);
+    EXPECT_EQ(read_all(file), "12345");
+    // 扩展头只作用于下一项
+    EXPECT_EQ(initramfs_open("short", &file), INITRAMFS_ERR_NOENT);
+    EXPECT_EQ(initramfs_open("pax_global_header", &file),
+              INITRAMFS_ERR_NOENT);
+    EXPECT_EQ(initramfs_open("PaxHeaders", &file), INITRAMFS_ERR_NOENT);
+}
+
+TEST_F(InitramfsTest, GnuLongName) {
+    const initramfs_file_t* file;
+    ASSERT_EQ(initramfs_open(GNU_PATH.c_str(), &file), INITRAMFS_OK);
+    EXPECT_EQ(read_all(file), "gnu");
+    EXPECT_EQ(initramfs_open(GNU_PATH.substr(0, 100).c_str(), &file),
+              INITRAMFS_ERR_NOENT);
+}
+
+TEST_F(InitramfsTest, UstarPrefix) {
+    const initramfs_file_t* file;
+    ASSERT_EQ(initramfs_open("deep/prefix/file.txt", &file), INITRAMFS_OK);
+    EXPECT_EQ(read_all(file), "prefix");
+}
+
+TEST_F(InitramfsTest, Links) {
+    const initramfs_file_t* link;
+    ASSERT_EQ(initramfs_open("etc/link", &link), INITRAMFS_OK);
+    initramfs_stat_t stat;
+    initramfs_stat(link, &stat);
+    EXPECT_EQ(stat.type, INITRAMFS_TYPE_SYMLINK);
+    EXPECT_EQ(stat.mode, 0777);
+    EXPECT_EQ(read_all(link), "hostname");
+    size_t size;
+    EXPECT_EQ(initramfs_mmap(link, &size), nullptr);
+
+    // 硬链接与目标共享数据
+    const initramfs_file_t* file;
+    const initramfs_file_t* hard;
+    ASSERT_EQ(initramfs_open("etc/hostname", &file), INITRAMFS_OK);
+    ASSERT_EQ(initramfs_open("etc/hard", &hard), INITRAMFS_OK);
+    EXPECT_NE(hard, file);
+    EXPECT_EQ(initramfs_mmap(hard, &size), initramfs_mmap(file, &size));
+    EXPECT_EQ(read_all(hard), "kernel\n");
+}
+
+TEST_F(InitramfsTest, Replace) {
+    const initramfs_file_t* file;
+    ASSERT_EQ(initramfs_open("etc/motd", &file), INITRAMFS_OK);
+    EXPECT_EQ(read_all(file), "new");
+    ASSERT_EQ(initramfs_open("etc", &file), INITRAMFS_OK);
+    initramfs_stat_t stat;
+    initramfs_stat(file, &stat);
+    EXPECT_EQ(stat.type, INITRAMFS_TYPE_DIR);
+    EXPECT_EQ(initramfs_open("dev", &file), INITRAMFS_ERR_NOENT);
+}
+
+TEST_F(InitramfsTest, PathWalk) {
+    const initramfs_file_t* file;
+    const initramfs_file_t* other;
+    ASSERT_EQ(initramfs_open("etc/issue", &file), INITRAMFS_OK);
+    EXPECT_EQ(read_all(file), "issue");
+    EXPECT_EQ(initramfs_open("//usr/./lib/../../etc/issue/", &other),
+              INITRAMFS_OK);
+    EXPECT_EQ(other, file);
+    EXPECT_EQ(initramfs_open("", &other), INITRAMFS_OK);
+    EXPECT_EQ(initramfs_open("..", &file), INITRAMFS_OK);
+    EXPECT_EQ(file, other);
+    EXPECT_EQ(initramfs_open("etc/hostname/x", &file), INITRAMFS_ERR_NOTDIR);
+    EXPECT_EQ(initramfs_open("etc/Hostname", &file), INITRAMFS_ERR_NOENT);
+    auto long_name = std::string(INITRAMFS_NAME_MAX + 1, 'n');
+    EXPECT_EQ(initramfs_open(long_name.c_str(), &file), INITRAMFS_ERR_NOENT);
+}
+
+TEST_F(InitramfsTest, Readdir) {
+    EXPECT_EQ(list_dir("/"),
+              (std::vector<std::string>{ "etc", "usr", "opt", "gnu", "deep" }));
+    EXPECT_EQ(list_dir("etc"),
+              (std::vector<std::string>{ "hostname", "link", "hard", "motd",
+                                         "issue" }));
+
+    const initramfs_file_t* dir;
+    ASSERT_EQ(initramfs_open("etc", &dir), INITRAMFS_OK);
+    size_t             pos = 0;
+    initramfs_dirent_t ent;
+    ASSERT_EQ(initramfs_readdir(dir, &pos, &ent), INITRAMFS_OK);
+    EXPECT_STREQ(ent.name, "hostname");
+    EXPECT_EQ(ent.size, 7);
+    EXPECT_EQ(ent.mode, MODE_FILE);
+    EXPECT_EQ(ent.type, INITRAMFS_TYPE_FILE);
+
+    const initramfs_file_t* file;
+    ASSERT_EQ(initramfs_open("etc/hostname", &file), INITRAMFS_OK);
+    pos = 0;
+    EXPECT_EQ(initramfs_readdir(file, &pos, &ent), INITRAMFS_ERR_NOTDIR);
+}
+
+/**
+ * 以下测试各自在子进程中建立索引
+ */
+
+/**
+ * @brief 在子进程中建立索引并检查结果
+ * @param  _tar                    归档
+ * @param  _status                 期望的返回值
+ * @param  _path                   索引中应有的文件，可以为 nullptr
+ */
+static void mount_child(const std::vector<uint8_t>& _tar, int32_t _status,
+                        const char* _path) {
+    ::testing::FLAGS_gtest_death_test_style = "threadsafe";
+    EXPECT_EXIT(
+      {
+          const initramfs_file_t* file;
+          auto ok = (initramfs_mount(_tar.data(), _tar.size()) == _status)
+                    && ((_path == nullptr)
+                        || (initramfs_open(_path, &file) == INITRAMFS_OK));
+          exit(ok ? 0 : 1);
+      },
+      ::testing::ExitedWithCode(0), "");
+    return;
+}
+
+TEST(InitramfsBadTest, NotTar) {
+    std::vector<uint8_t> tar(2 * BLOCK);
+    EXPECT_EQ(initramfs_mount(nullptr, 0), INITRAMFS_ERR_INVAL);
+    EXPECT_EQ(initramfs_mount(tar.data(), tar.size()), INITRAMFS_ERR_INVAL);
+    tar_file(tar, "file", "data");
+    EXPECT_EQ(initramfs_mount(tar.data() + 2 * BLOCK, BLOCK - 1),
+              INITRAMFS_ERR_INVAL);
+}
+
+TEST(InitramfsBadTest, Truncated) {
+    std::vector<uint8_t> tar;
+    tar_file(tar, "first", "data");
+    tar_file(tar, "second", std::string(BLOCK, 's'));
+    tar.resize(tar.size() - 1);
+    mount_child(tar, INITRAMFS_ERR_INVAL, "first");
+}
+
+TEST(InitramfsBadTest, Checksum) {
+    std::vector<uint8_t> tar;
+    tar_file(tar, "first", "data");
+    tar_file(tar, "second", "data");
+    tar[2 * BLOCK + OFF_NAME] = 'S';
+    tar_end(tar);
+    mount_child(tar, INITRAMFS_ERR_INVAL, "first");
+}
+
+TEST(InitramfsBadTest, BadPax) {
+    // 长度不符的记录忽略，不影响之后的项
+    std::vector<uint8_t> tar;
+    std::string          pax = "99 path=bad\n";
+    tar_header(tar, "pax", 'x', pax.size());
+    tar_data(tar, pax);
+    tar_file(tar, "good", "data");
+    tar_end(tar);
+    mount_child(tar, INITRAMFS_OK, "good");
+}
+
+TEST(InitramfsBadTest, NoEnd) {
+    // 没有结尾的全 0 块时读到归档末尾
+    std::vector<uint8_t> tar;
+    tar_file(tar, "file", "data");
+    mount_child(tar, INITRAMFS_OK, "file");
+}
+
+TEST(InitramfsBadTest, TooManyFiles) {
+    std::vector<uint8_t> tar;
+    for (size_t i = 0; i < FILES_LARGE; i++) {
+        tar_header(tar, "f" + std::to_string(i), '0', 0);
+    }
+    tar_end(tar);
+    mount_child(tar, INITRAMFS_ERR_NOMEM, "f0");
+}
@@ -0,0 +1,112 @@
+
+/**
+ * @file lock_bench.cpp
+ * @brief 自旋锁竞争微基准测试
+ * @author Zone.N (Zone.Niuzh@hotmail.com)
+ * @version 1.0
+ * @date 2026-10-18
+ * @copyright MIT LICENSE
+ * https://github.com/MRNIU/cmake-kernel
+ * @par change log:
+ * <table>
+ * <tr><th>Date<th>Author<th>Description
+ * <tr><td>2026-10-18<td>Zone.N (Zone.Niuzh@hotmail.com)<td>创建文件
+ * </table>
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+#include "spinlock.hpp"
+
+/// 最多的线程数
+static constexpr const size_t MAX_THREADS = 16;
+/// 每项测试的运行时间
+static constexpr const auto   DURATION    = std::chrono::milliseconds(500);
+/// 临界区内访问的缓存行数，模拟锁保护的数据
+static constexpr const size_t DATA_LINES  = 4;
+
+/// 锁保护的数据，每个元素占一个缓存行
+struct alignas(CACHE_LINE_SIZE) Line {
+    uint64_t val;
+};
+
+static Line data[DATA_LINES];
+
+/**
+ * @brief _threads 个线程竞争同一把锁 DURATION，
+ * 输出总吞吐量与各线程获得锁次数的最小值/最大值 (公平性)
+ * @param  _name                    锁名
+ * @param  _threads                 线程数
+ * @param  _func                    加锁执行一次临界区的函数
+ */
+template <class _F>
+static void bench(const char* _name, size_t _threads, _F&& _func) {
+    std::atomic<bool>        start(false);
+    std::atomic<bool>        stop(false);
+    std::vector<uint64_t>    counts(_threads);
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < _threads; i++) {
+        threads.emplace_back([&, i] {
+            while (!start.load(std::memory_order_acquire)) {
+                cpu_relax();
+            }
+            uint64_t done = 0;
+            while (!stop.load(std::memory_order_relaxed)) {
+                _func();
+                done++;
+            }
+            counts[i] = done;
+        });
+    }
+    start.store(true, std::memory_order_release);
+    std::this_thread::sleep_for(DURATION);
+    stop = true;
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    uint64_t total = 0;
+    for (auto count : counts) {
+        total += count;
+    }
+    auto sec = std::chrono::duration<double>(DURATION).count();
+    printf("%-12s %2zu threads %10.2f Mops/s  min %10lu  max %10lu\n", _name,
+           _threads, (double)total / sec / 1e6,
+           *std::min_element(counts.begin(), counts.end()),
+           *std::max_element(counts.begin(), counts.end()));
+    return;
+}
+
+/**
+ * @brief 临界区: 读写 DATA_LINES 个缓存行
+ */
+static void critical_section(void) {
+    for (auto& line : data) {
+        line.val++;
+    }
+    return;
+}
+
+int main(void) {
+    auto cpus = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+    printf("%zu cpus\n", cpus);
+    // 线程数超过 cpu 数时排队锁的交接需要等待调度，结果只作参考
+    for (size_t threads = 1; threads <= std::min(cpus, MAX_THREADS);
+         threads *= 2) {
+        TicketLock ticket;
+        bench("TicketLock", threads, [&] {
+            LockGuard<TicketLock> guard(ticket);
+            critical_section();
+        });
+        McsLock mcs;
+        bench("McsLock", threads, [&] {
+            LockGuard<McsLock> guard(mcs);
+            critical_section();
+        });
+    }
+    return 0;
+}
@@ -0,0 +1,211 @@
+
+/**
+ * @file lock_test.cpp
+ * @brief 自旋锁测试
+ * @author Zone.N (Zone.Niuzh@hotmail.com)
+ * @version 1.0
+ * @date 2026-10-18
+ * @copyright MIT LICENSE
+ * https://github.com/MRNIU/cmake-kernel
+ * @par change log:
+ * <table>
+ * <tr><th>Date<th>Author<th>Description
+ * <tr><td>2026-10-18<td>Zone.N (Zone.Niuzh@hotmail.com)<td>创建文件
+ * </table>
+ */
+
+#include <atomic>
+#include <chrono>
+#include <gtest/gtest.h>
+#include <thread>
+#include <vector>
+
+#include "spinlock.hpp"
+
+/// 并发测试的线程数
+static constexpr const size_t THREADS  = 4;
+/// 并发测试的运行时间，按时间而不是次数结束，
+/// 避免 cpu 少于线程数时排队锁的交接需要等待调度而运行过久
+static constexpr const auto   DURATION = std::chrono::milliseconds(200);
+
+/**
+ * @brief 启动 THREADS 个线程执行 _func(线程编号, 停止标记)，DURATION 后停止
+ * @param  _func                   线程函数
+ */
+template <class _F>
+static void run_threads(_F&& _func) {
+    std::atomic<bool>        stop(false);
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < THREADS; i++) {
+        threads.emplace_back([&, i] { _func(i, stop); });
+    }
+    std::this_thread::sleep_for(DURATION);
+    stop = true;
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    return;
+}
+
+TEST(TicketLockTest, MutualExclusion) {
+    TicketLock            lock;
+    uint64_t              counter = 0;
+    std::atomic<uint64_t> total(0);
+    run_threads([&](size_t, std::atomic<bool>& _stop) {
+        uint64_t done = 0;
+        while (!_stop.load(std::memory_order_relaxed)) {
+            LockGuard<TicketLock> guard(lock);
+            counter++;
+            done++;
+        }
+        total += done;
+    });
+    EXPECT_EQ(counter, total.load());
+    EXPECT_FALSE(lock.is_locked());
+}
+
+TEST(TicketLockTest, TryLock) {
+    TicketLock lock;
+    EXPECT_TRUE(lock.try_lock());
+    EXPECT_TRUE(lock.is_locked());
+    EXPECT_FALSE(lock.try_lock());
+    lock.unlock();
+    EXPECT_TRUE(lock.try_lock());
+    lock.unlock();
+}
+
+TEST(McsLockTest, MutualExclusion) {
+    McsLock               lock;
+    uint64_t              counter = 0;
+    std::atomic<uint64_t> total(0);
+    run_threads([&](size_t, std::atomic<bool>& _stop) {
+        uint64_t done = 0;
+        while (!_stop.load(std::memory_order_relaxed)) {
+            LockGuard<McsLock> guard(lock);
+            counter++;
+            done++;
+        }
+        total += done;
+    });
+    EXPECT_EQ(counter, total.load());
+    EXPECT_FALSE(lock.is_locked());
+}
+
+TEST(McsLockTest, TryLock) {
+    McsLock lock;
+    McsNode first;
+    McsNode second;
+    EXPECT_TRUE(lock.try_lock(first));
+    EXPECT_TRUE(lock.is_locked());
+    EXPECT_FALSE(lock.try_lock(second));
+    lock.unlock(first);
+    EXPECT_FALSE(lock.is_locked());
+    EXPECT_TRUE(lock.try_lock(second));
+    lock.unlock(second);
+}
+
+TEST(RwLockTest, ReadersShareTheLock) {
+    RwLock lock;
+    lock.read_lock();
+    // 其它读者在持有读锁时仍能进入，否则 join 不会返回
+    std::thread reader([&] {
+        lock.read_lock();
+        lock.read_unlock();
+    });
+    reader.join();
+    lock.read_unlock();
+    lock.write_lock();
+    lock.write_unlock();
+}
+
+TEST(RwLockTest, WriterExclusion) {
+    RwLock                lock;
+    std::atomic<int>      readers(0);
+    std::atomic<int>      writers(0);
+    std::atomic<uint64_t> errors(0);
+    std::atomic<uint64_t> writes(0);
+    // 写者保证 a 与 b 相等
+    uint64_t              a = 0;
+    uint64_t              b = 0;
+    run_threads([&](size_t _idx, std::atomic<bool>& _stop) {
+        // 一半写者一半读者
+        bool     writer = (_idx % 2) == 0;
+        uint64_t done   = 0;
+        while (!_stop.load(std::memory_order_relaxed)) {
+            if (writer) {
+                lock.write_lock();
+                if ((writers.fetch_add(1) != 0) || (readers.load() != 0)) {
+                    errors++;
+                }
+                a++;
+                // 延长临界区，使持有者更容易在其中被抢占
+                for (size_t i = 0; i < 64; i++) {
+                    cpu_relax();
+                }
+                b++;
+                done++;
+                writers.fetch_sub(1);
+                lock.write_unlock();
+            }
+            else {
+                lock.read_lock();
+                readers.fetch_add(1);
+                if ((writers.load() != 0) || (a != b)) {
+                    errors++;
+                }
+                readers.fetch_sub(1);
+                lock.read_unlock();
+            }
+        }
+        writes += done;
+    });
+    EXPECT_EQ(errors.load(), 0U);
+    EXPECT_EQ(a, writes.load());
+    EXPECT_EQ(b, a);
+}
+
+TEST(SeqLockTest, ReadRetriesAfterWrite) {
+    SeqLock lock;
+    auto    seq = lock.read_begin();
+    EXPECT_FALSE(lock.read_retry(seq));
+    lock.write_lock();
+    lock.write_unlock();
+    EXPECT_TRUE(lock.read_retry(seq));
+    seq = lock.read_begin();
+    EXPECT_FALSE(lock.read_retry(seq));
+}
+
+TEST(SeqLockTest, ReadersNeverAcceptTornData) {
+    SeqLock               lock;
+    std::atomic<uint64_t> torn(0);
+    // 写者保证 a 与 b 相等。读写都用 relaxed 原子操作避免数据竞争，
+    // 顺序只由 SeqLock 保证
+    uint64_t              a = 0;
+    uint64_t              b = 0;
+    run_threads([&](size_t _idx, std::atomic<bool>& _stop) {
+        uint64_t last = 0;
+        for (uint64_t i = 1; !_stop.load(std::memory_order_relaxed); i++) {
+            if (_idx == 0) {
+                lock.write_lock();
+                __atomic_store_n(&a, i, __ATOMIC_RELAXED);
+                __atomic_store_n(&b, i, __ATOMIC_RELAXED);
+                lock.write_unlock();
+                continue;
+            }
+            uint32_t seq;
+            uint64_t x;
+            uint64_t y;
+            do {
+                seq = lock.read_begin();
+                x   = __atomic_load_n(&a, __ATOMIC_RELAXED);
+                y   = __atomic_load_n(&b, __ATOMIC_RELAXED);
+            } while (lock.read_retry(seq));
+            // 只有一个写者，读到的值不会变小
+            if ((x != y) || (x < last)) {
+                torn++;
+            }
+            last = x;
+        }
+    });
+    EXPECT_EQ(torn.load(), 0U);
+}
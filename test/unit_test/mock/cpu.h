@@ -0,0 +1,73 @@
+
+/**
+ * @file cpu.h
+ * @brief 宿主机上模拟的 cpu 操作
+ * @author Zone.N (Zone.Niuzh@hotmail.com)
+ * @version 1.0
+ * @date 2026-10-18
+ * @copyright MIT LICENSE
+ * https://github.com/MRNIU/cmake-kernel
+ * @par change log:
+ * <table>
+ * <tr><th>Date<th>Author<th>Description
+ * <tr><td>2026-10-18<td>Zone.N (Zone.Niuzh@hotmail.com)<td>创建文件
+ * </table>
+ */
+
+#ifndef CMAKE_KERNEL_CPU_H
+#define CMAKE_KERNEL_CPU_H
+
+#include "cstddef"
+#include "cstdint"
+
+/**
+ * 单元测试中每个线程模拟一个 cpu，中断开关只记录在线程局部变量中，
+ * 不执行特权指令
+ */
+
+/// rflags 中断允许位
+static constexpr const uint64_t RFLAGS_IF = 1 << 9;
+
+/// 当前线程模拟的中断状态
+inline thread_local uint64_t mock_irq_flags = RFLAGS_IF;
+
+static inline void cpu_relax(void) {
+    __builtin_ia32_pause();
+    return;
+}
+
+static inline void cpu_wait_change(const uint32_t* _addr, uint32_t _old) {
+    (void)_addr;
+    (void)_old;
+    cpu_relax();
+    return;
+}
+
+static inline void cpu_irq_enable(void) {
+    mock_irq_flags = RFLAGS_IF;
+    return;
+}
+
+static inline void cpu_irq_disable(void) {
+    mock_irq_flags = 0;
+    return;
+}
+
+static inline uint64_t cpu_irq_save(void) {
+    auto flags     = mock_irq_flags;
+    mock_irq_flags = 0;
+    return flags;
+}
+
+static inline void cpu_irq_restore(uint64_t _flags) {
+    if ((_flags & RFLAGS_IF) != 0) {
+        cpu_irq_enable();
+    }
+    return;
+}
+
+static inline bool cpu_irq_enabled(void) {
+    return (mock_irq_flags & RFLAGS_IF) != 0;
+}
+
+#endif /* CMAKE_KERNEL_CPU_H */
@@ -0,0 +1,98 @@
+
+/**
+ * @file io.h
+ * @brief 宿主机上模拟的设备寄存器访问
+ * @author Zone.N (Zone.Niuzh@hotmail.com)
+ * @version 1.0
+ * @date 2026-10-18
+ * @copyright MIT LICENSE
+ * https://github.com/MRNIU/cmake-kernel
+ * @par change log:
+ * <table>
+ * <tr><th>Date<th>Author<th>Description
+ * <tr><td>2026-10-18<td>Zone.N (Zone.Niuzh@hotmail.com)<td>创建文件
+ * </table>
+ */
+
+#ifndef CMAKE_KERNEL_IO_H
+#define CMAKE_KERNEL_IO_H
+
+#include "cstddef"
+#include "cstdint"
+
+/**
+ * 设备寄存器是测试中的普通内存，与 x86_64 相同只需要编译器屏障。
+ * 写寄存器后调用 mock_mmio_write，测试以此模拟设备对门铃等寄存器的响应
+ */
+
+/// 写寄存器之后调用，为 nullptr 时不调用
+inline void (*mock_mmio_write)(volatile void* _addr, uint64_t _val) = nullptr;
+
+static inline void dma_rmb(void) {
+    __asm__ volatile("" ::: "memory");
+    return;
+}
+
+static inline void dma_wmb(void) {
+    __asm__ volatile("" ::: "memory");
+    return;
+}
+
+static inline void dma_mb(void) {
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    return;
+}
+
+template <class T>
+static inline T mock_mmio_read(const volatile void* _addr) {
+    __asm__ volatile("" ::: "memory");
+    return *static_cast<const volatile T*>(_addr);
+}
+
+template <class T>
+static inline void mock_mmio_store(volatile void* _addr, T _val) {
+    __asm__ volatile("" ::: "memory");
+    *static_cast<volatile T*>(_addr) = _val;
+    if (mock_mmio_write != nullptr) {
+        mock_mmio_write(_addr, _val);
+    }
+    return;
+}
+
+static inline uint8_t mmio_read8(const volatile void* _addr) {
+    return mock_mmio_read<uint8_t>(_addr);
+}
+
+static inline uint16_t mmio_read16(const volatile void* _addr) {
+    return mock_mmio_read<uint16_t>(_addr);
+}
+
+static inline uint32_t mmio_read32(const volatile void* _addr) {
+    return mock_mmio_read<uint32_t>(_addr);
+}
+
+static inline uint64_t mmio_read64(const volatile void* _addr) {
+    return mock_mmio_read<uint64_t>(_addr);
+}
+
+static inline void mmio_write8(volatile void* _addr, uint8_t _val) {
+    mock_mmio_store(_addr, _val);
+    return;
+}
+
+static inline void mmio_write16(volatile void* _addr, uint16_t _val) {
+    mock_mmio_store(_addr, _val);
+    return;
+}
+
+static inline void mmio_write32(volatile void* _addr, uint32_t _val) {
+    mock_mmio_store(_addr, _val);
+    return;
+}
+
+static inline void mmio_write64(volatile void* _addr, uint64_t _val) {
+    mock_mmio_store(_addr, _val);
+    return;
+}
+
+#endif /* CMAKE_KERNEL_IO_H */
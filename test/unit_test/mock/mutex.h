@@ -0,0 +1,64 @@
+
+/**
+ * @file mutex.h
+ * @brief 宿主机上模拟的睡眠锁
+ * @author Zone.N (Zone.Niuzh@hotmail.com)
+ * @version 1.0
+ * @date 2026-10-18
+ * @copyright MIT LICENSE
+ * https://github.com/MRNIU/cmake-kernel
+ * @par change log:
+ * <table>
+ * <tr><th>Date<th>Author<th>Description
+ * <tr><td>2026-10-18<td>Zone.N (Zone.Niuzh@hotmail.com)<td>创建文件
+ * </table>
+ */
+
+#ifndef CMAKE_KERNEL_MUTEX_H
+#define CMAKE_KERNEL_MUTEX_H
+
+#include "cstddef"
+#include "cstdint"
+
+#include "cpu.h"
+
+/**
+ * 内核的 sched.h 与宿主机的 <sched.h> 同名，不能加入包含路径，
+ * 驱动的头文件通过 driver.h 使用的 Mutex 在宿主机上自旋等待
+ */
+
+class Mutex {
+private:
+    bool locked;
+
+public:
+    Mutex(void) : locked(false) {
+    }
+
+    Mutex(const Mutex&)            = delete;
+    Mutex& operator=(const Mutex&) = delete;
+
+    ~Mutex(void) = default;
+
+    void lock(void) {
+        while (!try_lock()) {
+            cpu_relax();
+        }
+        return;
+    }
+
+    bool try_lock(void) {
+        return !__atomic_exchange_n(&locked, true, __ATOMIC_ACQUIRE);
+    }
+
+    void unlock(void) {
+        __atomic_store_n(&locked, false, __ATOMIC_RELEASE);
+        return;
+    }
+
+    bool is_locked(void) const {
+        return __atomic_load_n(&locked, __ATOMIC_RELAXED);
+    }
+};
+
+#endif /* CMAKE_KERNEL_MUTEX_H */
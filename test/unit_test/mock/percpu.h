@@ -0,0 +1,95 @@
+
+/**
+ * @file percpu.h
+ * @brief 宿主机上模拟的每个 cpu 的变量
+ * @author Zone.N (Zone.Niuzh@hotmail.com)
+ * @version 1.0
+ * @date 2026-10-18
+ * @copyright MIT LICENSE
+ * https://github.com/MRNIU/cmake-kernel
+ * @par change log:
+ * <table>
+ * <tr><th>Date<th>Author<th>Description
+ * <tr><td>2026-10-18<td>Zone.N (Zone.Niuzh@hotmail.com)<td>创建文件
+ * </table>
+ */
+
+#ifndef CMAKE_KERNEL_PERCPU_H
+#define CMAKE_KERNEL_PERCPU_H
+
+#include "cstddef"
+#include "cstdint"
+#include "cstdlib"
+#include "cstring"
+
+#include "cpu.h"
+
+/**
+ * 与内核相同，DEFINE_PER_CPU 定义的变量位于同一个段中作为模板，
+ * mock_percpu_init 为每个 cpu 复制一份并记录偏移。
+ * 当前 cpu 的编号保存在线程局部变量中，由测试线程在开始时设置
+ */
+
+#define DEFINE_PER_CPU(_type, _name)                                           \
+    __attribute__((section("mock_percpu"))) _type _name
+
+#define DECLARE_PER_CPU(_type, _name) extern _type _name
+
+/// 链接器生成的模板起止地址
+extern "C" char __start_mock_percpu[];
+extern "C" char __stop_mock_percpu[];
+
+/// 各 cpu 数据区相对模板的偏移
+inline uintptr_t           percpu_offsets[MAX_CPU_COUNT];
+/// 当前线程模拟的 cpu 编号
+inline thread_local size_t mock_cpu_id = 0;
+
+/**
+ * @brief 为每个 cpu 复制模板，在访问任何 percpu 变量前调用
+ */
+static inline void mock_percpu_init(void) {
+    auto size = static_cast<size_t>(__stop_mock_percpu - __start_mock_percpu);
+    // aligned_alloc 要求大小是对齐的整数倍
+    auto area_size = (size + 63) & ~static_cast<size_t>(63);
+    for (size_t i = 0; i < MAX_CPU_COUNT; i++) {
+        auto* area = static_cast<char*>(aligned_alloc(64, area_size));
+        memcpy(area, __start_mock_percpu, size);
+        percpu_offsets[i] = reinterpret_cast<uintptr_t>(area)
+                            - reinterpret_cast<uintptr_t>(__start_mock_percpu);
+    }
+    return;
+}
+
+template <class T>
+static inline T* per_cpu_ptr(T* _ptr, size_t _cpu) {
+    return reinterpret_cast<T*>(reinterpret_cast<uintptr_t>(_ptr)
+                                + percpu_offsets[_cpu]);
+}
+
+template <class T>
+static inline T* this_cpu_ptr(T* _ptr) {
+    return per_cpu_ptr(_ptr, mock_cpu_id);
+}
+
+template <class T>
+static inline T this_cpu_read(const T& _var) {
+    return *const_cast<volatile T*>(this_cpu_ptr(&_var));
+}
+
+template <class T>
+static inline void this_cpu_write(T& _var, T _val) {
+    *const_cast<volatile T*>(this_cpu_ptr(&_var)) = _val;
+    return;
+}
+
+template <class T>
+static inline void this_cpu_add(T& _var, T _val) {
+    __atomic_fetch_add(this_cpu_ptr(&_var), _val, __ATOMIC_RELAXED);
+    return;
+}
+
+static inline size_t cpu_id(void) {
+    return mock_cpu_id;
+}
+
+#endif /* CMAKE_KERNEL_PERCPU_H */
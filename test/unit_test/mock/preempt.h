@@ -0,0 +1,49 @@
+
+/**
+ * @file preempt.h
+ * @brief 宿主机上模拟的抢占控制
+ * @author Zone.N (Zone.Niuzh@hotmail.com)
+ * @version 1.0
+ * @date 2026-10-18
+ * @copyright MIT LICENSE
+ * https://github.com/MRNIU/cmake-kernel
+ * @par change log:
+ * <table>
+ * <tr><th>Date<th>Author<th>Description
+ * <tr><td>2026-10-18<td>Zone.N (Zone.Niuzh@hotmail.com)<td>创建文件
+ * </table>
+ */
+
+#ifndef CMAKE_KERNEL_PREEMPT_H
+#define CMAKE_KERNEL_PREEMPT_H
+
+#include "cstddef"
+#include "cstdint"
+
+#include "percpu.h"
+
+/**
+ * 测试线程不会被调度器抢占，只记录嵌套深度，
+ * 用于检查静止状态不会在读端临界区中报告
+ */
+
+/// 当前线程的抢占禁止计数
+inline thread_local uint32_t mock_preempt_count = 0;
+
+static inline void preempt_disable(void) {
+    mock_preempt_count++;
+    __atomic_signal_fence(__ATOMIC_SEQ_CST);
+    return;
+}
+
+static inline void preempt_enable(void) {
+    __atomic_signal_fence(__ATOMIC_SEQ_CST);
+    mock_preempt_count--;
+    return;
+}
+
+static inline bool preemptible(void) {
+    return (mock_preempt_count == 0) && cpu_irq_enabled();
+}
+
+#endif /* CMAKE_KERNEL_PREEMPT_H */
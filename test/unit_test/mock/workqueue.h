@@ -0,0 +1,41 @@
+
+/**
+ * @file workqueue.h
+ * @brief 宿主机上的工作项定义
+ * @author Zone.N (Zone.Niuzh@hotmail.com)
+ * @version 1.0
+ * @date 2026-10-18
+ * @copyright MIT LICENSE
+ * https://github.com/MRNIU/cmake-kernel
+ * @par change log:
+ * <table>
+ * <tr><th>Date<th>Author<th>Description
+ * <tr><td>2026-10-18<td>Zone.N (Zone.Niuzh@hotmail.com)<td>创建文件
+ * </table>
+ */
+
+#ifndef CMAKE_KERNEL_WORKQUEUE_H
+#define CMAKE_KERNEL_WORKQUEUE_H
+
+#include "cstddef"
+#include "cstdint"
+
+#include "intrusive_list.hpp"
+
+/**
+ * 单元测试不运行工作线程，只提供 device_t 中嵌入的 work_t，
+ * 定义与内核相同
+ */
+
+struct worker_pool_t;
+struct workqueue_t;
+
+struct work_t {
+    ListNode       node;
+    void           (*func)(work_t* _work);
+    uint32_t       flags;
+    worker_pool_t* pool;
+    workqueue_t*   wq;
+};
+
+#endif /* CMAKE_KERNEL_WORKQUEUE_H */
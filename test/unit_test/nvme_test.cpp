@@ -0,0 +1,583 @@
+
+/**
+ * @file nvme_test.cpp
+ * @brief NVMe 驱动测试
+ * @author Zone.N (Zone.Niuzh@hotmail.com)
+ * @version 1.0
+ * @date 2026-10-18
+ * @copyright MIT LICENSE
+ * https://github.com/MRNIU/cmake-kernel
+ * @par change log:
+ * <table>
+ * <tr><th>Date<th>Author<th>Description
+ * <tr><td>2026-10-18<td>Zone.N (Zone.Niuzh@hotmail.com)<td>创建文件
+ * </table>
+ */
+
+#include <gtest/gtest.h>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "blkdev.h"
+#include "io.h"
+#include "ktime.h"
+#include "pci.h"
+#include "smp.h"
+
+/**
+ * 控制器寄存器与队列都是普通内存，测试在门铃写入时模拟控制器:
+ * 处理新的提交项，按 PRP 描述的内存读写模拟的磁盘，再写入完成项。
+ * 随机的多段请求覆盖 PRP1、PRP2 与 PRP 列表，检查 PRP 符合规范、
+ * 读到的数据与写入的一致
+ */
+
+/// 控制器寄存器，与 nvme.cpp 相同
+static constexpr const size_t   REG_CAP      = 0x00;
+static constexpr const size_t   REG_CC       = 0x14;
+static constexpr const size_t   REG_CSTS     = 0x1C;
+static constexpr const size_t   REG_AQA      = 0x24;
+static constexpr const size_t   REG_ASQ      = 0x28;
+static constexpr const size_t   REG_ACQ      = 0x30;
+static constexpr const size_t   REG_DBS      = 0x1000;
+static constexpr const size_t   REG_SIZE     = 0x2000;
+static constexpr const uint32_t CC_EN        = 1;
+static constexpr const uint32_t CSTS_RDY     = 1;
+/// 命令
+static constexpr const uint8_t  ADMIN_CQ     = 0x05;
+static constexpr const uint8_t  ADMIN_SQ     = 0x01;
+static constexpr const uint8_t  ADMIN_ID     = 0x06;
+static constexpr const uint8_t  ADMIN_FEAT   = 0x09;
+static constexpr const uint8_t  CMD_FLUSH    = 0x00;
+static constexpr const uint8_t  CMD_WRITE    = 0x01;
+static constexpr const uint8_t  CMD_READ     = 0x02;
+/// 状态码
+static constexpr const uint16_t SC_INVAL_OP  = 0x01;
+static constexpr const uint16_t SC_INVAL_FLD = 0x02;
+static constexpr const uint16_t SC_LBA_RANGE = 0x80;
+
+/// 内存页
+static constexpr const size_t   PAGE         = 4096;
+/// CAP.MQES 从 0 起，队列较小以覆盖环的回绕与队列满
+static constexpr const uint64_t CAP_MQES     = 15;
+/// CAP.TO，500 毫秒为单位
+static constexpr const uint64_t CAP_TO       = 1;
+/// 模拟的 cpu 数与控制器支持的队列对数
+static constexpr const size_t   CPUS         = 4;
+static constexpr const size_t   QUEUES       = 3;
+/// 命名空间的逻辑块数，逻辑块 512 字节
+static constexpr const uint64_t DISK_BLOCKS  = 4096;
+static constexpr const uint32_t LBA_SHIFT    = 9;
+/// 请求缓冲区的页数
+static constexpr const size_t   POOL_PAGES   = 1024;
+/// 批数
+static constexpr const size_t   BATCHES      = 2000;
+
+/**
+ * @brief 提交项与完成项，与 nvme.cpp 相同
+ */
+struct fake_sqe_t {
+    uint8_t  opcode;
+    uint8_t  flags;
+    uint16_t cid;
+    uint32_t nsid;
+    uint64_t reserved;
+    uint64_t mptr;
+    uint64_t prp1;
+    uint64_t prp2;
+    uint32_t cdw10;
+    uint32_t cdw11;
+    uint32_t cdw12;
+    uint32_t cdw13;
+    uint32_t cdw14;
+    uint32_t cdw15;
+};
+static_assert(sizeof(fake_sqe_t) == 64);
+
+struct fake_cqe_t {
+    uint32_t result;
+    uint32_t reserved;
+    uint16_t sq_head;
+    uint16_t sq_id;
+    uint16_t cid;
+    uint16_t status;
+};
+static_assert(sizeof(fake_cqe_t) == 16);
+
+/**
+ * @brief 控制器一侧的队列对
+ */
+struct fake_queue_t {
+    fake_sqe_t* sq;
+    fake_cqe_t* cq;
+    uint16_t    size;
+    uint16_t    head;
+    uint16_t    tail;
+    uint16_t    phase;
+};
+
+/**
+ * @brief PRP 各种形式的计数
+ */
+struct prp_stats_t {
+    size_t one;
+    size_t two;
+    size_t list;
+    size_t errors;
+};
+
+alignas(PAGE) static uint8_t fake_regs[REG_SIZE];
+alignas(PAGE) static uint8_t pool[POOL_PAGES * PAGE];
+static fake_queue_t          fake_queues[BLK_HW_QUEUE_MAX + 1];
+static std::vector<uint8_t>  fake_disk(DISK_BLOCKS << LBA_SHIFT);
+static prp_stats_t           prp_stats;
+static blk_dev_t*            fake_bdev;
+static pci_device_t          fake_pdev;
+
+clocksource_t clocksource = {1000000000, 0, 1, 0, 1, 0};
+
+bus_t pci_bus;
+
+uint64_t clock_arch_read(void) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+size_t smp_cpu_count(void) {
+    return CPUS;
+}
+
+pci_device_t* to_pci_device(device_t* _dev) {
+    return reinterpret_cast<pci_device_t*>(_dev);
+}
+
+void pci_enable(pci_device_t* _pdev) {
+    (void)_pdev;
+    return;
+}
+
+volatile void* pci_iomap(const pci_device_t* _pdev, size_t _bar) {
+    (void)_pdev;
+    return _bar == 0 ? fake_regs : nullptr;
+}
+
+size_t pci_msix_enable(pci_device_t* _pdev, size_t _count) {
+    (void)_pdev;
+    (void)_count;
+    return 0;
+}
+
+bool pci_irq_request(pci_device_t* _pdev, size_t _index, size_t _cpu,
+                     void (*_handler)(void* _arg), void* _arg) {
+    (void)_pdev;
+    (void)_index;
+    (void)_cpu;
+    (void)_handler;
+    (void)_arg;
+    return false;
+}
+
+size_t pci_queue_cpu(size_t _queue, size_t _queues) {
+    (void)_queues;
+    return _queue;
+}
+
+bool blk_register(blk_dev_t* _bdev) {
+    fake_bdev = _bdev;
+    return true;
+}
+
+template <class T>
+static T reg_read(size_t _off) {
+    T val;
+    memcpy(&val, fake_regs + _off, sizeof(val));
+    return val;
+}
+
+template <class T>
+static void reg_write(size_t _off, T _val) {
+    memcpy(fake_regs + _off, &_val, sizeof(_val));
+    return;
+}
+
+/**
+ * @brief [_addr, _addr + _len) 是否在请求缓冲区中
+ */
+static bool in_pool(uint64_t _addr, uint64_t _len) {
+    auto base = reinterpret_cast<uintptr_t>(pool);
+    return (_addr >= base) && (_addr + _len <= base + sizeof(pool));
+}
+
+/**
+ * @brief 按规范解析 PRP1/PRP2，PRP 列表不跨页
+ * @param  _cmd                    命令
+ * @param  _bytes                  数据长度
+ * @param  _regions                输出，各段内存
+ * @return true                    PRP 有效
+ */
+static bool prp_walk(const fake_sqe_t& _cmd, uint64_t _bytes,
+                     std::vector<std::pair<uint8_t*, uint64_t>>& _regions) {
+    auto add = [&](uint64_t _addr, uint64_t _len) {
+        if (!in_pool(_addr, _len)) {
+            return false;
+        }
+        _regions.push_back({ reinterpret_cast<uint8_t*>(_addr), _len });
+        return true;
+    };
+    // PRP1 可以有页内偏移，需要按双字对齐
+    auto first = std::min<uint64_t>(PAGE - _cmd.prp1 % PAGE, _bytes);
+    if ((_cmd.prp1 % 4 != 0) || !add(_cmd.prp1, first)) {
+        return false;
+    }
+    auto rest = _bytes - first;
+    if (rest == 0) {
+        prp_stats.one++;
+        return true;
+    }
+    // 只剩一页时 PRP2 直接指向数据
+    if (rest <= PAGE) {
+        prp_stats.two++;
+        return (_cmd.prp2 % PAGE == 0) && add(_cmd.prp2, rest);
+    }
+    auto entries = (rest + PAGE - 1) / PAGE;
+    if ((_cmd.prp2 % 8 != 0)
+        || (entries > (PAGE - _cmd.prp2 % PAGE) / sizeof(uint64_t))) {
+        return false;
+    }
+    auto* list = reinterpret_cast<const uint64_t*>(_cmd.prp2);
+    for (uint64_t i = 0; i < entries; i++) {
+        auto len = std::min<uint64_t>(rest, PAGE);
+        if ((list[i] % PAGE != 0) || !add(list[i], len)) {
+            return false;
+        }
+        rest -= len;
+    }
+    prp_stats.list++;
+    return true;
+}
+
+static uint16_t fake_admin(const fake_sqe_t& _cmd, uint32_t* _result) {
+    auto qid  = _cmd.cdw10 & 0xFFFF;
+    auto size = static_cast<uint16_t>((_cmd.cdw10 >> 16) + 1);
+    switch (_cmd.opcode) {
+        case ADMIN_ID: {
+            auto* buf = reinterpret_cast<uint8_t*>(_cmd.prp1);
+            memset(buf, 0, PAGE);
+            if (_cmd.cdw10 == 0) {
+                auto nsze = DISK_BLOCKS;
+                memcpy(buf, &nsze, sizeof(nsze));
+                // 格式 0 的逻辑块大小
+                buf[128 + 2] = LBA_SHIFT;
+            }
+            return 0;
+        }
+        case ADMIN_FEAT: {
+            auto want = (_cmd.cdw11 & 0xFFFF) + 1;
+            auto got  = std::min<uint32_t>(want, QUEUES);
+            *_result  = (got - 1) << 16 | (got - 1);
+            return 0;
+        }
+        case ADMIN_CQ: {
+            if ((qid == 0) || (qid > BLK_HW_QUEUE_MAX)
+                || (size > CAP_MQES + 1)) {
+                return SC_INVAL_FLD;
+            }
+            auto& queue = fake_queues[qid];
+            queue.cq    = reinterpret_cast<fake_cqe_t*>(_cmd.prp1);
+            queue.size  = size;
+            queue.tail  = 0;
+            queue.phase = 1;
+            return 0;
+        }
+        case ADMIN_SQ: {
+            // 提交队列 n 使用完成队列 n
+            if ((qid == 0) || (qid > BLK_HW_QUEUE_MAX)
+                || (fake_queues[qid].cq == nullptr)
+                || ((_cmd.cdw11 >> 16) != qid)) {
+                return SC_INVAL_FLD;
+            }
+            fake_queues[qid].sq   = reinterpret_cast<fake_sqe_t*>(_cmd.prp1);
+            fake_queues[qid].head = 0;
+            return 0;
+        }
+        default:
+            return SC_INVAL_OP;
+    }
+}
+
+static uint16_t fake_io(const fake_sqe_t& _cmd) {
+    if (_cmd.opcode == CMD_FLUSH) {
+        return 0;
+    }
+    if ((_cmd.opcode != CMD_READ) && (_cmd.opcode != CMD_WRITE)) {
+        return SC_INVAL_OP;
+    }
+    auto slba = _cmd.cdw10 | static_cast<uint64_t>(_cmd.cdw11) << 32;
+    auto nlb  = static_cast<uint64_t>(_cmd.cdw12 & 0xFFFF) + 1;
+    if (slba + nlb > DISK_BLOCKS) {
+        return SC_LBA_RANGE;
+    }
+    std::vector<std::pair<uint8_t*, uint64_t>> regions;
+    if (!prp_walk(_cmd, nlb << LBA_SHIFT, regions)) {
+        prp_stats.errors++;
+        return SC_INVAL_FLD;
+    }
+    auto* disk = fake_disk.data() + (slba << LBA_SHIFT);
+    for (auto& [addr, len] : regions) {
+        if (_cmd.opcode == CMD_READ) {
+            memcpy(addr, disk, len);
+        }
+        else {
+            memcpy(disk, addr, len);
+        }
+        disk += len;
+    }
+    return 0;
+}
+
+/**
+ * @brief 处理队列 _qid 中到 _tail 为止的提交项
+ */
+static void fake_process(size_t _qid, uint16_t _tail) {
+    auto& queue = fake_queues[_qid];
+    ASSERT_NE(queue.sq, nullptr);
+    ASSERT_LT(_tail, queue.size);
+    while (queue.head != _tail) {
+        auto cmd        = queue.sq[queue.head];
+        queue.head      = (queue.head + 1) % queue.size;
+        uint32_t result = 0;
+        auto     sc     = _qid == 0 ? fake_admin(cmd, &result) : fake_io(cmd);
+        auto&    cqe    = queue.cq[queue.tail];
+        cqe.result      = result;
+        cqe.sq_head     = queue.head;
+        cqe.sq_id       = static_cast<uint16_t>(_qid);
+        cqe.cid         = cmd.cid;
+        // 相位最后写入
+        cqe.status      = static_cast<uint16_t>(sc << 1 | queue.phase);
+        if (++queue.tail == queue.size) {
+            queue.tail  = 0;
+            queue.phase ^= 1;
+        }
+    }
+    return;
+}
+
+static void fake_mmio(volatile void* _addr, uint64_t _val) {
+    auto off = static_cast<size_t>(static_cast<volatile uint8_t*>(_addr)
+                                   - fake_regs);
+    if (off == REG_CC) {
+        // 启用时建立管理队列，CAP.DSTRD 为 0，门铃间距 4 字节
+        if ((_val & CC_EN) != 0) {
+            auto  aqa   = reg_read<uint32_t>(REG_AQA);
+            auto& admin = fake_queues[0];
+            admin.sq    = reinterpret_cast<fake_sqe_t*>(
+              reg_read<uint64_t>(REG_ASQ));
+            admin.cq    = reinterpret_cast<fake_cqe_t*>(
+              reg_read<uint64_t>(REG_ACQ));
+            admin.size  = static_cast<uint16_t>((aqa & 0xFFF) + 1);
+            admin.head  = 0;
+            admin.tail  = 0;
+            admin.phase = 1;
+        }
+        reg_write<uint32_t>(REG_CSTS, (_val & CC_EN) != 0 ? CSTS_RDY : 0);
+    }
+    else if ((off >= REG_DBS) && ((off - REG_DBS) / 4 % 2 == 0)) {
+        fake_process((off - REG_DBS) / 8, static_cast<uint16_t>(_val));
+    }
+    return;
+}
+
+extern "C" driver_init_t __driver_init_start[];
+extern "C" driver_init_t __driver_init_end[];
+
+/**
+ * @brief 请求与期望读到的数据
+ */
+struct test_rq_t {
+    blk_request_t        rq;
+    blk_seg_t            segs[BLK_SEG_MAX];
+    /// 读请求应读到的数据
+    std::vector<uint8_t> expect;
+    bool                 done;
+};
+
+static void test_end_io(blk_request_t* _rq) {
+    auto* trq = static_cast<test_rq_t*>(_rq->private_data);
+    EXPECT_FALSE(trq->done);
+    trq->done = true;
+    return;
+}
+
+/**
+ * @brief 提交请求并轮询到全部完成
+ */
+static void submit(size_t _hwq, std::vector<test_rq_t>& _rqs) {
+    std::vector<blk_request_t*> rqs;
+    for (auto& trq : _rqs) {
+        trq.done            = false;
+        trq.rq.end_io       = test_end_io;
+        trq.rq.private_data = &trq;
+        trq.rq.status       = BLK_STS_IOERR;
+        rqs.push_back(&trq.rq);
+    }
+    auto*  ops = fake_bdev->ops;
+    size_t pos = 0;
+    size_t got = 0;
+    while (got < rqs.size()) {
+        // 队列满时先收取再继续提交
+        pos += ops->queue_rqs(fake_bdev, _hwq, rqs.data() + pos,
+                              rqs.size() - pos);
+        ops->commit(fake_bdev, _hwq);
+        got += ops->poll(fake_bdev, _hwq);
+    }
+    for (auto& trq : _rqs) {
+        EXPECT_TRUE(trq.done);
+    }
+    return;
+}
+
+class NvmeTest : public ::testing::Test {
+protected:
+    static int32_t probe;
+
+    static void SetUpTestSuite(void) {
+        reg_write<uint64_t>(REG_CAP, CAP_MQES | CAP_TO << 24);
+        mock_mmio_write = fake_mmio;
+        probe           = PROBE_ERROR;
+        for (auto* init = __driver_init_start; init < __driver_init_end;
+             init++) {
+            if (strcmp(init->driver->name, "nvme") == 0) {
+                probe = init->driver->probe(&fake_pdev.dev,
+                                            init->driver->id_table);
+            }
+        }
+        return;
+    }
+};
+
+int32_t NvmeTest::probe;
+
+TEST_F(NvmeTest, Probe) {
+    ASSERT_EQ(probe, PROBE_OK);
+    ASSERT_NE(fake_bdev, nullptr);
+    EXPECT_STREQ(fake_bdev->name, "nvme0n1");
+    EXPECT_EQ(fake_bdev->capacity, DISK_BLOCKS);
+    EXPECT_EQ(fake_bdev->block_size, 1U << LBA_SHIFT);
+    EXPECT_EQ(fake_bdev->seg_boundary, PAGE - 1);
+    // 控制器支持的队列对少于 cpu 数
+    EXPECT_EQ(fake_bdev->nr_hw_queues, QUEUES);
+    EXPECT_EQ(fake_bdev->queue_depth, CAP_MQES);
+    // 没有 MSI-X，全部轮询
+    EXPECT_EQ(fake_bdev->poll_queues, (1ULL << QUEUES) - 1);
+    EXPECT_EQ(fake_bdev->max_sectors, 32 * PAGE / SECTOR_SIZE);
+}
+
+TEST_F(NvmeTest, Fuzz) {
+    ASSERT_EQ(probe, PROBE_OK);
+    std::mt19937_64      rng(20261018);
+    std::vector<uint8_t> model(fake_disk);
+    auto                 max_sectors = fake_bdev->max_sectors;
+
+    for (size_t batch = 0; batch < BATCHES; batch++) {
+        std::vector<test_rq_t> rqs(1 + rng() % (2 * CAP_MQES));
+        // 各段在缓冲区中按页分配，段之间随机留空
+        size_t next_page = 0;
+        auto   alloc     = [&](uint64_t _bytes) {
+            next_page  += rng() % 2;
+            auto* addr  = pool + next_page * PAGE;
+            next_page  += (_bytes + PAGE - 1) / PAGE;
+            return addr;
+        };
+        for (auto& trq : rqs) {
+            auto& rq      = trq.rq;
+            rq            = {};
+            rq.op         = rng() % 2 == 0 ? BLK_OP_READ : BLK_OP_WRITE;
+            rq.nr_sectors = 1 + rng() % max_sectors;
+            rq.sector     = rng() % (DISK_BLOCKS - rq.nr_sectors + 1);
+            // 第一段可以从页内任意扇区开始，段与段相接处按页对齐
+            uint64_t off  = (rng() % (PAGE / SECTOR_SIZE)) * SECTOR_SIZE;
+            uint64_t rest = static_cast<uint64_t>(rq.nr_sectors)
+                            << SECTOR_SHIFT;
+            uint32_t nr   = 0;
+            while (rest > 0) {
+                auto len = rest;
+                if ((nr + 1 < BLK_SEG_MAX) && (rng() % 2 == 0)) {
+                    auto pages = 1 + rng() % ((off + rest + PAGE - 1) / PAGE);
+                    len        = std::min(pages * PAGE - off, rest);
+                }
+                auto* addr     = alloc(off + len) + off;
+                trq.segs[nr++] = { addr, static_cast<uint32_t>(len) };
+                rest           -= len;
+                off            = 0;
+            }
+            ASSERT_LE(next_page, POOL_PAGES);
+            // 只有一段时也可能使用 buffer
+            if ((nr == 1) && (rng() % 2 == 0)) {
+                rq.buffer = trq.segs[0].buffer;
+            }
+            else {
+                rq.segs    = trq.segs;
+                rq.nr_segs = nr;
+            }
+            // 按提交顺序更新模型，控制器按同样的顺序处理
+            auto* disk = model.data() + (rq.sector << SECTOR_SHIFT);
+            for (uint32_t i = 0; i < nr; i++) {
+                auto* buf = static_cast<uint8_t*>(trq.segs[i].buffer);
+                auto  len = trq.segs[i].len;
+                if (rq.op == BLK_OP_WRITE) {
+                    // 每 8 字节取一个随机数太慢，用线性同余填充
+                    auto seed = rng();
+                    for (uint32_t j = 0; j < len; j += sizeof(seed)) {
+                        seed = seed * 6364136223846793005ULL + 1;
+                        memcpy(buf + j, &seed, sizeof(seed));
+                    }
+                    memcpy(disk, buf, len);
+                }
+                else {
+                    memset(buf, 0, len);
+                    trq.expect.insert(trq.expect.end(), disk, disk + len);
+                }
+                disk += len;
+            }
+        }
+        submit(rng() % fake_bdev->nr_hw_queues, rqs);
+        for (auto& trq : rqs) {
+            ASSERT_EQ(trq.rq.status, BLK_STS_OK);
+            if (trq.rq.op != BLK_OP_READ) {
+                continue;
+            }
+            std::vector<uint8_t> got;
+            for (uint32_t i = 0; i < blk_rq_nr_segs(&trq.rq); i++) {
+                auto  seg = blk_rq_seg(&trq.rq, i);
+                auto* buf = static_cast<uint8_t*>(seg.buffer);
+                got.insert(got.end(), buf, buf + seg.len);
+            }
+            ASSERT_EQ(got, trq.expect);
+        }
+    }
+    EXPECT_EQ(fake_disk, model);
+    EXPECT_EQ(prp_stats.errors, 0);
+    // 覆盖 PRP 的三种形式
+    EXPECT_GT(prp_stats.one, 0);
+    EXPECT_GT(prp_stats.two, 0);
+    EXPECT_GT(prp_stats.list, 0);
+}
+
+TEST_F(NvmeTest, Status) {
+    ASSERT_EQ(probe, PROBE_OK);
+    std::vector<test_rq_t> rqs(2);
+    rqs[0].rq            = {};
+    rqs[0].rq.op         = BLK_OP_FLUSH;
+    // 超出命名空间的请求由控制器拒绝
+    rqs[1].rq            = {};
+    rqs[1].rq.op         = BLK_OP_READ;
+    rqs[1].rq.sector     = DISK_BLOCKS - 1;
+    rqs[1].rq.nr_sectors = 2;
+    rqs[1].rq.buffer     = pool;
+    submit(0, rqs);
+    EXPECT_EQ(rqs[0].rq.status, BLK_STS_OK);
+    EXPECT_EQ(rqs[1].rq.status, BLK_STS_IOERR);
+}
@@ -0,0 +1,490 @@
+
+/**
+ * @file pagecache_test.cpp
+ * @brief 页缓存测试
+ * @author Zone.N (Zone.Niuzh@hotmail.com)
+ * @version 1.0
+ * @date 2026-10-18
+ * @copyright MIT LICENSE
+ * https://github.com/MRNIU/cmake-kernel
+ * @par change log:
+ * <table>
+ * <tr><th>Date<th>Author<th>Description
+ * <tr><td>2026-10-18<td>Zone.N (Zone.Niuzh@hotmail.com)<td>创建文件
+ * </table>
+ */
+
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <numeric>
+#include <random>
+#include <vector>
+
+#include "bio.h"
+#include "mutex.h"
+#include "pagecache.h"
+#include "rcu.h"
+#include "sched.h"
+#include "wait.h"
+#include "workqueue.h"
+
+/**
+ * 块设备是普通内存，bio 在提交时同步完成。测试是单线程的，
+ * 等待的条件在调用时已经成立，rcu 回调在每次操作之后执行。
+ * 检查读写的数据与设备一致、CLOCK-Pro 的计数守恒，
+ * 热的工作集在大于缓存的顺序扫描之后仍然命中，
+ * 循环访问略大于缓存的页时仍有命中，以及预读与写回的计数
+ */
+
+/// 与 pagecache.cpp 相同
+static constexpr const size_t   COLD_MIN    = PCACHE_PAGES / 64;
+static constexpr const uint32_t RA_MAX      = 32;
+static constexpr const size_t   DIRTY_LIMIT = PCACHE_PAGES / 4;
+/// 模拟的设备大小，页
+static constexpr const size_t   DISK_PAGES  = 8 * PCACHE_PAGES;
+static constexpr const uint64_t DISK_SIZE   = DISK_PAGES * PCACHE_PAGE_SIZE;
+/// 单个 bio 的最大扇区数
+static constexpr const uint32_t MAX_SECTORS = 64;
+/// 测试同时使用的文件数
+static constexpr const size_t   MAPPINGS    = 4;
+/// 工作集的页数，占缓存的一半
+static constexpr const size_t   HOT_PAGES   = PCACHE_PAGES / 2;
+/// 循环访问的页数，比缓存多 1/4，与循环的轮数
+static constexpr const size_t   LOOP_PAGES  = PCACHE_PAGES * 5 / 4;
+static constexpr const size_t   LOOP_ROUNDS = 10;
+/// 预读测试的文件页数
+static constexpr const size_t   RA_PAGES    = 16 * RA_MAX;
+
+/**
+ * @brief 模拟的文件，从设备上的 base 扇区开始连续存放
+ */
+struct fake_file_t {
+    pcache_mapping_t mapping;
+    uint64_t         base;
+};
+
+static std::vector<uint8_t>     fake_disk(DISK_SIZE);
+static blk_dev_t                fake_bdev;
+/// 读写失败的扇区
+static uint64_t                 fake_bad_sector = UINT64_MAX;
+/// 提交的 bio 数
+static uint64_t                 fake_bios;
+/// 后台写回被唤醒的次数
+static uint64_t                 fake_wb_kicks;
+/// 等待宽限期的 rcu 回调
+static std::vector<rcu_head_t*> fake_rcu_heads;
+static task_t                   fake_task;
+static fake_file_t              fake_files[MAPPINGS];
+
+DEFINE_PER_CPU(uint32_t, sched_flags);
+DEFINE_PER_CPU(uint32_t, preempt_count);
+
+void preempt_schedule(void) {
+    return;
+}
+
+task_t* current_task(void) {
+    return &fake_task;
+}
+
+void Mutex::lock_slow(void) {
+    ADD_FAILURE() << "mutex contended";
+    abort();
+}
+
+void Mutex::unlock_slow(void) {
+    ADD_FAILURE() << "mutex not owned";
+    abort();
+}
+
+void wait_prepare(wait_entry_t* _entry, const void* _key) {
+    _entry->key = _key;
+    return;
+}
+
+void wait_finish(wait_entry_t* _entry) {
+    (void)_entry;
+    return;
+}
+
+size_t wake_up_all(const void* _key) {
+    (void)_key;
+    return 0;
+}
+
+void schedule(void) {
+    // 单线程时没有其它任务能改变等待的条件
+    ADD_FAILURE() << "schedule() would sleep forever";
+    abort();
+}
+
+void call_rcu(rcu_head_t* _head, void (*_func)(rcu_head_t* _head)) {
+    _head->func = _func;
+    fake_rcu_heads.push_back(_head);
+    return;
+}
+
+/**
+ * @brief 宽限期结束，执行等待的回调
+ */
+static void fake_rcu_flush(void) {
+    auto heads = std::move(fake_rcu_heads);
+    fake_rcu_heads.clear();
+    for (auto* head : heads) {
+        head->func(head);
+    }
+    return;
+}
+
+workqueue_t system_unbound_wq;
+
+void work_init(work_t* _work, void (*_func)(work_t* _work)) {
+    *_work      = {};
+    _work->func = _func;
+    return;
+}
+
+void delayed_work_init(delayed_work_t* _dwork, void (*_func)(work_t* _work)) {
+    work_init(&_dwork->work, _func);
+    return;
+}
+
+bool queue_work(workqueue_t* _wq, work_t* _work) {
+    (void)_wq;
+    (void)_work;
+    fake_wb_kicks++;
+    return true;
+}
+
+bool queue_delayed_work(workqueue_t* _wq, delayed_work_t* _dwork,
+                        uint64_t _delay) {
+    (void)_wq;
+    (void)_dwork;
+    (void)_delay;
+    return true;
+}
+
+void blk_start_plug(blk_plug_t* _plug) {
+    (void)_plug;
+    return;
+}
+
+void blk_finish_plug(blk_plug_t* _plug) {
+    (void)_plug;
+    return;
+}
+
+void blk_flush_plug(void) {
+    return;
+}
+
+void submit_bio(bio_t* _bio) {
+    auto offset  = _bio->sector << SECTOR_SHIFT;
+    auto len     = static_cast<size_t>(_bio->nr_sectors) << SECTOR_SHIFT;
+    fake_bios++;
+    EXPECT_EQ(_bio->bdev, &fake_bdev);
+    EXPECT_GT(_bio->nr_sectors, 0);
+    EXPECT_LE(_bio->nr_sectors, MAX_SECTORS);
+    _bio->status = BLK_STS_OK;
+    if ((_bio->sector + _bio->nr_sectors > fake_bdev.capacity)
+        || ((fake_bad_sector >= _bio->sector)
+            && (fake_bad_sector < _bio->sector + _bio->nr_sectors))) {
+        _bio->status = BLK_STS_IOERR;
+    }
+    else if (_bio->op == BLK_OP_READ) {
+        memcpy(_bio->buffer, fake_disk.data() + offset, len);
+    }
+    else {
+        memcpy(fake_disk.data() + offset, _bio->buffer, len);
+    }
+    _bio->end_io(_bio);
+    return;
+}
+
+/**
+ * @brief 文件内的扇区加上文件的起始扇区，整个文件在设备上连续
+ */
+static int32_t fake_map(pcache_mapping_t* _mapping, uint64_t _sector,
+                        uint64_t* _disk, uint32_t* _count) {
+    auto* file = reinterpret_cast<fake_file_t*>(_mapping);
+    *_disk     = file->base + _sector;
+    *_count    = UINT32_MAX;
+    return BLK_STS_OK;
+}
+
+static const pcache_mapping_ops_t fake_ops = { fake_map };
+
+static pcache_stats_t stats_now(void) {
+    pcache_stats_t stats;
+    pcache_get_stats(&stats);
+    return stats;
+}
+
+/**
+ * @brief 驻留页、空闲页与非驻留页的计数守恒
+ */
+static void expect_consistent(void) {
+    auto stats = stats_now();
+    EXPECT_EQ(stats.nr_hot + stats.nr_cold + stats.nr_free, PCACHE_PAGES);
+    EXPECT_LE(stats.nr_ghost, PCACHE_PAGES);
+    EXPECT_GE(stats.cold_target, COLD_MIN);
+    EXPECT_LE(stats.cold_target, PCACHE_PAGES - COLD_MIN);
+    return;
+}
+
+class PageCacheTest : public ::testing::Test {
+protected:
+    static void SetUpTestSuite(void) {
+        // 每个 8 字节不同，错位的读写都能发现
+        uint64_t seed = 20261018;
+        for (size_t i = 0; i < DISK_SIZE; i += sizeof(seed)) {
+            seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+            memcpy(fake_disk.data() + i, &seed, sizeof(seed));
+        }
+        fake_bdev.name        = "fake";
+        fake_bdev.capacity    = DISK_SIZE >> SECTOR_SHIFT;
+        fake_bdev.block_size  = SECTOR_SIZE;
+        fake_bdev.max_sectors = MAX_SECTORS;
+        pcache_init();
+        return;
+    }
+
+    void TearDown(void) override {
+        for (size_t i = 0; i < nr_files; i++) {
+            EXPECT_EQ(pcache_mapping_destroy(&fake_files[i].mapping),
+                      BLK_STS_OK);
+        }
+        fake_rcu_flush();
+        // 全部文件销毁后没有驻留页与非驻留页
+        auto stats = stats_now();
+        EXPECT_EQ(stats.nr_free, PCACHE_PAGES);
+        EXPECT_EQ(stats.nr_ghost, 0);
+        EXPECT_EQ(stats.nr_dirty, 0);
+        fake_bad_sector = UINT64_MAX;
+        return;
+    }
+
+    /**
+     * @brief 打开文件
+     * @param  _base_page              在设备上的起始页
+     * @param  _size                   文件大小，字节
+     */
+    pcache_mapping_t* file_open(size_t _base_page, uint64_t _size) {
+        auto* file = &fake_files[nr_files++];
+        file->base = _base_page * PCACHE_PAGE_SECTORS;
+        pcache_mapping_init(&file->mapping, &fake_bdev, &fake_ops, _size);
+        return &file->mapping;
+    }
+
+    /**
+     * @brief 读取并与设备比较
+     */
+    static void read_check(pcache_mapping_t* _mapping, uint64_t _offset,
+                           size_t _len) {
+        auto*    file   = reinterpret_cast<fake_file_t*>(_mapping);
+        uint64_t expect = 0;
+        if (_offset < _mapping->size) {
+            expect = std::min<uint64_t>(_len, _mapping->size - _offset);
+        }
+        std::vector<uint8_t> buf(_len);
+        ASSERT_EQ(pcache_read(_mapping, _offset, buf.data(), _len), expect);
+        ASSERT_EQ(memcmp(buf.data(),
+                         fake_disk.data() + (file->base << SECTOR_SHIFT)
+                           + _offset,
+                         expect),
+                  0);
+        fake_rcu_flush();
+        return;
+    }
+
+    /**
+     * @brief 读取一页，返回是否命中
+     */
+    static bool touch(pcache_mapping_t* _mapping, uint64_t _index) {
+        auto  before = stats_now().hits;
+        auto* page   = pcache_read_page(_mapping, _index);
+        EXPECT_NE(page, nullptr);
+        if (page != nullptr) {
+            page_put(page);
+        }
+        fake_rcu_flush();
+        return stats_now().hits != before;
+    }
+
+    size_t nr_files = 0;
+};
+
+TEST_F(PageCacheTest, ReadMatchesDevice) {
+    // 文件是缓存的 3 倍，结尾不满一页
+    auto*           mapping = file_open(0, 3 * PCACHE_PAGES * PCACHE_PAGE_SIZE
+                                             + 100);
+    std::mt19937_64 rng(20261018);
+    for (size_t i = 0; i < 20000; i++) {
+        auto offset = rng() % (mapping->size + PCACHE_PAGE_SIZE);
+        auto len    = 1 + rng() % (3 * PCACHE_PAGE_SIZE);
+        read_check(mapping, offset, len);
+        if (i % 1000 == 0) {
+            expect_consistent();
+        }
+    }
+    expect_consistent();
+    EXPECT_GT(stats_now().evictions, 0);
+}
+
+TEST_F(PageCacheTest, ScanResistant) {
+    // 工作集访问两轮，第二轮在测试期内
+    auto*               hot  = file_open(0, HOT_PAGES * PCACHE_PAGE_SIZE);
+    auto*               scan = file_open(HOT_PAGES,
+                                         4 * PCACHE_PAGES * PCACHE_PAGE_SIZE);
+    std::mt19937_64     rng(20261018);
+    std::vector<size_t> order(HOT_PAGES);
+    std::iota(order.begin(), order.end(), 0);
+    for (size_t round = 0; round < 2; round++) {
+        std::shuffle(order.begin(), order.end(), rng);
+        for (auto index : order) {
+            touch(hot, index);
+        }
+    }
+    // 一次性的顺序扫描，是缓存的 4 倍
+    for (uint64_t off = 0; off < scan->size; off += PCACHE_PAGE_SIZE) {
+        read_check(scan, off, PCACHE_PAGE_SIZE);
+    }
+    expect_consistent();
+    std::shuffle(order.begin(), order.end(), rng);
+    size_t misses = 0;
+    for (auto index : order) {
+        misses += touch(hot, index) ? 0 : 1;
+    }
+    // LRU 与 CLOCK 在这里全部未命中
+    EXPECT_LT(misses, HOT_PAGES / 20);
+    EXPECT_GT(stats_now().promotions, 0);
+}
+
+TEST_F(PageCacheTest, LoopLargerThanCache) {
+    // 每轮顺序相同，LRU 与 CLOCK 全部未命中
+    auto*               mapping = file_open(0, LOOP_PAGES * PCACHE_PAGE_SIZE);
+    std::mt19937_64     rng(20261018);
+    std::vector<size_t> order(LOOP_PAGES);
+    std::iota(order.begin(), order.end(), 0);
+    std::shuffle(order.begin(), order.end(), rng);
+    auto   before = stats_now();
+    size_t hits   = 0;
+    for (size_t round = 0; round < LOOP_ROUNDS; round++) {
+        hits = 0;
+        for (auto index : order) {
+            hits += touch(mapping, index) ? 1 : 0;
+        }
+    }
+    expect_consistent();
+    auto after = stats_now();
+    // 非驻留页被再次读入，增大冷页的目标数量，
+    // 热页保留下来，最后一轮至少一半命中
+    EXPECT_GT(after.refaults, before.refaults);
+    EXPECT_GT(hits, LOOP_PAGES / 2);
+}
+
+TEST_F(PageCacheTest, Readahead) {
+    auto* mapping = file_open(0, RA_PAGES * PCACHE_PAGE_SIZE);
+    auto  before  = stats_now();
+    auto  bios    = fake_bios;
+    // 顺序读取只有第一页同步读入，之后的页都由预读提前读入
+    for (size_t index = 0; index < RA_PAGES; index++) {
+        read_check(mapping, index * PCACHE_PAGE_SIZE, PCACHE_PAGE_SIZE);
+    }
+    auto after = stats_now();
+    EXPECT_EQ(after.misses - before.misses, 1);
+    EXPECT_EQ(after.ra_pages - before.ra_pages, RA_PAGES - 1);
+    EXPECT_EQ(after.ra_hits - before.ra_hits, RA_PAGES - 1);
+    EXPECT_EQ(after.ra_wasted, before.ra_wasted);
+    EXPECT_GT(after.ra_async, before.ra_async);
+    EXPECT_EQ(fake_bios - bios, RA_PAGES);
+
+    // 随机读取不预读
+    auto*           random = file_open(RA_PAGES, RA_PAGES * PCACHE_PAGE_SIZE);
+    std::mt19937_64 rng(20261018);
+    before = stats_now();
+    for (size_t i = 0; i < RA_PAGES; i++) {
+        auto index = 1 + rng() % (RA_PAGES - 1);
+        read_check(random, index * PCACHE_PAGE_SIZE, 1);
+    }
+    after = stats_now();
+    EXPECT_EQ(after.ra_pages, before.ra_pages);
+}
+
+TEST_F(PageCacheTest, WritebackClusters) {
+    auto*               mapping = file_open(0, DIRTY_LIMIT * PCACHE_PAGE_SIZE);
+    auto*               file    = reinterpret_cast<fake_file_t*>(mapping);
+    auto*               disk    = fake_disk.data()
+                                  + (file->base << SECTOR_SHIFT);
+    // 两段文件内连续的页乱序写入，另有一页只写一部分
+    std::vector<size_t> order;
+    for (size_t index = 0; index < 64; index++) {
+        order.push_back(index);
+    }
+    for (size_t index = 100; index < 132; index++) {
+        order.push_back(index);
+    }
+    std::mt19937_64 rng(20261018);
+    std::shuffle(order.begin(), order.end(), rng);
+    std::vector<uint8_t> expect(disk, disk + mapping->size);
+    std::vector<uint8_t> buf(PCACHE_PAGE_SIZE);
+    for (auto index : order) {
+        for (auto& byte : buf) {
+            byte = static_cast<uint8_t>(rng());
+        }
+        auto off = index * PCACHE_PAGE_SIZE;
+        ASSERT_EQ(pcache_write(mapping, off, buf.data(), buf.size()),
+                  buf.size());
+        memcpy(expect.data() + off, buf.data(), buf.size());
+    }
+    uint64_t off = 200 * PCACHE_PAGE_SIZE + 1000;
+    ASSERT_EQ(pcache_write(mapping, off, buf.data(), 100), 100);
+    memcpy(expect.data() + off, buf.data(), 100);
+    fake_rcu_flush();
+    EXPECT_EQ(stats_now().nr_dirty, order.size() + 1);
+    // 写回前设备不变，缓存中是新的数据
+    EXPECT_NE(memcmp(disk, expect.data(), mapping->size), 0);
+    std::vector<uint8_t> out(mapping->size);
+    ASSERT_EQ(pcache_read(mapping, 0, out.data(), out.size()), out.size());
+    EXPECT_EQ(out, expect);
+
+    auto before = stats_now();
+    ASSERT_EQ(pcache_writeback(mapping), BLK_STS_OK);
+    auto after = stats_now();
+    EXPECT_EQ(memcmp(disk, expect.data(), mapping->size), 0);
+    EXPECT_EQ(after.nr_dirty, 0);
+    EXPECT_EQ(after.wb_pages - before.wb_pages, order.size() + 1);
+    EXPECT_EQ(after.wb_clusters - before.wb_clusters, 3);
+    // 没有脏页时不再写回
+    ASSERT_EQ(pcache_writeback(mapping), BLK_STS_OK);
+    EXPECT_EQ(stats_now().wb_pages, after.wb_pages);
+
+    // 脏页达到上限时唤醒后台写回
+    auto kicks = fake_wb_kicks;
+    for (size_t index = 0; index < DIRTY_LIMIT; index++) {
+        ASSERT_EQ(pcache_write(mapping, index * PCACHE_PAGE_SIZE, buf.data(),
+                               buf.size()),
+                  buf.size());
+        EXPECT_EQ(fake_wb_kicks, kicks + (index + 1 == DIRTY_LIMIT ? 1 : 0));
+    }
+    fake_rcu_flush();
+}
+
+TEST_F(PageCacheTest, ReadError) {
+    auto* mapping = file_open(0, 64 * PCACHE_PAGE_SIZE);
+    auto* file    = reinterpret_cast<fake_file_t*>(mapping);
+    // 第 10 页的一个扇区读取失败，读到它之前为止
+    fake_bad_sector = file->base + 10 * PCACHE_PAGE_SECTORS + 3;
+    std::vector<uint8_t> buf(mapping->size);
+    auto                 before = stats_now();
+    EXPECT_EQ(pcache_read(mapping, 0, buf.data(), buf.size()),
+              10 * PCACHE_PAGE_SIZE);
+    EXPECT_GT(stats_now().io_errors, before.io_errors);
+    fake_rcu_flush();
+    // 设备恢复后失败的页重新读入
+    fake_bad_sector = UINT64_MAX;
+    read_check(mapping, 0, mapping->size);
+    expect_consistent();
+}
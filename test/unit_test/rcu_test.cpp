@@ -0,0 +1,358 @@
+
+/**
+ * @file rcu_test.cpp
+ * @brief rcu 压力测试
+ * @author Zone.N (Zone.Niuzh@hotmail.com)
+ * @version 1.0
+ * @date 2026-10-18
+ * @copyright MIT LICENSE
+ * https://github.com/MRNIU/cmake-kernel
+ * @par change log:
+ * <table>
+ * <tr><th>Date<th>Author<th>Description
+ * <tr><td>2026-10-18<td>Zone.N (Zone.Niuzh@hotmail.com)<td>创建文件
+ * </table>
+ */
+
+#include <atomic>
+#include <chrono>
+#include <gtest/gtest.h>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "percpu.h"
+#include "rcu.h"
+
+/**
+ * 一个更新者不断替换全局指针，旧对象通过 call_rcu 或 synchronize_rcu
+ * 延迟"释放"(标记为已释放)。读者在读端临界区中多次检查读到的对象，
+ * 如果宽限期提前结束，读者会看到已释放的对象
+ */
+
+/// 读者数，加上更新者不超过 MAX_CPU_COUNT
+static constexpr const size_t READERS         = 4;
+/// 运行时间
+static constexpr const auto   DURATION        = std::chrono::milliseconds(500);
+
+struct torture_obj_t {
+    rcu_head_t rcu;
+    uint64_t   seq;
+    bool       freed;
+};
+
+static torture_obj_t*        torture_ptr = nullptr;
+static std::atomic<uint64_t> torture_freed(0);
+
+static void torture_free(rcu_head_t* _head) {
+    auto* obj = reinterpret_cast<torture_obj_t*>(_head);
+    __atomic_store_n(&obj->freed, true, __ATOMIC_RELAXED);
+    torture_freed++;
+    return;
+}
+
+/**
+ * @brief 读者，编号为 _cpu
+ */
+static void torture_reader(size_t _cpu, std::atomic<bool>& _stop,
+                           std::atomic<uint64_t>& _errors,
+                           std::atomic<uint64_t>& _reads) {
+    mock_cpu_id = _cpu;
+    rcu_cpu_online();
+    uint64_t last  = 0;
+    uint64_t reads = 0;
+    while (!_stop.load(std::memory_order_relaxed)) {
+        rcu_read_lock();
+        auto* obj = rcu_dereference(torture_ptr);
+        if (obj != nullptr) {
+            // 线程让出宿主机 cpu 相当于模拟的 cpu 停顿，读端临界区中允许
+            if ((reads % 16) == 0) {
+                std::this_thread::yield();
+            }
+            for (size_t i = 0; i < 16; i++) {
+                if (__atomic_load_n(&obj->freed, __ATOMIC_RELAXED)) {
+                    _errors++;
+                    break;
+                }
+                cpu_relax();
+            }
+            // 更新按顺序发布，读到的序号不会变小
+            if (obj->seq < last) {
+                _errors++;
+            }
+            last = obj->seq;
+        }
+        rcu_read_unlock();
+        rcu_quiescent_state();
+        // 偶尔进入空闲，空闲的 cpu 不阻塞宽限期
+        if ((++reads % 256) == 0) {
+            rcu_idle_enter();
+            std::this_thread::yield();
+            rcu_idle_exit();
+        }
+    }
+    _reads += reads;
+    return;
+}
+
+TEST(RcuTest, Torture) {
+    mock_percpu_init();
+    rcu_init();
+
+    std::atomic<bool>        stop(false);
+    std::atomic<uint64_t>    errors(0);
+    std::atomic<uint64_t>    reads(0);
+    std::vector<std::thread> readers;
+    for (size_t i = 0; i < READERS; i++) {
+        readers.emplace_back(torture_reader, i + 1, std::ref(stop),
+                             std::ref(errors), std::ref(reads));
+    }
+
+    // 对象不复用，测试结束后统一释放
+    std::vector<torture_obj_t*> objs;
+    auto                        deadline
+        = std::chrono::steady_clock::now() + DURATION;
+    uint64_t                    syncs = 0;
+    for (uint64_t seq = 0; std::chrono::steady_clock::now() < deadline;
+         seq++) {
+        auto* obj  = new torture_obj_t;
+        obj->seq   = seq;
+        obj->freed = false;
+        objs.push_back(obj);
+        auto* old = torture_ptr;
+        rcu_assign_pointer(torture_ptr, obj);
+        if (old == nullptr) {
+            continue;
+        }
+        // 两种方式都要覆盖
+        if ((seq % 16) == 0) {
+            synchronize_rcu();
+            torture_free(&old->rcu);
+            syncs++;
+        }
+        else {
+            call_rcu(&old->rcu, torture_free);
+        }
+        rcu_quiescent_state();
+    }
+
+    // 等待所有回调执行，读者需要继续报告静止状态
+    rcu_assign_pointer(torture_ptr, static_cast<torture_obj_t*>(nullptr));
+    synchronize_rcu();
+    while (torture_freed.load() != objs.size() - 1) {
+        rcu_quiescent_state();
+        std::this_thread::yield();
+    }
+    stop = true;
+    for (auto& reader : readers) {
+        reader.join();
+    }
+
+    EXPECT_EQ(errors.load(), 0U);
+    EXPECT_GT(syncs, 0U);
+    EXPECT_GT(reads.load(), 0U);
+    RecordProperty("updates", static_cast<int>(objs.size()));
+    RecordProperty("reads", static_cast<int>(reads.load()));
+    for (auto* obj : objs) {
+        delete obj;
+    }
+}
+
+/**
+ * 多个更新者各自绑定一个 cpu，轮流替换 STRESS_SLOTS 个共享指针，
+ * 同一指针的更新者之间用锁互斥。旧对象交给 call_rcu，每个回调只能执行一次。
+ * 读者在读端临界区中持有全部指针，让出 cpu 后再检查它们没有被释放
+ */
+
+/// 共享指针数
+static constexpr const size_t STRESS_SLOTS    = 4;
+/// 读者与更新者数，加上主线程不超过 MAX_CPU_COUNT
+static constexpr const size_t STRESS_READERS  = 3;
+static constexpr const size_t STRESS_UPDATERS = 4;
+/// 每个更新者最多创建的对象数，对象在测试结束前不释放
+static constexpr const size_t STRESS_OBJS_MAX = 1 << 16;
+
+struct stress_obj_t {
+    rcu_head_t rcu;
+    /// 回调执行的次数
+    uint32_t   freed;
+};
+
+static stress_obj_t*         stress_slots[STRESS_SLOTS];
+static std::mutex            stress_locks[STRESS_SLOTS];
+/// 每个 cpu 上已执行的回调数，回调在提交它的 cpu 上执行
+static std::atomic<uint64_t> stress_freed[MAX_CPU_COUNT];
+
+static void stress_free(rcu_head_t* _head) {
+    auto* obj = reinterpret_cast<stress_obj_t*>(_head);
+    __atomic_fetch_add(&obj->freed, 1, __ATOMIC_RELAXED);
+    stress_freed[mock_cpu_id]++;
+    return;
+}
+
+/**
+ * @brief 替换 _slot 中的对象，旧对象交给 call_rcu
+ * @param  _slot                   指针下标
+ * @param  _obj                    新对象，可以为 nullptr
+ * @return true                    提交了回调
+ * @return false                   原来为空
+ */
+static bool stress_replace(size_t _slot, stress_obj_t* _obj) {
+    stress_obj_t* old;
+    {
+        std::lock_guard<std::mutex> guard(stress_locks[_slot]);
+        old = stress_slots[_slot];
+        rcu_assign_pointer(stress_slots[_slot], _obj);
+    }
+    if (old == nullptr) {
+        return false;
+    }
+    call_rcu(&old->rcu, stress_free);
+    return true;
+}
+
+/**
+ * @brief 报告静止状态，直到本 cpu 提交的 _posted 个回调全部执行
+ */
+static void stress_drain(uint64_t _posted) {
+    while (stress_freed[mock_cpu_id].load() != _posted) {
+        rcu_quiescent_state();
+        std::this_thread::yield();
+    }
+    return;
+}
+
+static void stress_reader(size_t _cpu, std::atomic<bool>& _stop,
+                          std::atomic<uint64_t>& _errors,
+                          std::atomic<uint64_t>& _reads) {
+    mock_cpu_id = _cpu;
+    rcu_cpu_online();
+    uint64_t reads = 0;
+    while (!_stop.load(std::memory_order_relaxed)) {
+        rcu_read_lock();
+        stress_obj_t* objs[STRESS_SLOTS];
+        for (size_t i = 0; i < STRESS_SLOTS; i++) {
+            objs[i] = rcu_dereference(stress_slots[i]);
+        }
+        if ((++reads % 16) == 0) {
+            std::this_thread::yield();
+        }
+        for (auto* obj : objs) {
+            if ((obj != nullptr)
+                && (__atomic_load_n(&obj->freed, __ATOMIC_RELAXED) != 0)) {
+                _errors++;
+            }
+        }
+        rcu_read_unlock();
+        rcu_quiescent_state();
+    }
+    rcu_idle_enter();
+    _reads += reads;
+    return;
+}
+
+/**
+ * @brief 更新者，编号为 _idx
+ * @param  _burst                  每批连续替换的次数，批之间报告一次静止状态
+ * @param  _sync                   是否每 8 批调用一次 synchronize_rcu
+ */
+static void stress_updater(size_t _idx, size_t _burst, bool _sync,
+                           std::atomic<bool>&          _stop,
+                           std::vector<stress_obj_t*>& _objs) {
+    mock_cpu_id = STRESS_READERS + _idx;
+    rcu_cpu_online();
+    uint64_t posted = 0;
+    for (size_t batch = 0; !_stop.load(std::memory_order_relaxed)
+                           && (_objs.size() + _burst <= STRESS_OBJS_MAX);
+         batch++) {
+        for (size_t i = 0; i < _burst; i++) {
+            auto* obj  = new stress_obj_t;
+            obj->freed = 0;
+            _objs.push_back(obj);
+            posted += stress_replace((batch + i + _idx) % STRESS_SLOTS, obj);
+        }
+        if (_sync && ((batch % 8) == 0)) {
+            synchronize_rcu();
+        }
+        rcu_quiescent_state();
+    }
+    // 退出前执行完本 cpu 的回调，之后不再阻塞宽限期
+    stress_drain(posted);
+    rcu_idle_enter();
+    return;
+}
+
+/**
+ * @brief 运行读者与 STRESS_UPDATERS 个更新者 DURATION，检查读者没有
+ * 看到已释放的对象，且每个回调恰好执行一次
+ */
+static void stress_run(size_t _burst, bool _sync) {
+    mock_percpu_init();
+    rcu_init();
+    for (auto& freed : stress_freed) {
+        freed = 0;
+    }
+
+    std::atomic<bool>                       stop_readers(false);
+    std::atomic<bool>                       stop_updaters(false);
+    std::atomic<uint64_t>                   errors(0);
+    std::atomic<uint64_t>                   reads(0);
+    std::vector<std::vector<stress_obj_t*>> objs(STRESS_UPDATERS + 1);
+    std::vector<std::thread>                readers;
+    std::vector<std::thread>                updaters;
+    for (size_t i = 0; i < STRESS_READERS; i++) {
+        readers.emplace_back(stress_reader, i + 1, std::ref(stop_readers),
+                             std::ref(errors), std::ref(reads));
+    }
+    for (size_t i = 1; i <= STRESS_UPDATERS; i++) {
+        updaters.emplace_back(stress_updater, i, _burst, _sync,
+                              std::ref(stop_updaters), std::ref(objs[i]));
+    }
+    // 主线程等待期间不阻塞宽限期
+    rcu_idle_enter();
+    std::this_thread::sleep_for(DURATION);
+    stop_updaters = true;
+    for (auto& updater : updaters) {
+        updater.join();
+    }
+    rcu_idle_exit();
+
+    // 清空共享指针，剩余对象的回调在主线程 (0 号 cpu) 上执行
+    uint64_t posted = 0;
+    for (size_t i = 0; i < STRESS_SLOTS; i++) {
+        posted += stress_replace(i, nullptr);
+    }
+    stress_drain(posted);
+    stop_readers = true;
+    for (auto& reader : readers) {
+        reader.join();
+    }
+
+    EXPECT_EQ(errors.load(), 0U);
+    EXPECT_GT(reads.load(), 0U);
+    size_t   total = 0;
+    uint64_t freed = 0;
+    for (auto& list : objs) {
+        for (auto* obj : list) {
+            EXPECT_EQ(obj->freed, 1U);
+            delete obj;
+        }
+        total += list.size();
+    }
+    for (auto& count : stress_freed) {
+        freed += count.load();
+    }
+    EXPECT_EQ(freed, total);
+    ::testing::Test::RecordProperty("updates", static_cast<int>(total));
+    ::testing::Test::RecordProperty("reads", static_cast<int>(reads.load()));
+    return;
+}
+
+TEST(RcuTest, MultipleUpdaters) {
+    stress_run(1, true);
+}
+
+TEST(RcuTest, CallbackFlood) {
+    // 每批提交大量回调，只靠 call_rcu 推进，不调用 synchronize_rcu
+    stress_run(1024, false);
+}
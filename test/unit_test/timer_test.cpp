@@ -0,0 +1,208 @@
+
+/**
+ * @file timer_test.cpp
+ * @brief 定时器随机测试
+ * @author Zone.N (Zone.Niuzh@hotmail.com)
+ * @version 1.0
+ * @date 2026-10-18
+ * @copyright MIT LICENSE
+ * https://github.com/MRNIU/cmake-kernel
+ * @par change log:
+ * <table>
+ * <tr><th>Date<th>Author<th>Description
+ * <tr><td>2026-10-18<td>Zone.N (Zone.Niuzh@hotmail.com)<td>创建文件
+ * </table>
+ */
+
+#include <gtest/gtest.h>
+#include <random>
+#include <vector>
+
+#include "cpu.h"
+#include "interrupt.h"
+#include "ktime.h"
+#include "timer.h"
+
+/**
+ * 计数器与时钟中断由测试模拟: 计数器单位为纳秒，时间只在测试推进时变化，
+ * 推进到设置的中断时间时直接调用时钟中断处理。随机添加、取消与推进时间，
+ * 检查定时器不会提前执行，也不会被遗漏
+ */
+
+/// 定时器数
+static constexpr const size_t   TIMERS       = 1024;
+/// 操作数
+static constexpr const size_t   OPERATIONS   = 100000;
+/// 到期时间最多 2^44 纳秒后，约 5 小时，覆盖时间轮的前 5 层
+static constexpr const uint64_t SPAN_BITS    = 44;
+/// 每次推进最多 2^28 纳秒
+static constexpr const uint64_t ADVANCE_BITS = 28;
+/// 周期定时器的最小周期，2^24 纳秒
+static constexpr const uint64_t PERIOD_MIN   = 1ULL << 24;
+/// 时间单位，与 timer.cpp 相同
+static constexpr const uint64_t UNIT         = 1ULL << 14;
+/// 允许的最大延迟: 到期时间向上取整到时间单位
+static constexpr const uint64_t MAX_LATE     = UNIT;
+
+clocksource_t clocksource = {1000000000, 0, 1, 0, 1, 0};
+
+/// 模拟的计数器
+static uint64_t            fake_now     = 0;
+/// 设置的中断时间，UINT64_MAX 表示未设置
+static uint64_t            fake_event   = UINT64_MAX;
+/// 时钟中断处理
+static interrupt_handler_t fake_handler = nullptr;
+
+uint64_t clock_arch_read(void) {
+    return fake_now;
+}
+
+void clock_arch_set_event(uint64_t _deadline) {
+    fake_event = _deadline;
+    return;
+}
+
+void clock_arch_stop_event(void) {
+    fake_event = UINT64_MAX;
+    return;
+}
+
+void clock_arch_ack(void) {
+    // 中断已产生，需要重新设置
+    fake_event = UINT64_MAX;
+    return;
+}
+
+bool register_interrupt_handler(size_t              _no,
+                                interrupt_handler_t _handler) {
+    (void)_no;
+    fake_handler = _handler;
+    return true;
+}
+
+struct test_timer_t {
+    ktimer_t timer;
+    /// 添加时的到期时间
+    uint64_t expires;
+    /// 是否已添加且尚未执行
+    bool     armed;
+    /// 执行时重新添加的间隔，为 0 时不重新添加
+    uint64_t period;
+};
+
+static test_timer_t test_timers[TIMERS];
+static uint64_t     early = 0;
+static uint64_t     late  = 0;
+static uint64_t     fired = 0;
+
+static void test_timer_func(ktimer_t* _timer) {
+    auto* timer = reinterpret_cast<test_timer_t*>(_timer);
+    if (!timer->armed || (fake_now < timer->expires)) {
+        early++;
+    }
+    else if (fake_now - timer->expires > MAX_LATE) {
+        late++;
+    }
+    timer->armed = false;
+    fired++;
+    // 回调中重新添加，覆盖时钟中断处理中添加的路径
+    if (timer->period != 0) {
+        timer->expires = fake_now + timer->period;
+        timer->armed   = true;
+        timer_add(_timer, timer->expires);
+    }
+    return;
+}
+
+/**
+ * @brief 推进时间到 _target，途中到达设置的中断时间时执行时钟中断
+ */
+static void advance(uint64_t _target) {
+    while (fake_event <= _target) {
+        if (fake_event > fake_now) {
+            fake_now = fake_event;
+        }
+        fake_handler(INTERRUPT_TIMER, nullptr);
+    }
+    fake_now = _target;
+    return;
+}
+
+/**
+ * @brief 随机的时间跨度
+ * @param  _rng                    随机数发生器
+ * @param  _max_bits               跨度不超过 2^_max_bits 纳秒
+ * @return uint64_t                纳秒
+ */
+static uint64_t random_span(std::mt19937_64& _rng, uint64_t _max_bits) {
+    auto bits = 8 + _rng() % (_max_bits - 7);
+    return _rng() & ((1ULL << bits) - 1);
+}
+
+TEST(TimerTest, Fuzz) {
+    timers_init();
+    timer_cpu_init();
+    for (auto& timer : test_timers) {
+        timer_init(&timer.timer, test_timer_func);
+        timer.armed = false;
+    }
+
+    std::mt19937_64 rng(20261018);
+    for (size_t i = 0; i < OPERATIONS; i++) {
+        auto& timer = test_timers[rng() % TIMERS];
+        auto  op    = rng() % 4;
+        if (op < 2) {
+            // 覆盖时间轮的各层
+            timer.expires = fake_now + random_span(rng, SPAN_BITS);
+            // 周期不能太短，否则推进时间时执行次数过多
+            timer.period  = (rng() % 8) == 0
+                              ? PERIOD_MIN + random_span(rng, ADVANCE_BITS)
+                              : 0;
+            timer.armed   = true;
+            timer_add(&timer.timer, timer.expires);
+            EXPECT_TRUE(cpu_irq_enabled());
+        }
+        else if (op == 2) {
+            EXPECT_EQ(timer_del(&timer.timer), timer.armed);
+            timer.armed = false;
+        }
+        else {
+            advance(fake_now + random_span(rng, ADVANCE_BITS));
+        }
+        ASSERT_EQ(timer_pending(&timer.timer), timer.armed);
+
+        // 下一次处理的时间不晚于最早的到期时间
+        if ((i % 64) == 0) {
+            uint64_t first = UINT64_MAX;
+            for (auto& t : test_timers) {
+                if (t.armed && (t.expires < first)) {
+                    first = t.expires;
+                }
+            }
+            if (first == UINT64_MAX) {
+                EXPECT_EQ(timer_next_event(), UINT64_MAX);
+            }
+            else {
+                EXPECT_LE(timer_next_event(), first + UNIT);
+            }
+        }
+    }
+
+    // 停止周期定时器，推进到所有定时器都应已执行
+    uint64_t last = fake_now;
+    for (auto& timer : test_timers) {
+        timer.period = 0;
+        if (timer.armed && (timer.expires > last)) {
+            last = timer.expires;
+        }
+    }
+    advance(last + MAX_LATE);
+    for (auto& timer : test_timers) {
+        EXPECT_FALSE(timer.armed);
+        EXPECT_FALSE(timer_pending(&timer.timer));
+    }
+    EXPECT_EQ(fake_event, UINT64_MAX);
+    EXPECT_EQ(early, 0);
+    EXPECT_EQ(late, 0);
+    EXPECT_GT(fired, 0);
+}
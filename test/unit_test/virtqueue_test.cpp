@@ -0,0 +1,402 @@
+
+/**
+ * @file virtqueue_test.cpp
+ * @brief 虚拟队列测试
+ * @author Zone.N (Zone.Niuzh@hotmail.com)
+ * @version 1.0
+ * @date 2026-10-18
+ * @copyright MIT LICENSE
+ * https://github.com/MRNIU/cmake-kernel
+ * @par change log:
+ * <table>
+ * <tr><th>Date<th>Author<th>Description
+ * <tr><td>2026-10-18<td>Zone.N (Zone.Niuzh@hotmail.com)<td>创建文件
+ * </table>
+ */
+
+#include <gtest/gtest.h>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "virtio.h"
+
+/**
+ * 队列内存与 virtio 寄存器都是普通内存，测试模拟设备：
+ * 从 avail 环取出描述符链，按任意顺序完成并写入 used 环。
+ * 随机放入与收取，检查空闲链表的计数、描述符链的内容与 token，
+ * 以及全部完成后空闲链表恢复完整
+ */
+
+/// 通用配置中的寄存器，与 virtio.cpp 相同
+static constexpr const uint32_t COMMON_Q_SIZE = 24;
+/// 模拟设备的队列大小，小于 VIRTQ_SIZE_MAX 以覆盖环的回绕
+static constexpr const uint16_t QUEUE_SIZE    = 16;
+/// 操作数
+static constexpr const size_t   OPERATIONS    = 200000;
+/// 中断向量
+static constexpr const uint16_t VECTOR        = 1;
+
+uint8_t pci_read8(const pci_device_t* _pdev, uint32_t _offset) {
+    (void)_pdev;
+    (void)_offset;
+    return 0;
+}
+
+uint32_t pci_read32(const pci_device_t* _pdev, uint32_t _offset) {
+    (void)_pdev;
+    (void)_offset;
+    return 0;
+}
+
+uint8_t pci_find_capability(const pci_device_t* _pdev, uint8_t _id,
+                            uint8_t _start) {
+    (void)_pdev;
+    (void)_id;
+    (void)_start;
+    return 0;
+}
+
+volatile void* pci_iomap(const pci_device_t* _pdev, size_t _bar) {
+    (void)_pdev;
+    (void)_bar;
+    return nullptr;
+}
+
+/**
+ * @brief 模拟的设备
+ */
+class FakeDevice {
+public:
+    virtio_device_t       vdev = {};
+    virtqueue_t*          vq   = nullptr;
+    /// 已从 avail 环取出、尚未完成的描述符链的头
+    std::vector<uint16_t> pending;
+
+    /**
+     * @brief 创建队列
+     * @param  _size                   设备支持的队列大小
+     * @param  _event_idx              是否协商 EVENT_IDX
+     */
+    FakeDevice(uint16_t _size, bool _event_idx) {
+        vdev.common            = common;
+        vdev.notify            = reinterpret_cast<uint8_t*>(notify);
+        vdev.notify_multiplier = 0;
+        vdev.features          = _event_idx ? (1ULL << VIRTIO_F_EVENT_IDX) : 0;
+        memcpy(common + COMMON_Q_SIZE, &_size, sizeof(_size));
+        vq = virtqueue_create(&vdev, 0, VECTOR);
+        in_use.assign(vq == nullptr ? 0 : vq->size, false);
+    }
+
+    /**
+     * @brief 取出 avail 环中的新项，检查描述符链不与其它未完成的链重叠
+     */
+    void poll(void) {
+        while (avail_seen != vq->avail->idx) {
+            auto head = vq->avail->ring[avail_seen % vq->size];
+            ASSERT_LT(head, vq->size);
+            for (auto idx = head;; idx = vq->desc[idx].next) {
+                ASSERT_LT(idx, vq->size);
+                ASSERT_FALSE(in_use[idx]);
+                in_use[idx] = true;
+                if ((vq->desc[idx].flags & VIRTQ_DESC_F_NEXT) == 0) {
+                    break;
+                }
+            }
+            pending.push_back(head);
+            avail_seen++;
+        }
+        return;
+    }
+
+    /**
+     * @brief 完成 pending 中的第 _which 项，写入的字节数为设备写的缓冲区的总长
+     */
+    void complete(size_t _which) {
+        auto     head    = pending[_which];
+        uint32_t written = 0;
+        for (auto idx = head;; idx = vq->desc[idx].next) {
+            in_use[idx] = false;
+            if ((vq->desc[idx].flags & VIRTQ_DESC_F_WRITE) != 0) {
+                written += vq->desc[idx].len;
+            }
+            if ((vq->desc[idx].flags & VIRTQ_DESC_F_NEXT) == 0) {
+                break;
+            }
+        }
+        pending.erase(pending.begin() + _which);
+        auto& elem = vq->used->ring[vq->used->idx % vq->size];
+        elem.id    = head;
+        elem.len   = written;
+        vq->used->idx++;
+        return;
+    }
+
+    /**
+     * @brief 设置 avail_event，紧接在 used 环之后
+     */
+    void set_avail_event(uint16_t _event) {
+        memcpy(&vq->used->ring[vq->size], &_event, sizeof(_event));
+        return;
+    }
+
+    /**
+     * @brief used_event，紧接在 avail 环之后
+     */
+    uint16_t used_event(void) {
+        return vq->avail->ring[vq->size];
+    }
+
+    uint16_t notified(void) {
+        return notify[0];
+    }
+
+private:
+    alignas(8) uint8_t common[64] = {};
+    uint16_t           notify[4]  = {};
+    std::vector<bool>  in_use;
+    uint16_t           avail_seen = 0;
+};
+
+/**
+ * @brief 一个已放入的描述符链
+ */
+struct request_t {
+    std::vector<virtio_buf_t> bufs;
+    size_t                    out;
+    uint32_t                  in_len;
+};
+
+/**
+ * @brief 空闲链表中不重复的描述符数
+ */
+static size_t free_list_len(const virtqueue_t* _vq) {
+    std::vector<bool> seen(_vq->size, false);
+    size_t            len = 0;
+    auto              idx = _vq->free_head;
+    for (size_t i = 0; i < _vq->num_free; i++) {
+        if ((idx >= _vq->size) || seen[idx]) {
+            break;
+        }
+        seen[idx] = true;
+        len++;
+        idx = _vq->desc[idx].next;
+    }
+    return len;
+}
+
+TEST(VirtqueueTest, Create) {
+    FakeDevice dev(QUEUE_SIZE, false);
+    ASSERT_NE(dev.vq, nullptr);
+    EXPECT_EQ(dev.vq->size, QUEUE_SIZE);
+    EXPECT_EQ(dev.vq->num_free, QUEUE_SIZE);
+    EXPECT_EQ(free_list_len(dev.vq), QUEUE_SIZE);
+    // 设备支持的更大时使用 VIRTQ_SIZE_MAX
+    FakeDevice large(VIRTQ_SIZE_MAX * 2, false);
+    ASSERT_NE(large.vq, nullptr);
+    EXPECT_EQ(large.vq->size, VIRTQ_SIZE_MAX);
+    EXPECT_EQ(free_list_len(large.vq), VIRTQ_SIZE_MAX);
+    FakeDevice none(0, false);
+    EXPECT_EQ(none.vq, nullptr);
+}
+
+TEST(VirtqueueTest, AddGetBuf) {
+    FakeDevice dev(QUEUE_SIZE, false);
+    ASSERT_NE(dev.vq, nullptr);
+    auto*        vq = dev.vq;
+    uint8_t      header[16];
+    uint8_t      data[512];
+    uint8_t      status;
+    int          token;
+    virtio_buf_t bufs[] = {
+        { header, sizeof(header) },
+        { data, sizeof(data) },
+        { &status, sizeof(status) },
+    };
+    EXPECT_FALSE(virtqueue_add(vq, bufs, 0, 0, &token));
+    ASSERT_TRUE(virtqueue_add(vq, bufs, 1, 2, &token));
+    EXPECT_EQ(vq->num_free, QUEUE_SIZE - 3);
+    EXPECT_EQ(vq->avail->idx, 1);
+
+    auto  head = vq->avail->ring[0];
+    auto* d0   = &vq->desc[head];
+    auto* d1   = &vq->desc[d0->next];
+    auto* d2   = &vq->desc[d1->next];
+    EXPECT_EQ(d0->addr, reinterpret_cast<uintptr_t>(header));
+    EXPECT_EQ(d0->flags, VIRTQ_DESC_F_NEXT);
+    EXPECT_EQ(d1->len, sizeof(data));
+    EXPECT_EQ(d1->flags, VIRTQ_DESC_F_NEXT | VIRTQ_DESC_F_WRITE);
+    EXPECT_EQ(d2->addr, reinterpret_cast<uintptr_t>(&status));
+    EXPECT_EQ(d2->flags, VIRTQ_DESC_F_WRITE);
+
+    // 没有完成时收取不到
+    uint32_t len = 0;
+    EXPECT_EQ(virtqueue_get_buf(vq, &len), nullptr);
+    dev.poll();
+    dev.complete(0);
+    EXPECT_EQ(virtqueue_get_buf(vq, &len), &token);
+    EXPECT_EQ(len, sizeof(data) + sizeof(status));
+    EXPECT_EQ(virtqueue_get_buf(vq, &len), nullptr);
+    EXPECT_EQ(vq->num_free, QUEUE_SIZE);
+    EXPECT_EQ(free_list_len(vq), QUEUE_SIZE);
+}
+
+TEST(VirtqueueTest, Full) {
+    FakeDevice dev(QUEUE_SIZE, false);
+    ASSERT_NE(dev.vq, nullptr);
+    auto*                     vq = dev.vq;
+    uint8_t                   buf[QUEUE_SIZE];
+    std::vector<virtio_buf_t> bufs(QUEUE_SIZE + 1, { buf, 1 });
+    int                       tokens[2];
+    EXPECT_FALSE(virtqueue_add(vq, bufs.data(), QUEUE_SIZE, 1, &tokens[0]));
+    ASSERT_TRUE(virtqueue_add(vq, bufs.data(), QUEUE_SIZE - 1, 0, &tokens[0]));
+    ASSERT_TRUE(virtqueue_add(vq, bufs.data(), 0, 1, &tokens[1]));
+    EXPECT_EQ(vq->num_free, 0);
+    EXPECT_FALSE(virtqueue_add(vq, bufs.data(), 1, 0, &tokens[0]));
+
+    // 后放入的先完成
+    dev.poll();
+    dev.complete(1);
+    EXPECT_EQ(virtqueue_get_buf(vq, nullptr), &tokens[1]);
+    EXPECT_EQ(vq->num_free, 1);
+    dev.complete(0);
+    EXPECT_EQ(virtqueue_get_buf(vq, nullptr), &tokens[0]);
+    EXPECT_EQ(vq->num_free, QUEUE_SIZE);
+    EXPECT_EQ(free_list_len(vq), QUEUE_SIZE);
+}
+
+TEST(VirtqueueTest, Fuzz) {
+    FakeDevice dev(QUEUE_SIZE, false);
+    ASSERT_NE(dev.vq, nullptr);
+    auto*                  vq = dev.vq;
+    std::vector<request_t> requests(QUEUE_SIZE);
+    std::vector<size_t>    free_reqs;
+    for (size_t i = 0; i < QUEUE_SIZE; i++) {
+        free_reqs.push_back(i);
+    }
+    std::vector<uint8_t> mem(4096);
+    size_t               num_free = QUEUE_SIZE;
+    size_t               added    = 0;
+    size_t               got      = 0;
+
+    std::mt19937_64 rng(20261018);
+    for (size_t i = 0; i < OPERATIONS; i++) {
+        auto op = rng() % 4;
+        if (op < 2) {
+            // 放入 1~QUEUE_SIZE 个缓冲区，描述符不足时应失败
+            auto      total = 1 + rng() % QUEUE_SIZE;
+            auto      out   = rng() % (total + 1);
+            auto      idx   = free_reqs.empty() ? 0 : free_reqs.back();
+            request_t req   = {};
+            req.out         = out;
+            for (size_t j = 0; j < total; j++) {
+                auto len = static_cast<uint32_t>(1 + rng() % 512);
+                req.bufs.push_back({ &mem[rng() % 2048], len });
+                if (j >= out) {
+                    req.in_len += len;
+                }
+            }
+            auto ok = virtqueue_add(vq, req.bufs.data(), out, total - out,
+                                    &requests[idx]);
+            ASSERT_EQ(ok, total <= num_free);
+            if (ok) {
+                ASSERT_FALSE(free_reqs.empty());
+                free_reqs.pop_back();
+                requests[idx] = req;
+                num_free      -= total;
+                added++;
+            }
+        }
+        else if (op == 2) {
+            dev.poll();
+            if (!dev.pending.empty()) {
+                dev.complete(rng() % dev.pending.size());
+            }
+        }
+        else {
+            uint32_t len;
+            auto*    token = static_cast<request_t*>(
+              virtqueue_get_buf(vq, &len));
+            if (token != nullptr) {
+                EXPECT_EQ(len, token->in_len);
+                num_free += token->bufs.size();
+                free_reqs.push_back(static_cast<size_t>(token - &requests[0]));
+                got++;
+            }
+        }
+        ASSERT_EQ(vq->num_free, num_free);
+    }
+
+    // 完成并收取全部
+    dev.poll();
+    while (!dev.pending.empty()) {
+        dev.complete(0);
+    }
+    while (virtqueue_get_buf(vq, nullptr) != nullptr) {
+        got++;
+    }
+    EXPECT_EQ(got, added);
+    EXPECT_GT(added, OPERATIONS / 8);
+    EXPECT_EQ(vq->num_free, QUEUE_SIZE);
+    EXPECT_EQ(free_list_len(vq), QUEUE_SIZE);
+}
+
+TEST(VirtqueueTest, Notify) {
+    FakeDevice dev(QUEUE_SIZE, false);
+    ASSERT_NE(dev.vq, nullptr);
+    auto*        vq = dev.vq;
+    uint8_t      buf;
+    virtio_buf_t bufs[] = { { &buf, 1 } };
+    int          token;
+    EXPECT_FALSE(virtqueue_kick_prepare(vq));
+    ASSERT_TRUE(virtqueue_add(vq, bufs, 1, 0, &token));
+    EXPECT_TRUE(virtqueue_kick_prepare(vq));
+    virtqueue_notify(vq);
+    EXPECT_EQ(dev.notified(), vq->index);
+    // 没有新的描述符链
+    EXPECT_FALSE(virtqueue_kick_prepare(vq));
+    // 设备不需要通知
+    vq->used->flags = VIRTQ_USED_F_NO_NOTIFY;
+    ASSERT_TRUE(virtqueue_add(vq, bufs, 1, 0, &token));
+    EXPECT_FALSE(virtqueue_kick_prepare(vq));
+}
+
+TEST(VirtqueueTest, EventIdx) {
+    FakeDevice dev(QUEUE_SIZE, true);
+    ASSERT_NE(dev.vq, nullptr);
+    auto*        vq = dev.vq;
+    uint8_t      buf;
+    virtio_buf_t bufs[] = { { &buf, 1 } };
+    int          token;
+    ASSERT_TRUE(vq->event_idx);
+
+    // 设备等待第 1 项，之后的项在它处理前不再通知
+    dev.set_avail_event(0);
+    ASSERT_TRUE(virtqueue_add(vq, bufs, 1, 0, &token));
+    EXPECT_TRUE(virtqueue_kick_prepare(vq));
+    ASSERT_TRUE(virtqueue_add(vq, bufs, 1, 0, &token));
+    ASSERT_TRUE(virtqueue_add(vq, bufs, 1, 0, &token));
+    EXPECT_FALSE(virtqueue_kick_prepare(vq));
+    // 设备处理完前 3 项后等待第 4 项，一次放入多项只通知一次
+    dev.set_avail_event(3);
+    ASSERT_TRUE(virtqueue_add(vq, bufs, 1, 0, &token));
+    ASSERT_TRUE(virtqueue_add(vq, bufs, 1, 0, &token));
+    EXPECT_TRUE(virtqueue_kick_prepare(vq));
+
+    // 收取时推进 used_event
+    dev.poll();
+    dev.complete(0);
+    dev.complete(0);
+    EXPECT_EQ(virtqueue_get_buf(vq, nullptr), &token);
+    EXPECT_EQ(dev.used_event(), 1);
+    // 关闭中断后不再推进，打开时检查已有的完成
+    virtqueue_disable_cb(vq);
+    EXPECT_EQ(virtqueue_get_buf(vq, nullptr), &token);
+    EXPECT_EQ(dev.used_event(), 1);
+    dev.complete(0);
+    EXPECT_FALSE(virtqueue_enable_cb(vq));
+    EXPECT_EQ(dev.used_event(), 2);
+    EXPECT_EQ(virtqueue_get_buf(vq, nullptr), &token);
+    EXPECT_TRUE(virtqueue_enable_cb(vq));
+    EXPECT_EQ(dev.used_event(), 3);
+}